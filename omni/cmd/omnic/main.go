@@ -55,6 +55,11 @@ func main() {
 		debugShort      = flag.Bool("g", false, "alias for -debug")
 		debugModules    = flag.Bool("debug-modules", false, "show module loading debug information")
 		debugModulesSh  = flag.Bool("G", false, "alias for -debug-modules")
+		coverage        = flag.Bool("coverage", false, "instrument the executable with coverage counters (c backend)")
+		profile         = flag.Bool("profile", false, "instrument the executable with function timing, allocation counts and sampling (c backend)")
+		lto             = flag.Bool("lto", false, "compile the program and runtime with link-time optimization (c backend)")
+		pgoGenerate     = flag.String("pgo-generate", "", "build with LTO and write gcc branch profiles to this directory when run (c backend)")
+		pgoUse          = flag.String("pgo-use", "", "build with LTO, optimized by the gcc profiles in this directory (c backend)")
 		emitDir         = flag.String("emit-dir", "", "directory where derived outputs are written")
 		emitDirShort    = flag.String("C", "", "alias for -emit-dir")
 		emitPrefix      = flag.String("emit-prefix", "", "prefix applied to derived output names")
@@ -173,7 +178,7 @@ func main() {
 
 	compileAndReport := func() (string, error) {
 		start := time.Now()
-		outputPath, err := run(input, finalOutput, *backend, *optLevel, emit, *dump, *verbose || *verboseShort, *debug, *debugModules)
+		outputPath, err := run(input, finalOutput, *backend, *optLevel, emit, *dump, *verbose || *verboseShort, *debug, *debugModules, *coverage, *profile, *lto, *pgoGenerate, *pgoUse)
 		duration := time.Since(start)
 		if err != nil {
 			logger.ErrorString(err.Error())
@@ -277,6 +282,17 @@ func showUsage() {
 	fmt.Fprintf(os.Stderr, "        generate debug symbols and debug information\n")
 	fmt.Fprintf(os.Stderr, "  -debug-modules, -G\n")
 	fmt.Fprintf(os.Stderr, "        show module loading debug information\n")
+	fmt.Fprintf(os.Stderr, "  -coverage\n")
+	fmt.Fprintf(os.Stderr, "        count coverage sites; the program writes $OMNI_COVERAGE_OUTPUT (default coverage.json) on exit\n")
+	fmt.Fprintf(os.Stderr, "  -profile\n")
+	fmt.Fprintf(os.Stderr, "        time functions and count their allocations; the program writes $OMNI_PROFILE_OUTPUT (default profile.json)\n")
+	fmt.Fprintf(os.Stderr, "        and folded stacks sampled at $OMNI_PROFILE_HZ (default 99) to $OMNI_PROFILE_FOLDED (default profile.folded)\n")
+	fmt.Fprintf(os.Stderr, "  -lto\n")
+	fmt.Fprintf(os.Stderr, "        compile the program and runtime as one link-time optimized unit (O3 unless -O is given)\n")
+	fmt.Fprintf(os.Stderr, "  -pgo-generate dir\n")
+	fmt.Fprintf(os.Stderr, "        build with -lto and write branch profiles to dir when the program runs\n")
+	fmt.Fprintf(os.Stderr, "  -pgo-use dir\n")
+	fmt.Fprintf(os.Stderr, "        build with -lto using the profiles in dir; keep the same -o as the -pgo-generate build\n")
 	fmt.Fprintf(os.Stderr, "  -verbose, -V\n")
 	fmt.Fprintf(os.Stderr, "        enable verbose output\n")
 	fmt.Fprintf(os.Stderr, "  -quiet, -q\n")
@@ -308,7 +324,7 @@ func showUsage() {
 	fmt.Fprintf(os.Stderr, "  omnic -dump mir hello.omni          # Dump MIR to file\n")
 }
 
-func run(input, output, backend, optLevel, emit, dump string, verbose, debug, debugModules bool) (string, error) {
+func run(input, output, backend, optLevel, emit, dump string, verbose, debug, debugModules, coverage, profile, lto bool, pgoGenerate, pgoUse string) (string, error) {
 	if filepath.Ext(input) != ".omni" {
 		return "", fmt.Errorf("%s: unsupported input (expected .omni)", input)
 	}
@@ -345,6 +361,11 @@ func run(input, output, backend, optLevel, emit, dump string, verbose, debug, de
 		Dump:         dump,
 		DebugInfo:    debug,
 		DebugModules: debugModules,
+		Coverage:     coverage,
+		Profile:      profile,
+		LTO:          lto,
+		PGOGenerate:  pgoGenerate,
+		PGOUse:       pgoUse,
 	}
 
 	if verbose {
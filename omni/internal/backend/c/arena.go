@@ -0,0 +1,224 @@
+package cbackend
+
+import (
+	"fmt"
+	"strings"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// Scoped arena allocation for string temporaries.
+//
+// Instead of malloc'ing every strcat result and conversion temporary and
+// tracking it in stringsToFree, functions allocate them from the runtime's
+// per-thread scratch arena (omni_arena_scratch). The function marks the arena
+// on entry and rewinds to that mark before every return, so all of its
+// temporaries are released at once. Blocks whose temporaries never leave the
+// block (typically loop bodies) additionally rewind at the end of the block,
+// keeping per-iteration garbage from piling up.
+//
+// A value may only live in the arena if it provably does not outlive the
+// function: every use must be one that reads or copies the string.
+
+const (
+	arenaVar     = "_arena"
+	arenaMarkVar = "_arena_mark"
+)
+
+// arenaStringFunctions maps allocating runtime string functions to their
+// arena-backed variants (same arguments, arena first).
+var arenaStringFunctions = map[string]string{
+	"omni_strcat":          "omni_strcat_arena",
+	"omni_substring":       "omni_substring_arena",
+	"omni_trim":            "omni_trim_arena",
+	"omni_to_upper":        "omni_to_upper_arena",
+	"omni_to_lower":        "omni_to_lower_arena",
+	"omni_int_to_string":   "omni_int_to_string_arena",
+	"omni_float_to_string": "omni_float_to_string_arena",
+	"omni_bool_to_string":  "omni_bool_to_string_arena",
+}
+
+// planArena decides which string values of fn are allocated in the scratch
+// arena and which blocks rewind it on exit. It populates useArena,
+// arenaValues and arenaBlocks.
+func (g *CGenerator) planArena(fn *mir.Function) {
+	g.useArena = false
+	g.arenaValues = make(map[mir.ValueID]bool)
+	g.arenaBlocks = make(map[string]bool)
+
+	userFuncs := make(map[string]bool)
+	if g.module != nil {
+		for _, f := range g.module.Functions {
+			userFuncs[f.Name] = true
+		}
+	}
+
+	defBlock := make(map[mir.ValueID]string)
+	escapes := make(map[mir.ValueID]bool)
+	usedOutside := make(map[mir.ValueID]bool)
+	var candidates []mir.ValueID
+
+	for _, block := range fn.Blocks {
+		for _, inst := range block.Instructions {
+			if inst.ID != mir.InvalidValue {
+				defBlock[inst.ID] = block.Name
+			}
+			if inst.ID != mir.InvalidValue && g.arenaCandidate(&inst, userFuncs) {
+				candidates = append(candidates, inst.ID)
+			}
+			if g.allocatesConversionTemps(&inst) {
+				g.useArena = true
+			}
+		}
+	}
+
+	for _, block := range fn.Blocks {
+		for _, inst := range block.Instructions {
+			borrows := g.operandsBorrowed(&inst, userFuncs)
+			for _, op := range inst.Operands {
+				if op.Kind != mir.OperandValue {
+					continue
+				}
+				if !borrows {
+					escapes[op.Value] = true
+				}
+				if defBlock[op.Value] != block.Name {
+					usedOutside[op.Value] = true
+				}
+			}
+		}
+		for _, op := range block.Terminator.Operands {
+			if op.Kind != mir.OperandValue {
+				continue
+			}
+			// ret hands the value to the caller; branch conditions are ints
+			if block.Terminator.Op == "ret" {
+				escapes[op.Value] = true
+			}
+			if defBlock[op.Value] != block.Name {
+				usedOutside[op.Value] = true
+			}
+		}
+	}
+
+	for _, id := range candidates {
+		if !escapes[id] {
+			g.arenaValues[id] = true
+			g.useArena = true
+		}
+	}
+	if !g.useArena {
+		return
+	}
+
+	// A block may rewind on exit when everything it puts in the arena is dead
+	// by the end of the block. Returning blocks are covered by the function's
+	// own rewind.
+	for _, block := range fn.Blocks {
+		if block.Terminator.Op == "ret" {
+			continue
+		}
+		allocates := false
+		local := true
+		for _, inst := range block.Instructions {
+			if g.arenaValues[inst.ID] {
+				allocates = true
+				if usedOutside[inst.ID] {
+					local = false
+				}
+			} else if g.allocatesConversionTemps(&inst) {
+				allocates = true
+			}
+		}
+		if allocates && local {
+			g.arenaBlocks[block.Name] = true
+		}
+	}
+}
+
+// arenaCandidate reports whether inst produces a fresh string that could be
+// allocated from the arena if it does not escape.
+func (g *CGenerator) arenaCandidate(inst *mir.Instruction, userFuncs map[string]bool) bool {
+	if inst.Op == "strcat" {
+		// Fused links are never materialized
+		return len(inst.Operands) >= 2 && !g.fusedStrcats[inst.ID]
+	}
+	if !isCallOp(inst.Op) || inst.Type != "string" || len(inst.Operands) == 0 {
+		return false
+	}
+	if inst.Operands[0].Kind != mir.OperandLiteral || userFuncs[inst.Operands[0].Literal] {
+		return false
+	}
+	_, ok := arenaStringFunctions[g.mapFunctionName(inst.Operands[0].Literal)]
+	return ok
+}
+
+// allocatesConversionTemps reports whether generating inst goes through
+// convertOperandToString, which puts its temporaries in the arena.
+func (g *CGenerator) allocatesConversionTemps(inst *mir.Instruction) bool {
+	switch inst.Op {
+	case "strcat":
+		// Builder chains format their leaves in place
+		return !g.fusedStrcats[inst.ID] && len(g.strcatLeaves(inst)) <= 2
+	case "std.io.print", "std.io.println":
+		return true
+	}
+	if isCallOp(inst.Op) && len(inst.Operands) > 0 && inst.Operands[0].Kind == mir.OperandLiteral {
+		switch inst.Operands[0].Literal {
+		case "std.io.print", "io.print", "std.io.println", "io.println":
+			return true
+		}
+	}
+	return false
+}
+
+// operandsBorrowed reports whether inst only reads (or copies) its string
+// operands, so they may be released when the function or block ends.
+func (g *CGenerator) operandsBorrowed(inst *mir.Instruction, userFuncs map[string]bool) bool {
+	switch inst.Op {
+	case "strcat", "index", "member",
+		"cmp.eq", "cmp.neq", "cmp.lt", "cmp.lte", "cmp.gt", "cmp.gte",
+		"std.io.print", "std.io.println",
+		"std.log.debug", "std.log.info", "std.log.warn", "std.log.error",
+		"std.log.set_level", "std.log.set_mode",
+		"map.init", "struct.init", // runtime map/struct setters copy strings
+		"assert", "assert.eq", "assert.true", "assert.false", "test.start", "test.end":
+		return true
+	}
+	if isCallOp(inst.Op) && len(inst.Operands) > 0 {
+		callee := inst.Operands[0]
+		if callee.Kind != mir.OperandLiteral || userFuncs[callee.Literal] {
+			// User functions may return or store their arguments
+			return false
+		}
+		cName := g.mapFunctionName(callee.Literal)
+		if !strings.HasPrefix(cName, "omni_") {
+			return false
+		}
+		// Some runtime functions hand back one of their arguments (e.g.
+		// omni_args_get_flag's default); only trust fresh-allocating ones.
+		if inst.Type == "string" {
+			_, fresh := arenaStringFunctions[cName]
+			return fresh || g.isStringReturningFunction(callee.Literal)
+		}
+		return true
+	}
+	return false
+}
+
+func isCallOp(op string) bool {
+	switch op {
+	case "call", "call.int", "call.void", "call.string", "call.bool":
+		return true
+	}
+	return false
+}
+
+// emitArenaRelease rewinds the scratch arena to the function's entry mark.
+// It is emitted right before each return, after the return value has been
+// read.
+func (g *CGenerator) emitArenaRelease() {
+	if g.useArena {
+		g.output.WriteString(fmt.Sprintf("  omni_arena_rewind(%s, %s);\n", arenaVar, arenaMarkVar))
+	}
+}
@@ -0,0 +1,126 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+func TestArenaScopedStrings(t *testing.T) {
+	// greet(name) prints "hello " + name and returns it + "!": the
+	// intermediate concatenation lives in the arena, the result does not.
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "greet",
+				ReturnType: "string",
+				Params:     []mir.Param{{Name: "name", Type: "string", ID: 0}},
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Instructions: []mir.Instruction{
+							{ID: 1, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"hello \"", Type: "string"}}},
+							{ID: 2, Op: "strcat", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+							}},
+							{ID: 5, Op: "call", Type: "void", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.io.println"},
+								{Kind: mir.OperandValue, Value: 2, Type: "string"},
+							}},
+							{ID: 3, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"!\"", Type: "string"}}},
+							{ID: 4, Op: "strcat", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 2, Type: "string"},
+								{Kind: mir.OperandValue, Value: 3, Type: "string"},
+							}},
+						},
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 4, Type: "string"}},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	if !strings.Contains(result, "omni_arena_mark_t _arena_mark = omni_arena_mark(_arena);") {
+		t.Error("expected function to mark the scratch arena on entry")
+	}
+	if !strings.Contains(result, "omni_strcat_arena(_arena, v1, name)") {
+		t.Error("expected intermediate strcat to be allocated in the arena")
+	}
+	if !strings.Contains(result, "= omni_strcat_len(NULL, v2, omni_str_len(v2), v3, (sizeof(\"!\") - 1));") {
+		t.Error("expected returned strcat to stay heap-allocated")
+	}
+	rewind := strings.Index(result, "omni_arena_rewind(_arena, _arena_mark);")
+	ret := strings.Index(result, "return v4;")
+	if rewind < 0 || ret < 0 || rewind > ret {
+		t.Error("expected arena rewind before return")
+	}
+}
+
+func TestArenaLoopBlockRewind(t *testing.T) {
+	// A println of a per-iteration strcat: the loop body releases its
+	// temporaries before jumping back to the header.
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "main",
+				ReturnType: "int",
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Terminator: mir.Terminator{
+							Op:       "br",
+							Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "loop_body_1"}},
+						},
+					},
+					{
+						Name: "loop_body_1",
+						Instructions: []mir.Instruction{
+							{ID: 1, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"n=\"", Type: "string"}}},
+							{ID: 2, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "7", Type: "int"}}},
+							{ID: 3, Op: "strcat", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+								{Kind: mir.OperandValue, Value: 2, Type: "int"},
+							}},
+							{ID: 4, Op: "call", Type: "void", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.io.println"},
+								{Kind: mir.OperandValue, Value: 3, Type: "string"},
+							}},
+						},
+						Terminator: mir.Terminator{
+							Op:       "br",
+							Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "loop_body_1"}},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	if !strings.Contains(result, "_arena_mark_loop_body_1 = omni_arena_mark(_arena);") {
+		t.Error("expected loop body to mark the arena")
+	}
+	if !strings.Contains(result, "omni_arena_rewind(_arena, _arena_mark_loop_body_1);") {
+		t.Error("expected loop body to rewind the arena")
+	}
+	if !strings.Contains(result, "omni_int_to_string_arena(_arena, v2)") {
+		t.Error("expected int conversion temporary in the arena")
+	}
+	if strings.Contains(result, "free((void*)temp_str_") || strings.Contains(result, "omni_str_free(temp_str_") {
+		t.Error("arena temporaries must not be freed individually")
+	}
+}
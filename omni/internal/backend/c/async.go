@@ -0,0 +1,237 @@
+package cbackend
+
+import (
+	"fmt"
+	"strings"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// Async functions.
+//
+// An async function runs as a task on the runtime's scheduler. Its body is
+// generated as <name>_async_body, a plain function returning the inner type
+// of its Promise<T>; <name> itself copies the arguments, starts the body
+// with omni_async_call and returns the pending promise, so independent async
+// calls overlap until they are awaited. String arguments are copied because
+// the caller's temporaries may be released before the task runs. A string
+// body always returns a heap omni_str of its own, which the task releases
+// once the promise holds its copy.
+
+const asyncBodySuffix = "_async_body"
+
+// asyncResultType returns the inner type of an async function's
+// Promise<T> result. main is excluded: it runs on the main thread and
+// returns its value directly.
+func asyncResultType(fn *mir.Function) (string, bool) {
+	if fn.Name == "main" || !strings.HasPrefix(fn.ReturnType, "Promise<") || !strings.HasSuffix(fn.ReturnType, ">") {
+		return "", false
+	}
+	return fn.ReturnType[len("Promise<") : len(fn.ReturnType)-1], true
+}
+
+// promiseKind returns the OMNI_PROMISE_* type of promises of inner type and
+// the suffix of their omni_promise_resolve_* and omni_promise_create_*
+// functions, or ok false if promises cannot hold it.
+func promiseKind(inner string) (kind, suffix string, ok bool) {
+	switch inner {
+	case "int", "void":
+		return "OMNI_PROMISE_INT", "int", true
+	case "string":
+		return "OMNI_PROMISE_STRING", "string", true
+	case "float", "double":
+		return "OMNI_PROMISE_FLOAT", "float", true
+	case "bool":
+		return "OMNI_PROMISE_BOOL", "bool", true
+	}
+	return "", "", false
+}
+
+// promiseZero returns the zero value of promises with create suffix.
+func promiseZero(suffix string) string {
+	switch suffix {
+	case "string":
+		return `""`
+	case "float":
+		return "0.0"
+	}
+	return "0"
+}
+
+// generateAsyncFunction generates the body of async function fn and the
+// wrapper scheduling it.
+func (g *CGenerator) generateAsyncFunction(fn *mir.Function, inner string) error {
+	kind, suffix, ok := promiseKind(inner)
+	if !ok {
+		g.errors = append(g.errors, fmt.Sprintf("cannot create promise for user-defined type: %s", inner))
+		kind, suffix = "OMNI_PROMISE_INT", "int"
+	}
+	resolve := "omni_promise_resolve_" + suffix
+
+	body := *fn
+	body.Name = fn.Name + asyncBodySuffix
+	body.ReturnType = inner
+	if err := g.generateFunction(&body); err != nil {
+		return err
+	}
+
+	funcName := g.mapFunctionName(fn.Name)
+	bodyName := funcName + asyncBodySuffix
+	argsType := funcName + "_async_args"
+	taskName := funcName + "_async_task"
+
+	var call strings.Builder
+	call.WriteString(bodyName + "(")
+	for i, param := range fn.Params {
+		if i > 0 {
+			call.WriteString(", ")
+		}
+		call.WriteString("args->" + param.Name)
+	}
+	call.WriteString(")")
+
+	// Arguments travel to the task in a heap struct
+	if len(fn.Params) > 0 {
+		g.output.WriteString("typedef struct {\n")
+		for _, param := range fn.Params {
+			if strings.Contains(param.Type, ") -> ") {
+				g.output.WriteString(fmt.Sprintf("  %s;\n", g.mapFunctionTypeWithName(param.Type, param.Name)))
+			} else {
+				g.output.WriteString(fmt.Sprintf("  %s %s;\n", g.mapType(param.Type), param.Name))
+			}
+		}
+		g.output.WriteString(fmt.Sprintf("} %s;\n\n", argsType))
+	}
+
+	g.output.WriteString(fmt.Sprintf("static void %s(omni_promise_t* promise, void* data) {\n", taskName))
+	if len(fn.Params) > 0 {
+		g.output.WriteString(fmt.Sprintf("  %s* args = (%s*)data;\n", argsType, argsType))
+	} else {
+		g.output.WriteString("  (void)data;\n")
+	}
+	if inner == "void" {
+		g.output.WriteString(fmt.Sprintf("  %s;\n", call.String()))
+		g.output.WriteString(fmt.Sprintf("  %s(promise, 0);\n", resolve))
+	} else if inner == "string" {
+		g.output.WriteString(fmt.Sprintf("  const char* result = %s;\n", call.String()))
+		g.output.WriteString(fmt.Sprintf("  %s(promise, result);\n", resolve))
+		g.output.WriteString("  omni_str_free(result);\n")
+	} else {
+		g.output.WriteString(fmt.Sprintf("  %s(promise, %s);\n", resolve, call.String()))
+	}
+	if len(fn.Params) > 0 {
+		for _, param := range fn.Params {
+			if param.Type == "string" {
+				g.output.WriteString(fmt.Sprintf("  omni_str_free(args->%s);\n", param.Name))
+			}
+		}
+		g.output.WriteString("  free(args);\n")
+	}
+	g.output.WriteString("}\n\n")
+
+	g.output.WriteString(g.asyncWrapperSignature(fn, funcName) + " {\n")
+	if len(fn.Params) == 0 {
+		g.output.WriteString(fmt.Sprintf("  return omni_async_call(%s, %s, NULL);\n", kind, taskName))
+	} else {
+		g.output.WriteString(fmt.Sprintf("  %s* args = (%s*)malloc(sizeof(%s));\n", argsType, argsType, argsType))
+		g.output.WriteString("  if (!args) {\n")
+		g.output.WriteString(fmt.Sprintf("    return omni_promise_create_%s(%s);\n", suffix, promiseZero(suffix)))
+		g.output.WriteString("  }\n")
+		for _, param := range fn.Params {
+			if param.Type == "string" {
+				g.output.WriteString(fmt.Sprintf("  args->%s = %s ? omni_str_new(NULL, %s, strlen(%s)) : NULL;\n",
+					param.Name, param.Name, param.Name, param.Name))
+			} else {
+				g.output.WriteString(fmt.Sprintf("  args->%s = %s;\n", param.Name, param.Name))
+			}
+		}
+		g.output.WriteString(fmt.Sprintf("  return omni_async_call(%s, %s, args);\n", kind, taskName))
+	}
+	g.output.WriteString("}\n\n")
+	return nil
+}
+
+// emitAsyncStringReturn returns string op from an async body. The task
+// frees the result with omni_str_free, so anything but a heap omni_str the
+// body owns is returned as a copy.
+func (g *CGenerator) emitAsyncStringReturn(op mir.Operand) {
+	value := g.getOperandValue(op)
+	if op.Kind == mir.OperandValue {
+		id := g.variableOf(op.Value)
+		if g.stringsToFree[id] && !g.arenaValues[id] {
+			if g.omniStrs[id] {
+				g.output.WriteString(fmt.Sprintf("  return %s;\n", value))
+				return
+			}
+			// A plain heap string is copied and released here
+			g.output.WriteString("  {\n")
+			g.output.WriteString(fmt.Sprintf("    const char* result = %s;\n", g.omniStrCopyExpr(op)))
+			g.output.WriteString(fmt.Sprintf("    free((void*)%s);\n", value))
+			g.output.WriteString("    return result;\n")
+			g.output.WriteString("  }\n")
+			return
+		}
+	}
+	g.output.WriteString(fmt.Sprintf("  return %s;\n", g.omniStrCopyExpr(op)))
+}
+
+// planPromiseReleases finds the awaits that can release their promise as
+// soon as they have its value: those awaiting a promise that was created
+// by a call in the same block and is used nowhere else.
+func (g *CGenerator) planPromiseReleases(fn *mir.Function) {
+	g.awaitedPromises = make(map[mir.ValueID]bool)
+	uses := make(map[mir.ValueID]int)
+	createdIn := make(map[mir.ValueID]string)
+	type await struct {
+		id, promise mir.ValueID
+		block       string
+	}
+	var awaits []await
+	for _, block := range fn.Blocks {
+		for _, inst := range block.Instructions {
+			for _, op := range inst.Operands {
+				if op.Kind == mir.OperandValue {
+					uses[op.Value]++
+				}
+			}
+			if inst.ID == mir.InvalidValue {
+				continue
+			}
+			if isCallOp(inst.Op) && strings.HasPrefix(inst.Type, "Promise<") {
+				createdIn[inst.ID] = block.Name
+			}
+			if inst.Op == "await" && len(inst.Operands) == 1 && inst.Operands[0].Kind == mir.OperandValue {
+				awaits = append(awaits, await{inst.ID, inst.Operands[0].Value, block.Name})
+			}
+		}
+		for _, op := range block.Terminator.Operands {
+			if op.Kind == mir.OperandValue {
+				uses[op.Value]++
+			}
+		}
+	}
+	for _, a := range awaits {
+		if createdIn[a.promise] == a.block && uses[a.promise] == 1 {
+			g.awaitedPromises[a.id] = true
+		}
+	}
+}
+
+// asyncWrapperSignature returns the C signature of the function starting
+// async function fn.
+func (g *CGenerator) asyncWrapperSignature(fn *mir.Function, funcName string) string {
+	var b strings.Builder
+	b.WriteString(fmt.Sprintf("omni_promise_t* %s(", funcName))
+	for i, param := range fn.Params {
+		if i > 0 {
+			b.WriteString(", ")
+		}
+		if strings.Contains(param.Type, ") -> ") {
+			b.WriteString(g.mapFunctionTypeWithName(param.Type, param.Name))
+		} else {
+			b.WriteString(fmt.Sprintf("%s %s", g.mapType(param.Type), param.Name))
+		}
+	}
+	b.WriteString(")")
+	return b.String()
+}
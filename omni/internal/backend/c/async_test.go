@@ -0,0 +1,118 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+func TestAsyncFunctionRunsAsTask(t *testing.T) {
+	// async func greet(name: string): string { return name }
+	// async func main(): int { let p = greet("amy"); await p; return 0 }
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "greet",
+				ReturnType: "Promise<string>",
+				Params:     []mir.Param{{Name: "name", Type: "string", ID: 0}},
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 0, Type: "string"}},
+						},
+					},
+				},
+			},
+			{
+				Name:       "main",
+				ReturnType: "Promise<int>",
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Instructions: []mir.Instruction{
+							{ID: 1, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"amy\"", Type: "string"}}},
+							{ID: 2, Op: "call", Type: "Promise<string>", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "greet"},
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+							}},
+							{ID: 3, Op: "await", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 2, Type: "Promise<string>"}}},
+							{ID: 4, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "0", Type: "int"}}},
+						},
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 4, Type: "int"}},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	expected := []string{
+		"const char* greet_async_body(const char* name) {",
+		"} greet_async_args;",
+		// The body returns its own copy of the borrowed parameter, which the
+		// task releases once the promise holds the string
+		"return name ? omni_str_new(NULL, name, strlen(name)) : NULL;",
+		"const char* result = greet_async_body(args->name);",
+		"omni_promise_resolve_string(promise, result);",
+		"omni_str_free(result);",
+		"omni_str_free(args->name);",
+		"args->name = name ? omni_str_new(NULL, name, strlen(name)) : NULL;",
+		"return omni_async_call(OMNI_PROMISE_STRING, greet_async_task, args);",
+		"v2 = greet(v1);",
+		"omni_await_string(v2)",
+		// The promise is only awaited, so it is released right after
+		"omni_promise_free(v2);",
+	}
+	for _, want := range expected {
+		if !strings.Contains(result, want) {
+			t.Errorf("expected %q in generated code:\n%s", want, result)
+		}
+	}
+}
+
+func TestAsyncFileIOUsesScheduler(t *testing.T) {
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "main",
+				ReturnType: "Promise<int>",
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Instructions: []mir.Instruction{
+							{ID: 1, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"in.txt\"", Type: "string"}}},
+							{ID: 2, Op: "call", Type: "Promise<string>", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.os.read_file_async"},
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+							}},
+							{ID: 3, Op: "await", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 2, Type: "Promise<string>"}}},
+							{ID: 4, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "0", Type: "int"}}},
+						},
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 4, Type: "int"}},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+	if !strings.Contains(result, "omni_read_file_async(v1)") {
+		t.Errorf("expected read_file_async to run on the scheduler:\n%s", result)
+	}
+}
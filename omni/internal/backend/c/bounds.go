@@ -0,0 +1,205 @@
+package cbackend
+
+import (
+	"strconv"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// Bounds-check elimination for array indexing.
+//
+// An array access that cannot be proven in range is emitted through
+// omni_array_check_index, an inline compare the C compiler can still drop
+// on its own. Accesses the generator proves in range are emitted as plain
+// C indexing, which keeps loops over arrays free of calls and lets the C
+// compiler vectorize them.
+//
+// The proof covers the shape counting loops lower to: a block ending in
+// `cbr (i < n), body, exit`, where body has no other predecessor, i only
+// ever holds non-negative values and n is at most the array's length. Inside
+// body, accesses arr[i] are in range until i is next assigned. Constant
+// indexes below the length of an array literal are in range anywhere.
+
+// planBoundsChecks records the index instructions of fn that are provably in
+// range.
+func (g *CGenerator) planBoundsChecks(fn *mir.Function) {
+	g.inRangeIndexes = make(map[mir.ValueID]bool)
+
+	defs := make(map[mir.ValueID]*mir.Instruction)
+	assigns := make(map[mir.ValueID][]*mir.Instruction)
+	preds := make(map[string]int)
+	blocks := make(map[string]*mir.BasicBlock)
+	for _, block := range fn.Blocks {
+		blocks[block.Name] = block
+		for i := range block.Instructions {
+			inst := &block.Instructions[i]
+			if inst.Op == "assign" && len(inst.Operands) == 2 && inst.Operands[0].Kind == mir.OperandValue {
+				assigns[inst.Operands[0].Value] = append(assigns[inst.Operands[0].Value], inst)
+				continue
+			}
+			if inst.ID != mir.InvalidValue {
+				if _, seen := defs[inst.ID]; !seen {
+					defs[inst.ID] = inst
+				}
+			}
+		}
+		for _, op := range block.Terminator.Operands {
+			if op.Kind == mir.OperandLiteral && (block.Terminator.Op == "br" || block.Terminator.Op == "cbr") {
+				preds[op.Literal]++
+			}
+		}
+	}
+
+	// Constant integer value of op, if it is one
+	constInt := func(op mir.Operand) (int64, bool) {
+		lit := op.Literal
+		if op.Kind == mir.OperandValue {
+			def, ok := defs[op.Value]
+			if !ok || def.Op != "const" || len(assigns[op.Value]) > 0 || len(def.Operands) != 1 {
+				return 0, false
+			}
+			lit = def.Operands[0].Literal
+		}
+		n, err := strconv.ParseInt(lit, 10, 64)
+		return n, err == nil
+	}
+
+	// Length of the array literal v, if v is never reassigned
+	arrayLength := func(v mir.ValueID) (int64, bool) {
+		def, ok := defs[v]
+		if !ok || def.Op != "array.init" || len(assigns[v]) > 0 {
+			return 0, false
+		}
+		return int64(len(def.Operands)), true
+	}
+
+	// Whether every value v ever holds is >= 0: it starts as a non-negative
+	// constant and each assign stores one or adds one to v. Larger steps
+	// are not accepted, since i + c can wrap negative while i < n holds;
+	// i + 1 cannot, because i < n <= INT32_MAX.
+	nonNegative := func(v mir.ValueID) bool {
+		if n, ok := constInt(mir.Operand{Kind: mir.OperandValue, Value: v}); ok {
+			return n >= 0
+		}
+		def, ok := defs[v]
+		if !ok || def.Op != "const" || len(def.Operands) != 1 {
+			return false
+		}
+		if n, err := strconv.ParseInt(def.Operands[0].Literal, 10, 64); err != nil || n < 0 {
+			return false
+		}
+		for _, a := range assigns[v] {
+			src := a.Operands[1]
+			if n, ok := constInt(src); ok && n >= 0 {
+				continue
+			}
+			if src.Kind != mir.OperandValue {
+				return false
+			}
+			add, ok := defs[src.Value]
+			if !ok || add.Op != "add" || len(add.Operands) != 2 {
+				return false
+			}
+			x, y := add.Operands[0], add.Operands[1]
+			if y.Kind == mir.OperandValue && y.Value == v {
+				x, y = y, x
+			}
+			if x.Kind != mir.OperandValue || x.Value != v {
+				return false
+			}
+			if n, ok := constInt(y); !ok || n != 1 {
+				return false
+			}
+		}
+		return true
+	}
+
+	// Constant indexes need no loop to prove them
+	for _, block := range fn.Blocks {
+		for i := range block.Instructions {
+			inst := &block.Instructions[i]
+			if inst.Op != "index" || len(inst.Operands) != 2 || inst.Operands[0].Kind != mir.OperandValue {
+				continue
+			}
+			length, known := arrayLength(inst.Operands[0].Value)
+			if n, ok := constInt(inst.Operands[1]); ok && known && n >= 0 && n < length {
+				g.inRangeIndexes[inst.ID] = true
+			}
+		}
+	}
+
+	for _, header := range fn.Blocks {
+		term := header.Terminator
+		if term.Op != "cbr" || len(term.Operands) != 3 || term.Operands[0].Kind != mir.OperandValue {
+			continue
+		}
+		cond, ok := defs[term.Operands[0].Value]
+		if !ok || (cond.Op != "cmp.lt" && cond.Op != "cmp.lte") || len(cond.Operands) != 2 {
+			continue
+		}
+		idx := cond.Operands[0]
+		if idx.Kind != mir.OperandValue || !nonNegative(idx.Value) {
+			continue
+		}
+		// The compare must be in the branching block and see the value i
+		// has when the branch is taken
+		if assignedAfter(header, cond, idx.Value) {
+			continue
+		}
+		body, ok := blocks[term.Operands[1].Literal]
+		if !ok || preds[body.Name] != 1 {
+			continue
+		}
+
+		// inRange reports whether i compared against the bound is a valid
+		// index into arr
+		bound := cond.Operands[1]
+		limit, constBound := constInt(bound)
+		if constBound && cond.Op == "cmp.lte" {
+			limit++
+		}
+		var lenOf mir.ValueID = mir.InvalidValue
+		if !constBound && cond.Op == "cmp.lt" && bound.Kind == mir.OperandValue {
+			if call, ok := defs[bound.Value]; ok && isCallOp(call.Op) && len(call.Operands) == 2 &&
+				call.Operands[0].Literal == "len" && call.Operands[1].Kind == mir.OperandValue {
+				lenOf = call.Operands[1].Value
+			}
+		}
+		inRange := func(arr mir.ValueID) bool {
+			length, known := arrayLength(arr)
+			if !known {
+				return false
+			}
+			return (constBound && limit <= length) || arr == lenOf
+		}
+
+		for i := range body.Instructions {
+			inst := &body.Instructions[i]
+			if inst.Op == "assign" && inst.Operands[0].Kind == mir.OperandValue && inst.Operands[0].Value == idx.Value {
+				break
+			}
+			if inst.Op == "index" && len(inst.Operands) == 2 &&
+				inst.Operands[0].Kind == mir.OperandValue && inst.Operands[1].Kind == mir.OperandValue &&
+				inst.Operands[1].Value == idx.Value && inRange(inst.Operands[0].Value) {
+				g.inRangeIndexes[inst.ID] = true
+			}
+		}
+	}
+}
+
+// assignedAfter reports whether block may assign v after instruction after,
+// which is true when after is not in block at all
+func assignedAfter(block *mir.BasicBlock, after *mir.Instruction, v mir.ValueID) bool {
+	seen := false
+	for i := range block.Instructions {
+		inst := &block.Instructions[i]
+		if inst == after {
+			seen = true
+			continue
+		}
+		if seen && inst.Op == "assign" && inst.Operands[0].Kind == mir.OperandValue && inst.Operands[0].Value == v {
+			return true
+		}
+	}
+	return !seen
+}
@@ -0,0 +1,142 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+func intConst(id mir.ValueID, lit string) mir.Instruction {
+	return mir.Instruction{ID: id, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: lit, Type: "int"}}}
+}
+
+func intValue(id mir.ValueID) mir.Operand {
+	return mir.Operand{Kind: mir.OperandValue, Value: id, Type: "int"}
+}
+
+// countingLoop builds
+//
+//	xs := [1, 2, 3]; sum := 0
+//	for i := 0; i < bound; i += step { sum += xs[i] }
+//	return sum + xs[last]
+//
+// where bound is len(xs) when boundLit is empty.
+func countingLoop(boundLit, step, last string) *mir.Module {
+	header := []mir.Instruction{}
+	var bound mir.Operand
+	if boundLit == "" {
+		header = append(header, mir.Instruction{ID: 11, Op: "call", Type: "int", Operands: []mir.Operand{
+			{Kind: mir.OperandLiteral, Literal: "len"},
+			{Kind: mir.OperandValue, Value: 0, Type: "array<int>"},
+		}})
+		bound = intValue(11)
+	} else {
+		header = append(header, intConst(11, boundLit))
+		bound = intValue(11)
+	}
+	header = append(header, mir.Instruction{ID: 12, Op: "cmp.lt", Type: "bool", Operands: []mir.Operand{intValue(10), bound}})
+
+	return &mir.Module{Functions: []*mir.Function{{
+		Name:       "main",
+		ReturnType: "int",
+		Blocks: []*mir.BasicBlock{
+			{
+				Name: "entry",
+				Instructions: []mir.Instruction{
+					intConst(1, "1"), intConst(2, "2"), intConst(3, "3"),
+					{ID: 0, Op: "array.init", Type: "array<int>", Operands: []mir.Operand{intValue(1), intValue(2), intValue(3)}},
+					intConst(9, "0"),
+					intConst(10, "0"),
+				},
+				Terminator: mir.Terminator{Op: "br", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "header"}}},
+			},
+			{
+				Name:         "header",
+				Instructions: header,
+				Terminator: mir.Terminator{Op: "cbr", Operands: []mir.Operand{
+					intValue(12),
+					{Kind: mir.OperandLiteral, Literal: "body"},
+					{Kind: mir.OperandLiteral, Literal: "exit"},
+				}},
+			},
+			{
+				Name: "body",
+				Instructions: []mir.Instruction{
+					{ID: 13, Op: "index", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 0, Type: "array<int>"}, intValue(10)}},
+					{ID: 14, Op: "add", Type: "int", Operands: []mir.Operand{intValue(9), intValue(13)}},
+					{ID: 15, Op: "assign", Type: "int", Operands: []mir.Operand{intValue(9), intValue(14)}},
+					intConst(16, step),
+					{ID: 17, Op: "add", Type: "int", Operands: []mir.Operand{intValue(10), intValue(16)}},
+					{ID: 18, Op: "assign", Type: "int", Operands: []mir.Operand{intValue(10), intValue(17)}},
+				},
+				Terminator: mir.Terminator{Op: "br", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "header"}}},
+			},
+			{
+				Name: "exit",
+				Instructions: []mir.Instruction{
+					intConst(21, last),
+					{ID: 22, Op: "index", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 0, Type: "array<int>"}, intValue(21)}},
+					{ID: 23, Op: "add", Type: "int", Operands: []mir.Operand{intValue(9), intValue(22)}},
+				},
+				Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{intValue(23)}},
+			},
+		},
+	}}}
+}
+
+func TestBoundsChecksEliminatedInCountingLoops(t *testing.T) {
+	for _, bound := range []string{"", "3", "2"} {
+		result, err := GenerateC(countingLoop(bound, "1", "2"))
+		if err != nil {
+			t.Fatalf("GenerateC failed: %v", err)
+		}
+		for _, want := range []string{"v13 = v0[v10];", "v22 = v0[v21];"} {
+			if !strings.Contains(result, want) {
+				t.Errorf("bound %q: expected %q in generated code:\n%s", bound, want, result)
+			}
+		}
+		if strings.Contains(result, "omni_array_check_index") {
+			t.Errorf("bound %q: no access should need a check:\n%s", bound, result)
+		}
+	}
+}
+
+func TestBoundsChecksKeptWhenUnproven(t *testing.T) {
+	tests := []struct {
+		name  string
+		bound string
+		step  string
+		last  string
+	}{
+		{"bound past the end", "4", "1", "2"},
+		{"index may go negative", "3", "-1", "2"},
+		{"large step may wrap negative", "", "2147483647", "2"},
+		{"constant index past the end", "3", "1", "3"},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			result, err := GenerateC(countingLoop(tt.bound, tt.step, tt.last))
+			if err != nil {
+				t.Fatalf("GenerateC failed: %v", err)
+			}
+			want := "v13 = v0[omni_array_check_index(v10, 3)];"
+			if tt.last == "3" {
+				want = "v22 = v0[omni_array_check_index(v21, 3)];"
+			}
+			if !strings.Contains(result, want) {
+				t.Errorf("expected %q in generated code:\n%s", want, result)
+			}
+		})
+	}
+}
+
+func TestLenOfArrayLiteralIsConstant(t *testing.T) {
+	result, err := GenerateC(countingLoop("", "1", "2"))
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+	if !strings.Contains(result, "v11 = 3;") || strings.Contains(result, "omni_len(") {
+		t.Errorf("len of an array literal should be emitted as its length:\n%s", result)
+	}
+}
@@ -40,12 +40,51 @@ type CGenerator struct {
 	stringsToFree map[mir.ValueID]bool
 	// Track promises that need to be freed
 	promisesToFree map[mir.ValueID]bool
+	// Awaits that release their promise right away (see async.go)
+	awaitedPromises map[mir.ValueID]bool
 	// Track temporary string variables created in convertOperandToString
 	tempStringsToFree []string
 	// Track the value ID that is being returned (to exclude from cleanup)
 	returnedValueID mir.ValueID
 	// Track which variables were declared at the top of the function
 	declaredVariables map[mir.ValueID]bool
+	// Scratch-arena plan for the current function (see arena.go)
+	useArena    bool
+	arenaValues map[mir.ValueID]bool
+	arenaBlocks map[string]bool
+	// Array accesses proven in range (see bounds.go)
+	inRangeIndexes map[mir.ValueID]bool
+	// Strcat chains folded into a single string builder (see strbuilder.go)
+	fusedStrcats map[mir.ValueID]bool
+	strcatDefs   map[mir.ValueID]*mir.Instruction
+	constStrings map[mir.ValueID]string
+	// String values known to be runtime omni_strs, the definitions and
+	// assigns whose string is copied into one, the variables each value is
+	// assigned to, and each assign's target (see omnistr.go)
+	omniStrs      map[mir.ValueID]bool
+	omniStrCopies map[mir.ValueID]bool
+	stringMoves   map[mir.ValueID][]mir.ValueID
+	assignTargets map[mir.ValueID]mir.ValueID
+	// Constant map keys and field names interned at startup (see intern.go)
+	internedKeys map[string]string
+	internOrder  []string
+	// Field order of struct types with a static layout (see structlayout.go)
+	structLayouts map[string][]string
+	inlineCaches  int
+	// Constant regex patterns compiled at startup (see regex.go)
+	regexHandles map[string]string
+	regexOrder   []string
+	// Compiled-in coverage sites (see coverage.go)
+	coverage      bool
+	coverageFile  string
+	coverageSites []coverageSite
+	coverageIDs   map[string]int
+	// Function entry/exit profiling hooks (see profile.go)
+	profile          bool
+	profileFile      string
+	profileFunctions []string
+	profileIDs       map[string]int
+	profileSite      int // Site of the function being generated
 }
 
 // NewCGenerator creates a new C code generator
@@ -67,9 +106,21 @@ func NewCGenerator(module *mir.Module) *CGenerator {
 		errors:            []string{},
 		stringsToFree:     make(map[mir.ValueID]bool),
 		promisesToFree:    make(map[mir.ValueID]bool),
+		awaitedPromises:   make(map[mir.ValueID]bool),
 		tempStringsToFree: []string{},
 		returnedValueID:   mir.InvalidValue,
 		declaredVariables: make(map[mir.ValueID]bool),
+		arenaValues:       make(map[mir.ValueID]bool),
+		arenaBlocks:       make(map[string]bool),
+		fusedStrcats:      make(map[mir.ValueID]bool),
+		strcatDefs:        make(map[mir.ValueID]*mir.Instruction),
+		constStrings:      make(map[mir.ValueID]string),
+		omniStrs:          make(map[mir.ValueID]bool),
+		omniStrCopies:     make(map[mir.ValueID]bool),
+		stringMoves:       make(map[mir.ValueID][]mir.ValueID),
+		assignTargets:     make(map[mir.ValueID]mir.ValueID),
+		internedKeys:      make(map[string]string),
+		regexHandles:      make(map[string]string),
 	}
 }
 
@@ -92,9 +143,21 @@ func NewCGeneratorWithOptLevel(module *mir.Module, optLevel string) *CGenerator
 		errors:            []string{},
 		stringsToFree:     make(map[mir.ValueID]bool),
 		promisesToFree:    make(map[mir.ValueID]bool),
+		awaitedPromises:   make(map[mir.ValueID]bool),
 		tempStringsToFree: []string{},
 		returnedValueID:   mir.InvalidValue,
 		declaredVariables: make(map[mir.ValueID]bool),
+		arenaValues:       make(map[mir.ValueID]bool),
+		arenaBlocks:       make(map[string]bool),
+		fusedStrcats:      make(map[mir.ValueID]bool),
+		strcatDefs:        make(map[mir.ValueID]*mir.Instruction),
+		constStrings:      make(map[mir.ValueID]string),
+		omniStrs:          make(map[mir.ValueID]bool),
+		omniStrCopies:     make(map[mir.ValueID]bool),
+		stringMoves:       make(map[mir.ValueID][]mir.ValueID),
+		assignTargets:     make(map[mir.ValueID]mir.ValueID),
+		internedKeys:      make(map[string]string),
+		regexHandles:      make(map[string]string),
 	}
 }
 
@@ -117,9 +180,21 @@ func NewCGeneratorWithDebug(module *mir.Module, optLevel string, debugInfo bool,
 		errors:            []string{},
 		stringsToFree:     make(map[mir.ValueID]bool),
 		promisesToFree:    make(map[mir.ValueID]bool),
+		awaitedPromises:   make(map[mir.ValueID]bool),
 		tempStringsToFree: []string{},
 		returnedValueID:   mir.InvalidValue,
 		declaredVariables: make(map[mir.ValueID]bool),
+		arenaValues:       make(map[mir.ValueID]bool),
+		arenaBlocks:       make(map[string]bool),
+		fusedStrcats:      make(map[mir.ValueID]bool),
+		strcatDefs:        make(map[mir.ValueID]*mir.Instruction),
+		constStrings:      make(map[mir.ValueID]string),
+		omniStrs:          make(map[mir.ValueID]bool),
+		omniStrCopies:     make(map[mir.ValueID]bool),
+		stringMoves:       make(map[mir.ValueID][]mir.ValueID),
+		assignTargets:     make(map[mir.ValueID]mir.ValueID),
+		internedKeys:      make(map[string]string),
+		regexHandles:      make(map[string]string),
 	}
 }
 
@@ -153,6 +228,8 @@ func (g *CGenerator) generate() (string, error) {
 
 	// Generate function declarations first
 	g.writeFunctionDeclarations()
+	declEnd := g.output.Len()
+	g.planStructLayouts()
 
 	// Then generate function definitions
 	for _, fn := range g.module.Functions {
@@ -168,8 +245,12 @@ func (g *CGenerator) generate() (string, error) {
 		return "", fmt.Errorf("code generation errors:\n%s", strings.Join(g.errors, "\n"))
 	}
 
-	// Apply optimizations
+	// The interned keys are only known once every function is generated
 	code := g.output.String()
+	code = code[:declEnd] + g.internKeyDefinitions() + g.inlineCacheDefinitions() + g.regexDefinitions() +
+		g.coverageDefinitions() + g.profileDefinitions() + code[declEnd:]
+
+	// Apply optimizations
 	optimizedCode := OptimizeC(code, g.optLevel)
 
 	return optimizedCode, nil
@@ -205,6 +286,7 @@ func (g *CGenerator) GenerateSourceMap() map[string]interface{} {
 // writeHeader writes the C header includes and declarations
 func (g *CGenerator) writeHeader() {
 	g.output.WriteString(`#include "omni_rt.h"
+#include "omni_rt_inline.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -318,6 +400,11 @@ func (g *CGenerator) generateFunction(fn *mir.Function) error {
 		return nil
 	}
 
+	// Async functions run as scheduled tasks (see async.go)
+	if inner, ok := asyncResultType(fn); ok {
+		return g.generateAsyncFunction(fn, inner)
+	}
+
 	// Warn if this is a stdlib function that should be an intrinsic but isn't implemented
 	if g.isStdFunction(fn.Name) && !g.hasRuntimeImplementation(fn.Name) {
 		// This is a stdlib function without a runtime implementation
@@ -394,6 +481,11 @@ func (g *CGenerator) generateFunction(fn *mir.Function) error {
 	g.tempStringsToFree = []string{}
 	g.returnedValueID = mir.InvalidValue
 	g.declaredVariables = make(map[mir.ValueID]bool)
+	g.planStrcatFusion(fn)
+	g.planStringLengths(fn)
+	g.planArena(fn)
+	g.planBoundsChecks(fn)
+	g.planPromiseReleases(fn)
 
 	// Map parameter SSA values to their names
 	for _, param := range fn.Params {
@@ -418,6 +510,10 @@ func (g *CGenerator) generateFunction(fn *mir.Function) error {
 
 	// Declare all variables at the beginning of the function
 	for id, varName := range allVariables {
+		// Fused strcat links never get a value of their own
+		if g.fusedStrcats[id] {
+			continue
+		}
 		// Skip parameters (they're already declared)
 		if _, isParam := g.variables[id]; !isParam {
 			// Determine the type based on the instruction that produces this value
@@ -623,6 +719,18 @@ func (g *CGenerator) generateFunction(fn *mir.Function) error {
 		}
 	}
 
+	// Mark the scratch arena so every temporary allocated by this call is
+	// released by one rewind before returning
+	if g.useArena {
+		g.output.WriteString(fmt.Sprintf("  omni_arena_t* %s = omni_arena_scratch();\n", arenaVar))
+		g.output.WriteString(fmt.Sprintf("  omni_arena_mark_t %s = omni_arena_mark(%s);\n", arenaMarkVar, arenaVar))
+		for _, block := range fn.Blocks {
+			if g.arenaBlocks[block.Name] {
+				g.output.WriteString(fmt.Sprintf("  omni_arena_mark_t %s_%s;\n", arenaMarkVar, block.Name))
+			}
+		}
+	}
+
 	// Pre-populate valueTypes for ALL blocks in this function
 	// This ensures type information is available when processing struct.init
 	// Also handle const instructions specially to infer types from literals
@@ -654,6 +762,9 @@ func (g *CGenerator) generateFunction(fn *mir.Function) error {
 		}
 	}
 
+	g.emitCoverageHit(strings.TrimSuffix(fn.Name, asyncBodySuffix))
+	g.emitProfileEnter(strings.TrimSuffix(fn.Name, asyncBodySuffix))
+
 	// Generate function body
 	for _, block := range fn.Blocks {
 		if err := g.generateBlock(block, fn); err != nil {
@@ -671,7 +782,11 @@ func (g *CGenerator) generateFunction(fn *mir.Function) error {
 		var stringIDs []mir.ValueID
 		for id := range g.stringsToFree {
 			// Skip the returned value - caller owns it
-			if id == g.returnedValueID {
+			if id == g.variableOf(g.returnedValueID) {
+				continue
+			}
+			// Skip values owned by the variable they were assigned to
+			if g.releasedElsewhere(id) {
 				continue
 			}
 			stringIDs = append(stringIDs, id)
@@ -680,7 +795,7 @@ func (g *CGenerator) generateFunction(fn *mir.Function) error {
 		for i := len(stringIDs) - 1; i >= 0; i-- {
 			id := stringIDs[i]
 			varName := g.getVariableName(id)
-			g.output.WriteString(fmt.Sprintf("  if (%s != NULL) { free((void*)%s); %s = NULL; }\n", varName, varName, varName))
+			g.output.WriteString(fmt.Sprintf("  if (%s != NULL) { %s; %s = NULL; }\n", varName, stringFreeCall(varName, g.omniStrs[id]), varName))
 		}
 	}
 
@@ -690,7 +805,7 @@ func (g *CGenerator) generateFunction(fn *mir.Function) error {
 		// Free in reverse order (last created first)
 		for i := len(g.tempStringsToFree) - 1; i >= 0; i-- {
 			tempVar := g.tempStringsToFree[i]
-			g.output.WriteString(fmt.Sprintf("  if (%s != NULL) { free((void*)%s); %s = NULL; }\n", tempVar, tempVar, tempVar))
+			g.output.WriteString(fmt.Sprintf("  if (%s != NULL) { %s; %s = NULL; }\n", tempVar, stringFreeCall(tempVar, true), tempVar))
 		}
 	}
 
@@ -720,6 +835,9 @@ func (g *CGenerator) generateBlock(block *mir.BasicBlock, fn *mir.Function) erro
 		// This ensures compatibility with older C standards
 		g.output.WriteString("  ;\n")
 	}
+	if g.arenaBlocks[block.Name] {
+		g.output.WriteString(fmt.Sprintf("  %s_%s = omni_arena_mark(%s);\n", arenaMarkVar, block.Name, arenaVar))
+	}
 
 	// Pre-populate valueTypes for this block's instructions
 	// This ensures type information is available when processing struct.init
@@ -753,6 +871,14 @@ func (g *CGenerator) generateBlock(block *mir.BasicBlock, fn *mir.Function) erro
 		if err := g.generateInstruction(&inst); err != nil {
 			return err
 		}
+		if g.omniStrCopies[inst.ID] && inst.Op != "assign" {
+			g.copyDefinitionToOmniStr(&inst)
+		}
+	}
+
+	// Release this block's temporaries before leaving it
+	if g.arenaBlocks[block.Name] {
+		g.output.WriteString(fmt.Sprintf("  omni_arena_rewind(%s, %s_%s);\n", arenaVar, arenaMarkVar, block.Name))
 	}
 
 	// Generate terminator
@@ -945,12 +1071,44 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 	case "strcat":
 		// Handle string concatenation
 		if len(inst.Operands) >= 2 {
+			// Intermediate links of a fused chain are appended by the chain's
+			// last strcat
+			if g.fusedStrcats[inst.ID] {
+				break
+			}
 			varName := g.getVariableName(inst.ID)
+			if leaves := g.strcatLeaves(inst); len(leaves) > 2 {
+				g.emitStrcatBuilder(inst, varName, leaves)
+				break
+			}
+
+			// Both lengths known: concatenate without rescanning either side
+			leftLen, okLeft := g.knownLength(inst.Operands[0])
+			rightLen, okRight := g.knownLength(inst.Operands[1])
+			if okLeft && okRight {
+				arena := "NULL"
+				if g.arenaValues[inst.ID] {
+					arena = arenaVar
+				} else {
+					g.stringsToFree[inst.ID] = true
+				}
+				g.output.WriteString(fmt.Sprintf("  %s = omni_strcat_len(%s, %s, %s, %s, %s);\n",
+					varName, arena, g.getOperandValue(inst.Operands[0]), leftLen,
+					g.getOperandValue(inst.Operands[1]), rightLen))
+				break
+			}
 
 			// Convert operands to strings if needed
 			leftStr := g.convertOperandToString(inst.Operands[0])
 			rightStr := g.convertOperandToString(inst.Operands[1])
 
+			// Non-escaping results live in the scratch arena
+			if g.arenaValues[inst.ID] {
+				g.output.WriteString(fmt.Sprintf("  %s = omni_strcat_arena(%s, %s, %s);\n",
+					varName, arenaVar, leftStr, rightStr))
+				break
+			}
+
 			// Generate proper string concatenation using runtime function
 			g.output.WriteString(fmt.Sprintf("  %s = omni_strcat(%s, %s);\n",
 				varName, leftStr, rightStr))
@@ -1042,6 +1200,10 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 				funcName = g.getOperandValue(inst.Operands[0])
 			}
 
+			if g.isStdFunction(funcName) {
+				g.emitCoverageHit(funcName)
+			}
+
 			// Special handling for len() function
 			if funcName == "len" && len(inst.Operands) == 2 {
 				varName := g.getVariableName(inst.ID)
@@ -1078,6 +1240,11 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 						}
 					}
 				}
+				if arrayLength >= 0 {
+					// A literal the C compiler can use to bound loops over the array
+					g.output.WriteString(fmt.Sprintf("  %s = %d;\n", varName, arrayLength))
+					return nil
+				}
 				// Map element type to C type to get element size
 				elementCType := g.mapType(arrayType)
 				// Calculate element size
@@ -1124,13 +1291,12 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 				return nil
 			}
 
-			// Special-case async I/O functions - they return Promise<T>
+			// Special-case async I/O functions - they return Promise<T> and run
+			// on the scheduler
 			if funcName == "std.io.read_line_async" || funcName == "io.read_line_async" {
 				if inst.ID != mir.InvalidValue {
 					varName := g.getVariableName(inst.ID)
-					tempVar := fmt.Sprintf("_temp_%d", inst.ID)
-					g.output.WriteString(fmt.Sprintf("  const char* %s = omni_read_line();\n", tempVar))
-					g.output.WriteString(fmt.Sprintf("  omni_promise_t* %s = omni_promise_create_string(%s);\n", varName, tempVar))
+					g.output.WriteString(fmt.Sprintf("  omni_promise_t* %s = omni_read_line_async();\n", varName))
 					g.valueTypes[inst.ID] = "Promise<string>"
 				}
 				return nil
@@ -1140,10 +1306,7 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 				if inst.ID != mir.InvalidValue && len(inst.Operands) >= 2 {
 					varName := g.getVariableName(inst.ID)
 					pathVar := g.getOperandValue(inst.Operands[1])
-					tempVar := fmt.Sprintf("_temp_%d", inst.ID)
-					// Declare temp variable first
-					g.output.WriteString(fmt.Sprintf("  const char* %s = omni_read_file(%s);\n", tempVar, pathVar))
-					g.output.WriteString(fmt.Sprintf("  omni_promise_t* %s = omni_promise_create_string(%s);\n", varName, tempVar))
+					g.output.WriteString(fmt.Sprintf("  omni_promise_t* %s = omni_read_file_async(%s);\n", varName, pathVar))
 					g.valueTypes[inst.ID] = "Promise<string>"
 					// Track the promise for cleanup
 					g.promisesToFree[inst.ID] = true
@@ -1156,9 +1319,7 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 					varName := g.getVariableName(inst.ID)
 					pathVar := g.getOperandValue(inst.Operands[1])
 					contentVar := g.getOperandValue(inst.Operands[2])
-					tempVar := fmt.Sprintf("_temp_%d", inst.ID)
-					g.output.WriteString(fmt.Sprintf("  int32_t %s = omni_write_file(%s, %s);\n", tempVar, pathVar, contentVar))
-					g.output.WriteString(fmt.Sprintf("  omni_promise_t* %s = omni_promise_create_bool(%s != 0);\n", varName, tempVar))
+					g.output.WriteString(fmt.Sprintf("  omni_promise_t* %s = omni_write_file_async(%s, %s);\n", varName, pathVar, contentVar))
 					g.valueTypes[inst.ID] = "Promise<bool>"
 					// Track the promise for cleanup
 					g.promisesToFree[inst.ID] = true
@@ -1171,9 +1332,7 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 					varName := g.getVariableName(inst.ID)
 					pathVar := g.getOperandValue(inst.Operands[1])
 					contentVar := g.getOperandValue(inst.Operands[2])
-					tempVar := fmt.Sprintf("_temp_%d", inst.ID)
-					g.output.WriteString(fmt.Sprintf("  int32_t %s = omni_append_file(%s, %s);\n", tempVar, pathVar, contentVar))
-					g.output.WriteString(fmt.Sprintf("  omni_promise_t* %s = omni_promise_create_bool(%s != 0);\n", varName, tempVar))
+					g.output.WriteString(fmt.Sprintf("  omni_promise_t* %s = omni_append_file_async(%s, %s);\n", varName, pathVar, contentVar))
 					g.valueTypes[inst.ID] = "Promise<bool>"
 					// Track the promise for cleanup
 					g.promisesToFree[inst.ID] = true
@@ -1309,27 +1468,12 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 							g.output.WriteString(fmt.Sprintf("  const char* %s = omni_http_request_get_header(%s, %s);\n", varName, reqVar, headerName))
 							g.stringsToFree[inst.ID] = true
 						}
-					} else if funcName == "omni_socket_receive" && inst.Type == "string" {
-						// Socket receive returns string
-						varName := g.getVariableName(inst.ID)
-						if len(inst.Operands) >= 3 {
-							socketVar := g.getOperandValue(inst.Operands[1])
-							bufferSizeVar := g.getOperandValue(inst.Operands[2])
-							// Allocate buffer
-							bufferVar := fmt.Sprintf("_buffer_%d", inst.ID)
-							g.output.WriteString(fmt.Sprintf("  char %s[%s + 1];\n", bufferVar, bufferSizeVar))
-							g.output.WriteString(fmt.Sprintf("  int32_t %s_len = omni_socket_receive(%s, %s, %s);\n", varName, socketVar, bufferVar, bufferSizeVar))
-							g.output.WriteString(fmt.Sprintf("  %s[%s_len] = '\\0';\n", bufferVar, varName))
-							g.output.WriteString(fmt.Sprintf("  const char* %s = strdup(%s);\n", varName, bufferVar))
-							g.stringsToFree[inst.ID] = true
-						}
 					} else if funcName == "omni_dns_lookup" && inst.Type != "" && strings.HasPrefix(inst.Type, "array<") {
-						// DNS lookup returns array of IPAddress
-						// For now, return empty array (stub implementation)
+						// DNS lookup returns array of IPAddress, resolved through the
+						// runtime's caching resolver; _count holds the number found
 						varName := g.getVariableName(inst.ID)
 						if len(inst.Operands) >= 2 {
 							hostname := g.getOperandValue(inst.Operands[1])
-							g.output.WriteString(fmt.Sprintf("  // DNS lookup stub - returns empty array\n"))
 							g.output.WriteString(fmt.Sprintf("  int32_t %s_count = 0;\n", varName))
 							g.output.WriteString(fmt.Sprintf("  omni_ip_address_t** %s = omni_dns_lookup(%s, &%s_count);\n", varName, hostname, varName))
 						}
@@ -1408,14 +1552,18 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 						// Stack create returns a new stack
 						varName := g.getVariableName(inst.ID)
 						g.output.WriteString(fmt.Sprintf("  omni_stack_t* %s = omni_stack_create();\n", varName))
-					} else if funcName == "omni_priority_queue_create" && inst.Type != "" && strings.HasPrefix(inst.Type, "priority_queue<") {
+					} else if (funcName == "omni_priority_queue_create" || funcName == "omni_priority_queue_create_min") && inst.Type != "" && strings.HasPrefix(inst.Type, "priority_queue<") {
 						// Priority queue create returns a new priority queue
 						varName := g.getVariableName(inst.ID)
-						g.output.WriteString(fmt.Sprintf("  omni_priority_queue_t* %s = omni_priority_queue_create();\n", varName))
+						g.output.WriteString(fmt.Sprintf("  omni_priority_queue_t* %s = %s();\n", varName, funcName))
 					} else if funcName == "omni_linked_list_create" && inst.Type != "" && strings.HasPrefix(inst.Type, "linked_list<") {
 						// Linked list create returns a new linked list
 						varName := g.getVariableName(inst.ID)
-						g.output.WriteString(fmt.Sprintf("  omni_linked_list_t* %s = omni_linked_list_create();\n", varName))
+						if g.declaredVariables[inst.ID] {
+							g.output.WriteString(fmt.Sprintf("  %s = omni_linked_list_create();\n", varName))
+						} else {
+							g.output.WriteString(fmt.Sprintf("  omni_linked_list_t* %s = omni_linked_list_create();\n", varName))
+						}
 					} else if funcName == "omni_binary_tree_create" && inst.Type != "" && strings.HasPrefix(inst.Type, "binary_tree<") {
 						// Binary tree create returns a new binary tree
 						varName := g.getVariableName(inst.ID)
@@ -1564,20 +1712,45 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 							if inst.Type == "string" {
 								g.stringsToFree[inst.ID] = true
 							}
+						} else if cFuncName == "omni_socket_receive" && inst.Type == "string" && len(inst.Operands) == 3 {
+							// Received data is an omni_str, so binary data keeps its length
+							g.output.WriteString(fmt.Sprintf("  %s = omni_socket_receive_string(%s, %s);\n",
+								varName, g.getOperandValue(inst.Operands[1]), g.getOperandValue(inst.Operands[2])))
+							g.stringsToFree[inst.ID] = true
+						} else if expr, ok := g.hoistedRegexCall(cFuncName, inst); ok {
+							// Constant pattern: use the handle compiled at startup
+							g.output.WriteString(fmt.Sprintf("  %s = %s;\n", varName, expr))
+							if inst.Type == "string" {
+								g.stringsToFree[inst.ID] = true
+							}
+						} else if expr, ok := g.lengthAwareCall(cFuncName, inst); ok {
+							// Known string lengths: use the runtime's length-aware fast path
+							g.output.WriteString(fmt.Sprintf("  %s = %s;\n", varName, expr))
+							if inst.Type == "string" && !g.arenaValues[inst.ID] {
+								g.stringsToFree[inst.ID] = true
+							}
 						} else {
 							// Regular function call - assign to already declared variable
-							g.output.WriteString(fmt.Sprintf("  %s = %s(",
-								varName, cFuncName))
+							// Non-escaping string results use the arena-backed variant
+							arenaFunc, hasArenaFunc := arenaStringFunctions[cFuncName]
+							useArenaFunc := hasArenaFunc && g.arenaValues[inst.ID]
+							if useArenaFunc {
+								g.output.WriteString(fmt.Sprintf("  %s = %s(%s",
+									varName, arenaFunc, arenaVar))
+							} else {
+								g.output.WriteString(fmt.Sprintf("  %s = %s(",
+									varName, cFuncName))
+							}
 							// Add arguments
 							for i, arg := range inst.Operands[1:] {
-								if i > 0 {
+								if i > 0 || useArenaFunc {
 									g.output.WriteString(", ")
 								}
 								g.output.WriteString(g.getOperandValue(arg))
 							}
 							g.output.WriteString(");\n")
 							// Track strings that need freeing if this function returns a heap-allocated string
-							if g.isStringReturningFunction(funcName) && inst.Type == "string" {
+							if !useArenaFunc && g.isStringReturningFunction(funcName) && inst.Type == "string" {
 								g.stringsToFree[inst.ID] = true
 							}
 							// Warn if function is called but doesn't have a runtime implementation
@@ -1622,6 +1795,7 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 				keyType, valueType := g.extractMapTypes(mapType)
 				getFunc := g.getMapGetFunction(keyType, valueType)
 				if getFunc != "" {
+					index = g.mapKey(inst.Operands[1], keyType)
 					g.output.WriteString(fmt.Sprintf("  %s = %s(%s, %s);\n", varName, getFunc, target, index))
 				} else {
 					g.errors = append(g.errors, fmt.Sprintf("unsupported map get operation for type: %s", mapType))
@@ -1654,61 +1828,33 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 				}
 				isStruct := !g.isPrimitiveType(resultType) && !strings.Contains(resultType, "<") && !strings.Contains(resultType, "(")
 
+				arrayLength := -1
+				if inst.Operands[0].Kind == mir.OperandValue {
+					if length, ok := g.arrayLengths[inst.Operands[0].Value]; ok {
+						arrayLength = length
+					}
+				}
+
 				if isStruct {
 					// For struct arrays, the element is already a pointer, so just index
 					g.output.WriteString(fmt.Sprintf("  %s = %s[%s];\n", varName, target, index))
 					// Store the struct type
 					g.valueTypes[inst.ID] = resultType
-				} else if elementType == "string" {
-					// For string arrays, use direct indexing (strings are const char*)
-					arrayLength := -1
-					if inst.Operands[0].Kind == mir.OperandValue {
-						arrayOperandID := inst.Operands[0].Value
-						if length, ok := g.arrayLengths[arrayOperandID]; ok {
-							arrayLength = length
-						}
-					}
-					if arrayLength >= 0 {
-						// Use bounds checking for string arrays
-						g.output.WriteString(fmt.Sprintf("  if (%s < 0 || %s >= %d) { fprintf(stderr, \"Array index out of bounds: %%d (length: %%d)\\n\", %s, %d); exit(1); }\n",
-							index, index, arrayLength, index, arrayLength))
-					}
+				} else if g.inRangeIndexes[inst.ID] {
+					// Proven in range by planBoundsChecks
 					g.output.WriteString(fmt.Sprintf("  %s = %s[%s];\n", varName, target, index))
-				} else if elementType == "int" || elementType == "int32" {
-					// For int arrays, use runtime function with bounds checking if length is known
-					arrayLength := -1
-					if inst.Operands[0].Kind == mir.OperandValue {
-						arrayOperandID := inst.Operands[0].Value
-						if length, ok := g.arrayLengths[arrayOperandID]; ok {
-							arrayLength = length
-						}
-					}
-					if arrayLength >= 0 {
-						// Use runtime function with bounds checking
-						g.output.WriteString(fmt.Sprintf("  %s = omni_array_get_int(%s, %s, %d);\n",
-							varName, target, index, arrayLength))
-					} else {
-						// Length unknown (might be parameter) - still use runtime function but with -1
-						// This will cause a runtime error rather than silent memory corruption
+				} else if arrayLength >= 0 {
+					// Inline check the C compiler may still hoist or drop
+					g.output.WriteString(fmt.Sprintf("  %s = %s[omni_array_check_index(%s, %d)];\n", varName, target, index, arrayLength))
+				} else {
+					// Length unknown (might be parameter): nothing to check against
+					if elementType == "int" || elementType == "int32" {
 						g.errors = append(g.errors, fmt.Sprintf("array length not known for indexing %s (ID: %d) - bounds checking disabled, may cause memory corruption", target, inst.Operands[0].Value))
 						g.output.WriteString(fmt.Sprintf("  // WARNING: Array length unknown, bounds checking disabled\n"))
 						g.output.WriteString(fmt.Sprintf("  %s = %s[%s]; // UNSAFE: No bounds check\n", varName, target, index))
+					} else {
+						g.output.WriteString(fmt.Sprintf("  %s = %s[%s];\n", varName, target, index))
 					}
-				} else {
-					// For other types (float, bool, etc.), use direct indexing
-					arrayLength := -1
-					if inst.Operands[0].Kind == mir.OperandValue {
-						arrayOperandID := inst.Operands[0].Value
-						if length, ok := g.arrayLengths[arrayOperandID]; ok {
-							arrayLength = length
-						}
-					}
-					if arrayLength >= 0 {
-						// Use bounds checking
-						g.output.WriteString(fmt.Sprintf("  if (%s < 0 || %s >= %d) { fprintf(stderr, \"Array index out of bounds: %%d (length: %%d)\\n\", %s, %d); exit(1); }\n",
-							index, index, arrayLength, index, arrayLength))
-					}
-					g.output.WriteString(fmt.Sprintf("  %s = %s[%s];\n", varName, target, index))
 				}
 			}
 		}
@@ -1773,7 +1919,6 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 		// Process key-value pairs from operands
 		for i := 0; i < len(inst.Operands); i += 2 {
 			if i+1 < len(inst.Operands) {
-				key := g.getOperandValue(inst.Operands[i])
 				value := g.getOperandValue(inst.Operands[i+1])
 
 				// Determine key and value types from the map type
@@ -1788,6 +1933,7 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 						// Generate appropriate put function call based on types
 						putFunc := g.getMapPutFunction(keyType, valueType)
 						if putFunc != "" {
+							key := g.mapKey(inst.Operands[i], keyType)
 							g.output.WriteString(fmt.Sprintf("  %s(%s, %s, %s);\n", putFunc, varName, key, value))
 						} else {
 							// Unsupported type combination - report error
@@ -1808,8 +1954,12 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 	case "struct.init":
 		// Handle struct initialization
 		varName := g.getVariableName(inst.ID)
-		// Assign to already declared variable
-		g.output.WriteString(fmt.Sprintf("  %s = omni_struct_create();\n", varName))
+		// Assign to already declared variable, with a slot for every field
+		if _, fields := structInitFields(inst); len(fields) > 0 {
+			g.output.WriteString(fmt.Sprintf("  %s = omni_struct_create_sized(%d);\n", varName, len(fields)))
+		} else {
+			g.output.WriteString(fmt.Sprintf("  %s = omni_struct_create();\n", varName))
+		}
 
 		// Process field-value pairs from operands
 		// Handle different operand formats: [field1Value, field2Value, ...] or [field1Name, field1Value, field2Name, field2Value, ...]
@@ -2014,11 +2164,11 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 							if fieldValueOp.Kind == mir.OperandLiteral && strings.HasPrefix(fieldValueOp.Literal, "\"") && strings.HasSuffix(fieldValueOp.Literal, "\"") {
 								actualValue = fieldValueOp.Literal
 							}
-							g.output.WriteString(fmt.Sprintf("  omni_struct_set_string_field(%s, \"%s\", %s);\n", varName, fieldName, actualValue))
+							g.output.WriteString(fmt.Sprintf("  omni_struct_set_string_field(%s, %s, %s);\n", varName, g.fieldKey(fieldName), actualValue))
 						case "float", "double":
-							g.output.WriteString(fmt.Sprintf("  omni_struct_set_float_field(%s, \"%s\", %s);\n", varName, fieldName, fieldValue))
+							g.output.WriteString(fmt.Sprintf("  omni_struct_set_float_field(%s, %s, %s);\n", varName, g.fieldKey(fieldName), fieldValue))
 						case "bool":
-							g.output.WriteString(fmt.Sprintf("  omni_struct_set_bool_field(%s, \"%s\", %s);\n", varName, fieldName, fieldValue))
+							g.output.WriteString(fmt.Sprintf("  omni_struct_set_bool_field(%s, %s, %s);\n", varName, g.fieldKey(fieldName), fieldValue))
 						default:
 							// For non-primitive types, we can't use the primitive setters
 							// This should have been caught earlier, but fail loudly here
@@ -2026,10 +2176,10 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 								g.errors = append(g.errors, fmt.Sprintf("cannot set struct field '%s' with type %s: only primitive types are supported", fieldName, fieldType))
 								// Fall back to int to prevent compilation errors
 								g.output.WriteString(fmt.Sprintf("  // ERROR: Cannot set field %s with type %s, using int setter (WRONG)\n", fieldName, fieldType))
-								g.output.WriteString(fmt.Sprintf("  omni_struct_set_int_field(%s, \"%s\", %s); // WRONG TYPE\n", varName, fieldName, fieldValue))
+								g.output.WriteString(fmt.Sprintf("  omni_struct_set_int_field(%s, %s, %s); // WRONG TYPE\n", varName, g.fieldKey(fieldName), fieldValue))
 							} else {
 								// Default to int for unknown primitive types
-								g.output.WriteString(fmt.Sprintf("  omni_struct_set_int_field(%s, \"%s\", %s);\n", varName, fieldName, fieldValue))
+								g.output.WriteString(fmt.Sprintf("  omni_struct_set_int_field(%s, %s, %s);\n", varName, g.fieldKey(fieldName), fieldValue))
 							}
 						}
 					}
@@ -2077,13 +2227,13 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 						if fieldValueOp.Kind == mir.OperandLiteral && strings.HasPrefix(fieldValueOp.Literal, "\"") && strings.HasSuffix(fieldValueOp.Literal, "\"") {
 							actualValue = fieldValueOp.Literal
 						}
-						g.output.WriteString(fmt.Sprintf("  omni_struct_set_string_field(%s, \"%s\", %s);\n", varName, fieldName, actualValue))
+						g.output.WriteString(fmt.Sprintf("  omni_struct_set_string_field(%s, %s, %s);\n", varName, g.fieldKey(fieldName), actualValue))
 					case "float", "double":
-						g.output.WriteString(fmt.Sprintf("  omni_struct_set_float_field(%s, \"%s\", %s);\n", varName, fieldName, fieldValue))
+						g.output.WriteString(fmt.Sprintf("  omni_struct_set_float_field(%s, %s, %s);\n", varName, g.fieldKey(fieldName), fieldValue))
 					case "bool":
-						g.output.WriteString(fmt.Sprintf("  omni_struct_set_bool_field(%s, \"%s\", %s);\n", varName, fieldName, fieldValue))
+						g.output.WriteString(fmt.Sprintf("  omni_struct_set_bool_field(%s, %s, %s);\n", varName, g.fieldKey(fieldName), fieldValue))
 					default:
-						g.output.WriteString(fmt.Sprintf("  omni_struct_set_int_field(%s, \"%s\", %s);\n", varName, fieldName, fieldValue))
+						g.output.WriteString(fmt.Sprintf("  omni_struct_set_int_field(%s, %s, %s);\n", varName, g.fieldKey(fieldName), fieldValue))
 					}
 				}
 			}
@@ -2091,7 +2241,6 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 	case "member":
 		// Handle struct member access
 		if len(inst.Operands) >= 2 {
-			structVar := g.getOperandValue(inst.Operands[0])
 			fieldName := inst.Operands[1].Literal
 			varName := g.getVariableName(inst.ID)
 
@@ -2148,17 +2297,17 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 			// Use appropriate getter based on field type
 			switch fieldType {
 			case "string":
-				g.output.WriteString(fmt.Sprintf("  %s = omni_struct_get_string_field(%s, \"%s\");\n", varName, structVar, fieldName))
+				g.output.WriteString(fmt.Sprintf("  %s = %s;\n", varName, g.structFieldGet("string", inst.Operands[0], fieldName)))
 				g.valueTypes[inst.ID] = "string"
 			case "float", "double":
-				g.output.WriteString(fmt.Sprintf("  %s = omni_struct_get_float_field(%s, \"%s\");\n", varName, structVar, fieldName))
+				g.output.WriteString(fmt.Sprintf("  %s = %s;\n", varName, g.structFieldGet("float", inst.Operands[0], fieldName)))
 				g.valueTypes[inst.ID] = fieldType
 			case "bool":
-				g.output.WriteString(fmt.Sprintf("  %s = omni_struct_get_bool_field(%s, \"%s\");\n", varName, structVar, fieldName))
+				g.output.WriteString(fmt.Sprintf("  %s = %s;\n", varName, g.structFieldGet("bool", inst.Operands[0], fieldName)))
 				g.valueTypes[inst.ID] = "bool"
 			default:
 				// Default to int
-				g.output.WriteString(fmt.Sprintf("  %s = omni_struct_get_int_field(%s, \"%s\");\n", varName, structVar, fieldName))
+				g.output.WriteString(fmt.Sprintf("  %s = %s;\n", varName, g.structFieldGet("int", inst.Operands[0], fieldName)))
 				g.valueTypes[inst.ID] = "int"
 			}
 		}
@@ -2188,11 +2337,11 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 			if leftType == "string" || rightType == "string" {
 				switch inst.Op {
 				case "cmp.eq":
-					g.output.WriteString(fmt.Sprintf("  %s = omni_string_equals(%s, %s) ? 1 : 0;\n",
-						varName, left, right))
+					g.output.WriteString(fmt.Sprintf("  %s = %s ? 1 : 0;\n",
+						varName, g.stringEqualsExpr(inst.Operands[0], inst.Operands[1])))
 				case "cmp.neq":
-					g.output.WriteString(fmt.Sprintf("  %s = omni_string_equals(%s, %s) ? 0 : 1;\n",
-						varName, left, right))
+					g.output.WriteString(fmt.Sprintf("  %s = %s ? 0 : 1;\n",
+						varName, g.stringEqualsExpr(inst.Operands[0], inst.Operands[1])))
 				case "cmp.lt":
 					g.output.WriteString(fmt.Sprintf("  %s = (omni_string_compare(%s, %s) < 0) ? 1 : 0;\n",
 						varName, left, right))
@@ -2234,6 +2383,10 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 		if len(inst.Operands) >= 2 {
 			target := g.getOperandValue(inst.Operands[0])
 			source := g.getOperandValue(inst.Operands[1])
+			if g.omniStrCopies[inst.ID] {
+				// The target is an omni_str on every path (see omnistr.go)
+				source = g.omniStrCopyExpr(inst.Operands[1])
+			}
 
 			// Assign the source value to the target variable
 			g.output.WriteString(fmt.Sprintf("  %s = %s;\n", target, source))
@@ -2241,6 +2394,27 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 			// Update the variable mapping to point to the target
 			g.variables[inst.ID] = target
 		}
+	case "list.begin":
+		// Range loops over linked lists walk a cursor instead of indexing
+		if len(inst.Operands) >= 1 {
+			list := g.getOperandValue(inst.Operands[0])
+			g.output.WriteString(fmt.Sprintf("  %s = omni_linked_list_begin(%s);\n", g.getVariableName(inst.ID), list))
+		}
+	case "list.valid":
+		if len(inst.Operands) >= 1 {
+			cursor := g.getOperandValue(inst.Operands[0])
+			g.output.WriteString(fmt.Sprintf("  %s = omni_linked_list_cursor_valid(&%s);\n", g.getVariableName(inst.ID), cursor))
+		}
+	case "list.value":
+		if len(inst.Operands) >= 1 {
+			cursor := g.getOperandValue(inst.Operands[0])
+			g.output.WriteString(fmt.Sprintf("  %s = omni_linked_list_cursor_value(&%s);\n", g.getVariableName(inst.ID), cursor))
+		}
+	case "list.next":
+		if len(inst.Operands) >= 1 {
+			cursor := g.getOperandValue(inst.Operands[0])
+			g.output.WriteString(fmt.Sprintf("  omni_linked_list_next(&%s);\n", cursor))
+		}
 	case "phi":
 		// Handle PHI nodes - for loops, we need to create mutable variables
 		if len(inst.Operands) >= 2 {
@@ -2509,6 +2683,14 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 			level := g.getOperandValue(inst.Operands[0])
 			g.output.WriteString(fmt.Sprintf("  omni_log_set_level(%s);\n", level))
 		}
+	case "std.log.set_mode":
+		// Handle log mode selection (sync, async, async_drop)
+		if len(inst.Operands) >= 1 {
+			mode := g.getOperandValue(inst.Operands[0])
+			g.output.WriteString(fmt.Sprintf("  omni_log_set_mode(%s);\n", mode))
+		}
+	case "std.log.flush":
+		g.output.WriteString("  omni_log_flush();\n")
 	case "await":
 		// Handle await instruction - unwrap Promise<T> to T
 		if len(inst.Operands) >= 1 {
@@ -2645,6 +2827,12 @@ func (g *CGenerator) generateInstruction(inst *mir.Instruction) error {
 					resultType = "int" // Store as int to prevent further type errors
 				}
 			}
+			// A promise awaited only here is not needed any more
+			if g.awaitedPromises[inst.ID] {
+				g.output.WriteString(fmt.Sprintf("  omni_promise_free(%s);\n", promiseVar))
+				g.output.WriteString(fmt.Sprintf("  %s = NULL;\n", promiseVar))
+				delete(g.promisesToFree, inst.Operands[0].Value)
+			}
 			// Store the result type
 			g.valueTypes[inst.ID] = resultType
 		}
@@ -2670,6 +2858,8 @@ func (g *CGenerator) generateTerminator(term *mir.Terminator, funcName string, o
 				g.returnedValueID = term.Operands[0].Value
 			}
 			value := g.getOperandValue(term.Operands[0])
+			g.emitArenaRelease()
+			g.emitProfileExit()
 			// Special case: async main returns int32_t directly (no promise wrapping)
 			// The value is already the unwrapped type (int), not a promise
 			if funcName == "omni_main" && strings.HasPrefix(originalReturnType, "Promise<") {
@@ -2714,15 +2904,22 @@ func (g *CGenerator) generateTerminator(term *mir.Terminator, funcName string, o
 				g.output.WriteString(fmt.Sprintf("  return %s(%s);\n", promiseFunc, value))
 			} else {
 				// For string return types, exclude the returned value from cleanup
-				if originalReturnType == "string" || originalReturnType == "const char*" || originalReturnType == "char*" {
+				isString := originalReturnType == "string" || originalReturnType == "const char*" || originalReturnType == "char*"
+				if isString && strings.HasSuffix(funcName, asyncBodySuffix) {
+					g.emitAsyncStringReturn(term.Operands[0])
+				} else {
+					g.output.WriteString(fmt.Sprintf("  return %s;\n", value))
+				}
+				if isString {
 					// The returned string is owned by the caller, don't free it
 					if term.Operands[0].Kind == mir.OperandValue {
 						delete(g.stringsToFree, term.Operands[0].Value)
 					}
 				}
-				g.output.WriteString(fmt.Sprintf("  return %s;\n", value))
 			}
 		} else {
+			g.emitArenaRelease()
+			g.emitProfileExit()
 			// For main function (omni_main), return 0 instead of void return
 			// Check if this is actually omni_main (mapped from main)
 			if funcName == "omni_main" {
@@ -2808,54 +3005,65 @@ func (g *CGenerator) convertOperandToString(op mir.Operand) string {
 		} else if operandType == "int" {
 			// Convert int to string - use unique counter to avoid conflicts
 			tempVar := fmt.Sprintf("temp_str_%d_%d", op.Value, g.output.Len())
-			g.output.WriteString(fmt.Sprintf("  const char* %s = omni_int_to_string(%s);\n", tempVar, varName))
-			// Track this temporary string for cleanup
-			g.tempStringsToFree = append(g.tempStringsToFree, tempVar)
+			g.emitConversionTemp(tempVar, "omni_int_to_string", varName)
 			return tempVar
 		} else if operandType == "float" || operandType == "double" {
 			// Convert float to string - use unique counter to avoid conflicts
 			tempVar := fmt.Sprintf("temp_str_%d_%d", op.Value, g.output.Len())
-			g.output.WriteString(fmt.Sprintf("  const char* %s = omni_float_to_string(%s);\n", tempVar, varName))
-			// Track this temporary string for cleanup
-			g.tempStringsToFree = append(g.tempStringsToFree, tempVar)
+			g.emitConversionTemp(tempVar, "omni_float_to_string", varName)
 			return tempVar
 		} else if operandType == "bool" {
 			// Convert bool to string - use unique counter to avoid conflicts
 			tempVar := fmt.Sprintf("temp_str_%d_%d", op.Value, g.output.Len())
-			g.output.WriteString(fmt.Sprintf("  const char* %s = omni_bool_to_string(%s);\n", tempVar, varName))
-			// Track this temporary string for cleanup
-			g.tempStringsToFree = append(g.tempStringsToFree, tempVar)
+			g.emitConversionTemp(tempVar, "omni_bool_to_string", varName)
 			return tempVar
 		} else {
 			// Default: assume int - use unique counter to avoid conflicts
 			tempVar := fmt.Sprintf("temp_str_%d_%d", op.Value, g.output.Len())
-			g.output.WriteString(fmt.Sprintf("  const char* %s = omni_int_to_string(%s);\n", tempVar, varName))
-			// Track this temporary string for cleanup
-			g.tempStringsToFree = append(g.tempStringsToFree, tempVar)
+			g.emitConversionTemp(tempVar, "omni_int_to_string", varName)
 			return tempVar
 		}
 
 	case mir.OperandLiteral:
 		// For literals, we need to convert based on the literal type
 		if op.Literal == "true" {
-			return "omni_bool_to_string(1)"
+			return g.conversionCall("omni_bool_to_string", "1")
 		} else if op.Literal == "false" {
-			return "omni_bool_to_string(0)"
+			return g.conversionCall("omni_bool_to_string", "0")
 		} else if strings.HasPrefix(op.Literal, "\"") && strings.HasSuffix(op.Literal, "\"") {
 			// String literal - return as is
 			return op.Literal
 		} else if strings.Contains(op.Literal, ".") {
 			// Float literal - convert to string
-			return fmt.Sprintf("omni_float_to_string(%s)", op.Literal)
+			return g.conversionCall("omni_float_to_string", op.Literal)
 		} else {
 			// Integer literal - convert to string
-			return fmt.Sprintf("omni_int_to_string(%s)", op.Literal)
+			return g.conversionCall("omni_int_to_string", op.Literal)
 		}
 	default:
 		return "/* unknown operand */"
 	}
 }
 
+// emitConversionTemp declares tempVar as the string form of value. Temporaries
+// come from the scratch arena when the function uses one, otherwise they are
+// tracked in tempStringsToFree.
+func (g *CGenerator) emitConversionTemp(tempVar, convFunc, value string) {
+	g.output.WriteString(fmt.Sprintf("  const char* %s = %s;\n", tempVar, g.conversionCall(convFunc, value)))
+	if !g.useArena {
+		g.tempStringsToFree = append(g.tempStringsToFree, tempVar)
+	}
+}
+
+// conversionCall returns the C expression converting value to a string with
+// convFunc, routed through the scratch arena when the function uses one.
+func (g *CGenerator) conversionCall(convFunc, value string) string {
+	if arenaFunc, ok := arenaStringFunctions[convFunc]; ok && g.useArena {
+		return fmt.Sprintf("%s(%s, %s)", arenaFunc, arenaVar, value)
+	}
+	return fmt.Sprintf("%s(%s)", convFunc, value)
+}
+
 // emitPrint handles std.io.print/println for primitive and convertible types.
 func (g *CGenerator) emitPrint(op mir.Operand, newline bool) {
 	funcName := "omni_print_string"
@@ -2939,6 +3147,19 @@ func (g *CGenerator) mapType(omniType string) string {
 		return "omni_struct_t*"
 	}
 
+	// Handle sets
+	if strings.HasPrefix(omniType, "set<") && strings.HasSuffix(omniType, ">") {
+		return "omni_set_t*"
+	}
+
+	// Handle linked lists and the cursors range loops walk them with
+	if strings.HasPrefix(omniType, "linked_list<") && strings.HasSuffix(omniType, ">") {
+		return "omni_linked_list_t*"
+	}
+	if omniType == "linked_list_cursor" {
+		return "omni_linked_list_cursor_t"
+	}
+
 	// Handle named struct types (like Point, User, etc.)
 	// For now, assume any unknown type that's not a primitive is a struct
 	if !g.isPrimitiveType(omniType) && !strings.Contains(omniType, "(") && !strings.Contains(omniType, "<") {
@@ -3261,6 +3482,19 @@ func (g *CGenerator) mapFunctionName(funcName string) string {
 		return "omni_map_copy_string_int"
 	case "std.collections.merge":
 		return "omni_map_merge_string_int"
+	case "std.collections.map_from_arrays":
+		return "omni_parallel_build_map_int"
+	// Parallel algorithms
+	case "std.algorithms.parallel_sort":
+		return "omni_parallel_sort_int"
+	case "std.algorithms.parallel_sort_strings":
+		return "omni_parallel_sort_string"
+	case "std.algorithms.parallel_sum":
+		return "omni_parallel_sum_int"
+	case "std.algorithms.parallel_min":
+		return "omni_parallel_min_int"
+	case "std.algorithms.parallel_max":
+		return "omni_parallel_max_int"
 	// Set functions
 	case "std.collections.set_create":
 		return "omni_set_create"
@@ -3280,6 +3514,12 @@ func (g *CGenerator) mapFunctionName(funcName string) string {
 		return "omni_set_intersection"
 	case "std.collections.set_difference":
 		return "omni_set_difference"
+	case "std.collections.set_union_with":
+		return "omni_set_union_with"
+	case "std.collections.set_intersect_with":
+		return "omni_set_intersect_with"
+	case "std.collections.set_difference_with":
+		return "omni_set_difference_with"
 	// Queue functions
 	case "std.collections.queue_create":
 		return "omni_queue_create"
@@ -3323,6 +3563,16 @@ func (g *CGenerator) mapFunctionName(funcName string) string {
 		return "omni_priority_queue_is_empty"
 	case "std.collections.priority_queue_size":
 		return "omni_priority_queue_size"
+	case "std.collections.priority_queue_create_min":
+		return "omni_priority_queue_create_min"
+	case "std.collections.priority_queue_push":
+		return "omni_priority_queue_push"
+	case "std.collections.priority_queue_decrease_key":
+		return "omni_priority_queue_decrease_key"
+	case "std.collections.priority_queue_remove":
+		return "omni_priority_queue_remove"
+	case "std.collections.priority_queue_clear":
+		return "omni_priority_queue_clear"
 	// Linked list functions
 	case "std.collections.linked_list_create":
 		return "omni_linked_list_create"
@@ -3406,6 +3656,18 @@ func (g *CGenerator) mapFunctionName(funcName string) string {
 		return "omni_socket_receive"
 	case "std.network.socket_close":
 		return "omni_socket_close"
+	case "std.network.socket_set_nonblocking":
+		return "omni_socket_set_nonblocking"
+	case "std.network.socket_set_reuse_port":
+		return "omni_socket_set_reuse_port"
+	case "std.network.socket_listen_shared":
+		return "omni_socket_listen_shared"
+	case "std.network.socket_accept_async":
+		return "omni_socket_accept_async"
+	case "std.network.socket_receive_async":
+		return "omni_socket_receive_async"
+	case "std.network.socket_send_async":
+		return "omni_socket_send_async"
 	case "std.network.network_is_connected":
 		return "omni_network_is_connected"
 	case "std.network.network_get_local_ip":
@@ -3432,6 +3694,10 @@ func (g *CGenerator) mapFunctionName(funcName string) string {
 		return "omni_log_error"
 	case "std.log.set_level":
 		return "omni_log_set_level"
+	case "std.log.set_mode":
+		return "omni_log_set_mode"
+	case "std.log.flush":
+		return "omni_log_flush"
 
 	// String functions
 	case "std.string.length":
@@ -3544,6 +3810,14 @@ func (g *CGenerator) mapFunctionName(funcName string) string {
 		return "omni_string_is_upper"
 	case "string.is_lower":
 		return "omni_string_is_lower"
+	// Regex functions (find_all_matches is left to the stdlib until it
+	// returns an array)
+	case "std.string.matches", "string.matches":
+		return "omni_string_matches"
+	case "std.string.find_match", "string.find_match":
+		return "omni_string_find_match"
+	case "std.string.replace_regex", "string.replace_regex":
+		return "omni_string_replace_regex"
 	case "std.string.encode_base64":
 		return "omni_encode_base64"
 	case "std.string.decode_base64":
@@ -3819,6 +4093,8 @@ func (g *CGenerator) hasRuntimeImplementation(funcName string) bool {
 		"std.log.warn":      "omni_log_warn",
 		"std.log.error":     "omni_log_error",
 		"std.log.set_level": "omni_log_set_level",
+		"std.log.set_mode":  "omni_log_set_mode",
+		"std.log.flush":     "omni_log_flush",
 
 		// File operations
 		"std.file.open":      "omni_file_open",
@@ -3971,20 +4247,30 @@ func (g *CGenerator) hasRuntimeImplementation(funcName string) bool {
 		"os.getppid":     "omni_getppid",
 
 		// Collections functions
-		"std.collections.keys":   "omni_map_keys_string_int",
-		"std.collections.values": "omni_map_values_string_int",
-		"std.collections.copy":   "omni_map_copy_string_int",
-		"std.collections.merge":  "omni_map_merge_string_int",
+		"std.collections.keys":            "omni_map_keys_string_int",
+		"std.collections.values":          "omni_map_values_string_int",
+		"std.collections.copy":            "omni_map_copy_string_int",
+		"std.collections.merge":           "omni_map_merge_string_int",
+		"std.collections.map_from_arrays": "omni_parallel_build_map_int",
+		// Parallel algorithms
+		"std.algorithms.parallel_sort":         "omni_parallel_sort_int",
+		"std.algorithms.parallel_sort_strings": "omni_parallel_sort_string",
+		"std.algorithms.parallel_sum":          "omni_parallel_sum_int",
+		"std.algorithms.parallel_min":          "omni_parallel_min_int",
+		"std.algorithms.parallel_max":          "omni_parallel_max_int",
 		// Set functions
-		"std.collections.set_create":       "omni_set_create",
-		"std.collections.set_add":          "omni_set_add",
-		"std.collections.set_remove":       "omni_set_remove",
-		"std.collections.set_contains":     "omni_set_contains",
-		"std.collections.set_size":         "omni_set_size",
-		"std.collections.set_clear":        "omni_set_clear",
-		"std.collections.set_union":        "omni_set_union",
-		"std.collections.set_intersection": "omni_set_intersection",
-		"std.collections.set_difference":   "omni_set_difference",
+		"std.collections.set_create":          "omni_set_create",
+		"std.collections.set_add":             "omni_set_add",
+		"std.collections.set_remove":          "omni_set_remove",
+		"std.collections.set_contains":        "omni_set_contains",
+		"std.collections.set_size":            "omni_set_size",
+		"std.collections.set_clear":           "omni_set_clear",
+		"std.collections.set_union":           "omni_set_union",
+		"std.collections.set_intersection":    "omni_set_intersection",
+		"std.collections.set_difference":      "omni_set_difference",
+		"std.collections.set_union_with":      "omni_set_union_with",
+		"std.collections.set_intersect_with":  "omni_set_intersect_with",
+		"std.collections.set_difference_with": "omni_set_difference_with",
 		// Queue functions
 		"std.collections.queue_create":   "omni_queue_create",
 		"std.collections.queue_enqueue":  "omni_queue_enqueue",
@@ -4002,12 +4288,17 @@ func (g *CGenerator) hasRuntimeImplementation(funcName string) bool {
 		"std.collections.stack_size":     "omni_stack_size",
 		"std.collections.stack_clear":    "omni_stack_clear",
 		// Priority queue functions
-		"std.collections.priority_queue_create":      "omni_priority_queue_create",
-		"std.collections.priority_queue_insert":      "omni_priority_queue_insert",
-		"std.collections.priority_queue_extract_max": "omni_priority_queue_extract_max",
-		"std.collections.priority_queue_peek":        "omni_priority_queue_peek",
-		"std.collections.priority_queue_is_empty":    "omni_priority_queue_is_empty",
-		"std.collections.priority_queue_size":        "omni_priority_queue_size",
+		"std.collections.priority_queue_create":       "omni_priority_queue_create",
+		"std.collections.priority_queue_insert":       "omni_priority_queue_insert",
+		"std.collections.priority_queue_extract_max":  "omni_priority_queue_extract_max",
+		"std.collections.priority_queue_peek":         "omni_priority_queue_peek",
+		"std.collections.priority_queue_is_empty":     "omni_priority_queue_is_empty",
+		"std.collections.priority_queue_size":         "omni_priority_queue_size",
+		"std.collections.priority_queue_create_min":   "omni_priority_queue_create_min",
+		"std.collections.priority_queue_push":         "omni_priority_queue_push",
+		"std.collections.priority_queue_decrease_key": "omni_priority_queue_decrease_key",
+		"std.collections.priority_queue_remove":       "omni_priority_queue_remove",
+		"std.collections.priority_queue_clear":        "omni_priority_queue_clear",
 		// Linked list functions
 		"std.collections.linked_list_create":   "omni_linked_list_create",
 		"std.collections.linked_list_append":   "omni_linked_list_append",
@@ -4028,32 +4319,38 @@ func (g *CGenerator) hasRuntimeImplementation(funcName string) bool {
 		"std.collections.binary_tree_is_empty": "omni_binary_tree_is_empty",
 		"std.collections.binary_tree_clear":    "omni_binary_tree_clear",
 		// Network functions
-		"std.network.ip_parse":             "omni_ip_parse",
-		"std.network.ip_is_valid":          "omni_ip_is_valid",
-		"std.network.ip_is_private":        "omni_ip_is_private",
-		"std.network.ip_is_loopback":       "omni_ip_is_loopback",
-		"std.network.ip_to_string":         "omni_ip_to_string",
-		"std.network.url_parse":            "omni_url_parse",
-		"std.network.url_to_string":        "omni_url_to_string",
-		"std.network.url_is_valid":         "omni_url_is_valid",
-		"std.network.dns_lookup":           "omni_dns_lookup",
-		"std.network.dns_reverse_lookup":   "omni_dns_reverse_lookup",
-		"std.network.http_get":             "omni_http_get",
-		"std.network.http_post":            "omni_http_post",
-		"std.network.http_put":             "omni_http_put",
-		"std.network.http_delete":          "omni_http_delete",
-		"std.network.http_request":         "omni_http_request",
-		"std.network.socket_create":        "omni_socket_create",
-		"std.network.socket_connect":       "omni_socket_connect",
-		"std.network.socket_bind":          "omni_socket_bind",
-		"std.network.socket_listen":        "omni_socket_listen",
-		"std.network.socket_accept":        "omni_socket_accept",
-		"std.network.socket_send":          "omni_socket_send",
-		"std.network.socket_receive":       "omni_socket_receive",
-		"std.network.socket_close":         "omni_socket_close",
-		"std.network.network_is_connected": "omni_network_is_connected",
-		"std.network.network_get_local_ip": "omni_network_get_local_ip",
-		"std.network.network_ping":         "omni_network_ping",
+		"std.network.ip_parse":               "omni_ip_parse",
+		"std.network.ip_is_valid":            "omni_ip_is_valid",
+		"std.network.ip_is_private":          "omni_ip_is_private",
+		"std.network.ip_is_loopback":         "omni_ip_is_loopback",
+		"std.network.ip_to_string":           "omni_ip_to_string",
+		"std.network.url_parse":              "omni_url_parse",
+		"std.network.url_to_string":          "omni_url_to_string",
+		"std.network.url_is_valid":           "omni_url_is_valid",
+		"std.network.dns_lookup":             "omni_dns_lookup",
+		"std.network.dns_reverse_lookup":     "omni_dns_reverse_lookup",
+		"std.network.http_get":               "omni_http_get",
+		"std.network.http_post":              "omni_http_post",
+		"std.network.http_put":               "omni_http_put",
+		"std.network.http_delete":            "omni_http_delete",
+		"std.network.http_request":           "omni_http_request",
+		"std.network.socket_create":          "omni_socket_create",
+		"std.network.socket_connect":         "omni_socket_connect",
+		"std.network.socket_bind":            "omni_socket_bind",
+		"std.network.socket_listen":          "omni_socket_listen",
+		"std.network.socket_accept":          "omni_socket_accept",
+		"std.network.socket_send":            "omni_socket_send",
+		"std.network.socket_receive":         "omni_socket_receive",
+		"std.network.socket_close":           "omni_socket_close",
+		"std.network.socket_set_nonblocking": "omni_socket_set_nonblocking",
+		"std.network.socket_set_reuse_port":  "omni_socket_set_reuse_port",
+		"std.network.socket_listen_shared":   "omni_socket_listen_shared",
+		"std.network.socket_accept_async":    "omni_socket_accept_async",
+		"std.network.socket_receive_async":   "omni_socket_receive_async",
+		"std.network.socket_send_async":      "omni_socket_send_async",
+		"std.network.network_is_connected":   "omni_network_is_connected",
+		"std.network.network_get_local_ip":   "omni_network_get_local_ip",
+		"std.network.network_ping":           "omni_network_ping",
 	}
 
 	_, exists := runtimeImplMap[funcName]
@@ -4155,89 +4452,111 @@ func (g *CGenerator) isRuntimeProvidedFunction(funcName string) bool {
 		"std.log.warn":        true,
 		"std.log.error":       true,
 		"std.log.set_level":   true,
+		"std.log.set_mode":    true,
+		"std.log.flush":       true,
 		"std.test.start":      true,
 		"std.test.end":        true,
 		"std.assert":          true,
 		"test.start":          true,
 		"test.end":            true,
 		// Collections functions
-		"std.collections.keys":                       true,
-		"std.collections.values":                     true,
-		"std.collections.copy":                       true,
-		"std.collections.merge":                      true,
-		"std.collections.set_create":                 true,
-		"std.collections.set_add":                    true,
-		"std.collections.set_remove":                 true,
-		"std.collections.set_contains":               true,
-		"std.collections.set_size":                   true,
-		"std.collections.set_clear":                  true,
-		"std.collections.set_union":                  true,
-		"std.collections.set_intersection":           true,
-		"std.collections.set_difference":             true,
-		"std.collections.queue_create":               true,
-		"std.collections.queue_enqueue":              true,
-		"std.collections.queue_dequeue":              true,
-		"std.collections.queue_peek":                 true,
-		"std.collections.queue_is_empty":             true,
-		"std.collections.queue_size":                 true,
-		"std.collections.queue_clear":                true,
-		"std.collections.stack_create":               true,
-		"std.collections.stack_push":                 true,
-		"std.collections.stack_pop":                  true,
-		"std.collections.stack_peek":                 true,
-		"std.collections.stack_is_empty":             true,
-		"std.collections.stack_size":                 true,
-		"std.collections.stack_clear":                true,
-		"std.collections.priority_queue_create":      true,
-		"std.collections.priority_queue_insert":      true,
-		"std.collections.priority_queue_extract_max": true,
-		"std.collections.priority_queue_peek":        true,
-		"std.collections.priority_queue_is_empty":    true,
-		"std.collections.priority_queue_size":        true,
-		"std.collections.linked_list_create":         true,
-		"std.collections.linked_list_append":         true,
-		"std.collections.linked_list_prepend":        true,
-		"std.collections.linked_list_insert":         true,
-		"std.collections.linked_list_remove":         true,
-		"std.collections.linked_list_get":            true,
-		"std.collections.linked_list_set":            true,
-		"std.collections.linked_list_size":           true,
-		"std.collections.linked_list_is_empty":       true,
-		"std.collections.linked_list_clear":          true,
-		"std.collections.binary_tree_create":         true,
-		"std.collections.binary_tree_insert":         true,
-		"std.collections.binary_tree_search":         true,
-		"std.collections.binary_tree_remove":         true,
-		"std.collections.binary_tree_size":           true,
-		"std.collections.binary_tree_is_empty":       true,
-		"std.collections.binary_tree_clear":          true,
+		"std.collections.keys":                        true,
+		"std.collections.values":                      true,
+		"std.collections.copy":                        true,
+		"std.collections.merge":                       true,
+		"std.collections.map_from_arrays":             true,
+		"std.algorithms.parallel_sort":                true,
+		"std.algorithms.parallel_sort_strings":        true,
+		"std.algorithms.parallel_sum":                 true,
+		"std.algorithms.parallel_min":                 true,
+		"std.algorithms.parallel_max":                 true,
+		"std.collections.set_create":                  true,
+		"std.collections.set_add":                     true,
+		"std.collections.set_remove":                  true,
+		"std.collections.set_contains":                true,
+		"std.collections.set_size":                    true,
+		"std.collections.set_clear":                   true,
+		"std.collections.set_union":                   true,
+		"std.collections.set_intersection":            true,
+		"std.collections.set_difference":              true,
+		"std.collections.set_union_with":              true,
+		"std.collections.set_intersect_with":          true,
+		"std.collections.set_difference_with":         true,
+		"std.collections.queue_create":                true,
+		"std.collections.queue_enqueue":               true,
+		"std.collections.queue_dequeue":               true,
+		"std.collections.queue_peek":                  true,
+		"std.collections.queue_is_empty":              true,
+		"std.collections.queue_size":                  true,
+		"std.collections.queue_clear":                 true,
+		"std.collections.stack_create":                true,
+		"std.collections.stack_push":                  true,
+		"std.collections.stack_pop":                   true,
+		"std.collections.stack_peek":                  true,
+		"std.collections.stack_is_empty":              true,
+		"std.collections.stack_size":                  true,
+		"std.collections.stack_clear":                 true,
+		"std.collections.priority_queue_create":       true,
+		"std.collections.priority_queue_insert":       true,
+		"std.collections.priority_queue_extract_max":  true,
+		"std.collections.priority_queue_peek":         true,
+		"std.collections.priority_queue_is_empty":     true,
+		"std.collections.priority_queue_size":         true,
+		"std.collections.priority_queue_create_min":   true,
+		"std.collections.priority_queue_push":         true,
+		"std.collections.priority_queue_decrease_key": true,
+		"std.collections.priority_queue_remove":       true,
+		"std.collections.priority_queue_clear":        true,
+		"std.collections.linked_list_create":          true,
+		"std.collections.linked_list_append":          true,
+		"std.collections.linked_list_prepend":         true,
+		"std.collections.linked_list_insert":          true,
+		"std.collections.linked_list_remove":          true,
+		"std.collections.linked_list_get":             true,
+		"std.collections.linked_list_set":             true,
+		"std.collections.linked_list_size":            true,
+		"std.collections.linked_list_is_empty":        true,
+		"std.collections.linked_list_clear":           true,
+		"std.collections.binary_tree_create":          true,
+		"std.collections.binary_tree_insert":          true,
+		"std.collections.binary_tree_search":          true,
+		"std.collections.binary_tree_remove":          true,
+		"std.collections.binary_tree_size":            true,
+		"std.collections.binary_tree_is_empty":        true,
+		"std.collections.binary_tree_clear":           true,
 		// Network functions
-		"std.network.ip_parse":             true,
-		"std.network.ip_is_valid":          true,
-		"std.network.ip_is_private":        true,
-		"std.network.ip_is_loopback":       true,
-		"std.network.ip_to_string":         true,
-		"std.network.url_parse":            true,
-		"std.network.url_to_string":        true,
-		"std.network.url_is_valid":         true,
-		"std.network.dns_lookup":           true,
-		"std.network.dns_reverse_lookup":   true,
-		"std.network.http_get":             true,
-		"std.network.http_post":            true,
-		"std.network.http_put":             true,
-		"std.network.http_delete":          true,
-		"std.network.http_request":         true,
-		"std.network.socket_create":        true,
-		"std.network.socket_connect":       true,
-		"std.network.socket_bind":          true,
-		"std.network.socket_listen":        true,
-		"std.network.socket_accept":        true,
-		"std.network.socket_send":          true,
-		"std.network.socket_receive":       true,
-		"std.network.socket_close":         true,
-		"std.network.network_is_connected": true,
-		"std.network.network_get_local_ip": true,
-		"std.network.network_ping":         true,
+		"std.network.ip_parse":               true,
+		"std.network.ip_is_valid":            true,
+		"std.network.ip_is_private":          true,
+		"std.network.ip_is_loopback":         true,
+		"std.network.ip_to_string":           true,
+		"std.network.url_parse":              true,
+		"std.network.url_to_string":          true,
+		"std.network.url_is_valid":           true,
+		"std.network.dns_lookup":             true,
+		"std.network.dns_reverse_lookup":     true,
+		"std.network.http_get":               true,
+		"std.network.http_post":              true,
+		"std.network.http_put":               true,
+		"std.network.http_delete":            true,
+		"std.network.http_request":           true,
+		"std.network.socket_create":          true,
+		"std.network.socket_connect":         true,
+		"std.network.socket_bind":            true,
+		"std.network.socket_listen":          true,
+		"std.network.socket_accept":          true,
+		"std.network.socket_send":            true,
+		"std.network.socket_receive":         true,
+		"std.network.socket_close":           true,
+		"std.network.socket_set_nonblocking": true,
+		"std.network.socket_set_reuse_port":  true,
+		"std.network.socket_listen_shared":   true,
+		"std.network.socket_accept_async":    true,
+		"std.network.socket_receive_async":   true,
+		"std.network.socket_send_async":      true,
+		"std.network.network_is_connected":   true,
+		"std.network.network_get_local_ip":   true,
+		"std.network.network_ping":           true,
 	}
 
 	return runtimeFunctions[funcName]
@@ -4284,6 +4603,13 @@ func (g *CGenerator) isStringReturningFunction(funcName string) bool {
 		"omni_bool_to_string":  true,
 		"omni_read_file":       true,
 		"omni_await_string":    true,
+
+		"std.string.find_match":     true,
+		"std.string.replace_regex":  true,
+		"string.find_match":         true,
+		"string.replace_regex":      true,
+		"omni_string_find_match":    true,
+		"omni_string_replace_regex": true,
 	}
 	return stringReturningFunctions[funcName]
 }
@@ -4505,6 +4831,14 @@ func (g *CGenerator) writeMain() {
 
 	g.output.WriteString("int main(int argc, char** argv) {\n")
 	g.output.WriteString("    omni_args_init(argc, argv);\n")
+	if len(g.internOrder) > 0 {
+		g.output.WriteString("    omni_intern_keys();\n")
+	}
+	if len(g.regexOrder) > 0 {
+		g.output.WriteString("    omni_compile_regexes();\n")
+	}
+	g.output.WriteString(g.coverageRegistration())
+	g.output.WriteString(g.profileRegistration())
 
 	// Handle Promise return types (async main) - unwrap to inner type
 	if strings.HasPrefix(mainReturnType, "Promise<") {
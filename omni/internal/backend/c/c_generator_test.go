@@ -1336,6 +1336,7 @@ func TestCGenerator(t *testing.T) {
 			{"std.log.info", "\"info message\""},
 			{"std.log.warn", "\"warn message\""},
 			{"std.log.error", "\"error message\""},
+			{"std.log.set_mode", "\"async\""},
 		}
 
 		for _, tc := range logTests {
@@ -3506,8 +3507,8 @@ func TestCGenerator(t *testing.T) {
 		if !strings.Contains(result, "omni_struct_create") {
 			t.Error("Expected struct creation in generated code")
 		}
-		if !strings.Contains(result, "omni_struct_get_int_field") {
-			t.Error("Expected struct field access in generated code")
+		if !strings.Contains(result, "omni_struct_get_int_at(v1, 0, ") {
+			t.Error("Expected slot-based struct field access in generated code")
 		}
 	})
 
@@ -3639,8 +3640,8 @@ func TestCGenerator(t *testing.T) {
 			t.Fatalf("GenerateC failed: %v", err)
 		}
 
-		if !strings.Contains(result, "omni_promise_create_int") {
-			t.Error("Expected promise creation in async function")
+		if !strings.Contains(result, "omni_async_call(OMNI_PROMISE_INT, asyncFunc_async_task, NULL)") {
+			t.Error("Expected async function to be scheduled as a task")
 		}
 	})
 
@@ -3820,3 +3821,102 @@ func TestCGenerator(t *testing.T) {
 		}
 	})
 }
+
+func TestLinkedListRangeUsesCursor(t *testing.T) {
+	// func sum(list: linked_list<int>): int { var s = 0; for x in list { s = s + x }; return s }
+	cursor := mir.Operand{Kind: mir.OperandValue, Value: 2, Type: "linked_list_cursor"}
+	module := &mir.Module{
+		Functions: []*mir.Function{{
+			Name:       "sum",
+			ReturnType: "int",
+			Params:     []mir.Param{{Name: "list", Type: "linked_list<int>", ID: 0}},
+			Blocks: []*mir.BasicBlock{
+				{
+					Name: "entry",
+					Instructions: []mir.Instruction{
+						{ID: 1, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "0", Type: "int"}}},
+						{ID: 2, Op: "list.begin", Type: "linked_list_cursor", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 0, Type: "linked_list<int>"}}},
+					},
+					Terminator: mir.Terminator{Op: "br", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "header"}}},
+				},
+				{
+					Name:         "header",
+					Instructions: []mir.Instruction{{ID: 3, Op: "list.valid", Type: "bool", Operands: []mir.Operand{cursor}}},
+					Terminator: mir.Terminator{Op: "cbr", Operands: []mir.Operand{
+						{Kind: mir.OperandValue, Value: 3, Type: "bool"},
+						{Kind: mir.OperandLiteral, Literal: "body"},
+						{Kind: mir.OperandLiteral, Literal: "exit"},
+					}},
+				},
+				{
+					Name: "body",
+					Instructions: []mir.Instruction{
+						{ID: 4, Op: "list.value", Type: "int", Operands: []mir.Operand{cursor}},
+						{ID: 5, Op: "add", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 1, Type: "int"}, {Kind: mir.OperandValue, Value: 4, Type: "int"}}},
+						{ID: 6, Op: "assign", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 1, Type: "int"}, {Kind: mir.OperandValue, Value: 5, Type: "int"}}},
+						{ID: 7, Op: "list.next", Type: "void", Operands: []mir.Operand{cursor}},
+					},
+					Terminator: mir.Terminator{Op: "br", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "header"}}},
+				},
+				{
+					Name:       "exit",
+					Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 1, Type: "int"}}},
+				},
+			},
+		}},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+	for _, want := range []string{
+		"omni_linked_list_cursor_t v2;",
+		"v2 = omni_linked_list_begin(",
+		"v3 = omni_linked_list_cursor_valid(&v2);",
+		"v4 = omni_linked_list_cursor_value(&v2);",
+		"omni_linked_list_next(&v2);",
+	} {
+		if !strings.Contains(result, want) {
+			t.Errorf("expected %q in generated code:\n%s", want, result)
+		}
+	}
+	if strings.Contains(result, "omni_linked_list_get") {
+		t.Error("range over a linked list should not index it")
+	}
+}
+
+func TestSetInPlaceOperationsMapToRuntime(t *testing.T) {
+	generator := NewCGenerator(&mir.Module{})
+	for name, want := range map[string]string{
+		"std.collections.set_union_with":      "omni_set_union_with",
+		"std.collections.set_intersect_with":  "omni_set_intersect_with",
+		"std.collections.set_difference_with": "omni_set_difference_with",
+	} {
+		if got := generator.mapFunctionName(name); got != want {
+			t.Errorf("mapFunctionName(%q) = %q, want %q", name, got, want)
+		}
+		if !generator.isRuntimeProvidedFunction(name) {
+			t.Errorf("%s should be provided by the runtime", name)
+		}
+	}
+}
+
+func TestParallelAlgorithmsMapToRuntime(t *testing.T) {
+	generator := NewCGenerator(&mir.Module{})
+	for name, want := range map[string]string{
+		"std.algorithms.parallel_sort":         "omni_parallel_sort_int",
+		"std.algorithms.parallel_sort_strings": "omni_parallel_sort_string",
+		"std.algorithms.parallel_sum":          "omni_parallel_sum_int",
+		"std.algorithms.parallel_min":          "omni_parallel_min_int",
+		"std.algorithms.parallel_max":          "omni_parallel_max_int",
+		"std.collections.map_from_arrays":      "omni_parallel_build_map_int",
+	} {
+		if got := generator.mapFunctionName(name); got != want {
+			t.Errorf("mapFunctionName(%q) = %q, want %q", name, got, want)
+		}
+		if !generator.isRuntimeProvidedFunction(name) {
+			t.Errorf("%s should be provided by the runtime", name)
+		}
+	}
+}
@@ -0,0 +1,79 @@
+package cbackend
+
+import (
+	"fmt"
+	"strings"
+)
+
+// Compiled-in coverage counters.
+//
+// With coverage enabled every instrumented site gets a numeric id when the
+// code is generated: one per function (counted on entry) and one per std
+// function the module calls (counted at each call). The ids index a static
+// counter array, so a hit is a single relaxed atomic increment; the site
+// names live in a static descriptor table that main registers with the
+// runtime, which writes the JSON export when the program exits.
+
+const (
+	coverageCounters = "omni_coverage_counters"
+	coverageSites    = "omni_coverage_sites"
+)
+
+// coverageSite describes one instrumented site.
+type coverageSite struct {
+	function string
+	line     int
+}
+
+// EnableCoverage instruments the generated program. Sites are attributed
+// to sourceFile.
+func (g *CGenerator) EnableCoverage(sourceFile string) {
+	g.coverage = true
+	g.coverageFile = sourceFile
+	g.coverageIDs = make(map[string]int)
+}
+
+// coverageSiteID returns the id of the site for function, registering it on
+// first use.
+func (g *CGenerator) coverageSiteID(function string) int {
+	if id, ok := g.coverageIDs[function]; ok {
+		return id
+	}
+	id := len(g.coverageSites)
+	g.coverageIDs[function] = id
+	g.coverageSites = append(g.coverageSites, coverageSite{function: function})
+	return id
+}
+
+// emitCoverageHit counts one hit of the site for function.
+func (g *CGenerator) emitCoverageHit(function string) {
+	if !g.coverage {
+		return
+	}
+	g.output.WriteString(fmt.Sprintf("  OMNI_COVERAGE_HIT(%s, %d);\n", coverageCounters, g.coverageSiteID(function)))
+}
+
+// coverageDefinitions returns the counter array and site table, or "" when
+// coverage is off or nothing was instrumented.
+func (g *CGenerator) coverageDefinitions() string {
+	if !g.coverage || len(g.coverageSites) == 0 {
+		return ""
+	}
+	var b strings.Builder
+	b.WriteString(fmt.Sprintf("\nstatic uint64_t %s[%d];\n", coverageCounters, len(g.coverageSites)))
+	b.WriteString(fmt.Sprintf("static const omni_coverage_site_t %s[%d] = {\n", coverageSites, len(g.coverageSites)))
+	for _, site := range g.coverageSites {
+		b.WriteString(fmt.Sprintf("  {%q, %q, %d},\n", site.function, g.coverageFile, site.line))
+	}
+	b.WriteString("};\n")
+	return b.String()
+}
+
+// coverageRegistration returns the call registering the site table from
+// main, or "" when there is none.
+func (g *CGenerator) coverageRegistration() string {
+	if !g.coverage || len(g.coverageSites) == 0 {
+		return ""
+	}
+	return fmt.Sprintf("    omni_coverage_register(%s, %s, %d);\n", coverageSites, coverageCounters, len(g.coverageSites))
+}
@@ -0,0 +1,94 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+func TestCoverageSiteTable(t *testing.T) {
+	// func helper() { println("a"); println("b") }; func main() int { helper(); return 0 }
+	println := func(id mir.ValueID) mir.Instruction {
+		return mir.Instruction{ID: id, Op: "call.void", Type: "void", Operands: []mir.Operand{
+			{Kind: mir.OperandLiteral, Literal: "std.io.println"},
+			{Kind: mir.OperandLiteral, Literal: "\"a\"", Type: "string"},
+		}}
+	}
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "helper",
+				ReturnType: "void",
+				Blocks: []*mir.BasicBlock{{
+					Name:         "entry",
+					Instructions: []mir.Instruction{println(1), println(2)},
+					Terminator:   mir.Terminator{Op: "ret"},
+				}},
+			},
+			{
+				Name:       "main",
+				ReturnType: "int",
+				Blocks: []*mir.BasicBlock{{
+					Name: "entry",
+					Instructions: []mir.Instruction{
+						{ID: 3, Op: "call.void", Type: "void", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "helper"}}},
+						{ID: 4, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "0", Type: "int"}}},
+					},
+					Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 4, Type: "int"}}},
+				}},
+			},
+		},
+	}
+
+	gen := NewCGenerator(module)
+	gen.EnableCoverage("app.omni")
+	result, err := gen.Generate()
+	if err != nil {
+		t.Fatalf("Generate failed: %v", err)
+	}
+
+	expected := []string{
+		"static uint64_t omni_coverage_counters[3];",
+		"static const omni_coverage_site_t omni_coverage_sites[3] = {",
+		"{\"helper\", \"app.omni\", 0},",
+		"{\"std.io.println\", \"app.omni\", 0},",
+		"{\"main\", \"app.omni\", 0},",
+		"omni_coverage_register(omni_coverage_sites, omni_coverage_counters, 3);",
+	}
+	for _, want := range expected {
+		if !strings.Contains(result, want) {
+			t.Errorf("expected %q in generated code:\n%s", want, result)
+		}
+	}
+	// Both println calls count into the same site
+	if n := strings.Count(result, "OMNI_COVERAGE_HIT(omni_coverage_counters, 1);"); n != 2 {
+		t.Errorf("expected 2 hits of the println site, got %d", n)
+	}
+	if strings.Index(result, "omni_coverage_counters[3]") > strings.Index(result, "OMNI_COVERAGE_HIT") {
+		t.Error("coverage tables must be defined before the functions using them")
+	}
+}
+
+func TestCoverageDisabledByDefault(t *testing.T) {
+	module := &mir.Module{
+		Functions: []*mir.Function{{
+			Name:       "main",
+			ReturnType: "int",
+			Blocks: []*mir.BasicBlock{{
+				Name: "entry",
+				Instructions: []mir.Instruction{
+					{ID: 1, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "0", Type: "int"}}},
+				},
+				Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 1, Type: "int"}}},
+			}},
+		}},
+	}
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+	if strings.Contains(result, "omni_coverage") || strings.Contains(result, "OMNI_COVERAGE_HIT") {
+		t.Errorf("coverage code generated without coverage enabled:\n%s", result)
+	}
+}
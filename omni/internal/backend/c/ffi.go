@@ -5,7 +5,7 @@ package cbackend
 
 /*
 #cgo CFLAGS: -I${SRCDIR}/../../../runtime
-#cgo linux  LDFLAGS: -lm
+#cgo linux  LDFLAGS: -lm -pthread
 #cgo darwin LDFLAGS: -lm
 #include <stdlib.h>
 #include "omni_rt.h"
@@ -0,0 +1,72 @@
+package cbackend
+
+import (
+	"fmt"
+	"strings"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// Compile-time interning of map keys and struct field names.
+//
+// Struct field names live in the runtime's intern pool, and maps store a key
+// whose contents are interned as the pool's pointer, so an interned key is
+// found by pointer and its hash is never recomputed. Every constant key and
+// field name of the module becomes a global omni_key_<n> that main interns
+// once at startup; the generated code passes that pointer instead of the
+// literal. Keys computed at run time are never interned: maps copy and free
+// them.
+
+// internKey returns the global holding the interned form of C string literal
+// lit, registering it on first use.
+func (g *CGenerator) internKey(lit string) string {
+	if name, ok := g.internedKeys[lit]; ok {
+		return name
+	}
+	name := fmt.Sprintf("omni_key_%d", len(g.internOrder))
+	g.internedKeys[lit] = name
+	g.internOrder = append(g.internOrder, lit)
+	return name
+}
+
+// fieldKey returns the interned global for struct field name.
+func (g *CGenerator) fieldKey(name string) string {
+	return g.internKey(fmt.Sprintf("%q", name))
+}
+
+// mapKey returns the C expression for map key op, using the interned global
+// when op is a string constant.
+func (g *CGenerator) mapKey(op mir.Operand, keyType string) string {
+	if keyType == "string" {
+		switch op.Kind {
+		case mir.OperandLiteral:
+			if strings.HasPrefix(op.Literal, "\"") && strings.HasSuffix(op.Literal, "\"") {
+				return g.internKey(op.Literal)
+			}
+		case mir.OperandValue:
+			if lit, ok := g.constStrings[op.Value]; ok {
+				return g.internKey(lit)
+			}
+		}
+	}
+	return g.getOperandValue(op)
+}
+
+// internKeyDefinitions returns the interned-key globals and the function
+// initializing them, or "" if the module has no constant keys.
+func (g *CGenerator) internKeyDefinitions() string {
+	if len(g.internOrder) == 0 {
+		return ""
+	}
+	var b strings.Builder
+	b.WriteString("\n")
+	for _, lit := range g.internOrder {
+		b.WriteString(fmt.Sprintf("static const char* %s;\n", g.internedKeys[lit]))
+	}
+	b.WriteString("\nstatic void omni_intern_keys(void) {\n")
+	for _, lit := range g.internOrder {
+		b.WriteString(fmt.Sprintf("  %s = omni_intern_len(%s, sizeof(%s) - 1);\n", g.internedKeys[lit], lit, lit))
+	}
+	b.WriteString("}\n")
+	return b.String()
+}
@@ -0,0 +1,77 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+func TestInternedKeysAndFieldNames(t *testing.T) {
+	// p := Point{x: 1}; p.x; m := {"a": 1}; m["a"]
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "main",
+				ReturnType: "int",
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Instructions: []mir.Instruction{
+							{ID: 1, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "1", Type: "int"}}},
+							{ID: 2, Op: "struct.init", Type: "Point", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "x"},
+								{Kind: mir.OperandValue, Value: 1, Type: "int"},
+							}},
+							{ID: 3, Op: "member", Type: "int", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 2, Type: "Point"},
+								{Kind: mir.OperandLiteral, Literal: "x"},
+							}},
+							{ID: 4, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"a\"", Type: "string"}}},
+							{ID: 5, Op: "map.init", Type: "map<string,int>", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 4, Type: "string"},
+								{Kind: mir.OperandValue, Value: 1, Type: "int"},
+							}},
+							{ID: 6, Op: "index", Type: "int", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 5, Type: "map<string,int>"},
+								{Kind: mir.OperandValue, Value: 4, Type: "string"},
+							}},
+						},
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 6, Type: "int"}},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	expected := []string{
+		"static const char* omni_key_0;",
+		"static const char* omni_key_1;",
+		"omni_key_0 = omni_intern_len(\"x\", sizeof(\"x\") - 1);",
+		"omni_key_1 = omni_intern_len(\"a\", sizeof(\"a\") - 1);",
+		"omni_struct_set_int_field(v2, omni_key_0, v1);",
+		"omni_struct_get_int_at(v2, 0, omni_key_0);",
+		"omni_map_put_string_int(v5, omni_key_1, v1);",
+		"omni_map_get_string_int(v5, omni_key_1);",
+	}
+	for _, want := range expected {
+		if !strings.Contains(result, want) {
+			t.Errorf("expected %q in generated code:\n%s", want, result)
+		}
+	}
+	if strings.Count(result, "omni_intern_len(\"x\"") != 1 {
+		t.Error("each key should be interned once")
+	}
+	keys := strings.Index(result, "omni_intern_keys();")
+	if keys < 0 || keys < strings.Index(result, "int main(") {
+		t.Error("expected main to intern the keys on startup")
+	}
+}
@@ -0,0 +1,303 @@
+package cbackend
+
+import (
+	"fmt"
+	"strings"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// Length-aware string lowering.
+//
+// Strings allocated by the runtime are omni_strs whose byte length sits in a
+// header in front of the data (omni_str_len is O(1)), and string constants
+// have a length the C compiler knows (sizeof). For values of either kind the
+// generator passes lengths explicitly to the runtime's *_len fast paths
+// instead of letting every call rescan the bytes.
+//
+// A value that is reassigned qualifies only if everything assigned to it is
+// an omni_str as well: a plain string has no header in front of it. A local
+// that holds an omni_str on some paths and another string on others is made
+// an omni_str on all of them instead: its definition and every other value
+// stored into it are copied into omni_strs (omniStrCopies), so the cleanup
+// releases it with omni_str_free whichever path ran. A value assigned to
+// another without a copy is released through that one (stringMoves).
+
+// planStringLengths records which string values of fn are omni_strs. It must
+// run after planStrcatFusion, whose constStrings it relies on.
+func (g *CGenerator) planStringLengths(fn *mir.Function) {
+	g.omniStrs = make(map[mir.ValueID]bool)
+	g.omniStrCopies = make(map[mir.ValueID]bool)
+	g.stringMoves = make(map[mir.ValueID][]mir.ValueID)
+	g.assignTargets = make(map[mir.ValueID]mir.ValueID)
+
+	userFuncs := make(map[string]bool)
+	if g.module != nil {
+		for _, f := range g.module.Functions {
+			userFuncs[f.Name] = true
+		}
+	}
+
+	var assigns []*mir.Instruction
+	defined := make(map[mir.ValueID]bool)
+	for _, block := range fn.Blocks {
+		for i := range block.Instructions {
+			inst := &block.Instructions[i]
+			if inst.Op == "assign" && len(inst.Operands) == 2 && inst.Operands[0].Kind == mir.OperandValue {
+				assigns = append(assigns, inst)
+				if inst.ID != mir.InvalidValue {
+					g.assignTargets[inst.ID] = inst.Operands[0].Value
+				}
+				continue
+			}
+			if inst.ID == mir.InvalidValue || g.fusedStrcats[inst.ID] {
+				continue
+			}
+			defined[inst.ID] = true
+			if inst.Op == "strcat" {
+				g.omniStrs[inst.ID] = true
+				continue
+			}
+			if !isCallOp(inst.Op) || inst.Type != "string" || len(inst.Operands) == 0 {
+				continue
+			}
+			callee := inst.Operands[0]
+			if callee.Kind != mir.OperandLiteral || userFuncs[callee.Literal] {
+				continue
+			}
+			// The allocating string functions are exactly those with arena
+			// variants, and all of them return omni_strs
+			if _, ok := arenaStringFunctions[g.mapFunctionName(callee.Literal)]; ok {
+				g.omniStrs[inst.ID] = true
+			}
+			// Received socket data is lowered to omni_socket_receive_string
+			if g.mapFunctionName(callee.Literal) == "omni_socket_receive" {
+				g.omniStrs[inst.ID] = true
+			}
+		}
+	}
+
+	// Values are tracked per variable: later assigns name their target by
+	// the value of an earlier assign
+	source := func(inst *mir.Instruction) (mir.ValueID, bool) {
+		op := inst.Operands[1]
+		return g.variableOf(op.Value), op.Kind == mir.OperandValue
+	}
+
+	// Targets assigned an omni_str somewhere may hold one at cleanup
+	mayBeOmniStr := make(map[mir.ValueID]bool, len(g.omniStrs))
+	producesOmniStr := make(map[mir.ValueID]bool, len(g.omniStrs))
+	for id := range g.omniStrs {
+		mayBeOmniStr[id] = true
+		producesOmniStr[id] = true
+	}
+	for changed := true; changed; {
+		changed = false
+		for _, inst := range assigns {
+			target := g.variableOf(inst.Operands[0].Value)
+			if from, ok := source(inst); ok && !mayBeOmniStr[target] && mayBeOmniStr[from] {
+				mayBeOmniStr[target] = true
+				changed = true
+			}
+		}
+	}
+	// Drop targets that are assigned anything but an omni_str until none
+	// change; values assigned each other in a loop keep their mark together
+	for changed := true; changed; {
+		changed = false
+		for _, inst := range assigns {
+			target := g.variableOf(inst.Operands[0].Value)
+			if from, ok := source(inst); g.omniStrs[target] && (!ok || !g.omniStrs[from]) {
+				delete(g.omniStrs, target)
+				changed = true
+			}
+		}
+	}
+	// Make the remaining targets omni_strs by copying what they are defined
+	// as where it is something else. Parameters are never released, so they
+	// keep whatever they are given.
+	for id := range mayBeOmniStr {
+		if !g.omniStrs[id] && defined[id] {
+			g.omniStrs[id] = true
+			if !producesOmniStr[id] {
+				g.omniStrCopies[id] = true
+				// The literal is only the first of its values
+				delete(g.constStrings, id)
+			}
+		}
+	}
+	for _, inst := range assigns {
+		target := g.variableOf(inst.Operands[0].Value)
+		from, ok := source(inst)
+		if g.omniStrs[target] && (!ok || !g.omniStrs[from]) {
+			g.omniStrCopies[inst.ID] = true
+		} else if ok {
+			g.stringMoves[from] = append(g.stringMoves[from], target)
+		}
+	}
+	for _, inst := range assigns {
+		if inst.ID != mir.InvalidValue && g.omniStrs[g.variableOf(inst.ID)] {
+			g.omniStrs[inst.ID] = true
+		}
+	}
+}
+
+// variableOf returns the value defining the variable that value id holds:
+// an assign's value stands for its target.
+func (g *CGenerator) variableOf(id mir.ValueID) mir.ValueID {
+	for {
+		target, ok := g.assignTargets[id]
+		if !ok {
+			return id
+		}
+		id = target
+	}
+}
+
+// knownLength returns a C expression for the byte length of string operand
+// op, if it can be had without scanning.
+func (g *CGenerator) knownLength(op mir.Operand) (string, bool) {
+	switch op.Kind {
+	case mir.OperandValue:
+		if g.omniStrs[op.Value] {
+			return fmt.Sprintf("omni_str_len(%s)", g.getVariableName(op.Value)), true
+		}
+		if lit, ok := g.constStrings[op.Value]; ok {
+			return fmt.Sprintf("(sizeof(%s) - 1)", lit), true
+		}
+	}
+	return "", false
+}
+
+// stringEqualsExpr returns the C expression comparing strings a and b for
+// equality, using lengths (and cached hashes) when they are known.
+func (g *CGenerator) stringEqualsExpr(a, b mir.Operand) string {
+	left := g.getOperandValue(a)
+	right := g.getOperandValue(b)
+	if a.Kind == mir.OperandValue && b.Kind == mir.OperandValue && g.omniStrs[a.Value] && g.omniStrs[b.Value] {
+		return fmt.Sprintf("omni_str_equals(%s, %s)", left, right)
+	}
+	leftLen, okLeft := g.knownLength(a)
+	rightLen, okRight := g.knownLength(b)
+	if okLeft && okRight {
+		return fmt.Sprintf("omni_string_equals_len(%s, %s, %s, %s)", left, leftLen, right, rightLen)
+	}
+	return fmt.Sprintf("omni_string_equals(%s, %s)", left, right)
+}
+
+// lengthAwareCall returns the fast-path C expression for a call to runtime
+// string function cFuncName when the lengths of its string arguments are
+// known. ok is false if the regular call should be emitted.
+func (g *CGenerator) lengthAwareCall(cFuncName string, inst *mir.Instruction) (expr string, ok bool) {
+	args := inst.Operands[1:]
+	arena := "NULL"
+	if g.arenaValues[inst.ID] {
+		arena = arenaVar
+	}
+
+	switch cFuncName {
+	case "omni_strlen":
+		if len(args) == 1 {
+			if n, known := g.knownLength(args[0]); known {
+				return fmt.Sprintf("(int32_t)%s", n), true
+			}
+		}
+	case "omni_char_at":
+		if len(args) == 2 {
+			if n, known := g.knownLength(args[0]); known {
+				return fmt.Sprintf("omni_char_at_len(%s, %s, %s)", g.getOperandValue(args[0]), n, g.getOperandValue(args[1])), true
+			}
+		}
+	case "omni_substring":
+		if len(args) == 3 {
+			if n, known := g.knownLength(args[0]); known {
+				return fmt.Sprintf("omni_substring_len(%s, %s, %s, %s, %s)", arena,
+					g.getOperandValue(args[0]), n, g.getOperandValue(args[1]), g.getOperandValue(args[2])), true
+			}
+		}
+	case "omni_strcat", "omni_starts_with", "omni_ends_with", "omni_contains", "omni_index_of":
+		if len(args) == 2 {
+			n0, known0 := g.knownLength(args[0])
+			n1, known1 := g.knownLength(args[1])
+			if !known0 || !known1 {
+				return "", false
+			}
+			a0, a1 := g.getOperandValue(args[0]), g.getOperandValue(args[1])
+			if cFuncName == "omni_strcat" {
+				return fmt.Sprintf("omni_strcat_len(%s, %s, %s, %s, %s)", arena, a0, n0, a1, n1), true
+			}
+			return fmt.Sprintf("%s_len(%s, %s, %s, %s)", cFuncName, a0, n0, a1, n1), true
+		}
+	case "omni_socket_send":
+		if len(args) == 2 {
+			if n, known := g.knownLength(args[1]); known {
+				return fmt.Sprintf("(int32_t)omni_socket_send_bytes(%s, %s, (int64_t)%s)",
+					g.getOperandValue(args[0]), g.getOperandValue(args[1]), n), true
+			}
+		}
+	case "omni_string_equals":
+		if len(args) == 2 {
+			if _, known0 := g.knownLength(args[0]); known0 {
+				if _, known1 := g.knownLength(args[1]); known1 {
+					return g.stringEqualsExpr(args[0], args[1]), true
+				}
+			}
+		}
+	}
+	return "", false
+}
+
+// releasedElsewhere reports whether string id was assigned to a variable
+// that the cleanup releases or that is returned, which then owns it.
+func (g *CGenerator) releasedElsewhere(id mir.ValueID) bool {
+	for _, target := range g.stringMoves[id] {
+		if g.stringsToFree[target] || target == g.variableOf(g.returnedValueID) {
+			return true
+		}
+	}
+	return false
+}
+
+// omniStrCopyExpr returns a C expression for a new heap omni_str holding
+// the value of string operand op, which is not an omni_str itself.
+func (g *CGenerator) omniStrCopyExpr(op mir.Operand) string {
+	value := g.getOperandValue(op)
+	if n, known := g.knownLength(op); known {
+		return fmt.Sprintf("omni_str_new(NULL, %s, %s)", value, n)
+	}
+	return fmt.Sprintf("%s ? omni_str_new(NULL, %s, strlen(%s)) : NULL", value, value, value)
+}
+
+// copyDefinitionToOmniStr replaces the string inst has just defined with an
+// omni_str copy (see omniStrCopies), releasing the original if the
+// generator allocated it. The copy is released by the cleanup.
+func (g *CGenerator) copyDefinitionToOmniStr(inst *mir.Instruction) {
+	varName := g.getVariableName(inst.ID)
+	if inst.Op == "const" && len(inst.Operands) > 0 {
+		// String constants are set at declaration, so this also resets the
+		// variable each time the definition runs
+		if lit := g.getOperandValue(inst.Operands[0]); strings.HasPrefix(lit, "\"") {
+			g.output.WriteString(fmt.Sprintf("  %s = omni_str_new(NULL, %s, sizeof(%s) - 1);\n", varName, lit, lit))
+			g.stringsToFree[inst.ID] = true
+			return
+		}
+	}
+	if g.stringsToFree[inst.ID] {
+		plain := fmt.Sprintf("_plain_%d", inst.ID)
+		g.output.WriteString(fmt.Sprintf("  const char* %s = %s;\n", plain, varName))
+		g.output.WriteString(fmt.Sprintf("  %s = %s ? omni_str_new(NULL, %s, strlen(%s)) : NULL;\n", varName, plain, plain, plain))
+		g.output.WriteString(fmt.Sprintf("  free((void*)%s);\n", plain))
+	} else {
+		g.output.WriteString(fmt.Sprintf("  %s = %s ? omni_str_new(NULL, %s, strlen(%s)) : NULL;\n", varName, varName, varName, varName))
+	}
+	g.stringsToFree[inst.ID] = true
+}
+
+// stringFreeCall returns the call releasing heap string name: omni_strs go
+// back through omni_str_free, other runtime strings are plain malloc blocks.
+func stringFreeCall(name string, omniStr bool) string {
+	if omniStr {
+		return fmt.Sprintf("omni_str_free(%s)", name)
+	}
+	return fmt.Sprintf("free((void*)%s)", name)
+}
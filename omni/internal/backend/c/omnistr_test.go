@@ -0,0 +1,215 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+func TestLengthAwareStringCalls(t *testing.T) {
+	// s := std.string.to_upper(name); len(s); s == "BOB"; ends_with(name, "b");
+	// contains(s, "O")
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "check",
+				ReturnType: "int",
+				Params:     []mir.Param{{Name: "name", Type: "string", ID: 0}},
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Instructions: []mir.Instruction{
+							{ID: 1, Op: "call", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.to_upper"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+							}},
+							{ID: 2, Op: "call", Type: "int", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.length"},
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+							}},
+							{ID: 3, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"BOB\"", Type: "string"}}},
+							{ID: 4, Op: "cmp.eq", Type: "bool", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+								{Kind: mir.OperandValue, Value: 3, Type: "string"},
+							}},
+							{ID: 5, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"b\"", Type: "string"}}},
+							{ID: 6, Op: "call", Type: "bool", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.ends_with"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+								{Kind: mir.OperandValue, Value: 5, Type: "string"},
+							}},
+							{ID: 7, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"O\"", Type: "string"}}},
+							{ID: 8, Op: "call", Type: "bool", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.contains"},
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+								{Kind: mir.OperandValue, Value: 7, Type: "string"},
+							}},
+						},
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 2, Type: "int"}},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	if !strings.Contains(result, "v2 = (int32_t)omni_str_len(v1);") {
+		t.Errorf("expected O(1) length of a runtime string:\n%s", result)
+	}
+	if !strings.Contains(result, "omni_string_equals_len(v1, omni_str_len(v1), v3, (sizeof(\"BOB\") - 1))") {
+		t.Errorf("expected length-aware equality against a constant:\n%s", result)
+	}
+	if !strings.Contains(result, "omni_contains_len(v1, omni_str_len(v1), v7, (sizeof(\"O\") - 1))") {
+		t.Errorf("expected length-aware contains:\n%s", result)
+	}
+	// The parameter's length is unknown, so the regular call stays
+	if !strings.Contains(result, "omni_ends_with(name, v5)") {
+		t.Errorf("expected plain ends_with for a string of unknown length:\n%s", result)
+	}
+}
+
+func TestSocketDataKeepsLength(t *testing.T) {
+	// data := std.network.socket_receive(sock, 64); std.network.socket_send(sock, data)
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "echo",
+				ReturnType: "int",
+				Params:     []mir.Param{{Name: "sock", Type: "int", ID: 0}},
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Instructions: []mir.Instruction{
+							{ID: 1, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "64", Type: "int"}}},
+							{ID: 2, Op: "call", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.network.socket_receive"},
+								{Kind: mir.OperandValue, Value: 0, Type: "int"},
+								{Kind: mir.OperandValue, Value: 1, Type: "int"},
+							}},
+							{ID: 3, Op: "call", Type: "int", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.network.socket_send"},
+								{Kind: mir.OperandValue, Value: 0, Type: "int"},
+								{Kind: mir.OperandValue, Value: 2, Type: "string"},
+							}},
+						},
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 3, Type: "int"}},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	if !strings.Contains(result, "v2 = omni_socket_receive_string(sock, v1);") {
+		t.Errorf("expected received data as an omni_str:\n%s", result)
+	}
+	if !strings.Contains(result, "omni_socket_send_bytes(sock, v2, (int64_t)omni_str_len(v2))") {
+		t.Errorf("expected a length-aware send of received data:\n%s", result)
+	}
+}
+
+func TestReassignedStringsKeepTheirKind(t *testing.T) {
+	// s := std.string.to_upper(name); s = s + "x"; len(s)
+	// u := std.string.to_upper(name); u = name
+	// w := "w"; w = std.string.to_upper(name)
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "grow",
+				ReturnType: "int",
+				Params:     []mir.Param{{Name: "name", Type: "string", ID: 0}},
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Instructions: []mir.Instruction{
+							{ID: 1, Op: "call", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.to_upper"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+							}},
+							{ID: 2, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"x\"", Type: "string"}}},
+							{ID: 3, Op: "strcat", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+								{Kind: mir.OperandValue, Value: 2, Type: "string"},
+							}},
+							{ID: 4, Op: "assign", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+								{Kind: mir.OperandValue, Value: 3, Type: "string"},
+							}},
+							{ID: 5, Op: "call", Type: "int", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.length"},
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+							}},
+							{ID: 6, Op: "call", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.to_upper"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+							}},
+							{ID: 7, Op: "assign", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 6, Type: "string"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+							}},
+							{ID: 8, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"w\"", Type: "string"}}},
+							{ID: 9, Op: "call", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.to_upper"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+							}},
+							{ID: 10, Op: "assign", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandValue, Value: 8, Type: "string"},
+								{Kind: mir.OperandValue, Value: 9, Type: "string"},
+							}},
+						},
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 5, Type: "int"}},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	// Only omni_strs are ever assigned to v1, so it is still one
+	if !strings.Contains(result, "v5 = (int32_t)omni_str_len(v1);") {
+		t.Errorf("expected O(1) length of a reassigned omni_str:\n%s", result)
+	}
+	if !strings.Contains(result, "omni_str_free(v1)") || strings.Contains(result, "free((void*)v1)") {
+		t.Errorf("expected the reassigned omni_str released with omni_str_free:\n%s", result)
+	}
+	// v3 now belongs to v1 and must not be released twice
+	if strings.Contains(result, "omni_str_free(v3)") {
+		t.Errorf("expected the assigned string released only through its variable:\n%s", result)
+	}
+	// The parameter stored into v6 is copied, so v6 is always an omni_str
+	if !strings.Contains(result, "v6 = name ? omni_str_new(NULL, name, strlen(name)) : NULL;") {
+		t.Errorf("expected a plain string stored into an omni_str variable to be copied:\n%s", result)
+	}
+	if !strings.Contains(result, "omni_str_free(v6)") || strings.Contains(result, "free((void*)v6)") {
+		t.Errorf("expected the variable released with omni_str_free:\n%s", result)
+	}
+	// v8 starts out as a literal, which is copied where it is defined
+	if !strings.Contains(result, `v8 = omni_str_new(NULL, "w", sizeof("w") - 1);`) {
+		t.Errorf("expected the literal definition copied into an omni_str:\n%s", result)
+	}
+	if !strings.Contains(result, "omni_str_free(v8)") || strings.Contains(result, "omni_str_free(v9)") {
+		t.Errorf("expected the variable, not the value moved into it, released:\n%s", result)
+	}
+}
@@ -0,0 +1,79 @@
+package cbackend
+
+import (
+	"fmt"
+	"strings"
+)
+
+// Function-level profiling.
+//
+// With profiling enabled every generated function calls omni_prof_enter on
+// entry and omni_prof_exit before each return, passing the function's site
+// id. Like coverage sites, the ids are assigned while generating and index a
+// static site table that main registers with the runtime; the runtime keeps
+// the timings and allocation counts per thread and writes them on exit.
+
+const profileSites = "omni_prof_sites"
+
+// EnableProfiling instruments the generated program with entry/exit hooks.
+// Sites are attributed to sourceFile.
+func (g *CGenerator) EnableProfiling(sourceFile string) {
+	g.profile = true
+	g.profileFile = sourceFile
+	g.profileIDs = make(map[string]int)
+}
+
+// profileSiteID returns the id of the site for function, registering it on
+// first use.
+func (g *CGenerator) profileSiteID(function string) int {
+	if id, ok := g.profileIDs[function]; ok {
+		return id
+	}
+	id := len(g.profileFunctions)
+	g.profileIDs[function] = id
+	g.profileFunctions = append(g.profileFunctions, function)
+	return id
+}
+
+// emitProfileEnter opens the profiled frame of function and makes it the
+// frame closed by emitProfileExit.
+func (g *CGenerator) emitProfileEnter(function string) {
+	if !g.profile {
+		return
+	}
+	g.profileSite = g.profileSiteID(function)
+	g.output.WriteString(fmt.Sprintf("  omni_prof_enter(%d);\n", g.profileSite))
+}
+
+// emitProfileExit closes the frame of the function being generated; it is
+// emitted before every return.
+func (g *CGenerator) emitProfileExit() {
+	if !g.profile {
+		return
+	}
+	g.output.WriteString(fmt.Sprintf("  omni_prof_exit(%d);\n", g.profileSite))
+}
+
+// profileDefinitions returns the site table, or "" when profiling is off or
+// nothing was instrumented.
+func (g *CGenerator) profileDefinitions() string {
+	if !g.profile || len(g.profileFunctions) == 0 {
+		return ""
+	}
+	var b strings.Builder
+	b.WriteString(fmt.Sprintf("\nstatic const omni_prof_site_t %s[%d] = {\n", profileSites, len(g.profileFunctions)))
+	for _, function := range g.profileFunctions {
+		b.WriteString(fmt.Sprintf("  {%q, %q},\n", function, g.profileFile))
+	}
+	b.WriteString("};\n")
+	return b.String()
+}
+
+// profileRegistration returns the call registering the site table from
+// main, or "" when there is none.
+func (g *CGenerator) profileRegistration() string {
+	if !g.profile || len(g.profileFunctions) == 0 {
+		return ""
+	}
+	return fmt.Sprintf("    omni_prof_register(%s, %d);\n", profileSites, len(g.profileFunctions))
+}
@@ -0,0 +1,108 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+func TestProfileHooks(t *testing.T) {
+	// func pick(x int) int { if x { return 1 } return 2 }; func main() int { return pick(1) }
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "pick",
+				ReturnType: "int",
+				Params:     []mir.Param{{Name: "x", Type: "int"}},
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Terminator: mir.Terminator{Op: "cbr", Operands: []mir.Operand{
+							{Kind: mir.OperandLiteral, Literal: "x"},
+							{Kind: mir.OperandLiteral, Literal: "one"},
+							{Kind: mir.OperandLiteral, Literal: "two"},
+						}},
+					},
+					{
+						Name:       "one",
+						Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "1", Type: "int"}}},
+					},
+					{
+						Name:       "two",
+						Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "2", Type: "int"}}},
+					},
+				},
+			},
+			{
+				Name:       "main",
+				ReturnType: "int",
+				Blocks: []*mir.BasicBlock{{
+					Name: "entry",
+					Instructions: []mir.Instruction{
+						{ID: 1, Op: "call", Type: "int", Operands: []mir.Operand{
+							{Kind: mir.OperandLiteral, Literal: "pick"},
+							{Kind: mir.OperandLiteral, Literal: "1", Type: "int"},
+						}},
+					},
+					Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 1, Type: "int"}}},
+				}},
+			},
+		},
+	}
+
+	gen := NewCGenerator(module)
+	gen.EnableProfiling("app.omni")
+	result, err := gen.Generate()
+	if err != nil {
+		t.Fatalf("Generate failed: %v", err)
+	}
+
+	expected := []string{
+		"static const omni_prof_site_t omni_prof_sites[2] = {",
+		"{\"pick\", \"app.omni\"},",
+		"{\"main\", \"app.omni\"},",
+		"omni_prof_register(omni_prof_sites, 2);",
+	}
+	for _, want := range expected {
+		if !strings.Contains(result, want) {
+			t.Errorf("expected %q in generated code:\n%s", want, result)
+		}
+	}
+	if n := strings.Count(result, "omni_prof_enter(0);"); n != 1 {
+		t.Errorf("expected 1 entry hook for pick, got %d", n)
+	}
+	// Both returns of pick close its frame
+	if n := strings.Count(result, "omni_prof_exit(0);"); n != 2 {
+		t.Errorf("expected 2 exit hooks for pick, got %d", n)
+	}
+	if n := strings.Count(result, "omni_prof_exit(1);"); n != 1 {
+		t.Errorf("expected 1 exit hook for main, got %d", n)
+	}
+	if strings.Index(result, "omni_prof_sites[2]") > strings.Index(result, "omni_prof_enter") {
+		t.Error("the site table must be defined before the functions using it")
+	}
+}
+
+func TestProfileDisabledByDefault(t *testing.T) {
+	module := &mir.Module{
+		Functions: []*mir.Function{{
+			Name:       "main",
+			ReturnType: "int",
+			Blocks: []*mir.BasicBlock{{
+				Name: "entry",
+				Instructions: []mir.Instruction{
+					{ID: 1, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "0", Type: "int"}}},
+				},
+				Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 1, Type: "int"}}},
+			}},
+		}},
+	}
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+	if strings.Contains(result, "omni_prof") {
+		t.Errorf("profiling code generated without profiling enabled:\n%s", result)
+	}
+}
@@ -0,0 +1,91 @@
+package cbackend
+
+import (
+	"fmt"
+	"strings"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// Regex hoisting.
+//
+// A regex call whose pattern is a string constant does not need to go through
+// the runtime's pattern cache at all: the pattern becomes a global
+// omni_regex_t handle, compiled once when the program starts, and the call
+// uses the handle-based variant of the function.
+
+// regexHandleFunctions maps the pattern-taking regex functions to their
+// handle-based variants. The pattern is the second argument of all of them.
+var regexHandleFunctions = map[string]string{
+	"omni_string_matches":       "omni_regex_exec",
+	"omni_string_find_match":    "omni_regex_find_match",
+	"omni_string_replace_regex": "omni_regex_replace",
+}
+
+// hoistedRegexCall returns the call to the handle-based variant of regex
+// function cFuncName when its pattern is a constant. ok is false if the
+// regular call should be emitted.
+func (g *CGenerator) hoistedRegexCall(cFuncName string, inst *mir.Instruction) (expr string, ok bool) {
+	handleFunc, isRegex := regexHandleFunctions[cFuncName]
+	if !isRegex || len(inst.Operands) < 3 {
+		return "", false
+	}
+	args := inst.Operands[1:]
+
+	var pattern string
+	switch op := args[1]; op.Kind {
+	case mir.OperandLiteral:
+		if strings.HasPrefix(op.Literal, "\"") && strings.HasSuffix(op.Literal, "\"") {
+			pattern = op.Literal
+		}
+	case mir.OperandValue:
+		pattern = g.constStrings[op.Value]
+	}
+	if pattern == "" {
+		return "", false
+	}
+
+	handle := g.regexHandle(pattern)
+	str := g.getOperandValue(args[0])
+	switch cFuncName {
+	case "omni_string_matches":
+		return fmt.Sprintf("%s(%s, %s, NULL, NULL)", handleFunc, handle, str), true
+	case "omni_string_replace_regex":
+		if len(args) != 3 {
+			return "", false
+		}
+		return fmt.Sprintf("%s(%s, %s, %s)", handleFunc, handle, str, g.getOperandValue(args[2])), true
+	}
+	return fmt.Sprintf("%s(%s, %s)", handleFunc, handle, str), true
+}
+
+// regexHandle returns the global handle for C string literal pattern,
+// registering it on first use.
+func (g *CGenerator) regexHandle(pattern string) string {
+	if name, ok := g.regexHandles[pattern]; ok {
+		return name
+	}
+	name := fmt.Sprintf("omni_re_%d", len(g.regexOrder))
+	g.regexHandles[pattern] = name
+	g.regexOrder = append(g.regexOrder, pattern)
+	return name
+}
+
+// regexDefinitions returns the hoisted regex handles and the function
+// compiling them, or "" if no pattern was hoisted.
+func (g *CGenerator) regexDefinitions() string {
+	if len(g.regexOrder) == 0 {
+		return ""
+	}
+	var b strings.Builder
+	b.WriteString("\n")
+	for _, pattern := range g.regexOrder {
+		b.WriteString(fmt.Sprintf("static omni_regex_t* %s;\n", g.regexHandles[pattern]))
+	}
+	b.WriteString("\nstatic void omni_compile_regexes(void) {\n")
+	for _, pattern := range g.regexOrder {
+		b.WriteString(fmt.Sprintf("  %s = omni_regex_compile(%s, 0);\n", g.regexHandles[pattern], pattern))
+	}
+	b.WriteString("}\n")
+	return b.String()
+}
@@ -0,0 +1,76 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+func TestRegexConstantPatternHoisted(t *testing.T) {
+	// matches(line, "^ERR") and replace_regex(line, "^ERR", "E"); then a
+	// pattern only known at run time
+	module := &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "filter",
+				ReturnType: "bool",
+				Params: []mir.Param{
+					{Name: "line", Type: "string", ID: 0},
+					{Name: "pattern", Type: "string", ID: 1},
+				},
+				Blocks: []*mir.BasicBlock{
+					{
+						Name: "entry",
+						Instructions: []mir.Instruction{
+							{ID: 2, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"^ERR\"", Type: "string"}}},
+							{ID: 3, Op: "call", Type: "bool", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.matches"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+								{Kind: mir.OperandValue, Value: 2, Type: "string"},
+							}},
+							{ID: 4, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"E\"", Type: "string"}}},
+							{ID: 5, Op: "call", Type: "string", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.replace_regex"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+								{Kind: mir.OperandValue, Value: 2, Type: "string"},
+								{Kind: mir.OperandValue, Value: 4, Type: "string"},
+							}},
+							{ID: 6, Op: "call", Type: "bool", Operands: []mir.Operand{
+								{Kind: mir.OperandLiteral, Literal: "std.string.matches"},
+								{Kind: mir.OperandValue, Value: 0, Type: "string"},
+								{Kind: mir.OperandValue, Value: 1, Type: "string"},
+							}},
+						},
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 3, Type: "bool"}},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := GenerateC(module)
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	expected := []string{
+		"static omni_regex_t* omni_re_0;",
+		"omni_re_0 = omni_regex_compile(\"^ERR\", 0);",
+		"v3 = omni_regex_exec(omni_re_0, line, NULL, NULL);",
+		"v5 = omni_regex_replace(omni_re_0, line, v4);",
+		"v6 = omni_string_matches(line, pattern);",
+		"omni_compile_regexes();",
+	}
+	for _, want := range expected {
+		if !strings.Contains(result, want) {
+			t.Errorf("expected %q in generated code:\n%s", want, result)
+		}
+	}
+	if strings.Count(result, "omni_regex_compile(") != 1 {
+		t.Error("a repeated pattern should be compiled once")
+	}
+}
@@ -0,0 +1,159 @@
+package cbackend
+
+import (
+	"fmt"
+	"strings"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// Strcat-chain fusion.
+//
+// An expression like "a" + b + "c" + n lowers to a left-leaning chain of
+// strcat instructions, each of which would allocate and copy everything
+// built so far. When an intermediate strcat result is used exactly once, by
+// a later strcat in the same block, it is not materialized: the final strcat
+// of the chain appends every leaf to one omni_strbuilder_t instead, so the
+// chain costs a single allocation and non-string leaves are formatted
+// straight into the buffer without conversion temporaries.
+
+// planStrcatFusion finds the strcat instructions of fn that are folded into a
+// later strcat. It populates fusedStrcats, strcatDefs and constStrings.
+func (g *CGenerator) planStrcatFusion(fn *mir.Function) {
+	g.fusedStrcats = make(map[mir.ValueID]bool)
+	g.strcatDefs = make(map[mir.ValueID]*mir.Instruction)
+	g.constStrings = make(map[mir.ValueID]string)
+
+	uses := make(map[mir.ValueID]int)
+	reassigned := make(map[mir.ValueID]bool)
+	for _, block := range fn.Blocks {
+		for i := range block.Instructions {
+			inst := &block.Instructions[i]
+			for _, op := range inst.Operands {
+				if op.Kind == mir.OperandValue {
+					uses[op.Value]++
+				}
+			}
+			if inst.Op == "assign" && len(inst.Operands) > 0 && inst.Operands[0].Kind == mir.OperandValue {
+				reassigned[inst.Operands[0].Value] = true
+			}
+		}
+		for _, op := range block.Terminator.Operands {
+			if op.Kind == mir.OperandValue {
+				uses[op.Value]++
+			}
+		}
+	}
+
+	for _, block := range fn.Blocks {
+		// Strcats of this block that are still waiting for their one use
+		pending := make(map[mir.ValueID]bool)
+		for i := range block.Instructions {
+			inst := &block.Instructions[i]
+			if inst.Op == "assign" {
+				// The leaves of a pending chain may be reassigned; fusing
+				// across this point would read the new values
+				pending = make(map[mir.ValueID]bool)
+				continue
+			}
+			if inst.Op == "const" && inst.Type == "string" && len(inst.Operands) > 0 &&
+				inst.Operands[0].Kind == mir.OperandLiteral {
+				if lit := g.getOperandValue(inst.Operands[0]); strings.HasPrefix(lit, "\"") {
+					g.constStrings[inst.ID] = lit
+				}
+			}
+			if inst.Op != "strcat" || len(inst.Operands) < 2 || inst.ID == mir.InvalidValue {
+				continue
+			}
+			g.strcatDefs[inst.ID] = inst
+			for _, op := range inst.Operands[:2] {
+				if op.Kind == mir.OperandValue && pending[op.Value] {
+					g.fusedStrcats[op.Value] = true
+					delete(pending, op.Value)
+				}
+			}
+			if uses[inst.ID] == 1 {
+				pending[inst.ID] = true
+			}
+		}
+	}
+
+	// A reassigned constant no longer holds its literal
+	for id := range reassigned {
+		delete(g.constStrings, id)
+	}
+}
+
+// strcatLeaves returns the operands appended by the chain ending at inst, in
+// order, looking through fused intermediate strcats.
+func (g *CGenerator) strcatLeaves(inst *mir.Instruction) []mir.Operand {
+	var leaves []mir.Operand
+	for _, op := range inst.Operands[:2] {
+		if op.Kind == mir.OperandValue && g.fusedStrcats[op.Value] {
+			if def, ok := g.strcatDefs[op.Value]; ok {
+				leaves = append(leaves, g.strcatLeaves(def)...)
+				continue
+			}
+		}
+		leaves = append(leaves, op)
+	}
+	return leaves
+}
+
+// emitStrcatBuilder generates the builder for a fused chain ending at inst
+// and assigns the finished string to varName.
+func (g *CGenerator) emitStrcatBuilder(inst *mir.Instruction, varName string, leaves []mir.Operand) {
+	sb := fmt.Sprintf("sb_%d", int(inst.ID))
+	g.output.WriteString(fmt.Sprintf("  omni_strbuilder_t %s;\n", sb))
+	g.output.WriteString(fmt.Sprintf("  omni_strbuilder_init(&%s);\n", sb))
+	for _, leaf := range leaves {
+		g.emitBuilderAppend(sb, leaf)
+	}
+
+	if g.arenaValues[inst.ID] {
+		g.output.WriteString(fmt.Sprintf("  %s = omni_strbuilder_finish_arena(&%s, %s);\n", varName, sb, arenaVar))
+		return
+	}
+	g.output.WriteString(fmt.Sprintf("  %s = omni_strbuilder_finish(&%s);\n", varName, sb))
+	g.stringsToFree[inst.ID] = true
+}
+
+// emitBuilderAppend appends one operand to builder sb, formatting it the same
+// way convertOperandToString would.
+func (g *CGenerator) emitBuilderAppend(sb string, op mir.Operand) {
+	switch op.Kind {
+	case mir.OperandValue:
+		operandType := op.Type
+		if recorded, exists := g.valueTypes[op.Value]; exists && recorded != "" {
+			operandType = recorded
+		}
+		varName := g.getVariableName(op.Value)
+		switch operandType {
+		case "string":
+			if n, ok := g.knownLength(op); ok {
+				g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_len(&%s, %s, %s);\n", sb, varName, n))
+			} else {
+				g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_str(&%s, %s);\n", sb, varName))
+			}
+		case "float", "double":
+			g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_float(&%s, %s);\n", sb, varName))
+		case "bool":
+			g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_bool(&%s, %s);\n", sb, varName))
+		default:
+			g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_int(&%s, %s);\n", sb, varName))
+		}
+	case mir.OperandLiteral:
+		lit := op.Literal
+		if lit == "true" {
+			g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_bool(&%s, 1);\n", sb))
+		} else if lit == "false" {
+			g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_bool(&%s, 0);\n", sb))
+		} else if strings.HasPrefix(lit, "\"") && strings.HasSuffix(lit, "\"") {
+			g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_len(&%s, %s, sizeof(%s) - 1);\n", sb, lit, lit))
+		} else if strings.Contains(lit, ".") {
+			g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_float(&%s, %s);\n", sb, lit))
+		} else {
+			g.output.WriteString(fmt.Sprintf("  omni_strbuilder_append_int(&%s, %s);\n", sb, lit))
+		}
+	}
+}
@@ -0,0 +1,110 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// strcatChainModule builds label(n) = "n=" + n + ", " + name, returned.
+func strcatChainModule(extra []mir.Instruction) *mir.Module {
+	insts := []mir.Instruction{
+		{ID: 2, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\"n=\"", Type: "string"}}},
+		{ID: 3, Op: "strcat", Type: "string", Operands: []mir.Operand{
+			{Kind: mir.OperandValue, Value: 2, Type: "string"},
+			{Kind: mir.OperandValue, Value: 0, Type: "int"},
+		}},
+		{ID: 4, Op: "const", Type: "string", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "\", \"", Type: "string"}}},
+		{ID: 5, Op: "strcat", Type: "string", Operands: []mir.Operand{
+			{Kind: mir.OperandValue, Value: 3, Type: "string"},
+			{Kind: mir.OperandValue, Value: 4, Type: "string"},
+		}},
+	}
+	insts = append(insts, extra...)
+	insts = append(insts, mir.Instruction{ID: 6, Op: "strcat", Type: "string", Operands: []mir.Operand{
+		{Kind: mir.OperandValue, Value: 5, Type: "string"},
+		{Kind: mir.OperandValue, Value: 1, Type: "string"},
+	}})
+
+	return &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "label",
+				ReturnType: "string",
+				Params: []mir.Param{
+					{Name: "n", Type: "int", ID: 0},
+					{Name: "name", Type: "string", ID: 1},
+				},
+				Blocks: []*mir.BasicBlock{
+					{
+						Name:         "entry",
+						Instructions: insts,
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 6, Type: "string"}},
+						},
+					},
+				},
+			},
+		},
+	}
+}
+
+func TestStrcatChainFusion(t *testing.T) {
+	result, err := GenerateC(strcatChainModule(nil))
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	expected := []string{
+		"omni_strbuilder_t sb_6;",
+		"omni_strbuilder_init(&sb_6);",
+		"omni_strbuilder_append_len(&sb_6, v2, (sizeof(\"n=\") - 1));",
+		"omni_strbuilder_append_int(&sb_6, n);",
+		"omni_strbuilder_append_len(&sb_6, v4, (sizeof(\", \") - 1));",
+		"omni_strbuilder_append_str(&sb_6, name);",
+		"v6 = omni_strbuilder_finish(&sb_6);",
+	}
+	last := -1
+	for _, want := range expected {
+		idx := strings.Index(result, want)
+		if idx < 0 {
+			t.Fatalf("expected %q in generated code:\n%s", want, result)
+		}
+		if idx < last {
+			t.Errorf("%q emitted out of order", want)
+		}
+		last = idx
+	}
+	if strings.Contains(result, "omni_strcat") {
+		t.Error("fused chain should not call omni_strcat")
+	}
+	if strings.Contains(result, "omni_int_to_string") {
+		t.Error("fused chain should format ints in place")
+	}
+	if strings.Contains(result, "v3;") || strings.Contains(result, "v5;") {
+		t.Error("fused links should not be declared")
+	}
+}
+
+func TestStrcatChainSplitAtAssign(t *testing.T) {
+	// Reassigning a variable between links must not be fused over
+	assign := []mir.Instruction{
+		{ID: 7, Op: "assign", Type: "string", Operands: []mir.Operand{
+			{Kind: mir.OperandValue, Value: 1, Type: "string"},
+			{Kind: mir.OperandValue, Value: 4, Type: "string"},
+		}},
+	}
+	result, err := GenerateC(strcatChainModule(assign))
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	if !strings.Contains(result, "v5 = omni_strbuilder_finish_arena(&sb_5, _arena);") {
+		t.Errorf("expected the links before the assign to be fused:\n%s", result)
+	}
+	if !strings.Contains(result, "v6 = omni_strcat(v5, name);") {
+		t.Errorf("expected the link after the assign to stay separate:\n%s", result)
+	}
+}
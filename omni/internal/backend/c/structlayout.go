@@ -0,0 +1,122 @@
+package cbackend
+
+import (
+	"fmt"
+	"strings"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// Static struct layouts.
+//
+// The runtime lays struct fields out in the order they are first set, so a
+// struct type whose every struct.init in the module lists the same fields in
+// the same order has a layout known at compile time. Member accesses on such
+// a type read the slot directly through the offset-based accessors; all other
+// accesses get an inline cache of their own. The runtime checks either guess
+// against the struct's shape, so a wrong one is slow but never incorrect.
+
+// planStructLayouts records the field order of every struct type of the
+// module that has a consistent one.
+func (g *CGenerator) planStructLayouts() {
+	g.structLayouts = make(map[string][]string)
+	for _, fn := range g.module.Functions {
+		for _, block := range fn.Blocks {
+			for i := range block.Instructions {
+				inst := &block.Instructions[i]
+				if inst.Op != "struct.init" {
+					continue
+				}
+				typeName, fields := structInitFields(inst)
+				if typeName == "" {
+					continue
+				}
+				layout, seen := g.structLayouts[typeName]
+				if !seen {
+					g.structLayouts[typeName] = fields
+				} else if layout != nil && !sameFields(layout, fields) {
+					// Initialized in different orders: no static layout
+					g.structLayouts[typeName] = nil
+				}
+			}
+		}
+	}
+}
+
+// structInitFields returns the struct type and field names, in order, that
+// struct.init inst sets. It mirrors the field naming of the struct.init
+// lowering.
+func structInitFields(inst *mir.Instruction) (string, []string) {
+	typeName := inst.Type
+	if len(inst.Operands) > 0 && inst.Operands[0].Kind == mir.OperandLiteral && len(inst.Operands)%2 == 1 {
+		typeName = inst.Operands[0].Literal
+	}
+	if typeName == "" || typeName == inferTypePlaceholder {
+		return "", nil
+	}
+
+	var fields []string
+	if len(inst.Operands) >= 2 && inst.Operands[0].Kind == mir.OperandLiteral {
+		start := len(inst.Operands) % 2
+		for i := start; i+1 < len(inst.Operands); i += 2 {
+			fields = append(fields, inst.Operands[i].Literal)
+		}
+		return typeName, fields
+	}
+	// Positional format: fields are named by position
+	for i := range inst.Operands {
+		if i == 0 && inst.Operands[0].Kind == mir.OperandLiteral {
+			continue
+		}
+		fields = append(fields, fmt.Sprintf("field%d", len(fields)))
+	}
+	return typeName, fields
+}
+
+func sameFields(a, b []string) bool {
+	if len(a) != len(b) {
+		return false
+	}
+	for i := range a {
+		if a[i] != b[i] {
+			return false
+		}
+	}
+	return true
+}
+
+// structFieldGet returns the C expression reading field of the struct in op
+// with the omni_struct getter of the given kind (string, int, float, bool).
+func (g *CGenerator) structFieldGet(kind string, op mir.Operand, field string) string {
+	structVar := g.getOperandValue(op)
+	key := g.fieldKey(field)
+
+	structType := op.Type
+	if op.Kind == mir.OperandValue {
+		if recorded, ok := g.valueTypes[op.Value]; ok && recorded != "" && recorded != inferTypePlaceholder {
+			structType = recorded
+		}
+	}
+	for slot, name := range g.structLayouts[structType] {
+		if name == field {
+			return fmt.Sprintf("omni_struct_get_%s_at(%s, %d, %s)", kind, structVar, slot, key)
+		}
+	}
+
+	ic := fmt.Sprintf("omni_ic_%d", g.inlineCaches)
+	g.inlineCaches++
+	return fmt.Sprintf("omni_struct_get_%s_field_ic(%s, %s, &%s)", kind, structVar, key, ic)
+}
+
+// inlineCacheDefinitions returns the inline caches of the struct accesses.
+func (g *CGenerator) inlineCacheDefinitions() string {
+	if g.inlineCaches == 0 {
+		return ""
+	}
+	var b strings.Builder
+	b.WriteString("\n")
+	for i := 0; i < g.inlineCaches; i++ {
+		b.WriteString(fmt.Sprintf("static omni_struct_ic_t omni_ic_%d;\n", i))
+	}
+	return b.String()
+}
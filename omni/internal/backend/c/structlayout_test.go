@@ -0,0 +1,84 @@
+package cbackend
+
+import (
+	"strings"
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// pointInit builds a struct.init of Point setting the given fields to v1.
+func pointInit(id mir.ValueID, fields ...string) mir.Instruction {
+	operands := []mir.Operand{{Kind: mir.OperandLiteral, Literal: "Point"}}
+	for _, f := range fields {
+		operands = append(operands,
+			mir.Operand{Kind: mir.OperandLiteral, Literal: f},
+			mir.Operand{Kind: mir.OperandValue, Value: 1, Type: "int"})
+	}
+	return mir.Instruction{ID: id, Op: "struct.init", Type: "Point", Operands: operands}
+}
+
+func pointMember(id, target mir.ValueID, field string) mir.Instruction {
+	return mir.Instruction{ID: id, Op: "member", Type: "int", Operands: []mir.Operand{
+		{Kind: mir.OperandValue, Value: target, Type: "Point"},
+		{Kind: mir.OperandLiteral, Literal: field},
+	}}
+}
+
+func structLayoutModule(inits ...mir.Instruction) *mir.Module {
+	insts := []mir.Instruction{
+		{ID: 1, Op: "const", Type: "int", Operands: []mir.Operand{{Kind: mir.OperandLiteral, Literal: "1", Type: "int"}}},
+	}
+	insts = append(insts, inits...)
+	insts = append(insts, pointMember(10, inits[0].ID, "y"))
+	return &mir.Module{
+		Functions: []*mir.Function{
+			{
+				Name:       "main",
+				ReturnType: "int",
+				Blocks: []*mir.BasicBlock{
+					{
+						Name:         "entry",
+						Instructions: insts,
+						Terminator: mir.Terminator{
+							Op:       "ret",
+							Operands: []mir.Operand{{Kind: mir.OperandValue, Value: 10, Type: "int"}},
+						},
+					},
+				},
+			},
+		},
+	}
+}
+
+func TestStructStaticLayout(t *testing.T) {
+	result, err := GenerateC(structLayoutModule(pointInit(2, "x", "y"), pointInit(3, "x", "y")))
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	if !strings.Contains(result, "v2 = omni_struct_create_sized(2);") {
+		t.Errorf("expected struct.init to reserve a slot per field:\n%s", result)
+	}
+	if !strings.Contains(result, "v10 = omni_struct_get_int_at(v2, 1, omni_key_1);") {
+		t.Errorf("expected slot access for a statically known layout:\n%s", result)
+	}
+	if strings.Contains(result, "omni_struct_ic_t") {
+		t.Error("static accesses need no inline cache")
+	}
+}
+
+func TestStructInlineCache(t *testing.T) {
+	// Point is initialized in two field orders, so y has no fixed slot
+	result, err := GenerateC(structLayoutModule(pointInit(2, "x", "y"), pointInit(3, "y", "x")))
+	if err != nil {
+		t.Fatalf("GenerateC failed: %v", err)
+	}
+
+	if !strings.Contains(result, "static omni_struct_ic_t omni_ic_0;") {
+		t.Errorf("expected an inline cache for the access site:\n%s", result)
+	}
+	if !strings.Contains(result, "v10 = omni_struct_get_int_field_ic(v2, omni_key_1, &omni_ic_0);") {
+		t.Errorf("expected cached name-based access:\n%s", result)
+	}
+}
@@ -32,6 +32,21 @@ type Config struct {
 	Dump         string
 	DebugInfo    bool
 	DebugModules bool
+	// Coverage instruments C backend executables with coverage counters
+	Coverage bool
+	// Profile instruments C backend executables with function timing and
+	// allocation counters and turns on the sampling profiler
+	Profile bool
+	// LTO compiles the C backend program and the runtime as one link-time
+	// optimized unit, so runtime calls on hot paths can be inlined
+	LTO bool
+	// PGOGenerate instruments an LTO build to write branch profiles under
+	// this directory when the program runs
+	PGOGenerate string
+	// PGOUse optimizes an LTO build with the profiles collected under this
+	// directory. GCC matches profiles by output path, so the instrumented
+	// and the optimized build must write the same -o.
+	PGOUse string
 }
 
 // ErrNotImplemented indicates that a requested stage has not yet been implemented.
@@ -115,6 +130,10 @@ func Compile(cfg Config) error {
 	if err := passes.Verify(mirMod); err != nil {
 		return err
 	}
+	for _, loop := range passes.FindParallelLoops(mirMod) {
+		logging.Logger().DebugFields("Loop eligible for parallel execution",
+			logging.String("function", loop.Function), logging.String("header", loop.Header))
+	}
 	// TODO: Re-enable constant folding with proper handling of mutable variables
 	// pipeline := passes.NewPipeline("default")
 	// if _, err := pipeline.Run(*mirMod); err != nil {
@@ -389,7 +408,11 @@ func compileCBackend(cfg Config, emit string, mod *mir.Module) error {
 
 	switch emit {
 	case "exe":
-		if cfg.DebugInfo {
+		if cfg.Coverage || cfg.Profile {
+			return compileCToExecutableInstrumented(mod, output, cfg)
+		} else if cfg.LTO || cfg.PGOGenerate != "" || cfg.PGOUse != "" {
+			return compileCToExecutableLTO(mod, output, cfg)
+		} else if cfg.DebugInfo {
 			return compileCToExecutableWithDebug(mod, output, cfg.OptLevel, cfg.InputPath)
 		} else if cfg.OptLevel != "O0" {
 			return compileCToExecutableWithOpt(mod, output, cfg.OptLevel)
@@ -492,6 +515,73 @@ func compileCToExecutableWithDebug(mod *mir.Module, outputPath string, optLevel
 	return nil
 }
 
+// compileCToExecutableInstrumented compiles MIR to an executable counting
+// coverage sites and/or profiling its functions; the program writes its
+// counts on exit
+func compileCToExecutableInstrumented(mod *mir.Module, outputPath string, cfg Config) error {
+	gen := cbackend.NewCGeneratorWithDebug(mod, cfg.OptLevel, cfg.DebugInfo, cfg.InputPath)
+	if cfg.Coverage {
+		gen.EnableCoverage(cfg.InputPath)
+	}
+	if cfg.Profile {
+		gen.EnableProfiling(cfg.InputPath)
+	}
+	cCode, err := gen.Generate()
+	if err != nil {
+		return fmt.Errorf("failed to generate instrumented C code: %w", err)
+	}
+
+	// Write C code to temporary file
+	cPath := strings.TrimSuffix(outputPath, filepath.Ext(outputPath)) + ".c"
+	if err := os.WriteFile(cPath, []byte(cCode), 0o644); err != nil {
+		return fmt.Errorf("failed to write C code: %w", err)
+	}
+
+	if cfg.DebugInfo {
+		err = compileCWrapperWithDebug(cPath, outputPath, cfg.OptLevel)
+	} else {
+		err = compileCWrapperWithOpt(cPath, outputPath, cfg.OptLevel)
+	}
+	if err != nil {
+		return fmt.Errorf("failed to compile instrumented C code: %w", err)
+	}
+
+	// Clean up temporary file
+	os.Remove(cPath)
+
+	return nil
+}
+
+// compileCToExecutableLTO compiles MIR and the runtime as a single
+// link-time optimized program, optionally instrumented for or optimized with
+// a gcc profile. Without an explicit level it builds at O3.
+func compileCToExecutableLTO(mod *mir.Module, outputPath string, cfg Config) error {
+	optLevel := cfg.OptLevel
+	if optLevel == "" || optLevel == "O0" {
+		optLevel = "O3"
+	}
+
+	cCode, err := cbackend.GenerateCOptimized(mod, optLevel)
+	if err != nil {
+		return fmt.Errorf("failed to generate optimized C code: %w", err)
+	}
+
+	// Write C code to temporary file
+	cPath := strings.TrimSuffix(outputPath, filepath.Ext(outputPath)) + ".c"
+	if err := os.WriteFile(cPath, []byte(cCode), 0o644); err != nil {
+		return fmt.Errorf("failed to write C code: %w", err)
+	}
+
+	if err := compileCWrapperLTO(cPath, outputPath, optLevel, cfg); err != nil {
+		return fmt.Errorf("failed to compile C code with LTO: %w", err)
+	}
+
+	// Clean up temporary file
+	os.Remove(cPath)
+
+	return nil
+}
+
 // compileCraneliftBackend compiles MIR to native code using Cranelift backend
 func compileCraneliftBackend(cfg Config, emit string, mod *mir.Module) error {
 	output := cfg.OutputPath
@@ -754,6 +844,88 @@ func compileCWrapperWithOpt(cPath, outputPath string, optLevel string) error {
 	} else if targetOS == "linux" {
 		args = append(args, "-DLINUX")
 	}
+	// The runtime's task scheduler runs on its own threads
+	if targetOS != "windows" {
+		args = append(args, "-pthread")
+	}
+
+	// Add architecture-specific flags
+	if targetArch == "amd64" || targetArch == "x86_64" {
+		args = append(args, "-DARCH_X86_64")
+	} else if targetArch == "arm64" || targetArch == "aarch64" {
+		args = append(args, "-DARCH_ARM64")
+	}
+
+	cmd := exec.Command("gcc", args...)
+	cmd.Stdout = os.Stdout
+	cmd.Stderr = os.Stderr
+	if err := cmd.Run(); err != nil {
+		return fmt.Errorf("c compilation failed: %w", err)
+	}
+
+	return nil
+}
+
+func compileCWrapperLTO(cPath, outputPath string, optLevel string, cfg Config) error {
+	// Find the runtime directory
+	runtimeDir := findRuntimeDir()
+	if runtimeDir == "" {
+		return fmt.Errorf("runtime directory not found")
+	}
+
+	// Determine target platform
+	targetOS, targetArch := getTargetPlatform()
+
+	// Program and runtime go through one compiler invocation, so the LTO
+	// link sees both and can inline across them
+	args := []string{
+		"-o", outputPath,
+		cPath,
+		filepath.Join(runtimeDir, "omni_rt.c"),
+		"-I", runtimeDir,
+		"-std=c99",
+		"-Wall",
+		"-Wextra",
+		"-flto",
+		"-lm",
+	}
+
+	// Add optimization flags
+	switch optLevel {
+	case "1", "O1", "basic":
+		args = append(args, "-O1")
+	case "2", "O2", "standard":
+		args = append(args, "-O2")
+	case "s", "Os", "size":
+		args = append(args, "-Os")
+	default:
+		args = append(args, "-O3")
+	}
+	if cfg.DebugInfo {
+		args = append(args, "-g")
+	}
+
+	// Profile-guided optimization. The scheduler runs tasks on several
+	// threads, so the counters are updated atomically.
+	if cfg.PGOGenerate != "" {
+		args = append(args, "-fprofile-generate="+cfg.PGOGenerate, "-fprofile-update=atomic")
+	}
+	if cfg.PGOUse != "" {
+		args = append(args, "-fprofile-use="+cfg.PGOUse, "-fprofile-partial-training", "-Wno-missing-profile")
+	}
+
+	// Add platform-specific flags
+	if targetOS == "windows" {
+		args = append(args, "-DWINDOWS")
+	} else if targetOS == "darwin" {
+		args = append(args, "-DDARWIN")
+	} else if targetOS == "linux" {
+		args = append(args, "-DLINUX")
+	}
+	// The runtime's task scheduler runs on its own threads
+	if targetOS != "windows" {
+		args = append(args, "-pthread")
+	}
 
 	// Add architecture-specific flags
 	if targetArch == "amd64" || targetArch == "x86_64" {
@@ -819,6 +991,10 @@ func compileCWrapperWithDebug(cPath, outputPath string, optLevel string) error {
 	} else if targetOS == "linux" {
 		args = append(args, "-DLINUX")
 	}
+	// The runtime's task scheduler runs on its own threads
+	if targetOS != "windows" {
+		args = append(args, "-pthread")
+	}
 
 	// Add architecture-specific flags
 	if targetArch == "amd64" || targetArch == "x86_64" {
@@ -909,6 +1085,10 @@ func compileCWrapper(cPath, outputPath string) error {
 	} else if targetOS == "linux" {
 		args = append(args, "-DLINUX")
 	}
+	// The runtime's task scheduler runs on its own threads
+	if targetOS != "windows" {
+		args = append(args, "-pthread")
+	}
 
 	// Add architecture-specific flags
 	if targetArch == "amd64" || targetArch == "x86_64" {
@@ -1,6 +1,9 @@
 package compiler
 
 import (
+	"os"
+	"os/exec"
+	"path/filepath"
 	"testing"
 )
 
@@ -53,6 +56,53 @@ func TestCompileWithValidBackend(t *testing.T) {
 	}
 }
 
+func TestCompileWithLTO(t *testing.T) {
+	if _, err := exec.LookPath("gcc"); err != nil {
+		t.Skip("gcc not available")
+	}
+	if findRuntimeDir() == "" {
+		t.Skip("runtime directory not found")
+	}
+
+	dir := t.TempDir()
+	input := filepath.Join(dir, "lto.omni")
+	source := `
+func main():int {
+    let a:int = 7
+    let b:int = 6
+    return a * b
+}`
+	if err := os.WriteFile(input, []byte(source), 0o644); err != nil {
+		t.Fatalf("Failed to write test file: %v", err)
+	}
+
+	output := filepath.Join(dir, "lto")
+	config := Config{
+		InputPath:   input,
+		OutputPath:  output,
+		Backend:     "c",
+		Emit:        "exe",
+		PGOGenerate: filepath.Join(dir, "profile"),
+	}
+	if err := Compile(config); err != nil {
+		t.Fatalf("Instrumented LTO build failed: %v", err)
+	}
+	err := exec.Command(output).Run()
+	if exitErr, ok := err.(*exec.ExitError); !ok || exitErr.ExitCode() != 42 {
+		t.Fatalf("Expected exit code 42, got %v", err)
+	}
+
+	config.PGOGenerate = ""
+	config.PGOUse = filepath.Join(dir, "profile")
+	if err := Compile(config); err != nil {
+		t.Fatalf("Profile-optimized LTO build failed: %v", err)
+	}
+	err = exec.Command(output).Run()
+	if exitErr, ok := err.(*exec.ExitError); !ok || exitErr.ExitCode() != 42 {
+		t.Fatalf("Expected exit code 42, got %v", err)
+	}
+}
+
 func TestConfig(t *testing.T) {
 	// Test config creation
 	config := Config{
@@ -422,6 +422,10 @@ func (fb *functionBuilder) lowerRangeFor(stmt *ast.ForStmt) error {
 		return fmt.Errorf("mir builder: range for loop requires a target variable")
 	}
 
+	if strings.HasPrefix(iterableValue.Type, "linked_list<") {
+		return fb.lowerListRangeFor(stmt, iterableValue, originalEnv)
+	}
+
 	// Create loop index variable before the loop
 	indexID := fb.fn.NextValue()
 	indexInst := mir.Instruction{
@@ -611,6 +615,100 @@ func (fb *functionBuilder) lowerRangeFor(stmt *ast.ForStmt) error {
 	return nil
 }
 
+// lowerListRangeFor lowers `for item in list` over a linked list to a cursor
+// walk instead of indexing: list.begin yields a cursor, list.valid tests it
+// in the header, list.value reads the element and list.next advances it in
+// a latch block that continue jumps to.
+func (fb *functionBuilder) lowerListRangeFor(stmt *ast.ForStmt, list mirValue, originalEnv map[string]symbol) error {
+	elementType := strings.TrimSpace(list.Type[len("linked_list<") : len(list.Type)-1])
+
+	cursorID := fb.fn.NextValue()
+	fb.block.Instructions = append(fb.block.Instructions, mir.Instruction{
+		ID:       cursorID,
+		Op:       "list.begin",
+		Type:     "linked_list_cursor",
+		Operands: []mir.Operand{valueOperand(list.ID, list.Type)},
+	})
+
+	headerBlock := fb.newBlock("list_loop_header")
+	bodyBlock := fb.newBlock("list_loop_body")
+	latchBlock := fb.newBlock("list_loop_next")
+	exitBlock := fb.newBlock("list_loop_exit")
+
+	fb.loopStack = append(fb.loopStack, loopContext{
+		continueBlock: latchBlock,
+		breakBlock:    exitBlock,
+	})
+
+	fb.block.Terminator = mir.Terminator{
+		Op:       "br",
+		Operands: []mir.Operand{blockOperand(headerBlock)},
+	}
+
+	// Header: stop once the cursor has run off the end
+	fb.block = headerBlock
+	validID := fb.fn.NextValue()
+	fb.block.Instructions = append(fb.block.Instructions, mir.Instruction{
+		ID:       validID,
+		Op:       "list.valid",
+		Type:     "bool",
+		Operands: []mir.Operand{valueOperand(cursorID, "linked_list_cursor")},
+	})
+	fb.block.Terminator = mir.Terminator{
+		Op: "cbr",
+		Operands: []mir.Operand{
+			valueOperand(validID, "bool"),
+			blockOperand(bodyBlock),
+			blockOperand(exitBlock),
+		},
+	}
+
+	// Body: bind the element under the cursor to the loop target
+	fb.block = bodyBlock
+	bodyEnv := make(map[string]symbol)
+	for k, v := range fb.env {
+		bodyEnv[k] = v
+	}
+	itemID := fb.fn.NextValue()
+	fb.block.Instructions = append(fb.block.Instructions, mir.Instruction{
+		ID:       itemID,
+		Op:       "list.value",
+		Type:     elementType,
+		Operands: []mir.Operand{valueOperand(cursorID, "linked_list_cursor")},
+	})
+	bodyEnv[stmt.Target.Name] = symbol{Value: itemID, Type: elementType, Mutable: false}
+	fb.env = bodyEnv
+
+	if err := fb.lowerBlock(stmt.Body); err != nil {
+		return err
+	}
+	if !fb.block.HasTerminator() {
+		fb.block.Terminator = mir.Terminator{
+			Op:       "br",
+			Operands: []mir.Operand{blockOperand(latchBlock)},
+		}
+	}
+
+	// Latch: advance the cursor and go around again
+	fb.block = latchBlock
+	fb.block.Instructions = append(fb.block.Instructions, mir.Instruction{
+		ID:       fb.fn.NextValue(),
+		Op:       "list.next",
+		Type:     "void",
+		Operands: []mir.Operand{valueOperand(cursorID, "linked_list_cursor")},
+	})
+	fb.block.Terminator = mir.Terminator{
+		Op:       "br",
+		Operands: []mir.Operand{blockOperand(headerBlock)},
+	}
+
+	fb.loopStack = fb.loopStack[:len(fb.loopStack)-1]
+
+	fb.block = exitBlock
+	fb.env = originalEnv
+	return nil
+}
+
 func (fb *functionBuilder) lowerClassicFor(stmt *ast.ForStmt) error {
 	// Save the current environment
 	originalEnv := make(map[string]symbol)
@@ -1359,6 +1457,59 @@ func (fb *functionBuilder) emitCall(expr *ast.CallExpr) (mirValue, error) {
 		} else if strings.Contains(calleeName, "file.") {
 			// File operations return int (file handles, byte counts, etc.)
 			resultType = "int"
+		} else if strings.Contains(calleeName, "network.socket_") {
+			// Socket operations
+			switch {
+			case strings.HasSuffix(calleeName, "_receive_async"):
+				resultType = "Promise<string>"
+			case strings.HasSuffix(calleeName, "_async"):
+				resultType = "Promise<int>"
+			case strings.HasSuffix(calleeName, "_receive"):
+				resultType = "string"
+			case strings.HasSuffix(calleeName, "_create"), strings.HasSuffix(calleeName, "_accept"),
+				strings.HasSuffix(calleeName, "_send"), strings.HasSuffix(calleeName, "_listen_shared"):
+				resultType = "int"
+			default:
+				// connect, bind, listen, close and the option setters
+				resultType = "bool"
+			}
+		} else if strings.Contains(calleeName, "collections.linked_list_") {
+			// Linked list operations
+			switch {
+			case strings.HasSuffix(calleeName, "_create"):
+				resultType = "linked_list<int>"
+			case strings.HasSuffix(calleeName, "_get"), strings.HasSuffix(calleeName, "_size"):
+				resultType = "int"
+			case strings.HasSuffix(calleeName, "_append"), strings.HasSuffix(calleeName, "_prepend"),
+				strings.HasSuffix(calleeName, "_clear"):
+				resultType = "void"
+			default:
+				// insert, remove, set, is_empty
+				resultType = "bool"
+			}
+		} else if strings.Contains(calleeName, "collections.set_") {
+			// Set operations
+			switch {
+			case strings.HasSuffix(calleeName, "_create"), strings.HasSuffix(calleeName, "_union"),
+				strings.HasSuffix(calleeName, "_intersection"), strings.HasSuffix(calleeName, "_difference"):
+				resultType = "set<int>"
+			case strings.HasSuffix(calleeName, "_size"):
+				resultType = "int"
+			case strings.HasSuffix(calleeName, "_clear"):
+				resultType = "void"
+			default:
+				// add, remove, contains and the in-place *_with operations
+				resultType = "bool"
+			}
+		} else if strings.Contains(calleeName, "collections.map_from_arrays") {
+			resultType = "map<int,int>"
+		} else if strings.Contains(calleeName, "algorithms.parallel_") {
+			// Parallel algorithms: the sorts report success, reductions return int
+			if strings.Contains(calleeName, "parallel_sort") {
+				resultType = "bool"
+			} else {
+				resultType = "int"
+			}
 		} else if strings.Contains(calleeName, "int_to_string") {
 			resultType = "string"
 		} else if strings.Contains(calleeName, "float_to_string") {
@@ -1,6 +1,7 @@
 package builder
 
 import (
+	"strings"
 	"testing"
 
 	"github.com/omni-lang/omni/internal/ast"
@@ -1328,3 +1329,110 @@ func TestFunctionWithExprBody(t *testing.T) {
 		t.Errorf("Expected 1 block for expr body, got %d", len(fn.Blocks))
 	}
 }
+
+func TestStdSocketCallTypes(t *testing.T) {
+	// Socket calls are typed so that their results can be used and awaited
+	call := func(name string) ast.Expr {
+		return &ast.CallExpr{
+			Callee: &ast.IdentifierExpr{Name: name},
+			Args:   []ast.Expr{&ast.LiteralExpr{Kind: ast.LiteralInt, Value: "3"}},
+		}
+	}
+	expected := map[string]string{
+		"std.network.socket_accept":        "int",
+		"std.network.socket_receive":       "string",
+		"std.network.socket_close":         "bool",
+		"std.network.socket_accept_async":  "Promise<int>",
+		"std.network.socket_send_async":    "Promise<int>",
+		"std.network.socket_receive_async": "Promise<string>",
+	}
+	var stmts []ast.Stmt
+	for name := range expected {
+		stmts = append(stmts, &ast.ExprStmt{Expr: call(name)})
+	}
+	module := &ast.Module{
+		Decls: []ast.Decl{
+			&ast.FuncDecl{
+				Name:   "test",
+				Return: &ast.TypeExpr{Name: "void"},
+				Body:   &ast.BlockStmt{Statements: stmts},
+			},
+		},
+	}
+
+	result, err := BuildModule(module)
+	if err != nil {
+		t.Fatalf("BuildModule failed: %v", err)
+	}
+
+	found := 0
+	for _, block := range result.Functions[0].Blocks {
+		for _, inst := range block.Instructions {
+			if inst.Op != "call" || len(inst.Operands) == 0 {
+				continue
+			}
+			want, ok := expected[inst.Operands[0].Literal]
+			if !ok {
+				continue
+			}
+			found++
+			if inst.Type != want {
+				t.Errorf("%s: expected type %s, got %s", inst.Operands[0].Literal, want, inst.Type)
+			}
+		}
+	}
+	if found != len(expected) {
+		t.Errorf("expected %d socket calls, found %d", len(expected), found)
+	}
+}
+
+func TestLowerForStmtRangeLinkedList(t *testing.T) {
+	// func sum(list: linked_list<int>): void { for item in list { continue } }
+	module := &ast.Module{
+		Decls: []ast.Decl{
+			&ast.FuncDecl{
+				Name: "sum",
+				Params: []ast.Param{
+					{Name: "list", Type: &ast.TypeExpr{Name: "linked_list", Args: []*ast.TypeExpr{{Name: "int"}}}},
+				},
+				Return: &ast.TypeExpr{Name: "void"},
+				Body: &ast.BlockStmt{
+					Statements: []ast.Stmt{
+						&ast.ForStmt{
+							IsRange:  true,
+							Target:   &ast.IdentifierExpr{Name: "item"},
+							Iterable: &ast.IdentifierExpr{Name: "list"},
+							Body: &ast.BlockStmt{
+								Statements: []ast.Stmt{&ast.ContinueStmt{}},
+							},
+						},
+					},
+				},
+			},
+		},
+	}
+
+	result, err := BuildModule(module)
+	if err != nil {
+		t.Fatalf("BuildModule failed: %v", err)
+	}
+
+	ops := make(map[string]string)
+	for _, block := range result.Functions[0].Blocks {
+		for _, inst := range block.Instructions {
+			ops[inst.Op] = block.Name
+		}
+	}
+	for _, op := range []string{"list.begin", "list.valid", "list.value", "list.next"} {
+		if _, ok := ops[op]; !ok {
+			t.Errorf("expected a %s instruction, got ops %v", op, ops)
+		}
+	}
+	if _, ok := ops["index"]; ok {
+		t.Error("range over a linked list should not index it")
+	}
+	// continue must still advance the cursor
+	if next := ops["list.next"]; !strings.HasPrefix(next, "list_loop_next") {
+		t.Errorf("list.next emitted in block %q, want the latch block", next)
+	}
+}
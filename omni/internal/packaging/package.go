@@ -210,6 +210,7 @@ func addFilesToTar(tarWriter *tar.Writer, config PackageConfig, record recorderF
 	runtimeFiles := []string{
 		"runtime/omni_rt.c",
 		"runtime/omni_rt.h",
+		"runtime/omni_rt_inline.h",
 	}
 
 	for _, file := range runtimeFiles {
@@ -293,6 +294,7 @@ func addFilesToZip(zipWriter *zip.Writer, config PackageConfig, record recorderF
 	runtimeFiles := []string{
 		"runtime/omni_rt.c",
 		"runtime/omni_rt.h",
+		"runtime/omni_rt_inline.h",
 	}
 
 	for _, file := range runtimeFiles {
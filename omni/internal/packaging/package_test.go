@@ -136,6 +136,7 @@ func TestCreatePackageDryRun(t *testing.T) {
 
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.c"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.h"), []byte("test"), 0644)
+	os.WriteFile(filepath.Join(runtimeDir, "omni_rt_inline.h"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(binDir, "omnic"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(stdDir, "test.omni"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(examplesDir, "hello.omni"), []byte("test"), 0644)
@@ -183,6 +184,7 @@ func TestCreatePackageWithManifest(t *testing.T) {
 
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.c"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.h"), []byte("test"), 0644)
+	os.WriteFile(filepath.Join(runtimeDir, "omni_rt_inline.h"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(binDir, "omnic"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(stdDir, "test.omni"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(examplesDir, "hello.omni"), []byte("test"), 0644)
@@ -269,6 +271,7 @@ func TestSimulatePackage(t *testing.T) {
 
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.c"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.h"), []byte("test"), 0644)
+	os.WriteFile(filepath.Join(runtimeDir, "omni_rt_inline.h"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(binDir, "omnic"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(stdDir, "test.omni"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(examplesDir, "hello.omni"), []byte("test"), 0644)
@@ -612,6 +615,7 @@ func TestCreatePackageWithChecksum(t *testing.T) {
 
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.c"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.h"), []byte("test"), 0644)
+	os.WriteFile(filepath.Join(runtimeDir, "omni_rt_inline.h"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(binDir, "omnic"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(stdDir, "test.omni"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(examplesDir, "hello.omni"), []byte("test"), 0644)
@@ -669,6 +673,7 @@ func TestCreatePackageWithDebugAndSrc(t *testing.T) {
 
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.c"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.h"), []byte("test"), 0644)
+	os.WriteFile(filepath.Join(runtimeDir, "omni_rt_inline.h"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(binDir, "omnic"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(stdDir, "test.omni"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(examplesDir, "hello.omni"), []byte("test"), 0644)
@@ -780,6 +785,7 @@ func TestCreatePackageOutputDirectory(t *testing.T) {
 
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.c"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(runtimeDir, "omni_rt.h"), []byte("test"), 0644)
+	os.WriteFile(filepath.Join(runtimeDir, "omni_rt_inline.h"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(binDir, "omnic"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(stdDir, "test.omni"), []byte("test"), 0644)
 	os.WriteFile(filepath.Join(examplesDir, "hello.omni"), []byte("test"), 0644)
@@ -0,0 +1,342 @@
+package passes
+
+import (
+	"strconv"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+// ParallelLoop is a counting loop whose iterations only interact through
+// reductions, so its index range can be split across threads (the runtime's
+// omni_parallel_for) with one private accumulator per reduction and range.
+type ParallelLoop struct {
+	Function string
+	// Header is the block ending in the loop's conditional branch.
+	Header string
+	// Index is the induction variable; it starts below Bound and only ever
+	// grows by Step.
+	Index mir.ValueID
+	Bound mir.Operand
+	Step  int64
+	// Reductions are the variables from outside the loop it updates, in
+	// order of first update.
+	Reductions []Reduction
+}
+
+// Reduction is a variable the loop only updates as v = v Op x, with x not
+// depending on v, and does not otherwise read.
+type Reduction struct {
+	Var mir.ValueID
+	Op  string
+}
+
+// reductionOps are the associative updates a split loop can recombine.
+// Subtraction accumulates like addition.
+var reductionOps = map[string]bool{
+	"add": true, "sub": true, "mul": true,
+	"bitand": true, "bitor": true, "bitxor": true,
+	"and": true, "or": true,
+}
+
+// parallelSafeOps are the instructions that neither have side effects nor
+// depend on earlier iterations except through assign.
+var parallelSafeOps = map[string]bool{
+	"const": true, "assign": true, "index": true, "member": true, "cast": true,
+	"add": true, "sub": true, "mul": true, "div": true, "mod": true, "neg": true, "not": true,
+	"and": true, "or": true, "bitand": true, "bitor": true, "bitxor": true, "bitnot": true,
+	"lshift": true, "rshift": true,
+	"cmp.eq": true, "cmp.neq": true, "cmp.lt": true, "cmp.lte": true, "cmp.gt": true, "cmp.gte": true,
+}
+
+// FindParallelLoops flags the loops of mod that could run in parallel. It
+// only analyses; no code is changed.
+//
+// A loop qualifies when its header compares an induction variable against a
+// loop-invariant bound, every path through the body leads back to the
+// header, the body makes no calls and has no other side effects, the
+// induction variable is only stepped by a positive constant, and every other
+// outside variable the body assigns is a reduction. Floating-point updates
+// are not treated as reductions, since regrouping them changes the result.
+func FindParallelLoops(mod *mir.Module) []ParallelLoop {
+	if mod == nil {
+		return nil
+	}
+	var loops []ParallelLoop
+	for _, fn := range mod.Functions {
+		loops = append(loops, findParallelLoops(fn)...)
+	}
+	return loops
+}
+
+func findParallelLoops(fn *mir.Function) []ParallelLoop {
+	blocks := make(map[string]*mir.BasicBlock, len(fn.Blocks))
+	defs := make(map[mir.ValueID]*mir.Instruction)
+	defBlock := make(map[mir.ValueID]string)
+	assigned := make(map[mir.ValueID]bool)
+	preds := make(map[string]int)
+	for _, block := range fn.Blocks {
+		blocks[block.Name] = block
+		for i := range block.Instructions {
+			inst := &block.Instructions[i]
+			if inst.Op == "assign" && len(inst.Operands) == 2 && inst.Operands[0].Kind == mir.OperandValue {
+				assigned[inst.Operands[0].Value] = true
+				continue
+			}
+			if _, seen := defs[inst.ID]; !seen && inst.ID != mir.InvalidValue {
+				defs[inst.ID] = inst
+				defBlock[inst.ID] = block.Name
+			}
+		}
+		for _, target := range branchTargets(block.Terminator) {
+			preds[target]++
+		}
+	}
+
+	var loops []ParallelLoop
+	for _, header := range fn.Blocks {
+		term := header.Terminator
+		if term.Op != "cbr" || len(term.Operands) != 3 || term.Operands[0].Kind != mir.OperandValue {
+			continue
+		}
+		cond, ok := defs[term.Operands[0].Value]
+		if !ok || defBlock[cond.ID] != header.Name || (cond.Op != "cmp.lt" && cond.Op != "cmp.lte") || len(cond.Operands) != 2 {
+			continue
+		}
+		index, bound := cond.Operands[0], cond.Operands[1]
+		if index.Kind != mir.OperandValue || !assigned[index.Value] {
+			continue
+		}
+		if bound.Kind == mir.OperandValue {
+			// Invariant: never reassigned, and if computed in the header
+			// then only from constants or an array's length
+			def, ok := defs[bound.Value]
+			if assigned[bound.Value] || (ok && defBlock[bound.Value] == header.Name && def.Op != "const" && !isLenCall(def)) {
+				continue
+			}
+		}
+		body := term.Operands[1].Literal
+		if preds[body] != 1 {
+			continue
+		}
+		region, ok := loopRegion(blocks, header.Name, body, term.Operands[2].Literal)
+		if !ok {
+			continue
+		}
+		if loop, ok := analyseLoop(fn, header, region, defs, defBlock, index.Value); ok {
+			loop.Bound = bound
+			loops = append(loops, loop)
+		}
+	}
+	return loops
+}
+
+// loopRegion collects the blocks reachable from body without passing the
+// header. It fails if any of them leaves the loop.
+func loopRegion(blocks map[string]*mir.BasicBlock, header, body, exit string) (map[string]bool, bool) {
+	region := map[string]bool{}
+	work := []string{body}
+	for len(work) > 0 {
+		name := work[len(work)-1]
+		work = work[:len(work)-1]
+		if name == header || region[name] {
+			continue
+		}
+		block, ok := blocks[name]
+		if !ok || name == exit {
+			return nil, false
+		}
+		term := block.Terminator
+		if term.Op != "br" && term.Op != "cbr" {
+			return nil, false // ret, throw, ...
+		}
+		region[name] = true
+		work = append(work, branchTargets(term)...)
+	}
+	return region, true
+}
+
+func analyseLoop(fn *mir.Function, header *mir.BasicBlock, region map[string]bool,
+	defs map[mir.ValueID]*mir.Instruction, defBlock map[mir.ValueID]string, index mir.ValueID) (ParallelLoop, bool) {
+	loop := ParallelLoop{Function: fn.Name, Header: header.Name, Index: index}
+	inLoop := func(v mir.ValueID) bool {
+		block, ok := defBlock[v]
+		return ok && (region[block] || block == header.Name)
+	}
+	// Every iteration must pass the single block that branches back
+	latch := ""
+	for _, block := range fn.Blocks {
+		if !region[block.Name] {
+			continue
+		}
+		for _, target := range branchTargets(block.Terminator) {
+			if target != header.Name {
+				continue
+			}
+			if latch != "" && latch != block.Name {
+				return loop, false
+			}
+			latch = block.Name
+		}
+	}
+	reductionOf := make(map[mir.ValueID]string)
+	// Values computed by a reduction update, which may feed only its assign
+	updates := make(map[mir.ValueID]mir.ValueID)
+
+	for _, block := range fn.Blocks {
+		if !region[block.Name] && block.Name != header.Name {
+			continue
+		}
+		for i := range block.Instructions {
+			inst := &block.Instructions[i]
+			if !parallelSafeOps[inst.Op] && !isLenCall(inst) {
+				return loop, false
+			}
+			if inst.Op != "assign" || len(inst.Operands) != 2 || inst.Operands[0].Kind != mir.OperandValue {
+				continue
+			}
+			target, src := inst.Operands[0].Value, inst.Operands[1]
+			if inLoop(target) {
+				continue // Private to one iteration
+			}
+			if block.Name == header.Name {
+				return loop, false
+			}
+			if target == index {
+				// Stepped exactly once, on the way back to the header
+				step, ok := steppedBy(src, defs, index)
+				if !ok || loop.Step != 0 || block.Name != latch {
+					return loop, false
+				}
+				loop.Step = step
+				continue
+			}
+			if src.Kind != mir.OperandValue {
+				return loop, false
+			}
+			update, ok := defs[src.Value]
+			if !ok || !reductionOps[update.Op] || len(update.Operands) != 2 || isFloatType(update.Type) {
+				return loop, false
+			}
+			x, y := update.Operands[0], update.Operands[1]
+			if y.Kind == mir.OperandValue && y.Value == target && update.Op != "sub" {
+				x, y = y, x
+			}
+			if x.Kind != mir.OperandValue || x.Value != target || (y.Kind == mir.OperandValue && y.Value == target) {
+				return loop, false
+			}
+			if op, seen := reductionOf[target]; seen && op != update.Op && !(isSum(op) && isSum(update.Op)) {
+				return loop, false
+			}
+			if _, seen := reductionOf[target]; !seen {
+				loop.Reductions = append(loop.Reductions, Reduction{Var: target, Op: update.Op})
+			}
+			reductionOf[target] = update.Op
+			updates[update.ID] = target
+		}
+	}
+	if loop.Step <= 0 {
+		return loop, false
+	}
+
+	// A reduction variable may only be read by its own updates, and an
+	// update only by the assign that stores it
+	for _, block := range fn.Blocks {
+		if !region[block.Name] && block.Name != header.Name {
+			continue
+		}
+		for i := range block.Instructions {
+			inst := &block.Instructions[i]
+			for k, op := range inst.Operands {
+				if op.Kind != mir.OperandValue {
+					continue
+				}
+				if inst.Op == "assign" && k == 0 {
+					continue
+				}
+				if _, ok := reductionOf[op.Value]; ok {
+					if owner, isUpdate := updates[inst.ID]; !isUpdate || owner != op.Value {
+						return loop, false
+					}
+				}
+				if owner, ok := updates[op.Value]; ok {
+					if inst.Op != "assign" || inst.Operands[0].Value != owner {
+						return loop, false
+					}
+				}
+			}
+		}
+		for _, op := range block.Terminator.Operands {
+			if op.Kind != mir.OperandValue {
+				continue
+			}
+			if _, ok := reductionOf[op.Value]; ok {
+				return loop, false
+			}
+			if _, ok := updates[op.Value]; ok {
+				return loop, false
+			}
+		}
+	}
+	return loop, true
+}
+
+// steppedBy returns c when src computes index + c for a constant c
+func steppedBy(src mir.Operand, defs map[mir.ValueID]*mir.Instruction, index mir.ValueID) (int64, bool) {
+	if src.Kind != mir.OperandValue {
+		return 0, false
+	}
+	add, ok := defs[src.Value]
+	if !ok || add.Op != "add" || len(add.Operands) != 2 {
+		return 0, false
+	}
+	x, y := add.Operands[0], add.Operands[1]
+	if y.Kind == mir.OperandValue && y.Value == index {
+		x, y = y, x
+	}
+	if x.Kind != mir.OperandValue || x.Value != index {
+		return 0, false
+	}
+	lit := y.Literal
+	if y.Kind == mir.OperandValue {
+		c, ok := defs[y.Value]
+		if !ok || c.Op != "const" || len(c.Operands) != 1 {
+			return 0, false
+		}
+		lit = c.Operands[0].Literal
+	}
+	n, err := strconv.ParseInt(lit, 10, 64)
+	return n, err == nil
+}
+
+// isLenCall reports whether inst is a call of the len builtin
+func isLenCall(inst *mir.Instruction) bool {
+	return inst.Op == "call" && len(inst.Operands) == 2 &&
+		inst.Operands[0].Kind == mir.OperandLiteral && inst.Operands[0].Literal == "len"
+}
+
+func branchTargets(term mir.Terminator) []string {
+	var targets []string
+	switch term.Op {
+	case "br":
+		for _, op := range term.Operands {
+			if op.Kind == mir.OperandLiteral {
+				targets = append(targets, op.Literal)
+			}
+		}
+	case "cbr":
+		for _, op := range term.Operands[1:] {
+			if op.Kind == mir.OperandLiteral {
+				targets = append(targets, op.Literal)
+			}
+		}
+	}
+	return targets
+}
+
+func isSum(op string) bool {
+	return op == "add" || op == "sub"
+}
+
+func isFloatType(t string) bool {
+	return t == "float" || t == "double" || t == "f32" || t == "f64"
+}
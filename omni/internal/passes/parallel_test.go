@@ -0,0 +1,212 @@
+package passes
+
+import (
+	"testing"
+
+	"github.com/omni-lang/omni/internal/mir"
+)
+
+func val(id mir.ValueID) mir.Operand {
+	return mir.Operand{Kind: mir.OperandValue, Value: id, Type: "int"}
+}
+
+func lit(s string) mir.Operand {
+	return mir.Operand{Kind: mir.OperandLiteral, Literal: s}
+}
+
+func inst(id mir.ValueID, op, typ string, operands ...mir.Operand) mir.Instruction {
+	return mir.Instruction{ID: id, Op: op, Type: typ, Operands: operands}
+}
+
+func constInst(id mir.ValueID, value string) mir.Instruction {
+	return inst(id, "const", "int", mir.Operand{Kind: mir.OperandLiteral, Literal: value, Type: "int"})
+}
+
+// sumLoop builds the MIR of
+//
+//	func total(xs:array<int>, n:int):int {
+//	    var sum:int = 0
+//	    for i:int = 0; i < n; i++ { sum = sum + xs[i] * 2 }
+//	    return sum
+//	}
+//
+// with body, the instructions between the load of xs[i] (%5) and the step
+// of i, replaceable.
+func sumLoop(body ...mir.Instruction) *mir.Module {
+	if body == nil {
+		body = []mir.Instruction{
+			constInst(6, "2"),
+			inst(7, "mul", "int", val(5), val(6)),
+			inst(8, "add", "int", val(2), val(7)),
+			inst(9, "assign", "int", val(2), val(8)),
+		}
+	}
+	loopBody := append([]mir.Instruction{inst(5, "index", "int", val(0), val(3))}, body...)
+	loopBody = append(loopBody,
+		constInst(10, "1"),
+		inst(11, "add", "int", val(3), val(10)),
+		inst(12, "assign", "int", val(3), val(11)),
+	)
+	return &mir.Module{Functions: []*mir.Function{{
+		Name:       "total",
+		ReturnType: "int",
+		Params:     []mir.Param{{Name: "xs", Type: "array<int>", ID: 0}, {Name: "n", Type: "int", ID: 1}},
+		Blocks: []*mir.BasicBlock{
+			{
+				Name:         "entry",
+				Instructions: []mir.Instruction{constInst(2, "0"), constInst(3, "0")},
+				Terminator:   mir.Terminator{Op: "br", Operands: []mir.Operand{lit("loop_header_0")}},
+			},
+			{
+				Name:         "loop_header_0",
+				Instructions: []mir.Instruction{inst(4, "cmp.lt", "bool", val(3), val(1))},
+				Terminator:   mir.Terminator{Op: "cbr", Operands: []mir.Operand{val(4), lit("loop_body_1"), lit("loop_exit_2")}},
+			},
+			{
+				Name:         "loop_body_1",
+				Instructions: loopBody,
+				Terminator:   mir.Terminator{Op: "br", Operands: []mir.Operand{lit("loop_header_0")}},
+			},
+			{
+				Name:       "loop_exit_2",
+				Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{val(2)}},
+			},
+		},
+	}}}
+}
+
+func TestFindParallelLoopsFlagsSumLoop(t *testing.T) {
+	loops := FindParallelLoops(sumLoop())
+	if len(loops) != 1 {
+		t.Fatalf("expected 1 parallel loop, got %d", len(loops))
+	}
+	loop := loops[0]
+	if loop.Function != "total" || loop.Header != "loop_header_0" || loop.Index != 3 || loop.Step != 1 {
+		t.Errorf("unexpected loop %+v", loop)
+	}
+	if loop.Bound.Kind != mir.OperandValue || loop.Bound.Value != 1 {
+		t.Errorf("expected bound %%1, got %+v", loop.Bound)
+	}
+	if len(loop.Reductions) != 1 || loop.Reductions[0] != (Reduction{Var: 2, Op: "add"}) {
+		t.Errorf("expected sum to be an add reduction, got %+v", loop.Reductions)
+	}
+}
+
+func TestFindParallelLoopsFlagsConditionalReduction(t *testing.T) {
+	// while i < n { if i % 3 == 0 { c = c + 1 } i = i + 1 }
+	mod := &mir.Module{Functions: []*mir.Function{{
+		Name:       "count",
+		ReturnType: "int",
+		Params:     []mir.Param{{Name: "n", Type: "int", ID: 0}},
+		Blocks: []*mir.BasicBlock{
+			{
+				Name:         "entry",
+				Instructions: []mir.Instruction{constInst(1, "0"), constInst(2, "0")},
+				Terminator:   mir.Terminator{Op: "br", Operands: []mir.Operand{lit("while_header_0")}},
+			},
+			{
+				Name:         "while_header_0",
+				Instructions: []mir.Instruction{inst(3, "cmp.lt", "bool", val(2), val(0))},
+				Terminator:   mir.Terminator{Op: "cbr", Operands: []mir.Operand{val(3), lit("while_body_1"), lit("while_exit_2")}},
+			},
+			{
+				Name: "while_body_1",
+				Instructions: []mir.Instruction{
+					constInst(4, "3"),
+					inst(5, "mod", "int", val(2), val(4)),
+					constInst(6, "0"),
+					inst(7, "cmp.eq", "bool", val(5), val(6)),
+				},
+				Terminator: mir.Terminator{Op: "cbr", Operands: []mir.Operand{val(7), lit("then_3"), lit("merge_4")}},
+			},
+			{
+				Name:       "while_exit_2",
+				Terminator: mir.Terminator{Op: "ret", Operands: []mir.Operand{val(1)}},
+			},
+			{
+				Name: "then_3",
+				Instructions: []mir.Instruction{
+					constInst(8, "1"),
+					inst(9, "add", "int", val(1), val(8)),
+					inst(10, "assign", "int", val(1), val(9)),
+				},
+				Terminator: mir.Terminator{Op: "br", Operands: []mir.Operand{lit("merge_4")}},
+			},
+			{
+				Name: "merge_4",
+				Instructions: []mir.Instruction{
+					constInst(11, "1"),
+					inst(12, "add", "int", val(2), val(11)),
+					inst(13, "assign", "int", val(2), val(12)),
+				},
+				Terminator: mir.Terminator{Op: "br", Operands: []mir.Operand{lit("while_header_0")}},
+			},
+		},
+	}}}
+	loops := FindParallelLoops(mod)
+	if len(loops) != 1 || len(loops[0].Reductions) != 1 || loops[0].Reductions[0].Var != 1 {
+		t.Fatalf("expected the counting loop with reduction %%1, got %+v", loops)
+	}
+}
+
+func TestFindParallelLoopsRejectsDependentLoops(t *testing.T) {
+	tests := []struct {
+		name string
+		body []mir.Instruction
+	}{
+		{
+			"call in body",
+			[]mir.Instruction{inst(6, "call", "void", lit("std.io.println"), val(5))},
+		},
+		{
+			"last value carried out",
+			[]mir.Instruction{inst(6, "assign", "int", val(2), val(5))},
+		},
+		{
+			"reduction read outside its update",
+			[]mir.Instruction{
+				inst(6, "add", "int", val(2), val(5)),
+				inst(7, "assign", "int", val(2), val(6)),
+				inst(8, "mul", "int", val(2), val(5)),
+			},
+		},
+		{
+			"non-associative update",
+			[]mir.Instruction{
+				inst(6, "div", "int", val(2), val(5)),
+				inst(7, "assign", "int", val(2), val(6)),
+			},
+		},
+		{
+			"float accumulation",
+			[]mir.Instruction{
+				inst(6, "add", "float", val(2), val(5)),
+				inst(7, "assign", "float", val(2), val(6)),
+			},
+		},
+		{
+			"index stepped twice",
+			[]mir.Instruction{
+				constInst(6, "1"),
+				inst(7, "add", "int", val(3), val(6)),
+				inst(8, "assign", "int", val(3), val(7)),
+			},
+		},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			if loops := FindParallelLoops(sumLoop(tt.body...)); len(loops) != 0 {
+				t.Errorf("expected no parallel loops, got %+v", loops)
+			}
+		})
+	}
+}
+
+func TestFindParallelLoopsRejectsEarlyExit(t *testing.T) {
+	mod := sumLoop()
+	body := mod.Functions[0].Blocks[2]
+	body.Terminator = mir.Terminator{Op: "cbr", Operands: []mir.Operand{val(4), lit("loop_header_0"), lit("loop_exit_2")}}
+	if loops := FindParallelLoops(mod); len(loops) != 0 {
+		t.Errorf("a loop that can break out should not be flagged, got %+v", loops)
+	}
+}
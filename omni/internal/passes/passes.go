@@ -93,6 +93,12 @@ func verifyInstruction(inst mir.Instruction) error {
 			return fmt.Errorf("comparison/logical operation expects at least 2 operands, got %d", len(inst.Operands))
 		}
 		return nil
+	case "list.begin", "list.valid", "list.value", "list.next":
+		// Linked list cursor operations take the list or the cursor
+		if len(inst.Operands) != 1 {
+			return fmt.Errorf("%s expects 1 operand, got %d", inst.Op, len(inst.Operands))
+		}
+		return nil
 	case "phi":
 		// PHI nodes: should have even number of operands (value, block pairs)
 		if len(inst.Operands)%2 != 0 {
@@ -286,6 +286,8 @@ func (c *Checker) initBuiltins() {
 	c.knownTypes["array"] = struct{}{}
 	c.knownTypes["map"] = struct{}{}
 	c.knownTypes["Promise"] = struct{}{}
+	c.knownTypes["linked_list"] = struct{}{}
+	c.knownTypes["set"] = struct{}{}
 
 	// Add builtin functions
 	c.functions["len"] = FunctionSignature{
@@ -793,8 +795,10 @@ func (c *Checker) checkForStmt(stmt *ast.ForStmt) {
 			elementType = t
 		} else if _, v, ok := mapTypes(iterType); ok {
 			elementType = v
+		} else if t, ok := linkedListElementType(iterType); ok {
+			elementType = t
 		} else if iterType != typeError {
-			c.report(stmt.Iterable.Span(), "range expects array or map", "iterate over a supported collection type")
+			c.report(stmt.Iterable.Span(), "range expects array, map or linked list", "iterate over a supported collection type")
 		}
 		if stmt.Target != nil {
 			c.declare(stmt.Target.Name, elementType, false, stmt.Target.Span())
@@ -2143,6 +2147,14 @@ func arrayElementType(typ string) (string, bool) {
 	return "", false
 }
 
+func linkedListElementType(typ string) (string, bool) {
+	if strings.HasPrefix(typ, "linked_list<") && strings.HasSuffix(typ, ">") {
+		inner := typ[len("linked_list<") : len(typ)-1]
+		return strings.TrimSpace(inner), true
+	}
+	return "", false
+}
+
 func mapTypes(typ string) (string, string, bool) {
 	if !strings.HasPrefix(typ, "map<") || !strings.HasSuffix(typ, ">") {
 		return "", "", false
@@ -1086,6 +1086,14 @@ func TestForStmtVariants(t *testing.T) {
 			      for k in m { let y = k }
 			      }`,
 		},
+		{
+			name: "for range with linked list",
+			src: `func total(list: linked_list<int>): int {
+			      var sum: int = 0
+			      for x in list { sum = sum + x }
+			      return sum
+			      }`,
+		},
 		{
 			name: "for classic with all parts",
 			src: `func main(): void {
@@ -1933,3 +1941,16 @@ func TestErrorHandlingHelpers(t *testing.T) {
 		})
 	}
 }
+
+func TestSetTypeIsKnown(t *testing.T) {
+	src := `func members(a: set<int>, b: set<int>): set<int> {
+	      return a
+	      }`
+	mod, err := parseSource(t, src)
+	if err != nil {
+		t.Fatalf("parse failed: %v", err)
+	}
+	if err := checker.Check("test.omni", src, mod); err != nil {
+		t.Fatalf("set<int> should be a known type: %v", err)
+	}
+}
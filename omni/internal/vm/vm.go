@@ -1477,6 +1477,20 @@ func execIntrinsic(callee string, operands []mir.Operand, fr *frame) (Result, bo
 			return Result{Type: "bool", Value: success}, true
 		}
 		return Result{Type: "bool", Value: false}, true
+	case "std.log.set_mode":
+		// The VM logger writes synchronously; the mode is only validated
+		if len(operands) == 1 {
+			modeStr, err := toString(operandValue(fr, operands[0]))
+			if err == nil {
+				switch strings.ToLower(strings.TrimSpace(modeStr)) {
+				case "sync", "async", "async_drop":
+					return Result{Type: "bool", Value: true}, true
+				}
+			}
+		}
+		return Result{Type: "bool", Value: false}, true
+	case "std.log.flush":
+		return Result{Type: "void", Value: nil}, true
 	case "std.math.max":
 		if len(operands) == 2 {
 			left := operandValue(fr, operands[0])
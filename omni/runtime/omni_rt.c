@@ -0,0 +1,12936 @@
+// Enable POSIX and GNU extensions for functions like localtime_r, setenv, strdup, etc.
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "omni_rt.h"
+// The exported leaf functions share their bodies with the inline versions
+#define OMNI_RT_NO_INLINE
+#include "omni_rt_inline.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <math.h>
+#include <time.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <locale.h>
+#include <regex.h>
+// 16-wide SIMD compares used by the map's control-byte probing and the
+// string kernels; AVX2 string kernels are compiled per function and selected
+// at run time. OMNI_NO_SIMD disables all of it.
+#if !defined(OMNI_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define OMNI_HAVE_SSE2 1
+#if defined(__GNUC__)
+#include <immintrin.h>
+#define OMNI_HAVE_AVX2_DISPATCH 1
+#endif
+#elif !defined(OMNI_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OMNI_HAVE_NEON 1
+#endif
+// Acquire/release access for data published to lock-free readers
+#if defined(__GNUC__) || defined(__clang__)
+#define OMNI_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define OMNI_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define OMNI_LOAD_ACQUIRE(p) (*(p))
+#define OMNI_STORE_RELEASE(p, v) (*(p) = (v))
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <io.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define OMNI_HAVE_BACKTRACE 1
+#endif
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#endif
+#ifdef __APPLE__
+#include <sys/clonefile.h>
+#endif
+#endif
+
+// Test framework state
+static int32_t total_tests = 0;
+static int32_t passed_tests = 0;
+static int32_t current_test_passed = 1;
+
+// Logging state
+enum {
+    OMNI_LOG_LEVEL_DEBUG = 0,
+    OMNI_LOG_LEVEL_INFO = 1,
+    OMNI_LOG_LEVEL_WARN = 2,
+    OMNI_LOG_LEVEL_ERROR = 3,
+};
+
+static int32_t omni_current_log_level = OMNI_LOG_LEVEL_INFO;
+
+// Formats and writes one line; defined with the async logging backend
+static void omni_log_write(int32_t level, const char* level_name, const char* message);
+
+static int omni_equals_ignore_case(const char* a, const char* b) {
+    if (!a || !b) {
+        return 0;
+    }
+    while (*a && *b) {
+        unsigned char ca = (unsigned char)(*a);
+        unsigned char cb = (unsigned char)(*b);
+        ca = (unsigned char)tolower(ca);
+        cb = (unsigned char)tolower(cb);
+        if (ca != cb) {
+            return 0;
+        }
+        a++;
+        b++;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+void omni_log_debug(const char* message) {
+    omni_log_write(OMNI_LOG_LEVEL_DEBUG, "DEBUG", message);
+}
+
+void omni_log_info(const char* message) {
+    omni_log_write(OMNI_LOG_LEVEL_INFO, "INFO", message);
+}
+
+void omni_log_warn(const char* message) {
+    omni_log_write(OMNI_LOG_LEVEL_WARN, "WARN", message);
+}
+
+void omni_log_error(const char* message) {
+    omni_log_write(OMNI_LOG_LEVEL_ERROR, "ERROR", message);
+}
+
+int32_t omni_log_set_level(const char* level) {
+    if (!level) {
+        return 0;
+    }
+    if (omni_equals_ignore_case(level, "DEBUG")) {
+        omni_current_log_level = OMNI_LOG_LEVEL_DEBUG;
+        return 1;
+    }
+    if (omni_equals_ignore_case(level, "INFO")) {
+        omni_current_log_level = OMNI_LOG_LEVEL_INFO;
+        return 1;
+    }
+    if (omni_equals_ignore_case(level, "WARN") || omni_equals_ignore_case(level, "WARNING")) {
+        omni_current_log_level = OMNI_LOG_LEVEL_WARN;
+        return 1;
+    }
+    if (omni_equals_ignore_case(level, "ERROR") || omni_equals_ignore_case(level, "ERR")) {
+        omni_current_log_level = OMNI_LOG_LEVEL_ERROR;
+        return 1;
+    }
+    return 0;
+}
+
+void omni_print_string(const char* str) {
+    printf("%s", str);
+}
+
+void omni_println_string(const char* str) {
+    printf("%s\n", str);
+}
+
+// Memory management
+// Set once a profiling build registers its sites; defined with the profiler
+static int32_t omni_prof_count_allocs;
+static void omni_prof_note_alloc(size_t size);
+
+void* omni_alloc(size_t size) {
+    if (omni_prof_count_allocs) omni_prof_note_alloc(size);
+    return malloc(size);
+}
+
+void omni_free(void* ptr) {
+    free(ptr);
+}
+
+void* omni_malloc(size_t size) {
+    if (omni_prof_count_allocs) omni_prof_note_alloc(size);
+    return malloc(size);
+}
+
+void* omni_realloc(void* ptr, size_t new_size) {
+    return realloc(ptr, new_size);
+}
+
+// ============================================================================
+// Arena Allocator
+// ============================================================================
+
+// Bump allocator over a singly linked list of chunks. Allocation advances a
+// cursor inside the current chunk and moves on to the next chunk (allocating
+// one if needed) when it runs out. Rewinding only moves the cursor back, so
+// chunks are kept and reused by later allocations.
+
+#define OMNI_ARENA_DEFAULT_CHUNK (64 * 1024)
+#define OMNI_ARENA_ALIGN 16
+
+#ifdef _WIN32
+#define OMNI_THREAD_LOCAL __declspec(thread)
+#else
+#define OMNI_THREAD_LOCAL __thread
+#endif
+
+typedef struct omni_arena_chunk {
+    struct omni_arena_chunk* next;
+    size_t size;
+    unsigned char data[];
+} omni_arena_chunk_t;
+
+struct omni_arena {
+    omni_arena_chunk_t* head;    // First chunk (NULL until the first allocation)
+    omni_arena_chunk_t* current; // Chunk the cursor is in (NULL = before head)
+    size_t used;                 // Bytes used in `current`
+    size_t chunk_size;
+};
+
+omni_arena_t* omni_arena_create(size_t chunk_size) {
+    omni_arena_t* arena = (omni_arena_t*)calloc(1, sizeof(omni_arena_t));
+    if (!arena) return NULL;
+    arena->chunk_size = chunk_size ? chunk_size : OMNI_ARENA_DEFAULT_CHUNK;
+    return arena;
+}
+
+void* omni_arena_alloc(omni_arena_t* arena, size_t size) {
+    if (!arena) return malloc(size);
+    if (size > SIZE_MAX - OMNI_ARENA_ALIGN) return NULL;
+    size = (size + OMNI_ARENA_ALIGN - 1) & ~(size_t)(OMNI_ARENA_ALIGN - 1);
+    
+    omni_arena_chunk_t* chunk = arena->current;
+    if (chunk && chunk->size - arena->used >= size) {
+        void* ptr = chunk->data + arena->used;
+        arena->used += size;
+        return ptr;
+    }
+    
+    // Reuse a chunk kept from before the last rewind, if one is big enough
+    omni_arena_chunk_t* last = chunk;
+    for (chunk = chunk ? chunk->next : arena->head; chunk; chunk = chunk->next) {
+        last = chunk;
+        if (chunk->size >= size) {
+            arena->current = chunk;
+            arena->used = size;
+            return chunk->data;
+        }
+    }
+    
+    size_t chunk_bytes = size > arena->chunk_size ? size : arena->chunk_size;
+    chunk = (omni_arena_chunk_t*)malloc(sizeof(omni_arena_chunk_t) + chunk_bytes);
+    if (!chunk) return NULL;
+    chunk->next = NULL;
+    chunk->size = chunk_bytes;
+    if (last) {
+        last->next = chunk;
+    } else {
+        arena->head = chunk;
+    }
+    arena->current = chunk;
+    arena->used = size;
+    return chunk->data;
+}
+
+char* omni_arena_strdup(omni_arena_t* arena, const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    char* copy = (char*)omni_arena_alloc(arena, len + 1);
+    if (copy) memcpy(copy, str, len + 1);
+    return copy;
+}
+
+omni_arena_mark_t omni_arena_mark(omni_arena_t* arena) {
+    omni_arena_mark_t mark;
+    mark.chunk = arena ? arena->current : NULL;
+    mark.used = arena ? arena->used : 0;
+    return mark;
+}
+
+void omni_arena_rewind(omni_arena_t* arena, omni_arena_mark_t mark) {
+    if (!arena) return;
+    arena->current = (omni_arena_chunk_t*)mark.chunk;
+    arena->used = mark.used;
+}
+
+void omni_arena_reset(omni_arena_t* arena) {
+    if (!arena) return;
+    arena->current = NULL;
+    arena->used = 0;
+}
+
+void omni_arena_destroy(omni_arena_t* arena) {
+    if (!arena) return;
+    omni_arena_chunk_t* chunk = arena->head;
+    while (chunk) {
+        omni_arena_chunk_t* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+// Per-thread arena used by compiled code for function- and block-scoped
+// string temporaries. Scopes nest with the call stack: each function marks
+// on entry and rewinds before returning.
+static OMNI_THREAD_LOCAL omni_arena_t* omni_scratch_arena = NULL;
+
+omni_arena_t* omni_arena_scratch(void) {
+    if (!omni_scratch_arena) {
+        omni_scratch_arena = omni_arena_create(0);
+    }
+    return omni_scratch_arena;
+}
+
+// Length-prefixed strings
+#define OMNI_STR_ARENA 0x1u
+#define OMNI_STR_INTERNED 0x2u
+#define OMNI_STR_HEADER(s) ((omni_str_header_t*)((char*)(s) - sizeof(omni_str_header_t)))
+
+static void omni_str_header_init(omni_str_header_t* header, size_t len, uint32_t flags) {
+    header->len = len;
+    header->runes = -1;
+    header->hash = 0;
+    header->flags = flags;
+}
+
+// Allocates an omni_str of len bytes (plus terminator) for the caller to fill
+char* omni_str_alloc(omni_arena_t* arena, size_t len) {
+    if (len > SIZE_MAX - sizeof(omni_str_header_t) - 1) return NULL;
+    omni_str_header_t* header = (omni_str_header_t*)omni_arena_alloc(arena, sizeof(omni_str_header_t) + len + 1);
+    if (!header) return NULL;
+    omni_str_header_init(header, len, arena ? OMNI_STR_ARENA : 0);
+    char* data = (char*)(header + 1);
+    data[len] = '\0';
+    return data;
+}
+
+char* omni_str_new(omni_arena_t* arena, const char* data, size_t len) {
+    char* str = omni_str_alloc(arena, len);
+    if (str && len > 0) memcpy(str, data, len);
+    return str;
+}
+
+size_t omni_str_len(const char* s) {
+    if (!s) return 0;
+    return OMNI_STR_HEADER(s)->len;
+}
+
+static int32_t count_utf8_runes(const char* str, size_t len) {
+    int32_t runes = 0;
+    for (size_t i = 0; i < len; i++) {
+        // Count every byte that is not a continuation byte (10xxxxxx)
+        if (((unsigned char)str[i] & 0xC0) != 0x80) runes++;
+    }
+    return runes;
+}
+
+int32_t omni_str_rune_count(const char* s) {
+    if (!s) return 0;
+    omni_str_header_t* header = OMNI_STR_HEADER(s);
+    if (header->runes < 0) {
+        header->runes = count_utf8_runes(s, header->len);
+    }
+    return header->runes;
+}
+
+// Same djb2 hash as the map's hash_string over the string's bytes
+static uint32_t hash_bytes(const char* str, size_t len) {
+    uint32_t hash = 5381;
+    for (size_t i = 0; i < len; i++) {
+        hash = ((hash << 5) + hash) + (uint32_t)(int)str[i];
+    }
+    return hash;
+}
+
+uint32_t omni_str_hash(const char* s) {
+    if (!s) return 0;
+    omni_str_header_t* header = OMNI_STR_HEADER(s);
+    if (header->hash == 0 && !(header->flags & OMNI_STR_INTERNED)) {
+        header->hash = hash_bytes(s, header->len);
+    }
+    return header->hash;
+}
+
+int32_t omni_str_equals(const char* a, const char* b) {
+    if (a == b) return 1;
+    if (!a || !b) return 0;
+    omni_str_header_t* ha = OMNI_STR_HEADER(a);
+    omni_str_header_t* hb = OMNI_STR_HEADER(b);
+    // Distinct interned strings never compare equal
+    if (ha->flags & hb->flags & OMNI_STR_INTERNED) return 0;
+    if (ha->len != hb->len) return 0;
+    // Only compare hashes already computed; hashing here costs a full scan
+    if (ha->hash != 0 && hb->hash != 0 && ha->hash != hb->hash) return 0;
+    return memcmp(a, b, ha->len) == 0 ? 1 : 0;
+}
+
+void omni_str_free(const char* s) {
+    if (!s) return;
+    omni_str_header_t* header = OMNI_STR_HEADER(s);
+    // Arena strings are reclaimed with their arena (interned ones never are)
+    if (header->flags & OMNI_STR_ARENA) return;
+    free(header);
+}
+
+// String interning
+// Canonical strings are omni_strs allocated from a pool arena that is never
+// released, flagged OMNI_STR_INTERNED with their hash filled in, so two
+// interned strings are equal exactly when their pointers are. The pool holds
+// the program's constant map keys and field names, so it stays small.
+//
+// The table is open-addressed on the cached hash. Lookups take no lock: the
+// current table is published with a release store and slots are only ever
+// filled, never cleared. Inserts take the mutex; growing publishes a new
+// table and keeps the old one, since a reader may still be probing it (the
+// retired tables add up to less than the live one).
+#define OMNI_INTERN_MIN_CAPACITY 256
+
+typedef struct omni_intern_table {
+    struct omni_intern_table* retired;
+    size_t capacity;
+    size_t size;
+    const char* slots[];
+} omni_intern_table_t;
+
+static omni_intern_table_t* omni_intern_table = NULL;
+static omni_arena_t* omni_intern_arena = NULL;
+
+#ifdef _WIN32
+static CRITICAL_SECTION omni_intern_mutex;
+static int omni_intern_mutex_initialized = 0;
+#else
+static pthread_mutex_t omni_intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void omni_intern_lock(void) {
+#ifdef _WIN32
+    if (!omni_intern_mutex_initialized) {
+        InitializeCriticalSection(&omni_intern_mutex);
+        omni_intern_mutex_initialized = 1;
+    }
+    EnterCriticalSection(&omni_intern_mutex);
+#else
+    pthread_mutex_lock(&omni_intern_mutex);
+#endif
+}
+
+static void omni_intern_unlock(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&omni_intern_mutex);
+#else
+    pthread_mutex_unlock(&omni_intern_mutex);
+#endif
+}
+
+static omni_intern_table_t* omni_intern_grow(omni_intern_table_t* table) {
+    size_t new_capacity = table ? table->capacity * 2 : OMNI_INTERN_MIN_CAPACITY;
+    omni_intern_table_t* grown = (omni_intern_table_t*)calloc(1, sizeof(omni_intern_table_t) + new_capacity * sizeof(const char*));
+    if (!grown) return NULL;
+    grown->retired = table;
+    grown->capacity = new_capacity;
+    if (table) {
+        for (size_t i = 0; i < table->capacity; i++) {
+            const char* s = table->slots[i];
+            if (!s) continue;
+            size_t j = OMNI_STR_HEADER(s)->hash & (new_capacity - 1);
+            while (grown->slots[j]) j = (j + 1) & (new_capacity - 1);
+            grown->slots[j] = s;
+        }
+        grown->size = table->size;
+    }
+    OMNI_STORE_RELEASE(&omni_intern_table, grown);
+    return grown;
+}
+
+// Probes table for the canonical copy of str[0..len) with the given hash
+static const char* omni_intern_probe(const omni_intern_table_t* table, const char* str, size_t len, uint32_t hash) {
+    if (!table) return NULL;
+    size_t i = hash & (table->capacity - 1);
+    const char* s;
+    while ((s = OMNI_LOAD_ACQUIRE(&table->slots[i])) != NULL) {
+        omni_str_header_t* header = OMNI_STR_HEADER(s);
+        if (header->hash == hash && header->len == len && memcmp(s, str, len) == 0) {
+            return s;
+        }
+        i = (i + 1) & (table->capacity - 1);
+    }
+    return NULL;
+}
+
+// Finds (or, when insert is set, adds) the canonical copy of str[0..len)
+// whose djb2 hash the caller already knows
+static const char* omni_intern_find(const char* str, size_t len, uint32_t hash, int insert) {
+    const char* result = omni_intern_probe(OMNI_LOAD_ACQUIRE(&omni_intern_table), str, len, hash);
+    if (result || !insert) return result;
+
+    omni_intern_lock();
+    omni_intern_table_t* table = omni_intern_table;
+    // Another thread may have added it since the probe
+    result = omni_intern_probe(table, str, len, hash);
+    if (!result) {
+        // Keep the load factor at or below 1/2
+        if (!table || (table->size + 1) * 2 > table->capacity) {
+            table = omni_intern_grow(table);
+        }
+        if (!omni_intern_arena) omni_intern_arena = omni_arena_create(0);
+        char* copy = table && omni_intern_arena ? omni_str_new(omni_intern_arena, str, len) : NULL;
+        if (copy) {
+            omni_str_header_t* header = OMNI_STR_HEADER(copy);
+            header->hash = hash;
+            header->flags |= OMNI_STR_INTERNED;
+            size_t i = hash & (table->capacity - 1);
+            while (table->slots[i]) i = (i + 1) & (table->capacity - 1);
+            OMNI_STORE_RELEASE(&table->slots[i], (const char*)copy);
+            table->size++;
+        }
+        result = copy;
+    }
+    omni_intern_unlock();
+    return result;
+}
+
+const char* omni_intern(const char* str) {
+    if (!str) return NULL;
+    return omni_intern_len(str, strlen(str));
+}
+
+const char* omni_intern_len(const char* str, size_t len) {
+    if (!str) return NULL;
+    return omni_intern_find(str, len, hash_bytes(str, len), 1);
+}
+
+const char* omni_intern_lookup(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    return omni_intern_find(str, len, hash_bytes(str, len), 0);
+}
+
+int32_t omni_is_interned(const char* str) {
+    if (!str) return 0;
+    // Only interned strings can be found at their own address in the pool
+    size_t len = strlen(str);
+    return omni_intern_find(str, len, hash_bytes(str, len), 0) == str ? 1 : 0;
+}
+
+// SIMD string kernels
+//
+// The hot string primitives (search, case conversion, classification,
+// escaping, base64) are built on the kernels below. Each works through the
+// input 16 bytes at a time with SSE2 or NEON, 32 at a time with AVX2 when the
+// CPU has it (checked once, at first use), and finishes with a scalar loop,
+// which is the whole implementation on other targets. Defining OMNI_NO_SIMD
+// forces the scalar paths.
+
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+#define OMNI_TARGET_AVX2 __attribute__((target("avx2")))
+
+static int omni_cpu_avx2 = -1;
+
+static int omni_has_avx2(void) {
+    int has = OMNI_LOAD_ACQUIRE(&omni_cpu_avx2);
+    if (has < 0) {
+        __builtin_cpu_init();
+        has = __builtin_cpu_supports("avx2") ? 1 : 0;
+        OMNI_STORE_RELEASE(&omni_cpu_avx2, has);
+    }
+    return has;
+}
+#endif
+
+#if defined(OMNI_HAVE_NEON)
+// One nibble per byte of a comparison result; the first set byte is at
+// ctz / 4
+static uint64_t omni_neon_nibble_mask(uint8x16_t lanes) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(lanes), 4)), 0);
+}
+#endif
+
+// Byte classes searched for by omni_scan
+enum {
+    OMNI_SCAN_NON_ASCII = 0, // >= 0x80
+    OMNI_SCAN_NON_DIGIT = 1, // outside '0'..'9'
+    OMNI_SCAN_JSON = 2,      // escaped in JSON strings: '"', '\\' and < 0x20
+    OMNI_SCAN_HTML = 3,      // escaped in HTML: & < > " '
+};
+
+static int omni_scan_hit(unsigned char c, int kind) {
+    switch (kind) {
+        case OMNI_SCAN_NON_ASCII: return c >= 0x80;
+        case OMNI_SCAN_NON_DIGIT: return c < '0' || c > '9';
+        case OMNI_SCAN_JSON: return c < 0x20 || c == '"' || c == '\\';
+        default: return c == '&' || c == '<' || c == '>' || c == '"' || c == '\'';
+    }
+}
+
+#if defined(OMNI_HAVE_SSE2)
+static uint32_t omni_scan_sse2(__m128i v, int kind) {
+    __m128i hits;
+    switch (kind) {
+        case OMNI_SCAN_NON_ASCII:
+            return (uint32_t)_mm_movemask_epi8(v);
+        case OMNI_SCAN_NON_DIGIT: {
+            __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+            __m128i digits = _mm_cmpeq_epi8(_mm_max_epu8(d, _mm_set1_epi8(9)), _mm_set1_epi8(9));
+            return (uint32_t)_mm_movemask_epi8(digits) ^ 0xFFFFu;
+        }
+        case OMNI_SCAN_JSON:
+            hits = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1F)), v);
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+            return (uint32_t)_mm_movemask_epi8(hits);
+        default:
+            hits = _mm_cmpeq_epi8(v, _mm_set1_epi8('&'));
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8('<')));
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8('>')));
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8('\'')));
+            return (uint32_t)_mm_movemask_epi8(hits);
+    }
+}
+#elif defined(OMNI_HAVE_NEON)
+static uint8x16_t omni_scan_neon(uint8x16_t v, int kind) {
+    uint8x16_t hits;
+    switch (kind) {
+        case OMNI_SCAN_NON_ASCII:
+            return vcgeq_u8(v, vdupq_n_u8(0x80));
+        case OMNI_SCAN_NON_DIGIT:
+            return vcgtq_u8(vsubq_u8(v, vdupq_n_u8('0')), vdupq_n_u8(9));
+        case OMNI_SCAN_JSON:
+            hits = vcltq_u8(v, vdupq_n_u8(0x20));
+            hits = vorrq_u8(hits, vceqq_u8(v, vdupq_n_u8('"')));
+            return vorrq_u8(hits, vceqq_u8(v, vdupq_n_u8('\\')));
+        default:
+            hits = vceqq_u8(v, vdupq_n_u8('&'));
+            hits = vorrq_u8(hits, vceqq_u8(v, vdupq_n_u8('<')));
+            hits = vorrq_u8(hits, vceqq_u8(v, vdupq_n_u8('>')));
+            hits = vorrq_u8(hits, vceqq_u8(v, vdupq_n_u8('"')));
+            return vorrq_u8(hits, vceqq_u8(v, vdupq_n_u8('\'')));
+    }
+}
+#endif
+
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+static OMNI_TARGET_AVX2 uint32_t omni_scan_avx2_mask(__m256i v, int kind) {
+    __m256i hits;
+    switch (kind) {
+        case OMNI_SCAN_NON_ASCII:
+            return (uint32_t)_mm256_movemask_epi8(v);
+        case OMNI_SCAN_NON_DIGIT: {
+            __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+            __m256i digits = _mm256_cmpeq_epi8(_mm256_max_epu8(d, _mm256_set1_epi8(9)), _mm256_set1_epi8(9));
+            return ~(uint32_t)_mm256_movemask_epi8(digits);
+        }
+        case OMNI_SCAN_JSON:
+            hits = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1F)), v);
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+            return (uint32_t)_mm256_movemask_epi8(hits);
+        default:
+            hits = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('&'));
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<')));
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')));
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')));
+            return (uint32_t)_mm256_movemask_epi8(hits);
+    }
+}
+
+// Returns the first hit in the whole 32-byte blocks, or where they end
+static OMNI_TARGET_AVX2 size_t omni_scan_avx2(const unsigned char* p, size_t len, int kind) {
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        uint32_t mask = omni_scan_avx2_mask(_mm256_loadu_si256((const __m256i*)(p + i)), kind);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    return i;
+}
+#endif
+
+// Returns the index of the first byte of s[0, len) in class kind, or len
+static size_t omni_scan(const char* s, size_t len, int kind) {
+    const unsigned char* p = (const unsigned char*)s;
+    size_t i = 0;
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+    if (len >= 32 && omni_has_avx2()) i = omni_scan_avx2(p, len, kind);
+#endif
+#if defined(OMNI_HAVE_SSE2)
+    for (; i + 16 <= len; i += 16) {
+        uint32_t mask = omni_scan_sse2(_mm_loadu_si128((const __m128i*)(p + i)), kind);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+#elif defined(OMNI_HAVE_NEON)
+    for (; i + 16 <= len; i += 16) {
+        uint64_t mask = omni_neon_nibble_mask(omni_scan_neon(vld1q_u8(p + i), kind));
+        if (mask) return i + (size_t)(__builtin_ctzll(mask) >> 2);
+    }
+#endif
+    for (; i < len; i++) {
+        if (omni_scan_hit(p[i], kind)) return i;
+    }
+    return len;
+}
+
+// ASCII case conversion: bytes in [from, from + 26) get bit 0x20 flipped,
+// where from is 'a' to convert to upper case and 'A' to lower case
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+static OMNI_TARGET_AVX2 size_t omni_ascii_case_avx2(char* dst, const char* src, size_t len, char from) {
+    // Shift the range onto [-128, -102) so one signed compare selects it
+    const __m256i shift = _mm256_set1_epi8((char)(0x80 - from));
+    const __m256i bound = _mm256_set1_epi8((char)(-128 + 26));
+    const __m256i flip = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i in_range = _mm256_cmpgt_epi8(bound, _mm256_add_epi8(v, shift));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(v, _mm256_and_si256(in_range, flip)));
+    }
+    return i;
+}
+#endif
+
+static void omni_ascii_case(char* dst, const char* src, size_t len, int upper) {
+    const char from = upper ? 'a' : 'A';
+    size_t i = 0;
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+    if (len >= 32 && omni_has_avx2()) i = omni_ascii_case_avx2(dst, src, len, from);
+#endif
+#if defined(OMNI_HAVE_SSE2)
+    const __m128i shift = _mm_set1_epi8((char)(0x80 - from));
+    const __m128i bound = _mm_set1_epi8((char)(-128 + 26));
+    const __m128i flip = _mm_set1_epi8(0x20);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i in_range = _mm_cmplt_epi8(_mm_add_epi8(v, shift), bound);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(v, _mm_and_si128(in_range, flip)));
+    }
+#elif defined(OMNI_HAVE_NEON)
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t*)src + i);
+        uint8x16_t in_range = vcltq_u8(vsubq_u8(v, vdupq_n_u8((uint8_t)from)), vdupq_n_u8(26));
+        vst1q_u8((uint8_t*)dst + i, veorq_u8(v, vandq_u8(in_range, vdupq_n_u8(0x20))));
+    }
+#endif
+    for (; i < len; i++) {
+        unsigned char c = (unsigned char)src[i];
+        dst[i] = (char)((unsigned)(c - (unsigned char)from) < 26u ? c ^ 0x20 : c);
+    }
+}
+
+// Substring search: candidate positions are those where both the first and
+// the last byte of the needle match, which rules out nearly every position
+// 16 or 32 at a time; only candidates are compared in full
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+static OMNI_TARGET_AVX2 int64_t omni_find_avx2(const char* h, size_t hl, const char* n, size_t nl, size_t* next) {
+    const size_t last = nl - 1;
+    const __m256i first_byte = _mm256_set1_epi8(n[0]);
+    const __m256i last_byte = _mm256_set1_epi8(n[last]);
+    size_t i = 0;
+    // Two blocks per step while no candidate turns up
+    for (; i + last + 64 <= hl; i += 64) {
+        __m256i lo = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h + i)), first_byte),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h + i + last)), last_byte));
+        __m256i hi = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h + i + 32)), first_byte),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h + i + 32 + last)), last_byte));
+        __m256i any = _mm256_or_si256(lo, hi);
+        if (!_mm256_testz_si256(any, any)) break;
+    }
+    for (; i + last + 32 <= hl; i += 32) {
+        __m256i block_first = _mm256_loadu_si256((const __m256i*)(h + i));
+        __m256i block_last = _mm256_loadu_si256((const __m256i*)(h + i + last));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(block_first, first_byte), _mm256_cmpeq_epi8(block_last, last_byte)));
+        while (mask) {
+            size_t pos = i + (size_t)__builtin_ctz(mask);
+            if (memcmp(h + pos + 1, n + 1, nl - 2) == 0) return (int64_t)pos;
+            mask &= mask - 1;
+        }
+    }
+    *next = i;
+    return -1;
+}
+#endif
+
+// Returns the offset of the first occurrence of n in h, or -1
+static int64_t omni_find(const char* h, size_t hl, const char* n, size_t nl) {
+    if (nl == 0) return 0;
+    if (nl > hl) return -1;
+    if (nl == 1) {
+        const char* p = (const char*)memchr(h, n[0], hl);
+        return p ? (int64_t)(p - h) : -1;
+    }
+    size_t i = 0;
+#if defined(OMNI_HAVE_SSE2) || defined(OMNI_HAVE_NEON)
+    const size_t last = nl - 1;
+#endif
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+    if (hl - last >= 32 && omni_has_avx2()) {
+        int64_t found = omni_find_avx2(h, hl, n, nl, &i);
+        if (found >= 0) return found;
+    }
+#endif
+#if defined(OMNI_HAVE_SSE2)
+    const __m128i first_byte = _mm_set1_epi8(n[0]);
+    const __m128i last_byte = _mm_set1_epi8(n[last]);
+    for (; i + last + 16 <= hl; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i*)(h + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i*)(h + i + last));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(block_first, first_byte), _mm_cmpeq_epi8(block_last, last_byte)));
+        while (mask) {
+            size_t pos = i + (size_t)__builtin_ctz(mask);
+            if (memcmp(h + pos + 1, n + 1, nl - 2) == 0) return (int64_t)pos;
+            mask &= mask - 1;
+        }
+    }
+#elif defined(OMNI_HAVE_NEON)
+    const uint8x16_t first_byte = vdupq_n_u8((uint8_t)n[0]);
+    const uint8x16_t last_byte = vdupq_n_u8((uint8_t)n[last]);
+    for (; i + last + 16 <= hl; i += 16) {
+        uint8x16_t block_first = vld1q_u8((const uint8_t*)h + i);
+        uint8x16_t block_last = vld1q_u8((const uint8_t*)h + i + last);
+        uint64_t mask = omni_neon_nibble_mask(vandq_u8(
+            vceqq_u8(block_first, first_byte), vceqq_u8(block_last, last_byte)));
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctzll(mask);
+            size_t pos = i + (bit >> 2);
+            if (memcmp(h + pos + 1, n + 1, nl - 2) == 0) return (int64_t)pos;
+            mask &= ~(0xFull << (bit & ~3u));
+        }
+    }
+#endif
+    // memchr skips to each candidate first byte
+    while (i + nl <= hl) {
+        const char* p = (const char*)memchr(h + i, n[0], hl - nl + 1 - i);
+        if (!p) return -1;
+        i = (size_t)(p - h);
+        if (memcmp(p + 1, n + 1, nl - 1) == 0) return (int64_t)i;
+        i++;
+    }
+    return -1;
+}
+
+// Base64 (standard alphabet, with padding)
+static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int base64_char_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+// 24 input bytes to 32 characters per step, after Mula and Lemire, "Faster
+// Base64 Encoding and Decoding using AVX2 Instructions"
+static OMNI_TARGET_AVX2 void omni_base64_encode_avx2(char* dst, const unsigned char* src, size_t len, size_t* in, size_t* out) {
+    size_t i = 0, j = 0;
+    for (; i + 28 <= len; i += 24, j += 32) {
+        // 12 input bytes in each lane, every 3 spread over a 32-bit word
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(src + i))),
+            _mm_loadu_si128((const __m128i*)(src + i + 12)), 1);
+        v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+        // Move each 6-bit group into its own byte
+        __m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+        __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+        __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(t1, t3);
+        // Map 0..63 onto the alphabet by adding a per-range offset
+        __m256i ranges = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        ranges = _mm256_sub_epi8(ranges, _mm256_cmpgt_epi8(indices, _mm256_set1_epi8(25)));
+        const __m256i offsets = _mm256_setr_epi8(
+            65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+            65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+        __m256i chars = _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, ranges));
+        _mm256_storeu_si256((__m256i*)(dst + j), chars);
+    }
+    *in = i;
+    *out = j;
+}
+
+// 32 characters to 24 bytes per step; stops at the first block holding a
+// character outside the alphabet and leaves it to the scalar loop
+static OMNI_TARGET_AVX2 void omni_base64_decode_avx2(unsigned char* dst, size_t cap, const char* src, size_t len, size_t* in, size_t* out) {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+    size_t i = 0, j = 0;
+    // Each step stores 32 bytes, 24 of them valid
+    for (; i + 32 <= len && j + 32 <= cap; i += 32, j += 24) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask_2f);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(v, mask_2f));
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        if (!_mm256_testz_si256(lo, hi)) break;
+        __m256i eq_2f = _mm256_cmpeq_epi8(v, mask_2f);
+        v = _mm256_add_epi8(v, _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles)));
+        // Pack four 6-bit values into each 24-bit group, then the groups together
+        __m256i merged = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        merged = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+        _mm256_storeu_si256((__m256i*)(dst + j), merged);
+    }
+    *in = i;
+    *out = j;
+}
+#endif
+
+// Encodes len bytes of src into dst, which must have room for
+// ((len + 2) / 3) * 4 characters; returns the number written
+static size_t omni_base64_encode(char* dst, const unsigned char* src, size_t len) {
+    size_t i = 0, j = 0;
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+    if (len >= 28 && omni_has_avx2()) omni_base64_encode_avx2(dst, src, len, &i, &j);
+#endif
+    for (; i + 3 <= len; i += 3) {
+        uint32_t v = ((uint32_t)src[i] << 16) | ((uint32_t)src[i + 1] << 8) | src[i + 2];
+        dst[j++] = base64_chars[v >> 18];
+        dst[j++] = base64_chars[(v >> 12) & 0x3F];
+        dst[j++] = base64_chars[(v >> 6) & 0x3F];
+        dst[j++] = base64_chars[v & 0x3F];
+    }
+    if (i < len) {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)src[i + 1] << 8;
+        dst[j++] = base64_chars[v >> 18];
+        dst[j++] = base64_chars[(v >> 12) & 0x3F];
+        dst[j++] = (i + 1 < len) ? base64_chars[(v >> 6) & 0x3F] : '=';
+        dst[j++] = '=';
+    }
+    return j;
+}
+
+// Decodes the len characters of src (padding already stripped) into dst,
+// which has room for cap bytes; returns the number of bytes written, or -1 if
+// src is not valid base64
+static int64_t omni_base64_decode(unsigned char* dst, size_t cap, const char* src, size_t len) {
+    if (len % 4 == 1) return -1;
+    size_t i = 0, j = 0;
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+    if (len >= 32 && omni_has_avx2()) omni_base64_decode_avx2(dst, cap, src, len, &i, &j);
+#else
+    (void)cap;
+#endif
+    for (; i + 4 <= len; i += 4) {
+        int v1 = base64_char_value(src[i]);
+        int v2 = base64_char_value(src[i + 1]);
+        int v3 = base64_char_value(src[i + 2]);
+        int v4 = base64_char_value(src[i + 3]);
+        if (v1 < 0 || v2 < 0 || v3 < 0 || v4 < 0) return -1;
+        dst[j++] = (unsigned char)((v1 << 2) | (v2 >> 4));
+        dst[j++] = (unsigned char)(((v2 & 0xF) << 4) | (v3 >> 2));
+        dst[j++] = (unsigned char)(((v3 & 0x3) << 6) | v4);
+    }
+    if (i < len) {
+        // Two or three characters left: one or two bytes
+        int v1 = base64_char_value(src[i]);
+        int v2 = base64_char_value(src[i + 1]);
+        if (v1 < 0 || v2 < 0) return -1;
+        dst[j++] = (unsigned char)((v1 << 2) | (v2 >> 4));
+        if (i + 2 < len) {
+            int v3 = base64_char_value(src[i + 2]);
+            if (v3 < 0) return -1;
+            dst[j++] = (unsigned char)(((v2 & 0xF) << 4) | (v3 >> 2));
+        }
+    }
+    return (int64_t)j;
+}
+
+// String operations
+// NOTE: Returns a newly allocated omni_str - caller must free it using omni_str_free()
+// This function allocates memory that must be freed by the caller to avoid leaks.
+char* omni_strcat(const char* str1, const char* str2) {
+    return omni_strcat_arena(NULL, str1, str2);
+}
+
+char* omni_strcat_arena(omni_arena_t* arena, const char* str1, const char* str2) {
+    return omni_strcat_len(arena, str1, strlen(str1), str2, strlen(str2));
+}
+
+char* omni_strcat_len(omni_arena_t* arena, const char* str1, size_t len1, const char* str2, size_t len2) {
+    if (len1 > SIZE_MAX / 2 || len2 > SIZE_MAX / 2) return NULL;
+    char* result = omni_str_alloc(arena, len1 + len2);
+    if (result) {
+        memcpy(result, str1, len1);
+        memcpy(result + len1, str2, len2);
+    }
+    return result;
+}
+
+int32_t omni_strlen(const char* str) {
+    return omni_inline_strlen(str);
+}
+
+// Helper function to find the start of the next UTF-8 rune. Stops at end,
+// since the string may be a view that is not NUL-terminated.
+static const char* next_utf8_rune(const char* str, const char* end) {
+    if (!str) return str;
+    // Skip continuation bytes (0x80-0xBF)
+    while (str < end && (*str & 0xC0) == 0x80) {
+        str++;
+    }
+    return str;
+}
+
+// Helper function to find the start of the previous UTF-8 rune
+static const char* __attribute__((unused)) prev_utf8_rune(const char* str, const char* start) {
+    if (!str || str <= start) return start;
+    str--;
+    // Skip continuation bytes backwards
+    while (str > start && (*str & 0xC0) == 0x80) {
+        str--;
+    }
+    return str;
+}
+
+// NOTE: Returns a newly allocated string - caller must free it using free()
+// This function allocates memory that must be freed by the caller to avoid leaks.
+// WARNING: This function treats start/end as byte indices, not rune indices.
+// For proper UTF-8 support, indices should be rune-based, but that requires
+// counting runes which is O(n). This implementation at least ensures we don't
+// split in the middle of a multi-byte character.
+char* omni_substring(const char* str, int32_t start, int32_t end) {
+    return omni_substring_arena(NULL, str, start, end);
+}
+
+char* omni_substring_arena(omni_arena_t* arena, const char* str, int32_t start, int32_t end) {
+    return omni_substring_len(arena, str, str ? strlen(str) : 0, start, end);
+}
+
+char* omni_substring_len(omni_arena_t* arena, const char* str, size_t str_len, int32_t start, int32_t end) {
+    if (!str || start < 0 || end < start) {
+        return omni_str_alloc(arena, 0);
+    }
+    
+    int32_t len = (int32_t)str_len;
+    if (start >= len) {
+        return omni_str_alloc(arena, 0);
+    }
+    
+    if (end > len) {
+        end = len;
+    }
+    
+    // Ensure we start at a valid UTF-8 boundary
+    const char* start_ptr = str + start;
+    if (start > 0) {
+        start_ptr = next_utf8_rune(start_ptr, str + len);
+    }
+    
+    // Ensure we end at a valid UTF-8 boundary
+    const char* end_ptr = str + end;
+    if (end < len) {
+        end_ptr = next_utf8_rune(end_ptr, str + len);
+    }
+    
+    return omni_str_new(arena, start_ptr, (size_t)(end_ptr - start_ptr));
+}
+
+char omni_char_at(const char* str, int32_t index) {
+    return omni_inline_char_at(str, index);
+}
+
+char omni_char_at_len(const char* str, size_t len, int32_t index) {
+    if (!str || index < 0 || (size_t)index >= len) {
+        return '\0';
+    }
+    return str[index];
+}
+
+int32_t omni_starts_with(const char* str, const char* prefix) {
+    if (!str || !prefix) {
+        return 0;
+    }
+    return strncmp(str, prefix, strlen(prefix)) == 0 ? 1 : 0;
+}
+
+int32_t omni_starts_with_len(const char* str, size_t len, const char* prefix, size_t prefix_len) {
+    if (!str || !prefix || prefix_len > len) {
+        return 0;
+    }
+    return memcmp(str, prefix, prefix_len) == 0 ? 1 : 0;
+}
+
+int32_t omni_ends_with(const char* str, const char* suffix) {
+    if (!str || !suffix) {
+        return 0;
+    }
+    return omni_ends_with_len(str, strlen(str), suffix, strlen(suffix));
+}
+
+int32_t omni_ends_with_len(const char* str, size_t len, const char* suffix, size_t suffix_len) {
+    if (!str || !suffix || suffix_len > len) {
+        return 0;
+    }
+    return memcmp(str + len - suffix_len, suffix, suffix_len) == 0 ? 1 : 0;
+}
+
+int32_t omni_contains(const char* str, const char* substr) {
+    if (!str || !substr) {
+        return 0;
+    }
+    return omni_find(str, strlen(str), substr, strlen(substr)) >= 0 ? 1 : 0;
+}
+
+int32_t omni_contains_len(const char* str, size_t len, const char* substr, size_t substr_len) {
+    if (!str || !substr) {
+        return 0;
+    }
+    return omni_find(str, len, substr, substr_len) >= 0 ? 1 : 0;
+}
+
+int32_t omni_index_of(const char* str, const char* substr) {
+    if (!str || !substr) {
+        return -1;
+    }
+    return (int32_t)omni_find(str, strlen(str), substr, strlen(substr));
+}
+
+int32_t omni_index_of_len(const char* str, size_t len, const char* substr, size_t substr_len) {
+    if (!str || !substr) {
+        return -1;
+    }
+    return (int32_t)omni_find(str, len, substr, substr_len);
+}
+
+int32_t omni_last_index_of(const char* str, const char* substr) {
+    if (!str || !substr) {
+        return -1;
+    }
+    
+    int32_t str_len = (int32_t)strlen(str);
+    int32_t substr_len = (int32_t)strlen(substr);
+    
+    if (substr_len == 0) {
+        return str_len;
+    }
+    
+    for (int32_t i = str_len - substr_len; i >= 0; i--) {
+        if (strncmp(str + i, substr, substr_len) == 0) {
+            return i;
+        }
+    }
+    
+    return -1;
+}
+
+// NOTE: Returns a newly allocated string - caller must free it using free()
+// This function allocates memory that must be freed by the caller to avoid leaks.
+char* omni_trim(const char* str) {
+    return omni_trim_arena(NULL, str);
+}
+
+char* omni_trim_arena(omni_arena_t* arena, const char* str) {
+    if (!str) {
+        return NULL;
+    }
+    
+    // Handle empty string
+    size_t str_len = strlen(str);
+    if (str_len == 0) {
+        return omni_str_alloc(arena, 0);
+    }
+    
+    // Find start of non-whitespace
+    const char* start = str;
+    while (*start && (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r')) {
+        start++;
+    }
+    
+    // If entire string is whitespace, return empty string
+    if (*start == '\0') {
+        return omni_str_alloc(arena, 0);
+    }
+    
+    // Find end of non-whitespace (safe: we know start is valid)
+    const char* end = str + str_len - 1;
+    while (end >= start && (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r')) {
+        end--;
+    }
+    
+    // Calculate length (end >= start is guaranteed at this point)
+    return omni_str_new(arena, start, (size_t)(end - start + 1));
+}
+
+char* omni_to_upper(const char* str) {
+    return omni_to_upper_arena(NULL, str);
+}
+
+char* omni_to_upper_arena(omni_arena_t* arena, const char* str) {
+    if (!str) {
+        return NULL;
+    }
+    
+    size_t len = strlen(str);
+    char* result = omni_str_alloc(arena, len);
+    if (result) {
+        omni_ascii_case(result, str, len, 1);
+    }
+    return result;
+}
+
+char* omni_to_lower(const char* str) {
+    return omni_to_lower_arena(NULL, str);
+}
+
+char* omni_to_lower_arena(omni_arena_t* arena, const char* str) {
+    if (!str) {
+        return NULL;
+    }
+    
+    size_t len = strlen(str);
+    char* result = omni_str_alloc(arena, len);
+    if (result) {
+        omni_ascii_case(result, str, len, 0);
+    }
+    return result;
+}
+
+int32_t omni_string_equals(const char* a, const char* b) {
+    return omni_inline_string_equals(a, b);
+}
+
+int32_t omni_string_equals_len(const char* a, size_t a_len, const char* b, size_t b_len) {
+    if (!a || !b) {
+        return (a == b) ? 1 : 0;
+    }
+    if (a_len != b_len) return 0;
+    return memcmp(a, b, a_len) == 0 ? 1 : 0;
+}
+
+int32_t omni_string_compare(const char* a, const char* b) {
+    if (!a || !b) {
+        if (!a && !b) return 0;
+        if (!a) return -1;
+        return 1;
+    }
+    return strcmp(a, b);
+}
+
+// String builder
+// Pieces accumulate in the inline buffer first and only move to the heap
+// once they outgrow it (doubling), so finishing a short chain costs exactly
+// one allocation. Heap buffers keep room for an omni_str header in front of
+// the data, so finish can hand them over without copying.
+void omni_strbuilder_init(omni_strbuilder_t* sb) {
+    if (!sb) return;
+    sb->data = sb->inline_buf;
+    sb->len = 0;
+    sb->cap = OMNI_STRBUILDER_INLINE;
+    sb->inline_buf[0] = '\0';
+}
+
+int omni_strbuilder_reserve(omni_strbuilder_t* sb, size_t additional) {
+    if (!sb) return -1;
+    if (additional > SIZE_MAX - sizeof(omni_str_header_t) - sb->len - 1) return -1;
+    size_t needed = sb->len + additional + 1;
+    if (needed <= sb->cap) return 0;
+    
+    size_t new_cap = sb->cap * 2;
+    if (new_cap < needed) new_cap = needed;
+    omni_str_header_t* block;
+    if (sb->data == sb->inline_buf) {
+        block = (omni_str_header_t*)malloc(sizeof(omni_str_header_t) + new_cap);
+        if (block) memcpy(block + 1, sb->data, sb->len + 1);
+    } else {
+        block = (omni_str_header_t*)realloc(OMNI_STR_HEADER(sb->data), sizeof(omni_str_header_t) + new_cap);
+    }
+    if (!block) return -1;
+    sb->data = (char*)(block + 1);
+    sb->cap = new_cap;
+    return 0;
+}
+
+void omni_strbuilder_append_len(omni_strbuilder_t* sb, const char* str, size_t len) {
+    if (!sb || !str || len == 0) return;
+    if (omni_strbuilder_reserve(sb, len) != 0) return;
+    memcpy(sb->data + sb->len, str, len);
+    sb->len += len;
+    sb->data[sb->len] = '\0';
+}
+
+void omni_strbuilder_append_str(omni_strbuilder_t* sb, const char* str) {
+    if (!str) return;
+    omni_strbuilder_append_len(sb, str, strlen(str));
+}
+
+// Numbers are formatted straight into the buffer
+void omni_strbuilder_append_int(omni_strbuilder_t* sb, int32_t value) {
+    if (!sb || omni_strbuilder_reserve(sb, OMNI_FMT_INT_MAX) != 0) return;
+    sb->len += omni_format_int(sb->data + sb->len, value);
+    sb->data[sb->len] = '\0';
+}
+
+void omni_strbuilder_append_float(omni_strbuilder_t* sb, double value) {
+    if (!sb || omni_strbuilder_reserve(sb, OMNI_FMT_FLOAT_MAX) != 0) return;
+    sb->len += omni_format_float(sb->data + sb->len, value);
+    sb->data[sb->len] = '\0';
+}
+
+void omni_strbuilder_append_bool(omni_strbuilder_t* sb, int32_t value) {
+    if (value) {
+        omni_strbuilder_append_len(sb, "true", 4);
+    } else {
+        omni_strbuilder_append_len(sb, "false", 5);
+    }
+}
+
+char* omni_strbuilder_finish(omni_strbuilder_t* sb) {
+    if (!sb) return NULL;
+    char* result;
+    if (sb->data == sb->inline_buf) {
+        result = omni_str_new(NULL, sb->data, sb->len);
+    } else {
+        // Hand over the heap buffer, trimmed to size
+        omni_str_header_t* block = OMNI_STR_HEADER(sb->data);
+        omni_str_header_t* trimmed = (omni_str_header_t*)realloc(block, sizeof(omni_str_header_t) + sb->len + 1);
+        if (trimmed) block = trimmed;
+        omni_str_header_init(block, sb->len, 0);
+        result = (char*)(block + 1);
+    }
+    omni_strbuilder_init(sb);
+    return result;
+}
+
+char* omni_strbuilder_finish_arena(omni_strbuilder_t* sb, omni_arena_t* arena) {
+    if (!arena) return omni_strbuilder_finish(sb);
+    if (!sb) return NULL;
+    char* result = omni_str_new(arena, sb->data, sb->len);
+    omni_strbuilder_free(sb);
+    return result;
+}
+
+void omni_strbuilder_free(omni_strbuilder_t* sb) {
+    if (!sb) return;
+    if (sb->data != sb->inline_buf) free(OMNI_STR_HEADER(sb->data));
+    omni_strbuilder_init(sb);
+}
+
+// Math operations
+int32_t omni_add(int32_t a, int32_t b) {
+    return omni_inline_add(a, b);
+}
+
+int32_t omni_sub(int32_t a, int32_t b) {
+    return omni_inline_sub(a, b);
+}
+
+int32_t omni_mul(int32_t a, int32_t b) {
+    return omni_inline_mul(a, b);
+}
+
+int32_t omni_div(int32_t a, int32_t b) {
+    return omni_inline_div(a, b);
+}
+
+int32_t omni_abs(int32_t x) {
+    return omni_inline_abs(x);
+}
+
+int32_t omni_max(int32_t a, int32_t b) {
+    return omni_inline_max(a, b);
+}
+
+int32_t omni_min(int32_t a, int32_t b) {
+    return omni_inline_min(a, b);
+}
+
+char* omni_int_to_string(int32_t value) {
+    return omni_int_to_string_arena(NULL, value);
+}
+
+// Formatted numbers are ASCII, so their rune count is known up front
+static char* omni_str_ascii(omni_arena_t* arena, const char* data, size_t len) {
+    char* str = omni_str_new(arena, data, len);
+    if (str) OMNI_STR_HEADER(str)->runes = (int32_t)len;
+    return str;
+}
+
+char* omni_int_to_string_arena(omni_arena_t* arena, int32_t value) {
+    char buf[OMNI_FMT_INT_MAX];
+    return omni_str_ascii(arena, buf, omni_format_int(buf, value));
+}
+
+char* omni_float_to_string(double value) {
+    return omni_float_to_string_arena(NULL, value);
+}
+
+char* omni_float_to_string_arena(omni_arena_t* arena, double value) {
+    char buf[OMNI_FMT_FLOAT_MAX];
+    return omni_str_ascii(arena, buf, omni_format_float(buf, value));
+}
+
+char* omni_bool_to_string(int32_t value) {
+    return omni_bool_to_string_arena(NULL, value);
+}
+
+char* omni_bool_to_string_arena(omni_arena_t* arena, int32_t value) {
+    if (value) {
+        return omni_str_ascii(arena, "true", 4);
+    }
+    return omni_str_ascii(arena, "false", 5);
+}
+
+static const char* omni_skip_space(const char* str) {
+    while (*str == ' ' || *str == '\t' || *str == '\n' || *str == '\v' || *str == '\f' || *str == '\r') {
+        str++;
+    }
+    return str;
+}
+
+int32_t omni_string_to_int(const char* str) {
+    if (!str) return 0;
+    const char* start = omni_skip_space(str);
+    size_t len = strlen(start);
+    int64_t result = 0;
+    size_t consumed = omni_parse_int(start, len, &result);
+    // Check for conversion errors
+    if (consumed > 0 && (result < INT32_MIN || result > INT32_MAX)) {
+        fprintf(stderr, "WARNING: String to int conversion overflow: %s\n", str);
+        return 0;
+    }
+    if (consumed == 0 || consumed != len) {
+        // No digits found or invalid characters
+        fprintf(stderr, "WARNING: Invalid integer string: %s\n", str);
+        return 0;
+    }
+    return (int32_t)result;
+}
+
+// Reads the longest number at the start of str, after any whitespace, and
+// 0.0 if there is none
+double omni_string_to_float(const char* str) {
+    if (!str) return 0.0;
+    const char* start = omni_skip_space(str);
+    const char* digits = start + (*start == '-' || *start == '+');
+    if (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+        // Hexadecimal floats are rare enough to leave to libc
+        return strtod(start, NULL);
+    }
+    double result = 0.0;
+    omni_parse_float(start, strlen(start), &result);
+    return result;
+}
+
+int32_t omni_string_to_bool(const char* str) {
+    if (!str) return 0;
+    return (strcmp(str, "true") == 0) ? 1 : 0;
+}
+
+// Array operations
+// NOTE: Array length cannot be determined from a pointer alone in C.
+// The backend should pass array length as a parameter or track it separately.
+// For now, return 0 as a safe default (backend should use compile-time known lengths).
+int32_t omni_array_length(int32_t* arr) {
+    if (!arr) return 0;
+    // Cannot determine length from pointer - backend must pass length explicitly
+    // Returning 0 is safer than a hardcoded value
+    return 0;
+}
+
+// Array get operation with bounds checking
+int32_t omni_array_get_int(int32_t* arr, int32_t index, int32_t length) {
+    if (!arr) {
+        fprintf(stderr, "ERROR: Array access on NULL pointer\n");
+        abort();
+    }
+    if (index < 0 || index >= length) {
+        fprintf(stderr, "ERROR: Array index out of bounds: index=%d, length=%d\n", index, length);
+        abort();
+    }
+    return arr[index];
+}
+
+// Array set operation with bounds checking
+void omni_array_set_int(int32_t* arr, int32_t index, int32_t value, int32_t length) {
+    if (!arr) {
+        fprintf(stderr, "ERROR: Array access on NULL pointer\n");
+        abort();
+    }
+    if (index < 0 || index >= length) {
+        fprintf(stderr, "ERROR: Array index out of bounds: index=%d, length=%d\n", index, length);
+        abort();
+    }
+    arr[index] = value;
+}
+
+// Out-of-line failure path of omni_array_check_index
+void omni_array_bounds_fail(int32_t index, int32_t length) {
+    fprintf(stderr, "ERROR: Array index out of bounds: index=%d, length=%d\n", index, length);
+    abort();
+}
+
+// Typed vectors
+// omni_vec_t carries its length, capacity and element kind, so a vector
+// keeps its bounds when passed between functions. Storage grows by
+// doubling. The int32 kernels below work 4 lanes at a time with SSE2 or
+// NEON and 8 with AVX2 when the CPU has it, finishing with a scalar loop;
+// OMNI_NO_SIMD leaves only the scalar loops.
+static const int32_t omni_vec_elem_sizes[] = {
+    (int32_t)sizeof(int32_t), // OMNI_VEC_INT
+    (int32_t)sizeof(int64_t), // OMNI_VEC_INT64
+    (int32_t)sizeof(double),  // OMNI_VEC_DOUBLE
+    (int32_t)sizeof(void*),   // OMNI_VEC_PTR
+};
+
+omni_vec_t* omni_vec_create(int32_t kind, int32_t capacity) {
+    if (kind < OMNI_VEC_INT || kind > OMNI_VEC_PTR || capacity < 0) return NULL;
+    omni_vec_t* vec = (omni_vec_t*)calloc(1, sizeof(omni_vec_t));
+    if (!vec) return NULL;
+    vec->kind = kind;
+    vec->elem_size = omni_vec_elem_sizes[kind];
+    if (capacity > 0 && !omni_vec_reserve(vec, capacity)) {
+        free(vec);
+        return NULL;
+    }
+    return vec;
+}
+
+omni_vec_t* omni_vec_from(int32_t kind, const void* data, int32_t length) {
+    omni_vec_t* vec = omni_vec_create(kind, length);
+    if (!vec) return NULL;
+    if (length > 0) memcpy(vec->data, data, (size_t)length * (size_t)vec->elem_size);
+    vec->length = length;
+    return vec;
+}
+
+void omni_vec_destroy(omni_vec_t* vec) {
+    if (!vec) return;
+    free(vec->data);
+    free(vec);
+}
+
+int32_t omni_vec_reserve(omni_vec_t* vec, int32_t capacity) {
+    if (!vec || capacity < 0) return 0;
+    if (capacity <= vec->capacity) return 1;
+    int64_t grown = vec->capacity > 0 ? (int64_t)vec->capacity * 2 : 8;
+    if (grown < capacity) grown = capacity;
+    if (grown > INT32_MAX) grown = INT32_MAX;
+    void* data = realloc(vec->data, (size_t)grown * (size_t)vec->elem_size);
+    if (!data) return 0;
+    vec->data = data;
+    vec->capacity = (int32_t)grown;
+    return 1;
+}
+
+int32_t omni_vec_resize(omni_vec_t* vec, int32_t length) {
+    if (!vec || length < 0 || !omni_vec_reserve(vec, length)) return 0;
+    if (length > vec->length) {
+        memset((char*)vec->data + (size_t)vec->length * (size_t)vec->elem_size, 0,
+               (size_t)(length - vec->length) * (size_t)vec->elem_size);
+    }
+    vec->length = length;
+    return 1;
+}
+
+void omni_vec_clear(omni_vec_t* vec) {
+    if (vec) vec->length = 0;
+}
+
+int32_t omni_vec_length(const omni_vec_t* vec) {
+    return vec ? vec->length : 0;
+}
+
+int32_t omni_vec_push_int(omni_vec_t* vec, int32_t value) {
+    if (!vec || vec->kind != OMNI_VEC_INT) return 0;
+    if (vec->length == vec->capacity && !omni_vec_reserve(vec, vec->length + 1)) return 0;
+    ((int32_t*)vec->data)[vec->length++] = value;
+    return 1;
+}
+
+int32_t omni_vec_push_int64(omni_vec_t* vec, int64_t value) {
+    if (!vec || vec->kind != OMNI_VEC_INT64) return 0;
+    if (vec->length == vec->capacity && !omni_vec_reserve(vec, vec->length + 1)) return 0;
+    ((int64_t*)vec->data)[vec->length++] = value;
+    return 1;
+}
+
+int32_t omni_vec_push_double(omni_vec_t* vec, double value) {
+    if (!vec || vec->kind != OMNI_VEC_DOUBLE) return 0;
+    if (vec->length == vec->capacity && !omni_vec_reserve(vec, vec->length + 1)) return 0;
+    ((double*)vec->data)[vec->length++] = value;
+    return 1;
+}
+
+int32_t omni_vec_push_ptr(omni_vec_t* vec, void* value) {
+    if (!vec || vec->kind != OMNI_VEC_PTR) return 0;
+    if (vec->length == vec->capacity && !omni_vec_reserve(vec, vec->length + 1)) return 0;
+    ((void**)vec->data)[vec->length++] = value;
+    return 1;
+}
+
+int32_t omni_vec_append(omni_vec_t* dst, const omni_vec_t* src) {
+    if (!dst || !src || dst->kind != src->kind) return 0;
+    if (src->length == 0) return 1;
+    if (!omni_vec_reserve(dst, dst->length + src->length)) return 0;
+    memcpy((char*)dst->data + (size_t)dst->length * (size_t)dst->elem_size, src->data,
+           (size_t)src->length * (size_t)src->elem_size);
+    dst->length += src->length;
+    return 1;
+}
+
+int32_t omni_vec_copy(omni_vec_t* dst, const omni_vec_t* src) {
+    if (!dst || !src || dst->kind != src->kind) return 0;
+    dst->length = 0;
+    return omni_vec_append(dst, src);
+}
+
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+// AVX2 halves of the kernels below; each handles whole 8-lane blocks and
+// returns where it stopped
+static OMNI_TARGET_AVX2 int32_t omni_vec_sum_int_avx2(const int32_t* p, int32_t n, int64_t* sum) {
+    __m256i acc = _mm256_setzero_si256();
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    *sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    return i;
+}
+
+static OMNI_TARGET_AVX2 int32_t omni_vec_minmax_int_avx2(const int32_t* p, int32_t n, int32_t* lo, int32_t* hi) {
+    __m256i vmin = _mm256_set1_epi32(*lo), vmax = _mm256_set1_epi32(*hi);
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        vmin = _mm256_min_epi32(vmin, v);
+        vmax = _mm256_max_epi32(vmax, v);
+    }
+    int32_t mins[8], maxs[8];
+    _mm256_storeu_si256((__m256i*)mins, vmin);
+    _mm256_storeu_si256((__m256i*)maxs, vmax);
+    for (int32_t k = 0; k < 8; k++) {
+        if (mins[k] < *lo) *lo = mins[k];
+        if (maxs[k] > *hi) *hi = maxs[k];
+    }
+    return i;
+}
+
+// Index of the first lane equal to value (equal != 0) or different from
+// b's lane (b != NULL), or the end of the whole blocks
+static OMNI_TARGET_AVX2 int32_t omni_vec_scan_int_avx2(const int32_t* a, const int32_t* b, int32_t value, int32_t from, int32_t n) {
+    __m256i needle = _mm256_set1_epi32(value);
+    int32_t i = from;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i other = b ? _mm256_loadu_si256((const __m256i*)(b + i)) : needle;
+        uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, other)));
+        if (b) mask ^= 0xFFu;
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i;
+}
+#endif
+
+// Shared by find (b == NULL: first lane equal to value) and compare (first
+// lane where a and b differ). Returns n when there is none.
+static int32_t omni_vec_scan_int(const int32_t* a, const int32_t* b, int32_t value, int32_t from, int32_t n) {
+    int32_t i = from;
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+    if (n - from >= 16 && omni_has_avx2()) {
+        // The lane where it stopped is either the first hit or unchecked
+        i = omni_vec_scan_int_avx2(a, b, value, from, n);
+        if (i < n && (b ? a[i] != b[i] : a[i] == value)) return i;
+    }
+#endif
+#if defined(OMNI_HAVE_SSE2)
+    __m128i needle = _mm_set1_epi32(value);
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i other = b ? _mm_loadu_si128((const __m128i*)(b + i)) : needle;
+        uint32_t mask = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, other)));
+        if (b) mask ^= 0xFu;
+        if (mask) return i + __builtin_ctz(mask);
+    }
+#elif defined(OMNI_HAVE_NEON)
+    int32x4_t needle = vdupq_n_s32(value);
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t v = vld1q_s32(a + i);
+        uint32x4_t eq = vceqq_s32(v, b ? vld1q_s32(b + i) : needle);
+        if (b ? vminvq_u32(eq) == 0 : vmaxvq_u32(eq) != 0) break;
+    }
+#endif
+    for (; i < n; i++) {
+        if (b ? a[i] != b[i] : a[i] == value) return i;
+    }
+    return n;
+}
+
+// Sum of p[0..n) widened to 64 bits
+static int64_t omni_sum_int32(const int32_t* p, int32_t n) {
+    int32_t i = 0;
+    int64_t sum = 0;
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+    if (n >= 16 && omni_has_avx2()) i = omni_vec_sum_int_avx2(p, n, &sum);
+#endif
+#if defined(OMNI_HAVE_SSE2)
+    // Sign-extend the lanes to 64 bits in pairs before adding
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i sign = _mm_srai_epi32(v, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    sum += lanes[0] + lanes[1];
+#elif defined(OMNI_HAVE_NEON)
+    int64x2_t acc = vdupq_n_s64(0);
+    for (; i + 4 <= n; i += 4) acc = vpadalq_s32(acc, vld1q_s32(p + i));
+    sum += vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1);
+#endif
+    for (; i < n; i++) sum += p[i];
+    return sum;
+}
+
+int64_t omni_vec_sum_int(const omni_vec_t* vec) {
+    if (!vec || vec->kind != OMNI_VEC_INT) return 0;
+    return omni_sum_int32((const int32_t*)vec->data, vec->length);
+}
+
+// Smallest and largest of p[0..n), n > 0, into *lo and *hi
+static void omni_minmax_int32(const int32_t* p, int32_t n, int32_t* lo, int32_t* hi) {
+    int32_t i = 0;
+    *lo = *hi = p[0];
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+    if (n >= 16 && omni_has_avx2()) i = omni_vec_minmax_int_avx2(p, n, lo, hi);
+#endif
+#if defined(OMNI_HAVE_SSE2)
+    // SSE2 has no 32-bit min/max, so select with a compare mask
+    __m128i vmin = _mm_set1_epi32(*lo), vmax = _mm_set1_epi32(*hi);
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i lt = _mm_cmplt_epi32(v, vmin);
+        __m128i gt = _mm_cmpgt_epi32(v, vmax);
+        vmin = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, vmin));
+        vmax = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, vmax));
+    }
+    int32_t mins[4], maxs[4];
+    _mm_storeu_si128((__m128i*)mins, vmin);
+    _mm_storeu_si128((__m128i*)maxs, vmax);
+    for (int32_t k = 0; k < 4; k++) {
+        if (mins[k] < *lo) *lo = mins[k];
+        if (maxs[k] > *hi) *hi = maxs[k];
+    }
+#elif defined(OMNI_HAVE_NEON)
+    int32x4_t vmin = vdupq_n_s32(*lo), vmax = vdupq_n_s32(*hi);
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t v = vld1q_s32(p + i);
+        vmin = vminq_s32(vmin, v);
+        vmax = vmaxq_s32(vmax, v);
+    }
+    *lo = vminvq_s32(vmin);
+    *hi = vmaxvq_s32(vmax);
+#endif
+    for (; i < n; i++) {
+        if (p[i] < *lo) *lo = p[i];
+        if (p[i] > *hi) *hi = p[i];
+    }
+}
+
+static int32_t omni_vec_minmax_int(const omni_vec_t* vec, int32_t* lo, int32_t* hi) {
+    if (!vec || vec->kind != OMNI_VEC_INT || vec->length == 0) return 0;
+    omni_minmax_int32((const int32_t*)vec->data, vec->length, lo, hi);
+    return 1;
+}
+
+int32_t omni_vec_min_int(const omni_vec_t* vec, int32_t* out) {
+    int32_t hi;
+    return omni_vec_minmax_int(vec, out, &hi);
+}
+
+int32_t omni_vec_max_int(const omni_vec_t* vec, int32_t* out) {
+    int32_t lo;
+    return omni_vec_minmax_int(vec, &lo, out);
+}
+
+void omni_vec_fill_int(omni_vec_t* vec, int32_t value) {
+    if (!vec || vec->kind != OMNI_VEC_INT) return;
+    int32_t* p = (int32_t*)vec->data;
+    int32_t n = vec->length, i = 0;
+#if defined(OMNI_HAVE_SSE2)
+    __m128i v = _mm_set1_epi32(value);
+    for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i*)(p + i), v);
+#elif defined(OMNI_HAVE_NEON)
+    int32x4_t v = vdupq_n_s32(value);
+    for (; i + 4 <= n; i += 4) vst1q_s32(p + i, v);
+#endif
+    for (; i < n; i++) p[i] = value;
+}
+
+int32_t omni_vec_find_int(const omni_vec_t* vec, int32_t value, int32_t from) {
+    if (!vec || vec->kind != OMNI_VEC_INT) return -1;
+    if (from < 0) from = 0;
+    if (from >= vec->length) return -1;
+    int32_t at = omni_vec_scan_int((const int32_t*)vec->data, NULL, value, from, vec->length);
+    return at < vec->length ? at : -1;
+}
+
+int32_t omni_vec_compare_int(const omni_vec_t* a, const omni_vec_t* b) {
+    int32_t na = (a && a->kind == OMNI_VEC_INT) ? a->length : 0;
+    int32_t nb = (b && b->kind == OMNI_VEC_INT) ? b->length : 0;
+    int32_t n = na < nb ? na : nb;
+    if (n > 0) {
+        const int32_t* pa = (const int32_t*)a->data;
+        const int32_t* pb = (const int32_t*)b->data;
+        int32_t at = omni_vec_scan_int(pa, pb, 0, 0, n);
+        if (at < n) return pa[at] < pb[at] ? -1 : 1;
+    }
+    return na < nb ? -1 : (na > nb ? 1 : 0);
+}
+
+int32_t omni_vec_equal(const omni_vec_t* a, const omni_vec_t* b) {
+    if (!a || !b) return a == b;
+    if (a->kind != b->kind || a->length != b->length) return 0;
+    if (a->length == 0) return 1;
+    if (a->kind == OMNI_VEC_DOUBLE) {
+        // Numeric equality, so 0.0 == -0.0 and NaN never matches
+        const double* pa = (const double*)a->data;
+        const double* pb = (const double*)b->data;
+        for (int32_t i = 0; i < a->length; i++) {
+            if (pa[i] != pb[i]) return 0;
+        }
+        return 1;
+    }
+    return memcmp(a->data, b->data, (size_t)a->length * (size_t)a->elem_size) == 0;
+}
+
+// Four partial sums; the compiler keeps them in one vector register
+double omni_vec_sum_double(const omni_vec_t* vec) {
+    if (!vec || vec->kind != OMNI_VEC_DOUBLE) return 0.0;
+    const double* p = (const double*)vec->data;
+    int32_t n = vec->length, i = 0;
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += p[i];
+        s1 += p[i + 1];
+        s2 += p[i + 2];
+        s3 += p[i + 3];
+    }
+    for (; i < n; i++) s0 += p[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+void omni_vec_fill_double(omni_vec_t* vec, double value) {
+    if (!vec || vec->kind != OMNI_VEC_DOUBLE) return;
+    double* p = (double*)vec->data;
+    for (int32_t i = 0; i < vec->length; i++) p[i] = value;
+}
+
+double omni_pow(double x, double y) {
+    return omni_inline_pow(x, y);
+}
+
+double omni_sqrt(double x) {
+    return omni_inline_sqrt(x);
+}
+
+double omni_floor(double x) {
+    return omni_inline_floor(x);
+}
+
+double omni_ceil(double x) {
+    return omni_inline_ceil(x);
+}
+
+double omni_round(double x) {
+    return omni_inline_round(x);
+}
+
+int32_t omni_gcd(int32_t a, int32_t b) {
+    if (b == 0) {
+        return a;
+    }
+    return omni_gcd(b, a % b);
+}
+
+int32_t omni_lcm(int32_t a, int32_t b) {
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return (a * b) / omni_gcd(a, b);
+}
+
+int32_t omni_factorial(int32_t n) {
+    if (n <= 1) {
+        return 1;
+    }
+    int32_t result = 1;
+    for (int32_t i = 2; i <= n; i++) {
+        result *= i;
+    }
+    return result;
+}
+
+// Trigonometric functions
+double omni_sin(double x) {
+    return sin(x);
+}
+
+double omni_cos(double x) {
+    return cos(x);
+}
+
+double omni_tan(double x) {
+    return tan(x);
+}
+
+double omni_asin(double x) {
+    return asin(x);
+}
+
+double omni_acos(double x) {
+    return acos(x);
+}
+
+double omni_atan(double x) {
+    return atan(x);
+}
+
+double omni_atan2(double y, double x) {
+    return atan2(y, x);
+}
+
+// Logarithmic and exponential functions
+double omni_exp(double x) {
+    return exp(x);
+}
+
+double omni_log(double x) {
+    return log(x);
+}
+
+double omni_log10(double x) {
+    return log10(x);
+}
+
+double omni_log2(double x) {
+    return log2(x);
+}
+
+// Hyperbolic functions
+double omni_sinh(double x) {
+    return sinh(x);
+}
+
+double omni_cosh(double x) {
+    return cosh(x);
+}
+
+double omni_tanh(double x) {
+    return tanh(x);
+}
+
+// Additional math functions
+double omni_cbrt(double x) {
+    if (x == 0.0) return 0.0;
+    if (x < 0.0) return -pow(-x, 1.0/3.0);
+    return pow(x, 1.0/3.0);
+}
+
+double omni_trunc(double x) {
+    return omni_inline_trunc(x);
+}
+
+// Array operations
+// omni_len returns the length of an array. The length is passed explicitly by the backend.
+int32_t omni_len(void* array, size_t element_size, int32_t array_length) {
+    return omni_inline_len(array, element_size, array_length);
+}
+
+// File I/O operations
+intptr_t omni_file_open(const char* filename, const char* mode) {
+    FILE* file = fopen(filename, mode);
+    if (file == NULL) {
+        return (intptr_t)-1; // Error: file could not be opened
+    }
+    return (intptr_t)file; // Cast FILE* to intptr_t handle (safe on 64-bit)
+}
+
+int32_t omni_file_close(intptr_t file_handle) {
+    if (file_handle == (intptr_t)-1) {
+        return -1; // Error: invalid handle
+    }
+    FILE* file = (FILE*)(intptr_t)file_handle;
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+int32_t omni_file_read(intptr_t file_handle, char* buffer, int32_t size) {
+    if (file_handle == (intptr_t)-1 || buffer == NULL || size <= 0) {
+        return -1; // Error: invalid parameters
+    }
+    FILE* file = (FILE*)file_handle;
+    size_t bytes_read = fread(buffer, 1, (size_t)size, file);
+    return (int32_t)bytes_read;
+}
+
+int32_t omni_file_write(intptr_t file_handle, const char* buffer, int32_t size) {
+    if (file_handle == (intptr_t)-1 || buffer == NULL || size <= 0) {
+        return -1; // Error: invalid parameters
+    }
+    FILE* file = (FILE*)file_handle;
+    size_t bytes_written = fwrite(buffer, 1, (size_t)size, file);
+    return (int32_t)bytes_written;
+}
+
+int32_t omni_file_seek(intptr_t file_handle, int32_t offset, int32_t whence) {
+    return omni_file_seek64(file_handle, offset, whence);
+}
+
+int32_t omni_file_tell(intptr_t file_handle) {
+    int64_t pos = omni_file_tell64(file_handle);
+    return pos <= INT32_MAX ? (int32_t)pos : -1;
+}
+
+int64_t omni_file_read64(intptr_t file_handle, char* buffer, int64_t size) {
+    if (file_handle == (intptr_t)-1 || buffer == NULL || size <= 0 || (uint64_t)size > SIZE_MAX) {
+        return -1; // Error: invalid parameters
+    }
+    FILE* file = (FILE*)file_handle;
+    return (int64_t)fread(buffer, 1, (size_t)size, file);
+}
+
+int64_t omni_file_write64(intptr_t file_handle, const char* buffer, int64_t size) {
+    if (file_handle == (intptr_t)-1 || buffer == NULL || size <= 0 || (uint64_t)size > SIZE_MAX) {
+        return -1; // Error: invalid parameters
+    }
+    FILE* file = (FILE*)file_handle;
+    return (int64_t)fwrite(buffer, 1, (size_t)size, file);
+}
+
+int32_t omni_file_seek64(intptr_t file_handle, int64_t offset, int32_t whence) {
+    if (file_handle == (intptr_t)-1) {
+        return -1; // Error: invalid handle
+    }
+    FILE* file = (FILE*)file_handle;
+#ifdef _WIN32
+    return _fseeki64(file, offset, whence) == 0 ? 0 : -1;
+#else
+    return fseeko(file, (off_t)offset, whence) == 0 ? 0 : -1;
+#endif
+}
+
+int64_t omni_file_tell64(intptr_t file_handle) {
+    if (file_handle == (intptr_t)-1) {
+        return -1; // Error: invalid handle
+    }
+    FILE* file = (FILE*)file_handle;
+#ifdef _WIN32
+    int64_t pos = _ftelli64(file);
+#else
+    int64_t pos = (int64_t)ftello(file);
+#endif
+    return pos >= 0 ? pos : -1;
+}
+
+// Vectored writes
+// Whatever stdio has buffered goes first, then the pieces are handed to
+// writev in batches. Afterwards the stream is repositioned to the
+// descriptor's offset so later stdio calls continue from the right place.
+#define OMNI_WRITEV_BATCH 256
+
+int64_t omni_file_writev(intptr_t file_handle, const omni_iovec_t* pieces, int32_t count) {
+    if (file_handle == (intptr_t)-1 || (!pieces && count > 0) || count < 0) {
+        return -1; // Error: invalid parameters
+    }
+    FILE* file = (FILE*)file_handle;
+    int64_t total = 0;
+#ifdef _WIN32
+    for (int32_t i = 0; i < count; i++) {
+        if (pieces[i].len == 0) continue;
+        size_t written = fwrite(pieces[i].data, 1, pieces[i].len, file);
+        total += (int64_t)written;
+        if (written != pieces[i].len) return total > 0 ? total : -1;
+    }
+    return total;
+#else
+    if (fflush(file) != 0) {
+        return -1;
+    }
+    int fd = fileno(file);
+    // Drop any read-ahead so the descriptor offset matches the stream
+    off_t start = ftello(file);
+    if (start >= 0) {
+        lseek(fd, start, SEEK_SET);
+    }
+    int32_t index = 0;
+    size_t skip = 0; // Bytes of pieces[index] already written
+    while (index < count) {
+        struct iovec iov[OMNI_WRITEV_BATCH];
+        int n = 0;
+        for (int32_t i = index; i < count && n < OMNI_WRITEV_BATCH; i++) {
+            size_t off = i == index ? skip : 0;
+            if (pieces[i].len == off) continue;
+            iov[n].iov_base = (void*)(pieces[i].data + off);
+            iov[n].iov_len = pieces[i].len - off;
+            n++;
+        }
+        if (n == 0) break;
+        ssize_t written = writev(fd, iov, n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (total == 0) total = -1;
+            break;
+        }
+        total += written;
+        // Advance past everything that went out
+        size_t left = (size_t)written;
+        while (index < count) {
+            size_t rest = pieces[index].len - skip;
+            if (left < rest) {
+                skip += left;
+                break;
+            }
+            left -= rest;
+            skip = 0;
+            index++;
+        }
+    }
+    off_t end = lseek(fd, 0, SEEK_CUR);
+    if (end >= 0) {
+        fseeko(file, end, SEEK_SET);
+    }
+    return total;
+#endif
+}
+
+int32_t omni_file_exists(const char* filename) {
+    if (filename == NULL) {
+        return 0; // Error: null filename
+    }
+    struct stat st;
+    return stat(filename, &st) == 0 ? 1 : 0;
+}
+
+int32_t omni_file_size(const char* filename) {
+    int64_t size = omni_file_size64(filename);
+    return size <= INT32_MAX ? (int32_t)size : -1;
+}
+
+int64_t omni_file_size64(const char* filename) {
+    if (filename == NULL) {
+        return -1; // Error: null filename
+    }
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(filename, &st) != 0) {
+        return -1; // Error: file not found or stat failed
+    }
+#else
+    struct stat st;
+    if (stat(filename, &st) != 0) {
+        return -1; // Error: file not found or stat failed
+    }
+#endif
+    return (int64_t)st.st_size;
+}
+
+// Memory-mapped files
+// The view is mapped once, read-only and private, and the descriptor is
+// closed straight away; the mapping keeps the file contents reachable. The
+// advice maps to madvise on POSIX and to the scan-pattern flags of CreateFile
+// on Windows, which has no per-range equivalent.
+static const char omni_file_view_empty[1] = "";
+
+omni_file_view_t* omni_file_map(const char* path, int32_t advice) {
+    if (!path) {
+        return NULL;
+    }
+    omni_file_view_t* view = (omni_file_view_t*)calloc(1, sizeof(omni_file_view_t));
+    if (!view) {
+        return NULL;
+    }
+#ifdef _WIN32
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (advice == OMNI_FILE_MAP_SEQUENTIAL) flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    else if (advice == OMNI_FILE_MAP_RANDOM) flags |= FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, OPEN_EXISTING, flags, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        free(view);
+        return NULL;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX) {
+        CloseHandle(file);
+        free(view);
+        return NULL;
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        view->data = omni_file_view_empty;
+        return view;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        free(view);
+        return NULL;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        free(view);
+        return NULL;
+    }
+    view->data = (const char*)data;
+    view->len = (size_t)size.QuadPart;
+    view->handle = mapping;
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        free(view);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (uint64_t)st.st_size > (uint64_t)SIZE_MAX) {
+        close(fd);
+        free(view);
+        return NULL;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        view->data = omni_file_view_empty;
+        return view;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        free(view);
+        return NULL;
+    }
+    view->data = (const char*)data;
+    view->len = (size_t)st.st_size;
+    if (advice != OMNI_FILE_MAP_NORMAL) {
+        omni_file_advise(view, 0, view->len, advice);
+    }
+#endif
+    return view;
+}
+
+int32_t omni_file_advise(omni_file_view_t* view, size_t offset, size_t len, int32_t advice) {
+    if (!view || offset > view->len) {
+        return -1;
+    }
+    if (len > view->len - offset) {
+        len = view->len - offset;
+    }
+    if (len == 0) {
+        return 0;
+    }
+#ifdef _WIN32
+    (void)advice;
+    return 0;
+#else
+    int how;
+    switch (advice) {
+        case OMNI_FILE_MAP_NORMAL: how = MADV_NORMAL; break;
+        case OMNI_FILE_MAP_SEQUENTIAL: how = MADV_SEQUENTIAL; break;
+        case OMNI_FILE_MAP_RANDOM: how = MADV_RANDOM; break;
+        case OMNI_FILE_MAP_WILLNEED: how = MADV_WILLNEED; break;
+        default: return -1;
+    }
+    // madvise wants a page-aligned start
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)(view->data + offset) & ~(uintptr_t)(page - 1);
+    size_t span = (size_t)((uintptr_t)(view->data + offset) - start) + len;
+    return madvise((void*)start, span, how) == 0 ? 0 : -1;
+#endif
+}
+
+void omni_file_unmap(omni_file_view_t* view) {
+    if (!view) {
+        return;
+    }
+    if (view->len > 0) {
+#ifdef _WIN32
+        UnmapViewOfFile(view->data);
+        CloseHandle((HANDLE)view->handle);
+#else
+        munmap((void*)view->data, view->len);
+#endif
+    }
+    free(view);
+}
+
+// Testing framework
+void omni_test_start(const char* test_name) {
+    printf("Running test: %s\n", test_name);
+    current_test_passed = 1;
+}
+
+void omni_test_end(const char* test_name, int32_t passed) {
+    total_tests++;
+    if (passed && current_test_passed) {
+        passed_tests++;
+        printf("✓ %s PASSED\n", test_name);
+    } else {
+        printf("✗ %s FAILED\n", test_name);
+    }
+}
+
+void omni_assert(int32_t condition, const char* message) {
+    if (!condition) {
+        printf("  ASSERTION FAILED: %s\n", message);
+        current_test_passed = 0;
+    }
+}
+
+void omni_assert_eq_int(int32_t expected, int32_t actual, const char* message) {
+    if (expected != actual) {
+        printf("  ASSERTION FAILED: %s (expected: %d, actual: %d)\n", message, expected, actual);
+        current_test_passed = 0;
+    }
+}
+
+void omni_assert_eq_string(const char* expected, const char* actual, const char* message) {
+    if (strcmp(expected, actual) != 0) {
+        printf("  ASSERTION FAILED: %s (expected: \"%s\", actual: \"%s\")\n", message, expected, actual);
+        current_test_passed = 0;
+    }
+}
+
+void omni_assert_eq_float(double expected, double actual, const char* message) {
+    const double epsilon = 1e-9;
+    if (fabs(expected - actual) > epsilon) {
+        printf("  ASSERTION FAILED: %s (expected: %f, actual: %f)\n", message, expected, actual);
+        current_test_passed = 0;
+    }
+}
+
+void omni_assert_true(int32_t condition, const char* message) {
+    if (!condition) {
+        printf("  ASSERTION FAILED: %s (expected: true, actual: false)\n", message);
+        current_test_passed = 0;
+    }
+}
+
+void omni_assert_false(int32_t condition, const char* message) {
+    if (condition) {
+        printf("  ASSERTION FAILED: %s (expected: false, actual: true)\n", message);
+        current_test_passed = 0;
+    }
+}
+
+int32_t omni_test_summary() {
+    printf("\nTest Summary: %d/%d tests passed\n", passed_tests, total_tests);
+    if (passed_tests == total_tests) {
+        printf("All tests passed! ✓\n");
+        return 0;
+    } else {
+        printf("Some tests failed! ✗\n");
+        return 1;
+    }
+}
+
+void omni_test_reset() {
+    // Reset test counters (useful when running multiple test files)
+    total_tests = 0;
+    passed_tests = 0;
+    current_test_passed = 1;
+}
+
+// System operations
+void omni_exit(int32_t code) {
+    exit(code);
+}
+
+// Environment variable operations
+const char* omni_getenv(const char* name) {
+    if (!name) return NULL;
+    char* value = getenv(name);
+    if (!value) return NULL;
+    // Return a pointer to the environment variable value
+    // Note: This is valid until the environment is modified
+    return value;
+}
+
+int32_t omni_setenv(const char* name, const char* value) {
+    if (!name) return 0;
+#ifdef _WIN32
+    // Windows uses _putenv_s
+    if (value) {
+        char* env_str = (char*)malloc(strlen(name) + strlen(value) + 2);
+        if (!env_str) return 0;
+        sprintf(env_str, "%s=%s", name, value);
+        int result = _putenv(env_str);
+        free(env_str);
+        return (result == 0) ? 1 : 0;
+    } else {
+        // Unset by setting to empty
+        char* env_str = (char*)malloc(strlen(name) + 2);
+        if (!env_str) return 0;
+        sprintf(env_str, "%s=", name);
+        int result = _putenv(env_str);
+        free(env_str);
+        return (result == 0) ? 1 : 0;
+    }
+#else
+    // POSIX uses setenv
+    if (value) {
+        return (setenv(name, value, 1) == 0) ? 1 : 0;
+    } else {
+        return (unsetenv(name) == 0) ? 1 : 0;
+    }
+#endif
+}
+
+int32_t omni_unsetenv(const char* name) {
+    if (!name) return 0;
+#ifdef _WIN32
+    // Windows: set to empty string
+    char* env_str = (char*)malloc(strlen(name) + 2);
+    if (!env_str) return 0;
+    sprintf(env_str, "%s=", name);
+    int result = _putenv(env_str);
+    free(env_str);
+    return (result == 0) ? 1 : 0;
+#else
+    return (unsetenv(name) == 0) ? 1 : 0;
+#endif
+}
+
+// Directory operations
+const char* omni_getcwd(void) {
+    static char cwd[PATH_MAX];
+#ifdef _WIN32
+    if (_getcwd(cwd, sizeof(cwd)) != NULL) {
+        return cwd;
+    }
+#else
+    if (getcwd(cwd, sizeof(cwd)) != NULL) {
+        return cwd;
+    }
+#endif
+    return NULL;
+}
+
+int32_t omni_chdir(const char* path) {
+    if (!path) return 0;
+#ifdef _WIN32
+    return (_chdir(path) == 0) ? 1 : 0;
+#else
+    return (chdir(path) == 0) ? 1 : 0;
+#endif
+}
+
+// File system operations
+int32_t omni_mkdir(const char* path) {
+    if (!path) return 0;
+#ifdef _WIN32
+    return (_mkdir(path) == 0) ? 1 : 0;
+#else
+    return (mkdir(path, 0755) == 0) ? 1 : 0;
+#endif
+}
+
+int32_t omni_rmdir(const char* path) {
+    if (!path) return 0;
+#ifdef _WIN32
+    return (_rmdir(path) == 0) ? 1 : 0;
+#else
+    return (rmdir(path) == 0) ? 1 : 0;
+#endif
+}
+
+int32_t omni_remove(const char* path) {
+    if (!path) return 0;
+    return (remove(path) == 0) ? 1 : 0;
+}
+
+int32_t omni_rename(const char* old_path, const char* new_path) {
+    if (!old_path || !new_path) return 0;
+    return (rename(old_path, new_path) == 0) ? 1 : 0;
+}
+
+// File copy
+// The fastest mechanism the platform offers goes first: a reflink clone
+// (FICLONE, clonefile) shares the blocks outright, copy_file_range and
+// sendfile keep the data in the kernel, and a plain read/write loop with a
+// large buffer catches everything else. Each stage continues from the
+// descriptor offsets the previous one left behind.
+#define OMNI_COPY_BUFFER (1024 * 1024)
+
+#ifndef _WIN32
+static int omni_copy_fd(int src, int dst, const struct stat* st) {
+#ifdef __linux__
+    if (S_ISREG(st->st_mode)) {
+#ifdef FICLONE
+        if (ioctl(dst, FICLONE, src) == 0) {
+            return 1;
+        }
+#endif
+        // copy_file_range returns 0 early on files whose stat size lies
+        // (procfs and friends), so those drop through to the loops below
+        off_t left = st->st_size;
+#ifdef SYS_copy_file_range
+        while (left > 0) {
+            size_t chunk = left > (1 << 30) ? (size_t)1 << 30 : (size_t)left;
+            ssize_t n = syscall(SYS_copy_file_range, src, NULL, dst, NULL, chunk, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            left -= n;
+        }
+#endif
+        while (left > 0) {
+            size_t chunk = left > (1 << 30) ? (size_t)1 << 30 : (size_t)left;
+            ssize_t n = sendfile(dst, src, NULL, chunk);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            left -= n;
+        }
+    }
+#endif
+    char* buffer = (char*)malloc(OMNI_COPY_BUFFER);
+    if (!buffer) {
+        return 0;
+    }
+    int ok = 1;
+    for (;;) {
+        ssize_t n = read(src, buffer, OMNI_COPY_BUFFER);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ok = n == 0;
+            break;
+        }
+        char* p = buffer;
+        while (n > 0) {
+            ssize_t w = write(dst, p, (size_t)n);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) break;
+            p += w;
+            n -= w;
+        }
+        if (n > 0) {
+            ok = 0;
+            break;
+        }
+    }
+    free(buffer);
+    return ok;
+}
+#endif
+
+int32_t omni_copy(const char* src_path, const char* dst_path) {
+    if (!src_path || !dst_path) return 0;
+#ifdef _WIN32
+    // CopyFile already uses block cloning where the file system has it
+    return CopyFileA(src_path, dst_path, FALSE) ? 1 : 0;
+#else
+    int src = open(src_path, O_RDONLY | O_CLOEXEC);
+    if (src < 0) return 0;
+    struct stat st;
+    if (fstat(src, &st) != 0 || S_ISDIR(st.st_mode)) {
+        close(src);
+        return 0;
+    }
+#ifdef __APPLE__
+    // clonefile only creates files; an existing destination is copied into
+    if (S_ISREG(st.st_mode) && clonefile(src_path, dst_path, 0) == 0) {
+        close(src);
+        return 1;
+    }
+#endif
+    int dst = open(dst_path, O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+    if (dst < 0) {
+        close(src);
+        return 0;
+    }
+    // Truncate only after checking this is not the source itself
+    struct stat dst_st;
+    int32_t success = fstat(dst, &dst_st) == 0 &&
+                      !(dst_st.st_dev == st.st_dev && dst_st.st_ino == st.st_ino) &&
+                      (!S_ISREG(dst_st.st_mode) || ftruncate(dst, 0) == 0) &&
+                      omni_copy_fd(src, dst, &st);
+    close(src);
+    if (close(dst) != 0) success = 0;
+    return success;
+#endif
+}
+
+int32_t omni_exists(const char* path) {
+    if (!path) return 0;
+    struct stat st;
+    return (stat(path, &st) == 0) ? 1 : 0;
+}
+
+int32_t omni_is_file(const char* path) {
+    if (!path) return 0;
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+    return S_ISREG(st.st_mode) ? 1 : 0;
+}
+
+int32_t omni_is_dir(const char* path) {
+    if (!path) return 0;
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+    return S_ISDIR(st.st_mode) ? 1 : 0;
+}
+
+// String validation functions
+int32_t omni_string_is_alpha(const char* str) {
+    if (!str) return 0;
+    for (const char* p = str; *p; p++) {
+        if (!isalpha((unsigned char)*p)) {
+            return 0;
+        }
+    }
+    return (*str != '\0') ? 1 : 0;
+}
+
+int32_t omni_string_is_digit(const char* str) {
+    if (!str) return 0;
+    size_t len = strlen(str);
+    return (len > 0 && omni_scan(str, len, OMNI_SCAN_NON_DIGIT) == len) ? 1 : 0;
+}
+
+int32_t omni_string_is_alnum(const char* str) {
+    if (!str) return 0;
+    for (const char* p = str; *p; p++) {
+        if (!isalnum((unsigned char)*p)) {
+            return 0;
+        }
+    }
+    return (*str != '\0') ? 1 : 0;
+}
+
+int32_t omni_string_is_ascii(const char* str) {
+    if (!str) return 1;
+    size_t len = strlen(str);
+    return omni_scan(str, len, OMNI_SCAN_NON_ASCII) == len ? 1 : 0;
+}
+
+int32_t omni_string_is_upper(const char* str) {
+    if (!str || *str == '\0') return 0;
+    for (const char* p = str; *p; p++) {
+        if (islower((unsigned char)*p)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int32_t omni_string_is_lower(const char* str) {
+    if (!str || *str == '\0') return 0;
+    for (const char* p = str; *p; p++) {
+        if (isupper((unsigned char)*p)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// String encoding/escaping functions (base64 implementations moved below)
+
+char* omni_encode_url(const char* str) {
+    if (!str) return NULL;
+    // URL encoding: %XX for non-ASCII and special chars
+    size_t len = strlen(str);
+    char* result = (char*)malloc(len * 3 + 1);
+    if (!result) return NULL;
+    
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)str[i];
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || 
+            (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~') {
+            result[j++] = c;
+        } else {
+            sprintf(result + j, "%%%02X", c);
+            j += 3;
+        }
+    }
+    result[j] = '\0';
+    return result;
+}
+
+char* omni_decode_url(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    char* result = (char*)malloc(len + 1);
+    if (!result) return NULL;
+    
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (str[i] == '%' && i + 2 < len) {
+            char hex[3] = {str[i+1], str[i+2], '\0'};
+            int value;
+            if (sscanf(hex, "%x", &value) == 1) {
+                result[j++] = (char)value;
+                i += 2;
+            } else {
+                result[j++] = str[i];
+            }
+        } else if (str[i] == '+') {
+            result[j++] = ' ';
+        } else {
+            result[j++] = str[i];
+        }
+    }
+    result[j] = '\0';
+    return result;
+}
+
+// Escaping copies the runs between escaped characters whole: a first pass
+// over the hits sizes the result exactly, a second one fills it in
+static const char* omni_html_entity(char c) {
+    switch (c) {
+        case '&': return "&amp;";
+        case '<': return "&lt;";
+        case '>': return "&gt;";
+        case '"': return "&quot;";
+        default: return "&#39;";
+    }
+}
+
+char* omni_escape_html(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    size_t out_len = len;
+    for (size_t i = omni_scan(str, len, OMNI_SCAN_HTML); i < len;
+         i += 1 + omni_scan(str + i + 1, len - i - 1, OMNI_SCAN_HTML)) {
+        out_len += strlen(omni_html_entity(str[i])) - 1;
+    }
+    char* result = (char*)malloc(out_len + 1);
+    if (!result) return NULL;
+    
+    size_t i = 0, j = 0;
+    while (i < len) {
+        size_t run = omni_scan(str + i, len - i, OMNI_SCAN_HTML);
+        memcpy(result + j, str + i, run);
+        i += run;
+        j += run;
+        if (i < len) {
+            const char* entity = omni_html_entity(str[i++]);
+            size_t n = strlen(entity);
+            memcpy(result + j, entity, n);
+            j += n;
+        }
+    }
+    result[j] = '\0';
+    return result;
+}
+
+char* omni_unescape_html(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    char* result = (char*)malloc(len + 1);
+    if (!result) return NULL;
+    
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (str[i] == '&' && i + 3 < len) {
+            if (strncmp(str + i, "&lt;", 4) == 0) {
+                result[j++] = '<';
+                i += 3;
+            } else if (strncmp(str + i, "&gt;", 4) == 0) {
+                result[j++] = '>';
+                i += 3;
+            } else if (strncmp(str + i, "&amp;", 5) == 0) {
+                result[j++] = '&';
+                i += 4;
+            } else if (strncmp(str + i, "&quot;", 6) == 0) {
+                result[j++] = '"';
+                i += 5;
+            } else if (strncmp(str + i, "&#39;", 5) == 0) {
+                result[j++] = '\'';
+                i += 4;
+            } else {
+                result[j++] = str[i];
+            }
+        } else {
+            result[j++] = str[i];
+        }
+    }
+    result[j] = '\0';
+    return result;
+}
+
+// Writes the JSON escape of c to out (if not NULL); returns its length
+static size_t omni_json_escape(unsigned char c, char* out) {
+    char short_form = 0;
+    switch (c) {
+        case '"': short_form = '"'; break;
+        case '\\': short_form = '\\'; break;
+        case '\b': short_form = 'b'; break;
+        case '\f': short_form = 'f'; break;
+        case '\n': short_form = 'n'; break;
+        case '\r': short_form = 'r'; break;
+        case '\t': short_form = 't'; break;
+    }
+    if (short_form) {
+        if (out) {
+            out[0] = '\\';
+            out[1] = short_form;
+        }
+        return 2;
+    }
+    // Other control characters
+    if (out) {
+        static const char hex[] = "0123456789abcdef";
+        memcpy(out, "\\u00", 4);
+        out[4] = hex[c >> 4];
+        out[5] = hex[c & 0xF];
+    }
+    return 6;
+}
+
+char* omni_escape_json(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    size_t out_len = len;
+    for (size_t i = omni_scan(str, len, OMNI_SCAN_JSON); i < len;
+         i += 1 + omni_scan(str + i + 1, len - i - 1, OMNI_SCAN_JSON)) {
+        out_len += omni_json_escape((unsigned char)str[i], NULL) - 1;
+    }
+    char* result = (char*)malloc(out_len + 1);
+    if (!result) return NULL;
+    
+    size_t i = 0, j = 0;
+    while (i < len) {
+        size_t run = omni_scan(str + i, len - i, OMNI_SCAN_JSON);
+        memcpy(result + j, str + i, run);
+        i += run;
+        j += run;
+        if (i < len) {
+            j += omni_json_escape((unsigned char)str[i++], result + j);
+        }
+    }
+    result[j] = '\0';
+    return result;
+}
+
+char* omni_escape_shell(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    char* result = (char*)malloc(len * 2 + 3); // Worst case: all chars escaped + quotes
+    if (!result) return NULL;
+    
+    result[0] = '\'';
+    size_t j = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (str[i] == '\'') {
+            result[j++] = '\'';
+            result[j++] = '\\';
+            result[j++] = '\'';
+            result[j++] = '\'';
+        } else {
+            result[j++] = str[i];
+        }
+    }
+    result[j++] = '\'';
+    result[j] = '\0';
+    return result;
+}
+
+// Base64 encoding/decoding (kernels in the SIMD string kernels section)
+char* omni_encode_base64(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    char* result = (char*)malloc(((len + 2) / 3) * 4 + 1);
+    if (!result) return NULL;
+    
+    size_t j = omni_base64_encode(result, (const unsigned char*)str, len);
+    result[j] = '\0';
+    return result;
+}
+
+char* omni_decode_base64(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str);
+    // Up to two '=' of padding
+    if (len > 0 && str[len - 1] == '=') len--;
+    if (len > 0 && str[len - 1] == '=') len--;
+    
+    size_t out_len = (len / 4) * 3 + ((len % 4) * 3) / 4;
+    char* result = (char*)malloc(out_len + 1);
+    if (!result) return NULL;
+    
+    int64_t j = omni_base64_decode((unsigned char*)result, out_len + 1, str, len);
+    if (j < 0) {
+        free(result);
+        return NULL;
+    }
+    result[j] = '\0';
+    return result;
+}
+
+// Regex functions using POSIX regex
+//
+// Compiled patterns are shared through a small LRU cache keyed by pattern and
+// flags, so a pattern used over and over is compiled once. Handles are
+// reference counted: an entry evicted from the cache stays alive until the
+// last handle to it is released.
+#define OMNI_REGEX_CACHE_SIZE 64
+
+struct omni_regex {
+    char* pattern;
+    uint32_t hash;
+    int32_t flags;
+    int32_t refs;    // Handles held by callers
+    int32_t cached;  // Whether the cache still references it
+    uint64_t last_used;
+    regex_t compiled;
+};
+
+static omni_regex_t* omni_regex_cache[OMNI_REGEX_CACHE_SIZE];
+static uint64_t omni_regex_clock = 0;
+
+#ifdef _WIN32
+static CRITICAL_SECTION omni_regex_mutex;
+static int omni_regex_mutex_initialized = 0;
+#else
+static pthread_mutex_t omni_regex_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void omni_regex_lock(void) {
+#ifdef _WIN32
+    if (!omni_regex_mutex_initialized) {
+        InitializeCriticalSection(&omni_regex_mutex);
+        omni_regex_mutex_initialized = 1;
+    }
+    EnterCriticalSection(&omni_regex_mutex);
+#else
+    pthread_mutex_lock(&omni_regex_mutex);
+#endif
+}
+
+static void omni_regex_unlock(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&omni_regex_mutex);
+#else
+    pthread_mutex_unlock(&omni_regex_mutex);
+#endif
+}
+
+static void omni_regex_destroy(omni_regex_t* re) {
+    regfree(&re->compiled);
+    free(re->pattern);
+    free(re);
+}
+
+// Must be called with the cache locked
+static omni_regex_t* omni_regex_cache_find(const char* pattern, uint32_t hash, int32_t flags) {
+    int i;
+    for (i = 0; i < OMNI_REGEX_CACHE_SIZE; i++) {
+        omni_regex_t* re = omni_regex_cache[i];
+        if (re && re->hash == hash && re->flags == flags && strcmp(re->pattern, pattern) == 0) {
+            return re;
+        }
+    }
+    return NULL;
+}
+
+// Must be called with the cache locked
+static void omni_regex_cache_insert(omni_regex_t* re) {
+    int victim = 0;
+    int i;
+    for (i = 0; i < OMNI_REGEX_CACHE_SIZE; i++) {
+        if (!omni_regex_cache[i]) {
+            victim = i;
+            break;
+        }
+        if (omni_regex_cache[i]->last_used < omni_regex_cache[victim]->last_used) {
+            victim = i;
+        }
+    }
+    omni_regex_t* evicted = omni_regex_cache[victim];
+    if (evicted) {
+        evicted->cached = 0;
+        if (evicted->refs == 0) omni_regex_destroy(evicted);
+    }
+    re->cached = 1;
+    omni_regex_cache[victim] = re;
+}
+
+omni_regex_t* omni_regex_compile(const char* pattern, int32_t flags) {
+    if (!pattern) return NULL;
+    uint32_t hash = (uint32_t)hash_bytes(pattern, strlen(pattern)) ^ (uint32_t)flags;
+
+    omni_regex_lock();
+    omni_regex_t* re = omni_regex_cache_find(pattern, hash, flags);
+    if (re) {
+        re->refs++;
+        re->last_used = ++omni_regex_clock;
+        omni_regex_unlock();
+        return re;
+    }
+    omni_regex_unlock();
+
+    // Compile outside the lock; it is by far the expensive part
+    re = (omni_regex_t*)malloc(sizeof(omni_regex_t));
+    if (!re) return NULL;
+    re->pattern = strdup(pattern);
+    if (!re->pattern) {
+        free(re);
+        return NULL;
+    }
+    int cflags = REG_EXTENDED;
+    if (flags & OMNI_REGEX_ICASE) cflags |= REG_ICASE;
+    if (flags & OMNI_REGEX_NEWLINE) cflags |= REG_NEWLINE;
+    if (regcomp(&re->compiled, pattern, cflags) != 0) {
+        free(re->pattern);
+        free(re);
+        return NULL; // Invalid pattern
+    }
+    re->hash = hash;
+    re->flags = flags;
+    re->refs = 1;
+    re->cached = 0;
+
+    omni_regex_lock();
+    omni_regex_t* existing = omni_regex_cache_find(pattern, hash, flags);
+    if (existing) {
+        // Another thread compiled it in the meantime
+        existing->refs++;
+        existing->last_used = ++omni_regex_clock;
+        omni_regex_unlock();
+        omni_regex_destroy(re);
+        return existing;
+    }
+    re->last_used = ++omni_regex_clock;
+    omni_regex_cache_insert(re);
+    omni_regex_unlock();
+    return re;
+}
+
+void omni_regex_free(omni_regex_t* re) {
+    if (!re) return;
+    omni_regex_lock();
+    re->refs--;
+    int dead = re->refs == 0 && !re->cached;
+    omni_regex_unlock();
+    if (dead) omni_regex_destroy(re);
+}
+
+int32_t omni_regex_exec(const omni_regex_t* re, const char* str, int32_t* match_start, int32_t* match_end) {
+    if (!re || !str) return 0;
+    regmatch_t match;
+    if (regexec(&re->compiled, str, 1, &match, 0) != 0 || match.rm_so < 0) {
+        return 0;
+    }
+    if (match_start) *match_start = (int32_t)match.rm_so;
+    if (match_end) *match_end = (int32_t)match.rm_eo;
+    return 1;
+}
+
+char* omni_regex_find_match(const omni_regex_t* re, const char* str) {
+    int32_t start, end;
+    if (!omni_regex_exec(re, str, &start, &end)) return NULL;
+
+    size_t match_len = (size_t)(end - start);
+    char* result = (char*)malloc(match_len + 1);
+    if (result) {
+        memcpy(result, str + start, match_len);
+        result[match_len] = '\0';
+    }
+    return result;
+}
+
+char* omni_regex_find_all_matches(const omni_regex_t* re, const char* str, int32_t* count) {
+    if (!re || !str || !count) return NULL;
+
+    *count = 0;
+    // Count matches first
+    regmatch_t match;
+    const char* search_start = str;
+    int match_count = 0;
+    while (regexec(&re->compiled, search_start, 1, &match, 0) == 0 && match.rm_so >= 0) {
+        match_count++;
+        search_start += match.rm_eo;
+    }
+
+    if (match_count == 0) {
+        char* result = (char*)malloc(1);
+        if (result) result[0] = '\0';
+        return result;
+    }
+
+    // Allocate array: each match is stored as "start:end," format
+    // For simplicity, return a comma-separated string of match positions
+    // In a real implementation, this would return an array
+    size_t buf_size = match_count * 32; // Rough estimate
+    char* result = (char*)malloc(buf_size);
+    if (!result) return NULL;
+
+    *count = match_count;
+    search_start = str;
+    size_t pos = 0;
+    int found = 0;
+    while (regexec(&re->compiled, search_start, 1, &match, 0) == 0 && match.rm_so >= 0 && pos < buf_size - 1) {
+        if (found > 0) {
+            result[pos++] = ',';
+        }
+        int start_pos = (int)(search_start - str) + match.rm_so;
+        int end_pos = (int)(search_start - str) + match.rm_eo;
+        int written = snprintf(result + pos, buf_size - pos, "%d:%d", start_pos, end_pos);
+        if (written > 0) pos += written;
+        search_start += match.rm_eo;
+        found++;
+    }
+    result[pos] = '\0';
+    return result;
+}
+
+char* omni_regex_replace(const omni_regex_t* re, const char* str, const char* replacement) {
+    if (!re || !str || !replacement) return NULL;
+
+    regmatch_t matches[1];
+    const char* search_start = str;
+    size_t repl_len = strlen(replacement);
+    size_t result_size = strlen(str) + repl_len + 1;
+    char* result = (char*)malloc(result_size);
+    if (!result) return NULL;
+
+    size_t result_pos = 0;
+
+    while (regexec(&re->compiled, search_start, 1, matches, 0) == 0 && matches[0].rm_so >= 0) {
+        // Copy text before match
+        size_t before_len = matches[0].rm_so;
+        if (result_pos + before_len + repl_len + 1 >= result_size) {
+            result_size = result_pos + before_len + repl_len + 100;
+            char* grown = (char*)realloc(result, result_size);
+            if (!grown) {
+                free(result);
+                return NULL;
+            }
+            result = grown;
+        }
+        memcpy(result + result_pos, search_start, before_len);
+        result_pos += before_len;
+
+        // Copy replacement
+        memcpy(result + result_pos, replacement, repl_len);
+        result_pos += repl_len;
+
+        search_start += matches[0].rm_eo;
+    }
+
+    // Copy remaining text
+    size_t remaining = strlen(search_start);
+    if (result_pos + remaining + 1 >= result_size) {
+        result_size = result_pos + remaining + 1;
+        char* grown = (char*)realloc(result, result_size);
+        if (!grown) {
+            free(result);
+            return NULL;
+        }
+        result = grown;
+    }
+    memcpy(result + result_pos, search_start, remaining);
+    result_pos += remaining;
+    result[result_pos] = '\0';
+    return result;
+}
+
+int32_t omni_string_matches(const char* str, const char* pattern) {
+    if (!str || !pattern) return 0;
+    omni_regex_t* re = omni_regex_compile(pattern, 0);
+    if (!re) return 0; // Invalid pattern
+    int32_t result = omni_regex_exec(re, str, NULL, NULL);
+    omni_regex_free(re);
+    return result;
+}
+
+char* omni_string_find_match(const char* str, const char* pattern) {
+    if (!str || !pattern) return NULL;
+    omni_regex_t* re = omni_regex_compile(pattern, 0);
+    if (!re) return NULL; // Invalid pattern
+    char* result = omni_regex_find_match(re, str);
+    omni_regex_free(re);
+    return result;
+}
+
+char* omni_string_find_all_matches(const char* str, const char* pattern, int32_t* count) {
+    if (!str || !pattern || !count) return NULL;
+    *count = 0;
+    omni_regex_t* re = omni_regex_compile(pattern, 0);
+    if (!re) return NULL; // Invalid pattern
+    char* result = omni_regex_find_all_matches(re, str, count);
+    omni_regex_free(re);
+    return result;
+}
+
+char* omni_string_replace_regex(const char* str, const char* pattern, const char* replacement) {
+    if (!str || !pattern || !replacement) return NULL;
+    omni_regex_t* re = omni_regex_compile(pattern, 0);
+    if (!re) return NULL; // Invalid pattern
+    char* result = omni_regex_replace(re, str, replacement);
+    omni_regex_free(re);
+    return result;
+}
+
+// Time functions
+int64_t omni_time_now_unix(void) {
+    return (int64_t)time(NULL);
+}
+
+int64_t omni_time_now_unix_nano(void) {
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    ULARGE_INTEGER uli;
+    uli.LowPart = ft.dwLowDateTime;
+    uli.HighPart = ft.dwHighDateTime;
+    // Windows file time is in 100-nanosecond intervals since 1601-01-01
+    // Convert to Unix epoch (seconds since 1970-01-01)
+    return (int64_t)((uli.QuadPart / 10000000ULL) - 11644473600ULL) * 1000000000ULL + 
+           (int64_t)((uli.QuadPart % 10000000ULL) * 100);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+#endif
+}
+
+int64_t omni_time_now_monotonic_nano(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (int64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000LL +
+           (int64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000LL / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+#endif
+}
+
+void omni_time_sleep_seconds(double seconds) {
+    if (seconds <= 0.0) return;
+#ifdef _WIN32
+    Sleep((DWORD)(seconds * 1000.0));
+#else
+    struct timespec req;
+    req.tv_sec = (time_t)seconds;
+    req.tv_nsec = (long)((seconds - req.tv_sec) * 1000000000.0);
+    // Signals (the profiler's SIGPROF among them) must not cut the sleep short
+    while (nanosleep(&req, &req) == -1 && errno == EINTR) {
+    }
+#endif
+}
+
+void omni_time_sleep_milliseconds(int32_t milliseconds) {
+    if (milliseconds <= 0) return;
+    omni_time_sleep_seconds(milliseconds / 1000.0);
+}
+
+int32_t omni_time_zone_offset(void) {
+    time_t now = time(NULL);
+    // Use portable calculation method that works on all platforms
+    // Calculate offset by comparing local and UTC time
+    struct tm local_tm, utc_tm;
+    struct tm* local = localtime_r(&now, &local_tm);
+    struct tm* utc = gmtime_r(&now, &utc_tm);
+    if (!local || !utc) return 0;
+    return (int32_t)(mktime(&local_tm) - mktime(&utc_tm));
+}
+
+const char* omni_time_zone_name(void) {
+    static char tz_name[64];
+    const char* tz = getenv("TZ");
+    if (tz) {
+        strncpy(tz_name, tz, sizeof(tz_name) - 1);
+        tz_name[sizeof(tz_name) - 1] = '\0';
+        return tz_name;
+    }
+    return "UTC";
+}
+
+// Command-line argument functions
+static char** omni_args_array = NULL;
+static int32_t omni_args_count_val = 0;
+
+void omni_args_init(int argc, char** argv) {
+    omni_args_array = argv;
+    omni_args_count_val = argc;
+}
+
+int32_t omni_args_count(void) {
+    return omni_args_count_val;
+}
+
+const char* omni_args_get(int32_t index) {
+    if (!omni_args_array || index < 0 || index >= omni_args_count_val) {
+        return NULL;
+    }
+    return omni_args_array[index];
+}
+
+int32_t omni_args_has_flag(const char* name) {
+    if (!name || !omni_args_array) return 0;
+    char flag[256];
+    snprintf(flag, sizeof(flag), "--%s", name);
+    for (int32_t i = 1; i < omni_args_count_val; i++) {
+        if (strcmp(omni_args_array[i], flag) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char* omni_args_get_flag(const char* name, const char* default_value) {
+    if (!name || !omni_args_array) return default_value;
+    char flag[256];
+    snprintf(flag, sizeof(flag), "--%s=", name);
+    size_t flag_len = strlen(flag);
+    
+    for (int32_t i = 1; i < omni_args_count_val; i++) {
+        if (strncmp(omni_args_array[i], flag, flag_len) == 0) {
+            return omni_args_array[i] + flag_len;
+        }
+        if (strcmp(omni_args_array[i], flag) == 0 && i + 1 < omni_args_count_val) {
+            return omni_args_array[i + 1];
+        }
+    }
+    return default_value;
+}
+
+const char* omni_args_positional(int32_t index, const char* default_value) {
+    if (!omni_args_array) return default_value;
+    int32_t pos_idx = 0;
+    for (int32_t i = 1; i < omni_args_count_val; i++) {
+        if (omni_args_array[i][0] != '-') {
+            if (pos_idx == index) {
+                return omni_args_array[i];
+            }
+            pos_idx++;
+        }
+    }
+    return default_value;
+}
+
+// Process ID functions
+int32_t omni_getpid(void) {
+#ifdef _WIN32
+    return (int32_t)GetCurrentProcessId();
+#else
+    return (int32_t)getpid();
+#endif
+}
+
+int32_t omni_getppid(void) {
+#ifdef _WIN32
+    // Windows doesn't have a direct equivalent
+    return 0;
+#else
+    return (int32_t)getppid();
+#endif
+}
+
+// Entry point - this will be implemented by the generated code
+// The generated code will provide the omni_main function
+
+// ============================================================================
+// Number Formatting and Parsing
+// ============================================================================
+
+// Integers are written two digits at a time from a table of digit pairs,
+// right to left into a field whose width is computed up front. Doubles are
+// printed with Ryu (Adams, PLDI 2018), which finds the shortest decimal
+// that rounds back to the same double from 128-bit approximations of powers
+// of five. Parsing follows fast_float: eight digits are folded at a time
+// with SWAR arithmetic, short exact inputs take Clinger's fast path, the
+// rest go through the Eisel-Lemire algorithm, and the rare inputs it cannot
+// round with certainty fall back to strtod. Nothing here allocates except
+// that fallback for inputs longer than its stack buffer.
+//
+// Both directions read one table of powers of ten, each truncated to its
+// leading 128 bits. It is computed from exact big integers on first use,
+// which takes a few microseconds.
+
+static const char omni_digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const uint64_t omni_pow10_u64[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+static int32_t omni_decimal_digits(uint64_t value) {
+    if (value == 0) return 1;
+    // bits * log10(2) is the digit count or one more
+    int32_t guess = ((64 - __builtin_clzll(value)) * 1233) >> 12;
+    return guess + 1 - (value < omni_pow10_u64[guess]);
+}
+
+static size_t omni_format_u64(char* buf, uint64_t value) {
+    size_t len = (size_t)omni_decimal_digits(value);
+    char* p = buf + len;
+    while (value >= 100) {
+        uint64_t rest = value / 100;
+        const char* pair = omni_digit_pairs + (value - rest * 100) * 2;
+        p -= 2;
+        p[0] = pair[0];
+        p[1] = pair[1];
+        value = rest;
+    }
+    if (value >= 10) {
+        p -= 2;
+        p[0] = omni_digit_pairs[value * 2];
+        p[1] = omni_digit_pairs[value * 2 + 1];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    return len;
+}
+
+size_t omni_format_int(char* buf, int64_t value) {
+    if (value < 0) {
+        buf[0] = '-';
+        return 1 + omni_format_u64(buf + 1, 0 - (uint64_t)value);
+    }
+    return omni_format_u64(buf, (uint64_t)value);
+}
+
+// Powers of ten from 10^-342 (below which every 19-digit input rounds to
+// zero) to 10^325 (the largest power of five Ryu needs)
+#define OMNI_POW10_MIN (-342)
+#define OMNI_POW10_MAX 325
+#define OMNI_BIGNUM_LIMBS 34
+
+typedef struct {
+    uint64_t hi;
+    uint64_t lo;
+} omni_u128_t;
+
+static omni_u128_t omni_pow10_table[OMNI_POW10_MAX - OMNI_POW10_MIN + 1];
+static int32_t omni_pow10_state = 0; // 0 = not built, 1 = building, 2 = ready
+
+// 32 bits of a little-endian big integer starting at bit pos; bits below
+// zero read as zeros
+static uint32_t omni_bignum_bits32(const uint32_t* limbs, int32_t pos) {
+    int32_t limb = pos >= 0 ? pos / 32 : -((31 - pos) / 32);
+    int32_t shift = pos - limb * 32;
+    uint64_t lo = (limb >= 0 && limb < OMNI_BIGNUM_LIMBS) ? limbs[limb] : 0;
+    uint64_t hi = (limb + 1 >= 0 && limb + 1 < OMNI_BIGNUM_LIMBS) ? limbs[limb + 1] : 0;
+    return (uint32_t)(((hi << 32) | lo) >> shift);
+}
+
+// The leading 128 bits of a nonzero big integer, truncated
+static omni_u128_t omni_bignum_top128(const uint32_t* limbs) {
+    int32_t top = OMNI_BIGNUM_LIMBS - 1;
+    while (limbs[top] == 0) top--;
+    int32_t pos = top * 32 + (32 - __builtin_clz(limbs[top])) - 128;
+    omni_u128_t r;
+    r.hi = ((uint64_t)omni_bignum_bits32(limbs, pos + 96) << 32) | omni_bignum_bits32(limbs, pos + 64);
+    r.lo = ((uint64_t)omni_bignum_bits32(limbs, pos + 32) << 32) | omni_bignum_bits32(limbs, pos);
+    return r;
+}
+
+static void omni_pow10_build(void) {
+    uint32_t big[OMNI_BIGNUM_LIMBS];
+
+    // 10^q has the leading bits of 5^q
+    memset(big, 0, sizeof(big));
+    big[0] = 1;
+    for (int32_t q = 0; q <= OMNI_POW10_MAX; q++) {
+        omni_pow10_table[q - OMNI_POW10_MIN] = omni_bignum_top128(big);
+        uint64_t carry = 0;
+        for (int32_t i = 0; i < OMNI_BIGNUM_LIMBS; i++) {
+            uint64_t cur = (uint64_t)big[i] * 5 + carry;
+            big[i] = (uint32_t)cur;
+            carry = cur >> 32;
+        }
+    }
+
+    // 10^-q has the leading bits of 2^1056 / 5^q, and flooring each
+    // division by 5 along the way floors the whole quotient
+    memset(big, 0, sizeof(big));
+    big[OMNI_BIGNUM_LIMBS - 1] = 1;
+    for (int32_t q = 1; q <= -OMNI_POW10_MIN; q++) {
+        uint64_t rem = 0;
+        for (int32_t i = OMNI_BIGNUM_LIMBS - 1; i >= 0; i--) {
+            uint64_t cur = (rem << 32) | big[i];
+            big[i] = (uint32_t)(cur / 5);
+            rem = cur % 5;
+        }
+        omni_pow10_table[-q - OMNI_POW10_MIN] = omni_bignum_top128(big);
+    }
+}
+
+static void omni_pow10_ready(void) {
+    if (OMNI_LOAD_ACQUIRE(&omni_pow10_state) == 2) return;
+    int32_t expected = 0;
+    if (__atomic_compare_exchange_n(&omni_pow10_state, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        omni_pow10_build();
+        OMNI_STORE_RELEASE(&omni_pow10_state, 2);
+        return;
+    }
+    while (OMNI_LOAD_ACQUIRE(&omni_pow10_state) != 2) {
+#ifdef _WIN32
+        SwitchToThread();
+#else
+        sched_yield();
+#endif
+    }
+}
+
+// Full 64x64-bit product; returns the low half
+static inline uint64_t omni_umul128(uint64_t a, uint64_t b, uint64_t* hi) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *hi = (uint64_t)(product >> 64);
+    return (uint64_t)product;
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+    uint64_t mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+    *hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+    return (mid << 32) | (uint32_t)p0;
+#endif
+}
+
+// Ryu multiplies by 125-bit powers of five: 5^i rounded down, and
+// 2^k / 5^i rounded up. Both are the table entries shifted down 3 bits.
+static omni_u128_t omni_ryu_pow5(int32_t i) {
+    omni_u128_t t = omni_pow10_table[i - OMNI_POW10_MIN];
+    omni_u128_t r = {t.hi >> 3, (t.lo >> 3) | (t.hi << 61)};
+    return r;
+}
+
+static omni_u128_t omni_ryu_inv_pow5(int32_t i) {
+    if (i == 0) {
+        omni_u128_t one = {1ULL << 61, 1};
+        return one;
+    }
+    omni_u128_t r = omni_ryu_pow5(-i);
+    r.lo++;
+    r.hi += r.lo == 0;
+    return r;
+}
+
+// ceil(log2(5^e)), or 1 for e == 0
+static inline int32_t omni_ryu_pow5_bits(int32_t e) {
+    return ((e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e)) and floor(log10(5^e))
+static inline int32_t omni_ryu_log10_pow2(int32_t e) {
+    return (e * 78913) >> 18;
+}
+
+static inline int32_t omni_ryu_log10_pow5(int32_t e) {
+    return (e * 732923) >> 20;
+}
+
+static inline int omni_ryu_multiple_of_pow5(uint64_t value, int32_t p) {
+    int32_t count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+static inline int omni_ryu_multiple_of_pow2(uint64_t value, int32_t p) {
+    return (value & ((1ULL << p) - 1)) == 0;
+}
+
+// (m * mul) >> j for 64 < j < 128
+static inline uint64_t omni_ryu_mul_shift(uint64_t m, omni_u128_t mul, int32_t j) {
+    uint64_t high0, high1;
+    omni_umul128(m, mul.lo, &high0);
+    uint64_t low1 = omni_umul128(m, mul.hi, &high1);
+    uint64_t sum = high0 + low1;
+    high1 += sum < high0;
+    int32_t shift = j - 64;
+    return (high1 << (64 - shift)) | (sum >> shift);
+}
+
+// The shortest digits d and exponent e with d * 10^e inside the rounding
+// interval of a finite, nonzero double
+static void omni_ryu_shortest(uint64_t ieee_mantissa, uint32_t ieee_exponent, uint64_t* digits, int32_t* exponent) {
+    int32_t e2;
+    uint64_t m2;
+    if (ieee_exponent == 0) {
+        e2 = 1 - 1023 - 52 - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (int32_t)ieee_exponent - 1023 - 52 - 2;
+        m2 = (1ULL << 52) | ieee_mantissa;
+    }
+    const int accept_bounds = (m2 & 1) == 0;
+
+    // The double and the midpoints to its neighbours, scaled by 4
+    const uint64_t mv = 4 * m2;
+    const uint64_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+    uint64_t vr, vp, vm;
+    int32_t e10;
+    int vm_trailing_zeros = 0;
+    int vr_trailing_zeros = 0;
+    if (e2 >= 0) {
+        const int32_t q = omni_ryu_log10_pow2(e2) - (e2 > 3);
+        const int32_t k = 125 + omni_ryu_pow5_bits(q) - 1;
+        const int32_t i = -e2 + q + k;
+        const omni_u128_t mul = omni_ryu_inv_pow5(q);
+        e10 = q;
+        vr = omni_ryu_mul_shift(mv, mul, i);
+        vp = omni_ryu_mul_shift(mv + 2, mul, i);
+        vm = omni_ryu_mul_shift(mv - 1 - mm_shift, mul, i);
+        if (q <= 21) {
+            // Only one of mv, mv + 2 and mv - 1 - mm_shift can be a multiple of 5
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = omni_ryu_multiple_of_pow5(mv, q);
+            } else if (accept_bounds) {
+                vm_trailing_zeros = omni_ryu_multiple_of_pow5(mv - 1 - mm_shift, q);
+            } else {
+                vp -= omni_ryu_multiple_of_pow5(mv + 2, q);
+            }
+        }
+    } else {
+        const int32_t q = omni_ryu_log10_pow5(-e2) - (-e2 > 1);
+        const int32_t i = -e2 - q;
+        const int32_t k = omni_ryu_pow5_bits(i) - 125;
+        const int32_t j = q - k;
+        const omni_u128_t mul = omni_ryu_pow5(i);
+        e10 = q + e2;
+        vr = omni_ryu_mul_shift(mv, mul, j);
+        vp = omni_ryu_mul_shift(mv + 2, mul, j);
+        vm = omni_ryu_mul_shift(mv - 1 - mm_shift, mul, j);
+        if (q <= 1) {
+            // mv has at least two trailing zero bits, so vr is exact
+            vr_trailing_zeros = 1;
+            if (accept_bounds) {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 63) {
+            vr_trailing_zeros = omni_ryu_multiple_of_pow2(mv, q);
+        }
+    }
+
+    // Drop digits while the interval still holds a shorter number
+    int32_t removed = 0;
+    uint32_t last_removed = 0;
+    uint64_t output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        // Exact midpoints are possible; track them to round half to even
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = (uint32_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = (uint32_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+            last_removed = 4;
+        }
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+    } else {
+        int round_up = 0;
+        if (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+    *digits = output;
+    *exponent = e10 + removed;
+}
+
+size_t omni_format_float(char* buf, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t ieee_mantissa = bits & ((1ULL << 52) - 1);
+    const uint32_t ieee_exponent = (uint32_t)((bits >> 52) & 0x7FF);
+    const int negative = (int)(bits >> 63);
+
+    if (ieee_exponent == 0x7FF) {
+        if (ieee_mantissa != 0) {
+            memcpy(buf, "NaN", 3);
+            return 3;
+        }
+        memcpy(buf, negative ? "-Inf" : "+Inf", 4);
+        return 4;
+    }
+    char* p = buf;
+    if (negative) *p++ = '-';
+    if (ieee_exponent == 0 && ieee_mantissa == 0) {
+        *p++ = '0';
+        return (size_t)(p - buf);
+    }
+
+    omni_pow10_ready();
+    uint64_t decimal;
+    int32_t exponent;
+    omni_ryu_shortest(ieee_mantissa, ieee_exponent, &decimal, &exponent);
+    char digits[20];
+    int32_t n = (int32_t)omni_format_u64(digits, decimal);
+    // Exponent of the leading digit, which picks the layout as %g does
+    int32_t point = exponent + n - 1;
+
+    if (point < -4 || point >= 6) {
+        *p++ = digits[0];
+        if (n > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, (size_t)(n - 1));
+            p += n - 1;
+        }
+        *p++ = 'e';
+        if (point < 0) {
+            *p++ = '-';
+            point = -point;
+        } else {
+            *p++ = '+';
+        }
+        if (point >= 100) {
+            *p++ = (char)('0' + point / 100);
+            point %= 100;
+        }
+        memcpy(p, omni_digit_pairs + point * 2, 2);
+        p += 2;
+    } else if (point < 0) {
+        *p++ = '0';
+        *p++ = '.';
+        for (int32_t i = -1; i > point; i--) *p++ = '0';
+        memcpy(p, digits, (size_t)n);
+        p += n;
+    } else if (n <= point + 1) {
+        memcpy(p, digits, (size_t)n);
+        p += n;
+        for (int32_t i = n; i <= point; i++) *p++ = '0';
+    } else {
+        memcpy(p, digits, (size_t)(point + 1));
+        p += point + 1;
+        *p++ = '.';
+        memcpy(p, digits + point + 1, (size_t)(n - point - 1));
+        p += n - point - 1;
+    }
+    return (size_t)(p - buf);
+}
+
+static inline int omni_is_digit(char c) {
+    return (unsigned char)(c - '0') < 10;
+}
+
+// Eight ASCII digits in one little-endian word are checked and converted
+// with a few multiplies instead of eight steps
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define OMNI_HAVE_SWAR_DIGITS 1
+
+static inline uint64_t omni_load_u64(const char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline int omni_is_eight_digits(uint64_t value) {
+    return (((value & 0xF0F0F0F0F0F0F0F0ULL) |
+             (((value + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+            0x3333333333333333ULL);
+}
+
+static inline uint64_t omni_parse_eight_digits(uint64_t value) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 0x000F424000000064ULL; // 100 + (1000000 << 32)
+    const uint64_t mul2 = 0x0000271000000001ULL; // 1 + (10000 << 32)
+    value -= 0x3030303030303030ULL;
+    value = (value * 10) + (value >> 8);
+    return (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+}
+#endif
+
+// Appends the digits at *p to *value, stopping at the first non-digit.
+// The value wraps if there are more than 19; callers count digits.
+static inline void omni_scan_digits(const char** p, const char* end, uint64_t* value) {
+    const char* s = *p;
+    uint64_t v = *value;
+#ifdef OMNI_HAVE_SWAR_DIGITS
+    while (end - s >= 8 && omni_is_eight_digits(omni_load_u64(s))) {
+        v = v * 100000000 + omni_parse_eight_digits(omni_load_u64(s));
+        s += 8;
+    }
+#endif
+    while (s != end && omni_is_digit(*s)) {
+        v = v * 10 + (uint64_t)(*s - '0');
+        s++;
+    }
+    *p = s;
+    *value = v;
+}
+
+size_t omni_parse_int(const char* str, size_t len, int64_t* out) {
+    const char* p = str;
+    const char* end = str + len;
+    int negative = 0;
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    const char* start = p;
+    while (p != end && *p == '0') p++;
+    const char* digits = p;
+    uint64_t value = 0;
+    omni_scan_digits(&p, end, &value);
+    if (p == start) return 0;
+
+    // Past 19 significant digits the value may have wrapped
+    const uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    if (p - digits > 19 || value > limit) {
+        *out = negative ? INT64_MIN : INT64_MAX;
+    } else if (negative) {
+        *out = value == limit ? INT64_MIN : -(int64_t)value;
+    } else {
+        *out = (int64_t)value;
+    }
+    return (size_t)(p - str);
+}
+
+static size_t omni_match_word(const char* p, const char* end, const char* word) {
+    size_t n = 0;
+    for (; word[n]; n++) {
+        if (p + n == end || (p[n] | 0x20) != word[n]) return 0;
+    }
+    return n;
+}
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define OMNI_HAVE_CLINGER_FAST_PATH 1
+
+// Powers of ten that doubles hold exactly
+static const double omni_exact_pow10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+#endif
+
+// Rounds man * 10^exp10 to a double. Returns 0 when the truncated product
+// leaves the rounding undecided, or the result is subnormal.
+static int omni_eisel_lemire(uint64_t man, int32_t exp10, double* out) {
+    const omni_u128_t pow = omni_pow10_table[exp10 - OMNI_POW10_MIN];
+    const int32_t clz = __builtin_clzll(man);
+    man <<= clz;
+    uint64_t ret_exp2 = (uint64_t)(int64_t)(((217706 * exp10) >> 16) + 64 + 1023 - clz);
+
+    uint64_t x_hi;
+    uint64_t x_lo = omni_umul128(man, pow.hi, &x_hi);
+    if ((x_hi & 0x1FF) == 0x1FF && x_lo + man < man) {
+        // Widen the approximation with the low half of the power
+        uint64_t y_hi;
+        uint64_t y_lo = omni_umul128(man, pow.lo, &y_hi);
+        uint64_t merged_hi = x_hi;
+        uint64_t merged_lo = x_lo + y_hi;
+        if (merged_lo < x_lo) merged_hi++;
+        if ((merged_hi & 0x1FF) == 0x1FF && merged_lo + 1 == 0 && y_lo + man < man) return 0;
+        x_hi = merged_hi;
+        x_lo = merged_lo;
+    }
+
+    // Shift to 54 bits, then round to 53
+    const uint64_t msb = x_hi >> 63;
+    uint64_t ret_mantissa = x_hi >> (msb + 9);
+    ret_exp2 -= 1 ^ msb;
+    if (x_lo == 0 && (x_hi & 0x1FF) == 0 && (ret_mantissa & 3) == 1) return 0;
+    ret_mantissa += ret_mantissa & 1;
+    ret_mantissa >>= 1;
+    if (ret_mantissa >> 53 > 0) {
+        ret_mantissa >>= 1;
+        ret_exp2++;
+    }
+    if (ret_exp2 - 1 >= 0x7FF - 1) return 0;
+
+    const uint64_t bits = (ret_exp2 << 52) | (ret_mantissa & ((1ULL << 52) - 1));
+    memcpy(out, &bits, sizeof(bits));
+    return 1;
+}
+
+// strtod rounds every input correctly but reads the locale's decimal
+// separator, so it gets a copy that uses it
+static double omni_parse_float_slow(const char* str, size_t len) {
+    const char* point = localeconv()->decimal_point;
+    size_t point_len = strlen(point);
+    char stack_buf[128];
+    size_t size = len + point_len + 1;
+    char* buf = size <= sizeof(stack_buf) ? stack_buf : (char*)malloc(size);
+    if (!buf) return 0.0;
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (str[i] == '.') {
+            memcpy(buf + n, point, point_len);
+            n += point_len;
+        } else {
+            buf[n++] = str[i];
+        }
+    }
+    buf[n] = '\0';
+    double value = strtod(buf, NULL);
+    if (buf != stack_buf) free(buf);
+    return value;
+}
+
+size_t omni_parse_float(const char* str, size_t len, double* out) {
+    const char* p = str;
+    const char* end = str + len;
+    int negative = 0;
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    const char* number = p;
+
+    uint64_t mantissa = 0;
+    const char* int_start = p;
+    omni_scan_digits(&p, end, &mantissa);
+    const char* int_end = p;
+    int64_t digit_count = int_end - int_start;
+    const char* frac_start = p;
+    const char* frac_end = p;
+    int64_t exponent = 0;
+    if (p != end && *p == '.') {
+        p++;
+        frac_start = p;
+        omni_scan_digits(&p, end, &mantissa);
+        frac_end = p;
+        exponent = -(int64_t)(frac_end - frac_start);
+        digit_count += frac_end - frac_start;
+    }
+
+    if (digit_count == 0) {
+        size_t n = omni_match_word(number, end, "infinity");
+        if (n == 0) n = omni_match_word(number, end, "inf");
+        if (n > 0) {
+            *out = negative ? -INFINITY : INFINITY;
+            return (size_t)(number + n - str);
+        }
+        n = omni_match_word(number, end, "nan");
+        if (n > 0) {
+            *out = NAN;
+            return (size_t)(number + n - str);
+        }
+        return 0;
+    }
+
+    int64_t exp_number = 0;
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        const char* e = p + 1;
+        int exp_negative = 0;
+        if (e != end && (*e == '-' || *e == '+')) {
+            exp_negative = *e == '-';
+            e++;
+        }
+        if (e != end && omni_is_digit(*e)) {
+            while (e != end && omni_is_digit(*e)) {
+                if (exp_number < 0x10000) exp_number = exp_number * 10 + (*e - '0');
+                e++;
+            }
+            if (exp_negative) exp_number = -exp_number;
+            exponent += exp_number;
+            p = e;
+        }
+    }
+    const size_t consumed = (size_t)(p - str);
+
+    // Past 19 significant digits, keep the first 19 and round both ways
+    int truncated = 0;
+    if (digit_count > 19) {
+        for (const char* s = int_start; s != frac_end && (*s == '0' || *s == '.'); s++) {
+            if (*s == '0') digit_count--;
+        }
+        if (digit_count > 19) {
+            const uint64_t min_19_digits = 1000000000000000000ULL;
+            const char* s = int_start;
+            truncated = 1;
+            mantissa = 0;
+            while (mantissa < min_19_digits && s != int_end) {
+                mantissa = mantissa * 10 + (uint64_t)(*s++ - '0');
+            }
+            if (mantissa >= min_19_digits) {
+                exponent = (int_end - s) + exp_number;
+            } else {
+                s = frac_start;
+                while (mantissa < min_19_digits && s != frac_end) {
+                    mantissa = mantissa * 10 + (uint64_t)(*s++ - '0');
+                }
+                exponent = (frac_start - s) + exp_number;
+            }
+        }
+    }
+
+    double value;
+    if (mantissa == 0) {
+        value = 0.0;
+    } else if (exponent < OMNI_POW10_MIN) {
+        value = 0.0;
+    } else if (exponent > 308) {
+        value = INFINITY;
+#ifdef OMNI_HAVE_CLINGER_FAST_PATH
+    } else if (!truncated && exponent >= -22 && exponent <= 22 && mantissa <= (1ULL << 53)) {
+        value = (double)mantissa;
+        value = exponent < 0 ? value / omni_exact_pow10[-exponent] : value * omni_exact_pow10[exponent];
+#endif
+    } else {
+        omni_pow10_ready();
+        int ok = omni_eisel_lemire(mantissa, (int32_t)exponent, &value);
+        if (ok && truncated) {
+            double up;
+            ok = omni_eisel_lemire(mantissa + 1, (int32_t)exponent, &up) && up == value;
+        }
+        if (!ok) value = omni_parse_float_slow(number, (size_t)(p - number));
+    }
+    *out = negative ? -value : value;
+    return consumed;
+}
+
+// ============================================================================
+// Map Implementation
+// ============================================================================
+
+// Open-addressing hash map (Swiss-table layout).
+//
+// Slots live in one flat array next to a parallel array of control bytes.
+// A control byte is either OMNI_MAP_EMPTY, OMNI_MAP_DELETED, or the low 7 bits
+// of the slot's hash (the "fingerprint"). Lookups split the hash into h1 (which
+// group of 16 slots to start in) and h2 (the fingerprint), compare all 16
+// control bytes of a group against h2 at once, and only touch slots whose
+// fingerprint matches. Capacity is always a power of two, so the group index
+// is masked rather than reduced with modulo.
+//
+// Keys and values are stored inline in the slot: int/float/bool directly,
+// string values as an owned copy, and string keys as omni_strs together with
+// the key's hash and length. Rehashing never rereads key bytes and
+// mismatched keys are rejected without comparing bytes. A key whose contents
+// are already interned (the program's constant keys) is stored as the pool's
+// pointer, matches an interned lookup key by pointer and is shared by every
+// map; any other key is an owned copy, freed with its slot.
+//
+// Growing never rehashes everything at once: the full table becomes `old`,
+// and each later put/delete moves a small batch of slots into the new table
+// until `old` is empty. Lookups consult both tables while that is in progress.
+
+#define OMNI_MAP_GROUP_WIDTH 16
+#define OMNI_MAP_MIN_CAPACITY 16
+#define OMNI_MAP_MIGRATE_BATCH 64
+
+#define OMNI_MAP_EMPTY ((int8_t)-128)   // 0x80
+#define OMNI_MAP_DELETED ((int8_t)-2)   // 0xFE
+
+enum {
+    OMNI_MAP_KEY_UNSET = 0,
+    OMNI_MAP_KEY_STRING = 1,
+    OMNI_MAP_KEY_INT = 2,
+};
+
+enum {
+    OMNI_MAP_VALUE_UNSET = 0,
+    OMNI_MAP_VALUE_SCALAR = 1, // int, bool or float stored inline
+    OMNI_MAP_VALUE_STRING = 2, // owned copy, freed with the slot
+    OMNI_MAP_VALUE_BORROWED = 3, // string owned by the map's creator, never freed
+};
+
+typedef struct {
+    union {
+        const char* s; // omni_str, interned or owned
+        int32_t i;
+    } key;
+    union {
+        char* s;
+        int32_t i;
+        double f;
+    } value;
+    uint32_t hash;    // hash_string/hash_int of the key, before mixing
+    uint32_t key_len; // strlen of a string key
+} omni_map_slot_t;
+
+// A key being looked up, with its hash computed once up front
+typedef struct {
+    const char* s;
+    int32_t i;
+    uint32_t len;
+    uint32_t hash;
+} omni_map_key_t;
+
+typedef struct {
+    int8_t* ctrl;
+    omni_map_slot_t* slots;
+    uint32_t capacity;    // Power of two, multiple of OMNI_MAP_GROUP_WIDTH (0 = unallocated)
+    uint32_t size;        // Live slots in this table
+    uint32_t growth_left; // EMPTY slots that may still be claimed before a resize
+} omni_map_table_t;
+
+struct omni_map {
+    omni_map_table_t table;   // Current table; all inserts go here
+    omni_map_table_t old;     // Previous table while an incremental rehash is in progress
+    uint32_t migrate_pos;     // Next slot of `old` to move
+    int32_t key_kind;         // OMNI_MAP_KEY_*; fixed by the first insert
+    int32_t value_kind;       // OMNI_MAP_VALUE_*; fixed by the first insert
+    int32_t size;
+};
+
+// Simple hash function for strings; also reports the string's length
+static uint32_t hash_string(const char* str, uint32_t* len) {
+    const char* start = str;
+    uint32_t hash = 5381;
+    int c;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    if (len) *len = (uint32_t)(str - start - 1);
+    return hash;
+}
+
+// Simple hash function for integers
+static uint32_t hash_int(int32_t value) {
+    return (uint32_t)value;
+}
+
+// Finalize a raw hash so both h1 and the 7-bit h2 fingerprint are well mixed.
+// hash_int is the identity, so without this small keys would all share h2 = 0.
+static uint64_t omni_map_mix(uint32_t raw) {
+    uint64_t h = raw;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static omni_map_key_t omni_map_string_key(const char* key) {
+    omni_map_key_t k;
+    k.s = key;
+    k.i = 0;
+    k.hash = hash_string(key, &k.len);
+    return k;
+}
+
+static omni_map_key_t omni_map_int_key(int32_t key) {
+    omni_map_key_t k;
+    k.s = NULL;
+    k.i = key;
+    k.len = 0;
+    k.hash = hash_int(key);
+    return k;
+}
+
+static int omni_map_key_equals(int32_t kind, const omni_map_slot_t* slot, const omni_map_key_t* key) {
+    if (kind == OMNI_MAP_KEY_STRING) {
+        return slot->key.s == key->s ||
+               (slot->hash == key->hash && slot->key_len == key->len &&
+                memcmp(slot->key.s, key->s, key->len) == 0);
+    }
+    return slot->key.i == key->i;
+}
+
+// Group probing: each helper returns a 16-bit mask with bit i set when
+// control byte i of the group satisfies the predicate.
+#if defined(OMNI_HAVE_NEON)
+static uint32_t omni_map_neon_mask(uint8x16_t lanes) {
+    static const uint8_t bits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t m = vandq_u8(lanes, vld1q_u8(bits));
+    return (uint32_t)vaddv_u8(vget_low_u8(m)) | ((uint32_t)vaddv_u8(vget_high_u8(m)) << 8);
+}
+#endif
+
+static uint32_t omni_map_group_match(const int8_t* ctrl, int8_t h2) {
+#if defined(OMNI_HAVE_SSE2)
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+#elif defined(OMNI_HAVE_NEON)
+    return omni_map_neon_mask(vceqq_s8(vld1q_s8(ctrl), vdupq_n_s8(h2)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < OMNI_MAP_GROUP_WIDTH; i++) {
+        if (ctrl[i] == h2) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+static uint32_t omni_map_group_match_empty(const int8_t* ctrl) {
+    return omni_map_group_match(ctrl, OMNI_MAP_EMPTY);
+}
+
+// EMPTY and DELETED are the only control values with the sign bit set
+static uint32_t omni_map_group_match_free(const int8_t* ctrl) {
+#if defined(OMNI_HAVE_SSE2)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#elif defined(OMNI_HAVE_NEON)
+    return omni_map_neon_mask(vcltq_s8(vld1q_s8(ctrl), vdupq_n_s8(0)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < OMNI_MAP_GROUP_WIDTH; i++) {
+        if (ctrl[i] < 0) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+static int omni_map_table_init(omni_map_table_t* t, uint32_t capacity) {
+    t->ctrl = (int8_t*)malloc(capacity);
+    t->slots = (omni_map_slot_t*)malloc((size_t)capacity * sizeof(omni_map_slot_t));
+    if (!t->ctrl || !t->slots) {
+        free(t->ctrl);
+        free(t->slots);
+        memset(t, 0, sizeof(*t));
+        return 0;
+    }
+    memset(t->ctrl, OMNI_MAP_EMPTY, capacity);
+    t->capacity = capacity;
+    t->size = 0;
+    t->growth_left = capacity - capacity / 8; // Max load factor 7/8
+    return 1;
+}
+
+static void omni_map_table_free(omni_map_table_t* t) {
+    free(t->ctrl);
+    free(t->slots);
+    memset(t, 0, sizeof(*t));
+}
+
+// Smallest capacity that holds `count` entries at no more than half load
+static uint32_t omni_map_capacity_for(uint32_t count) {
+    uint32_t capacity = OMNI_MAP_MIN_CAPACITY;
+    while (capacity - capacity / 8 < count * 2 && capacity < 0x80000000u) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Returns the slot index holding key, or -1
+static int64_t omni_map_table_find(const omni_map_table_t* t, int32_t kind, const omni_map_key_t* key, uint64_t hash) {
+    if (t->capacity == 0 || t->size == 0) return -1;
+    uint32_t group_mask = t->capacity / OMNI_MAP_GROUP_WIDTH - 1;
+    uint32_t group = (uint32_t)(hash >> 7) & group_mask;
+    int8_t h2 = (int8_t)(hash & 0x7f);
+    // Triangular probing visits every group exactly once for power-of-two group counts
+    for (uint32_t step = 1; step <= group_mask + 1; step++) {
+        const int8_t* ctrl = t->ctrl + (size_t)group * OMNI_MAP_GROUP_WIDTH;
+        uint32_t match = omni_map_group_match(ctrl, h2);
+        while (match) {
+            uint32_t index = group * OMNI_MAP_GROUP_WIDTH + (uint32_t)__builtin_ctz(match);
+            if (omni_map_key_equals(kind, &t->slots[index], key)) {
+                return index;
+            }
+            match &= match - 1;
+        }
+        if (omni_map_group_match_empty(ctrl)) return -1;
+        group = (group + step) & group_mask;
+    }
+    return -1;
+}
+
+// Claims a free slot for a key known to be absent. Caller guarantees room.
+static uint32_t omni_map_table_claim(omni_map_table_t* t, uint64_t hash) {
+    uint32_t group_mask = t->capacity / OMNI_MAP_GROUP_WIDTH - 1;
+    uint32_t group = (uint32_t)(hash >> 7) & group_mask;
+    for (uint32_t step = 1;; step++) {
+        const int8_t* ctrl = t->ctrl + (size_t)group * OMNI_MAP_GROUP_WIDTH;
+        uint32_t free_mask = omni_map_group_match_free(ctrl);
+        if (free_mask) {
+            uint32_t index = group * OMNI_MAP_GROUP_WIDTH + (uint32_t)__builtin_ctz(free_mask);
+            if (t->ctrl[index] == OMNI_MAP_EMPTY) {
+                t->growth_left--;
+            }
+            t->ctrl[index] = (int8_t)(hash & 0x7f);
+            t->size++;
+            return index;
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+// A slot may go straight back to EMPTY only if its group has never been full,
+// i.e. still contains an EMPTY byte; otherwise some probe sequence may pass
+// through it and it must become a DELETED tombstone.
+static void omni_map_table_erase(omni_map_table_t* t, uint32_t index) {
+    const int8_t* ctrl = t->ctrl + (size_t)(index / OMNI_MAP_GROUP_WIDTH) * OMNI_MAP_GROUP_WIDTH;
+    if (omni_map_group_match_empty(ctrl)) {
+        t->ctrl[index] = OMNI_MAP_EMPTY;
+        t->growth_left++;
+    } else {
+        t->ctrl[index] = OMNI_MAP_DELETED;
+    }
+    t->size--;
+}
+
+// Relocate a slot using its cached hash; key bytes are never reread
+static void omni_map_table_move(omni_map_table_t* dst, omni_map_table_t* src, uint32_t index) {
+    uint32_t target = omni_map_table_claim(dst, omni_map_mix(src->slots[index].hash));
+    dst->slots[target] = src->slots[index];
+    // Mark as DELETED (not EMPTY) so probe chains in `src` stay intact for
+    // keys that have not been moved yet.
+    src->ctrl[index] = OMNI_MAP_DELETED;
+    src->size--;
+}
+
+// Move up to `budget` slots of the old table into the current one
+static void omni_map_migrate(omni_map_t* map, uint32_t budget) {
+    omni_map_table_t* old = &map->old;
+    if (old->capacity == 0) return;
+    while (budget-- > 0 && map->migrate_pos < old->capacity && old->size > 0) {
+        uint32_t index = map->migrate_pos++;
+        if (old->ctrl[index] >= 0) {
+            omni_map_table_move(&map->table, old, index);
+        }
+    }
+    if (old->size == 0 || map->migrate_pos >= old->capacity) {
+        omni_map_table_free(old);
+        map->migrate_pos = 0;
+    }
+}
+
+// Called when the current table has no EMPTY slots left.
+static int omni_map_grow(omni_map_t* map) {
+    omni_map_table_t fresh;
+    if (!omni_map_table_init(&fresh, omni_map_capacity_for((uint32_t)map->size + 1))) {
+        return 0;
+    }
+    if (map->old.capacity != 0) {
+        // The previous migration has not finished yet: fold both tables into
+        // the new one synchronously. Only happens under heavy delete churn.
+        for (uint32_t i = 0; i < map->old.capacity; i++) {
+            if (map->old.ctrl[i] >= 0) omni_map_table_move(&fresh, &map->old, i);
+        }
+        for (uint32_t i = 0; i < map->table.capacity; i++) {
+            if (map->table.ctrl[i] >= 0) omni_map_table_move(&fresh, &map->table, i);
+        }
+        omni_map_table_free(&map->old);
+        omni_map_table_free(&map->table);
+        map->table = fresh;
+        map->migrate_pos = 0;
+        return 1;
+    }
+    map->old = map->table;
+    map->table = fresh;
+    map->migrate_pos = 0;
+    omni_map_migrate(map, OMNI_MAP_MIGRATE_BATCH);
+    return 1;
+}
+
+// Locate key in either table; returns NULL when absent
+static omni_map_slot_t* omni_map_lookup(omni_map_t* map, int32_t kind, const omni_map_key_t* key) {
+    if (!map || map->size == 0 || map->key_kind != kind) return NULL;
+    uint64_t hash = omni_map_mix(key->hash);
+    int64_t index = omni_map_table_find(&map->table, kind, key, hash);
+    if (index >= 0) return &map->table.slots[index];
+    index = omni_map_table_find(&map->old, kind, key, hash);
+    if (index >= 0) return &map->old.slots[index];
+    return NULL;
+}
+
+// Find key or claim a slot for it. On insert, *inserted is set and the slot's
+// key and hash are filled in; the caller stores the value. Returns NULL on
+// allocation failure or when the map already holds another key/value kind.
+static omni_map_slot_t* omni_map_upsert(omni_map_t* map, int32_t kind, int32_t value_kind,
+                                        const omni_map_key_t* key, int* inserted) {
+    *inserted = 0;
+    if (!map) return NULL;
+    if (map->key_kind == OMNI_MAP_KEY_UNSET) {
+        map->key_kind = kind;
+        map->value_kind = value_kind;
+    } else if (map->key_kind != kind || map->value_kind != value_kind) {
+        return NULL;
+    }
+    omni_map_migrate(map, OMNI_MAP_MIGRATE_BATCH);
+
+    uint64_t hash = omni_map_mix(key->hash);
+    int64_t index = omni_map_table_find(&map->table, kind, key, hash);
+    if (index >= 0) return &map->table.slots[index];
+    index = omni_map_table_find(&map->old, kind, key, hash);
+    if (index >= 0) return &map->old.slots[index];
+
+    // Reuse the pool's copy of constant keys; the lookup takes no lock
+    const char* key_copy = NULL;
+    if (kind == OMNI_MAP_KEY_STRING) {
+        key_copy = omni_intern_find(key->s, key->len, key->hash, 0);
+        if (!key_copy) {
+            char* owned = omni_str_new(NULL, key->s, key->len);
+            if (!owned) return NULL;
+            OMNI_STR_HEADER(owned)->hash = key->hash;
+            key_copy = owned;
+        }
+    }
+    if (map->table.growth_left == 0 && !omni_map_grow(map)) {
+        omni_str_free(key_copy);
+        return NULL;
+    }
+
+    omni_map_slot_t* slot = &map->table.slots[omni_map_table_claim(&map->table, hash)];
+    if (kind == OMNI_MAP_KEY_STRING) {
+        slot->key.s = key_copy;
+    } else {
+        slot->key.i = key->i;
+    }
+    slot->hash = key->hash;
+    slot->key_len = key->len;
+    slot->value.s = NULL;
+    map->size++;
+    *inserted = 1;
+    return slot;
+}
+
+// omni_str_free leaves interned keys alone
+static void omni_map_release_slot(const omni_map_t* map, omni_map_slot_t* slot) {
+    if (map->key_kind == OMNI_MAP_KEY_STRING) omni_str_free(slot->key.s);
+    if (map->value_kind == OMNI_MAP_VALUE_STRING) free(slot->value.s);
+}
+
+static void omni_map_remove(omni_map_t* map, int32_t kind, const omni_map_key_t* key) {
+    if (!map || map->size == 0 || map->key_kind != kind) return;
+    omni_map_migrate(map, OMNI_MAP_MIGRATE_BATCH);
+    uint64_t hash = omni_map_mix(key->hash);
+    omni_map_table_t* tables[2] = {&map->table, &map->old};
+    for (int t = 0; t < 2; t++) {
+        int64_t index = omni_map_table_find(tables[t], kind, key, hash);
+        if (index >= 0) {
+            omni_map_release_slot(map, &tables[t]->slots[index]);
+            omni_map_table_erase(tables[t], (uint32_t)index);
+            map->size--;
+            return;
+        }
+    }
+}
+
+// Iterate live slots across both tables. Start with *pos = 0; returns NULL when done.
+static omni_map_slot_t* omni_map_next_slot(const omni_map_t* map, uint32_t* pos) {
+    while (*pos < map->table.capacity) {
+        uint32_t i = (*pos)++;
+        if (map->table.ctrl[i] >= 0) return &map->table.slots[i];
+    }
+    while (*pos - map->table.capacity < map->old.capacity) {
+        uint32_t i = (*pos)++ - map->table.capacity;
+        if (map->old.ctrl[i] >= 0) return &map->old.slots[i];
+    }
+    return NULL;
+}
+
+omni_map_t* omni_map_create() {
+    omni_map_t* map = (omni_map_t*)calloc(1, sizeof(omni_map_t));
+    if (!map) return NULL;
+    
+    if (!omni_map_table_init(&map->table, OMNI_MAP_MIN_CAPACITY)) {
+        free(map);
+        return NULL;
+    }
+    
+    return map;
+}
+
+void omni_map_destroy(omni_map_t* map) {
+    if (!map) return;
+    
+    if (map->key_kind == OMNI_MAP_KEY_STRING || map->value_kind == OMNI_MAP_VALUE_STRING) {
+        uint32_t pos = 0;
+        omni_map_slot_t* slot;
+        while ((slot = omni_map_next_slot(map, &pos)) != NULL) {
+            omni_map_release_slot(map, slot);
+        }
+    }
+    
+    omni_map_table_free(&map->table);
+    omni_map_table_free(&map->old);
+    free(map);
+}
+
+// Map utility functions
+int32_t omni_map_keys_string_int(omni_map_t* map, char** keys_buffer, int32_t buffer_size) {
+    if (!map || !keys_buffer || buffer_size <= 0) return 0;
+    if (map->key_kind != OMNI_MAP_KEY_STRING) return 0;
+    
+    int32_t count = 0;
+    uint32_t pos = 0;
+    omni_map_slot_t* slot;
+    while (count < buffer_size && (slot = omni_map_next_slot(map, &pos)) != NULL) {
+        keys_buffer[count++] = strdup(slot->key.s);
+    }
+    return count;
+}
+
+int32_t omni_map_values_string_int(omni_map_t* map, int32_t* values_buffer, int32_t buffer_size) {
+    if (!map || !values_buffer || buffer_size <= 0) return 0;
+    if (map->value_kind != OMNI_MAP_VALUE_SCALAR) return 0;
+    
+    int32_t count = 0;
+    uint32_t pos = 0;
+    omni_map_slot_t* slot;
+    while (count < buffer_size && (slot = omni_map_next_slot(map, &pos)) != NULL) {
+        values_buffer[count++] = slot->value.i;
+    }
+    return count;
+}
+
+omni_map_t* omni_map_copy_string_int(omni_map_t* map) {
+    if (!map) return NULL;
+    
+    omni_map_t* new_map = omni_map_create();
+    if (!new_map) return NULL;
+    if (map->key_kind != OMNI_MAP_KEY_STRING) return new_map;
+    
+    // Copy all entries
+    uint32_t pos = 0;
+    omni_map_slot_t* slot;
+    while ((slot = omni_map_next_slot(map, &pos)) != NULL) {
+        omni_map_put_string_int(new_map, slot->key.s, slot->value.i);
+    }
+    
+    return new_map;
+}
+
+omni_map_t* omni_map_merge_string_int(omni_map_t* a, omni_map_t* b) {
+    if (!a && !b) return NULL;
+    if (!a) return omni_map_copy_string_int(b);
+    if (!b) return omni_map_copy_string_int(a);
+    
+    omni_map_t* merged = omni_map_copy_string_int(a);
+    if (!merged) return NULL;
+    if (b->key_kind != OMNI_MAP_KEY_STRING) return merged;
+    
+    // Add all entries from b (will overwrite duplicates)
+    uint32_t pos = 0;
+    omni_map_slot_t* slot;
+    while ((slot = omni_map_next_slot(b, &pos)) != NULL) {
+        omni_map_put_string_int(merged, slot->key.s, slot->value.i);
+    }
+    
+    return merged;
+}
+
+static omni_map_slot_t* omni_map_upsert_string(omni_map_t* map, const char* key, int32_t value_kind) {
+    if (!map || !key) return NULL;
+    omni_map_key_t k = omni_map_string_key(key);
+    int inserted;
+    return omni_map_upsert(map, OMNI_MAP_KEY_STRING, value_kind, &k, &inserted);
+}
+
+static omni_map_slot_t* omni_map_upsert_int(omni_map_t* map, int32_t key, int32_t value_kind) {
+    if (!map) return NULL;
+    omni_map_key_t k = omni_map_int_key(key);
+    int inserted;
+    return omni_map_upsert(map, OMNI_MAP_KEY_INT, value_kind, &k, &inserted);
+}
+
+static omni_map_slot_t* omni_map_lookup_string(omni_map_t* map, const char* key) {
+    if (!map || !key) return NULL;
+    omni_map_key_t k = omni_map_string_key(key);
+    return omni_map_lookup(map, OMNI_MAP_KEY_STRING, &k);
+}
+
+static omni_map_slot_t* omni_map_lookup_int(omni_map_t* map, int32_t key) {
+    if (!map) return NULL;
+    omni_map_key_t k = omni_map_int_key(key);
+    return omni_map_lookup(map, OMNI_MAP_KEY_INT, &k);
+}
+
+// Replace a slot's string value with a copy of value
+static void omni_map_store_string_value(omni_map_slot_t* slot, const char* value) {
+    free(slot->value.s);
+    slot->value.s = value ? strdup(value) : NULL;
+}
+
+void omni_map_put_string_int(omni_map_t* map, const char* key, int32_t value) {
+    omni_map_slot_t* slot = omni_map_upsert_string(map, key, OMNI_MAP_VALUE_SCALAR);
+    if (slot) slot->value.i = value;
+}
+
+void omni_map_put_int_int(omni_map_t* map, int32_t key, int32_t value) {
+    omni_map_slot_t* slot = omni_map_upsert_int(map, key, OMNI_MAP_VALUE_SCALAR);
+    if (slot) slot->value.i = value;
+}
+
+int32_t omni_map_get_string_int(omni_map_t* map, const char* key) {
+    omni_map_slot_t* slot = omni_map_lookup_string(map, key);
+    return slot ? slot->value.i : 0; // Key not found, return default value
+}
+
+int32_t omni_map_get_int_int(omni_map_t* map, int32_t key) {
+    omni_map_slot_t* slot = omni_map_lookup_int(map, key);
+    return slot ? slot->value.i : 0; // Key not found, return default value
+}
+
+int32_t omni_map_contains_string(omni_map_t* map, const char* key) {
+    return omni_map_lookup_string(map, key) != NULL;
+}
+
+int32_t omni_map_contains_int(omni_map_t* map, int32_t key) {
+    return omni_map_lookup_int(map, key) != NULL;
+}
+
+int32_t omni_map_size(omni_map_t* map) {
+    return map ? map->size : 0;
+}
+
+// Additional map put operations
+void omni_map_put_string_string(omni_map_t* map, const char* key, const char* value) {
+    omni_map_slot_t* slot = omni_map_upsert_string(map, key, OMNI_MAP_VALUE_STRING);
+    if (slot) omni_map_store_string_value(slot, value);
+}
+
+// Stores value without copying it, for maps whose strings all live in one
+// buffer the caller keeps alive at least as long as the map (HTTP headers)
+static void omni_map_put_string_borrowed(omni_map_t* map, const char* key, char* value) {
+    omni_map_slot_t* slot = omni_map_upsert_string(map, key, OMNI_MAP_VALUE_BORROWED);
+    if (slot) slot->value.s = value;
+}
+
+void omni_map_put_string_float(omni_map_t* map, const char* key, double value) {
+    omni_map_slot_t* slot = omni_map_upsert_string(map, key, OMNI_MAP_VALUE_SCALAR);
+    if (slot) slot->value.f = value;
+}
+
+void omni_map_put_string_bool(omni_map_t* map, const char* key, int32_t value) {
+    omni_map_slot_t* slot = omni_map_upsert_string(map, key, OMNI_MAP_VALUE_SCALAR);
+    if (slot) slot->value.i = value;
+}
+
+void omni_map_put_int_string(omni_map_t* map, int32_t key, const char* value) {
+    omni_map_slot_t* slot = omni_map_upsert_int(map, key, OMNI_MAP_VALUE_STRING);
+    if (slot) omni_map_store_string_value(slot, value);
+}
+
+void omni_map_put_int_float(omni_map_t* map, int32_t key, double value) {
+    omni_map_slot_t* slot = omni_map_upsert_int(map, key, OMNI_MAP_VALUE_SCALAR);
+    if (slot) slot->value.f = value;
+}
+
+void omni_map_put_int_bool(omni_map_t* map, int32_t key, int32_t value) {
+    omni_map_slot_t* slot = omni_map_upsert_int(map, key, OMNI_MAP_VALUE_SCALAR);
+    if (slot) slot->value.i = value;
+}
+
+// Additional map get operations
+const char* omni_map_get_string_string(omni_map_t* map, const char* key) {
+    omni_map_slot_t* slot = omni_map_lookup_string(map, key);
+    return slot ? slot->value.s : NULL; // Key not found
+}
+
+double omni_map_get_string_float(omni_map_t* map, const char* key) {
+    omni_map_slot_t* slot = omni_map_lookup_string(map, key);
+    return slot ? slot->value.f : 0.0; // Key not found
+}
+
+int32_t omni_map_get_string_bool(omni_map_t* map, const char* key) {
+    omni_map_slot_t* slot = omni_map_lookup_string(map, key);
+    return slot ? slot->value.i : 0; // Key not found
+}
+
+const char* omni_map_get_int_string(omni_map_t* map, int32_t key) {
+    omni_map_slot_t* slot = omni_map_lookup_int(map, key);
+    return slot ? slot->value.s : NULL; // Key not found
+}
+
+double omni_map_get_int_float(omni_map_t* map, int32_t key) {
+    omni_map_slot_t* slot = omni_map_lookup_int(map, key);
+    return slot ? slot->value.f : 0.0; // Key not found
+}
+
+int32_t omni_map_get_int_bool(omni_map_t* map, int32_t key) {
+    omni_map_slot_t* slot = omni_map_lookup_int(map, key);
+    return slot ? slot->value.i : 0; // Key not found
+}
+
+// Map delete operations
+void omni_map_delete_string(omni_map_t* map, const char* key) {
+    if (!map || !key) return;
+    omni_map_key_t k = omni_map_string_key(key);
+    omni_map_remove(map, OMNI_MAP_KEY_STRING, &k);
+}
+
+void omni_map_delete_int(omni_map_t* map, int32_t key) {
+    if (!map) return;
+    omni_map_key_t k = omni_map_int_key(key);
+    omni_map_remove(map, OMNI_MAP_KEY_INT, &k);
+}
+
+// ============================================================================
+// Struct Implementation
+// ============================================================================
+
+// Struct implementation for OmniLang structs
+// NOTE: This implementation only supports primitive field types (string, int, float, bool).
+// Nested structs and arrays as field values are not supported and will cause
+// memory leaks or crashes. For nested structs, the runtime would need to:
+// 1. Store struct values as omni_struct_t* pointers
+// 2. Recursively free nested structs in omni_struct_destroy
+// 3. Handle type checking for nested struct access
+// This is a known limitation that requires architectural changes to fix.
+//
+// Layout: every struct points at a shape (hidden class) describing its field
+// names and types in slot order, and keeps its values in a contiguous slot
+// array. Structs built with the same field sequence share one shape, found by
+// following the transition from the shape without the last field. Shapes are
+// immutable once published and live for the rest of the program, so readers
+// never lock; only creating a new transition takes the shape mutex.
+enum {
+    OMNI_FIELD_STRING = 0,
+    OMNI_FIELD_INT = 1,
+    OMNI_FIELD_FLOAT = 2,
+    OMNI_FIELD_BOOL = 3,
+};
+
+#define OMNI_STRUCT_DEFAULT_SLOTS 4
+
+typedef union {
+    char* s; // Owned copy
+    int32_t i;
+    double f;
+} omni_slot_t;
+
+typedef struct omni_shape omni_shape_t;
+struct omni_shape {
+    int32_t count;
+    const char** names; // Interned, in slot order
+    int32_t* types;     // OMNI_FIELD_* per slot
+    omni_shape_t* transitions; // Shapes extending this one by one field
+    omni_shape_t* sibling;     // Next transition of the parent
+};
+
+struct omni_struct {
+    omni_shape_t* shape;
+    omni_slot_t* slots; // Trailing storage, or a heap array once grown
+    int32_t capacity;
+};
+
+static omni_shape_t omni_shape_root = {0, NULL, NULL, NULL, NULL};
+
+#ifdef _WIN32
+static CRITICAL_SECTION omni_shape_mutex;
+static int omni_shape_mutex_initialized = 0;
+#else
+static pthread_mutex_t omni_shape_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void omni_shape_lock(void) {
+#ifdef _WIN32
+    if (!omni_shape_mutex_initialized) {
+        InitializeCriticalSection(&omni_shape_mutex);
+        omni_shape_mutex_initialized = 1;
+    }
+    EnterCriticalSection(&omni_shape_mutex);
+#else
+    pthread_mutex_lock(&omni_shape_mutex);
+#endif
+}
+
+static void omni_shape_unlock(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&omni_shape_mutex);
+#else
+    pthread_mutex_unlock(&omni_shape_mutex);
+#endif
+}
+
+// Field names are interned, so a name the generator interned up front matches
+// by pointer; other callers fall back to a string compare
+static int32_t omni_shape_slot(const omni_shape_t* shape, const char* name) {
+    int32_t i;
+    for (i = 0; i < shape->count; i++) {
+        if (shape->names[i] == name) return i;
+    }
+    for (i = 0; i < shape->count; i++) {
+        if (strcmp(shape->names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static omni_shape_t* omni_shape_find_transition(omni_shape_t* shape, const char* name, int32_t type) {
+    omni_shape_t* child = OMNI_LOAD_ACQUIRE(&shape->transitions);
+    for (; child; child = child->sibling) {
+        const char* child_name = child->names[shape->count];
+        if (child->types[shape->count] == type &&
+            (child_name == name || strcmp(child_name, name) == 0)) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+// Returns the shape of shape plus field name of the given type, creating it
+// on first use
+static omni_shape_t* omni_shape_transition(omni_shape_t* shape, const char* name, int32_t type) {
+    omni_shape_t* child = omni_shape_find_transition(shape, name, type);
+    if (child) return child;
+
+    const char* interned = omni_intern(name);
+    if (!interned) return NULL;
+
+    omni_shape_lock();
+    // Another thread may have added it in the meantime
+    child = omni_shape_find_transition(shape, interned, type);
+    if (!child) {
+        int32_t count = shape->count + 1;
+        child = (omni_shape_t*)malloc(sizeof(omni_shape_t) + (size_t)count * (sizeof(const char*) + sizeof(int32_t)));
+        if (child) {
+            child->count = count;
+            child->names = (const char**)(child + 1);
+            child->types = (int32_t*)(child->names + count);
+            if (shape->count > 0) {
+                memcpy(child->names, shape->names, (size_t)shape->count * sizeof(const char*));
+                memcpy(child->types, shape->types, (size_t)shape->count * sizeof(int32_t));
+            }
+            child->names[shape->count] = interned;
+            child->types[shape->count] = type;
+            child->transitions = NULL;
+            child->sibling = shape->transitions;
+            OMNI_STORE_RELEASE(&shape->transitions, child);
+        }
+    }
+    omni_shape_unlock();
+    return child;
+}
+
+// Returns shape with the field in slot changed to type, keeping every slot in
+// place
+static omni_shape_t* omni_shape_retype(const omni_shape_t* shape, int32_t slot, int32_t type) {
+    omni_shape_t* result = &omni_shape_root;
+    int32_t i;
+    for (i = 0; i < shape->count && result; i++) {
+        result = omni_shape_transition(result, shape->names[i], i == slot ? type : shape->types[i]);
+    }
+    return result;
+}
+
+omni_struct_t* omni_struct_create_sized(int32_t field_count) {
+    if (field_count < OMNI_STRUCT_DEFAULT_SLOTS) field_count = OMNI_STRUCT_DEFAULT_SLOTS;
+    omni_struct_t* struct_ptr = (omni_struct_t*)malloc(sizeof(omni_struct_t) + (size_t)field_count * sizeof(omni_slot_t));
+    if (!struct_ptr) return NULL;
+
+    struct_ptr->shape = &omni_shape_root;
+    struct_ptr->slots = (omni_slot_t*)(struct_ptr + 1);
+    struct_ptr->capacity = field_count;
+    return struct_ptr;
+}
+
+omni_struct_t* omni_struct_create() {
+    return omni_struct_create_sized(OMNI_STRUCT_DEFAULT_SLOTS);
+}
+
+void omni_struct_destroy(omni_struct_t* struct_ptr) {
+    if (!struct_ptr) return;
+
+    const omni_shape_t* shape = struct_ptr->shape;
+    int32_t i;
+    for (i = 0; i < shape->count; i++) {
+        if (shape->types[i] == OMNI_FIELD_STRING) {
+            free(struct_ptr->slots[i].s);
+        }
+    }
+    if (struct_ptr->slots != (omni_slot_t*)(struct_ptr + 1)) {
+        free(struct_ptr->slots);
+    }
+    free(struct_ptr);
+}
+
+// Returns the slot to store a value of the given type in, adding the field if
+// the struct does not have it yet. A string previously held by the slot is
+// released.
+static omni_slot_t* omni_struct_slot_for_set(omni_struct_t* struct_ptr, const char* field_name, int32_t type) {
+    omni_shape_t* shape = struct_ptr->shape;
+    // A known transition means the field is new, which is the common case
+    // while a struct is being initialized
+    omni_shape_t* extended = omni_shape_find_transition(shape, field_name, type);
+    int32_t slot = extended ? -1 : omni_shape_slot(shape, field_name);
+    if (slot >= 0) {
+        if (shape->types[slot] != type) {
+            omni_shape_t* retyped = omni_shape_retype(shape, slot, type);
+            if (!retyped) return NULL;
+            if (shape->types[slot] == OMNI_FIELD_STRING) {
+                free(struct_ptr->slots[slot].s);
+            }
+            struct_ptr->shape = retyped;
+        } else if (type == OMNI_FIELD_STRING) {
+            free(struct_ptr->slots[slot].s);
+        }
+        return &struct_ptr->slots[slot];
+    }
+
+    if (shape->count == struct_ptr->capacity) {
+        int32_t new_capacity = struct_ptr->capacity * 2;
+        omni_slot_t* grown = (omni_slot_t*)malloc((size_t)new_capacity * sizeof(omni_slot_t));
+        if (!grown) return NULL;
+        memcpy(grown, struct_ptr->slots, (size_t)shape->count * sizeof(omni_slot_t));
+        if (struct_ptr->slots != (omni_slot_t*)(struct_ptr + 1)) {
+            free(struct_ptr->slots);
+        }
+        struct_ptr->slots = grown;
+        struct_ptr->capacity = new_capacity;
+    }
+
+    if (!extended) extended = omni_shape_transition(shape, field_name, type);
+    if (!extended) return NULL;
+    struct_ptr->shape = extended;
+    return &struct_ptr->slots[shape->count];
+}
+
+void omni_struct_set_string_field(omni_struct_t* struct_ptr, const char* field_name, const char* value) {
+    if (!struct_ptr || !field_name) return;
+    if (!value) return; // Skip NULL values
+
+    size_t len = strlen(value);
+    char* copy = (char*)malloc(len + 1);
+    if (!copy) return;
+    memcpy(copy, value, len + 1);
+
+    omni_slot_t* slot = omni_struct_slot_for_set(struct_ptr, field_name, OMNI_FIELD_STRING);
+    if (!slot) {
+        free(copy);
+        return;
+    }
+    slot->s = copy;
+}
+
+void omni_struct_set_int_field(omni_struct_t* struct_ptr, const char* field_name, int32_t value) {
+    if (!struct_ptr || !field_name) return;
+    omni_slot_t* slot = omni_struct_slot_for_set(struct_ptr, field_name, OMNI_FIELD_INT);
+    if (slot) slot->i = value;
+}
+
+void omni_struct_set_float_field(omni_struct_t* struct_ptr, const char* field_name, double value) {
+    if (!struct_ptr || !field_name) return;
+    omni_slot_t* slot = omni_struct_slot_for_set(struct_ptr, field_name, OMNI_FIELD_FLOAT);
+    if (slot) slot->f = value;
+}
+
+void omni_struct_set_bool_field(omni_struct_t* struct_ptr, const char* field_name, int32_t value) {
+    if (!struct_ptr || !field_name) return;
+    omni_slot_t* slot = omni_struct_slot_for_set(struct_ptr, field_name, OMNI_FIELD_BOOL);
+    if (slot) slot->i = value;
+}
+
+// Finds the slot holding field_name with the given type, or NULL. When hint
+// is given its slot is tried first (a pointer compare against the struct's
+// own shape, so a stale or racing hint only costs a miss) and is updated
+// after a miss.
+static const omni_slot_t* omni_struct_find_slot(const omni_struct_t* struct_ptr, const char* field_name, int32_t type, int32_t* hint) {
+    if (!struct_ptr || !field_name) return NULL;
+    const omni_shape_t* shape = struct_ptr->shape;
+    int32_t slot;
+    if (hint) {
+        slot = OMNI_LOAD_ACQUIRE(hint);
+        if (slot >= 0 && slot < shape->count && shape->names[slot] == field_name && shape->types[slot] == type) {
+            return &struct_ptr->slots[slot];
+        }
+    }
+    slot = omni_shape_slot(shape, field_name);
+    if (slot < 0 || shape->types[slot] != type) return NULL;
+    if (hint) OMNI_STORE_RELEASE(hint, slot);
+    return &struct_ptr->slots[slot];
+}
+
+const char* omni_struct_get_string_field(omni_struct_t* struct_ptr, const char* field_name) {
+    const omni_slot_t* slot = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_STRING, NULL);
+    return slot ? slot->s : ""; // Field not found, return default value
+}
+
+int32_t omni_struct_get_int_field(omni_struct_t* struct_ptr, const char* field_name) {
+    const omni_slot_t* slot = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_INT, NULL);
+    return slot ? slot->i : 0;
+}
+
+double omni_struct_get_float_field(omni_struct_t* struct_ptr, const char* field_name) {
+    const omni_slot_t* slot = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_FLOAT, NULL);
+    return slot ? slot->f : 0.0;
+}
+
+int32_t omni_struct_get_bool_field(omni_struct_t* struct_ptr, const char* field_name) {
+    const omni_slot_t* slot = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_BOOL, NULL);
+    return slot ? slot->i : 0;
+}
+
+// Offset-based accessors: slot is where the generator expects the field
+const char* omni_struct_get_string_at(omni_struct_t* struct_ptr, int32_t slot, const char* field_name) {
+    const omni_slot_t* found = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_STRING, &slot);
+    return found ? found->s : "";
+}
+
+int32_t omni_struct_get_int_at(omni_struct_t* struct_ptr, int32_t slot, const char* field_name) {
+    const omni_slot_t* found = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_INT, &slot);
+    return found ? found->i : 0;
+}
+
+double omni_struct_get_float_at(omni_struct_t* struct_ptr, int32_t slot, const char* field_name) {
+    const omni_slot_t* found = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_FLOAT, &slot);
+    return found ? found->f : 0.0;
+}
+
+int32_t omni_struct_get_bool_at(omni_struct_t* struct_ptr, int32_t slot, const char* field_name) {
+    const omni_slot_t* found = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_BOOL, &slot);
+    return found ? found->i : 0;
+}
+
+// Inline-cached accessors: ic remembers the slot found at one access site
+const char* omni_struct_get_string_field_ic(omni_struct_t* struct_ptr, const char* field_name, omni_struct_ic_t* ic) {
+    const omni_slot_t* found = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_STRING, ic ? &ic->slot : NULL);
+    return found ? found->s : "";
+}
+
+int32_t omni_struct_get_int_field_ic(omni_struct_t* struct_ptr, const char* field_name, omni_struct_ic_t* ic) {
+    const omni_slot_t* found = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_INT, ic ? &ic->slot : NULL);
+    return found ? found->i : 0;
+}
+
+double omni_struct_get_float_field_ic(omni_struct_t* struct_ptr, const char* field_name, omni_struct_ic_t* ic) {
+    const omni_slot_t* found = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_FLOAT, ic ? &ic->slot : NULL);
+    return found ? found->f : 0.0;
+}
+
+int32_t omni_struct_get_bool_field_ic(omni_struct_t* struct_ptr, const char* field_name, omni_struct_ic_t* ic) {
+    const omni_slot_t* found = omni_struct_find_slot(struct_ptr, field_name, OMNI_FIELD_BOOL, ic ? &ic->slot : NULL);
+    return found ? found->i : 0;
+}
+
+// ============================================================================
+// Task Scheduler and Promises
+// ============================================================================
+
+// Runtime threads: the mutex, condition variable and detached thread start
+// used by the runtime's own worker threads
+#ifdef _WIN32
+typedef SRWLOCK omni_mutex_t;
+typedef CONDITION_VARIABLE omni_cond_t;
+#define OMNI_MUTEX_INIT SRWLOCK_INIT
+#define OMNI_COND_INIT CONDITION_VARIABLE_INIT
+
+static void omni_mutex_lock(omni_mutex_t* m) { AcquireSRWLockExclusive(m); }
+static void omni_mutex_unlock(omni_mutex_t* m) { ReleaseSRWLockExclusive(m); }
+static void omni_cond_wait(omni_cond_t* c, omni_mutex_t* m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static void omni_cond_signal(omni_cond_t* c) { WakeConditionVariable(c); }
+static void omni_cond_broadcast(omni_cond_t* c) { WakeAllConditionVariable(c); }
+
+static int omni_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+#else
+typedef pthread_mutex_t omni_mutex_t;
+typedef pthread_cond_t omni_cond_t;
+#define OMNI_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#define OMNI_COND_INIT PTHREAD_COND_INITIALIZER
+
+static void omni_mutex_lock(omni_mutex_t* m) { pthread_mutex_lock(m); }
+static void omni_mutex_unlock(omni_mutex_t* m) { pthread_mutex_unlock(m); }
+static void omni_cond_wait(omni_cond_t* c, omni_mutex_t* m) { pthread_cond_wait(c, m); }
+static void omni_cond_signal(omni_cond_t* c) { pthread_cond_signal(c); }
+static void omni_cond_broadcast(omni_cond_t* c) { pthread_cond_broadcast(c); }
+
+static int omni_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+#endif
+
+typedef struct {
+    void (*fn)(void*);
+    void* arg;
+} omni_thread_start_t;
+
+#ifdef _WIN32
+static unsigned __stdcall omni_thread_main(void* data) {
+#else
+static void* omni_thread_main(void* data) {
+#endif
+    omni_thread_start_t start = *(omni_thread_start_t*)data;
+    free(data);
+    start.fn(start.arg);
+    return 0;
+}
+
+// Starts a detached thread running fn(arg); returns 0 on success, -1 on error
+static int omni_thread_spawn(void (*fn)(void*), void* arg) {
+    omni_thread_start_t* start = (omni_thread_start_t*)malloc(sizeof(omni_thread_start_t));
+    if (!start) return -1;
+    start->fn = fn;
+    start->arg = arg;
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_beginthreadex(NULL, 0, omni_thread_main, start, 0, NULL);
+    if (!handle) {
+        free(start);
+        return -1;
+    }
+    CloseHandle(handle);
+#else
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, omni_thread_main, start) != 0) {
+        free(start);
+        return -1;
+    }
+    pthread_detach(thread);
+#endif
+    return 0;
+}
+
+// Work-stealing deques (Chase and Lev, "Dynamic Circular Work-Stealing
+// Deque", with the memory orderings of Le et al.). The owning worker pushes
+// and takes at the bottom; any other thread steals from the top, and only a
+// steal or a take of the last task contend, on one compare-and-swap.
+#define OMNI_DEQUE_INITIAL_SIZE 256
+
+typedef struct omni_task {
+    omni_task_fn fn;
+    void* arg;
+    struct omni_task* next; // Link in the shared queue
+} omni_task_t;
+
+typedef struct omni_task_ring {
+    int64_t size; // Power of two
+    // Replaced rings stay readable for stealers that loaded them before the
+    // switch; they are never freed
+    struct omni_task_ring* retired;
+    omni_task_t* slots[];
+} omni_task_ring_t;
+
+typedef struct {
+    int64_t top;
+    int64_t bottom;
+    omni_task_ring_t* ring;
+    uint32_t steal_seed;
+    // Keeps neighbouring workers' deques off each other's cache lines
+    char padding[64];
+} omni_worker_t;
+
+static omni_task_ring_t* omni_task_ring_new(int64_t size) {
+    omni_task_ring_t* ring = (omni_task_ring_t*)calloc(1, sizeof(omni_task_ring_t) + (size_t)size * sizeof(omni_task_t*));
+    if (ring) ring->size = size;
+    return ring;
+}
+
+// Returns -1 if the deque is full and cannot grow
+static int omni_deque_push(omni_worker_t* w, omni_task_t* task) {
+    int64_t b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED);
+    int64_t t = __atomic_load_n(&w->top, __ATOMIC_ACQUIRE);
+    omni_task_ring_t* ring = __atomic_load_n(&w->ring, __ATOMIC_RELAXED);
+    if (b - t >= ring->size) {
+        omni_task_ring_t* grown = omni_task_ring_new(ring->size * 2);
+        if (!grown) return -1;
+        for (int64_t i = t; i < b; i++) {
+            grown->slots[i & (grown->size - 1)] = __atomic_load_n(&ring->slots[i & (ring->size - 1)], __ATOMIC_RELAXED);
+        }
+        grown->retired = ring;
+        __atomic_store_n(&w->ring, grown, __ATOMIC_RELEASE);
+        ring = grown;
+    }
+    __atomic_store_n(&ring->slots[b & (ring->size - 1)], task, __ATOMIC_RELAXED);
+    __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static omni_task_t* omni_deque_take(omni_worker_t* w) {
+    int64_t b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED) - 1;
+    omni_task_ring_t* ring = __atomic_load_n(&w->ring, __ATOMIC_RELAXED);
+    __atomic_store_n(&w->bottom, b, __ATOMIC_SEQ_CST);
+    int64_t t = __atomic_load_n(&w->top, __ATOMIC_SEQ_CST);
+    if (t > b) {
+        __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    omni_task_t* task = __atomic_load_n(&ring->slots[b & (ring->size - 1)], __ATOMIC_RELAXED);
+    if (t == b) {
+        // Last task: race the stealers for it
+        if (!__atomic_compare_exchange_n(&w->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            task = NULL;
+        }
+        __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+}
+
+static omni_task_t* omni_deque_steal(omni_worker_t* w) {
+    int64_t t = __atomic_load_n(&w->top, __ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&w->bottom, __ATOMIC_SEQ_CST);
+    if (t >= b) return NULL;
+    omni_task_ring_t* ring = __atomic_load_n(&w->ring, __ATOMIC_ACQUIRE);
+    omni_task_t* task = __atomic_load_n(&ring->slots[t & (ring->size - 1)], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&w->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL; // Lost the race
+    }
+    return task;
+}
+
+// Scheduler state. Idle threads sleep on omni_sched_cond; whoever publishes
+// work or resolves a promise bumps omni_sched_epoch first and then wakes
+// sleepers if there are any. A thread going to sleep re-checks the epoch
+// after registering as a sleeper, so no wakeup is lost.
+static omni_mutex_t omni_sched_mutex = OMNI_MUTEX_INIT;
+static omni_cond_t omni_sched_cond = OMNI_COND_INIT;
+static omni_worker_t* omni_workers = NULL;
+static int32_t omni_worker_count = 0;  // -1 if the pool could not start
+static omni_task_t* omni_shared_head = NULL; // Tasks from non-worker threads
+static omni_task_t* omni_shared_tail = NULL;
+static int64_t omni_shared_count = 0;
+static uint64_t omni_sched_epoch = 0;
+static int32_t omni_sched_sleepers = 0;
+static OMNI_THREAD_LOCAL omni_worker_t* omni_current_worker = NULL;
+static OMNI_THREAD_LOCAL uint32_t omni_steal_seed = 0;
+// Spare threads stand in for pool threads blocked on I/O (see
+// omni_promise_wait). Both counts are guarded by omni_sched_mutex.
+#define OMNI_MAX_SPARE_THREADS 512
+static int32_t omni_sched_blocked = 0;
+static int32_t omni_sched_spares = 0;
+static OMNI_THREAD_LOCAL int32_t omni_in_pool = 0;
+
+static void omni_sched_notify(int wake_all) {
+    __atomic_add_fetch(&omni_sched_epoch, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&omni_sched_sleepers, __ATOMIC_SEQ_CST) > 0) {
+        omni_mutex_lock(&omni_sched_mutex);
+        if (wake_all) {
+            omni_cond_broadcast(&omni_sched_cond);
+        } else {
+            omni_cond_signal(&omni_sched_cond);
+        }
+        omni_mutex_unlock(&omni_sched_mutex);
+    }
+}
+
+static omni_task_t* omni_sched_find(omni_worker_t* self) {
+    omni_task_t* task;
+    if (self && (task = omni_deque_take(self)) != NULL) return task;
+
+    int32_t count = OMNI_LOAD_ACQUIRE(&omni_worker_count);
+    if (count > 0) {
+        // Start at a random victim so thieves spread out
+        uint32_t* seed = self ? &self->steal_seed : &omni_steal_seed;
+        if (*seed == 0) *seed = (uint32_t)(uintptr_t)seed | 1u;
+        *seed ^= *seed << 13;
+        *seed ^= *seed >> 17;
+        *seed ^= *seed << 5;
+        for (int32_t i = 0; i < count; i++) {
+            omni_worker_t* victim = &omni_workers[(*seed + (uint32_t)i) % (uint32_t)count];
+            if (victim != self && (task = omni_deque_steal(victim)) != NULL) return task;
+        }
+    }
+
+    if (__atomic_load_n(&omni_shared_count, __ATOMIC_ACQUIRE) > 0) {
+        omni_mutex_lock(&omni_sched_mutex);
+        task = omni_shared_head;
+        if (task) {
+            omni_shared_head = task->next;
+            if (!omni_shared_head) omni_shared_tail = NULL;
+            __atomic_sub_fetch(&omni_shared_count, 1, __ATOMIC_RELEASE);
+        }
+        omni_mutex_unlock(&omni_sched_mutex);
+        if (task) return task;
+    }
+    return NULL;
+}
+
+static void omni_task_run(omni_task_t* task) {
+    omni_task_fn fn = task->fn;
+    void* arg = task->arg;
+    free(task);
+    fn(arg);
+}
+
+// Runs one task if there is one; otherwise sleeps until more work is
+// published or, if done is not NULL, *done is set
+static void omni_sched_step(omni_worker_t* self, const int32_t* done) {
+    uint64_t epoch = __atomic_load_n(&omni_sched_epoch, __ATOMIC_SEQ_CST);
+    omni_task_t* task = omni_sched_find(self);
+    if (task) {
+        omni_task_run(task);
+        return;
+    }
+    omni_mutex_lock(&omni_sched_mutex);
+    __atomic_add_fetch(&omni_sched_sleepers, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&omni_sched_epoch, __ATOMIC_SEQ_CST) == epoch && !(done && OMNI_LOAD_ACQUIRE(done))) {
+        omni_cond_wait(&omni_sched_cond, &omni_sched_mutex);
+    }
+    __atomic_sub_fetch(&omni_sched_sleepers, 1, __ATOMIC_SEQ_CST);
+    omni_mutex_unlock(&omni_sched_mutex);
+}
+
+static void omni_worker_main(void* data) {
+    omni_current_worker = (omni_worker_t*)data;
+    omni_in_pool = 1;
+    for (;;) {
+        omni_sched_step(omni_current_worker, NULL);
+    }
+}
+
+// Runs tasks (stealing, as it has no deque) until there are more spares
+// than blocked pool threads
+static void omni_spare_main(void* data) {
+    (void)data;
+    omni_in_pool = 1;
+    for (;;) {
+        omni_mutex_lock(&omni_sched_mutex);
+        if (omni_sched_spares > omni_sched_blocked) {
+            omni_sched_spares--;
+            omni_mutex_unlock(&omni_sched_mutex);
+            return;
+        }
+        omni_mutex_unlock(&omni_sched_mutex);
+        omni_sched_step(NULL, NULL);
+    }
+}
+
+static int32_t omni_sched_start(void) {
+    int32_t count = OMNI_LOAD_ACQUIRE(&omni_worker_count);
+    if (count != 0) return count;
+
+    omni_mutex_lock(&omni_sched_mutex);
+    count = OMNI_LOAD_ACQUIRE(&omni_worker_count);
+    if (count == 0) {
+        int wanted = omni_cpu_count();
+        const char* env = getenv("OMNI_WORKERS");
+        if (env && atoi(env) > 0) wanted = atoi(env);
+
+        omni_workers = (omni_worker_t*)calloc((size_t)wanted, sizeof(omni_worker_t));
+        int started = 0;
+        if (omni_workers) {
+            for (; started < wanted; started++) {
+                omni_worker_t* w = &omni_workers[started];
+                w->ring = omni_task_ring_new(OMNI_DEQUE_INITIAL_SIZE);
+                w->steal_seed = (uint32_t)started * 2654435761u + 1u;
+                if (!w->ring || omni_thread_spawn(omni_worker_main, w) != 0) {
+                    free(w->ring);
+                    w->ring = NULL;
+                    break;
+                }
+            }
+        }
+        count = started > 0 ? started : -1;
+        if (started == 0) {
+            fprintf(stderr, "WARNING: could not start worker threads, running tasks inline\n");
+        }
+        OMNI_STORE_RELEASE(&omni_worker_count, count);
+    }
+    omni_mutex_unlock(&omni_sched_mutex);
+    return count;
+}
+
+int32_t omni_scheduler_workers(void) {
+    int32_t count = omni_sched_start();
+    return count > 0 ? count : 0;
+}
+
+void omni_task_spawn(omni_task_fn fn, void* arg) {
+    if (!fn) return;
+    omni_task_t* task = (omni_task_t*)malloc(sizeof(omni_task_t));
+    if (!task || omni_sched_start() < 0) {
+        // No pool to run it on
+        free(task);
+        fn(arg);
+        return;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->next = NULL;
+
+    omni_worker_t* self = omni_current_worker;
+    if (!self || omni_deque_push(self, task) != 0) {
+        omni_mutex_lock(&omni_sched_mutex);
+        if (omni_shared_tail) {
+            omni_shared_tail->next = task;
+        } else {
+            omni_shared_head = task;
+        }
+        omni_shared_tail = task;
+        __atomic_add_fetch(&omni_shared_count, 1, __ATOMIC_RELEASE);
+        omni_mutex_unlock(&omni_sched_mutex);
+    }
+    omni_sched_notify(0);
+}
+
+// Promises. Completion callbacks are kept on a lock-free stack, closed by
+// the resolution: a callback added after that runs right away.
+typedef struct omni_promise_link {
+    omni_promise_callback_t callback;
+    void* arg;
+    struct omni_promise_link* next;
+} omni_promise_link_t;
+
+#define OMNI_PROMISE_CLOSED ((omni_promise_link_t*)1)
+
+struct omni_promise {
+    union {
+        int32_t i;
+        double f;
+        char* s;
+    } value;
+    int32_t type;
+    int32_t claimed; // Set by the first resolution
+    int32_t done;    // Set once the value is in place
+    int32_t refs;
+    int32_t external; // Settled by the event loop rather than a task
+    omni_promise_link_t* callbacks;
+};
+
+omni_promise_t* omni_promise_new(int32_t type) {
+    omni_promise_t* promise = (omni_promise_t*)calloc(1, sizeof(omni_promise_t));
+    if (!promise) return NULL;
+    promise->type = type;
+    promise->refs = 1;
+    return promise;
+}
+
+omni_promise_t* omni_promise_retain(omni_promise_t* promise) {
+    if (promise) __atomic_add_fetch(&promise->refs, 1, __ATOMIC_RELAXED);
+    return promise;
+}
+
+// NOTE: This drops one reference; the promise and the string it holds are
+// freed with the last one. Strings returned by omni_await_string are copies
+// and stay valid.
+void omni_promise_free(omni_promise_t* promise) {
+    if (!promise) return;
+    if (__atomic_sub_fetch(&promise->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+    omni_promise_link_t* link = promise->callbacks;
+    while (link && link != OMNI_PROMISE_CLOSED) {
+        omni_promise_link_t* next = link->next;
+        free(link);
+        link = next;
+    }
+    if (promise->type == OMNI_PROMISE_STRING) free(promise->value.s);
+    free(promise);
+}
+
+static int omni_promise_claim(omni_promise_t* promise) {
+    int32_t expected = 0;
+    return promise && __atomic_compare_exchange_n(&promise->claimed, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+// Publishes the value written after a successful claim and runs the
+// callbacks, in the order they were added
+static void omni_promise_complete(omni_promise_t* promise) {
+    OMNI_STORE_RELEASE(&promise->done, 1);
+    omni_promise_link_t* link = __atomic_exchange_n(&promise->callbacks, OMNI_PROMISE_CLOSED, __ATOMIC_ACQ_REL);
+    omni_promise_link_t* ordered = NULL;
+    while (link) {
+        omni_promise_link_t* next = link->next;
+        link->next = ordered;
+        ordered = link;
+        link = next;
+    }
+    while (ordered) {
+        omni_promise_link_t* next = ordered->next;
+        ordered->callback(promise, ordered->arg);
+        free(ordered);
+        ordered = next;
+    }
+    omni_sched_notify(1);
+}
+
+void omni_promise_resolve_int(omni_promise_t* promise, int32_t value) {
+    if (!omni_promise_claim(promise)) return;
+    promise->value.i = value;
+    omni_promise_complete(promise);
+}
+
+void omni_promise_resolve_string(omni_promise_t* promise, const char* value) {
+    if (!omni_promise_claim(promise)) return;
+    promise->value.s = strdup(value ? value : "");
+    omni_promise_complete(promise);
+}
+
+// Resolves with a malloc'd string, taking ownership of it
+static void omni_promise_resolve_string_owned(omni_promise_t* promise, char* value) {
+    if (!omni_promise_claim(promise)) {
+        free(value);
+        return;
+    }
+    promise->value.s = value ? value : strdup("");
+    omni_promise_complete(promise);
+}
+
+void omni_promise_resolve_float(omni_promise_t* promise, double value) {
+    if (!omni_promise_claim(promise)) return;
+    promise->value.f = value;
+    omni_promise_complete(promise);
+}
+
+void omni_promise_resolve_bool(omni_promise_t* promise, int32_t value) {
+    if (!omni_promise_claim(promise)) return;
+    promise->value.i = value ? 1 : 0;
+    omni_promise_complete(promise);
+}
+
+int32_t omni_promise_is_done(omni_promise_t* promise) {
+    return (promise && OMNI_LOAD_ACQUIRE(&promise->done)) ? 1 : 0;
+}
+
+void omni_promise_then(omni_promise_t* promise, omni_promise_callback_t callback, void* arg) {
+    if (!promise || !callback) return;
+    omni_promise_link_t* link = (omni_promise_link_t*)malloc(sizeof(omni_promise_link_t));
+    if (link) {
+        link->callback = callback;
+        link->arg = arg;
+        link->next = __atomic_load_n(&promise->callbacks, __ATOMIC_ACQUIRE);
+        while (link->next != OMNI_PROMISE_CLOSED) {
+            if (__atomic_compare_exchange_n(&promise->callbacks, &link->next, link, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return;
+            }
+        }
+        free(link);
+    }
+    // Already resolved
+    callback(promise, arg);
+}
+
+typedef struct {
+    omni_async_fn fn;
+    void* arg;
+    omni_promise_t* promise;
+} omni_async_call_t;
+
+static void omni_async_call_run(void* data) {
+    omni_async_call_t* call = (omni_async_call_t*)data;
+    call->fn(call->promise, call->arg);
+    omni_promise_free(call->promise);
+    free(call);
+}
+
+omni_promise_t* omni_async_call(int32_t type, omni_async_fn fn, void* arg) {
+    omni_promise_t* promise = omni_promise_new(type);
+    if (!promise || !fn) return promise;
+    omni_async_call_t* call = (omni_async_call_t*)malloc(sizeof(omni_async_call_t));
+    if (!call) {
+        fn(promise, arg);
+        return promise;
+    }
+    call->fn = fn;
+    call->arg = arg;
+    call->promise = omni_promise_retain(promise);
+    omni_task_spawn(omni_async_call_run, call);
+    return promise;
+}
+
+omni_promise_t* omni_promise_create_int(int32_t value) {
+    omni_promise_t* promise = omni_promise_new(OMNI_PROMISE_INT);
+    omni_promise_resolve_int(promise, value);
+    return promise;
+}
+
+omni_promise_t* omni_promise_create_string(const char* value) {
+    omni_promise_t* promise = omni_promise_new(OMNI_PROMISE_STRING);
+    omni_promise_resolve_string(promise, value);
+    return promise;
+}
+
+omni_promise_t* omni_promise_create_float(double value) {
+    omni_promise_t* promise = omni_promise_new(OMNI_PROMISE_FLOAT);
+    omni_promise_resolve_float(promise, value);
+    return promise;
+}
+
+omni_promise_t* omni_promise_create_bool(int32_t value) {
+    omni_promise_t* promise = omni_promise_new(OMNI_PROMISE_BOOL);
+    omni_promise_resolve_bool(promise, value);
+    return promise;
+}
+
+// Sleeps until *done is set
+static void omni_sched_block(const int32_t* done) {
+    omni_mutex_lock(&omni_sched_mutex);
+    __atomic_add_fetch(&omni_sched_sleepers, 1, __ATOMIC_SEQ_CST);
+    while (!OMNI_LOAD_ACQUIRE(done)) {
+        omni_cond_wait(&omni_sched_cond, &omni_sched_mutex);
+    }
+    __atomic_sub_fetch(&omni_sched_sleepers, 1, __ATOMIC_SEQ_CST);
+    omni_mutex_unlock(&omni_sched_mutex);
+}
+
+// Bracket a wait that blocks the calling thread. A pool thread gets a spare
+// thread to run tasks in its place until omni_sched_unblocked; returns
+// whether one stands in, to be passed on.
+static int omni_sched_blocking(void) {
+    int spare = 0;
+    if (omni_in_pool) {
+        omni_mutex_lock(&omni_sched_mutex);
+        if (omni_sched_spares < OMNI_MAX_SPARE_THREADS) {
+            omni_sched_blocked++;
+            if (omni_sched_spares < omni_sched_blocked) {
+                if (omni_thread_spawn(omni_spare_main, NULL) == 0) {
+                    omni_sched_spares++;
+                }
+            }
+            spare = 1;
+        }
+        omni_mutex_unlock(&omni_sched_mutex);
+    }
+    return spare;
+}
+
+static void omni_sched_unblocked(int spare) {
+    if (!spare) return;
+    // Lets a now surplus spare notice and exit
+    omni_mutex_lock(&omni_sched_mutex);
+    omni_sched_blocked--;
+    omni_mutex_unlock(&omni_sched_mutex);
+    omni_sched_notify(1);
+}
+
+// Waits for promise by running other tasks meanwhile, and returns whether it
+// holds a value of the given type. Helping is only safe for promises settled
+// by tasks: a promise settled by the event loop may depend on a task the
+// waiter would then bury under its own stack (a server waiting to accept
+// could end up below the client task it ran, which waits for the server to
+// answer). Those are waited for by blocking instead.
+static int omni_promise_wait(omni_promise_t* promise, int32_t type) {
+    if (!promise) return 0;
+    if (promise->external && !OMNI_LOAD_ACQUIRE(&promise->done)) {
+        int spare = omni_sched_blocking();
+        // Past the spare cap, a pool thread falls back to helping
+        if (spare || !omni_in_pool) {
+            omni_sched_block(&promise->done);
+        }
+        omni_sched_unblocked(spare);
+    }
+    while (!OMNI_LOAD_ACQUIRE(&promise->done)) {
+        omni_sched_step(omni_current_worker, &promise->done);
+    }
+    return promise->type == type;
+}
+
+int32_t omni_await_int(omni_promise_t* promise) {
+    return omni_promise_wait(promise, OMNI_PROMISE_INT) ? promise->value.i : 0;
+}
+
+// NOTE: This function returns a newly allocated copy of the string stored in the promise.
+// The caller is responsible for freeing the returned string using free().
+// This ensures the string remains valid even after the promise is freed.
+char* omni_await_string(omni_promise_t* promise) {
+    const char* str = NULL;
+    if (omni_promise_wait(promise, OMNI_PROMISE_STRING)) {
+        str = promise->value.s;
+    }
+    return strdup(str ? str : "");
+}
+
+double omni_await_float(omni_promise_t* promise) {
+    return omni_promise_wait(promise, OMNI_PROMISE_FLOAT) ? promise->value.f : 0.0;
+}
+
+int32_t omni_await_bool(omni_promise_t* promise) {
+    return omni_promise_wait(promise, OMNI_PROMISE_BOOL) ? promise->value.i : 0;
+}
+
+// Buffered line reader
+// One buffer is refilled in place with read(2); lines are found with
+// memchr and handed out as slices of that buffer, so the steady state
+// allocates nothing. Leftover bytes move to the front before each refill,
+// and the buffer only grows when a single line outgrows it. A mapped view
+// is scanned where it lies, without a buffer at all.
+#define OMNI_READER_BUFFER (128 * 1024)
+
+struct omni_reader {
+    int fd;                  // -1 when reading a mapped view
+    int close_fd;            // Set when the reader opened fd itself
+    int eof;
+    FILE* file;              // Stream to reposition on free, if any
+    omni_file_view_t* view;  // View owned by the reader (omni_reader_open)
+    char* buf;               // Owned buffer, or the view's data
+    size_t pos, len, cap;    // cap is 0 for a view
+};
+
+// The process-wide stdin reader; omni_read_line takes the lock around it
+static omni_reader_t omni_stdin_reader = {0, 0, 0, NULL, NULL, NULL, 0, 0, 0};
+static omni_mutex_t omni_stdin_lock = OMNI_MUTEX_INIT;
+
+omni_reader_t* omni_reader_stdin(void) {
+    return &omni_stdin_reader;
+}
+
+static omni_reader_t* omni_reader_new_fd(int fd) {
+    omni_reader_t* reader = (omni_reader_t*)calloc(1, sizeof(omni_reader_t));
+    if (!reader) return NULL;
+    reader->fd = fd;
+    return reader;
+}
+
+omni_reader_t* omni_reader_from_file(intptr_t file_handle) {
+    if (file_handle == (intptr_t)-1 || file_handle == 0) {
+        return NULL;
+    }
+    FILE* file = (FILE*)file_handle;
+    // Whatever stdio has buffered is given back to the descriptor first
+    fflush(file);
+    int64_t at = omni_file_tell64(file_handle);
+    int fd = fileno(file);
+    if (at >= 0) {
+        lseek(fd, (off_t)at, SEEK_SET);
+    }
+    omni_reader_t* reader = omni_reader_new_fd(fd);
+    if (reader) reader->file = file;
+    return reader;
+}
+
+omni_reader_t* omni_reader_from_view(const omni_file_view_t* view) {
+    if (!view) {
+        return NULL;
+    }
+    omni_reader_t* reader = (omni_reader_t*)calloc(1, sizeof(omni_reader_t));
+    if (!reader) return NULL;
+    reader->fd = -1;
+    reader->eof = 1;
+    reader->buf = (char*)view->data;
+    reader->len = view->len;
+    return reader;
+}
+
+omni_reader_t* omni_reader_open(const char* path) {
+    if (!path) {
+        return NULL;
+    }
+    omni_file_view_t* view = omni_file_map(path, OMNI_FILE_MAP_SEQUENTIAL);
+    if (view) {
+        omni_reader_t* reader = omni_reader_from_view(view);
+        if (!reader) {
+            omni_file_unmap(view);
+            return NULL;
+        }
+        reader->view = view;
+        return reader;
+    }
+    // Pipes and devices cannot be mapped; read those through the buffer
+    int flags = O_RDONLY;
+#ifdef O_BINARY
+    flags |= O_BINARY;
+#endif
+#ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#endif
+    int fd = open(path, flags);
+    if (fd < 0) {
+        return NULL;
+    }
+    omni_reader_t* reader = omni_reader_new_fd(fd);
+    if (!reader) {
+        close(fd);
+        return NULL;
+    }
+    reader->close_fd = 1;
+    return reader;
+}
+
+// Makes room past the unread bytes and reads more; returns 0 at end of input
+static int omni_reader_fill(omni_reader_t* reader) {
+    if (reader->eof) {
+        return 0;
+    }
+    if (reader->pos > 0) {
+        memmove(reader->buf, reader->buf + reader->pos, reader->len - reader->pos);
+        reader->len -= reader->pos;
+        reader->pos = 0;
+    }
+    // One byte stays spare so lines can be NUL-terminated in place
+    if (reader->cap == 0 || reader->len + 1 >= reader->cap) {
+        size_t cap = reader->cap ? reader->cap * 2 : OMNI_READER_BUFFER;
+        char* buf = (char*)realloc(reader->buf, cap);
+        if (!buf) {
+            reader->eof = 1;
+            return 0;
+        }
+        reader->buf = buf;
+        reader->cap = cap;
+    }
+    for (;;) {
+        ssize_t n = read(reader->fd, reader->buf + reader->len, reader->cap - 1 - reader->len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            reader->eof = 1;
+            return 0;
+        }
+        reader->len += (size_t)n;
+        return 1;
+    }
+}
+
+const char* omni_reader_next_line(omni_reader_t* reader, size_t* len) {
+    if (len) *len = 0;
+    if (!reader) {
+        return NULL;
+    }
+    size_t scanned = 0; // Bytes past pos already known to hold no newline
+    const char* nl = NULL;
+    for (;;) {
+        if (reader->len - reader->pos > scanned) {
+            nl = (const char*)memchr(reader->buf + reader->pos + scanned, '\n',
+                                     reader->len - reader->pos - scanned);
+            if (nl) break;
+        }
+        scanned = reader->len - reader->pos;
+        if (!omni_reader_fill(reader)) break;
+    }
+    char* line = reader->buf + reader->pos;
+    size_t line_len;
+    if (nl) {
+        line_len = (size_t)(nl - line);
+        reader->pos += line_len + 1;
+    } else {
+        // Last line without a newline, or end of input
+        line_len = reader->len - reader->pos;
+        if (line_len == 0) {
+            return NULL;
+        }
+        reader->pos = reader->len;
+    }
+    if (line_len > 0 && line[line_len - 1] == '\r') {
+        line_len--;
+    }
+    if (reader->cap) {
+        line[line_len] = '\0';
+    }
+    if (len) *len = line_len;
+    return line;
+}
+
+void omni_reader_free(omni_reader_t* reader) {
+    if (!reader || reader == &omni_stdin_reader) {
+        return;
+    }
+    if (reader->file) {
+        // Leave the stream just past the last line handed out
+        off_t end = lseek(reader->fd, 0, SEEK_CUR);
+        if (end >= 0) {
+            omni_file_seek64((intptr_t)reader->file, (int64_t)end - (int64_t)(reader->len - reader->pos), SEEK_SET);
+        }
+    }
+    if (reader->close_fd) {
+        close(reader->fd);
+    }
+    if (reader->view) {
+        omni_file_unmap(reader->view);
+    } else if (reader->cap) {
+        free(reader->buf);
+    }
+    free(reader);
+}
+
+// NOTE: Returns a newly allocated string - caller must free it using free()
+// Reads through the shared stdin reader; at end of input the result is "".
+char* omni_read_line(void) {
+    omni_mutex_lock(&omni_stdin_lock);
+    size_t len = 0;
+    const char* line = omni_reader_next_line(&omni_stdin_reader, &len);
+    char* copy = (char*)malloc(len + 1);
+    if (copy) {
+        if (line) memcpy(copy, line, len);
+        copy[len] = '\0';
+    }
+    omni_mutex_unlock(&omni_stdin_lock);
+    return copy;
+}
+
+// File I/O convenience functions (for async operations)
+// NOTE: Returns a newly allocated string - caller must free it using free()
+// This function allocates memory that must be freed by the caller to avoid leaks.
+char* omni_read_file(const char* path) {
+    if (!path) {
+        return NULL;
+    }
+    
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        // Return NULL on error instead of leaking strdup("")
+        return NULL;
+    }
+    
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    // Handle empty files
+    if (size <= 0) {
+        fclose(file);
+        char* empty = (char*)malloc(1);
+        if (empty) {
+            empty[0] = '\0';
+        }
+        return empty;
+    }
+    
+    char* buffer = (char*)malloc(size + 1);
+    if (!buffer) {
+        fclose(file);
+        return NULL;
+    }
+    
+    size_t read = fread(buffer, 1, size, file);
+    buffer[read] = '\0';
+    fclose(file);
+    
+    return buffer;
+}
+
+int32_t omni_write_file(const char* path, const char* content) {
+    if (!path) {
+        fprintf(stderr, "ERROR: omni_write_file called with NULL path\n");
+        return 0;
+    }
+    if (!content) {
+        fprintf(stderr, "ERROR: omni_write_file called with NULL content\n");
+        return 0;
+    }
+    
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return 0;
+    }
+    
+    size_t len = strlen(content);
+    size_t written = fwrite(content, 1, len, file);
+    fclose(file);
+    
+    return (written == len) ? 1 : 0;
+}
+
+int32_t omni_append_file(const char* path, const char* content) {
+    if (!path) {
+        fprintf(stderr, "ERROR: omni_append_file called with NULL path\n");
+        return 0;
+    }
+    if (!content) {
+        fprintf(stderr, "ERROR: omni_append_file called with NULL content\n");
+        return 0;
+    }
+    
+    FILE* file = fopen(path, "a");
+    if (!file) {
+        return 0;
+    }
+    
+    size_t len = strlen(content);
+    size_t written = fwrite(content, 1, len, file);
+    fclose(file);
+    
+    return (written == len) ? 1 : 0;
+}
+
+// Async file I/O: the blocking call runs as a task, on copies of the
+// arguments
+typedef struct {
+    char* path;
+    char* content;
+} omni_file_request_t;
+
+static omni_file_request_t* omni_file_request_new(const char* path, const char* content) {
+    omni_file_request_t* request = (omni_file_request_t*)calloc(1, sizeof(omni_file_request_t));
+    if (!request) return NULL;
+    request->path = path ? strdup(path) : NULL;
+    request->content = content ? strdup(content) : NULL;
+    return request;
+}
+
+static void omni_file_request_free(omni_file_request_t* request) {
+    free(request->path);
+    free(request->content);
+    free(request);
+}
+
+static void omni_read_file_task(omni_promise_t* promise, void* arg) {
+    omni_file_request_t* request = (omni_file_request_t*)arg;
+    omni_promise_resolve_string_owned(promise, omni_read_file(request->path));
+    omni_file_request_free(request);
+}
+
+static void omni_write_file_task(omni_promise_t* promise, void* arg) {
+    omni_file_request_t* request = (omni_file_request_t*)arg;
+    omni_promise_resolve_bool(promise, omni_write_file(request->path, request->content));
+    omni_file_request_free(request);
+}
+
+static void omni_append_file_task(omni_promise_t* promise, void* arg) {
+    omni_file_request_t* request = (omni_file_request_t*)arg;
+    omni_promise_resolve_bool(promise, omni_append_file(request->path, request->content));
+    omni_file_request_free(request);
+}
+
+static void omni_read_line_task(omni_promise_t* promise, void* arg) {
+    (void)arg;
+    omni_promise_resolve_string_owned(promise, omni_read_line());
+}
+
+omni_promise_t* omni_read_file_async(const char* path) {
+    omni_file_request_t* request = omni_file_request_new(path, NULL);
+    if (!request) return omni_promise_create_string("");
+    return omni_async_call(OMNI_PROMISE_STRING, omni_read_file_task, request);
+}
+
+omni_promise_t* omni_write_file_async(const char* path, const char* content) {
+    omni_file_request_t* request = omni_file_request_new(path, content);
+    if (!request) return omni_promise_create_bool(0);
+    return omni_async_call(OMNI_PROMISE_BOOL, omni_write_file_task, request);
+}
+
+omni_promise_t* omni_append_file_async(const char* path, const char* content) {
+    omni_file_request_t* request = omni_file_request_new(path, content);
+    if (!request) return omni_promise_create_bool(0);
+    return omni_async_call(OMNI_PROMISE_BOOL, omni_append_file_task, request);
+}
+
+omni_promise_t* omni_read_line_async(void) {
+    return omni_async_call(OMNI_PROMISE_STRING, omni_read_line_task, NULL);
+}
+
+// ============================================================================
+// Channels
+// ============================================================================
+
+// Multi-producer/multi-consumer channels of fixed-size elements.
+//
+// A bounded channel is Vyukov's bounded MPMC queue: a power-of-two ring of
+// cells, each holding a sequence number that says which lap it is ready
+// for. A sender claims position p with a CAS on enqueue_pos once cell p
+// reads p, copies the element in and publishes p + 1; a receiver claims p
+// on dequeue_pos once the cell reads p + 1 and hands it to the next lap
+// with p + capacity. Batch operations claim a run of positions with one
+// CAS, sized by the other side's claim counter, and then wait per cell for
+// the peer that claimed it a lap earlier to finish copying.
+//
+// An unbounded channel is a list of segments whose slots are each used once
+// (Ramalhete and Correia's FAA array queue): senders and receivers take
+// slot indexes with fetch-and-add, a receiver that overtakes its sender
+// poisons the slot and that sender retries further on. Segments the head
+// has moved past are retired and freed by the last operation to leave the
+// channel: every operation counts itself in `active`, so a retired segment
+// taken off the list before that count drops to zero has no more readers.
+//
+// Blocking operations poll for a while, then register a waiter on each
+// channel involved and sleep until an operation on the other side, or a
+// close, wakes them. Waiter lists are guarded by a per-channel mutex that
+// only the slow path takes; completed operations check an atomic waiter
+// count. Each send wakes at most one receiver and each receive one sender.
+// A waiter woken for a case it then did not take passes the wakeup on.
+// Tasks run to completion on their worker's stack and cannot be suspended,
+// so a worker that blocks gets a spare thread to run tasks in its place
+// (as for promises settled by the event loop); past the spare cap it runs
+// other tasks while it waits instead.
+#define OMNI_CHAN_SEGMENT_SLOTS 256
+#define OMNI_CHAN_POLLS 64
+
+#define OMNI_CHAN_SLOT_EMPTY 0
+#define OMNI_CHAN_SLOT_FULL 1
+#define OMNI_CHAN_SLOT_POISONED 2
+
+#if defined(_WIN32)
+#define OMNI_CPU_RELAX() YieldProcessor()
+#elif defined(__x86_64__) || defined(__i386__)
+#define OMNI_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define OMNI_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define OMNI_CPU_RELAX() ((void)0)
+#endif
+
+// Cells and slots are an 8-byte header (sequence number or slot state)
+// followed by the element
+#define OMNI_CHAN_HEADER 8
+
+typedef struct omni_chan_segment {
+    int64_t enq; // Next slot for a sender; runs past the end once full
+    char pad0[56];
+    int64_t deq; // Next slot for a receiver
+    char pad1[56];
+    int64_t start; // Channel position of slot 0
+    struct omni_chan_segment* next;
+    struct omni_chan_segment* retired_next;
+    unsigned char slots[];
+} omni_chan_segment_t;
+
+typedef struct {
+    omni_mutex_t mutex;
+    omni_cond_t cond;
+} omni_chan_parker_t;
+
+// A blocked thread sleeps on its own parker, so a wakeup disturbs no one else
+static OMNI_THREAD_LOCAL omni_chan_parker_t omni_chan_parker = {OMNI_MUTEX_INIT, OMNI_COND_INIT};
+
+typedef struct {
+    int32_t signaled;
+    int32_t helping; // Runs tasks while it waits instead of sleeping
+    omni_chan_parker_t* parker;
+} omni_chan_waiter_t;
+
+// One per channel a waiter waits on
+typedef struct omni_chan_wait_node {
+    omni_chan_waiter_t* waiter;
+    struct omni_chan_wait_node* prev;
+    struct omni_chan_wait_node* next;
+    int32_t linked;
+    int32_t fired; // Taken off the list by a wakeup
+} omni_chan_wait_node_t;
+
+typedef struct {
+    omni_chan_wait_node_t* head;
+    omni_chan_wait_node_t* tail;
+    int32_t count; // Also read without the lock
+} omni_chan_wait_list_t;
+
+struct omni_chan {
+    int32_t elem_size;
+    int32_t stride;
+    int32_t capacity; // 0 if unbounded
+    int32_t closed;
+    // Bounded
+    unsigned char* cells;
+    uint64_t mask;
+    char pad0[64];
+    uint64_t enqueue_pos;
+    char pad1[64];
+    uint64_t dequeue_pos;
+    char pad2[64];
+    // Unbounded
+    omni_chan_segment_t* head;
+    char pad3[64];
+    omni_chan_segment_t* tail;
+    char pad4[64];
+    int32_t active;
+    omni_chan_segment_t* retired;
+    char pad5[64];
+    omni_mutex_t wait_lock;
+    omni_chan_wait_list_t senders;
+    omni_chan_wait_list_t receivers;
+};
+
+// Waits out a peer that claimed a cell and is still copying; yields the
+// thread if the peer seems to be descheduled
+static void omni_chan_backoff(uint32_t* spins) {
+    if (++*spins < 64) {
+        OMNI_CPU_RELAX();
+        return;
+    }
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+static omni_chan_segment_t* omni_chan_segment_new(omni_chan_t* ch, int64_t start) {
+    omni_chan_segment_t* seg = (omni_chan_segment_t*)calloc(1, sizeof(omni_chan_segment_t) + (size_t)OMNI_CHAN_SEGMENT_SLOTS * (size_t)ch->stride);
+    if (seg) seg->start = start;
+    return seg;
+}
+
+static unsigned char* omni_chan_slot(omni_chan_t* ch, omni_chan_segment_t* seg, int64_t index) {
+    return seg->slots + (size_t)index * (size_t)ch->stride;
+}
+
+static unsigned char* omni_chan_cell(omni_chan_t* ch, uint64_t pos) {
+    return ch->cells + (size_t)(pos & ch->mask) * (size_t)ch->stride;
+}
+
+omni_chan_t* omni_chan_create(int32_t elem_size, int32_t capacity) {
+    if (elem_size <= 0 || elem_size > (1 << 20) || capacity > (1 << 30)) return NULL;
+    omni_chan_t* ch = (omni_chan_t*)calloc(1, sizeof(omni_chan_t));
+    if (!ch) return NULL;
+    ch->elem_size = elem_size;
+    ch->stride = OMNI_CHAN_HEADER + ((elem_size + 7) & ~7);
+    omni_mutex_t lock = OMNI_MUTEX_INIT;
+    ch->wait_lock = lock;
+    if (capacity > 0) {
+        // With one cell, "filled on this lap" and "free for the next" would
+        // be the same sequence number
+        uint64_t size = 2;
+        while (size < (uint64_t)capacity) size *= 2;
+        ch->cells = (unsigned char*)malloc((size_t)size * (size_t)ch->stride);
+        if (!ch->cells) {
+            free(ch);
+            return NULL;
+        }
+        for (uint64_t i = 0; i < size; i++) {
+            *(uint64_t*)(ch->cells + (size_t)i * (size_t)ch->stride) = i;
+        }
+        ch->mask = size - 1;
+        ch->capacity = (int32_t)size;
+    } else {
+        ch->head = ch->tail = omni_chan_segment_new(ch, 0);
+        if (!ch->head) {
+            free(ch);
+            return NULL;
+        }
+    }
+    return ch;
+}
+
+void omni_chan_destroy(omni_chan_t* ch) {
+    if (!ch) return;
+    free(ch->cells);
+    omni_chan_segment_t* seg = ch->head;
+    while (seg) {
+        omni_chan_segment_t* next = seg->next;
+        free(seg);
+        seg = next;
+    }
+    seg = ch->retired;
+    while (seg) {
+        omni_chan_segment_t* next = seg->retired_next;
+        free(seg);
+        seg = next;
+    }
+    free(ch);
+}
+
+// Bounded ring
+
+static int omni_chan_ring_push(omni_chan_t* ch, const void* elem) {
+    uint64_t pos = __atomic_load_n(&ch->enqueue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        unsigned char* cell = omni_chan_cell(ch, pos);
+        int64_t diff = (int64_t)(__atomic_load_n((uint64_t*)cell, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ch->enqueue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                memcpy(cell + OMNI_CHAN_HEADER, elem, (size_t)ch->elem_size);
+                __atomic_store_n((uint64_t*)cell, pos + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0; // Full
+        } else {
+            pos = __atomic_load_n(&ch->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static int omni_chan_ring_pop(omni_chan_t* ch, void* out) {
+    uint64_t pos = __atomic_load_n(&ch->dequeue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        unsigned char* cell = omni_chan_cell(ch, pos);
+        int64_t diff = (int64_t)(__atomic_load_n((uint64_t*)cell, __ATOMIC_ACQUIRE) - (pos + 1));
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ch->dequeue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                memcpy(out, cell + OMNI_CHAN_HEADER, (size_t)ch->elem_size);
+                __atomic_store_n((uint64_t*)cell, pos + ch->mask + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0; // Empty
+        } else {
+            pos = __atomic_load_n(&ch->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Claims up to count positions on *claim that the other side's counter
+// shows to be free (room: the ring has capacity minus the gap) or filled
+// (the gap itself); returns how many, from *first
+static uint64_t omni_chan_ring_claim(omni_chan_t* ch, uint64_t* claim, const uint64_t* other, int room, uint64_t count, uint64_t* first) {
+    uint64_t pos = __atomic_load_n(claim, __ATOMIC_RELAXED);
+    for (;;) {
+        uint64_t peer = __atomic_load_n(other, __ATOMIC_ACQUIRE);
+        int64_t gap = room ? (int64_t)(pos - peer) : (int64_t)(peer - pos);
+        if (gap < 0) {
+            // Our position is stale: the peer cannot pass a claim
+            pos = __atomic_load_n(claim, __ATOMIC_RELAXED);
+            continue;
+        }
+        uint64_t available = room ? ch->mask + 1 - (uint64_t)gap : (uint64_t)gap;
+        if (available == 0) return 0;
+        uint64_t n = count < available ? count : available;
+        if (__atomic_compare_exchange_n(claim, &pos, pos + n, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            *first = pos;
+            return n;
+        }
+    }
+}
+
+static int32_t omni_chan_ring_push_n(omni_chan_t* ch, const unsigned char* elems, int32_t count) {
+    uint64_t pos;
+    uint64_t n = omni_chan_ring_claim(ch, &ch->enqueue_pos, &ch->dequeue_pos, 1, (uint64_t)count, &pos);
+    for (uint64_t i = 0; i < n; i++) {
+        unsigned char* cell = omni_chan_cell(ch, pos + i);
+        uint32_t spins = 0;
+        while (__atomic_load_n((uint64_t*)cell, __ATOMIC_ACQUIRE) != pos + i) omni_chan_backoff(&spins);
+        memcpy(cell + OMNI_CHAN_HEADER, elems + (size_t)i * (size_t)ch->elem_size, (size_t)ch->elem_size);
+        __atomic_store_n((uint64_t*)cell, pos + i + 1, __ATOMIC_RELEASE);
+    }
+    return (int32_t)n;
+}
+
+static int32_t omni_chan_ring_pop_n(omni_chan_t* ch, unsigned char* out, int32_t max) {
+    uint64_t pos;
+    uint64_t n = omni_chan_ring_claim(ch, &ch->dequeue_pos, &ch->enqueue_pos, 0, (uint64_t)max, &pos);
+    for (uint64_t i = 0; i < n; i++) {
+        unsigned char* cell = omni_chan_cell(ch, pos + i);
+        uint32_t spins = 0;
+        while (__atomic_load_n((uint64_t*)cell, __ATOMIC_ACQUIRE) != pos + i + 1) omni_chan_backoff(&spins);
+        memcpy(out + (size_t)i * (size_t)ch->elem_size, cell + OMNI_CHAN_HEADER, (size_t)ch->elem_size);
+        __atomic_store_n((uint64_t*)cell, pos + i + ch->mask + 1, __ATOMIC_RELEASE);
+    }
+    return (int32_t)n;
+}
+
+// Unbounded segment list. The head and tail pointers are accessed with
+// sequentially consistent operations: together with `active` they prove a
+// retired segment unreachable (see omni_chan_leave).
+
+static void omni_chan_enter(omni_chan_t* ch) {
+    __atomic_add_fetch(&ch->active, 1, __ATOMIC_SEQ_CST);
+}
+
+// Frees the segments retired before this operation leaves if it is the
+// last one in the channel: any operation that could still be reading them
+// had entered before they were retired, so would still be counted
+static void omni_chan_leave(omni_chan_t* ch) {
+    omni_chan_segment_t* retired = __atomic_exchange_n(&ch->retired, NULL, __ATOMIC_SEQ_CST);
+    if (__atomic_sub_fetch(&ch->active, 1, __ATOMIC_SEQ_CST) == 0) {
+        while (retired) {
+            omni_chan_segment_t* next = retired->retired_next;
+            free(retired);
+            retired = next;
+        }
+        return;
+    }
+    if (!retired) return;
+    omni_chan_segment_t* last = retired;
+    while (last->retired_next) last = last->retired_next;
+    last->retired_next = __atomic_load_n(&ch->retired, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&ch->retired, &last->retired_next, retired, 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void omni_chan_retire(omni_chan_t* ch, omni_chan_segment_t* seg) {
+    seg->retired_next = __atomic_load_n(&ch->retired, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&ch->retired, &seg->retired_next, seg, 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Returns 0 only if a new segment could not be allocated
+static int omni_chan_list_push(omni_chan_t* ch, const void* elem) {
+    for (;;) {
+        omni_chan_segment_t* seg = __atomic_load_n(&ch->tail, __ATOMIC_SEQ_CST);
+        int64_t index = __atomic_fetch_add(&seg->enq, 1, __ATOMIC_RELAXED);
+        if (index < OMNI_CHAN_SEGMENT_SLOTS) {
+            unsigned char* slot = omni_chan_slot(ch, seg, index);
+            memcpy(slot + OMNI_CHAN_HEADER, elem, (size_t)ch->elem_size);
+            int32_t expected = OMNI_CHAN_SLOT_EMPTY;
+            if (__atomic_compare_exchange_n((int32_t*)slot, &expected, OMNI_CHAN_SLOT_FULL, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+                return 1;
+            }
+            continue; // A receiver gave up on this slot
+        }
+        // Full: append a segment holding the element, or help move the tail
+        omni_chan_segment_t* next = __atomic_load_n(&seg->next, __ATOMIC_ACQUIRE);
+        if (!next) {
+            omni_chan_segment_t* fresh = omni_chan_segment_new(ch, seg->start + OMNI_CHAN_SEGMENT_SLOTS);
+            if (!fresh) return 0;
+            memcpy(fresh->slots + OMNI_CHAN_HEADER, elem, (size_t)ch->elem_size);
+            *(int32_t*)fresh->slots = OMNI_CHAN_SLOT_FULL;
+            fresh->enq = 1;
+            if (__atomic_compare_exchange_n(&seg->next, &next, fresh, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+                __atomic_compare_exchange_n(&ch->tail, &seg, fresh, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+                return 1;
+            }
+            free(fresh);
+        }
+        __atomic_compare_exchange_n(&ch->tail, &seg, next, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    }
+}
+
+static int omni_chan_list_pop(omni_chan_t* ch, void* out) {
+    for (;;) {
+        omni_chan_segment_t* seg = __atomic_load_n(&ch->head, __ATOMIC_SEQ_CST);
+        int64_t deq = __atomic_load_n(&seg->deq, __ATOMIC_ACQUIRE);
+        if (deq < OMNI_CHAN_SEGMENT_SLOTS) {
+            if (deq >= __atomic_load_n(&seg->enq, __ATOMIC_ACQUIRE)) return 0; // Empty
+            int64_t index = __atomic_fetch_add(&seg->deq, 1, __ATOMIC_RELAXED);
+            if (index < OMNI_CHAN_SEGMENT_SLOTS) {
+                int32_t* state = (int32_t*)omni_chan_slot(ch, seg, index);
+                // The sender took its index first; give it a moment to
+                // finish before poisoning the slot
+                for (int spin = 0; spin < 64 && __atomic_load_n(state, __ATOMIC_ACQUIRE) == OMNI_CHAN_SLOT_EMPTY; spin++) {
+                    OMNI_CPU_RELAX();
+                }
+                int32_t expected = OMNI_CHAN_SLOT_EMPTY;
+                if (!__atomic_compare_exchange_n(state, &expected, OMNI_CHAN_SLOT_POISONED, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+                    memcpy(out, (unsigned char*)state + OMNI_CHAN_HEADER, (size_t)ch->elem_size);
+                    return 1;
+                }
+                continue;
+            }
+        }
+        // Every slot of this segment is taken: move the head on
+        omni_chan_segment_t* next = __atomic_load_n(&seg->next, __ATOMIC_ACQUIRE);
+        if (!next) return 0;
+        omni_chan_segment_t* tail = seg;
+        __atomic_compare_exchange_n(&ch->tail, &tail, next, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&ch->head, &seg, next, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            omni_chan_retire(ch, seg);
+        }
+    }
+}
+
+// One attempt, without blocking. Sends return 1 when sent, 0 when full and
+// -1 when the channel is closed; receives 1 when an element was taken, 0
+// when empty and -1 when closed and drained.
+
+static int omni_chan_try_push(omni_chan_t* ch, const void* elem) {
+    if (__atomic_load_n(&ch->closed, __ATOMIC_ACQUIRE)) return -1;
+    if (ch->capacity > 0) return omni_chan_ring_push(ch, elem);
+    omni_chan_enter(ch);
+    int sent = omni_chan_list_push(ch, elem);
+    omni_chan_leave(ch);
+    return sent;
+}
+
+static int omni_chan_pop_once(omni_chan_t* ch, void* out) {
+    if (ch->capacity > 0) return omni_chan_ring_pop(ch, out);
+    omni_chan_enter(ch);
+    int taken = omni_chan_list_pop(ch, out);
+    omni_chan_leave(ch);
+    return taken;
+}
+
+static int omni_chan_try_pop(omni_chan_t* ch, void* out) {
+    if (omni_chan_pop_once(ch, out)) return 1;
+    if (!__atomic_load_n(&ch->closed, __ATOMIC_ACQUIRE)) return 0;
+    // A send may have landed just before the close
+    return omni_chan_pop_once(ch, out) ? 1 : -1;
+}
+
+// Waiting
+
+static void omni_chan_link(omni_chan_wait_list_t* list, omni_chan_wait_node_t* node) {
+    node->prev = list->tail;
+    node->next = NULL;
+    if (list->tail) {
+        list->tail->next = node;
+    } else {
+        list->head = node;
+    }
+    list->tail = node;
+    node->linked = 1;
+    node->fired = 0;
+    __atomic_store_n(&list->count, list->count + 1, __ATOMIC_SEQ_CST);
+}
+
+static void omni_chan_unlink(omni_chan_wait_list_t* list, omni_chan_wait_node_t* node) {
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        list->head = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    } else {
+        list->tail = node->prev;
+    }
+    node->linked = 0;
+    __atomic_store_n(&list->count, list->count - 1, __ATOMIC_SEQ_CST);
+}
+
+static void omni_chan_signal(omni_chan_waiter_t* waiter) {
+    if (waiter->helping) {
+        // The waiter may return as soon as it sees the flag
+        OMNI_STORE_RELEASE(&waiter->signaled, 1);
+        omni_sched_notify(1);
+        return;
+    }
+    omni_chan_parker_t* parker = waiter->parker;
+    omni_mutex_lock(&parker->mutex);
+    OMNI_STORE_RELEASE(&waiter->signaled, 1);
+    omni_cond_signal(&parker->cond);
+    omni_mutex_unlock(&parker->mutex);
+}
+
+// Wakes up to n waiters of list; the caller holds wait_lock
+static void omni_chan_wake_locked(omni_chan_wait_list_t* list, int32_t n) {
+    while (n-- > 0 && list->head) {
+        omni_chan_wait_node_t* node = list->head;
+        omni_chan_unlink(list, node);
+        node->fired = 1;
+        omni_chan_signal(node->waiter);
+    }
+}
+
+static omni_chan_wait_list_t* omni_chan_list_for(omni_chan_t* ch, int32_t dir) {
+    return dir == OMNI_CHAN_SEND ? &ch->senders : &ch->receivers;
+}
+
+// Called after n elements went in (dir = OMNI_CHAN_SEND) or out of the
+// channel, to wake as many waiters on the other side. The fence pairs with
+// the one a waiter issues between registering and retrying.
+static void omni_chan_wake(omni_chan_t* ch, int32_t dir, int32_t n) {
+    omni_chan_wait_list_t* list = omni_chan_list_for(ch, dir == OMNI_CHAN_SEND ? OMNI_CHAN_RECV : OMNI_CHAN_SEND);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&list->count, __ATOMIC_RELAXED) == 0) return;
+    omni_mutex_lock(&ch->wait_lock);
+    omni_chan_wake_locked(list, n);
+    omni_mutex_unlock(&ch->wait_lock);
+}
+
+// Tries every case once, starting at a rotating offset so no case starves
+static int32_t omni_chan_poll(omni_chan_case_t* cases, int32_t count, uint32_t start) {
+    for (int32_t k = 0; k < count; k++) {
+        int32_t i = (int32_t)((start + (uint32_t)k) % (uint32_t)count);
+        omni_chan_case_t* c = &cases[i];
+        if (!c->chan) continue;
+        int result = c->dir == OMNI_CHAN_SEND ? omni_chan_try_push(c->chan, c->data) : omni_chan_try_pop(c->chan, c->data);
+        if (result == 0) continue;
+        c->ok = result > 0;
+        if (c->ok) omni_chan_wake(c->chan, c->dir, 1);
+        return i;
+    }
+    return -1;
+}
+
+#define OMNI_CHAN_STACK_NODES 8
+
+int32_t omni_chan_select(omni_chan_case_t* cases, int32_t count, int32_t block) {
+    static uint32_t rotation = 0;
+    if (!cases || count <= 0) return -1;
+    int32_t live = 0;
+    for (int32_t i = 0; i < count; i++) {
+        cases[i].ok = 0;
+        if (cases[i].chan) live++;
+    }
+    uint32_t start = count > 1 ? __atomic_fetch_add(&rotation, 1, __ATOMIC_RELAXED) : 0;
+    int32_t chosen = omni_chan_poll(cases, count, start);
+    if (chosen >= 0 || !block || live == 0) return chosen;
+    for (int32_t polls = 0; polls < OMNI_CHAN_POLLS; polls++) {
+        OMNI_CPU_RELAX();
+        if ((chosen = omni_chan_poll(cases, count, start)) >= 0) return chosen;
+    }
+
+    omni_chan_wait_node_t stack_nodes[OMNI_CHAN_STACK_NODES];
+    omni_chan_wait_node_t* nodes = stack_nodes;
+    if (count > OMNI_CHAN_STACK_NODES) {
+        nodes = (omni_chan_wait_node_t*)malloc((size_t)count * sizeof(omni_chan_wait_node_t));
+        if (!nodes) {
+            // Cannot register: keep polling
+            while ((chosen = omni_chan_poll(cases, count, start)) < 0) {
+#ifdef _WIN32
+                SwitchToThread();
+#else
+                sched_yield();
+#endif
+            }
+            return chosen;
+        }
+    }
+    omni_chan_waiter_t waiter;
+    waiter.signaled = 0;
+    waiter.parker = &omni_chan_parker;
+    int spare = omni_sched_blocking();
+    // Past the spare cap, a pool thread helps with tasks rather than sleep
+    waiter.helping = !spare && omni_in_pool;
+    for (int32_t i = 0; i < count; i++) {
+        nodes[i].waiter = &waiter;
+        nodes[i].linked = 0;
+        nodes[i].fired = 0;
+    }
+
+    for (;;) {
+        __atomic_store_n(&waiter.signaled, 0, __ATOMIC_RELAXED);
+        for (int32_t i = 0; i < count; i++) {
+            omni_chan_t* ch = cases[i].chan;
+            if (!ch || nodes[i].linked) continue;
+            omni_mutex_lock(&ch->wait_lock);
+            omni_chan_link(omni_chan_list_for(ch, cases[i].dir), &nodes[i]);
+            omni_mutex_unlock(&ch->wait_lock);
+        }
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if ((chosen = omni_chan_poll(cases, count, start)) >= 0) break;
+        if (waiter.helping) {
+            while (!OMNI_LOAD_ACQUIRE(&waiter.signaled)) {
+                omni_sched_step(omni_current_worker, &waiter.signaled);
+            }
+        } else {
+            omni_mutex_lock(&waiter.parker->mutex);
+            while (!OMNI_LOAD_ACQUIRE(&waiter.signaled)) {
+                omni_cond_wait(&waiter.parker->cond, &waiter.parker->mutex);
+            }
+            omni_mutex_unlock(&waiter.parker->mutex);
+        }
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        omni_chan_t* ch = cases[i].chan;
+        if (!ch) continue;
+        omni_mutex_lock(&ch->wait_lock);
+        omni_chan_wait_list_t* list = omni_chan_list_for(ch, cases[i].dir);
+        if (nodes[i].linked) {
+            omni_chan_unlink(list, &nodes[i]);
+        } else if (nodes[i].fired && i != chosen) {
+            // Woken for a case it did not take: pass the wakeup on
+            omni_chan_wake_locked(list, 1);
+        }
+        omni_mutex_unlock(&ch->wait_lock);
+    }
+    if (nodes != stack_nodes) free(nodes);
+    omni_sched_unblocked(spare);
+    return chosen;
+}
+
+int32_t omni_chan_try_send(omni_chan_t* ch, const void* elem) {
+    if (!ch || !elem || omni_chan_try_push(ch, elem) <= 0) return 0;
+    omni_chan_wake(ch, OMNI_CHAN_SEND, 1);
+    return 1;
+}
+
+int32_t omni_chan_try_recv(omni_chan_t* ch, void* out) {
+    if (!ch || !out || omni_chan_try_pop(ch, out) <= 0) return 0;
+    omni_chan_wake(ch, OMNI_CHAN_RECV, 1);
+    return 1;
+}
+
+int32_t omni_chan_send(omni_chan_t* ch, const void* elem) {
+    if (!ch || !elem) return 0;
+    omni_chan_case_t c = {ch, OMNI_CHAN_SEND, (void*)elem, 0};
+    return omni_chan_select(&c, 1, 1) == 0 && c.ok;
+}
+
+int32_t omni_chan_recv(omni_chan_t* ch, void* out) {
+    if (!ch || !out) return 0;
+    omni_chan_case_t c = {ch, OMNI_CHAN_RECV, out, 0};
+    return omni_chan_select(&c, 1, 1) == 0 && c.ok;
+}
+
+// The batch forms move what they can in one claim and fall back to a
+// blocking single-element operation when nothing fits
+int32_t omni_chan_send_n(omni_chan_t* ch, const void* elems, int32_t count) {
+    if (!ch || !elems || count <= 0) return 0;
+    const unsigned char* bytes = (const unsigned char*)elems;
+    int32_t sent = 0;
+    while (sent < count) {
+        if (__atomic_load_n(&ch->closed, __ATOMIC_ACQUIRE)) break;
+        const unsigned char* next = bytes + (size_t)sent * (size_t)ch->elem_size;
+        int32_t n = 0;
+        if (ch->capacity > 0) {
+            n = omni_chan_ring_push_n(ch, next, count - sent);
+        } else {
+            // Never full: the slots are claimed one at a time
+            omni_chan_enter(ch);
+            while (n < count - sent && omni_chan_list_push(ch, next + (size_t)n * (size_t)ch->elem_size)) n++;
+            omni_chan_leave(ch);
+            if (n == 0) break;
+        }
+        if (n > 0) {
+            sent += n;
+            omni_chan_wake(ch, OMNI_CHAN_SEND, n);
+        } else if (omni_chan_send(ch, next)) {
+            sent++;
+        } else {
+            break;
+        }
+    }
+    return sent;
+}
+
+int32_t omni_chan_recv_n(omni_chan_t* ch, void* out, int32_t max) {
+    if (!ch || !out || max <= 0) return 0;
+    unsigned char* bytes = (unsigned char*)out;
+    int32_t taken = 0;
+    if (ch->capacity > 0) {
+        taken = omni_chan_ring_pop_n(ch, bytes, max);
+    } else {
+        omni_chan_enter(ch);
+        while (taken < max && omni_chan_list_pop(ch, bytes + (size_t)taken * (size_t)ch->elem_size)) taken++;
+        omni_chan_leave(ch);
+    }
+    if (taken > 0) {
+        omni_chan_wake(ch, OMNI_CHAN_RECV, taken);
+        return taken;
+    }
+    if (!omni_chan_recv(ch, bytes)) return 0;
+    // Take whatever else has arrived along with it
+    taken = 1;
+    while (taken < max && omni_chan_try_recv(ch, bytes + (size_t)taken * (size_t)ch->elem_size)) taken++;
+    return taken;
+}
+
+void omni_chan_close(omni_chan_t* ch) {
+    if (!ch) return;
+    __atomic_store_n(&ch->closed, 1, __ATOMIC_SEQ_CST);
+    omni_mutex_lock(&ch->wait_lock);
+    omni_chan_wake_locked(&ch->senders, INT32_MAX);
+    omni_chan_wake_locked(&ch->receivers, INT32_MAX);
+    omni_mutex_unlock(&ch->wait_lock);
+}
+
+int32_t omni_chan_is_closed(omni_chan_t* ch) {
+    return ch ? __atomic_load_n(&ch->closed, __ATOMIC_ACQUIRE) : 1;
+}
+
+int32_t omni_chan_len(omni_chan_t* ch) {
+    if (!ch) return 0;
+    if (ch->capacity > 0) {
+        // Dequeue first: it never passes enqueue
+        uint64_t deq = __atomic_load_n(&ch->dequeue_pos, __ATOMIC_ACQUIRE);
+        uint64_t enq = __atomic_load_n(&ch->enqueue_pos, __ATOMIC_ACQUIRE);
+        return (int32_t)(enq - deq);
+    }
+    omni_chan_enter(ch);
+    omni_chan_segment_t* head = __atomic_load_n(&ch->head, __ATOMIC_SEQ_CST);
+    int64_t deq = __atomic_load_n(&head->deq, __ATOMIC_ACQUIRE);
+    omni_chan_segment_t* tail = __atomic_load_n(&ch->tail, __ATOMIC_SEQ_CST);
+    int64_t enq = __atomic_load_n(&tail->enq, __ATOMIC_ACQUIRE);
+    int64_t len = (tail->start + (enq < OMNI_CHAN_SEGMENT_SLOTS ? enq : OMNI_CHAN_SEGMENT_SLOTS)) -
+                  (head->start + (deq < OMNI_CHAN_SEGMENT_SLOTS ? deq : OMNI_CHAN_SEGMENT_SLOTS));
+    omni_chan_leave(ch);
+    if (len < 0) return 0;
+    return len > INT32_MAX ? INT32_MAX : (int32_t)len;
+}
+
+int32_t omni_chan_capacity(omni_chan_t* ch) {
+    return ch ? ch->capacity : 0;
+}
+
+// ============================================================================
+// Parallel Algorithms
+// ============================================================================
+
+// Data-parallel loops, sorts and reductions on the task scheduler.
+//
+// omni_parallel_for splits ranges lazily: a task holding more than the grain
+// halves its range, spawns the upper half and keeps the lower one. Work is
+// therefore only divided as fast as idle workers steal it, and a busy pool
+// runs a loop in a few large pieces. The caller runs the first range itself
+// and then helps with other tasks until every range is done, so parallel
+// loops nest and may start from inside tasks.
+//
+// The algorithms below cut their input into blocks of OMNI_PARALLEL_CHUNK
+// bytes, so each task streams through a block that fits in cache. Inputs
+// under OMNI_PARALLEL_MIN elements, or with no pool to run on, stay on the
+// calling thread. Reductions combine their per-block results in block
+// order, so results do not depend on how the work was scheduled.
+#define OMNI_PARALLEL_CHUNK (64 * 1024)
+#define OMNI_PARALLEL_MIN 16384
+
+typedef struct {
+    omni_parallel_range_fn fn;
+    void* ctx;
+    int64_t grain;
+    int64_t pending; // Ranges started but not finished
+    int32_t done;
+} omni_parallel_job_t;
+
+typedef struct {
+    omni_parallel_job_t* job;
+    int64_t begin;
+    int64_t end;
+} omni_parallel_range_t;
+
+static void omni_parallel_run(omni_parallel_job_t* job, int64_t begin, int64_t end);
+
+static void omni_parallel_task(void* data) {
+    omni_parallel_range_t range = *(omni_parallel_range_t*)data;
+    free(data);
+    omni_parallel_run(range.job, range.begin, range.end);
+}
+
+// Runs [begin, end), splitting upper halves off as tasks while it is larger
+// than the grain. The last range to finish marks the job done; the job
+// lives on the caller's stack, so that store is its last access to it.
+static void omni_parallel_run(omni_parallel_job_t* job, int64_t begin, int64_t end) {
+    while (end - begin > job->grain) {
+        int64_t mid = begin + (end - begin) / 2;
+        omni_parallel_range_t* half = (omni_parallel_range_t*)malloc(sizeof(omni_parallel_range_t));
+        if (!half) break; // Run the rest here
+        half->job = job;
+        half->begin = mid;
+        half->end = end;
+        __atomic_add_fetch(&job->pending, 1, __ATOMIC_RELAXED);
+        omni_task_spawn(omni_parallel_task, half);
+        end = mid;
+    }
+    job->fn(job->ctx, begin, end);
+    if (__atomic_sub_fetch(&job->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        OMNI_STORE_RELEASE(&job->done, 1);
+        omni_sched_notify(1);
+    }
+}
+
+void omni_parallel_for(int64_t begin, int64_t end, int64_t grain, omni_parallel_range_fn fn, void* ctx) {
+    if (!fn || end <= begin) return;
+    int32_t workers = omni_scheduler_workers();
+    if (grain <= 0) {
+        // About eight pieces per thread leaves room to balance uneven work
+        grain = (end - begin) / ((int64_t)(workers + 1) * 8);
+        if (grain < 1) grain = 1;
+    }
+    if (workers == 0 || end - begin <= grain) {
+        fn(ctx, begin, end);
+        return;
+    }
+    omni_parallel_job_t job;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.grain = grain;
+    job.pending = 1;
+    job.done = 0;
+    omni_parallel_run(&job, begin, end);
+    while (!OMNI_LOAD_ACQUIRE(&job.done)) {
+        omni_sched_step(omni_current_worker, &job.done);
+    }
+}
+
+// Number of blocks of at most OMNI_PARALLEL_CHUNK bytes covering n elements,
+// each holding *block_len of them (the last one possibly fewer)
+static int64_t omni_parallel_blocks(int64_t n, size_t elem_size, int64_t* block_len) {
+    int64_t len = (int64_t)(OMNI_PARALLEL_CHUNK / elem_size);
+    if (len < 1) len = 1;
+    if (n < OMNI_PARALLEL_MIN || omni_scheduler_workers() == 0) len = n > 0 ? n : 1;
+    *block_len = len;
+    return (n + len - 1) / len;
+}
+
+// Vector map and reduce
+typedef struct {
+    const char* src;
+    char* dst;
+    size_t src_size;
+    size_t dst_size;
+    int64_t n;
+    int64_t block_len;
+    omni_parallel_map_fn map;
+    omni_parallel_fold_fn fold;
+    void* partials;
+    size_t acc_size;
+    void* ctx;
+} omni_parallel_vec_job_t;
+
+static void omni_parallel_map_blocks(void* data, int64_t begin, int64_t end) {
+    omni_parallel_vec_job_t* job = (omni_parallel_vec_job_t*)data;
+    for (int64_t b = begin; b < end; b++) {
+        int64_t lo = b * job->block_len;
+        int64_t count = job->n - lo < job->block_len ? job->n - lo : job->block_len;
+        job->map(job->ctx, job->src + lo * job->src_size, job->dst + lo * job->dst_size, count);
+    }
+}
+
+static void omni_parallel_fold_blocks(void* data, int64_t begin, int64_t end) {
+    omni_parallel_vec_job_t* job = (omni_parallel_vec_job_t*)data;
+    for (int64_t b = begin; b < end; b++) {
+        int64_t lo = b * job->block_len;
+        int64_t count = job->n - lo < job->block_len ? job->n - lo : job->block_len;
+        job->fold(job->ctx, job->src + lo * job->src_size, count, (char*)job->partials + b * job->acc_size);
+    }
+}
+
+omni_vec_t* omni_parallel_map(const omni_vec_t* src, int32_t kind, omni_parallel_map_fn fn, void* ctx) {
+    if (!src || !fn) return NULL;
+    omni_vec_t* dst = omni_vec_create(kind, src->length);
+    if (!dst || !omni_vec_resize(dst, src->length)) {
+        omni_vec_destroy(dst);
+        return NULL;
+    }
+    if (src->length == 0) return dst;
+    omni_parallel_vec_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.src = (const char*)src->data;
+    job.dst = (char*)dst->data;
+    job.src_size = (size_t)src->elem_size;
+    job.dst_size = (size_t)dst->elem_size;
+    job.n = src->length;
+    job.map = fn;
+    job.ctx = ctx;
+    size_t widest = job.src_size > job.dst_size ? job.src_size : job.dst_size;
+    int64_t blocks = omni_parallel_blocks(job.n, widest, &job.block_len);
+    omni_parallel_for(0, blocks, 1, omni_parallel_map_blocks, &job);
+    return dst;
+}
+
+int32_t omni_parallel_reduce(const omni_vec_t* vec, void* acc, size_t acc_size,
+                             omni_parallel_fold_fn fold, omni_parallel_combine_fn combine, void* ctx) {
+    if (!vec || !acc || acc_size == 0 || !fold || !combine) return 0;
+    if (vec->length == 0) return 1;
+    omni_parallel_vec_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.src = (const char*)vec->data;
+    job.src_size = (size_t)vec->elem_size;
+    job.n = vec->length;
+    job.fold = fold;
+    job.acc_size = acc_size;
+    job.ctx = ctx;
+    int64_t blocks = omni_parallel_blocks(job.n, job.src_size, &job.block_len);
+    if (blocks == 1) {
+        fold(ctx, job.src, job.n, acc);
+        return 1;
+    }
+    job.partials = malloc((size_t)blocks * acc_size);
+    if (!job.partials) return 0;
+    for (int64_t b = 0; b < blocks; b++) {
+        memcpy((char*)job.partials + b * acc_size, acc, acc_size);
+    }
+    omni_parallel_for(0, blocks, 1, omni_parallel_fold_blocks, &job);
+    for (int64_t b = 0; b < blocks; b++) {
+        combine(ctx, acc, (char*)job.partials + b * acc_size);
+    }
+    free(job.partials);
+    return 1;
+}
+
+// Integer reductions over plain arrays, built on the vector kernels
+typedef struct {
+    int64_t sum;
+    int32_t lo;
+    int32_t hi;
+} omni_parallel_int_acc_t;
+
+static void omni_parallel_sum_fold(void* ctx, const void* src, int64_t count, void* acc) {
+    (void)ctx;
+    ((omni_parallel_int_acc_t*)acc)->sum += omni_sum_int32((const int32_t*)src, (int32_t)count);
+}
+
+static void omni_parallel_sum_combine(void* ctx, void* acc, const void* other) {
+    (void)ctx;
+    ((omni_parallel_int_acc_t*)acc)->sum += ((const omni_parallel_int_acc_t*)other)->sum;
+}
+
+static void omni_parallel_minmax_fold(void* ctx, const void* src, int64_t count, void* acc) {
+    (void)ctx;
+    omni_parallel_int_acc_t* a = (omni_parallel_int_acc_t*)acc;
+    int32_t lo, hi;
+    omni_minmax_int32((const int32_t*)src, (int32_t)count, &lo, &hi);
+    if (lo < a->lo) a->lo = lo;
+    if (hi > a->hi) a->hi = hi;
+}
+
+static void omni_parallel_minmax_combine(void* ctx, void* acc, const void* other) {
+    (void)ctx;
+    omni_parallel_int_acc_t* a = (omni_parallel_int_acc_t*)acc;
+    const omni_parallel_int_acc_t* b = (const omni_parallel_int_acc_t*)other;
+    if (b->lo < a->lo) a->lo = b->lo;
+    if (b->hi > a->hi) a->hi = b->hi;
+}
+
+// Wraps a caller's array without copying it
+static omni_vec_t omni_parallel_view_int(const int32_t* data, int64_t n) {
+    omni_vec_t view;
+    view.data = (void*)data;
+    view.length = (data && n > 0) ? (int32_t)(n < INT32_MAX ? n : INT32_MAX) : 0;
+    view.capacity = view.length;
+    view.elem_size = (int32_t)sizeof(int32_t);
+    view.kind = OMNI_VEC_INT;
+    return view;
+}
+
+int64_t omni_parallel_sum_int(const int32_t* data, int64_t n) {
+    omni_vec_t view = omni_parallel_view_int(data, n);
+    omni_parallel_int_acc_t acc = {0, 0, 0};
+    omni_parallel_reduce(&view, &acc, sizeof(acc), omni_parallel_sum_fold, omni_parallel_sum_combine, NULL);
+    return acc.sum;
+}
+
+static omni_parallel_int_acc_t omni_parallel_minmax_int(const int32_t* data, int64_t n) {
+    omni_vec_t view = omni_parallel_view_int(data, n);
+    omni_parallel_int_acc_t acc = {0, INT32_MAX, INT32_MIN};
+    if (view.length == 0) {
+        acc.lo = acc.hi = 0;
+        return acc;
+    }
+    omni_parallel_reduce(&view, &acc, sizeof(acc), omni_parallel_minmax_fold, omni_parallel_minmax_combine, NULL);
+    return acc;
+}
+
+int32_t omni_parallel_min_int(const int32_t* data, int64_t n) {
+    return omni_parallel_minmax_int(data, n).lo;
+}
+
+int32_t omni_parallel_max_int(const int32_t* data, int64_t n) {
+    return omni_parallel_minmax_int(data, n).hi;
+}
+
+// Radix sort. Each of the four passes scatters the keys by one byte,
+// least significant first, with the sign bit flipped so negative keys order
+// first. Every block histograms its part of the input, the histograms are
+// turned into per-block write offsets, and the blocks then scatter in
+// parallel; a pass whose byte is the same for every key is skipped.
+#define OMNI_RADIX_BUCKETS 256
+
+typedef struct {
+    const uint32_t* src;
+    uint32_t* dst;
+    int64_t n;
+    int64_t block_len;
+    int32_t shift;
+    int64_t* counts; // blocks x OMNI_RADIX_BUCKETS, then offsets
+} omni_radix_job_t;
+
+static void omni_radix_histogram(void* data, int64_t begin, int64_t end) {
+    omni_radix_job_t* job = (omni_radix_job_t*)data;
+    for (int64_t b = begin; b < end; b++) {
+        int64_t* counts = job->counts + b * OMNI_RADIX_BUCKETS;
+        int64_t lo = b * job->block_len;
+        int64_t hi = lo + job->block_len < job->n ? lo + job->block_len : job->n;
+        memset(counts, 0, OMNI_RADIX_BUCKETS * sizeof(int64_t));
+        for (int64_t i = lo; i < hi; i++) {
+            counts[((job->src[i] ^ 0x80000000u) >> job->shift) & 0xff]++;
+        }
+    }
+}
+
+static void omni_radix_scatter(void* data, int64_t begin, int64_t end) {
+    omni_radix_job_t* job = (omni_radix_job_t*)data;
+    for (int64_t b = begin; b < end; b++) {
+        int64_t* offsets = job->counts + b * OMNI_RADIX_BUCKETS;
+        int64_t lo = b * job->block_len;
+        int64_t hi = lo + job->block_len < job->n ? lo + job->block_len : job->n;
+        for (int64_t i = lo; i < hi; i++) {
+            uint32_t key = job->src[i];
+            job->dst[offsets[((key ^ 0x80000000u) >> job->shift) & 0xff]++] = key;
+        }
+    }
+}
+
+int32_t omni_parallel_sort_int(int32_t* data, int64_t n) {
+    if (!data || n < 2) return 1;
+    if (n < 32) {
+        for (int64_t i = 1; i < n; i++) {
+            int32_t key = data[i];
+            int64_t j = i;
+            for (; j > 0 && data[j - 1] > key; j--) data[j] = data[j - 1];
+            data[j] = key;
+        }
+        return 1;
+    }
+    omni_radix_job_t job;
+    // Blocks only split the scatter, so a few per thread are enough; fewer,
+    // larger blocks keep the histograms small
+    int32_t workers = omni_scheduler_workers();
+    int64_t blocks = n < OMNI_PARALLEL_MIN ? 1 : (int64_t)(workers + 1) * 4;
+    job.block_len = (n + blocks - 1) / blocks;
+    blocks = (n + job.block_len - 1) / job.block_len;
+    job.n = n;
+    job.counts = (int64_t*)malloc((size_t)blocks * OMNI_RADIX_BUCKETS * sizeof(int64_t));
+    uint32_t* scratch = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    if (!job.counts || !scratch) {
+        free(job.counts);
+        free(scratch);
+        return 0;
+    }
+    uint32_t* src = (uint32_t*)data;
+    uint32_t* dst = scratch;
+    for (job.shift = 0; job.shift < 32; job.shift += 8) {
+        job.src = src;
+        job.dst = dst;
+        omni_parallel_for(0, blocks, 1, omni_radix_histogram, &job);
+        // Exclusive prefix sums, bucket-major so each bucket's blocks land
+        // in block order
+        int64_t offset = 0;
+        int uniform = 0;
+        for (int32_t bucket = 0; bucket < OMNI_RADIX_BUCKETS; bucket++) {
+            int64_t before = offset;
+            for (int64_t b = 0; b < blocks; b++) {
+                int64_t* count = &job.counts[b * OMNI_RADIX_BUCKETS + bucket];
+                int64_t c = *count;
+                *count = offset;
+                offset += c;
+            }
+            if (offset - before == n) uniform = 1;
+        }
+        if (uniform) continue; // Every key has the same byte here
+        omni_parallel_for(0, blocks, 1, omni_radix_scatter, &job);
+        uint32_t* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != (uint32_t*)data) {
+        memcpy(data, src, (size_t)n * sizeof(uint32_t));
+    }
+    free(scratch);
+    free(job.counts);
+    return 1;
+}
+
+// String merge sort. Runs of the input are sorted concurrently with qsort,
+// then merged pairwise in rounds. Each round is one parallel loop over
+// output positions: a range of the output finds where it starts and ends
+// in the two runs it draws from by binary search (the merge path), so every
+// round, down to the final two-run merge, splits across all threads.
+typedef struct {
+    const char** src;
+    const char** dst;
+    int64_t n;
+    int64_t width; // Length of the runs being merged
+} omni_merge_job_t;
+
+static int omni_string_ptr_compare(const void* a, const void* b) {
+    const char* x = *(const char* const*)a;
+    const char* y = *(const char* const*)b;
+    return strcmp(x ? x : "", y ? y : "");
+}
+
+static int omni_merge_less(const char* a, const char* b) {
+    return strcmp(a ? a : "", b ? b : "") < 0;
+}
+
+static void omni_merge_sort_runs(void* data, int64_t begin, int64_t end) {
+    omni_merge_job_t* job = (omni_merge_job_t*)data;
+    for (int64_t r = begin; r < end; r++) {
+        int64_t lo = r * job->width;
+        int64_t hi = lo + job->width < job->n ? lo + job->width : job->n;
+        qsort(job->src + lo, (size_t)(hi - lo), sizeof(const char*), omni_string_ptr_compare);
+    }
+}
+
+// How many of the first k elements of the merge of a and b come from a
+// (ties taken from a first)
+static int64_t omni_merge_corank(int64_t k, const char** a, int64_t na, const char** b, int64_t nb) {
+    int64_t lo = k > nb ? k - nb : 0;
+    int64_t hi = k < na ? k : na;
+    while (lo < hi) {
+        int64_t i = lo + (hi - lo) / 2;
+        // a[i] belongs in the first k if it does not come after b[k - i - 1]
+        if (!omni_merge_less(b[k - i - 1], a[i])) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+static void omni_merge_range(void* data, int64_t begin, int64_t end) {
+    omni_merge_job_t* job = (omni_merge_job_t*)data;
+    while (begin < end) {
+        // The pair of runs holding output position begin
+        int64_t pair = begin - begin % (2 * job->width);
+        int64_t mid = pair + job->width < job->n ? pair + job->width : job->n;
+        int64_t pair_end = pair + 2 * job->width < job->n ? pair + 2 * job->width : job->n;
+        int64_t stop = pair_end < end ? pair_end : end;
+        const char** a = job->src + pair;
+        const char** b = job->src + mid;
+        int64_t na = mid - pair;
+        int64_t nb = pair_end - mid;
+        int64_t i = omni_merge_corank(begin - pair, a, na, b, nb);
+        int64_t j = begin - pair - i;
+        int64_t i_end = omni_merge_corank(stop - pair, a, na, b, nb);
+        int64_t j_end = stop - pair - i_end;
+        const char** out = job->dst + begin;
+        while (i < i_end && j < j_end) {
+            *out++ = omni_merge_less(b[j], a[i]) ? b[j++] : a[i++];
+        }
+        while (i < i_end) *out++ = a[i++];
+        while (j < j_end) *out++ = b[j++];
+        begin = stop;
+    }
+}
+
+int32_t omni_parallel_sort_string(const char** data, int64_t n) {
+    if (!data || n < 2) return 1;
+    int32_t workers = omni_scheduler_workers();
+    if (n < OMNI_PARALLEL_MIN || workers == 0) {
+        qsort(data, (size_t)n, sizeof(const char*), omni_string_ptr_compare);
+        return 1;
+    }
+    const char** scratch = (const char**)malloc((size_t)n * sizeof(const char*));
+    if (!scratch) return 0;
+    omni_merge_job_t job;
+    job.n = n;
+    // Two runs per thread, so the first round already has work for all
+    int64_t runs = (int64_t)(workers + 1) * 2;
+    job.width = (n + runs - 1) / runs;
+    runs = (n + job.width - 1) / job.width;
+    job.src = data;
+    omni_parallel_for(0, runs, 1, omni_merge_sort_runs, &job);
+
+    int64_t grain = OMNI_PARALLEL_CHUNK / (int64_t)sizeof(const char*);
+    job.dst = scratch;
+    for (; job.width < n; job.width *= 2) {
+        omni_parallel_for(0, n, grain, omni_merge_range, &job);
+        const char** tmp = job.src;
+        job.src = job.dst;
+        job.dst = tmp;
+    }
+    if (job.src != data) {
+        memcpy(data, job.src, (size_t)n * sizeof(const char*));
+    }
+    free(scratch);
+    return 1;
+}
+
+// Bulk map build. Keys are first grouped by which slice of the table their
+// home group falls in. Each slice is then filled by one task, which owns
+// those groups outright: a key whose probe sequence would step outside the
+// slice is set aside instead. The set-aside keys, a small fraction at the
+// half load the table is sized for, are inserted afterwards through the
+// normal path. Keys stay in input order within a slice, and a later copy
+// of a set-aside key is always set aside too, so the last value for a
+// repeated key wins, as with successive puts.
+typedef struct {
+    const int32_t* keys;
+    const int32_t* values;
+    int64_t n;
+    int64_t block_len;
+    omni_map_table_t* table;
+    int32_t slice_shift;  // Group index >> slice_shift = slice
+    int64_t slices;
+    int64_t* counts;      // blocks x slices, then write offsets
+    int64_t* starts;      // slices + 1 bounds into order
+    uint32_t* order;      // Input positions grouped by slice
+    int64_t* claimed;     // Per slice: slots filled
+    int64_t* set_aside;   // Per slice: positions left at the front of its range
+} omni_map_build_job_t;
+
+static uint32_t omni_map_build_slice(const omni_map_build_job_t* job, int32_t key) {
+    uint64_t hash = omni_map_mix(hash_int(key));
+    uint32_t group_mask = job->table->capacity / OMNI_MAP_GROUP_WIDTH - 1;
+    return ((uint32_t)(hash >> 7) & group_mask) >> job->slice_shift;
+}
+
+static void omni_map_build_count(void* data, int64_t begin, int64_t end) {
+    omni_map_build_job_t* job = (omni_map_build_job_t*)data;
+    for (int64_t b = begin; b < end; b++) {
+        int64_t* counts = job->counts + b * job->slices;
+        int64_t lo = b * job->block_len;
+        int64_t hi = lo + job->block_len < job->n ? lo + job->block_len : job->n;
+        memset(counts, 0, (size_t)job->slices * sizeof(int64_t));
+        for (int64_t i = lo; i < hi; i++) {
+            counts[omni_map_build_slice(job, job->keys[i])]++;
+        }
+    }
+}
+
+static void omni_map_build_scatter(void* data, int64_t begin, int64_t end) {
+    omni_map_build_job_t* job = (omni_map_build_job_t*)data;
+    for (int64_t b = begin; b < end; b++) {
+        int64_t* offsets = job->counts + b * job->slices;
+        int64_t lo = b * job->block_len;
+        int64_t hi = lo + job->block_len < job->n ? lo + job->block_len : job->n;
+        for (int64_t i = lo; i < hi; i++) {
+            job->order[offsets[omni_map_build_slice(job, job->keys[i])]++] = (uint32_t)i;
+        }
+    }
+}
+
+static void omni_map_build_fill(void* data, int64_t begin, int64_t end) {
+    omni_map_build_job_t* job = (omni_map_build_job_t*)data;
+    omni_map_table_t* t = job->table;
+    uint32_t group_mask = t->capacity / OMNI_MAP_GROUP_WIDTH - 1;
+    for (int64_t s = begin; s < end; s++) {
+        int64_t claimed = 0;
+        int64_t kept = job->starts[s];
+        for (int64_t at = job->starts[s]; at < job->starts[s + 1]; at++) {
+            uint32_t pos = job->order[at];
+            int32_t key = job->keys[pos];
+            uint64_t hash = omni_map_mix(hash_int(key));
+            int8_t h2 = (int8_t)(hash & 0x7f);
+            uint32_t group = (uint32_t)(hash >> 7) & group_mask;
+            omni_map_slot_t* slot = NULL;
+            // The table starts empty and only gains keys, so a group with a
+            // free slot ends both the lookup and the search for a slot
+            for (uint32_t step = 1; (int64_t)(group >> job->slice_shift) == s; step++) {
+                int8_t* ctrl = t->ctrl + (size_t)group * OMNI_MAP_GROUP_WIDTH;
+                uint32_t match = omni_map_group_match(ctrl, h2);
+                while (match) {
+                    uint32_t index = group * OMNI_MAP_GROUP_WIDTH + (uint32_t)__builtin_ctz(match);
+                    if (t->slots[index].key.i == key) {
+                        slot = &t->slots[index];
+                        break;
+                    }
+                    match &= match - 1;
+                }
+                if (slot) break;
+                uint32_t empty = omni_map_group_match_empty(ctrl);
+                if (empty) {
+                    uint32_t index = group * OMNI_MAP_GROUP_WIDTH + (uint32_t)__builtin_ctz(empty);
+                    t->ctrl[index] = h2;
+                    slot = &t->slots[index];
+                    slot->key.i = key;
+                    slot->hash = hash_int(key);
+                    slot->key_len = 0;
+                    claimed++;
+                    break;
+                }
+                group = (group + step) & group_mask;
+            }
+            if (slot) {
+                slot->value.i = job->values[pos];
+            } else {
+                job->order[kept++] = pos;
+            }
+        }
+        job->claimed[s] = claimed;
+        job->set_aside[s] = kept - job->starts[s];
+    }
+}
+
+omni_map_t* omni_parallel_build_map_int(const int32_t* keys, const int32_t* values, int64_t n) {
+    if (n < 0 || (n > 0 && (!keys || !values)) || n > (1 << 29)) return NULL;
+    omni_map_t* map = (omni_map_t*)calloc(1, sizeof(omni_map_t));
+    if (!map) return NULL;
+    if (!omni_map_table_init(&map->table, omni_map_capacity_for((uint32_t)n))) {
+        free(map);
+        return NULL;
+    }
+    int32_t workers = omni_scheduler_workers();
+    uint32_t groups = map->table.capacity / OMNI_MAP_GROUP_WIDTH;
+    if (n < OMNI_PARALLEL_MIN || workers == 0 || groups < 64) {
+        for (int64_t i = 0; i < n; i++) omni_map_put_int_int(map, keys[i], values[i]);
+        return map;
+    }
+
+    omni_map_build_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.keys = keys;
+    job.values = values;
+    job.n = n;
+    job.table = &map->table;
+    // Eight slices per thread, each at least 64 groups wide so few probe
+    // sequences cross a slice edge
+    job.slices = 1;
+    while (job.slices < (int64_t)(workers + 1) * 8 && (int64_t)groups / (job.slices * 2) >= 64) {
+        job.slices *= 2;
+    }
+    job.slice_shift = 0;
+    while (((int64_t)groups >> job.slice_shift) > job.slices) job.slice_shift++;
+    int64_t blocks = omni_parallel_blocks(n, sizeof(int32_t), &job.block_len);
+    job.counts = (int64_t*)malloc((size_t)(blocks * job.slices) * sizeof(int64_t));
+    job.starts = (int64_t*)malloc((size_t)(job.slices + 1) * sizeof(int64_t));
+    job.claimed = (int64_t*)calloc((size_t)job.slices, sizeof(int64_t));
+    job.set_aside = (int64_t*)calloc((size_t)job.slices, sizeof(int64_t));
+    job.order = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    if (!job.counts || !job.starts || !job.claimed || !job.set_aside || !job.order) {
+        free(job.counts);
+        free(job.starts);
+        free(job.claimed);
+        free(job.set_aside);
+        free(job.order);
+        omni_map_destroy(map);
+        return NULL;
+    }
+
+    omni_parallel_for(0, blocks, 1, omni_map_build_count, &job);
+    int64_t offset = 0;
+    for (int64_t s = 0; s < job.slices; s++) {
+        job.starts[s] = offset;
+        for (int64_t b = 0; b < blocks; b++) {
+            int64_t c = job.counts[b * job.slices + s];
+            job.counts[b * job.slices + s] = offset;
+            offset += c;
+        }
+    }
+    job.starts[job.slices] = offset;
+    omni_parallel_for(0, blocks, 1, omni_map_build_scatter, &job);
+    omni_parallel_for(0, job.slices, 1, omni_map_build_fill, &job);
+
+    map->key_kind = OMNI_MAP_KEY_INT;
+    map->value_kind = OMNI_MAP_VALUE_SCALAR;
+    for (int64_t s = 0; s < job.slices; s++) {
+        map->table.size += (uint32_t)job.claimed[s];
+        map->table.growth_left -= (uint32_t)job.claimed[s];
+        map->size += (int32_t)job.claimed[s];
+    }
+    for (int64_t s = 0; s < job.slices; s++) {
+        for (int64_t at = job.starts[s]; at < job.starts[s] + job.set_aside[s]; at++) {
+            omni_map_put_int_int(map, keys[job.order[at]], values[job.order[at]]);
+        }
+    }
+    free(job.counts);
+    free(job.starts);
+    free(job.claimed);
+    free(job.set_aside);
+    free(job.order);
+    return map;
+}
+
+// ============================================================================
+// Logging
+// ============================================================================
+
+// Lines read "YYYY-MM-DD HH:MM:SS - [LEVEL] message"; each thread formats
+// the timestamp at most once a second. In sync mode (the default) the line
+// is on stderr before the call returns. In async mode every thread appends
+// to a ring buffer of its own, which only it writes and only the drainer
+// reads, and a flusher thread empties all rings into stderr with a few
+// writev calls per pass. A full ring either drops the line (counted, and
+// reported by the flusher) or, by default, makes the logging thread drain
+// the rings itself, which blocks it on the write as sync mode would.
+
+#define OMNI_LOG_RING_SIZE (64 * 1024)
+#define OMNI_LOG_BATCH 64
+
+enum {
+    OMNI_LOG_MODE_SYNC = 0,
+    OMNI_LOG_MODE_ASYNC = 1,      // Block when the ring is full
+    OMNI_LOG_MODE_ASYNC_DROP = 2, // Drop when the ring is full
+};
+
+typedef struct omni_log_ring {
+    struct omni_log_ring* next; // Registry link; rings are never unlinked
+    int32_t owned;              // Claimed by a live thread
+    size_t head;                // Advanced by the owning thread
+    size_t tail;                // Advanced by the drainer
+    char data[OMNI_LOG_RING_SIZE];
+} omni_log_ring_t;
+
+static int32_t omni_log_mode = OMNI_LOG_MODE_SYNC;
+static omni_mutex_t omni_log_mutex = OMNI_MUTEX_INIT;       // Sync writes
+static omni_mutex_t omni_log_drain_mutex = OMNI_MUTEX_INIT; // One drainer at a time
+static omni_mutex_t omni_log_wake_mutex = OMNI_MUTEX_INIT;
+static omni_cond_t omni_log_wake = OMNI_COND_INIT;
+static int32_t omni_log_flusher_idle = 0;
+static int32_t omni_log_flusher_started = 0;
+static omni_log_ring_t* omni_log_rings = NULL;
+static int64_t omni_log_dropped = 0;
+
+static OMNI_THREAD_LOCAL omni_log_ring_t* omni_log_thread_ring = NULL;
+static OMNI_THREAD_LOCAL time_t omni_log_stamp_second = (time_t)-1;
+static OMNI_THREAD_LOCAL char omni_log_stamp[32];
+
+static const char* omni_log_timestamp(void) {
+    time_t now = time(NULL);
+    if (now != omni_log_stamp_second) {
+        struct tm tm_info;
+#ifdef _WIN32
+        int ok = localtime_s(&tm_info, &now) == 0;
+#else
+        int ok = localtime_r(&now, &tm_info) != NULL;
+#endif
+        if (!ok || strftime(omni_log_stamp, sizeof(omni_log_stamp), "%Y-%m-%d %H:%M:%S", &tm_info) == 0) {
+            strcpy(omni_log_stamp, "0000-00-00 00:00:00");
+        }
+        omni_log_stamp_second = now;
+    }
+    return omni_log_stamp;
+}
+
+// A thread's ring goes back to the pool when the thread exits. Windows has
+// no destructor hook here, so a ring stays with its thread for good.
+#ifndef _WIN32
+static pthread_key_t omni_log_ring_key;
+static pthread_once_t omni_log_ring_key_once = PTHREAD_ONCE_INIT;
+
+static void omni_log_ring_release(void* ring) {
+    __atomic_store_n(&((omni_log_ring_t*)ring)->owned, 0, __ATOMIC_RELEASE);
+}
+
+static void omni_log_ring_key_init(void) {
+    pthread_key_create(&omni_log_ring_key, omni_log_ring_release);
+}
+#endif
+
+static omni_log_ring_t* omni_log_ring(void) {
+    omni_log_ring_t* ring = omni_log_thread_ring;
+    if (ring) {
+        return ring;
+    }
+    for (ring = OMNI_LOAD_ACQUIRE(&omni_log_rings); ring; ring = ring->next) {
+        int32_t expected = 0;
+        if (__atomic_compare_exchange_n(&ring->owned, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    if (!ring) {
+        ring = (omni_log_ring_t*)calloc(1, sizeof(omni_log_ring_t));
+        if (!ring) return NULL;
+        ring->owned = 1;
+        omni_log_ring_t* first = OMNI_LOAD_ACQUIRE(&omni_log_rings);
+        do {
+            ring->next = first;
+        } while (!__atomic_compare_exchange_n(&omni_log_rings, &first, ring, 1, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+    }
+#ifndef _WIN32
+    pthread_once(&omni_log_ring_key_once, omni_log_ring_key_init);
+    pthread_setspecific(omni_log_ring_key, ring);
+#endif
+    omni_log_thread_ring = ring;
+    return ring;
+}
+
+// Writes out everything the rings hold; the caller holds omni_log_drain_mutex
+static void omni_log_drain_locked(void) {
+    omni_iovec_t pieces[OMNI_LOG_BATCH];
+    omni_log_ring_t* done[OMNI_LOG_BATCH];
+    size_t done_head[OMNI_LOG_BATCH];
+    int32_t count = 0, rings = 0;
+    for (omni_log_ring_t* ring = OMNI_LOAD_ACQUIRE(&omni_log_rings); ring; ring = ring->next) {
+        size_t head = OMNI_LOAD_ACQUIRE(&ring->head);
+        size_t tail = ring->tail;
+        if (head == tail) continue;
+        if (count + 2 > OMNI_LOG_BATCH) {
+            omni_file_writev((intptr_t)stderr, pieces, count);
+            for (int32_t i = 0; i < rings; i++) OMNI_STORE_RELEASE(&done[i]->tail, done_head[i]);
+            count = rings = 0;
+        }
+        size_t start = tail % OMNI_LOG_RING_SIZE;
+        size_t len = head - tail;
+        size_t first = len < OMNI_LOG_RING_SIZE - start ? len : OMNI_LOG_RING_SIZE - start;
+        pieces[count].data = ring->data + start;
+        pieces[count++].len = first;
+        if (first < len) {
+            pieces[count].data = ring->data;
+            pieces[count++].len = len - first;
+        }
+        done[rings] = ring;
+        done_head[rings++] = head;
+    }
+    if (count > 0) {
+        omni_file_writev((intptr_t)stderr, pieces, count);
+        for (int32_t i = 0; i < rings; i++) OMNI_STORE_RELEASE(&done[i]->tail, done_head[i]);
+    }
+    int64_t dropped = __atomic_exchange_n(&omni_log_dropped, 0, __ATOMIC_ACQ_REL);
+    if (dropped > 0) {
+        fprintf(stderr, "%s - [WARN] %lld log messages dropped\n", omni_log_timestamp(), (long long)dropped);
+        fflush(stderr);
+    }
+}
+
+static int omni_log_pending(void) {
+    for (omni_log_ring_t* ring = OMNI_LOAD_ACQUIRE(&omni_log_rings); ring; ring = ring->next) {
+        if (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) != __atomic_load_n(&ring->tail, __ATOMIC_RELAXED)) {
+            return 1;
+        }
+    }
+    return __atomic_load_n(&omni_log_dropped, __ATOMIC_RELAXED) != 0;
+}
+
+static void omni_log_flusher(void* arg) {
+    (void)arg;
+    for (;;) {
+        omni_mutex_lock(&omni_log_drain_mutex);
+        omni_log_drain_locked();
+        omni_mutex_unlock(&omni_log_drain_mutex);
+        // Writers only take the wake lock once they see the flag, so a
+        // busy flusher costs them nothing
+        omni_mutex_lock(&omni_log_wake_mutex);
+        __atomic_store_n(&omni_log_flusher_idle, 1, __ATOMIC_SEQ_CST);
+        if (!omni_log_pending()) {
+            omni_cond_wait(&omni_log_wake, &omni_log_wake_mutex);
+        }
+        __atomic_store_n(&omni_log_flusher_idle, 0, __ATOMIC_SEQ_CST);
+        omni_mutex_unlock(&omni_log_wake_mutex);
+    }
+}
+
+static void omni_log_ring_put(omni_log_ring_t* ring, size_t at, const char* text, size_t len) {
+    size_t start = at % OMNI_LOG_RING_SIZE;
+    size_t first = len < OMNI_LOG_RING_SIZE - start ? len : OMNI_LOG_RING_SIZE - start;
+    memcpy(ring->data + start, text, first);
+    memcpy(ring->data, text + first, len - first);
+}
+
+static void omni_log_write_sync(const char* level_name, const char* message) {
+    const char* stamp = omni_log_timestamp();
+    omni_mutex_lock(&omni_log_mutex);
+    fprintf(stderr, "%s - [%s] %s\n", stamp, level_name, message);
+    fflush(stderr);
+    omni_mutex_unlock(&omni_log_mutex);
+}
+
+static void omni_log_write_async(int32_t mode, const char* level_name, const char* message) {
+    omni_log_ring_t* ring = omni_log_ring();
+    if (!ring) {
+        omni_log_write_sync(level_name, message);
+        return;
+    }
+    const char* stamp = omni_log_timestamp();
+    size_t stamp_len = strlen(stamp);
+    size_t level_len = strlen(level_name);
+    size_t message_len = strlen(message);
+    size_t overhead = stamp_len + level_len + 7; // " - [" "] " "\n"
+    if (message_len > OMNI_LOG_RING_SIZE - overhead) {
+        message_len = OMNI_LOG_RING_SIZE - overhead; // Cut to what a ring holds
+    }
+    size_t need = overhead + message_len;
+    size_t head = ring->head;
+    while (OMNI_LOG_RING_SIZE - (head - OMNI_LOAD_ACQUIRE(&ring->tail)) < need) {
+        if (mode == OMNI_LOG_MODE_ASYNC_DROP) {
+            __atomic_add_fetch(&omni_log_dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        omni_mutex_lock(&omni_log_drain_mutex);
+        omni_log_drain_locked();
+        omni_mutex_unlock(&omni_log_drain_mutex);
+    }
+    size_t at = head;
+    omni_log_ring_put(ring, at, stamp, stamp_len); at += stamp_len;
+    omni_log_ring_put(ring, at, " - [", 4); at += 4;
+    omni_log_ring_put(ring, at, level_name, level_len); at += level_len;
+    omni_log_ring_put(ring, at, "] ", 2); at += 2;
+    omni_log_ring_put(ring, at, message, message_len); at += message_len;
+    omni_log_ring_put(ring, at, "\n", 1);
+    __atomic_store_n(&ring->head, head + need, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&omni_log_flusher_idle, __ATOMIC_SEQ_CST)) {
+        omni_mutex_lock(&omni_log_wake_mutex);
+        omni_cond_signal(&omni_log_wake);
+        omni_mutex_unlock(&omni_log_wake_mutex);
+    }
+}
+
+static void omni_log_write(int32_t level, const char* level_name, const char* message) {
+    if (level < omni_current_log_level) {
+        return;
+    }
+    if (!message) {
+        message = "";
+    }
+    int32_t mode = OMNI_LOAD_ACQUIRE(&omni_log_mode);
+    if (mode == OMNI_LOG_MODE_SYNC) {
+        omni_log_write_sync(level_name, message);
+    } else {
+        omni_log_write_async(mode, level_name, message);
+    }
+}
+
+void omni_log_flush(void) {
+    if (!OMNI_LOAD_ACQUIRE(&omni_log_rings)) {
+        return;
+    }
+    omni_mutex_lock(&omni_log_drain_mutex);
+    omni_log_drain_locked();
+    omni_mutex_unlock(&omni_log_drain_mutex);
+}
+
+int32_t omni_log_set_mode(const char* mode) {
+    int32_t next;
+    if (omni_equals_ignore_case(mode, "sync")) {
+        next = OMNI_LOG_MODE_SYNC;
+    } else if (omni_equals_ignore_case(mode, "async")) {
+        next = OMNI_LOG_MODE_ASYNC;
+    } else if (omni_equals_ignore_case(mode, "async_drop")) {
+        next = OMNI_LOG_MODE_ASYNC_DROP;
+    } else {
+        return 0;
+    }
+    if (next != OMNI_LOG_MODE_SYNC) {
+        int32_t expected = 0;
+        if (__atomic_compare_exchange_n(&omni_log_flusher_started, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            if (omni_thread_spawn(omni_log_flusher, NULL) != 0) {
+                __atomic_store_n(&omni_log_flusher_started, 0, __ATOMIC_RELEASE);
+                return 0;
+            }
+            atexit(omni_log_flush);
+        }
+    }
+    OMNI_STORE_RELEASE(&omni_log_mode, next);
+    if (next == OMNI_LOG_MODE_SYNC) {
+        // Lines queued before the switch come out before later sync lines
+        omni_log_flush();
+    }
+    return 1;
+}
+
+// ============================================================================
+// Collection Data Structures Implementation
+// ============================================================================
+
+// Set implementation (roaring bitmap)
+// Elements are split into a 16-bit chunk key (the high half) and a 16-bit
+// value. The set keeps one container per non-empty chunk, sorted by key,
+// and each container picks its own layout: a sorted uint16_t array while it
+// holds at most OMNI_SET_ARRAY_MAX values, an 8 KiB bitmap beyond that. A
+// sparse set is therefore a few small sorted arrays, and a dense range of
+// IDs costs about one bit per element. Keys are biased by 2^31 so chunks
+// sort in signed order.
+//
+// Set operations walk the two container lists together. Bitmap pairs are
+// combined a word at a time with the cardinality kept by popcount (AVX2 when
+// the CPU has it), array pairs by merging, and mixed pairs by probing the
+// bitmap. The *_with variants update the left set in place and only allocate
+// when a container changes layout or the right set has chunks the left one
+// lacks; union, intersection and difference clone one side and apply the
+// in-place operation to the copy.
+#define OMNI_SET_ARRAY_MAX 4096
+// Removals only turn a bitmap back into an array below this, so adding and
+// removing around the threshold does not convert back and forth
+#define OMNI_SET_ARRAY_MIN 2048
+#define OMNI_SET_BITMAP_WORDS 1024
+
+enum { OMNI_SET_ARRAY = 0, OMNI_SET_BITMAP = 1 };
+enum { OMNI_SET_OR = 0, OMNI_SET_AND = 1, OMNI_SET_ANDNOT = 2 };
+
+typedef struct {
+    uint16_t key;
+    uint16_t kind;
+    int32_t card;
+    int32_t capacity;  // Array slots allocated
+    uint16_t* values;  // OMNI_SET_ARRAY
+    uint64_t* words;   // OMNI_SET_BITMAP
+} omni_set_chunk_t;
+
+struct omni_set {
+    omni_set_chunk_t* chunks;
+    int32_t count;
+    int32_t capacity;
+    int32_t size;
+};
+
+static inline uint32_t omni_set_biased(int32_t element) {
+    return (uint32_t)element ^ 0x80000000u;
+}
+
+static inline int omni_set_bit(const uint64_t* words, uint16_t v) {
+    return (int)((words[v >> 6] >> (v & 63)) & 1);
+}
+
+static void omni_set_chunk_free(omni_set_chunk_t* chunk) {
+    free(chunk->values);
+    free(chunk->words);
+    chunk->values = NULL;
+    chunk->words = NULL;
+}
+
+// Index of the first chunk whose key is >= key
+static int32_t omni_set_find_chunk(const omni_set_t* set, uint16_t key) {
+    int32_t lo = 0, hi = set->count;
+    while (lo < hi) {
+        int32_t mid = (lo + hi) >> 1;
+        if (set->chunks[mid].key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Index of the first value >= v in values[from, n)
+static int32_t omni_set_u16_lower_bound(const uint16_t* values, int32_t from, int32_t n, uint16_t v) {
+    int32_t lo = from, hi = n;
+    while (lo < hi) {
+        int32_t mid = (lo + hi) >> 1;
+        if (values[mid] < v) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static int omni_set_reserve_chunks(omni_set_t* set, int32_t need) {
+    if (need <= set->capacity) return 1;
+    int32_t capacity = set->capacity ? set->capacity * 2 : 4;
+    while (capacity < need) capacity *= 2;
+    omni_set_chunk_t* chunks = (omni_set_chunk_t*)realloc(set->chunks, (size_t)capacity * sizeof(omni_set_chunk_t));
+    if (!chunks) return 0;
+    set->chunks = chunks;
+    set->capacity = capacity;
+    return 1;
+}
+
+static int omni_set_array_reserve(omni_set_chunk_t* chunk, int32_t need) {
+    if (need <= chunk->capacity) return 1;
+    int32_t capacity = chunk->capacity ? chunk->capacity * 2 : 4;
+    while (capacity < need) capacity *= 2;
+    if (capacity > OMNI_SET_ARRAY_MAX) capacity = need > OMNI_SET_ARRAY_MAX ? need : OMNI_SET_ARRAY_MAX;
+    uint16_t* values = (uint16_t*)realloc(chunk->values, (size_t)capacity * sizeof(uint16_t));
+    if (!values) return 0;
+    chunk->values = values;
+    chunk->capacity = capacity;
+    return 1;
+}
+
+static int omni_set_to_bitmap(omni_set_chunk_t* chunk) {
+    uint64_t* words = (uint64_t*)calloc(OMNI_SET_BITMAP_WORDS, sizeof(uint64_t));
+    if (!words) return 0;
+    for (int32_t i = 0; i < chunk->card; i++) {
+        uint16_t v = chunk->values[i];
+        words[v >> 6] |= (uint64_t)1 << (v & 63);
+    }
+    free(chunk->values);
+    chunk->values = NULL;
+    chunk->capacity = 0;
+    chunk->words = words;
+    chunk->kind = OMNI_SET_BITMAP;
+    return 1;
+}
+
+static int omni_set_to_array(omni_set_chunk_t* chunk) {
+    int32_t capacity = chunk->card > 0 ? chunk->card : 1;
+    uint16_t* values = (uint16_t*)malloc((size_t)capacity * sizeof(uint16_t));
+    if (!values) return 0;
+    int32_t n = 0;
+    for (int32_t w = 0; w < OMNI_SET_BITMAP_WORDS; w++) {
+        uint64_t bits = chunk->words[w];
+        while (bits) {
+            values[n++] = (uint16_t)((w << 6) + __builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+    free(chunk->words);
+    chunk->words = NULL;
+    chunk->values = values;
+    chunk->capacity = capacity;
+    chunk->kind = OMNI_SET_ARRAY;
+    return 1;
+}
+
+static int omni_set_chunk_clone(omni_set_chunk_t* dst, const omni_set_chunk_t* src) {
+    *dst = *src;
+    dst->values = NULL;
+    dst->words = NULL;
+    if (src->kind == OMNI_SET_BITMAP) {
+        dst->words = (uint64_t*)malloc(OMNI_SET_BITMAP_WORDS * sizeof(uint64_t));
+        if (!dst->words) return 0;
+        memcpy(dst->words, src->words, OMNI_SET_BITMAP_WORDS * sizeof(uint64_t));
+    } else {
+        dst->capacity = src->card > 0 ? src->card : 1;
+        dst->values = (uint16_t*)malloc((size_t)dst->capacity * sizeof(uint16_t));
+        if (!dst->values) return 0;
+        memcpy(dst->values, src->values, (size_t)src->card * sizeof(uint16_t));
+    }
+    return 1;
+}
+
+// a = a op b over whole bitmaps, returning the new cardinality
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+// Every AVX2 CPU also has POPCNT
+static __attribute__((target("avx2,popcnt"))) int32_t omni_set_words_avx2(uint64_t* a, const uint64_t* b, int op) {
+    int64_t card = 0;
+    for (int32_t i = 0; i < OMNI_SET_BITMAP_WORDS; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i r = op == OMNI_SET_OR ? _mm256_or_si256(x, y)
+                  : op == OMNI_SET_AND ? _mm256_and_si256(x, y)
+                  : _mm256_andnot_si256(y, x);
+        _mm256_storeu_si256((__m256i*)(a + i), r);
+        card += _mm_popcnt_u64(a[i]) + _mm_popcnt_u64(a[i + 1]) + _mm_popcnt_u64(a[i + 2]) + _mm_popcnt_u64(a[i + 3]);
+    }
+    return (int32_t)card;
+}
+#endif
+
+static int32_t omni_set_words(uint64_t* a, const uint64_t* b, int op) {
+#if defined(OMNI_HAVE_AVX2_DISPATCH)
+    if (omni_has_avx2()) return omni_set_words_avx2(a, b, op);
+#endif
+    int32_t card = 0;
+    for (int32_t i = 0; i < OMNI_SET_BITMAP_WORDS; i++) {
+        uint64_t r = op == OMNI_SET_OR ? a[i] | b[i] : op == OMNI_SET_AND ? a[i] & b[i] : a[i] & ~b[i];
+        a[i] = r;
+        card += __builtin_popcountll(r);
+    }
+    return card;
+}
+
+// Union of two arrays into a; falls back to a bitmap when it may not fit
+static int omni_set_array_union(omni_set_chunk_t* a, const omni_set_chunk_t* b) {
+    int32_t total = a->card + b->card;
+    if (total > OMNI_SET_ARRAY_MAX) {
+        if (!omni_set_to_bitmap(a)) return 0;
+        for (int32_t j = 0; j < b->card; j++) {
+            uint16_t v = b->values[j];
+            a->card += !omni_set_bit(a->words, v);
+            a->words[v >> 6] |= (uint64_t)1 << (v & 63);
+        }
+        return 1;
+    }
+    if (!omni_set_array_reserve(a, total)) return 0;
+    // Merge from the back so a's values are read before being overwritten
+    uint16_t* values = a->values;
+    int32_t i = a->card - 1, j = b->card - 1, k = total - 1;
+    while (i >= 0 && j >= 0) {
+        if (values[i] > b->values[j]) {
+            values[k--] = values[i--];
+        } else if (values[i] < b->values[j]) {
+            values[k--] = b->values[j--];
+        } else {
+            values[k--] = values[i--];
+            j--;
+        }
+    }
+    while (j >= 0) values[k--] = b->values[j--];
+    while (i >= 0) values[k--] = values[i--];
+    a->card = total - 1 - k;
+    memmove(values, values + k + 1, (size_t)a->card * sizeof(uint16_t));
+    return 1;
+}
+
+// Keeps the values of array a that are (AND) or are not (ANDNOT) in array b
+static void omni_set_array_filter(omni_set_chunk_t* a, const omni_set_chunk_t* b, int op) {
+    int32_t keep_found = op == OMNI_SET_AND;
+    int32_t n = 0, j = 0;
+    if (b->card > 32 * a->card) {
+        // Much larger b: binary search it instead of walking all of it
+        for (int32_t i = 0; i < a->card; i++) {
+            uint16_t v = a->values[i];
+            j = omni_set_u16_lower_bound(b->values, j, b->card, v);
+            int found = j < b->card && b->values[j] == v;
+            if (found == keep_found) a->values[n++] = v;
+        }
+    } else {
+        for (int32_t i = 0; i < a->card; i++) {
+            uint16_t v = a->values[i];
+            while (j < b->card && b->values[j] < v) j++;
+            int found = j < b->card && b->values[j] == v;
+            if (found == keep_found) a->values[n++] = v;
+        }
+    }
+    a->card = n;
+}
+
+// a = a op b for two containers with the same key. Returns 0 if an
+// allocation failed, leaving a valid but possibly only partly updated.
+static int omni_set_chunk_apply(omni_set_chunk_t* a, const omni_set_chunk_t* b, int op) {
+    if (a->kind == OMNI_SET_BITMAP && b->kind == OMNI_SET_BITMAP) {
+        a->card = omni_set_words(a->words, b->words, op);
+    } else if (a->kind == OMNI_SET_BITMAP) {
+        if (op == OMNI_SET_AND) {
+            // The result is a subset of b's array
+            int32_t capacity = b->card > 0 ? b->card : 1;
+            uint16_t* values = (uint16_t*)malloc((size_t)capacity * sizeof(uint16_t));
+            if (!values) return 0;
+            int32_t n = 0;
+            for (int32_t j = 0; j < b->card; j++) {
+                if (omni_set_bit(a->words, b->values[j])) values[n++] = b->values[j];
+            }
+            free(a->words);
+            a->words = NULL;
+            a->values = values;
+            a->capacity = capacity;
+            a->card = n;
+            a->kind = OMNI_SET_ARRAY;
+            return 1;
+        }
+        for (int32_t j = 0; j < b->card; j++) {
+            uint16_t v = b->values[j];
+            uint64_t bit = (uint64_t)1 << (v & 63);
+            int present = (a->words[v >> 6] & bit) != 0;
+            if (op == OMNI_SET_OR) {
+                a->words[v >> 6] |= bit;
+                a->card += !present;
+            } else {
+                a->words[v >> 6] &= ~bit;
+                a->card -= present;
+            }
+        }
+    } else if (b->kind == OMNI_SET_BITMAP) {
+        if (op == OMNI_SET_OR) {
+            uint64_t* words = (uint64_t*)malloc(OMNI_SET_BITMAP_WORDS * sizeof(uint64_t));
+            if (!words) return 0;
+            memcpy(words, b->words, OMNI_SET_BITMAP_WORDS * sizeof(uint64_t));
+            int32_t card = b->card;
+            for (int32_t i = 0; i < a->card; i++) {
+                uint16_t v = a->values[i];
+                card += !omni_set_bit(words, v);
+                words[v >> 6] |= (uint64_t)1 << (v & 63);
+            }
+            free(a->values);
+            a->values = NULL;
+            a->capacity = 0;
+            a->words = words;
+            a->card = card;
+            a->kind = OMNI_SET_BITMAP;
+        } else {
+            int keep_found = op == OMNI_SET_AND;
+            int32_t n = 0;
+            for (int32_t i = 0; i < a->card; i++) {
+                if (omni_set_bit(b->words, a->values[i]) == keep_found) a->values[n++] = a->values[i];
+            }
+            a->card = n;
+        }
+    } else if (op == OMNI_SET_OR) {
+        if (!omni_set_array_union(a, b)) return 0;
+    } else {
+        omni_set_array_filter(a, b, op);
+    }
+    // Bulk results go back to the array layout whenever they fit
+    if (a->kind == OMNI_SET_BITMAP && a->card <= OMNI_SET_ARRAY_MAX) omni_set_to_array(a);
+    return 1;
+}
+
+static void omni_set_recount(omni_set_t* set) {
+    int32_t size = 0;
+    for (int32_t i = 0; i < set->count; i++) size += set->chunks[i].card;
+    set->size = size;
+}
+
+// a = a op b chunk by chunk
+static int32_t omni_set_apply(omni_set_t* a, const omni_set_t* b, int op) {
+    int ok = 1;
+    if (op != OMNI_SET_OR) {
+        // Matching chunks are updated, unmatched ones kept (ANDNOT) or
+        // dropped (AND), and empty ones compacted away
+        int32_t n = 0, j = 0;
+        for (int32_t i = 0; i < a->count; i++) {
+            omni_set_chunk_t* chunk = &a->chunks[i];
+            while (j < b->count && b->chunks[j].key < chunk->key) j++;
+            if (j < b->count && b->chunks[j].key == chunk->key) {
+                if (!omni_set_chunk_apply(chunk, &b->chunks[j], op)) ok = 0;
+            } else if (op == OMNI_SET_AND) {
+                chunk->card = 0;
+            }
+            if (chunk->card == 0) {
+                omni_set_chunk_free(chunk);
+            } else {
+                a->chunks[n++] = *chunk;
+            }
+        }
+        a->count = n;
+        omni_set_recount(a);
+        return ok;
+    }
+
+    int32_t missing = 0;
+    for (int32_t i = 0, j = 0; j < b->count; j++) {
+        while (i < a->count && a->chunks[i].key < b->chunks[j].key) i++;
+        if (i == a->count || a->chunks[i].key != b->chunks[j].key) missing++;
+    }
+    if (missing > 0 && !omni_set_reserve_chunks(a, a->count + missing)) return 0;
+    // Merge the chunk lists from the back so a's chunks move at most once
+    int32_t i = a->count - 1, j = b->count - 1, k = a->count + missing - 1;
+    while (j >= 0) {
+        if (i >= 0 && a->chunks[i].key > b->chunks[j].key) {
+            a->chunks[k--] = a->chunks[i--];
+        } else if (i >= 0 && a->chunks[i].key == b->chunks[j].key) {
+            if (!omni_set_chunk_apply(&a->chunks[i], &b->chunks[j], op)) ok = 0;
+            a->chunks[k--] = a->chunks[i--];
+            j--;
+        } else {
+            if (!omni_set_chunk_clone(&a->chunks[k], &b->chunks[j])) {
+                omni_set_chunk_free(&a->chunks[k]);
+                a->chunks[k].card = 0;
+                ok = 0;
+            }
+            k--;
+            j--;
+        }
+    }
+    a->count += missing;
+    if (!ok) {
+        // Drop the chunks whose clone failed
+        int32_t n = 0;
+        for (int32_t c = 0; c < a->count; c++) {
+            if (a->chunks[c].card > 0) a->chunks[n++] = a->chunks[c];
+        }
+        a->count = n;
+    }
+    omni_set_recount(a);
+    return ok;
+}
+
+omni_set_t* omni_set_create() {
+    return (omni_set_t*)calloc(1, sizeof(omni_set_t));
+}
+
+void omni_set_destroy(omni_set_t* set) {
+    if (!set) return;
+    omni_set_clear(set);
+    free(set->chunks);
+    free(set);
+}
+
+int32_t omni_set_add(omni_set_t* set, int32_t element) {
+    if (!set) return 0;
+    uint32_t biased = omni_set_biased(element);
+    uint16_t key = (uint16_t)(biased >> 16);
+    uint16_t v = (uint16_t)biased;
+    int32_t pos = omni_set_find_chunk(set, key);
+    if (pos == set->count || set->chunks[pos].key != key) {
+        if (!omni_set_reserve_chunks(set, set->count + 1)) return 0;
+        memmove(set->chunks + pos + 1, set->chunks + pos, (size_t)(set->count - pos) * sizeof(omni_set_chunk_t));
+        memset(&set->chunks[pos], 0, sizeof(omni_set_chunk_t));
+        set->chunks[pos].key = key;
+        set->count++;
+    }
+    omni_set_chunk_t* chunk = &set->chunks[pos];
+    if (chunk->kind == OMNI_SET_ARRAY) {
+        int32_t at = omni_set_u16_lower_bound(chunk->values, 0, chunk->card, v);
+        if (at < chunk->card && chunk->values[at] == v) return 0;
+        if (chunk->card == OMNI_SET_ARRAY_MAX) {
+            if (!omni_set_to_bitmap(chunk)) return 0;
+        } else {
+            if (!omni_set_array_reserve(chunk, chunk->card + 1)) {
+                if (chunk->card == 0) {
+                    memmove(set->chunks + pos, set->chunks + pos + 1, (size_t)(set->count - pos - 1) * sizeof(omni_set_chunk_t));
+                    set->count--;
+                }
+                return 0;
+            }
+            memmove(chunk->values + at + 1, chunk->values + at, (size_t)(chunk->card - at) * sizeof(uint16_t));
+            chunk->values[at] = v;
+            chunk->card++;
+            set->size++;
+            return 1;
+        }
+    }
+    uint64_t bit = (uint64_t)1 << (v & 63);
+    if (chunk->words[v >> 6] & bit) return 0;
+    chunk->words[v >> 6] |= bit;
+    chunk->card++;
+    set->size++;
+    return 1;
+}
+
+int32_t omni_set_remove(omni_set_t* set, int32_t element) {
+    if (!set) return 0;
+    uint32_t biased = omni_set_biased(element);
+    uint16_t key = (uint16_t)(biased >> 16);
+    uint16_t v = (uint16_t)biased;
+    int32_t pos = omni_set_find_chunk(set, key);
+    if (pos == set->count || set->chunks[pos].key != key) return 0;
+    omni_set_chunk_t* chunk = &set->chunks[pos];
+    if (chunk->kind == OMNI_SET_ARRAY) {
+        int32_t at = omni_set_u16_lower_bound(chunk->values, 0, chunk->card, v);
+        if (at == chunk->card || chunk->values[at] != v) return 0;
+        memmove(chunk->values + at, chunk->values + at + 1, (size_t)(chunk->card - at - 1) * sizeof(uint16_t));
+    } else {
+        uint64_t bit = (uint64_t)1 << (v & 63);
+        if (!(chunk->words[v >> 6] & bit)) return 0;
+        chunk->words[v >> 6] &= ~bit;
+    }
+    chunk->card--;
+    set->size--;
+    if (chunk->card == 0) {
+        omni_set_chunk_free(chunk);
+        memmove(set->chunks + pos, set->chunks + pos + 1, (size_t)(set->count - pos - 1) * sizeof(omni_set_chunk_t));
+        set->count--;
+    } else if (chunk->kind == OMNI_SET_BITMAP && chunk->card < OMNI_SET_ARRAY_MIN) {
+        omni_set_to_array(chunk); // Staying a bitmap is fine if this fails
+    }
+    return 1;
+}
+
+int32_t omni_set_contains(omni_set_t* set, int32_t element) {
+    if (!set) return 0;
+    uint32_t biased = omni_set_biased(element);
+    uint16_t key = (uint16_t)(biased >> 16);
+    uint16_t v = (uint16_t)biased;
+    int32_t pos = omni_set_find_chunk(set, key);
+    if (pos == set->count || set->chunks[pos].key != key) return 0;
+    const omni_set_chunk_t* chunk = &set->chunks[pos];
+    if (chunk->kind == OMNI_SET_BITMAP) return omni_set_bit(chunk->words, v);
+    int32_t at = omni_set_u16_lower_bound(chunk->values, 0, chunk->card, v);
+    return (at < chunk->card && chunk->values[at] == v) ? 1 : 0;
+}
+
+int32_t omni_set_size(omni_set_t* set) {
+    if (!set) return 0;
+    return set->size;
+}
+
+void omni_set_clear(omni_set_t* set) {
+    if (!set) return;
+    for (int32_t i = 0; i < set->count; i++) omni_set_chunk_free(&set->chunks[i]);
+    set->count = 0;
+    set->size = 0;
+}
+
+static omni_set_t* omni_set_clone(const omni_set_t* src) {
+    omni_set_t* set = omni_set_create();
+    if (!set || !src || src->count == 0) return set;
+    if (!omni_set_reserve_chunks(set, src->count)) {
+        free(set);
+        return NULL;
+    }
+    for (int32_t i = 0; i < src->count; i++) {
+        if (!omni_set_chunk_clone(&set->chunks[i], &src->chunks[i])) {
+            omni_set_chunk_free(&set->chunks[i]);
+            set->count = i;
+            omni_set_destroy(set);
+            return NULL;
+        }
+    }
+    set->count = src->count;
+    set->size = src->size;
+    return set;
+}
+
+// The in-place operations read b while rewriting a's chunks, so a set
+// combined with itself is answered up front
+int32_t omni_set_union_with(omni_set_t* a, omni_set_t* b) {
+    if (!a) return 0;
+    if (!b || b == a || b->count == 0) return 1;
+    return omni_set_apply(a, b, OMNI_SET_OR);
+}
+
+int32_t omni_set_intersect_with(omni_set_t* a, omni_set_t* b) {
+    if (!a) return 0;
+    if (b == a) return 1;
+    if (!b) {
+        omni_set_clear(a);
+        return 1;
+    }
+    return omni_set_apply(a, b, OMNI_SET_AND);
+}
+
+int32_t omni_set_difference_with(omni_set_t* a, omni_set_t* b) {
+    if (!a) return 0;
+    if (b == a) {
+        omni_set_clear(a);
+        return 1;
+    }
+    if (!b || b->count == 0) return 1;
+    return omni_set_apply(a, b, OMNI_SET_ANDNOT);
+}
+
+// Binary operations copy one operand and update the copy in place. Union
+// and intersection are symmetric, so they copy whichever side leaves less
+// work: the larger one for union, the smaller one for intersection.
+static omni_set_t* omni_set_combine(omni_set_t* copy, omni_set_t* other, int op) {
+    omni_set_t* result = omni_set_clone(copy);
+    if (!result) return NULL;
+    if (other && !omni_set_apply(result, other, op)) {
+        omni_set_destroy(result);
+        return NULL;
+    }
+    return result;
+}
+
+omni_set_t* omni_set_union(omni_set_t* a, omni_set_t* b) {
+    if (!a && !b) return NULL;
+    if (!a || (b && b->size > a->size)) return omni_set_combine(b, a, OMNI_SET_OR);
+    return omni_set_combine(a, b, OMNI_SET_OR);
+}
+
+omni_set_t* omni_set_intersection(omni_set_t* a, omni_set_t* b) {
+    if (!a || !b) return omni_set_create();
+    if (b->size < a->size) return omni_set_combine(b, a, OMNI_SET_AND);
+    return omni_set_combine(a, b, OMNI_SET_AND);
+}
+
+omni_set_t* omni_set_difference(omni_set_t* a, omni_set_t* b) {
+    if (!a) return omni_set_create();
+    return omni_set_combine(a, b, OMNI_SET_ANDNOT);
+}
+
+// Queue implementation (FIFO on a growable ring buffer)
+// Elements live in one power-of-two array indexed by head & mask, so
+// enqueue and dequeue are a store and an index bump; the array only grows,
+// doubling when full, with the wrapped part unrolled into the new space.
+#define OMNI_QUEUE_INITIAL_CAPACITY 16
+
+struct omni_queue {
+    int32_t* items;
+    uint32_t head;
+    uint32_t mask; // capacity - 1
+    int32_t size;
+};
+
+static int omni_queue_grow(omni_queue_t* queue, int64_t needed) {
+    int64_t capacity = queue->items ? (int64_t)queue->mask + 1 : 0;
+    if (needed <= capacity) return 1;
+    if (needed > INT32_MAX) return 0;
+    int64_t grown = capacity > 0 ? capacity : OMNI_QUEUE_INITIAL_CAPACITY;
+    while (grown < needed) grown *= 2;
+    int32_t* items = (int32_t*)malloc((size_t)grown * sizeof(int32_t));
+    if (!items) return 0;
+    if (queue->size > 0) {
+        uint32_t first = (uint32_t)capacity - queue->head;
+        if (first > (uint32_t)queue->size) first = (uint32_t)queue->size;
+        memcpy(items, queue->items + queue->head, (size_t)first * sizeof(int32_t));
+        memcpy(items + first, queue->items, (size_t)(queue->size - first) * sizeof(int32_t));
+    }
+    free(queue->items);
+    queue->items = items;
+    queue->head = 0;
+    queue->mask = (uint32_t)grown - 1;
+    return 1;
+}
+
+omni_queue_t* omni_queue_create() {
+    return (omni_queue_t*)calloc(1, sizeof(omni_queue_t));
+}
+
+void omni_queue_destroy(omni_queue_t* queue) {
+    if (!queue) return;
+    free(queue->items);
+    free(queue);
+}
+
+int32_t omni_queue_reserve(omni_queue_t* queue, int32_t capacity) {
+    if (!queue) return 0;
+    return omni_queue_grow(queue, capacity) ? 1 : 0;
+}
+
+void omni_queue_enqueue(omni_queue_t* queue, int32_t element) {
+    if (!queue || !omni_queue_grow(queue, (int64_t)queue->size + 1)) return;
+    queue->items[(queue->head + (uint32_t)queue->size) & queue->mask] = element;
+    queue->size++;
+}
+
+int32_t omni_queue_enqueue_n(omni_queue_t* queue, const int32_t* elements, int32_t count) {
+    if (!queue || !elements || count <= 0) return 0;
+    if (!omni_queue_grow(queue, (int64_t)queue->size + count)) return 0;
+    // At most two contiguous runs: up to the end of the array, then from 0
+    uint32_t tail = (queue->head + (uint32_t)queue->size) & queue->mask;
+    uint32_t first = queue->mask + 1 - tail;
+    if (first > (uint32_t)count) first = (uint32_t)count;
+    memcpy(queue->items + tail, elements, (size_t)first * sizeof(int32_t));
+    memcpy(queue->items, elements + first, (size_t)(count - (int32_t)first) * sizeof(int32_t));
+    queue->size += count;
+    return count;
+}
+
+int32_t omni_queue_dequeue(omni_queue_t* queue) {
+    if (!queue || queue->size == 0) return 0;
+    int32_t value = queue->items[queue->head];
+    queue->head = (queue->head + 1) & queue->mask;
+    queue->size--;
+    return value;
+}
+
+int32_t omni_queue_dequeue_n(omni_queue_t* queue, int32_t* out, int32_t max) {
+    if (!queue || !out || max <= 0) return 0;
+    int32_t count = max < queue->size ? max : queue->size;
+    uint32_t first = queue->mask + 1 - queue->head;
+    if (first > (uint32_t)count) first = (uint32_t)count;
+    memcpy(out, queue->items + queue->head, (size_t)first * sizeof(int32_t));
+    memcpy(out + first, queue->items, (size_t)(count - (int32_t)first) * sizeof(int32_t));
+    queue->head = (queue->head + (uint32_t)count) & queue->mask;
+    queue->size -= count;
+    return count;
+}
+
+int32_t omni_queue_peek(omni_queue_t* queue) {
+    if (!queue || queue->size == 0) return 0;
+    return queue->items[queue->head];
+}
+
+int32_t omni_queue_is_empty(omni_queue_t* queue) {
+    return (!queue || queue->size == 0) ? 1 : 0;
+}
+
+int32_t omni_queue_size(omni_queue_t* queue) {
+    return queue ? queue->size : 0;
+}
+
+void omni_queue_clear(omni_queue_t* queue) {
+    if (!queue) return;
+    queue->head = 0;
+    queue->size = 0;
+}
+
+// Stack implementation (LIFO on a growable array)
+#define OMNI_STACK_INITIAL_CAPACITY 16
+
+struct omni_stack {
+    int32_t* items;
+    int32_t size;
+    int32_t capacity;
+};
+
+static int omni_stack_grow(omni_stack_t* stack, int64_t needed) {
+    if (needed <= stack->capacity) return 1;
+    if (needed > INT32_MAX) return 0;
+    int64_t grown = stack->capacity > 0 ? stack->capacity : OMNI_STACK_INITIAL_CAPACITY;
+    while (grown < needed) grown *= 2;
+    if (grown > INT32_MAX) grown = INT32_MAX;
+    int32_t* items = (int32_t*)realloc(stack->items, (size_t)grown * sizeof(int32_t));
+    if (!items) return 0;
+    stack->items = items;
+    stack->capacity = (int32_t)grown;
+    return 1;
+}
+
+omni_stack_t* omni_stack_create() {
+    return (omni_stack_t*)calloc(1, sizeof(omni_stack_t));
+}
+
+void omni_stack_destroy(omni_stack_t* stack) {
+    if (!stack) return;
+    free(stack->items);
+    free(stack);
+}
+
+int32_t omni_stack_reserve(omni_stack_t* stack, int32_t capacity) {
+    if (!stack) return 0;
+    return omni_stack_grow(stack, capacity) ? 1 : 0;
+}
+
+void omni_stack_push(omni_stack_t* stack, int32_t element) {
+    if (!stack || !omni_stack_grow(stack, (int64_t)stack->size + 1)) return;
+    stack->items[stack->size++] = element;
+}
+
+int32_t omni_stack_push_n(omni_stack_t* stack, const int32_t* elements, int32_t count) {
+    if (!stack || !elements || count <= 0) return 0;
+    if (!omni_stack_grow(stack, (int64_t)stack->size + count)) return 0;
+    memcpy(stack->items + stack->size, elements, (size_t)count * sizeof(int32_t));
+    stack->size += count;
+    return count;
+}
+
+int32_t omni_stack_pop(omni_stack_t* stack) {
+    if (!stack || stack->size == 0) return 0;
+    return stack->items[--stack->size];
+}
+
+int32_t omni_stack_pop_n(omni_stack_t* stack, int32_t* out, int32_t max) {
+    if (!stack || !out || max <= 0) return 0;
+    int32_t count = max < stack->size ? max : stack->size;
+    // Pop order: out[0] is the old top
+    for (int32_t i = 0; i < count; i++) {
+        out[i] = stack->items[stack->size - 1 - i];
+    }
+    stack->size -= count;
+    return count;
+}
+
+int32_t omni_stack_peek(omni_stack_t* stack) {
+    if (!stack || stack->size == 0) return 0;
+    return stack->items[stack->size - 1];
+}
+
+int32_t omni_stack_is_empty(omni_stack_t* stack) {
+    return (!stack || stack->size == 0) ? 1 : 0;
+}
+
+int32_t omni_stack_size(omni_stack_t* stack) {
+    return stack ? stack->size : 0;
+}
+
+void omni_stack_clear(omni_stack_t* stack) {
+    if (!stack) return;
+    stack->size = 0;
+}
+
+// Single-producer/single-consumer queue
+// A bounded ring shared by exactly one pushing and one popping thread.
+// `tail` is written only by the producer and `head` only by the consumer,
+// each published with a release store; both sides keep a private copy of
+// the other's index and reload it only when the ring looks full or empty,
+// so in steady state neither side touches the other's cache line.
+struct omni_spsc_queue {
+    int64_t* items;
+    uint64_t mask;
+    char pad0[64];
+    uint64_t tail;        // Producer
+    uint64_t head_cached; // Producer's view of head
+    char pad1[64];
+    uint64_t head;        // Consumer
+    uint64_t tail_cached; // Consumer's view of tail
+    char pad2[64];
+};
+
+omni_spsc_queue_t* omni_spsc_queue_create(int32_t capacity) {
+    if (capacity <= 0 || capacity > (1 << 30)) return NULL;
+    omni_spsc_queue_t* q = (omni_spsc_queue_t*)calloc(1, sizeof(omni_spsc_queue_t));
+    if (!q) return NULL;
+    uint64_t size = 1;
+    while (size < (uint64_t)capacity) size *= 2;
+    q->items = (int64_t*)malloc((size_t)size * sizeof(int64_t));
+    if (!q->items) {
+        free(q);
+        return NULL;
+    }
+    q->mask = size - 1;
+    return q;
+}
+
+void omni_spsc_queue_destroy(omni_spsc_queue_t* q) {
+    if (!q) return;
+    free(q->items);
+    free(q);
+}
+
+int32_t omni_spsc_queue_push_n(omni_spsc_queue_t* q, const int64_t* values, int32_t count) {
+    if (!q || !values || count <= 0) return 0;
+    uint64_t tail = q->tail;
+    uint64_t free_slots = q->mask + 1 - (tail - q->head_cached);
+    if (free_slots < (uint64_t)count) {
+        q->head_cached = OMNI_LOAD_ACQUIRE(&q->head);
+        free_slots = q->mask + 1 - (tail - q->head_cached);
+    }
+    if ((uint64_t)count > free_slots) count = (int32_t)free_slots;
+    for (int32_t i = 0; i < count; i++) {
+        q->items[(tail + (uint64_t)i) & q->mask] = values[i];
+    }
+    if (count > 0) OMNI_STORE_RELEASE(&q->tail, tail + (uint64_t)count);
+    return count;
+}
+
+int32_t omni_spsc_queue_push(omni_spsc_queue_t* q, int64_t value) {
+    return omni_spsc_queue_push_n(q, &value, 1);
+}
+
+int32_t omni_spsc_queue_pop_n(omni_spsc_queue_t* q, int64_t* out, int32_t max) {
+    if (!q || !out || max <= 0) return 0;
+    uint64_t head = q->head;
+    uint64_t available = q->tail_cached - head;
+    if (available < (uint64_t)max) {
+        q->tail_cached = OMNI_LOAD_ACQUIRE(&q->tail);
+        available = q->tail_cached - head;
+    }
+    int32_t count = (uint64_t)max < available ? max : (int32_t)available;
+    for (int32_t i = 0; i < count; i++) {
+        out[i] = q->items[(head + (uint64_t)i) & q->mask];
+    }
+    if (count > 0) OMNI_STORE_RELEASE(&q->head, head + (uint64_t)count);
+    return count;
+}
+
+int32_t omni_spsc_queue_pop(omni_spsc_queue_t* q, int64_t* out) {
+    return omni_spsc_queue_pop_n(q, out, 1);
+}
+
+int32_t omni_spsc_queue_size(omni_spsc_queue_t* q) {
+    if (!q) return 0;
+    // Head first: it never passes tail, so the difference cannot go negative
+    uint64_t head = OMNI_LOAD_ACQUIRE(&q->head);
+    uint64_t tail = OMNI_LOAD_ACQUIRE(&q->tail);
+    return (int32_t)(tail - head);
+}
+
+int32_t omni_spsc_queue_capacity(omni_spsc_queue_t* q) {
+    return q ? (int32_t)(q->mask + 1) : 0;
+}
+
+// Priority queue implementation (growable 4-ary heap)
+//
+// Nodes live in one array, children of slot i at 4i+1..4i+4. A node is 16
+// bytes, so once the array is shifted by three slots on a 64-byte boundary
+// every group of four siblings shares a single cache line and sift-down
+// touches one line per level, on a tree half the height of a binary heap.
+//
+// Both orders and both priority widths share one engine: priorities are
+// stored as int64 keys XOR-ed with the queue's order mask (0 for a min-heap,
+// all ones for a max-heap), which reverses the order without overflow, so
+// the sift loops always compare keys as a min-heap.
+//
+// insert/push hand out a handle that stays valid until its element leaves
+// the queue; `positions[handle]` tracks the element's slot and is kept up
+// to date by every move, which gives O(log n) decrease_key and remove. Freed
+// handles are chained through `positions` as -2 - next and reused.
+#define OMNI_PQ_INITIAL_CAPACITY 16
+#define OMNI_PQ_ARITY 4
+#define OMNI_PQ_ALIGN_SLOTS 3
+#define OMNI_PQ_NO_HANDLE (-1)
+
+typedef struct omni_priority_queue_node {
+    int64_t key;
+    int32_t element;
+    int32_t handle;
+} omni_priority_queue_node_t;
+
+struct omni_priority_queue {
+    omni_priority_queue_node_t* heap;
+    void* heap_block;
+    int32_t size;
+    int32_t capacity;
+    int64_t order_mask;
+    int32_t* positions;
+    int32_t handle_count;
+    int32_t handle_capacity;
+    int32_t free_handle;
+};
+
+static inline int64_t omni_pq_key(const omni_priority_queue_t* pq, int64_t priority) {
+    return priority ^ pq->order_mask;
+}
+
+static inline void omni_pq_place(omni_priority_queue_t* pq, int32_t index, omni_priority_queue_node_t node) {
+    pq->heap[index] = node;
+    pq->positions[node.handle] = index;
+}
+
+// Moves the node at index toward the root, shifting parents down into the
+// hole instead of swapping. Returns the final slot.
+static int32_t omni_pq_heapify_up(omni_priority_queue_t* pq, int32_t index) {
+    omni_priority_queue_node_t* heap = pq->heap;
+    omni_priority_queue_node_t node = heap[index];
+    while (index > 0) {
+        int32_t parent = (index - 1) / OMNI_PQ_ARITY;
+        if (heap[parent].key <= node.key) break;
+        omni_pq_place(pq, index, heap[parent]);
+        index = parent;
+    }
+    omni_pq_place(pq, index, node);
+    return index;
+}
+
+// Moves the node at index toward the leaves, promoting the smallest of up
+// to four children each level. Returns the final slot.
+static int32_t omni_pq_heapify_down(omni_priority_queue_t* pq, int32_t index) {
+    omni_priority_queue_node_t* heap = pq->heap;
+    int32_t size = pq->size;
+    omni_priority_queue_node_t node = heap[index];
+    while (1) {
+        int32_t first = OMNI_PQ_ARITY * index + 1;
+        if (first >= size) break;
+        int32_t last = first + OMNI_PQ_ARITY < size ? first + OMNI_PQ_ARITY : size;
+        int32_t best = first;
+        for (int32_t child = first + 1; child < last; child++) {
+            if (heap[child].key < heap[best].key) best = child;
+        }
+        if (heap[best].key >= node.key) break;
+        omni_pq_place(pq, index, heap[best]);
+        index = best;
+    }
+    omni_pq_place(pq, index, node);
+    return index;
+}
+
+// Restores the heap property after a node's key changed in either direction
+static void omni_pq_resift(omni_priority_queue_t* pq, int32_t index) {
+    if (omni_pq_heapify_up(pq, index) == index) {
+        omni_pq_heapify_down(pq, index);
+    }
+}
+
+// Grows the node array to hold at least `needed` nodes, keeping the
+// cache-line alignment of sibling groups
+static int omni_pq_reserve_nodes(omni_priority_queue_t* pq, int64_t needed) {
+    if (needed <= pq->capacity) return 1;
+    if (needed > INT32_MAX) return 0;
+    int64_t capacity = pq->capacity > 0 ? pq->capacity : OMNI_PQ_INITIAL_CAPACITY;
+    while (capacity < needed) capacity *= 2;
+    if (capacity > INT32_MAX) capacity = INT32_MAX;
+    size_t bytes = (size_t)(capacity + OMNI_PQ_ALIGN_SLOTS) * sizeof(omni_priority_queue_node_t) + 64;
+    void* block = malloc(bytes);
+    if (!block) return 0;
+    uintptr_t aligned = ((uintptr_t)block + 63) & ~(uintptr_t)63;
+    omni_priority_queue_node_t* heap = (omni_priority_queue_node_t*)aligned + OMNI_PQ_ALIGN_SLOTS;
+    if (pq->size > 0) {
+        memcpy(heap, pq->heap, (size_t)pq->size * sizeof(omni_priority_queue_node_t));
+    }
+    free(pq->heap_block);
+    pq->heap_block = block;
+    pq->heap = heap;
+    pq->capacity = (int32_t)capacity;
+    return 1;
+}
+
+// Returns a free handle, growing the position table when none is left
+static int32_t omni_pq_take_handle(omni_priority_queue_t* pq) {
+    if (pq->free_handle != OMNI_PQ_NO_HANDLE) {
+        int32_t handle = pq->free_handle;
+        pq->free_handle = -2 - pq->positions[handle];
+        return handle;
+    }
+    if (pq->handle_count == pq->handle_capacity) {
+        int64_t capacity = pq->handle_capacity > 0 ? (int64_t)pq->handle_capacity * 2 : OMNI_PQ_INITIAL_CAPACITY;
+        if (capacity > INT32_MAX) capacity = INT32_MAX;
+        if (capacity <= pq->handle_count) return OMNI_PQ_NO_HANDLE;
+        int32_t* positions = (int32_t*)realloc(pq->positions, (size_t)capacity * sizeof(int32_t));
+        if (!positions) return OMNI_PQ_NO_HANDLE;
+        pq->positions = positions;
+        pq->handle_capacity = (int32_t)capacity;
+    }
+    return pq->handle_count++;
+}
+
+static void omni_pq_release_handle(omni_priority_queue_t* pq, int32_t handle) {
+    pq->positions[handle] = -2 - pq->free_handle;
+    pq->free_handle = handle;
+}
+
+static int omni_pq_handle_live(const omni_priority_queue_t* pq, int32_t handle) {
+    return pq && handle >= 0 && handle < pq->handle_count && pq->positions[handle] >= 0;
+}
+
+// Takes the node at index out of the heap, filling the hole with the last
+// node, and returns its element
+static int32_t omni_pq_remove_at(omni_priority_queue_t* pq, int32_t index) {
+    omni_priority_queue_node_t removed = pq->heap[index];
+    omni_pq_release_handle(pq, removed.handle);
+    pq->size--;
+    if (index < pq->size) {
+        pq->heap[index] = pq->heap[pq->size];
+        omni_pq_resift(pq, index);
+    }
+    return removed.element;
+}
+
+static omni_priority_queue_t* omni_pq_create(int64_t order_mask) {
+    omni_priority_queue_t* pq = (omni_priority_queue_t*)calloc(1, sizeof(omni_priority_queue_t));
+    if (!pq) return NULL;
+    pq->order_mask = order_mask;
+    pq->free_handle = OMNI_PQ_NO_HANDLE;
+    return pq;
+}
+
+omni_priority_queue_t* omni_priority_queue_create() {
+    return omni_pq_create(-1);
+}
+
+omni_priority_queue_t* omni_priority_queue_create_min() {
+    return omni_pq_create(0);
+}
+
+void omni_priority_queue_destroy(omni_priority_queue_t* pq) {
+    if (!pq) return;
+    free(pq->heap_block);
+    free(pq->positions);
+    free(pq);
+}
+
+int32_t omni_priority_queue_reserve(omni_priority_queue_t* pq, int32_t capacity) {
+    if (!pq) return 0;
+    return omni_pq_reserve_nodes(pq, capacity) ? 1 : 0;
+}
+
+int32_t omni_priority_queue_push(omni_priority_queue_t* pq, int32_t element, int64_t priority) {
+    if (!pq || !omni_pq_reserve_nodes(pq, (int64_t)pq->size + 1)) return OMNI_PQ_NO_HANDLE;
+    int32_t handle = omni_pq_take_handle(pq);
+    if (handle == OMNI_PQ_NO_HANDLE) return OMNI_PQ_NO_HANDLE;
+    omni_priority_queue_node_t* node = &pq->heap[pq->size];
+    node->key = omni_pq_key(pq, priority);
+    node->element = element;
+    node->handle = handle;
+    omni_pq_heapify_up(pq, pq->size++);
+    return handle;
+}
+
+int32_t omni_priority_queue_insert(omni_priority_queue_t* pq, int32_t element, int32_t priority) {
+    return omni_priority_queue_push(pq, element, priority);
+}
+
+int32_t omni_priority_queue_push_n(omni_priority_queue_t* pq, const int32_t* elements,
+                                   const int64_t* priorities, int32_t count, int32_t* handles) {
+    if (!pq || !elements || !priorities || count <= 0) return 0;
+    if (!omni_pq_reserve_nodes(pq, (int64_t)pq->size + count)) return 0;
+    int32_t old_size = pq->size;
+    int32_t added = 0;
+    for (; added < count; added++) {
+        int32_t handle = omni_pq_take_handle(pq);
+        if (handle == OMNI_PQ_NO_HANDLE) break;
+        omni_priority_queue_node_t* node = &pq->heap[old_size + added];
+        node->key = omni_pq_key(pq, priorities[added]);
+        node->element = elements[added];
+        node->handle = handle;
+        pq->positions[handle] = old_size + added;
+        if (handles) handles[added] = handle;
+    }
+    pq->size = old_size + added;
+    if (added > old_size) {
+        // Floyd's bottom-up build: sifting every internal node down is O(n),
+        // cheaper than `added` sift-ups once the batch outweighs the heap
+        for (int32_t i = (pq->size - 2) / OMNI_PQ_ARITY; i >= 0; i--) {
+            omni_pq_heapify_down(pq, i);
+        }
+    } else {
+        for (int32_t i = old_size; i < pq->size; i++) {
+            omni_pq_heapify_up(pq, i);
+        }
+    }
+    return added;
+}
+
+int32_t omni_priority_queue_extract_max(omni_priority_queue_t* pq) {
+    if (!pq || pq->size == 0) return 0;
+    return omni_pq_remove_at(pq, 0);
+}
+
+int32_t omni_priority_queue_pop(omni_priority_queue_t* pq) {
+    return omni_priority_queue_extract_max(pq);
+}
+
+int32_t omni_priority_queue_extract_top_k(omni_priority_queue_t* pq, int32_t k, int32_t* out) {
+    if (!pq || !out || k <= 0) return 0;
+    int32_t taken = 0;
+    while (taken < k && pq->size > 0) {
+        out[taken++] = omni_pq_remove_at(pq, 0);
+    }
+    return taken;
+}
+
+int32_t omni_priority_queue_peek(omni_priority_queue_t* pq) {
+    if (!pq || pq->size == 0) return 0;
+    return pq->heap[0].element;
+}
+
+int64_t omni_priority_queue_peek_priority(omni_priority_queue_t* pq) {
+    if (!pq || pq->size == 0) return 0;
+    return pq->heap[0].key ^ pq->order_mask;
+}
+
+int32_t omni_priority_queue_update(omni_priority_queue_t* pq, int32_t handle, int64_t priority) {
+    if (!omni_pq_handle_live(pq, handle)) return 0;
+    int32_t index = pq->positions[handle];
+    pq->heap[index].key = omni_pq_key(pq, priority);
+    omni_pq_resift(pq, index);
+    return 1;
+}
+
+int32_t omni_priority_queue_decrease_key(omni_priority_queue_t* pq, int32_t handle, int64_t priority) {
+    if (!omni_pq_handle_live(pq, handle)) return 0;
+    int32_t index = pq->positions[handle];
+    int64_t key = omni_pq_key(pq, priority);
+    if (key > pq->heap[index].key) return 0;
+    pq->heap[index].key = key;
+    omni_pq_heapify_up(pq, index);
+    return 1;
+}
+
+int32_t omni_priority_queue_remove(omni_priority_queue_t* pq, int32_t handle) {
+    if (!omni_pq_handle_live(pq, handle)) return 0;
+    omni_pq_remove_at(pq, pq->positions[handle]);
+    return 1;
+}
+
+int32_t omni_priority_queue_contains(omni_priority_queue_t* pq, int32_t handle) {
+    return omni_pq_handle_live(pq, handle) ? 1 : 0;
+}
+
+int32_t omni_priority_queue_is_empty(omni_priority_queue_t* pq) {
+    return (!pq || pq->size == 0) ? 1 : 0;
+}
+
+int32_t omni_priority_queue_size(omni_priority_queue_t* pq) {
+    return pq ? pq->size : 0;
+}
+
+void omni_priority_queue_clear(omni_priority_queue_t* pq) {
+    if (!pq) return;
+    pq->size = 0;
+    pq->handle_count = 0;
+    pq->free_handle = OMNI_PQ_NO_HANDLE;
+}
+
+// Linked list implementation (unrolled)
+// Elements are stored in doubly linked 64-byte nodes holding up to
+// OMNI_LIST_NODE_CAPACITY values each, so a scan touches one cache line per
+// eleven elements instead of chasing a pointer per element. Inserting into
+// a full node splits it in half; a node that drops below a quarter full
+// absorbs its successor when both fit, which keeps nodes at least half full
+// on average.
+//
+// Index operations start from whichever of the head, the tail or the last
+// node an index resolved to is closest, so sequential get/set/insert/remove
+// run in O(1) amortized. Cursors walk the nodes directly and are what the C
+// backend emits for `for x in list`.
+#define OMNI_LIST_NODE_CAPACITY 11
+
+struct omni_linked_list_node {
+    struct omni_linked_list_node* next;
+    struct omni_linked_list_node* prev;
+    int32_t count;
+    int32_t values[OMNI_LIST_NODE_CAPACITY];
+};
+typedef struct omni_linked_list_node omni_linked_list_node_t;
+
+struct omni_linked_list {
+    omni_linked_list_node_t* head;
+    omni_linked_list_node_t* tail;
+    int32_t size;
+    // Last node an index resolved to and the index of its first element;
+    // only valid while cache_node is non-NULL
+    omni_linked_list_node_t* cache_node;
+    int32_t cache_base;
+};
+
+static omni_linked_list_node_t* omni_ll_node_new(void) {
+    omni_linked_list_node_t* node = (omni_linked_list_node_t*)malloc(sizeof(omni_linked_list_node_t));
+    if (!node) return NULL;
+    node->next = NULL;
+    node->prev = NULL;
+    node->count = 0;
+    return node;
+}
+
+// Links node after `after` (at the front when after is NULL)
+static void omni_ll_link_after(omni_linked_list_t* ll, omni_linked_list_node_t* after, omni_linked_list_node_t* node) {
+    node->prev = after;
+    node->next = after ? after->next : ll->head;
+    if (node->next) {
+        node->next->prev = node;
+    } else {
+        ll->tail = node;
+    }
+    if (after) {
+        after->next = node;
+    } else {
+        ll->head = node;
+    }
+}
+
+static void omni_ll_unlink(omni_linked_list_t* ll, omni_linked_list_node_t* node) {
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        ll->head = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    } else {
+        ll->tail = node->prev;
+    }
+    free(node);
+}
+
+// Finds the node holding index (0 <= index < size) and the index of its
+// first element, starting from the closest known position
+static omni_linked_list_node_t* omni_ll_locate(omni_linked_list_t* ll, int32_t index, int32_t* base_out) {
+    omni_linked_list_node_t* node = ll->head;
+    int32_t base = 0;
+    int32_t best = index;
+    if (ll->size - index < best) {
+        node = ll->tail;
+        base = ll->size - ll->tail->count;
+        best = ll->size - index;
+    }
+    if (ll->cache_node) {
+        int32_t distance = index >= ll->cache_base ? index - ll->cache_base : ll->cache_base - index;
+        if (distance < best) {
+            node = ll->cache_node;
+            base = ll->cache_base;
+        }
+    }
+    while (index >= base + node->count) {
+        base += node->count;
+        node = node->next;
+    }
+    while (index < base) {
+        node = node->prev;
+        base -= node->count;
+    }
+    ll->cache_node = node;
+    ll->cache_base = base;
+    *base_out = base;
+    return node;
+}
+
+// Inserts element at *offset within node, splitting a full node first.
+// On return node/offset name the inserted element.
+static int omni_ll_insert_in(omni_linked_list_t* ll, omni_linked_list_node_t** node_io, int32_t* offset_io) {
+    omni_linked_list_node_t* node = *node_io;
+    int32_t offset = *offset_io;
+    if (node->count == OMNI_LIST_NODE_CAPACITY) {
+        omni_linked_list_node_t* upper = omni_ll_node_new();
+        if (!upper) return 0;
+        int32_t keep = OMNI_LIST_NODE_CAPACITY / 2;
+        upper->count = node->count - keep;
+        memcpy(upper->values, node->values + keep, (size_t)upper->count * sizeof(int32_t));
+        node->count = keep;
+        omni_ll_link_after(ll, node, upper);
+        if (offset > keep) {
+            node = upper;
+            offset -= keep;
+        }
+    }
+    memmove(node->values + offset + 1, node->values + offset, (size_t)(node->count - offset) * sizeof(int32_t));
+    node->count++;
+    ll->size++;
+    *node_io = node;
+    *offset_io = offset;
+    return 1;
+}
+
+// Removes the element at offset within node. On return node/offset name the
+// element that followed it (node is NULL at the end of the list).
+static void omni_ll_remove_in(omni_linked_list_t* ll, omni_linked_list_node_t** node_io, int32_t* offset_io) {
+    omni_linked_list_node_t* node = *node_io;
+    int32_t offset = *offset_io;
+    memmove(node->values + offset, node->values + offset + 1, (size_t)(node->count - offset - 1) * sizeof(int32_t));
+    node->count--;
+    ll->size--;
+    if (node->count == 0) {
+        omni_linked_list_node_t* next = node->next;
+        if (ll->cache_node == node) ll->cache_node = NULL;
+        omni_ll_unlink(ll, node);
+        node = next;
+        offset = 0;
+    } else {
+        omni_linked_list_node_t* next = node->next;
+        if (next && node->count < OMNI_LIST_NODE_CAPACITY / 4 + 1 && node->count + next->count <= OMNI_LIST_NODE_CAPACITY) {
+            memcpy(node->values + node->count, next->values, (size_t)next->count * sizeof(int32_t));
+            node->count += next->count;
+            if (ll->cache_node == next) ll->cache_node = NULL;
+            omni_ll_unlink(ll, next);
+        }
+        if (offset == node->count) {
+            node = node->next;
+            offset = 0;
+        }
+    }
+    *node_io = node;
+    *offset_io = offset;
+}
+
+omni_linked_list_t* omni_linked_list_create() {
+    return (omni_linked_list_t*)calloc(1, sizeof(omni_linked_list_t));
+}
+
+void omni_linked_list_destroy(omni_linked_list_t* ll) {
+    if (!ll) return;
+    omni_linked_list_clear(ll);
+    free(ll);
+}
+
+void omni_linked_list_append(omni_linked_list_t* ll, int32_t element) {
+    if (!ll) return;
+    omni_linked_list_node_t* node = ll->tail;
+    if (!node || node->count == OMNI_LIST_NODE_CAPACITY) {
+        node = omni_ll_node_new();
+        if (!node) return;
+        omni_ll_link_after(ll, ll->tail, node);
+    }
+    node->values[node->count++] = element;
+    ll->size++;
+}
+
+void omni_linked_list_prepend(omni_linked_list_t* ll, int32_t element) {
+    omni_linked_list_insert(ll, 0, element);
+}
+
+int32_t omni_linked_list_insert(omni_linked_list_t* ll, int32_t index, int32_t element) {
+    if (!ll || index < 0 || index > ll->size) return 0;
+    if (index == ll->size) {
+        int32_t size = ll->size;
+        omni_linked_list_append(ll, element);
+        return ll->size > size ? 1 : 0;
+    }
+    int32_t base;
+    omni_linked_list_node_t* node = omni_ll_locate(ll, index, &base);
+    int32_t offset = index - base;
+    if (offset == 0 && node->prev && node->prev->count < OMNI_LIST_NODE_CAPACITY) {
+        // Appending to a predecessor with room avoids shifting this node
+        node = node->prev;
+        offset = node->count;
+        base -= node->count;
+    }
+    if (!omni_ll_insert_in(ll, &node, &offset)) return 0;
+    node->values[offset] = element;
+    ll->cache_node = node;
+    ll->cache_base = index - offset;
+    return 1;
+}
+
+int32_t omni_linked_list_remove(omni_linked_list_t* ll, int32_t index) {
+    if (!ll || index < 0 || index >= ll->size) return 0;
+    int32_t base;
+    omni_linked_list_node_t* node = omni_ll_locate(ll, index, &base);
+    int32_t offset = index - base;
+    omni_ll_remove_in(ll, &node, &offset);
+    if (node) {
+        ll->cache_node = node;
+        ll->cache_base = index - offset;
+    }
+    return 1;
+}
+
+int32_t omni_linked_list_get(omni_linked_list_t* ll, int32_t index) {
+    if (!ll || index < 0 || index >= ll->size) return 0;
+    int32_t base;
+    omni_linked_list_node_t* node = omni_ll_locate(ll, index, &base);
+    return node->values[index - base];
+}
+
+int32_t omni_linked_list_set(omni_linked_list_t* ll, int32_t index, int32_t element) {
+    if (!ll || index < 0 || index >= ll->size) return 0;
+    int32_t base;
+    omni_linked_list_node_t* node = omni_ll_locate(ll, index, &base);
+    node->values[index - base] = element;
+    return 1;
+}
+
+int32_t omni_linked_list_size(omni_linked_list_t* ll) {
+    return ll ? ll->size : 0;
+}
+
+int32_t omni_linked_list_is_empty(omni_linked_list_t* ll) {
+    return (!ll || ll->size == 0) ? 1 : 0;
+}
+
+void omni_linked_list_clear(omni_linked_list_t* ll) {
+    if (!ll) return;
+    omni_linked_list_node_t* node = ll->head;
+    while (node) {
+        omni_linked_list_node_t* next = node->next;
+        free(node);
+        node = next;
+    }
+    ll->head = NULL;
+    ll->tail = NULL;
+    ll->size = 0;
+    ll->cache_node = NULL;
+}
+
+omni_linked_list_cursor_t omni_linked_list_begin(omni_linked_list_t* ll) {
+    omni_linked_list_cursor_t cursor;
+    cursor.list = ll;
+    cursor.node = ll ? ll->head : NULL;
+    cursor.offset = 0;
+    cursor.index = 0;
+    return cursor;
+}
+
+int32_t omni_linked_list_cursor_valid(const omni_linked_list_cursor_t* cursor) {
+    return cursor->node != NULL ? 1 : 0;
+}
+
+int32_t omni_linked_list_cursor_value(const omni_linked_list_cursor_t* cursor) {
+    return cursor->node ? cursor->node->values[cursor->offset] : 0;
+}
+
+int32_t omni_linked_list_cursor_index(const omni_linked_list_cursor_t* cursor) {
+    return cursor->index;
+}
+
+void omni_linked_list_next(omni_linked_list_cursor_t* cursor) {
+    if (!cursor->node) return;
+    cursor->index++;
+    if (++cursor->offset == cursor->node->count) {
+        cursor->node = cursor->node->next;
+        cursor->offset = 0;
+    }
+}
+
+int32_t omni_linked_list_insert_at_cursor(omni_linked_list_cursor_t* cursor, int32_t element) {
+    omni_linked_list_t* ll = cursor->list;
+    if (!ll) return 0;
+    if (!cursor->node) {
+        // Past the end: append, leaving the cursor at the end
+        int32_t size = ll->size;
+        omni_linked_list_append(ll, element);
+        if (ll->size == size) return 0;
+        cursor->index = ll->size;
+        return 1;
+    }
+    omni_linked_list_node_t* node = cursor->node;
+    int32_t offset = cursor->offset;
+    if (!omni_ll_insert_in(ll, &node, &offset)) return 0;
+    node->values[offset] = element;
+    ll->cache_node = NULL;
+    // Step over the new element: the cursor keeps naming the element it
+    // named before, now one index further on
+    cursor->node = node;
+    cursor->offset = offset;
+    omni_linked_list_next(cursor);
+    return 1;
+}
+
+int32_t omni_linked_list_remove_at_cursor(omni_linked_list_cursor_t* cursor) {
+    omni_linked_list_t* ll = cursor->list;
+    if (!ll || !cursor->node) return 0;
+    ll->cache_node = NULL;
+    omni_ll_remove_in(ll, &cursor->node, &cursor->offset);
+    return 1;
+}
+
+// Binary tree implementation (B+-tree)
+// omni_binary_tree_t is an ordered set of int32 keys kept in a B+-tree:
+// branches hold up to OMNI_BT_BRANCH_KEYS separators and one more child,
+// leaves hold up to OMNI_BT_LEAF_KEYS sorted keys and are chained both
+// ways so iteration and range queries scan leaves without revisiting
+// branches. A lookup touches a handful of wide nodes whatever the insertion
+// order, so sorted input no longer degenerates into a list.
+//
+// All operations are iterative. Insert and remove remember the descent in a
+// fixed path array (a 32-way tree of 2^31 keys is under eight levels deep)
+// and split, borrow or merge on the way back up. Branch separator i is the
+// smallest key ever moved into child i + 1; removals may leave it stale,
+// which is harmless because it still orders the two children.
+#define OMNI_BT_LEAF_KEYS 32
+#define OMNI_BT_BRANCH_KEYS 31
+#define OMNI_BT_MIN_LEAF (OMNI_BT_LEAF_KEYS / 2)
+#define OMNI_BT_MIN_BRANCH (OMNI_BT_BRANCH_KEYS / 2)
+#define OMNI_BT_MAX_DEPTH 32
+
+typedef struct {
+    int32_t count;
+    int32_t is_leaf;
+} omni_bt_header_t;
+
+typedef struct omni_bt_leaf {
+    omni_bt_header_t h;
+    struct omni_bt_leaf* prev;
+    struct omni_bt_leaf* next;
+    int32_t keys[OMNI_BT_LEAF_KEYS];
+} omni_bt_leaf_t;
+
+typedef struct omni_bt_branch {
+    omni_bt_header_t h;
+    int32_t keys[OMNI_BT_BRANCH_KEYS];
+    omni_bt_header_t* children[OMNI_BT_BRANCH_KEYS + 1];
+} omni_bt_branch_t;
+
+struct omni_binary_tree {
+    omni_bt_header_t* root;
+    omni_bt_leaf_t* first;
+    omni_bt_leaf_t* last;
+    int32_t size;
+};
+
+// Number of keys below key / at most key. Written as counts rather than a
+// search so the loops vectorize over a whole node.
+static inline int32_t omni_bt_count_less(const int32_t* keys, int32_t count, int32_t key) {
+    int32_t n = 0;
+    for (int32_t i = 0; i < count; i++) n += keys[i] < key;
+    return n;
+}
+
+static inline int32_t omni_bt_count_leq(const int32_t* keys, int32_t count, int32_t key) {
+    int32_t n = 0;
+    for (int32_t i = 0; i < count; i++) n += keys[i] <= key;
+    return n;
+}
+
+static omni_bt_leaf_t* omni_bt_leaf_new(void) {
+    omni_bt_leaf_t* leaf = (omni_bt_leaf_t*)calloc(1, sizeof(omni_bt_leaf_t));
+    if (leaf) leaf->h.is_leaf = 1;
+    return leaf;
+}
+
+static omni_bt_branch_t* omni_bt_branch_new(void) {
+    return (omni_bt_branch_t*)calloc(1, sizeof(omni_bt_branch_t));
+}
+
+// Leaf that would hold key
+static omni_bt_leaf_t* omni_bt_find_leaf(const omni_binary_tree_t* bt, int32_t key) {
+    omni_bt_header_t* node = bt->root;
+    while (node && !node->is_leaf) {
+        omni_bt_branch_t* branch = (omni_bt_branch_t*)node;
+        node = branch->children[omni_bt_count_leq(branch->keys, branch->h.count, key)];
+    }
+    return (omni_bt_leaf_t*)node;
+}
+
+// Frees every node, walking branches with an explicit stack
+static void omni_bt_free_nodes(omni_binary_tree_t* bt) {
+    omni_bt_header_t* stack[OMNI_BT_MAX_DEPTH * (OMNI_BT_BRANCH_KEYS + 1)];
+    int32_t top = 0;
+    if (bt->root && !bt->root->is_leaf) stack[top++] = bt->root;
+    while (top > 0) {
+        omni_bt_branch_t* branch = (omni_bt_branch_t*)stack[--top];
+        for (int32_t i = 0; i <= branch->h.count; i++) {
+            if (!branch->children[i]->is_leaf) stack[top++] = branch->children[i];
+        }
+        free(branch);
+    }
+    omni_bt_leaf_t* leaf = bt->first;
+    while (leaf) {
+        omni_bt_leaf_t* next = leaf->next;
+        free(leaf);
+        leaf = next;
+    }
+    bt->root = NULL;
+    bt->first = NULL;
+    bt->last = NULL;
+    bt->size = 0;
+}
+
+omni_binary_tree_t* omni_binary_tree_create() {
+    return (omni_binary_tree_t*)calloc(1, sizeof(omni_binary_tree_t));
+}
+
+void omni_binary_tree_destroy(omni_binary_tree_t* bt) {
+    if (!bt) return;
+    omni_bt_free_nodes(bt);
+    free(bt);
+}
+
+// Inserts sep/right after child index `at` of branch, which has room
+static void omni_bt_branch_insert(omni_bt_branch_t* branch, int32_t at, int32_t sep, omni_bt_header_t* right) {
+    int32_t count = branch->h.count;
+    memmove(branch->keys + at + 1, branch->keys + at, (size_t)(count - at) * sizeof(int32_t));
+    memmove(branch->children + at + 2, branch->children + at + 1, (size_t)(count - at) * sizeof(omni_bt_header_t*));
+    branch->keys[at] = sep;
+    branch->children[at + 1] = right;
+    branch->h.count = count + 1;
+}
+
+int32_t omni_binary_tree_add(omni_binary_tree_t* bt, int32_t element) {
+    if (!bt) return 0;
+    if (!bt->root) {
+        omni_bt_leaf_t* leaf = omni_bt_leaf_new();
+        if (!leaf) return 0;
+        bt->root = &leaf->h;
+        bt->first = bt->last = leaf;
+    }
+
+    omni_bt_branch_t* path[OMNI_BT_MAX_DEPTH];
+    int32_t slots[OMNI_BT_MAX_DEPTH];
+    int32_t depth = 0;
+    omni_bt_header_t* node = bt->root;
+    while (!node->is_leaf) {
+        omni_bt_branch_t* branch = (omni_bt_branch_t*)node;
+        int32_t slot = omni_bt_count_leq(branch->keys, branch->h.count, element);
+        path[depth] = branch;
+        slots[depth++] = slot;
+        node = branch->children[slot];
+    }
+
+    omni_bt_leaf_t* leaf = (omni_bt_leaf_t*)node;
+    int32_t pos = omni_bt_count_less(leaf->keys, leaf->h.count, element);
+    if (pos < leaf->h.count && leaf->keys[pos] == element) return 0;
+
+    if (leaf->h.count < OMNI_BT_LEAF_KEYS) {
+        memmove(leaf->keys + pos + 1, leaf->keys + pos, (size_t)(leaf->h.count - pos) * sizeof(int32_t));
+        leaf->keys[pos] = element;
+        leaf->h.count++;
+        bt->size++;
+        return 1;
+    }
+
+    // Every full branch on the path splits too, plus a new root if they all
+    // do. Allocate those nodes first so a failure leaves the tree untouched.
+    omni_bt_branch_t* spare[OMNI_BT_MAX_DEPTH + 1];
+    int32_t needed = 0;
+    while (needed < depth && path[depth - 1 - needed]->h.count == OMNI_BT_BRANCH_KEYS) needed++;
+    if (needed == depth) needed++;
+    omni_bt_leaf_t* right = omni_bt_leaf_new();
+    int32_t spares = 0;
+    while (right && spares < needed && (spare[spares] = omni_bt_branch_new()) != NULL) spares++;
+    if (!right || spares < needed) {
+        while (spares > 0) free(spare[--spares]);
+        free(right);
+        return 0;
+    }
+
+    // Split the full leaf. Appending at the right edge (sorted input) leaves
+    // the old leaf full instead of half empty.
+    int32_t keep = (pos == OMNI_BT_LEAF_KEYS && !leaf->next) ? OMNI_BT_LEAF_KEYS : OMNI_BT_LEAF_KEYS / 2;
+    right->h.count = OMNI_BT_LEAF_KEYS - keep;
+    memcpy(right->keys, leaf->keys + keep, (size_t)right->h.count * sizeof(int32_t));
+    leaf->h.count = keep;
+    omni_bt_leaf_t* target = (pos <= keep && keep < OMNI_BT_LEAF_KEYS) ? leaf : right;
+    int32_t at = target == leaf ? pos : pos - keep;
+    memmove(target->keys + at + 1, target->keys + at, (size_t)(target->h.count - at) * sizeof(int32_t));
+    target->keys[at] = element;
+    target->h.count++;
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next) {
+        leaf->next->prev = right;
+    } else {
+        bt->last = right;
+    }
+    leaf->next = right;
+    bt->size++;
+
+    // Push the separator up, splitting full branches on the way
+    int32_t sep = right->keys[0];
+    omni_bt_header_t* new_child = &right->h;
+    while (depth > 0) {
+        omni_bt_branch_t* branch = path[--depth];
+        int32_t slot = slots[depth];
+        if (branch->h.count < OMNI_BT_BRANCH_KEYS) {
+            omni_bt_branch_insert(branch, slot, sep, new_child);
+            return 1;
+        }
+        omni_bt_branch_t* sibling = spare[--spares];
+        int32_t keys[OMNI_BT_BRANCH_KEYS + 1];
+        omni_bt_header_t* children[OMNI_BT_BRANCH_KEYS + 2];
+        memcpy(keys, branch->keys, (size_t)slot * sizeof(int32_t));
+        keys[slot] = sep;
+        memcpy(keys + slot + 1, branch->keys + slot, (size_t)(OMNI_BT_BRANCH_KEYS - slot) * sizeof(int32_t));
+        memcpy(children, branch->children, (size_t)(slot + 1) * sizeof(omni_bt_header_t*));
+        children[slot + 1] = new_child;
+        memcpy(children + slot + 2, branch->children + slot + 1, (size_t)(OMNI_BT_BRANCH_KEYS - slot) * sizeof(omni_bt_header_t*));
+        int32_t mid = (OMNI_BT_BRANCH_KEYS + 1) / 2;
+        branch->h.count = mid;
+        memcpy(branch->keys, keys, (size_t)mid * sizeof(int32_t));
+        memcpy(branch->children, children, (size_t)(mid + 1) * sizeof(omni_bt_header_t*));
+        sibling->h.count = OMNI_BT_BRANCH_KEYS - mid;
+        memcpy(sibling->keys, keys + mid + 1, (size_t)sibling->h.count * sizeof(int32_t));
+        memcpy(sibling->children, children + mid + 1, (size_t)(sibling->h.count + 1) * sizeof(omni_bt_header_t*));
+        sep = keys[mid];
+        new_child = &sibling->h;
+    }
+
+    omni_bt_branch_t* root = spare[--spares];
+    root->h.count = 1;
+    root->keys[0] = sep;
+    root->children[0] = bt->root;
+    root->children[1] = new_child;
+    bt->root = &root->h;
+    return 1;
+}
+
+void omni_binary_tree_insert(omni_binary_tree_t* bt, int32_t element) {
+    omni_binary_tree_add(bt, element);
+}
+
+int32_t omni_binary_tree_search(omni_binary_tree_t* bt, int32_t element) {
+    if (!bt) return 0;
+    omni_bt_leaf_t* leaf = omni_bt_find_leaf(bt, element);
+    if (!leaf) return 0;
+    int32_t pos = omni_bt_count_less(leaf->keys, leaf->h.count, element);
+    return (pos < leaf->h.count && leaf->keys[pos] == element) ? 1 : 0;
+}
+
+// Removes separator `at` and the child to its right from branch
+static void omni_bt_branch_remove(omni_bt_branch_t* branch, int32_t at) {
+    int32_t count = branch->h.count;
+    memmove(branch->keys + at, branch->keys + at + 1, (size_t)(count - at - 1) * sizeof(int32_t));
+    memmove(branch->children + at + 1, branch->children + at + 2, (size_t)(count - at - 1) * sizeof(omni_bt_header_t*));
+    branch->h.count = count - 1;
+}
+
+// Refills the underfull leaf at parent->children[slot] from a sibling, or
+// merges it with one. Returns 1 if a child was removed from parent.
+static int omni_bt_fix_leaf(omni_binary_tree_t* bt, omni_bt_branch_t* parent, int32_t slot) {
+    omni_bt_leaf_t* leaf = (omni_bt_leaf_t*)parent->children[slot];
+    omni_bt_leaf_t* left = slot > 0 ? (omni_bt_leaf_t*)parent->children[slot - 1] : NULL;
+    omni_bt_leaf_t* right = slot < parent->h.count ? (omni_bt_leaf_t*)parent->children[slot + 1] : NULL;
+    if (left && left->h.count > OMNI_BT_MIN_LEAF) {
+        memmove(leaf->keys + 1, leaf->keys, (size_t)leaf->h.count * sizeof(int32_t));
+        leaf->keys[0] = left->keys[--left->h.count];
+        leaf->h.count++;
+        parent->keys[slot - 1] = leaf->keys[0];
+        return 0;
+    }
+    if (right && right->h.count > OMNI_BT_MIN_LEAF) {
+        leaf->keys[leaf->h.count++] = right->keys[0];
+        memmove(right->keys, right->keys + 1, (size_t)(--right->h.count) * sizeof(int32_t));
+        parent->keys[slot] = right->keys[0];
+        return 0;
+    }
+    // Merge the right one of the pair into the left one
+    int32_t sep = left ? slot - 1 : slot;
+    omni_bt_leaf_t* into = left ? left : leaf;
+    omni_bt_leaf_t* from = left ? leaf : right;
+    memcpy(into->keys + into->h.count, from->keys, (size_t)from->h.count * sizeof(int32_t));
+    into->h.count += from->h.count;
+    into->next = from->next;
+    if (from->next) {
+        from->next->prev = into;
+    } else {
+        bt->last = into;
+    }
+    free(from);
+    omni_bt_branch_remove(parent, sep);
+    return 1;
+}
+
+// Same for an underfull branch, rotating separators through the parent
+static int omni_bt_fix_branch(omni_bt_branch_t* parent, int32_t slot) {
+    omni_bt_branch_t* node = (omni_bt_branch_t*)parent->children[slot];
+    omni_bt_branch_t* left = slot > 0 ? (omni_bt_branch_t*)parent->children[slot - 1] : NULL;
+    omni_bt_branch_t* right = slot < parent->h.count ? (omni_bt_branch_t*)parent->children[slot + 1] : NULL;
+    if (left && left->h.count > OMNI_BT_MIN_BRANCH) {
+        memmove(node->keys + 1, node->keys, (size_t)node->h.count * sizeof(int32_t));
+        memmove(node->children + 1, node->children, (size_t)(node->h.count + 1) * sizeof(omni_bt_header_t*));
+        node->keys[0] = parent->keys[slot - 1];
+        node->children[0] = left->children[left->h.count];
+        node->h.count++;
+        parent->keys[slot - 1] = left->keys[--left->h.count];
+        return 0;
+    }
+    if (right && right->h.count > OMNI_BT_MIN_BRANCH) {
+        node->keys[node->h.count] = parent->keys[slot];
+        node->children[node->h.count + 1] = right->children[0];
+        node->h.count++;
+        parent->keys[slot] = right->keys[0];
+        memmove(right->keys, right->keys + 1, (size_t)(right->h.count - 1) * sizeof(int32_t));
+        memmove(right->children, right->children + 1, (size_t)right->h.count * sizeof(omni_bt_header_t*));
+        right->h.count--;
+        return 0;
+    }
+    int32_t sep = left ? slot - 1 : slot;
+    omni_bt_branch_t* into = left ? left : node;
+    omni_bt_branch_t* from = left ? node : right;
+    into->keys[into->h.count] = parent->keys[sep];
+    memcpy(into->keys + into->h.count + 1, from->keys, (size_t)from->h.count * sizeof(int32_t));
+    memcpy(into->children + into->h.count + 1, from->children, (size_t)(from->h.count + 1) * sizeof(omni_bt_header_t*));
+    into->h.count += from->h.count + 1;
+    free(from);
+    omni_bt_branch_remove(parent, sep);
+    return 1;
+}
+
+int32_t omni_binary_tree_remove(omni_binary_tree_t* bt, int32_t element) {
+    if (!bt || !bt->root) return 0;
+    omni_bt_branch_t* path[OMNI_BT_MAX_DEPTH];
+    int32_t slots[OMNI_BT_MAX_DEPTH];
+    int32_t depth = 0;
+    omni_bt_header_t* node = bt->root;
+    while (!node->is_leaf) {
+        omni_bt_branch_t* branch = (omni_bt_branch_t*)node;
+        int32_t slot = omni_bt_count_leq(branch->keys, branch->h.count, element);
+        path[depth] = branch;
+        slots[depth++] = slot;
+        node = branch->children[slot];
+    }
+    omni_bt_leaf_t* leaf = (omni_bt_leaf_t*)node;
+    int32_t pos = omni_bt_count_less(leaf->keys, leaf->h.count, element);
+    if (pos >= leaf->h.count || leaf->keys[pos] != element) return 0;
+    memmove(leaf->keys + pos, leaf->keys + pos + 1, (size_t)(leaf->h.count - pos - 1) * sizeof(int32_t));
+    leaf->h.count--;
+    bt->size--;
+
+    if (depth == 0) {
+        if (leaf->h.count == 0) {
+            free(leaf);
+            bt->root = NULL;
+            bt->first = bt->last = NULL;
+        }
+        return 1;
+    }
+    if (leaf->h.count >= OMNI_BT_MIN_LEAF) return 1;
+
+    // Rebalance upward while merges leave parents underfull
+    int merged = omni_bt_fix_leaf(bt, path[depth - 1], slots[depth - 1]);
+    depth--;
+    while (merged && depth > 0 && path[depth]->h.count < OMNI_BT_MIN_BRANCH) {
+        merged = omni_bt_fix_branch(path[depth - 1], slots[depth - 1]);
+        depth--;
+    }
+    omni_bt_branch_t* root = (omni_bt_branch_t*)bt->root;
+    if (!root->h.is_leaf && root->h.count == 0) {
+        bt->root = root->children[0];
+        free(root);
+    }
+    return 1;
+}
+
+int32_t omni_binary_tree_size(omni_binary_tree_t* bt) {
+    if (!bt) return 0;
+    return bt->size;
+}
+
+int32_t omni_binary_tree_is_empty(omni_binary_tree_t* bt) {
+    return (!bt || bt->size == 0) ? 1 : 0;
+}
+
+void omni_binary_tree_clear(omni_binary_tree_t* bt) {
+    if (!bt) return;
+    omni_bt_free_nodes(bt);
+}
+
+int32_t omni_binary_tree_min(omni_binary_tree_t* bt, int32_t* out) {
+    if (!bt || bt->size == 0) return 0;
+    *out = bt->first->keys[0];
+    return 1;
+}
+
+int32_t omni_binary_tree_max(omni_binary_tree_t* bt, int32_t* out) {
+    if (!bt || bt->size == 0) return 0;
+    *out = bt->last->keys[bt->last->h.count - 1];
+    return 1;
+}
+
+omni_binary_tree_iter_t omni_binary_tree_iter_begin(omni_binary_tree_t* bt) {
+    omni_binary_tree_iter_t it;
+    it.leaf = bt ? bt->first : NULL;
+    it.index = 0;
+    return it;
+}
+
+omni_binary_tree_iter_t omni_binary_tree_iter_seek(omni_binary_tree_t* bt, int32_t key) {
+    omni_binary_tree_iter_t it;
+    it.leaf = NULL;
+    it.index = 0;
+    omni_bt_leaf_t* leaf = bt ? omni_bt_find_leaf(bt, key) : NULL;
+    if (!leaf) return it;
+    int32_t pos = omni_bt_count_less(leaf->keys, leaf->h.count, key);
+    if (pos == leaf->h.count) {
+        // Every key here is smaller; the bound is the next leaf's first key
+        leaf = leaf->next;
+        pos = 0;
+    }
+    it.leaf = leaf;
+    it.index = pos;
+    return it;
+}
+
+int32_t omni_binary_tree_iter_valid(const omni_binary_tree_iter_t* it) {
+    return it->leaf != NULL ? 1 : 0;
+}
+
+int32_t omni_binary_tree_iter_value(const omni_binary_tree_iter_t* it) {
+    return it->leaf ? it->leaf->keys[it->index] : 0;
+}
+
+void omni_binary_tree_iter_next(omni_binary_tree_iter_t* it) {
+    omni_bt_leaf_t* leaf = it->leaf;
+    if (!leaf) return;
+    if (++it->index == leaf->h.count) {
+        it->leaf = leaf->next;
+        it->index = 0;
+    }
+}
+
+int32_t omni_binary_tree_lower_bound(omni_binary_tree_t* bt, int32_t key, int32_t* out) {
+    omni_binary_tree_iter_t it = omni_binary_tree_iter_seek(bt, key);
+    if (!it.leaf) return 0;
+    *out = omni_binary_tree_iter_value(&it);
+    return 1;
+}
+
+int32_t omni_binary_tree_upper_bound(omni_binary_tree_t* bt, int32_t key, int32_t* out) {
+    if (key == INT32_MAX) return 0;
+    return omni_binary_tree_lower_bound(bt, key + 1, out);
+}
+
+int32_t omni_binary_tree_range(omni_binary_tree_t* bt, int32_t lo, int32_t hi, int32_t* out, int32_t max) {
+    if (!bt || lo > hi) return 0;
+    omni_binary_tree_iter_t it = omni_binary_tree_iter_seek(bt, lo);
+    int32_t n = 0;
+    // Copy whole leaf runs at a time
+    while (it.leaf) {
+        omni_bt_leaf_t* leaf = it.leaf;
+        int32_t end = leaf->h.count;
+        if (leaf->keys[end - 1] > hi) end = omni_bt_count_leq(leaf->keys, end, hi);
+        int32_t take = end > it.index ? end - it.index : 0;
+        if (out) {
+            if (take > max - n) take = max - n;
+            memcpy(out + n, leaf->keys + it.index, (size_t)take * sizeof(int32_t));
+            if (n + take == max) return max;
+        }
+        n += take;
+        if (end < leaf->h.count) break;
+        it.leaf = leaf->next;
+        it.index = 0;
+    }
+    return n;
+}
+
+// ============================================================================
+// Network Functions Implementation
+// ============================================================================
+
+// IP address functions
+omni_ip_address_t* omni_ip_parse(const char* ip_str) {
+    if (!ip_str) return NULL;
+    omni_ip_address_t* ip = (omni_ip_address_t*)malloc(sizeof(omni_ip_address_t));
+    if (!ip) return NULL;
+    
+    strncpy(ip->address, ip_str, sizeof(ip->address) - 1);
+    ip->address[sizeof(ip->address) - 1] = '\0';
+    
+    // Simple IPv4 detection (contains dots and no colons)
+    ip->is_ipv4 = (strchr(ip_str, '.') != NULL && strchr(ip_str, ':') == NULL) ? 1 : 0;
+    ip->is_ipv6 = (strchr(ip_str, ':') != NULL) ? 1 : 0;
+    
+    return ip;
+}
+
+int32_t omni_ip_is_valid(const char* ip_str) {
+    if (!ip_str) return 0;
+    // Basic validation - check for IPv4 format (dotted decimal)
+    int dot_count = 0;
+    int digit_count = 0;
+    for (const char* p = ip_str; *p; p++) {
+        if (*p == '.') {
+            dot_count++;
+            digit_count = 0;
+        } else if (*p >= '0' && *p <= '9') {
+            digit_count++;
+            if (digit_count > 3) return 0;
+        } else if (*p == ':') {
+            // IPv6 format
+            return 1; // Basic check - assume valid if contains colon
+        } else {
+            return 0;
+        }
+    }
+    return (dot_count == 3) ? 1 : 0;
+}
+
+int32_t omni_ip_is_private(omni_ip_address_t* ip) {
+    if (!ip || !ip->is_ipv4) return 0;
+    // Check for private IP ranges: 10.x.x.x, 172.16-31.x.x, 192.168.x.x
+    if (strncmp(ip->address, "10.", 3) == 0) return 1;
+    if (strncmp(ip->address, "172.16.", 7) == 0 || strncmp(ip->address, "172.17.", 7) == 0 ||
+        strncmp(ip->address, "172.18.", 7) == 0 || strncmp(ip->address, "172.19.", 7) == 0 ||
+        strncmp(ip->address, "172.20.", 7) == 0 || strncmp(ip->address, "172.21.", 7) == 0 ||
+        strncmp(ip->address, "172.22.", 7) == 0 || strncmp(ip->address, "172.23.", 7) == 0 ||
+        strncmp(ip->address, "172.24.", 7) == 0 || strncmp(ip->address, "172.25.", 7) == 0 ||
+        strncmp(ip->address, "172.26.", 7) == 0 || strncmp(ip->address, "172.27.", 7) == 0 ||
+        strncmp(ip->address, "172.28.", 7) == 0 || strncmp(ip->address, "172.29.", 7) == 0 ||
+        strncmp(ip->address, "172.30.", 7) == 0 || strncmp(ip->address, "172.31.", 7) == 0) return 1;
+    if (strncmp(ip->address, "192.168.", 8) == 0) return 1;
+    return 0;
+}
+
+int32_t omni_ip_is_loopback(omni_ip_address_t* ip) {
+    if (!ip || !ip->is_ipv4) return 0;
+    return (strncmp(ip->address, "127.", 4) == 0) ? 1 : 0;
+}
+
+char* omni_ip_to_string(omni_ip_address_t* ip) {
+    if (!ip) return NULL;
+    return strdup(ip->address);
+}
+
+// URL functions
+omni_url_t* omni_url_parse(const char* url_str) {
+    if (!url_str) return NULL;
+    omni_url_t* url = (omni_url_t*)malloc(sizeof(omni_url_t));
+    if (!url) return NULL;
+    
+    // Initialize with defaults
+    strncpy(url->scheme, "http", sizeof(url->scheme) - 1);
+    strncpy(url->host, "localhost", sizeof(url->host) - 1);
+    url->port = 80;
+    strncpy(url->path, "/", sizeof(url->path) - 1);
+    url->query[0] = '\0';
+    url->fragment[0] = '\0';
+    
+    // Basic parsing
+    const char* scheme_end = strstr(url_str, "://");
+    if (scheme_end) {
+        size_t scheme_len = scheme_end - url_str;
+        if (scheme_len < sizeof(url->scheme)) {
+            strncpy(url->scheme, url_str, scheme_len);
+            url->scheme[scheme_len] = '\0';
+        }
+        url_str = scheme_end + 3;
+    }
+    
+    // Extract host and port
+    const char* path_start = strchr(url_str, '/');
+    const char* port_start = strchr(url_str, ':');
+    if (port_start && (!path_start || port_start < path_start)) {
+        size_t host_len = port_start - url_str;
+        if (host_len < sizeof(url->host)) {
+            strncpy(url->host, url_str, host_len);
+            url->host[host_len] = '\0';
+        }
+        sscanf(port_start + 1, "%d", &url->port);
+        if (path_start) {
+            strncpy(url->path, path_start, sizeof(url->path) - 1);
+        }
+    } else if (path_start) {
+        size_t host_len = path_start - url_str;
+        if (host_len < sizeof(url->host)) {
+            strncpy(url->host, url_str, host_len);
+            url->host[host_len] = '\0';
+        }
+        strncpy(url->path, path_start, sizeof(url->path) - 1);
+    } else {
+        strncpy(url->host, url_str, sizeof(url->host) - 1);
+    }
+    
+    return url;
+}
+
+char* omni_url_to_string(omni_url_t* url) {
+    if (!url) return NULL;
+    char* result = (char*)malloc(1024);
+    if (!result) return NULL;
+    
+    snprintf(result, 1024, "%s://%s", url->scheme, url->host);
+    if (url->port > 0 && url->port != 80 && url->port != 443) {
+        char temp[1024];
+        snprintf(temp, 1024, "%s:%d%s", result, url->port, url->path);
+        strncpy(result, temp, 1024);
+    } else {
+        strncat(result, url->path, 1024 - strlen(result) - 1);
+    }
+    if (url->query[0] != '\0') {
+        strncat(result, "?", 1024 - strlen(result) - 1);
+        strncat(result, url->query, 1024 - strlen(result) - 1);
+    }
+    if (url->fragment[0] != '\0') {
+        strncat(result, "#", 1024 - strlen(result) - 1);
+        strncat(result, url->fragment, 1024 - strlen(result) - 1);
+    }
+    return result;
+}
+
+int32_t omni_url_is_valid(const char* url_str) {
+    if (!url_str) return 0;
+    // Basic validation - check for scheme://host format
+    return (strstr(url_str, "://") != NULL) ? 1 : 0;
+}
+
+// HTTP client functions (the transport is after the socket functions)
+static omni_http_response_t* omni_http_simple(const char* method, const char* url, const char* body) {
+    omni_http_request_t* req = omni_http_request_create(method, url);
+    if (!req) return NULL;
+    if (body) omni_http_request_set_body(req, body);
+    omni_http_response_t* resp = omni_http_request(req);
+    omni_http_request_destroy(req);
+    return resp;
+}
+
+omni_http_response_t* omni_http_get(const char* url) {
+    return omni_http_simple("GET", url, NULL);
+}
+
+omni_http_response_t* omni_http_post(const char* url, const char* body) {
+    return omni_http_simple("POST", url, body);
+}
+
+omni_http_response_t* omni_http_put(const char* url, const char* body) {
+    return omni_http_simple("PUT", url, body);
+}
+
+omni_http_response_t* omni_http_delete(const char* url) {
+    return omni_http_simple("DELETE", url, NULL);
+}
+
+void omni_http_response_destroy(omni_http_response_t* resp) {
+    if (!resp) return;
+    if (resp->headers) omni_map_destroy(resp->headers);
+    omni_str_free(resp->body);
+    free(resp->header_block);
+    free(resp);
+}
+
+int32_t omni_http_response_is_success(omni_http_response_t* resp) {
+    if (!resp) return 0;
+    return (resp->status_code >= 200 && resp->status_code < 300) ? 1 : 0;
+}
+
+int32_t omni_http_response_is_client_error(omni_http_response_t* resp) {
+    if (!resp) return 0;
+    return (resp->status_code >= 400 && resp->status_code < 500) ? 1 : 0;
+}
+
+int32_t omni_http_response_is_server_error(omni_http_response_t* resp) {
+    if (!resp) return 0;
+    return (resp->status_code >= 500 && resp->status_code < 600) ? 1 : 0;
+}
+
+char* omni_http_response_get_header(omni_http_response_t* resp, const char* name) {
+    if (!resp || !resp->headers || !name) return NULL;
+    // Names are stored lower-cased
+    char lower[256];
+    size_t len = strlen(name);
+    if (len >= sizeof(lower)) return NULL;
+    for (size_t i = 0; i <= len; i++) {
+        lower[i] = (char)tolower((unsigned char)name[i]);
+    }
+    const char* value = omni_map_get_string_string(resp->headers, lower);
+    return value ? strdup(value) : NULL;
+}
+
+omni_http_request_t* omni_http_request_create(const char* method, const char* url) {
+    if (!method || !url) return NULL;
+    // A truncated method or URL would send a different request
+    if (strlen(method) >= sizeof(((omni_http_request_t*)0)->method) ||
+        strlen(url) >= sizeof(((omni_http_request_t*)0)->url)) {
+        return NULL;
+    }
+    omni_http_request_t* req = (omni_http_request_t*)calloc(1, sizeof(omni_http_request_t));
+    if (!req) return NULL;
+    strcpy(req->method, method);
+    strcpy(req->url, url);
+    req->headers = omni_map_create();
+    req->body = NULL;
+    return req;
+}
+
+void omni_http_request_set_header(omni_http_request_t* req, const char* name, const char* value) {
+    if (!req || !req->headers || !name || !value) return;
+    omni_map_put_string_string(req->headers, name, value);
+}
+
+void omni_http_request_set_body(omni_http_request_t* req, const char* body) {
+    if (!req) return;
+    if (req->body) free(req->body);
+    req->body = body ? strdup(body) : NULL;
+}
+
+char* omni_http_request_get_header(omni_http_request_t* req, const char* name) {
+    if (!req || !req->headers || !name) return NULL;
+    const char* value = omni_map_get_string_string(req->headers, name);
+    return value ? strdup(value) : NULL;
+}
+
+void omni_http_request_destroy(omni_http_request_t* req) {
+    if (!req) return;
+    if (req->headers) omni_map_destroy(req->headers);
+    if (req->body) free(req->body);
+    free(req);
+}
+
+// Socket functions
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Host name resolution, provided by the DNS resolver below
+#define OMNI_DNS_MAX_ADDRS 16
+typedef struct {
+    int32_t family; // AF_INET or AF_INET6
+    unsigned char bytes[16];
+} omni_dns_addr_t;
+static int32_t omni_dns_resolve(const char* hostname, omni_dns_addr_t* out);
+
+int32_t omni_socket_create() {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return -1;
+    return socket(AF_INET, SOCK_STREAM, 0);
+#else
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+#ifdef SO_NOSIGPIPE
+    // Writing to a closed peer fails with EPIPE instead of raising SIGPIPE
+    if (fd >= 0) {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    }
+#endif
+    return fd;
+#endif
+}
+
+int32_t omni_socket_connect(int32_t socket, const char* address, int32_t port) {
+    if (socket < 0 || !address) return 0;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+        // A host name; the socket is IPv4, so it takes the first IPv4 address
+        omni_dns_addr_t addrs[OMNI_DNS_MAX_ADDRS];
+        int32_t count = omni_dns_resolve(address, addrs);
+        int32_t i = 0;
+        while (i < count && addrs[i].family != AF_INET) i++;
+        if (i == count) return 0;
+        memcpy(&addr.sin_addr, addrs[i].bytes, 4);
+    }
+    return (connect(socket, (struct sockaddr*)&addr, sizeof(addr)) == 0) ? 1 : 0;
+}
+
+int32_t omni_socket_bind(int32_t socket, const char* address, int32_t port) {
+    if (socket < 0 || !address) return 0;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, address, &addr.sin_addr);
+    return (bind(socket, (struct sockaddr*)&addr, sizeof(addr)) == 0) ? 1 : 0;
+}
+
+int32_t omni_socket_listen(int32_t socket, int32_t backlog) {
+    if (socket < 0) return 0;
+    return (listen(socket, backlog) == 0) ? 1 : 0;
+}
+
+int32_t omni_socket_accept(int32_t socket) {
+    if (socket < 0) return -1;
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    return accept(socket, (struct sockaddr*)&addr, &len);
+}
+
+int32_t omni_socket_send(int32_t socket, const char* data) {
+    if (socket < 0 || !data) return -1;
+    return (int32_t)omni_socket_send_bytes(socket, data, (int64_t)strlen(data));
+}
+
+int64_t omni_socket_send_bytes(int32_t socket, const void* data, int64_t len) {
+    if (socket < 0 || len < 0 || (!data && len > 0)) return -1;
+    const char* bytes = (const char*)data;
+    int64_t sent = 0;
+    while (sent < len) {
+        int64_t chunk = len - sent;
+        if (chunk > INT_MAX) chunk = INT_MAX;
+#ifdef _WIN32
+        int n = send(socket, bytes + sent, (int)chunk, 0);
+#else
+        ssize_t n = send(socket, bytes + sent, (size_t)chunk, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n < 0) return sent > 0 ? sent : -1;
+        sent += n;
+    }
+    return sent;
+}
+
+int32_t omni_socket_receive(int32_t socket, char* buffer, int32_t buffer_size) {
+    if (socket < 0 || !buffer || buffer_size <= 0) return -1;
+    int64_t received = omni_socket_receive_bytes(socket, buffer, buffer_size - 1);
+    buffer[received > 0 ? received : 0] = '\0';
+    return (int32_t)received;
+}
+
+int64_t omni_socket_receive_bytes(int32_t socket, void* buffer, int64_t size) {
+    if (socket < 0 || size < 0 || (!buffer && size > 0)) return -1;
+    if (size > INT_MAX) size = INT_MAX;
+    for (;;) {
+#ifdef _WIN32
+        int n = recv(socket, (char*)buffer, (int)size, 0);
+#else
+        ssize_t n = recv(socket, buffer, (size_t)size, 0);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        return (int64_t)n;
+    }
+}
+
+char* omni_socket_receive_string(int32_t socket, int32_t max_len) {
+    if (max_len < 0) max_len = 0;
+    char* str = omni_str_alloc(NULL, (size_t)max_len);
+    if (!str) return NULL;
+    int64_t received = max_len > 0 ? omni_socket_receive_bytes(socket, str, max_len) : 0;
+    if (received < 0) received = 0;
+    OMNI_STR_HEADER(str)->len = (size_t)received;
+    str[received] = '\0';
+    return str;
+}
+
+int32_t omni_socket_set_nonblocking(int32_t socket, int32_t enable) {
+    if (socket < 0) return 0;
+#ifdef _WIN32
+    u_long mode = enable ? 1 : 0;
+    return (ioctlsocket(socket, FIONBIO, &mode) == 0) ? 1 : 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags < 0) return 0;
+    flags = enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return (fcntl(socket, F_SETFL, flags) == 0) ? 1 : 0;
+#endif
+}
+
+int32_t omni_socket_set_reuse_port(int32_t socket, int32_t enable) {
+    if (socket < 0) return 0;
+#ifdef SO_REUSEPORT
+    int on = enable ? 1 : 0;
+    return (setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, (const char*)&on, sizeof(on)) == 0) ? 1 : 0;
+#else
+    (void)enable;
+    return 0;
+#endif
+}
+
+int32_t omni_socket_listen_shared(const char* address, int32_t port, int32_t backlog) {
+    int32_t fd = omni_socket_create();
+    if (fd < 0) return -1;
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+    if (!omni_socket_set_reuse_port(fd, 1) ||
+        !omni_socket_bind(fd, address ? address : "0.0.0.0", port) ||
+        !omni_socket_listen(fd, backlog > 0 ? backlog : SOMAXCONN)) {
+        omni_socket_close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// ============================================================================
+// Event Loop
+// ============================================================================
+
+#if defined(_WIN32)
+#define OMNI_EV_NONE 1
+#elif defined(__linux__)
+#include <sys/epoll.h>
+#define OMNI_EV_EPOLL 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+#include <sys/event.h>
+#define OMNI_EV_KQUEUE 1
+#else
+#include <poll.h>
+#define OMNI_EV_POLL 1
+#endif
+
+// Events collected per wait
+#define OMNI_EV_BATCH 64
+
+typedef struct {
+    omni_io_callback_t callback;
+    void* arg;
+    int32_t events;      // Armed events, 0 while disarmed
+    int32_t registered;  // Known to the kernel (epoll/kqueue)
+} omni_io_watch_t;
+
+struct omni_event_loop {
+    int fd;                   // epoll or kqueue descriptor, -1 for poll
+    int wake[2];              // Self-pipe waking the loop from other threads
+    int32_t wake_pending;
+    int32_t stopped;
+    omni_mutex_t lock;        // Guards watches
+    omni_io_watch_t* watches; // Indexed by descriptor
+    int32_t capacity;
+};
+
+const char* omni_event_loop_backend(void) {
+#if defined(OMNI_EV_EPOLL)
+    return "epoll";
+#elif defined(OMNI_EV_KQUEUE)
+    return "kqueue";
+#elif defined(OMNI_EV_POLL)
+    return "poll";
+#else
+    return "none";
+#endif
+}
+
+#ifdef OMNI_EV_NONE
+
+omni_event_loop_t* omni_event_loop_create(void) { return NULL; }
+void omni_event_loop_destroy(omni_event_loop_t* loop) { (void)loop; }
+int32_t omni_event_loop_add(omni_event_loop_t* loop, int32_t fd, int32_t events, omni_io_callback_t callback, void* arg) {
+    (void)loop; (void)fd; (void)events; (void)callback; (void)arg;
+    return -1;
+}
+int32_t omni_event_loop_modify(omni_event_loop_t* loop, int32_t fd, int32_t events) {
+    (void)loop; (void)fd; (void)events;
+    return -1;
+}
+int32_t omni_event_loop_remove(omni_event_loop_t* loop, int32_t fd) {
+    (void)loop; (void)fd;
+    return -1;
+}
+int32_t omni_event_loop_run_once(omni_event_loop_t* loop, int32_t timeout_ms) {
+    (void)loop; (void)timeout_ms;
+    return -1;
+}
+int32_t omni_event_loop_run(omni_event_loop_t* loop) { (void)loop; return -1; }
+void omni_event_loop_stop(omni_event_loop_t* loop) { (void)loop; }
+
+static omni_io_callback_t omni_ev_detach(omni_event_loop_t* loop, int32_t fd, void** arg, int32_t* events) {
+    (void)loop; (void)fd; (void)arg; (void)events;
+    return NULL;
+}
+
+#else
+
+static int omni_fd_set_flags(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) return -1;
+    return fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+omni_event_loop_t* omni_event_loop_create(void) {
+    omni_event_loop_t* loop = (omni_event_loop_t*)calloc(1, sizeof(omni_event_loop_t));
+    if (!loop) return NULL;
+    omni_mutex_t lock = OMNI_MUTEX_INIT;
+    loop->lock = lock;
+    loop->fd = -1;
+    if (pipe(loop->wake) != 0) {
+        free(loop);
+        return NULL;
+    }
+    if (omni_fd_set_flags(loop->wake[0]) != 0 || omni_fd_set_flags(loop->wake[1]) != 0) {
+        omni_event_loop_destroy(loop);
+        return NULL;
+    }
+#if defined(OMNI_EV_EPOLL)
+    loop->fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = loop->wake[0];
+    if (loop->fd < 0 || epoll_ctl(loop->fd, EPOLL_CTL_ADD, loop->wake[0], &ev) != 0) {
+        omni_event_loop_destroy(loop);
+        return NULL;
+    }
+#elif defined(OMNI_EV_KQUEUE)
+    loop->fd = kqueue();
+    struct kevent change;
+    EV_SET(&change, loop->wake[0], EVFILT_READ, EV_ADD, 0, 0, NULL);
+    if (loop->fd < 0 || fcntl(loop->fd, F_SETFD, FD_CLOEXEC) != 0 ||
+        kevent(loop->fd, &change, 1, NULL, 0, NULL) != 0) {
+        omni_event_loop_destroy(loop);
+        return NULL;
+    }
+#endif
+    return loop;
+}
+
+void omni_event_loop_destroy(omni_event_loop_t* loop) {
+    if (!loop) return;
+    if (loop->fd >= 0) close(loop->fd);
+    if (loop->wake[0] >= 0) close(loop->wake[0]);
+    if (loop->wake[1] >= 0) close(loop->wake[1]);
+    free(loop->watches);
+    free(loop);
+}
+
+// Interrupts a wait in progress; wakes are coalesced until the loop drains
+// the pipe
+static void omni_ev_wake(omni_event_loop_t* loop) {
+    if (__atomic_exchange_n(&loop->wake_pending, 1, __ATOMIC_ACQ_REL)) return;
+    char byte = 1;
+    ssize_t n;
+    do {
+        n = write(loop->wake[1], &byte, 1);
+    } while (n < 0 && errno == EINTR);
+}
+
+static void omni_ev_drain(omni_event_loop_t* loop) {
+    char buffer[64];
+    __atomic_store_n(&loop->wake_pending, 0, __ATOMIC_RELEASE);
+    while (read(loop->wake[0], buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+// Makes the kernel's interest in fd match events (the watch's previous
+// events were old_events). Called with the loop locked.
+static int omni_ev_apply(omni_event_loop_t* loop, int fd, omni_io_watch_t* watch, int32_t old_events, int32_t events) {
+#if defined(OMNI_EV_EPOLL)
+    (void)old_events;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.data.fd = fd;
+    if (events & OMNI_EV_READ) ev.events |= EPOLLIN | EPOLLRDHUP;
+    if (events & OMNI_EV_WRITE) ev.events |= EPOLLOUT;
+    if (events & OMNI_EV_ONESHOT) ev.events |= EPOLLONESHOT;
+    if (!events) {
+        if (watch->registered) epoll_ctl(loop->fd, EPOLL_CTL_DEL, fd, &ev);
+        watch->registered = 0;
+        return 0;
+    }
+    // The descriptor may have been closed and reused since the kernel last
+    // saw it, so fall back between ADD and MOD
+    int op = watch->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(loop->fd, op, fd, &ev) != 0) {
+        if (op == EPOLL_CTL_MOD && errno == ENOENT) {
+            op = EPOLL_CTL_ADD;
+        } else if (op == EPOLL_CTL_ADD && errno == EEXIST) {
+            op = EPOLL_CTL_MOD;
+        } else {
+            return -1;
+        }
+        if (epoll_ctl(loop->fd, op, fd, &ev) != 0) return -1;
+    }
+    watch->registered = 1;
+    return 0;
+#elif defined(OMNI_EV_KQUEUE)
+    // One filter per direction: add the requested ones, delete the others
+    // (EV_RECEIPT reports per-change errors, so deleting a filter that a
+    // oneshot already removed is harmless)
+    struct kevent changes[2];
+    struct kevent results[2];
+    unsigned short oneshot = (events & OMNI_EV_ONESHOT) ? EV_ONESHOT : 0;
+    int n = 0;
+    if (events & OMNI_EV_READ) {
+        EV_SET(&changes[n++], fd, EVFILT_READ, EV_ADD | EV_ENABLE | EV_RECEIPT | oneshot, 0, 0, NULL);
+    } else if (watch->registered || (old_events & OMNI_EV_READ)) {
+        EV_SET(&changes[n++], fd, EVFILT_READ, EV_DELETE | EV_RECEIPT, 0, 0, NULL);
+    }
+    if (events & OMNI_EV_WRITE) {
+        EV_SET(&changes[n++], fd, EVFILT_WRITE, EV_ADD | EV_ENABLE | EV_RECEIPT | oneshot, 0, 0, NULL);
+    } else if (watch->registered || (old_events & OMNI_EV_WRITE)) {
+        EV_SET(&changes[n++], fd, EVFILT_WRITE, EV_DELETE | EV_RECEIPT, 0, 0, NULL);
+    }
+    watch->registered = (events & (OMNI_EV_READ | OMNI_EV_WRITE)) != 0;
+    if (n == 0) return 0;
+    int got = kevent(loop->fd, changes, n, results, n, NULL);
+    if (got < 0) return -1;
+    for (int i = 0; i < got; i++) {
+        if ((results[i].flags & EV_ERROR) && results[i].data != 0 &&
+            !(changes[i].flags & EV_DELETE)) {
+            return -1;
+        }
+    }
+    return 0;
+#else
+    // poll rebuilds its descriptor set on every wait
+    (void)fd; (void)watch; (void)old_events; (void)events;
+    omni_ev_wake(loop);
+    return 0;
+#endif
+}
+
+static omni_io_watch_t* omni_ev_watch(omni_event_loop_t* loop, int32_t fd, int grow) {
+    if (fd < 0) return NULL;
+    if (fd >= loop->capacity) {
+        if (!grow) return NULL;
+        int32_t capacity = loop->capacity ? loop->capacity : 64;
+        while (capacity <= fd) capacity *= 2;
+        omni_io_watch_t* watches = (omni_io_watch_t*)realloc(loop->watches, (size_t)capacity * sizeof(omni_io_watch_t));
+        if (!watches) return NULL;
+        memset(watches + loop->capacity, 0, (size_t)(capacity - loop->capacity) * sizeof(omni_io_watch_t));
+        loop->watches = watches;
+        loop->capacity = capacity;
+    }
+    return &loop->watches[fd];
+}
+
+int32_t omni_event_loop_add(omni_event_loop_t* loop, int32_t fd, int32_t events, omni_io_callback_t callback, void* arg) {
+    if (!loop || !callback || !(events & (OMNI_EV_READ | OMNI_EV_WRITE))) return -1;
+    omni_mutex_lock(&loop->lock);
+    omni_io_watch_t* watch = omni_ev_watch(loop, fd, 1);
+    if (!watch || watch->events) {
+        omni_mutex_unlock(&loop->lock);
+        return -1;
+    }
+    if (omni_ev_apply(loop, fd, watch, 0, events) != 0) {
+        omni_mutex_unlock(&loop->lock);
+        return -1;
+    }
+    watch->callback = callback;
+    watch->arg = arg;
+    watch->events = events;
+    omni_mutex_unlock(&loop->lock);
+    return 0;
+}
+
+int32_t omni_event_loop_modify(omni_event_loop_t* loop, int32_t fd, int32_t events) {
+    if (!loop) return -1;
+    omni_mutex_lock(&loop->lock);
+    omni_io_watch_t* watch = omni_ev_watch(loop, fd, 0);
+    if (!watch || !watch->callback) {
+        omni_mutex_unlock(&loop->lock);
+        return -1;
+    }
+    int32_t old_events = watch->events;
+    watch->events = 0;
+    if (omni_ev_apply(loop, fd, watch, old_events, events) != 0) {
+        omni_mutex_unlock(&loop->lock);
+        return -1;
+    }
+    watch->events = events;
+    omni_mutex_unlock(&loop->lock);
+    return 0;
+}
+
+// Removes fd's watch; returns its callback and stores its argument and
+// armed events, or returns NULL if fd had none. The caller owns the
+// argument of a watch that was still armed.
+static omni_io_callback_t omni_ev_detach(omni_event_loop_t* loop, int32_t fd, void** arg, int32_t* events) {
+    omni_mutex_lock(&loop->lock);
+    omni_io_watch_t* watch = omni_ev_watch(loop, fd, 0);
+    omni_io_callback_t callback = watch ? watch->callback : NULL;
+    if (callback) {
+        *arg = watch->arg;
+        *events = watch->events;
+        omni_ev_apply(loop, fd, watch, watch->events, 0);
+        memset(watch, 0, sizeof(*watch));
+    }
+    omni_mutex_unlock(&loop->lock);
+    return callback;
+}
+
+int32_t omni_event_loop_remove(omni_event_loop_t* loop, int32_t fd) {
+    if (!loop) return -1;
+    void* arg;
+    int32_t events;
+    return omni_ev_detach(loop, fd, &arg, &events) ? 0 : -1;
+}
+
+// Runs fd's callback for the ready events, disarming a oneshot watch first
+// so that only one thread ever owns its argument
+static int omni_ev_dispatch(omni_event_loop_t* loop, int fd, int32_t ready) {
+    omni_mutex_lock(&loop->lock);
+    omni_io_watch_t* watch = omni_ev_watch(loop, fd, 0);
+    if (!watch || !watch->events) {
+        omni_mutex_unlock(&loop->lock);
+        return 0;
+    }
+    int32_t wanted = watch->events & (OMNI_EV_READ | OMNI_EV_WRITE);
+    if (ready & OMNI_EV_ERROR) {
+        // Let the callback discover the error from its next operation
+        ready |= wanted;
+    }
+    ready &= wanted | OMNI_EV_ERROR;
+    if (!ready) {
+        omni_mutex_unlock(&loop->lock);
+        return 0;
+    }
+    if (watch->events & OMNI_EV_ONESHOT) {
+#ifdef OMNI_EV_KQUEUE
+        // The filter that fired is gone; drop the other direction too
+        omni_ev_apply(loop, fd, watch, watch->events, 0);
+#endif
+        watch->events = 0;
+    }
+    omni_io_callback_t callback = watch->callback;
+    void* arg = watch->arg;
+    omni_mutex_unlock(&loop->lock);
+    callback(loop, fd, ready, arg);
+    return 1;
+}
+
+int32_t omni_event_loop_run_once(omni_event_loop_t* loop, int32_t timeout_ms) {
+    if (!loop) return -1;
+    int32_t dispatched = 0;
+#if defined(OMNI_EV_EPOLL)
+    struct epoll_event events[OMNI_EV_BATCH];
+    int n = epoll_wait(loop->fd, events, OMNI_EV_BATCH, timeout_ms < 0 ? -1 : timeout_ms);
+    if (n < 0) return errno == EINTR ? 0 : -1;
+    for (int i = 0; i < n; i++) {
+        int fd = events[i].data.fd;
+        if (fd == loop->wake[0]) {
+            omni_ev_drain(loop);
+            continue;
+        }
+        int32_t ready = 0;
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP)) ready |= OMNI_EV_READ;
+        if (events[i].events & EPOLLOUT) ready |= OMNI_EV_WRITE;
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) ready |= OMNI_EV_ERROR;
+        dispatched += omni_ev_dispatch(loop, fd, ready);
+    }
+#elif defined(OMNI_EV_KQUEUE)
+    struct kevent events[OMNI_EV_BATCH];
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+    int n = kevent(loop->fd, NULL, 0, events, OMNI_EV_BATCH, timeout_ms < 0 ? NULL : &timeout);
+    if (n < 0) return errno == EINTR ? 0 : -1;
+    for (int i = 0; i < n; i++) {
+        int fd = (int)events[i].ident;
+        if (fd == loop->wake[0]) {
+            omni_ev_drain(loop);
+            continue;
+        }
+        int32_t ready = events[i].filter == EVFILT_WRITE ? OMNI_EV_WRITE : OMNI_EV_READ;
+        if (events[i].flags & (EV_EOF | EV_ERROR)) ready |= OMNI_EV_ERROR;
+        dispatched += omni_ev_dispatch(loop, fd, ready);
+    }
+#else
+    // Snapshot the armed watches; changes made during the wait wake it
+    omni_mutex_lock(&loop->lock);
+    nfds_t count = 1;
+    for (int32_t fd = 0; fd < loop->capacity; fd++) {
+        if (loop->watches[fd].events) count++;
+    }
+    struct pollfd* fds = (struct pollfd*)malloc(count * sizeof(struct pollfd));
+    if (!fds) {
+        omni_mutex_unlock(&loop->lock);
+        return -1;
+    }
+    fds[0].fd = loop->wake[0];
+    fds[0].events = POLLIN;
+    nfds_t used = 1;
+    for (int32_t fd = 0; fd < loop->capacity; fd++) {
+        int32_t events = loop->watches[fd].events;
+        if (!events) continue;
+        fds[used].fd = fd;
+        fds[used].events = (short)(((events & OMNI_EV_READ) ? POLLIN : 0) | ((events & OMNI_EV_WRITE) ? POLLOUT : 0));
+        used++;
+    }
+    omni_mutex_unlock(&loop->lock);
+    int n = poll(fds, used, timeout_ms < 0 ? -1 : timeout_ms);
+    if (n < 0) {
+        free(fds);
+        return errno == EINTR ? 0 : -1;
+    }
+    if (fds[0].revents) omni_ev_drain(loop);
+    for (nfds_t i = 1; i < used; i++) {
+        short revents = fds[i].revents;
+        if (!revents) continue;
+        int32_t ready = 0;
+        if (revents & POLLIN) ready |= OMNI_EV_READ;
+        if (revents & POLLOUT) ready |= OMNI_EV_WRITE;
+        if (revents & (POLLERR | POLLHUP | POLLNVAL)) ready |= OMNI_EV_ERROR;
+        dispatched += omni_ev_dispatch(loop, fds[i].fd, ready);
+    }
+    free(fds);
+#endif
+    return dispatched;
+}
+
+int32_t omni_event_loop_run(omni_event_loop_t* loop) {
+    if (!loop) return -1;
+    int32_t result = 0;
+    while (!__atomic_load_n(&loop->stopped, __ATOMIC_ACQUIRE)) {
+        if (omni_event_loop_run_once(loop, -1) < 0) {
+            result = -1;
+            break;
+        }
+    }
+    __atomic_store_n(&loop->stopped, 0, __ATOMIC_RELEASE);
+    return result;
+}
+
+void omni_event_loop_stop(omni_event_loop_t* loop) {
+    if (!loop) return;
+    __atomic_store_n(&loop->stopped, 1, __ATOMIC_RELEASE);
+    omni_ev_wake(loop);
+}
+
+#endif
+
+// Asynchronous sockets
+// Operations first try the non-blocking call; only if it would block do they
+// arm a oneshot watch on the shared loop, whose thread then retries the call
+// and resolves the promise. Without an event loop they run as blocking
+// scheduler tasks instead.
+
+enum {
+    OMNI_IO_WAIT,
+    OMNI_IO_ACCEPT,
+    OMNI_IO_RECEIVE,
+    OMNI_IO_SEND,
+};
+
+typedef struct {
+    omni_promise_t* promise;
+    int32_t kind;
+    int32_t fd;
+    int32_t events;  // Direction waited for
+    char* data;      // Receive buffer or copy of the data to send
+    int64_t len;
+    int64_t done;    // Bytes sent so far
+} omni_io_op_t;
+
+static omni_event_loop_t* omni_io_loop = NULL;
+static int32_t omni_io_loop_failed = 0;
+static omni_mutex_t omni_io_mutex = OMNI_MUTEX_INIT;
+
+static void omni_io_loop_main(void* arg) {
+    omni_event_loop_run((omni_event_loop_t*)arg);
+}
+
+// Returns the shared loop, starting its thread on first use, or NULL if the
+// platform has none
+static omni_event_loop_t* omni_io_loop_get(void) {
+    omni_event_loop_t* loop = OMNI_LOAD_ACQUIRE(&omni_io_loop);
+    if (loop || OMNI_LOAD_ACQUIRE(&omni_io_loop_failed)) return loop;
+    omni_mutex_lock(&omni_io_mutex);
+    loop = omni_io_loop;
+    if (!loop && !omni_io_loop_failed) {
+        loop = omni_event_loop_create();
+        if (loop && omni_thread_spawn(omni_io_loop_main, loop) != 0) {
+            omni_event_loop_destroy(loop);
+            loop = NULL;
+        }
+        if (loop) {
+            OMNI_STORE_RELEASE(&omni_io_loop, loop);
+        } else {
+            OMNI_STORE_RELEASE(&omni_io_loop_failed, 1);
+        }
+    }
+    omni_mutex_unlock(&omni_io_mutex);
+    return loop;
+}
+
+static omni_io_op_t* omni_io_op_new(int32_t kind, int32_t type, int32_t fd, int32_t events) {
+    omni_io_op_t* op = (omni_io_op_t*)calloc(1, sizeof(omni_io_op_t));
+    if (!op) return NULL;
+    op->promise = omni_promise_new(type);
+    if (!op->promise) {
+        free(op);
+        return NULL;
+    }
+    op->promise->external = 1;
+    op->kind = kind;
+    op->fd = fd;
+    op->events = events;
+    return op;
+}
+
+static void omni_io_op_free(omni_io_op_t* op) {
+    omni_promise_free(op->promise);
+    free(op->data);
+    free(op);
+}
+
+// Resolves op as failed and releases it
+static void omni_io_fail(omni_io_op_t* op) {
+    if (op->kind == OMNI_IO_RECEIVE) {
+        omni_promise_resolve_string(op->promise, "");
+    } else {
+        omni_promise_resolve_int(op->promise, -1);
+    }
+    omni_io_op_free(op);
+}
+
+static int omni_io_would_block(void) {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+// Performs op; returns 1 once it has resolved (op is released), 0 if it
+// would block. blocking selects blocking calls for the fallback path.
+static int omni_io_attempt(omni_io_op_t* op, int blocking) {
+    switch (op->kind) {
+    case OMNI_IO_WAIT:
+        omni_promise_resolve_int(op->promise, op->events);
+        break;
+    case OMNI_IO_ACCEPT: {
+        int32_t client = omni_socket_accept(op->fd);
+        if (client < 0) {
+#ifdef ECONNABORTED
+            if (!blocking && (omni_io_would_block() || errno == ECONNABORTED)) return 0;
+#else
+            if (!blocking && omni_io_would_block()) return 0;
+#endif
+        }
+        omni_promise_resolve_int(op->promise, client);
+        break;
+    }
+    case OMNI_IO_RECEIVE: {
+#ifdef _WIN32
+        int n = recv(op->fd, op->data, (int)op->len, 0);
+#else
+        ssize_t n = recv(op->fd, op->data, (size_t)op->len, blocking ? 0 : MSG_DONTWAIT);
+#endif
+        if (n < 0) {
+            if (!blocking && omni_io_would_block()) return 0;
+            n = 0;
+        }
+        op->data[n] = '\0';
+        omni_promise_resolve_string_owned(op->promise, op->data);
+        op->data = NULL;
+        break;
+    }
+    case OMNI_IO_SEND:
+        while (op->done < op->len) {
+            int64_t chunk = op->len - op->done;
+            if (chunk > INT_MAX) chunk = INT_MAX;
+#ifdef _WIN32
+            int n = send(op->fd, op->data + op->done, (int)chunk, 0);
+#else
+            ssize_t n = send(op->fd, op->data + op->done, (size_t)chunk, MSG_NOSIGNAL | (blocking ? 0 : MSG_DONTWAIT));
+#endif
+            if (n < 0) {
+                if (omni_io_would_block()) {
+                    if (!blocking) return 0;
+                    continue;
+                }
+                break;
+            }
+            op->done += n;
+        }
+        omni_promise_resolve_int(op->promise, op->done == op->len ? (int32_t)(op->done > INT32_MAX ? INT32_MAX : op->done) : -1);
+        break;
+    }
+    omni_io_op_free(op);
+    return 1;
+}
+
+static void omni_io_ready(omni_event_loop_t* loop, int32_t fd, int32_t events, void* arg) {
+    omni_io_op_t* op = (omni_io_op_t*)arg;
+    if (op->kind == OMNI_IO_WAIT) op->events = events;
+    if (omni_io_attempt(op, 0)) return;
+    // Spurious wakeup (or another acceptor won the connection): wait again
+    if ((events & OMNI_EV_ERROR) || omni_event_loop_modify(loop, fd, op->events | OMNI_EV_ONESHOT) != 0) {
+        omni_io_fail(op);
+    }
+}
+
+static void omni_io_blocking_task(void* arg) {
+    omni_io_attempt((omni_io_op_t*)arg, 1);
+}
+
+// Starts op and returns its promise
+static omni_promise_t* omni_io_submit(omni_io_op_t* op) {
+    omni_promise_t* promise = omni_promise_retain(op->promise);
+    omni_event_loop_t* loop = omni_io_loop_get();
+    if (!loop) {
+        omni_task_spawn(omni_io_blocking_task, op);
+        return promise;
+    }
+    if (op->kind != OMNI_IO_WAIT && omni_io_attempt(op, 0)) return promise;
+    if (omni_event_loop_add(loop, op->fd, op->events | OMNI_EV_ONESHOT, omni_io_ready, op) != 0) {
+        omni_io_fail(op);
+    }
+    return promise;
+}
+
+omni_promise_t* omni_socket_wait_async(int32_t socket, int32_t events) {
+    events &= OMNI_EV_READ | OMNI_EV_WRITE;
+    if (socket < 0 || !events) return omni_promise_create_int(-1);
+    omni_io_op_t* op = omni_io_op_new(OMNI_IO_WAIT, OMNI_PROMISE_INT, socket, events);
+    if (!op) return omni_promise_create_int(-1);
+    return omni_io_submit(op);
+}
+
+omni_promise_t* omni_socket_accept_async(int32_t socket) {
+    if (socket < 0) return omni_promise_create_int(-1);
+    // A ready listener may still have its connection taken by another
+    // acceptor, so accept must not block the loop thread
+    if (omni_io_loop_get()) omni_socket_set_nonblocking(socket, 1);
+    omni_io_op_t* op = omni_io_op_new(OMNI_IO_ACCEPT, OMNI_PROMISE_INT, socket, OMNI_EV_READ);
+    if (!op) return omni_promise_create_int(-1);
+    return omni_io_submit(op);
+}
+
+omni_promise_t* omni_socket_receive_async(int32_t socket, int32_t max_len) {
+    if (socket < 0 || max_len <= 0) return omni_promise_create_string("");
+    omni_io_op_t* op = omni_io_op_new(OMNI_IO_RECEIVE, OMNI_PROMISE_STRING, socket, OMNI_EV_READ);
+    if (!op) return omni_promise_create_string("");
+    op->len = max_len;
+    op->data = (char*)malloc((size_t)max_len + 1);
+    if (!op->data) {
+        omni_io_fail(op);
+        return omni_promise_create_string("");
+    }
+    return omni_io_submit(op);
+}
+
+omni_promise_t* omni_socket_send_bytes_async(int32_t socket, const void* data, int64_t len) {
+    if (socket < 0 || len < 0 || (!data && len > 0)) return omni_promise_create_int(-1);
+    omni_io_op_t* op = omni_io_op_new(OMNI_IO_SEND, OMNI_PROMISE_INT, socket, OMNI_EV_WRITE);
+    if (!op) return omni_promise_create_int(-1);
+    op->len = len;
+    op->data = (char*)malloc(len > 0 ? (size_t)len : 1);
+    if (!op->data) {
+        omni_io_fail(op);
+        return omni_promise_create_int(-1);
+    }
+    if (len > 0) memcpy(op->data, data, (size_t)len);
+    return omni_io_submit(op);
+}
+
+omni_promise_t* omni_socket_send_async(int32_t socket, const char* data) {
+    if (!data) return omni_promise_create_int(-1);
+    return omni_socket_send_bytes_async(socket, data, (int64_t)strlen(data));
+}
+
+int32_t omni_socket_close(int32_t socket) {
+    if (socket < 0) return 0;
+    // Fail an operation still waiting on the socket before its descriptor
+    // can be reused
+    omni_event_loop_t* loop = OMNI_LOAD_ACQUIRE(&omni_io_loop);
+    if (loop) {
+        void* arg;
+        int32_t events;
+        omni_io_callback_t callback = omni_ev_detach(loop, socket, &arg, &events);
+        if (callback == omni_io_ready && events) omni_io_fail((omni_io_op_t*)arg);
+    }
+#ifdef _WIN32
+    return (closesocket(socket) == 0) ? 1 : 0;
+#else
+    return (close(socket) == 0) ? 1 : 0;
+#endif
+}
+
+// ============================================================================
+// DNS Resolver
+// ============================================================================
+// Lookups are answered from a cache that keeps a name's addresses for the
+// TTL of its records, and a failed lookup for the negative TTL of the zone's
+// SOA record. Misses ask the nameservers in /etc/resolv.conf directly over
+// UDP, for the A and AAAA records at once. Names found in /etc/hosts, names
+// without a dot (which need the search list), truncated answers and
+// systems without nameservers fall back to getaddrinfo. Concurrent lookups
+// of one name share a single query.
+
+#ifdef _WIN32
+
+static int32_t omni_dns_resolve(const char* hostname, omni_dns_addr_t* out) {
+    (void)hostname;
+    (void)out;
+    return 0;
+}
+
+omni_ip_address_t** omni_dns_lookup(const char* hostname, int32_t* count) {
+    (void)hostname;
+    if (count) *count = 0;
+    return NULL;
+}
+
+omni_promise_t* omni_dns_lookup_async(const char* hostname) {
+    (void)hostname;
+    return omni_promise_create_string("");
+}
+
+char* omni_dns_reverse_lookup(omni_ip_address_t* ip) {
+    if (!ip) return NULL;
+    return strdup("");
+}
+
+void omni_dns_cache_clear(void) {
+}
+
+#else
+
+#include <poll.h>
+
+#define OMNI_DNS_CACHE_BUCKETS 256
+#define OMNI_DNS_CACHE_LIMIT 4096     // Entries cached at most
+#define OMNI_DNS_MAX_SERVERS 3
+#define OMNI_DNS_MAX_TTL 3600         // Seconds; longer TTLs are capped
+#define OMNI_DNS_NEGATIVE_TTL 30      // For a failed lookup without an SOA record
+#define OMNI_DNS_MAX_NEGATIVE_TTL 300
+#define OMNI_DNS_FAILURE_TTL 5        // When no nameserver answered
+#define OMNI_DNS_FALLBACK_TTL 30      // getaddrinfo and /etc/hosts carry no TTL
+#define OMNI_DNS_TYPE_A 1
+#define OMNI_DNS_TYPE_SOA 6
+#define OMNI_DNS_TYPE_AAAA 28
+
+static int64_t omni_net_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Waits up to timeout_ms until fd is ready for events; returns 1 when it
+// is, 0 on timeout or error. A pool thread has a spare thread run tasks in
+// its place while it waits.
+static int omni_net_wait(int fd, short events, int64_t timeout_ms) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+    int n = poll(&pfd, 1, 0);
+    if (n < 0 && errno == EINTR) n = 0;
+    if (n == 0) {
+        int spare = omni_sched_blocking();
+        int64_t deadline = omni_net_now_ms() + timeout_ms;
+        do {
+            int64_t left = deadline - omni_net_now_ms();
+            if (left <= 0) {
+                n = 0;
+                break;
+            }
+            n = poll(&pfd, 1, (int)left);
+        } while (n < 0 && errno == EINTR);
+        omni_sched_unblocked(spare);
+    }
+    return n > 0;
+}
+
+typedef struct {
+    int32_t count;  // 0 when the name has no addresses
+    omni_dns_addr_t addrs[OMNI_DNS_MAX_ADDRS];
+    uint32_t ttl;   // Seconds
+} omni_dns_answer_t;
+
+enum {
+    OMNI_DNS_PENDING, // Being looked up; waiters sleep on omni_dns_cond
+    OMNI_DNS_READY,
+};
+
+typedef struct omni_dns_entry {
+    char name[256];     // Lower-cased, without a trailing dot
+    uint32_t hash;
+    int32_t state;
+    int64_t expires;    // Monotonic milliseconds
+    omni_dns_answer_t answer;
+    struct omni_dns_entry* next;
+} omni_dns_entry_t;
+
+static omni_dns_entry_t* omni_dns_cache[OMNI_DNS_CACHE_BUCKETS];
+static int32_t omni_dns_cache_size = 0;
+static omni_mutex_t omni_dns_mutex = OMNI_MUTEX_INIT;
+static omni_cond_t omni_dns_cond = OMNI_COND_INIT;
+
+static void omni_dns_add(omni_dns_answer_t* answer, int32_t family, const void* bytes) {
+    if (answer->count >= OMNI_DNS_MAX_ADDRS) return;
+    omni_dns_addr_t* addr = &answer->addrs[answer->count++];
+    memset(addr, 0, sizeof(*addr));
+    addr->family = family;
+    memcpy(addr->bytes, bytes, family == AF_INET ? 4 : 16);
+}
+
+// Adds the addresses /etc/hosts lists for name; returns whether it has any
+static int omni_dns_from_hosts(const char* name, omni_dns_answer_t* answer) {
+    FILE* file = fopen("/etc/hosts", "r");
+    if (!file) return 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "#\n")] = '\0';
+        char* save = NULL;
+        char* address = strtok_r(line, " \t", &save);
+        if (!address) continue;
+        unsigned char bytes[16];
+        int32_t family = AF_INET;
+        if (inet_pton(AF_INET, address, bytes) != 1) {
+            if (inet_pton(AF_INET6, address, bytes) != 1) continue;
+            family = AF_INET6;
+        }
+        char* alias;
+        while ((alias = strtok_r(NULL, " \t", &save)) != NULL) {
+            if (strcasecmp(alias, name) == 0) {
+                omni_dns_add(answer, family, bytes);
+                break;
+            }
+        }
+    }
+    fclose(file);
+    answer->ttl = OMNI_DNS_FALLBACK_TTL;
+    return answer->count > 0;
+}
+
+static void omni_dns_from_getaddrinfo(const char* name, omni_dns_answer_t* answer) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* list = NULL;
+    int spare = omni_sched_blocking();
+    int rc = getaddrinfo(name, NULL, &hints, &list);
+    omni_sched_unblocked(spare);
+    if (rc != 0) {
+        answer->ttl = rc == EAI_NONAME ? OMNI_DNS_NEGATIVE_TTL : OMNI_DNS_FAILURE_TTL;
+        return;
+    }
+    for (struct addrinfo* ai = list; ai; ai = ai->ai_next) {
+        if (ai->ai_family == AF_INET) {
+            omni_dns_add(answer, AF_INET, &((struct sockaddr_in*)ai->ai_addr)->sin_addr);
+        } else if (ai->ai_family == AF_INET6) {
+            omni_dns_add(answer, AF_INET6, &((struct sockaddr_in6*)ai->ai_addr)->sin6_addr);
+        }
+    }
+    freeaddrinfo(list);
+    answer->ttl = OMNI_DNS_FALLBACK_TTL;
+}
+
+typedef struct {
+    struct sockaddr_storage servers[OMNI_DNS_MAX_SERVERS];
+    socklen_t server_lens[OMNI_DNS_MAX_SERVERS];
+    int32_t count;
+    int32_t timeout_ms; // Per attempt and server
+    int32_t attempts;
+} omni_dns_config_t;
+
+// Reads the nameservers and the timeout:/attempts: options from
+// /etc/resolv.conf (the defaults match the C library's)
+static void omni_dns_read_config(omni_dns_config_t* config) {
+    config->count = 0;
+    config->timeout_ms = 5000;
+    config->attempts = 2;
+    FILE* file = fopen("/etc/resolv.conf", "r");
+    if (!file) return;
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "#;\n")] = '\0';
+        char* save = NULL;
+        char* key = strtok_r(line, " \t", &save);
+        if (!key) continue;
+        char* value;
+        if (strcmp(key, "nameserver") == 0 && (value = strtok_r(NULL, " \t", &save)) != NULL &&
+            config->count < OMNI_DNS_MAX_SERVERS) {
+            struct sockaddr_storage* server = &config->servers[config->count];
+            memset(server, 0, sizeof(*server));
+            struct sockaddr_in* in4 = (struct sockaddr_in*)server;
+            struct sockaddr_in6* in6 = (struct sockaddr_in6*)server;
+            if (inet_pton(AF_INET, value, &in4->sin_addr) == 1) {
+                in4->sin_family = AF_INET;
+                in4->sin_port = htons(53);
+                config->server_lens[config->count++] = sizeof(*in4);
+            } else if (inet_pton(AF_INET6, value, &in6->sin6_addr) == 1) {
+                in6->sin6_family = AF_INET6;
+                in6->sin6_port = htons(53);
+                config->server_lens[config->count++] = sizeof(*in6);
+            }
+        } else if (strcmp(key, "options") == 0) {
+            while ((value = strtok_r(NULL, " \t", &save)) != NULL) {
+                if (strncmp(value, "timeout:", 8) == 0 && atoi(value + 8) > 0) {
+                    config->timeout_ms = atoi(value + 8) * 1000;
+                } else if (strncmp(value, "attempts:", 9) == 0 && atoi(value + 9) > 0) {
+                    config->attempts = atoi(value + 9);
+                }
+            }
+        }
+    }
+    fclose(file);
+}
+
+// Query IDs need only be unpredictable enough to make spoofed replies miss
+static uint16_t omni_dns_query_id(void) {
+    static OMNI_THREAD_LOCAL uint64_t state = 0;
+    if (state == 0) state = (uint64_t)omni_net_now_ms() ^ ((uint64_t)(uintptr_t)&state << 16) ^ (uint64_t)getpid();
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (uint16_t)(state >> 32);
+}
+
+// Encodes a recursive query for name; returns its length, 0 if name is not
+// a valid domain name
+static size_t omni_dns_build_query(unsigned char* buf, uint16_t id, const char* name, uint16_t type) {
+    memset(buf, 0, 12);
+    buf[0] = (unsigned char)(id >> 8);
+    buf[1] = (unsigned char)id;
+    buf[2] = 0x01; // Recursion desired
+    buf[5] = 1;    // One question
+    size_t pos = 12;
+    while (*name) {
+        size_t len = strcspn(name, ".");
+        if (len == 0 || len > 63) return 0;
+        buf[pos++] = (unsigned char)len;
+        memcpy(buf + pos, name, len);
+        pos += len;
+        name += len;
+        if (*name == '.') name++;
+    }
+    buf[pos++] = 0;
+    buf[pos++] = (unsigned char)(type >> 8);
+    buf[pos++] = (unsigned char)type;
+    buf[pos++] = 0;
+    buf[pos++] = 1; // Class IN
+    return pos;
+}
+
+// Returns the offset just past the (possibly compressed) name at pos, or 0
+static size_t omni_dns_skip_name(const unsigned char* msg, size_t len, size_t pos) {
+    while (pos < len) {
+        unsigned char label = msg[pos];
+        if (label == 0) return pos + 1;
+        if ((label & 0xC0) == 0xC0) return pos + 2 <= len ? pos + 2 : 0;
+        if (label & 0xC0) return 0;
+        pos += (size_t)label + 1;
+    }
+    return 0;
+}
+
+static uint32_t omni_dns_read32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Parses the reply to a query of the given id and type, adding its addresses
+// to answer. *ttl is lowered to the TTL of every answer record, and
+// *negative_ttl to that of an SOA record in the authority section. Returns
+// the response code, or -1 if msg is not a well-formed reply to the query.
+static int omni_dns_parse(const unsigned char* msg, size_t len, uint16_t id, uint16_t type,
+                          omni_dns_answer_t* answer, uint32_t* ttl, uint32_t* negative_ttl, int* truncated) {
+    if (len < 12 || ((uint16_t)(msg[0] << 8) | msg[1]) != id || !(msg[2] & 0x80)) return -1;
+    *truncated = (msg[2] & 0x02) != 0;
+    int rcode = msg[3] & 0x0F;
+    size_t questions = ((size_t)msg[4] << 8) | msg[5];
+    size_t answers = ((size_t)msg[6] << 8) | msg[7];
+    size_t authority = ((size_t)msg[8] << 8) | msg[9];
+    if (questions != 1) return -1;
+    size_t pos = omni_dns_skip_name(msg, len, 12);
+    if (pos == 0 || pos + 4 > len || (((uint16_t)(msg[pos] << 8) | msg[pos + 1]) != type)) return -1;
+    pos += 4;
+    for (size_t i = 0; i < answers + authority; i++) {
+        pos = omni_dns_skip_name(msg, len, pos);
+        if (pos == 0 || pos + 10 > len) return -1;
+        uint16_t rtype = (uint16_t)((msg[pos] << 8) | msg[pos + 1]);
+        uint32_t rttl = omni_dns_read32(msg + pos + 4);
+        size_t rdlen = ((size_t)msg[pos + 8] << 8) | msg[pos + 9];
+        pos += 10;
+        if (pos + rdlen > len) return -1;
+        if (rttl > 0x7FFFFFFF) rttl = 0;
+        if (i < answers) {
+            // Includes the CNAME records leading to the addresses
+            if (rttl < *ttl) *ttl = rttl;
+            if (rtype == OMNI_DNS_TYPE_A && type == OMNI_DNS_TYPE_A && rdlen == 4) {
+                omni_dns_add(answer, AF_INET, msg + pos);
+            } else if (rtype == OMNI_DNS_TYPE_AAAA && type == OMNI_DNS_TYPE_AAAA && rdlen == 16) {
+                omni_dns_add(answer, AF_INET6, msg + pos);
+            }
+        } else if (rtype == OMNI_DNS_TYPE_SOA && rdlen >= 20) {
+            // The SOA's last field is the zone's negative TTL
+            uint32_t minimum = omni_dns_read32(msg + pos + rdlen - 4);
+            if (minimum < rttl) rttl = minimum;
+            if (rttl < *negative_ttl) *negative_ttl = rttl;
+        }
+        pos += rdlen;
+    }
+    return rcode;
+}
+
+// Asks the configured nameservers for name's A and AAAA records. Returns 1
+// with answer filled in, addresses or not, or 0 when getaddrinfo should be
+// asked instead.
+static int omni_dns_query(const char* name, omni_dns_answer_t* answer) {
+    static const uint16_t types[2] = {OMNI_DNS_TYPE_A, OMNI_DNS_TYPE_AAAA};
+    omni_dns_config_t config;
+    omni_dns_read_config(&config);
+    if (config.count == 0) return 0;
+
+    for (int32_t attempt = 0; attempt < config.attempts; attempt++) {
+        for (int32_t s = 0; s < config.count; s++) {
+            struct sockaddr* server = (struct sockaddr*)&config.servers[s];
+            int fd = socket(server->sa_family, SOCK_DGRAM, 0);
+            if (fd < 0) continue;
+            omni_socket_set_nonblocking(fd, 1);
+            // A connected socket only receives replies from the server
+            if (connect(fd, server, config.server_lens[s]) != 0) {
+                close(fd);
+                continue;
+            }
+            unsigned char query[2][300];
+            size_t query_len[2];
+            uint16_t ids[2];
+            int sent = 1;
+            for (int q = 0; q < 2; q++) {
+                ids[q] = omni_dns_query_id();
+                query_len[q] = omni_dns_build_query(query[q], ids[q], name, types[q]);
+                if (query_len[q] == 0) {
+                    close(fd);
+                    answer->ttl = OMNI_DNS_NEGATIVE_TTL;
+                    return 1;
+                }
+                if (send(fd, query[q], query_len[q], 0) != (ssize_t)query_len[q]) sent = 0;
+            }
+
+            int replied[2] = {0, 0};
+            int failed = !sent;
+            int nxdomain = 0;
+            uint32_t ttl = OMNI_DNS_MAX_TTL;
+            uint32_t negative_ttl = OMNI_DNS_NEGATIVE_TTL;
+            int64_t deadline = omni_net_now_ms() + config.timeout_ms;
+            while (!failed && !nxdomain && !(replied[0] && replied[1])) {
+                int64_t left = deadline - omni_net_now_ms();
+                if (left <= 0 || !omni_net_wait(fd, POLLIN, left)) break;
+                unsigned char reply[1232];
+                ssize_t n = recv(fd, reply, sizeof(reply), 0);
+                if (n < 0) {
+                    // ECONNREFUSED: nothing listens on the server
+                    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) failed = 1;
+                    continue;
+                }
+                for (int q = 0; q < 2; q++) {
+                    if (replied[q]) continue;
+                    int truncated = 0;
+                    int rcode = omni_dns_parse(reply, (size_t)n, ids[q], types[q], answer, &ttl, &negative_ttl, &truncated);
+                    if (rcode < 0) continue;
+                    if (truncated) {
+                        // The full answer needs TCP, which getaddrinfo speaks
+                        close(fd);
+                        answer->count = 0;
+                        return 0;
+                    }
+                    if (rcode == 3) {
+                        nxdomain = 1;
+                    } else if (rcode != 0) {
+                        // SERVFAIL, REFUSED: ask the next server
+                        failed = 1;
+                    }
+                    replied[q] = 1;
+                    break;
+                }
+            }
+            close(fd);
+            if (!failed && (nxdomain || replied[0] || replied[1])) {
+                if (nxdomain) answer->count = 0;
+                if (answer->count > 0) {
+                    answer->ttl = ttl;
+                } else {
+                    answer->ttl = negative_ttl < OMNI_DNS_MAX_NEGATIVE_TTL ? negative_ttl : OMNI_DNS_MAX_NEGATIVE_TTL;
+                }
+                return 1;
+            }
+            answer->count = 0;
+        }
+    }
+    answer->ttl = OMNI_DNS_FAILURE_TTL;
+    return 1;
+}
+
+static void omni_dns_lookup_name(const char* name, omni_dns_answer_t* answer) {
+    memset(answer, 0, sizeof(*answer));
+    if (omni_dns_from_hosts(name, answer)) return;
+    if (strchr(name, '.') && omni_dns_query(name, answer)) return;
+    omni_dns_from_getaddrinfo(name, answer);
+}
+
+static omni_dns_entry_t** omni_dns_find(const char* name, uint32_t hash) {
+    omni_dns_entry_t** link = &omni_dns_cache[hash % OMNI_DNS_CACHE_BUCKETS];
+    while (*link && !((*link)->hash == hash && strcmp((*link)->name, name) == 0)) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+// Drops entries that have expired (all settled ones when everything is set)
+static void omni_dns_evict(int everything) {
+    int64_t now = omni_net_now_ms();
+    for (int32_t b = 0; b < OMNI_DNS_CACHE_BUCKETS; b++) {
+        omni_dns_entry_t** link = &omni_dns_cache[b];
+        while (*link) {
+            omni_dns_entry_t* entry = *link;
+            if (entry->state == OMNI_DNS_READY && (everything || entry->expires <= now)) {
+                *link = entry->next;
+                free(entry);
+                omni_dns_cache_size--;
+            } else {
+                link = &entry->next;
+            }
+        }
+    }
+}
+
+// Resolves hostname (or parses a numeric address) into out, which has room
+// for OMNI_DNS_MAX_ADDRS; returns the count, 0 if it has no addresses
+static int32_t omni_dns_resolve(const char* hostname, omni_dns_addr_t* out) {
+    memset(&out[0], 0, sizeof(out[0]));
+    if (inet_pton(AF_INET, hostname, out[0].bytes) == 1) {
+        out[0].family = AF_INET;
+        return 1;
+    }
+    if (inet_pton(AF_INET6, hostname, out[0].bytes) == 1) {
+        out[0].family = AF_INET6;
+        return 1;
+    }
+    char name[256];
+    size_t len = strlen(hostname);
+    if (len > 0 && hostname[len - 1] == '.') len--;
+    if (len == 0 || len > 253) return 0;
+    for (size_t i = 0; i < len; i++) name[i] = (char)tolower((unsigned char)hostname[i]);
+    name[len] = '\0';
+    uint32_t hash = hash_string(name, NULL);
+
+    omni_dns_answer_t answer;
+    omni_dns_entry_t* entry = NULL;
+    omni_mutex_lock(&omni_dns_mutex);
+    for (;;) {
+        entry = *omni_dns_find(name, hash);
+        if (!entry) break;
+        if (entry->state == OMNI_DNS_PENDING) {
+            int spare = omni_sched_blocking();
+            omni_cond_wait(&omni_dns_cond, &omni_dns_mutex);
+            omni_sched_unblocked(spare);
+            continue;
+        }
+        if (entry->expires > omni_net_now_ms()) {
+            answer = entry->answer;
+            omni_mutex_unlock(&omni_dns_mutex);
+            memcpy(out, answer.addrs, (size_t)answer.count * sizeof(omni_dns_addr_t));
+            return answer.count;
+        }
+        break;
+    }
+    // This thread looks the name up; others asking meanwhile wait for it
+    if (!entry) {
+        if (omni_dns_cache_size >= OMNI_DNS_CACHE_LIMIT) omni_dns_evict(0);
+        if (omni_dns_cache_size < OMNI_DNS_CACHE_LIMIT) {
+            entry = (omni_dns_entry_t*)calloc(1, sizeof(omni_dns_entry_t));
+        }
+        if (entry) {
+            memcpy(entry->name, name, len + 1);
+            entry->hash = hash;
+            omni_dns_entry_t** link = &omni_dns_cache[hash % OMNI_DNS_CACHE_BUCKETS];
+            entry->next = *link;
+            *link = entry;
+            omni_dns_cache_size++;
+        }
+    }
+    if (entry) entry->state = OMNI_DNS_PENDING;
+    omni_mutex_unlock(&omni_dns_mutex);
+
+    omni_dns_lookup_name(name, &answer);
+    if (answer.ttl > OMNI_DNS_MAX_TTL) answer.ttl = OMNI_DNS_MAX_TTL;
+
+    if (entry) {
+        omni_mutex_lock(&omni_dns_mutex);
+        entry->answer = answer;
+        entry->expires = omni_net_now_ms() + (int64_t)answer.ttl * 1000;
+        entry->state = OMNI_DNS_READY;
+        omni_cond_broadcast(&omni_dns_cond);
+        omni_mutex_unlock(&omni_dns_mutex);
+    }
+    memcpy(out, answer.addrs, (size_t)answer.count * sizeof(omni_dns_addr_t));
+    return answer.count;
+}
+
+omni_ip_address_t** omni_dns_lookup(const char* hostname, int32_t* count) {
+    if (!hostname || !count) return NULL;
+    *count = 0;
+    omni_dns_addr_t addrs[OMNI_DNS_MAX_ADDRS];
+    int32_t n = omni_dns_resolve(hostname, addrs);
+    if (n == 0) return NULL;
+    // One block: the pointer array, then the addresses it points to
+    omni_ip_address_t** result = (omni_ip_address_t**)malloc((size_t)n * (sizeof(omni_ip_address_t*) + sizeof(omni_ip_address_t)));
+    if (!result) return NULL;
+    omni_ip_address_t* ips = (omni_ip_address_t*)(result + n);
+    for (int32_t i = 0; i < n; i++) {
+        inet_ntop(addrs[i].family, addrs[i].bytes, ips[i].address, sizeof(ips[i].address));
+        ips[i].is_ipv4 = addrs[i].family == AF_INET;
+        ips[i].is_ipv6 = addrs[i].family == AF_INET6;
+        result[i] = &ips[i];
+    }
+    *count = n;
+    return result;
+}
+
+static void omni_dns_lookup_task(omni_promise_t* promise, void* arg) {
+    char* hostname = (char*)arg;
+    omni_dns_addr_t addrs[OMNI_DNS_MAX_ADDRS];
+    int32_t n = omni_dns_resolve(hostname, addrs);
+    omni_strbuilder_t sb;
+    omni_strbuilder_init(&sb);
+    for (int32_t i = 0; i < n; i++) {
+        char text[INET6_ADDRSTRLEN];
+        inet_ntop(addrs[i].family, addrs[i].bytes, text, sizeof(text));
+        if (i > 0) omni_strbuilder_append_len(&sb, ",", 1);
+        omni_strbuilder_append_str(&sb, text);
+    }
+    char* result = omni_strbuilder_finish(&sb);
+    omni_promise_resolve_string(promise, result ? result : "");
+    omni_str_free(result);
+    free(hostname);
+}
+
+omni_promise_t* omni_dns_lookup_async(const char* hostname) {
+    char* copy = hostname ? strdup(hostname) : NULL;
+    if (!copy) return omni_promise_create_string("");
+    return omni_async_call(OMNI_PROMISE_STRING, omni_dns_lookup_task, copy);
+}
+
+char* omni_dns_reverse_lookup(omni_ip_address_t* ip) {
+    if (!ip) return NULL;
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    memset(&addr, 0, sizeof(addr));
+    struct sockaddr_in* in4 = (struct sockaddr_in*)&addr;
+    struct sockaddr_in6* in6 = (struct sockaddr_in6*)&addr;
+    if (inet_pton(AF_INET, ip->address, &in4->sin_addr) == 1) {
+        in4->sin_family = AF_INET;
+        addr_len = sizeof(*in4);
+    } else if (inet_pton(AF_INET6, ip->address, &in6->sin6_addr) == 1) {
+        in6->sin6_family = AF_INET6;
+        addr_len = sizeof(*in6);
+    } else {
+        return strdup("");
+    }
+    char host[NI_MAXHOST];
+    int spare = omni_sched_blocking();
+    int rc = getnameinfo((struct sockaddr*)&addr, addr_len, host, sizeof(host), NULL, 0, NI_NAMEREQD);
+    omni_sched_unblocked(spare);
+    return strdup(rc == 0 ? host : "");
+}
+
+void omni_dns_cache_clear(void) {
+    omni_mutex_lock(&omni_dns_mutex);
+    omni_dns_evict(1);
+    omni_mutex_unlock(&omni_dns_mutex);
+}
+
+#endif
+
+// ============================================================================
+// HTTP Client
+// ============================================================================
+
+#ifdef _WIN32
+
+omni_http_response_t* omni_http_request(omni_http_request_t* req) {
+    (void)req;
+    return NULL;
+}
+
+int32_t omni_http_request_all(omni_http_request_t** requests, omni_http_response_t** responses, int32_t count) {
+    (void)requests;
+    for (int32_t i = 0; responses && i < count; i++) responses[i] = NULL;
+    return 0;
+}
+
+void omni_http_pool_clear(void) {
+}
+
+#else
+
+#include <netinet/tcp.h>
+
+#define OMNI_HTTP_TIMEOUT_MS 30000      // Longest wait for the peer
+#define OMNI_HTTP_IDLE_TIMEOUT_MS 30000 // Pooled connections idle longer are closed
+#define OMNI_HTTP_MAX_IDLE_PER_HOST 8
+#define OMNI_HTTP_MAX_CONNS_PER_HOST 6  // Connections omni_http_request_all opens to one host
+#define OMNI_HTTP_PIPELINE_DEPTH 8      // Requests in flight on one connection
+#define OMNI_HTTP_MAX_HEAD (64 * 1024)  // Longest status line plus headers
+#define OMNI_HTTP_READ_SIZE 16384
+
+typedef struct {
+    char host[256];
+    int32_t port;
+    const char* path; // Into the URL; may be empty or start with '?'
+    size_t path_len;  // Up to any fragment
+} omni_http_target_t;
+
+typedef struct omni_http_conn {
+    int fd;
+    char host[256];
+    int32_t port;
+    int32_t reused;     // Has answered a request, so the peer may since have closed it
+    int64_t idle_since; // Monotonic milliseconds, while pooled
+    char* buf;          // buf[pos..len) is received but not yet parsed
+    size_t pos;
+    size_t len;
+    size_t cap;
+    struct omni_http_conn* next;
+} omni_http_conn_t;
+
+static omni_http_conn_t* omni_http_idle = NULL;
+static omni_mutex_t omni_http_pool_mutex = OMNI_MUTEX_INIT;
+
+// Splits an http:// URL into host, port and path; returns 0, or -1 for
+// another scheme or a malformed authority
+static int omni_http_parse_target(const char* url, omni_http_target_t* target) {
+    const char* p = url;
+    const char* scheme = strstr(url, "://");
+    if (scheme) {
+        if (scheme - url != 4 || strncasecmp(url, "http", 4) != 0) return -1;
+        p = scheme + 3;
+    }
+    size_t authority = strcspn(p, "/?#");
+    const char* host = p;
+    const char* end = p + authority;
+    const char* port = NULL;
+    size_t host_len;
+    if (*host == '[') {
+        // IPv6 literal
+        const char* close = (const char*)memchr(host, ']', authority);
+        if (!close) return -1;
+        host++;
+        host_len = (size_t)(close - host);
+        if (close + 1 < end) {
+            if (close[1] != ':') return -1;
+            port = close + 2;
+        }
+    } else {
+        const char* colon = (const char*)memchr(host, ':', authority);
+        host_len = (size_t)((colon ? colon : end) - host);
+        if (colon) port = colon + 1;
+    }
+    if (host_len == 0 || host_len >= sizeof(target->host)) return -1;
+    memcpy(target->host, host, host_len);
+    target->host[host_len] = '\0';
+
+    target->port = 80;
+    if (port) {
+        int32_t value = 0;
+        if (port == end) return -1;
+        for (const char* c = port; c < end; c++) {
+            if (!isdigit((unsigned char)*c)) return -1;
+            value = value * 10 + (*c - '0');
+            if (value > 65535) return -1;
+        }
+        if (value == 0) return -1;
+        target->port = value;
+    }
+    target->path = end;
+    target->path_len = strcspn(end, "#");
+    return 0;
+}
+
+// Connects to the target with a non-blocking socket; returns it or -1
+static int omni_http_connect(const omni_http_target_t* target) {
+    omni_dns_addr_t addrs[OMNI_DNS_MAX_ADDRS];
+    int32_t count = omni_dns_resolve(target->host, addrs);
+
+    int fd = -1;
+    for (int32_t i = 0; i < count && fd < 0; i++) {
+        struct sockaddr_storage addr;
+        socklen_t addr_len;
+        memset(&addr, 0, sizeof(addr));
+        if (addrs[i].family == AF_INET) {
+            struct sockaddr_in* in4 = (struct sockaddr_in*)&addr;
+            in4->sin_family = AF_INET;
+            in4->sin_port = htons((uint16_t)target->port);
+            memcpy(&in4->sin_addr, addrs[i].bytes, 4);
+            addr_len = sizeof(*in4);
+        } else {
+            struct sockaddr_in6* in6 = (struct sockaddr_in6*)&addr;
+            in6->sin6_family = AF_INET6;
+            in6->sin6_port = htons((uint16_t)target->port);
+            memcpy(&in6->sin6_addr, addrs[i].bytes, 16);
+            addr_len = sizeof(*in6);
+        }
+        fd = socket(addrs[i].family, SOCK_STREAM, 0);
+        if (fd < 0) continue;
+        omni_socket_set_nonblocking(fd, 1);
+        if (connect(fd, (struct sockaddr*)&addr, addr_len) != 0) {
+            int err = errno;
+            socklen_t err_len = sizeof(err);
+            if (err != EINPROGRESS || !omni_net_wait(fd, POLLOUT, OMNI_HTTP_TIMEOUT_MS) ||
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_len) != 0 || err != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+    if (fd >= 0) {
+        int on = 1;
+        // Requests go out in one write each, so there is nothing to coalesce
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    }
+    return fd;
+}
+
+static void omni_http_conn_close(omni_http_conn_t* conn) {
+    close(conn->fd);
+    free(conn->buf);
+    free(conn);
+}
+
+// Takes an idle pooled connection to the target's host, or opens a new one.
+// Connections that idled too long are closed on the way.
+static omni_http_conn_t* omni_http_checkout(const omni_http_target_t* target) {
+    for (;;) {
+        int64_t now = omni_net_now_ms();
+        omni_http_conn_t* conn = NULL;
+        omni_http_conn_t* expired = NULL;
+        omni_mutex_lock(&omni_http_pool_mutex);
+        omni_http_conn_t** link = &omni_http_idle;
+        while (*link) {
+            omni_http_conn_t* c = *link;
+            if (now - c->idle_since > OMNI_HTTP_IDLE_TIMEOUT_MS) {
+                *link = c->next;
+                c->next = expired;
+                expired = c;
+            } else if (!conn && c->port == target->port && strcmp(c->host, target->host) == 0) {
+                *link = c->next;
+                conn = c;
+            } else {
+                link = &c->next;
+            }
+        }
+        omni_mutex_unlock(&omni_http_pool_mutex);
+        while (expired) {
+            omni_http_conn_t* next = expired->next;
+            omni_http_conn_close(expired);
+            expired = next;
+        }
+        if (!conn) break;
+
+        // An idle connection that is readable has been closed by the peer
+        // (or holds bytes nobody asked for)
+        struct pollfd pfd;
+        pfd.fd = conn->fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 0) == 0) {
+            conn->next = NULL;
+            return conn;
+        }
+        omni_http_conn_close(conn);
+    }
+
+    omni_http_conn_t* conn = (omni_http_conn_t*)calloc(1, sizeof(omni_http_conn_t));
+    if (!conn) return NULL;
+    conn->fd = omni_http_connect(target);
+    if (conn->fd < 0) {
+        free(conn);
+        return NULL;
+    }
+    strcpy(conn->host, target->host);
+    conn->port = target->port;
+    return conn;
+}
+
+// Returns conn to the pool, unless its host already has enough idle ones
+static void omni_http_checkin(omni_http_conn_t* conn) {
+    // Bytes beyond the last response were never asked for
+    if (conn->pos < conn->len) {
+        omni_http_conn_close(conn);
+        return;
+    }
+    int32_t same_host = 0;
+    conn->reused = 1;
+    conn->idle_since = omni_net_now_ms();
+    conn->pos = conn->len = 0;
+    omni_mutex_lock(&omni_http_pool_mutex);
+    for (omni_http_conn_t* c = omni_http_idle; c; c = c->next) {
+        if (c->port == conn->port && strcmp(c->host, conn->host) == 0) same_host++;
+    }
+    if (same_host < OMNI_HTTP_MAX_IDLE_PER_HOST) {
+        conn->next = omni_http_idle;
+        omni_http_idle = conn;
+        conn = NULL;
+    }
+    omni_mutex_unlock(&omni_http_pool_mutex);
+    if (conn) omni_http_conn_close(conn);
+}
+
+void omni_http_pool_clear(void) {
+    omni_mutex_lock(&omni_http_pool_mutex);
+    omni_http_conn_t* conn = omni_http_idle;
+    omni_http_idle = NULL;
+    omni_mutex_unlock(&omni_http_pool_mutex);
+    while (conn) {
+        omni_http_conn_t* next = conn->next;
+        omni_http_conn_close(conn);
+        conn = next;
+    }
+}
+
+static int omni_http_send(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            len -= (size_t)n;
+        } else if (!(n < 0 && errno == EINTR) &&
+                   !(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && omni_net_wait(fd, POLLOUT, OMNI_HTTP_TIMEOUT_MS))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Receives into dst; returns the count, 0 at end of stream or -1
+static ssize_t omni_http_recv(int fd, char* dst, size_t len) {
+    for (;;) {
+        ssize_t n = recv(fd, dst, len, 0);
+        if (n >= 0) return n;
+        if (errno == EINTR) continue;
+        if ((errno == EAGAIN || errno == EWOULDBLOCK) && omni_net_wait(fd, POLLIN, OMNI_HTTP_TIMEOUT_MS)) continue;
+        return -1;
+    }
+}
+
+// Receives more into conn->buf, moving the unparsed bytes to its start
+// first; returns the count, 0 at end of stream or -1
+static ssize_t omni_http_fill(omni_http_conn_t* conn) {
+    if (conn->cap - conn->len < OMNI_HTTP_READ_SIZE && conn->pos > 0) {
+        memmove(conn->buf, conn->buf + conn->pos, conn->len - conn->pos);
+        conn->len -= conn->pos;
+        conn->pos = 0;
+    }
+    if (conn->cap - conn->len < OMNI_HTTP_READ_SIZE) {
+        size_t cap = conn->cap ? conn->cap * 2 : OMNI_HTTP_READ_SIZE;
+        char* buf = (char*)realloc(conn->buf, cap);
+        if (!buf) return -1;
+        conn->buf = buf;
+        conn->cap = cap;
+    }
+    ssize_t n = omni_http_recv(conn->fd, conn->buf + conn->len, conn->cap - conn->len);
+    if (n > 0) conn->len += (size_t)n;
+    return n;
+}
+
+// Reads one line and returns it NUL-terminated, without its line ending, in
+// conn->buf (valid until the next read); NULL on error or end of stream
+static char* omni_http_read_line(omni_http_conn_t* conn) {
+    for (;;) {
+        char* start = conn->buf ? conn->buf + conn->pos : NULL;
+        char* nl = conn->len > conn->pos ? (char*)memchr(start, '\n', conn->len - conn->pos) : NULL;
+        if (nl) {
+            *nl = '\0';
+            if (nl > start && nl[-1] == '\r') nl[-1] = '\0';
+            conn->pos = (size_t)(nl + 1 - conn->buf);
+            return start;
+        }
+        if (conn->len - conn->pos > OMNI_HTTP_MAX_HEAD || omni_http_fill(conn) <= 0) return NULL;
+    }
+}
+
+// Returns the length of the response head (the status line and headers,
+// through the blank line) waiting in conn->buf, reading as needed; 0 on error
+static size_t omni_http_read_head(omni_http_conn_t* conn) {
+    size_t scanned = 0;
+    for (;;) {
+        const char* start = conn->buf ? conn->buf + conn->pos : NULL;
+        size_t avail = conn->len - conn->pos;
+        for (size_t i = scanned; i < avail; i++) {
+            if (start[i] != '\n') continue;
+            if (i + 1 < avail && start[i + 1] == '\n') return i + 2;
+            if (i + 2 < avail && start[i + 1] == '\r' && start[i + 2] == '\n') return i + 3;
+        }
+        // Rescan the last two bytes, which may begin the blank line
+        scanned = avail > 2 ? avail - 2 : 0;
+        if (avail > OMNI_HTTP_MAX_HEAD || omni_http_fill(conn) <= 0) return 0;
+    }
+}
+
+// Terminates the line at p and returns the next one, or NULL at the end
+static char* omni_http_next_line(char* p) {
+    char* nl = strchr(p, '\n');
+    if (!nl) return NULL;
+    *nl = '\0';
+    if (nl > p && nl[-1] == '\r') nl[-1] = '\0';
+    return nl + 1;
+}
+
+// Parses resp->header_block in place: header lines are NUL-terminated and
+// their names lower-cased, so the header map can point into the block.
+// Returns the HTTP/1.x minor version, or -1 if the head is malformed.
+static int omni_http_parse_head(omni_http_response_t* resp) {
+    char* line = resp->header_block;
+    char* next = omni_http_next_line(line);
+    if (strncmp(line, "HTTP/1.", 7) != 0 || !isdigit((unsigned char)line[7]) || line[8] != ' ' ||
+        !isdigit((unsigned char)line[9]) || !isdigit((unsigned char)line[10]) ||
+        !isdigit((unsigned char)line[11]) || (line[12] != ' ' && line[12] != '\0')) {
+        return -1;
+    }
+    int minor = line[7] - '0';
+    resp->status_code = (line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0');
+    snprintf(resp->status_text, sizeof(resp->status_text), "%s", line[12] ? line + 13 : "");
+
+    for (line = next; line; line = next) {
+        next = omni_http_next_line(line);
+        if (!*line) break;
+        // Obsolete line folding
+        if (*line == ' ' || *line == '\t') continue;
+        char* colon = strchr(line, ':');
+        if (!colon || colon == line) return -1;
+        *colon = '\0';
+        for (char* c = line; *c; c++) *c = (char)tolower((unsigned char)*c);
+        char* value = colon + 1;
+        while (*value == ' ' || *value == '\t') value++;
+        char* end = value + strlen(value);
+        while (end > value && (end[-1] == ' ' || end[-1] == '\t')) *--end = '\0';
+        // A repeated header keeps its last value
+        omni_map_put_string_borrowed(resp->headers, line, value);
+    }
+    return minor;
+}
+
+// Whether the comma-separated list contains token, ignoring case
+static int omni_http_has_token(const char* list, const char* token) {
+    size_t len = strlen(token);
+    const char* p = list;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        const char* start = p;
+        while (*p && *p != ',') p++;
+        const char* end = p;
+        while (end > start && (end[-1] == ' ' || end[-1] == '\t')) end--;
+        if ((size_t)(end - start) == len && strncasecmp(start, token, len) == 0) return 1;
+    }
+    return 0;
+}
+
+// A body of known length, received straight into its omni_str
+static char* omni_http_read_sized(omni_http_conn_t* conn, size_t length) {
+    char* body = omni_str_alloc(NULL, length);
+    if (!body) return NULL;
+    size_t got = conn->len - conn->pos;
+    if (got > length) got = length;
+    if (got > 0) memcpy(body, conn->buf + conn->pos, got);
+    conn->pos += got;
+    while (got < length) {
+        ssize_t n = omni_http_recv(conn->fd, body + got, length - got);
+        if (n <= 0) {
+            omni_str_free(body);
+            return NULL;
+        }
+        got += (size_t)n;
+    }
+    return body;
+}
+
+static char* omni_http_read_chunked(omni_http_conn_t* conn) {
+    omni_strbuilder_t sb;
+    omni_strbuilder_init(&sb);
+    char* line;
+    for (;;) {
+        line = omni_http_read_line(conn);
+        if (!line || !isxdigit((unsigned char)*line)) goto fail;
+        char* end;
+        errno = 0;
+        unsigned long long size = strtoull(line, &end, 16);
+        if (errno != 0 || size > SIZE_MAX) goto fail;
+        // Chunk extensions after ';' are ignored
+        if (size == 0) break;
+        if (omni_strbuilder_reserve(&sb, (size_t)size) != 0) goto fail;
+        size_t want = (size_t)size;
+        while (want > 0) {
+            if (conn->pos == conn->len && omni_http_fill(conn) <= 0) goto fail;
+            size_t n = conn->len - conn->pos;
+            if (n > want) n = want;
+            omni_strbuilder_append_len(&sb, conn->buf + conn->pos, n);
+            conn->pos += n;
+            want -= n;
+        }
+        line = omni_http_read_line(conn);
+        if (!line || *line) goto fail;
+    }
+    // Trailer fields, through the blank line
+    while ((line = omni_http_read_line(conn)) != NULL && *line) {
+    }
+    if (!line) goto fail;
+    return omni_strbuilder_finish(&sb);
+fail:
+    omni_strbuilder_free(&sb);
+    return NULL;
+}
+
+// A body delimited by the end of the connection
+static char* omni_http_read_to_close(omni_http_conn_t* conn) {
+    omni_strbuilder_t sb;
+    omni_strbuilder_init(&sb);
+    omni_strbuilder_append_len(&sb, conn->buf + conn->pos, conn->len - conn->pos);
+    conn->pos = conn->len;
+    for (;;) {
+        if (omni_strbuilder_reserve(&sb, OMNI_HTTP_READ_SIZE) != 0) break;
+        ssize_t n = omni_http_recv(conn->fd, sb.data + sb.len, sb.cap - sb.len - 1);
+        if (n == 0) {
+            sb.data[sb.len] = '\0';
+            return omni_strbuilder_finish(&sb);
+        }
+        if (n < 0) break;
+        sb.len += (size_t)n;
+    }
+    omni_strbuilder_free(&sb);
+    return NULL;
+}
+
+// Reads the response to a request with the given method. *keep_alive is set
+// when the connection can carry another request.
+static omni_http_response_t* omni_http_read_response(omni_http_conn_t* conn, const char* method, int* keep_alive) {
+    *keep_alive = 0;
+    omni_http_response_t* resp = (omni_http_response_t*)calloc(1, sizeof(omni_http_response_t));
+    if (!resp) return NULL;
+    int minor;
+    do {
+        // Interim responses (100 Continue) precede the final one
+        size_t head_len = omni_http_read_head(conn);
+        if (head_len == 0) goto fail;
+        if (resp->headers) omni_map_destroy(resp->headers);
+        free(resp->header_block);
+        resp->headers = omni_map_create();
+        resp->header_block = (char*)malloc(head_len + 1);
+        if (!resp->headers || !resp->header_block) goto fail;
+        memcpy(resp->header_block, conn->buf + conn->pos, head_len);
+        resp->header_block[head_len] = '\0';
+        conn->pos += head_len;
+        minor = omni_http_parse_head(resp);
+        if (minor < 0) goto fail;
+    } while (resp->status_code < 200 && resp->status_code != 101);
+
+    const char* connection = omni_map_get_string_string(resp->headers, "connection");
+    if (minor >= 1) {
+        *keep_alive = !(connection && omni_http_has_token(connection, "close"));
+    } else {
+        *keep_alive = connection && omni_http_has_token(connection, "keep-alive");
+    }
+    const char* encoding = omni_map_get_string_string(resp->headers, "transfer-encoding");
+    const char* length = omni_map_get_string_string(resp->headers, "content-length");
+    int32_t code = resp->status_code;
+    if (strcmp(method, "HEAD") == 0 || code == 101 || code == 204 || code == 304) {
+        resp->body = omni_str_new(NULL, "", 0);
+        if (code == 101) *keep_alive = 0;
+    } else if (encoding && omni_http_has_token(encoding, "chunked")) {
+        resp->body = omni_http_read_chunked(conn);
+    } else if (length) {
+        char* end;
+        errno = 0;
+        unsigned long long size = strtoull(length, &end, 10);
+        if (!isdigit((unsigned char)*length) || *end || errno != 0 || size > SIZE_MAX) goto fail;
+        resp->body = omni_http_read_sized(conn, (size_t)size);
+    } else {
+        resp->body = omni_http_read_to_close(conn);
+        *keep_alive = 0;
+    }
+    if (!resp->body) goto fail;
+    return resp;
+fail:
+    *keep_alive = 0;
+    omni_http_response_destroy(resp);
+    return NULL;
+}
+
+static int omni_http_idempotent(const omni_http_request_t* req) {
+    static const char* const methods[] = {"GET", "HEAD", "OPTIONS", "PUT", "DELETE", "TRACE"};
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strcmp(req->method, methods[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int omni_http_pipelinable(const omni_http_request_t* req) {
+    return omni_http_idempotent(req) && (!req->body || !*req->body);
+}
+
+// Header fields must not smuggle in line breaks
+static int omni_http_header_safe(const char* s) {
+    return strpbrk(s, "\r\n") == NULL;
+}
+
+// Serializes req, head and body, for sending in one write
+static char* omni_http_format_request(const omni_http_request_t* req, const omni_http_target_t* target, size_t* len) {
+    omni_strbuilder_t sb;
+    omni_strbuilder_init(&sb);
+    omni_strbuilder_append_str(&sb, req->method);
+    omni_strbuilder_append_len(&sb, " ", 1);
+    if (target->path_len == 0 || target->path[0] != '/') omni_strbuilder_append_len(&sb, "/", 1);
+    omni_strbuilder_append_len(&sb, target->path, target->path_len);
+    omni_strbuilder_append_str(&sb, " HTTP/1.1\r\n");
+
+    int has_host = 0;
+    int has_length = 0;
+    omni_map_t* headers = req->headers;
+    if (headers && headers->key_kind == OMNI_MAP_KEY_STRING && headers->value_kind == OMNI_MAP_VALUE_STRING) {
+        uint32_t pos = 0;
+        omni_map_slot_t* slot;
+        while ((slot = omni_map_next_slot(headers, &pos)) != NULL) {
+            if (!slot->value.s || !omni_http_header_safe(slot->key.s) || !omni_http_header_safe(slot->value.s)) continue;
+            if (strcasecmp(slot->key.s, "host") == 0) has_host = 1;
+            if (strcasecmp(slot->key.s, "content-length") == 0 ||
+                strcasecmp(slot->key.s, "transfer-encoding") == 0) {
+                has_length = 1;
+            }
+            omni_strbuilder_append_len(&sb, slot->key.s, slot->key_len);
+            omni_strbuilder_append_len(&sb, ": ", 2);
+            omni_strbuilder_append_str(&sb, slot->value.s);
+            omni_strbuilder_append_len(&sb, "\r\n", 2);
+        }
+    }
+    if (!has_host) {
+        char host[300];
+        int ipv6 = strchr(target->host, ':') != NULL;
+        if (target->port == 80) {
+            snprintf(host, sizeof(host), ipv6 ? "Host: [%s]\r\n" : "Host: %s\r\n", target->host);
+        } else {
+            snprintf(host, sizeof(host), ipv6 ? "Host: [%s]:%d\r\n" : "Host: %s:%d\r\n", target->host, target->port);
+        }
+        omni_strbuilder_append_str(&sb, host);
+    }
+    size_t body_len = req->body ? strlen(req->body) : 0;
+    if (!has_length && (body_len > 0 || strcmp(req->method, "POST") == 0 ||
+                        strcmp(req->method, "PUT") == 0 || strcmp(req->method, "PATCH") == 0)) {
+        char length[48];
+        snprintf(length, sizeof(length), "Content-Length: %zu\r\n", body_len);
+        omni_strbuilder_append_str(&sb, length);
+    }
+    omni_strbuilder_append_len(&sb, "\r\n", 2);
+    omni_strbuilder_append_len(&sb, req->body, body_len);
+    char* result = omni_strbuilder_finish(&sb);
+    *len = omni_str_len(result);
+    return result;
+}
+
+// Requests to one host, performed in order over one connection at a time
+typedef struct {
+    omni_http_request_t** requests;   // The whole batch
+    omni_http_response_t** responses;
+    const omni_http_target_t* targets;
+    int32_t* order;                   // Batch indices of this lane's requests
+    int32_t count;
+    int32_t succeeded;
+} omni_http_lane_t;
+
+// Pipelines up to OMNI_HTTP_PIPELINE_DEPTH requests ahead of the responses
+// while they are all pipelinable. When a connection ends early, requests
+// left unanswered move to a new one; the request in progress is retried
+// only if it is idempotent and the connection had been reused, the case
+// where a peer closing an idle connection races with the request.
+static void omni_http_lane_run(omni_http_lane_t* lane) {
+    int32_t answered = 0;
+    int32_t retried = -1;
+    while (answered < lane->count) {
+        const omni_http_target_t* target = &lane->targets[lane->order[answered]];
+        omni_http_conn_t* conn = omni_http_checkout(target);
+        if (!conn) {
+            answered++;
+            continue;
+        }
+        int reused = conn->reused;
+        int keep_alive = 1;
+        int failed = 0;
+        int32_t sent = answered;
+        while (answered < lane->count && keep_alive) {
+            while (sent < lane->count &&
+                   (sent == answered ||
+                    (sent - answered < OMNI_HTTP_PIPELINE_DEPTH &&
+                     omni_http_pipelinable(lane->requests[lane->order[answered]]) &&
+                     omni_http_pipelinable(lane->requests[lane->order[sent]])))) {
+                int32_t index = lane->order[sent];
+                size_t len;
+                char* data = omni_http_format_request(lane->requests[index], &lane->targets[index], &len);
+                int rc = data ? omni_http_send(conn->fd, data, len) : -1;
+                omni_str_free(data);
+                if (rc != 0) break;
+                sent++;
+            }
+            if (sent == answered) {
+                failed = 1;
+                break;
+            }
+            int32_t index = lane->order[answered];
+            omni_http_response_t* resp = omni_http_read_response(conn, lane->requests[index]->method, &keep_alive);
+            if (!resp) {
+                failed = 1;
+                break;
+            }
+            lane->responses[index] = resp;
+            lane->succeeded++;
+            answered++;
+            reused = 1;
+        }
+        if (!failed && keep_alive) {
+            omni_http_checkin(conn);
+        } else {
+            omni_http_conn_close(conn);
+        }
+        if (failed) {
+            if (reused && retried != answered && omni_http_idempotent(lane->requests[lane->order[answered]])) {
+                retried = answered;
+            } else {
+                answered++;
+            }
+        }
+    }
+}
+
+static void omni_http_lane_task(omni_promise_t* promise, void* arg) {
+    omni_http_lane_t* lane = (omni_http_lane_t*)arg;
+    omni_http_lane_run(lane);
+    omni_promise_resolve_int(promise, lane->succeeded);
+}
+
+omni_http_response_t* omni_http_request(omni_http_request_t* req) {
+    if (!req) return NULL;
+    omni_http_response_t* resp = NULL;
+    omni_http_request_all(&req, &resp, 1);
+    return resp;
+}
+
+int32_t omni_http_request_all(omni_http_request_t** requests, omni_http_response_t** responses, int32_t count) {
+    if (!requests || !responses || count <= 0) return 0;
+    omni_http_target_t* targets = (omni_http_target_t*)malloc((size_t)count * sizeof(omni_http_target_t));
+    int32_t* order = (int32_t*)malloc((size_t)count * sizeof(int32_t));
+    int32_t* lane_of = (int32_t*)malloc((size_t)count * sizeof(int32_t));
+    omni_http_lane_t* lanes = (omni_http_lane_t*)calloc((size_t)count, sizeof(omni_http_lane_t));
+    if (!targets || !order || !lane_of || !lanes) {
+        free(targets);
+        free(order);
+        free(lane_of);
+        free(lanes);
+        return 0;
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        responses[i] = NULL;
+        lane_of[i] = -1;
+        if (!requests[i]) {
+            lane_of[i] = -2;
+        } else if (omni_http_parse_target(requests[i]->url, &targets[i]) != 0) {
+            fprintf(stderr, "ERROR: unsupported or malformed HTTP URL: %s\n", requests[i]->url);
+            lane_of[i] = -2;
+        }
+    }
+
+    // Deal each host's requests round-robin onto up to
+    // OMNI_HTTP_MAX_CONNS_PER_HOST lanes, keeping their order in each lane
+    int32_t lane_count = 0;
+    for (int32_t i = 0; i < count; i++) {
+        if (lane_of[i] != -1) continue;
+        int32_t first = lane_count;
+        int32_t members = 0;
+        for (int32_t j = i; j < count; j++) {
+            if (lane_of[j] != -1 || targets[j].port != targets[i].port ||
+                strcmp(targets[j].host, targets[i].host) != 0) {
+                continue;
+            }
+            int32_t lane = first + members % OMNI_HTTP_MAX_CONNS_PER_HOST;
+            if (lane == lane_count) lane_count++;
+            lane_of[j] = lane;
+            lanes[lane].count++;
+            members++;
+        }
+    }
+    int32_t offset = 0;
+    for (int32_t l = 0; l < lane_count; l++) {
+        lanes[l].requests = requests;
+        lanes[l].responses = responses;
+        lanes[l].targets = targets;
+        lanes[l].order = order + offset;
+        offset += lanes[l].count;
+        lanes[l].count = 0;
+    }
+    for (int32_t i = 0; i < count; i++) {
+        if (lane_of[i] >= 0) {
+            omni_http_lane_t* lane = &lanes[lane_of[i]];
+            lane->order[lane->count++] = i;
+        }
+    }
+
+    int32_t succeeded = 0;
+    if (lane_count == 1) {
+        omni_http_lane_run(&lanes[0]);
+        succeeded = lanes[0].succeeded;
+    } else if (lane_count > 1) {
+        omni_promise_t** pending = (omni_promise_t**)malloc((size_t)lane_count * sizeof(omni_promise_t*));
+        for (int32_t l = 0; l < lane_count; l++) {
+            if (pending) {
+                pending[l] = omni_async_call(OMNI_PROMISE_INT, omni_http_lane_task, &lanes[l]);
+            } else {
+                omni_http_lane_run(&lanes[l]);
+                succeeded += lanes[l].succeeded;
+            }
+        }
+        for (int32_t l = 0; pending && l < lane_count; l++) {
+            succeeded += omni_await_int(pending[l]);
+            omni_promise_free(pending[l]);
+        }
+        free(pending);
+    }
+
+    free(targets);
+    free(order);
+    free(lane_of);
+    free(lanes);
+    return succeeded;
+}
+
+#endif
+
+// Network utility functions
+int32_t omni_network_is_connected() {
+    // Stub: would need to check network interface status
+    return 1; // Assume connected
+}
+
+omni_ip_address_t* omni_network_get_local_ip() {
+    omni_ip_address_t* ip = (omni_ip_address_t*)malloc(sizeof(omni_ip_address_t));
+    if (!ip) return NULL;
+    strncpy(ip->address, "127.0.0.1", sizeof(ip->address) - 1);
+    ip->is_ipv4 = 1;
+    ip->is_ipv6 = 0;
+    return ip;
+}
+
+int32_t omni_network_ping(const char* host) {
+    if (!host) return 0;
+    // Stub: would need ICMP ping implementation
+    return 0;
+}
+
+// ============================================================================
+// Coverage Tracking Infrastructure
+// ============================================================================
+
+// Two kinds of sites are counted. Programs built with coverage carry a
+// static table of their sites (generated by the C backend) next to a counter
+// array; a hit is a relaxed atomic increment of counters[id] and nothing
+// else, and the tables are registered once at startup. Sites reported by
+// name through omni_coverage_record go into a hash table under a lock. The
+// export walks the registered tables, then the named sites.
+
+#define OMNI_COVERAGE_MAX_TABLES 16
+
+typedef struct {
+    const omni_coverage_site_t* sites;
+    uint64_t* counters;
+    int32_t count;
+} omni_coverage_table_t;
+
+typedef struct omni_coverage_entry {
+    struct omni_coverage_entry* next;
+    uint64_t hash;
+    char* function_name;
+    char* file_path;
+    int32_t line_number;
+    int64_t call_count;
+} omni_coverage_entry_t;
+
+static struct {
+    omni_coverage_table_t tables[OMNI_COVERAGE_MAX_TABLES];
+    int32_t table_count;
+    omni_coverage_entry_t** buckets;
+    size_t bucket_count;
+    size_t count;
+    int32_t enabled;
+    omni_mutex_t mutex;
+} omni_coverage_state = {
+    .table_count = 0,
+    .buckets = NULL,
+    .bucket_count = 0,
+    .count = 0,
+    .enabled = 0,
+    .mutex = OMNI_MUTEX_INIT
+};
+
+// Called with the lock held
+static void omni_coverage_clear_locked(void) {
+    for (size_t i = 0; i < omni_coverage_state.bucket_count; i++) {
+        omni_coverage_entry_t* entry = omni_coverage_state.buckets[i];
+        while (entry) {
+            omni_coverage_entry_t* next = entry->next;
+            free(entry->function_name);
+            free(entry->file_path);
+            free(entry);
+            entry = next;
+        }
+        omni_coverage_state.buckets[i] = NULL;
+    }
+    omni_coverage_state.count = 0;
+    for (int32_t t = 0; t < omni_coverage_state.table_count; t++) {
+        omni_coverage_table_t* table = &omni_coverage_state.tables[t];
+        for (int32_t i = 0; i < table->count; i++) {
+            __atomic_store_n(&table->counters[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void omni_coverage_init(void) {
+    omni_mutex_lock(&omni_coverage_state.mutex);
+    omni_coverage_clear_locked();
+    omni_coverage_state.enabled = 1;
+    omni_mutex_unlock(&omni_coverage_state.mutex);
+}
+
+void omni_coverage_set_enabled(int32_t enabled) {
+    omni_mutex_lock(&omni_coverage_state.mutex);
+    omni_coverage_state.enabled = enabled;
+    omni_mutex_unlock(&omni_coverage_state.mutex);
+}
+
+int32_t omni_coverage_is_enabled(void) {
+    return omni_coverage_state.enabled;
+}
+
+static void omni_coverage_write_at_exit(void) {
+    const char* path = getenv("OMNI_COVERAGE_OUTPUT");
+    if (!path || !*path) {
+        path = "coverage.json";
+    }
+    char* json = omni_coverage_export();
+    if (!json) {
+        return;
+    }
+    FILE* file = fopen(path, "w");
+    if (file) {
+        fputs(json, file);
+        fclose(file);
+    } else {
+        fprintf(stderr, "ERROR: cannot write coverage data to %s\n", path);
+    }
+    free(json);
+}
+
+void omni_coverage_register(const omni_coverage_site_t* sites, uint64_t* counters, int32_t count) {
+    if (!sites || !counters || count <= 0) {
+        return;
+    }
+    omni_mutex_lock(&omni_coverage_state.mutex);
+    if (omni_coverage_state.table_count < OMNI_COVERAGE_MAX_TABLES) {
+        omni_coverage_table_t* table = &omni_coverage_state.tables[omni_coverage_state.table_count++];
+        table->sites = sites;
+        table->counters = counters;
+        table->count = count;
+        if (omni_coverage_state.table_count == 1) {
+            atexit(omni_coverage_write_at_exit);
+        }
+        omni_coverage_state.enabled = 1;
+    } else {
+        fprintf(stderr, "ERROR: too many coverage tables (limit %d)\n", OMNI_COVERAGE_MAX_TABLES);
+    }
+    omni_mutex_unlock(&omni_coverage_state.mutex);
+}
+
+static uint64_t omni_coverage_hash(const char* function_name, const char* file_path, int32_t line_number) {
+    // FNV-1a over both names and the line
+    uint64_t h = 1469598103934665603ULL;
+    for (const char* p = function_name; *p; p++) h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+    h = (h ^ 0xFF) * 1099511628211ULL;
+    for (const char* p = file_path; *p; p++) h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+    return (h ^ (uint32_t)line_number) * 1099511628211ULL;
+}
+
+// Doubles the bucket array; called with the lock held
+static int omni_coverage_grow_locked(void) {
+    size_t bucket_count = omni_coverage_state.bucket_count ? omni_coverage_state.bucket_count * 2 : 256;
+    omni_coverage_entry_t** buckets = (omni_coverage_entry_t**)calloc(bucket_count, sizeof(omni_coverage_entry_t*));
+    if (!buckets) {
+        return 0;
+    }
+    for (size_t i = 0; i < omni_coverage_state.bucket_count; i++) {
+        omni_coverage_entry_t* entry = omni_coverage_state.buckets[i];
+        while (entry) {
+            omni_coverage_entry_t* next = entry->next;
+            size_t b = (size_t)(entry->hash & (bucket_count - 1));
+            entry->next = buckets[b];
+            buckets[b] = entry;
+            entry = next;
+        }
+    }
+    free(omni_coverage_state.buckets);
+    omni_coverage_state.buckets = buckets;
+    omni_coverage_state.bucket_count = bucket_count;
+    return 1;
+}
+
+void omni_coverage_record(const char* function_name, const char* file_path, int32_t line_number) {
+    if (!omni_coverage_state.enabled || !function_name) {
+        return;
+    }
+    if (!file_path) {
+        file_path = "";
+    }
+    uint64_t hash = omni_coverage_hash(function_name, file_path, line_number);
+
+    omni_mutex_lock(&omni_coverage_state.mutex);
+    if (omni_coverage_state.count >= omni_coverage_state.bucket_count && !omni_coverage_grow_locked() &&
+        omni_coverage_state.bucket_count == 0) {
+        omni_mutex_unlock(&omni_coverage_state.mutex);
+        return;
+    }
+    size_t b = (size_t)(hash & (omni_coverage_state.bucket_count - 1));
+    omni_coverage_entry_t* entry = omni_coverage_state.buckets[b];
+    while (entry && !(entry->hash == hash && entry->line_number == line_number &&
+                      strcmp(entry->function_name, function_name) == 0 &&
+                      strcmp(entry->file_path, file_path) == 0)) {
+        entry = entry->next;
+    }
+    if (entry) {
+        entry->call_count++;
+    } else if ((entry = (omni_coverage_entry_t*)calloc(1, sizeof(omni_coverage_entry_t))) != NULL) {
+        entry->function_name = strdup(function_name);
+        entry->file_path = strdup(file_path);
+        if (!entry->function_name || !entry->file_path) {
+            free(entry->function_name);
+            free(entry->file_path);
+            free(entry);
+        } else {
+            entry->hash = hash;
+            entry->line_number = line_number;
+            entry->call_count = 1;
+            entry->next = omni_coverage_state.buckets[b];
+            omni_coverage_state.buckets[b] = entry;
+            omni_coverage_state.count++;
+        }
+    }
+    omni_mutex_unlock(&omni_coverage_state.mutex);
+}
+
+void omni_coverage_reset(void) {
+    omni_mutex_lock(&omni_coverage_state.mutex);
+    omni_coverage_clear_locked();
+    omni_mutex_unlock(&omni_coverage_state.mutex);
+}
+
+static void omni_coverage_append_json_string(omni_strbuilder_t* sb, const char* str) {
+    omni_strbuilder_append_len(sb, "\"", 1);
+    for (const char* p = str ? str : ""; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\') {
+            char escaped[2] = {'\\', (char)c};
+            omni_strbuilder_append_len(sb, escaped, 2);
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            omni_strbuilder_append_str(sb, escaped);
+        } else {
+            omni_strbuilder_append_len(sb, p, 1);
+        }
+    }
+    omni_strbuilder_append_len(sb, "\"", 1);
+}
+
+static void omni_coverage_append_entry(omni_strbuilder_t* sb, int first, int64_t id, const char* function_name,
+                                       const char* file_path, int32_t line_number, uint64_t count) {
+    char number[32];
+    omni_strbuilder_append_str(sb, first ? "{" : ",{");
+    if (id >= 0) {
+        snprintf(number, sizeof(number), "\"id\":%lld,", (long long)id);
+        omni_strbuilder_append_str(sb, number);
+    }
+    omni_strbuilder_append_str(sb, "\"function\":");
+    omni_coverage_append_json_string(sb, function_name);
+    omni_strbuilder_append_str(sb, ",\"file\":");
+    omni_coverage_append_json_string(sb, file_path);
+    snprintf(number, sizeof(number), ",\"line\":%d", line_number);
+    omni_strbuilder_append_str(sb, number);
+    snprintf(number, sizeof(number), ",\"count\":%llu}", (unsigned long long)count);
+    omni_strbuilder_append_str(sb, number);
+}
+
+// Site ids number the registered tables' sites consecutively
+char* omni_coverage_export(void) {
+    omni_strbuilder_t sb;
+    omni_strbuilder_init(&sb);
+    omni_strbuilder_append_str(&sb, "{\"entries\":[");
+    int first = 1;
+
+    omni_mutex_lock(&omni_coverage_state.mutex);
+    int64_t id = 0;
+    for (int32_t t = 0; t < omni_coverage_state.table_count; t++) {
+        omni_coverage_table_t* table = &omni_coverage_state.tables[t];
+        for (int32_t i = 0; i < table->count; i++, id++) {
+            const omni_coverage_site_t* site = &table->sites[i];
+            omni_coverage_append_entry(&sb, first, id, site->function_name, site->file_path, site->line_number,
+                                       __atomic_load_n(&table->counters[i], __ATOMIC_RELAXED));
+            first = 0;
+        }
+    }
+    for (size_t i = 0; i < omni_coverage_state.bucket_count; i++) {
+        for (omni_coverage_entry_t* entry = omni_coverage_state.buckets[i]; entry; entry = entry->next) {
+            omni_coverage_append_entry(&sb, first, -1, entry->function_name, entry->file_path, entry->line_number,
+                                       (uint64_t)entry->call_count);
+            first = 0;
+        }
+    }
+    omni_mutex_unlock(&omni_coverage_state.mutex);
+
+    omni_strbuilder_append_str(&sb, "]}");
+    // Callers free() the result, so it cannot stay an omni_str
+    char* built = omni_strbuilder_finish(&sb);
+    if (!built) {
+        return NULL;
+    }
+    char* json = strdup(built);
+    omni_str_free(built);
+    return json;
+}
+
+// ============================================================================
+// Profiler
+// ============================================================================
+
+// Function timing: every thread owns an omni_prof_thread_t holding a shadow
+// stack of the instrumented functions it is in and one counter block per
+// site. Only the owning thread writes either, so enter/exit are a clock read
+// and a few plain stores. The states of all threads are linked into a list
+// that the export walks; a state goes back to the pool when its thread exits
+// and keeps accumulating for the next thread that claims it.
+//
+// Sampling: SIGPROF fires on CPU time, on whichever thread is running. The
+// handler claims a slot of a preallocated sample array with one atomic add
+// and copies the thread's shadow stack into it, or the native return
+// addresses from backtrace() when the thread is in no instrumented function.
+// Samples are symbolized and folded only when exported.
+
+#define OMNI_PROF_MAX_DEPTH 256      // Deeper frames are counted but not timed
+#define OMNI_PROF_SAMPLE_DEPTH 48    // Innermost frames kept per sample
+#define OMNI_PROF_MAX_SAMPLES 65536
+#define OMNI_PROF_DEFAULT_HZ 99
+
+enum {
+    OMNI_PROF_SAMPLE_SITES = 1,  // frames[] holds site ids, outermost first
+    OMNI_PROF_SAMPLE_NATIVE = 2, // frames[] holds return addresses, innermost first
+};
+
+typedef struct {
+    int32_t site;
+    int64_t start_ns;
+    int64_t child_ns; // Inclusive time of the callees that have returned
+} omni_prof_frame_t;
+
+typedef struct {
+    uint64_t calls;
+    int64_t total_ns;
+    int64_t self_ns;
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+} omni_prof_counter_t;
+
+typedef struct omni_prof_thread {
+    struct omni_prof_thread* next; // Registry link; states are never unlinked
+    int32_t owned;                 // Claimed by a live thread
+    volatile int32_t depth;        // Read by the SIGPROF handler on this thread
+    omni_prof_counter_t* counters; // One per registered site
+    omni_prof_frame_t frames[OMNI_PROF_MAX_DEPTH];
+} omni_prof_thread_t;
+
+typedef struct {
+    int32_t depth; // 0 until the handler has filled the sample
+    int32_t kind;
+    uintptr_t frames[OMNI_PROF_SAMPLE_DEPTH];
+} omni_prof_sample_t;
+
+static struct {
+    const omni_prof_site_t* sites;
+    int32_t site_count;
+    omni_prof_thread_t* threads;
+    uint64_t unattributed_allocs; // Made outside any instrumented function
+    uint64_t unattributed_bytes;
+    omni_prof_sample_t* samples;
+    uint64_t next_sample;
+    uint64_t dropped_samples;
+    int32_t sampling;
+    int32_t exit_hook;
+    omni_mutex_t mutex;
+} omni_prof_state = {
+    .sites = NULL,
+    .site_count = 0,
+    .threads = NULL,
+    .samples = NULL,
+    .sampling = 0,
+    .exit_hook = 0,
+    .mutex = OMNI_MUTEX_INIT
+};
+
+// The SIGPROF handler reads this, so it must not need an allocation on
+// first access from a signal handler
+#if defined(__GNUC__) && !defined(_WIN32)
+static __thread omni_prof_thread_t* omni_prof_self __attribute__((tls_model("initial-exec"))) = NULL;
+#else
+static OMNI_THREAD_LOCAL omni_prof_thread_t* omni_prof_self = NULL;
+#endif
+
+#ifndef _WIN32
+static pthread_key_t omni_prof_thread_key;
+static pthread_once_t omni_prof_thread_key_once = PTHREAD_ONCE_INIT;
+
+static void omni_prof_thread_release(void* state) {
+    omni_prof_thread_t* thread = (omni_prof_thread_t*)state;
+    thread->depth = 0;
+    __atomic_store_n(&thread->owned, 0, __ATOMIC_RELEASE);
+}
+
+static void omni_prof_thread_key_init(void) {
+    pthread_key_create(&omni_prof_thread_key, omni_prof_thread_release);
+}
+#endif
+
+// The calling thread's state, claimed or created on first use; NULL before
+// any sites are registered or when out of memory
+static omni_prof_thread_t* omni_prof_thread(void) {
+    omni_prof_thread_t* thread = omni_prof_self;
+    if (thread) {
+        return thread;
+    }
+    int32_t site_count = OMNI_LOAD_ACQUIRE(&omni_prof_state.site_count);
+    if (site_count == 0) {
+        return NULL;
+    }
+    for (thread = OMNI_LOAD_ACQUIRE(&omni_prof_state.threads); thread; thread = thread->next) {
+        int32_t expected = 0;
+        if (__atomic_compare_exchange_n(&thread->owned, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    if (!thread) {
+        thread = (omni_prof_thread_t*)calloc(1, sizeof(omni_prof_thread_t));
+        if (!thread) {
+            return NULL;
+        }
+        thread->counters = (omni_prof_counter_t*)calloc((size_t)site_count, sizeof(omni_prof_counter_t));
+        if (!thread->counters) {
+            free(thread);
+            return NULL;
+        }
+        thread->owned = 1;
+        omni_mutex_lock(&omni_prof_state.mutex);
+        thread->next = omni_prof_state.threads;
+        OMNI_STORE_RELEASE(&omni_prof_state.threads, thread);
+        omni_mutex_unlock(&omni_prof_state.mutex);
+    }
+#ifndef _WIN32
+    pthread_once(&omni_prof_thread_key_once, omni_prof_thread_key_init);
+    pthread_setspecific(omni_prof_thread_key, thread);
+#endif
+    omni_prof_self = thread;
+    return thread;
+}
+
+void omni_prof_enter(int32_t site) {
+    omni_prof_thread_t* thread = omni_prof_thread();
+    if (!thread || site < 0 || site >= omni_prof_state.site_count) {
+        return;
+    }
+    thread->counters[site].calls++;
+    int32_t depth = thread->depth;
+    if (depth < OMNI_PROF_MAX_DEPTH) {
+        omni_prof_frame_t* frame = &thread->frames[depth];
+        frame->site = site;
+        frame->child_ns = 0;
+        frame->start_ns = omni_time_now_monotonic_nano();
+    }
+    // The frame must be complete before a sample can see it
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    thread->depth = depth + 1;
+}
+
+void omni_prof_exit(int32_t site) {
+    (void)site; // Exits always match the innermost enter
+    omni_prof_thread_t* thread = omni_prof_self;
+    if (!thread || thread->depth == 0) {
+        return;
+    }
+    int32_t depth = thread->depth - 1;
+    if (depth < OMNI_PROF_MAX_DEPTH) {
+        omni_prof_frame_t* frame = &thread->frames[depth];
+        int64_t elapsed = omni_time_now_monotonic_nano() - frame->start_ns;
+        omni_prof_counter_t* counter = &thread->counters[frame->site];
+        counter->total_ns += elapsed;
+        counter->self_ns += elapsed - frame->child_ns;
+        if (depth > 0) {
+            thread->frames[depth - 1].child_ns += elapsed;
+        }
+    }
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    thread->depth = depth;
+}
+
+static void omni_prof_note_alloc(size_t size) {
+    omni_prof_thread_t* thread = omni_prof_self;
+    int32_t depth = thread ? thread->depth : 0;
+    if (depth > 0 && depth <= OMNI_PROF_MAX_DEPTH) {
+        omni_prof_counter_t* counter = &thread->counters[thread->frames[depth - 1].site];
+        counter->allocs++;
+        counter->alloc_bytes += size;
+    } else {
+        __atomic_fetch_add(&omni_prof_state.unattributed_allocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&omni_prof_state.unattributed_bytes, (uint64_t)size, __ATOMIC_RELAXED);
+    }
+}
+
+static void omni_prof_write_file(const char* env, const char* fallback, char* text) {
+    const char* path = getenv(env);
+    if (!path || !*path) {
+        path = fallback;
+    }
+    if (!text) {
+        return;
+    }
+    FILE* file = fopen(path, "w");
+    if (file) {
+        fputs(text, file);
+        fclose(file);
+    } else {
+        fprintf(stderr, "ERROR: cannot write profile data to %s\n", path);
+    }
+    free(text);
+}
+
+static void omni_prof_write_at_exit(void) {
+    int32_t sampled = omni_prof_state.samples != NULL;
+    omni_prof_stop_sampling();
+    if (omni_prof_state.site_count > 0) {
+        omni_prof_write_file("OMNI_PROFILE_OUTPUT", "profile.json", omni_prof_export());
+    }
+    if (sampled) {
+        omni_prof_write_file("OMNI_PROFILE_FOLDED", "profile.folded", omni_prof_export_folded());
+    }
+    uint64_t dropped = __atomic_load_n(&omni_prof_state.dropped_samples, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+        fprintf(stderr, "WARN: profiler dropped %llu samples (buffer holds %d)\n", (unsigned long long)dropped,
+                OMNI_PROF_MAX_SAMPLES);
+    }
+}
+
+// Called with the lock held
+static void omni_prof_install_exit_hook_locked(void) {
+    if (!omni_prof_state.exit_hook) {
+        omni_prof_state.exit_hook = 1;
+        atexit(omni_prof_write_at_exit);
+    }
+}
+
+void omni_prof_register(const omni_prof_site_t* sites, int32_t count) {
+    if (!sites || count <= 0) {
+        return;
+    }
+    omni_mutex_lock(&omni_prof_state.mutex);
+    if (omni_prof_state.site_count > 0) {
+        // Per-thread counters are sized for the one table
+        omni_mutex_unlock(&omni_prof_state.mutex);
+        fprintf(stderr, "ERROR: profiler sites are already registered\n");
+        return;
+    }
+    omni_prof_state.sites = sites;
+    OMNI_STORE_RELEASE(&omni_prof_state.site_count, count);
+    omni_prof_install_exit_hook_locked();
+    omni_mutex_unlock(&omni_prof_state.mutex);
+    omni_prof_count_allocs = 1;
+
+    const char* hz = getenv("OMNI_PROFILE_HZ");
+    int32_t rate = hz && *hz ? (int32_t)atoi(hz) : OMNI_PROF_DEFAULT_HZ;
+    if (rate > 0) {
+        omni_prof_start_sampling(rate);
+    }
+}
+
+#ifndef _WIN32
+static struct sigaction omni_prof_previous_action;
+
+static void omni_prof_on_sigprof(int sig) {
+    (void)sig;
+    int saved_errno = errno;
+    uint64_t slot = __atomic_fetch_add(&omni_prof_state.next_sample, 1, __ATOMIC_RELAXED);
+    if (slot >= OMNI_PROF_MAX_SAMPLES) {
+        __atomic_fetch_add(&omni_prof_state.dropped_samples, 1, __ATOMIC_RELAXED);
+        errno = saved_errno;
+        return;
+    }
+    omni_prof_sample_t* sample = &omni_prof_state.samples[slot];
+    omni_prof_thread_t* thread = omni_prof_self;
+    int32_t depth = thread ? thread->depth : 0;
+    int32_t count = 0;
+    if (depth > 0) {
+        if (depth > OMNI_PROF_MAX_DEPTH) {
+            depth = OMNI_PROF_MAX_DEPTH;
+        }
+        int32_t first = depth > OMNI_PROF_SAMPLE_DEPTH ? depth - OMNI_PROF_SAMPLE_DEPTH : 0;
+        for (int32_t i = first; i < depth; i++) {
+            sample->frames[count++] = (uintptr_t)thread->frames[i].site;
+        }
+        sample->kind = OMNI_PROF_SAMPLE_SITES;
+    } else {
+#ifdef OMNI_HAVE_BACKTRACE
+        count = backtrace((void**)sample->frames, OMNI_PROF_SAMPLE_DEPTH);
+#endif
+        sample->kind = OMNI_PROF_SAMPLE_NATIVE;
+    }
+    __atomic_store_n(&sample->depth, count, __ATOMIC_RELEASE);
+    errno = saved_errno;
+}
+#endif
+
+int32_t omni_prof_start_sampling(int32_t hz) {
+#ifdef _WIN32
+    (void)hz;
+    return 0;
+#else
+    if (hz <= 0) {
+        hz = OMNI_PROF_DEFAULT_HZ;
+    }
+    if (hz > 1000000) {
+        hz = 1000000;
+    }
+    omni_mutex_lock(&omni_prof_state.mutex);
+    if (!omni_prof_state.samples) {
+        // Mostly untouched zero pages until samples arrive
+        omni_prof_state.samples = (omni_prof_sample_t*)calloc(OMNI_PROF_MAX_SAMPLES, sizeof(omni_prof_sample_t));
+        if (!omni_prof_state.samples) {
+            omni_mutex_unlock(&omni_prof_state.mutex);
+            return 0;
+        }
+    }
+#ifdef OMNI_HAVE_BACKTRACE
+    // The first backtrace() loads the unwinder, which must not happen in
+    // the signal handler
+    void* warmup[2];
+    backtrace(warmup, 2);
+#endif
+    if (!omni_prof_state.sampling) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = omni_prof_on_sigprof;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, &omni_prof_previous_action) != 0) {
+            omni_mutex_unlock(&omni_prof_state.mutex);
+            return 0;
+        }
+    }
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000 / hz;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+        if (!omni_prof_state.sampling) {
+            sigaction(SIGPROF, &omni_prof_previous_action, NULL);
+        }
+        omni_mutex_unlock(&omni_prof_state.mutex);
+        return 0;
+    }
+    omni_prof_state.sampling = 1;
+    omni_prof_install_exit_hook_locked();
+    omni_mutex_unlock(&omni_prof_state.mutex);
+    return 1;
+#endif
+}
+
+void omni_prof_stop_sampling(void) {
+#ifndef _WIN32
+    omni_mutex_lock(&omni_prof_state.mutex);
+    if (omni_prof_state.sampling) {
+        struct itimerval timer;
+        memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_PROF, &timer, NULL);
+        // A signal already raised still runs the handler; it can stay
+        // installed harmlessly until then
+        omni_prof_state.sampling = 0;
+    }
+    omni_mutex_unlock(&omni_prof_state.mutex);
+#endif
+}
+
+void omni_prof_reset(void) {
+    omni_mutex_lock(&omni_prof_state.mutex);
+    for (omni_prof_thread_t* thread = omni_prof_state.threads; thread; thread = thread->next) {
+        memset(thread->counters, 0, (size_t)omni_prof_state.site_count * sizeof(omni_prof_counter_t));
+    }
+    __atomic_store_n(&omni_prof_state.unattributed_allocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&omni_prof_state.unattributed_bytes, 0, __ATOMIC_RELAXED);
+    if (omni_prof_state.samples) {
+        uint64_t used = __atomic_exchange_n(&omni_prof_state.next_sample, 0, __ATOMIC_RELAXED);
+        if (used > OMNI_PROF_MAX_SAMPLES) {
+            used = OMNI_PROF_MAX_SAMPLES;
+        }
+        for (uint64_t i = 0; i < used; i++) {
+            __atomic_store_n(&omni_prof_state.samples[i].depth, 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&omni_prof_state.dropped_samples, 0, __ATOMIC_RELAXED);
+    }
+    omni_mutex_unlock(&omni_prof_state.mutex);
+}
+
+// The counters of every thread, summed per site; counters of threads still
+// running are a snapshot
+char* omni_prof_export(void) {
+    omni_strbuilder_t sb;
+    omni_strbuilder_init(&sb);
+    char number[160];
+
+    omni_mutex_lock(&omni_prof_state.mutex);
+    int32_t count = omni_prof_state.site_count;
+    omni_prof_counter_t* totals = (omni_prof_counter_t*)calloc(count > 0 ? (size_t)count : 1, sizeof(omni_prof_counter_t));
+    if (!totals) {
+        omni_mutex_unlock(&omni_prof_state.mutex);
+        omni_strbuilder_free(&sb);
+        return NULL;
+    }
+    for (omni_prof_thread_t* thread = omni_prof_state.threads; thread; thread = thread->next) {
+        for (int32_t i = 0; i < count; i++) {
+            totals[i].calls += thread->counters[i].calls;
+            totals[i].total_ns += thread->counters[i].total_ns;
+            totals[i].self_ns += thread->counters[i].self_ns;
+            totals[i].allocs += thread->counters[i].allocs;
+            totals[i].alloc_bytes += thread->counters[i].alloc_bytes;
+        }
+    }
+    omni_strbuilder_append_str(&sb, "{\"functions\":[");
+    for (int32_t i = 0; i < count; i++) {
+        const omni_prof_site_t* site = &omni_prof_state.sites[i];
+        omni_strbuilder_append_str(&sb, i == 0 ? "{\"function\":" : ",{\"function\":");
+        omni_coverage_append_json_string(&sb, site->function_name);
+        omni_strbuilder_append_str(&sb, ",\"file\":");
+        omni_coverage_append_json_string(&sb, site->file_path);
+        snprintf(number, sizeof(number),
+                 ",\"calls\":%llu,\"total_ns\":%lld,\"self_ns\":%lld,\"allocs\":%llu,\"alloc_bytes\":%llu}",
+                 (unsigned long long)totals[i].calls, (long long)totals[i].total_ns, (long long)totals[i].self_ns,
+                 (unsigned long long)totals[i].allocs, (unsigned long long)totals[i].alloc_bytes);
+        omni_strbuilder_append_str(&sb, number);
+    }
+    snprintf(number, sizeof(number), "],\"unattributed\":{\"allocs\":%llu,\"alloc_bytes\":%llu}}",
+             (unsigned long long)__atomic_load_n(&omni_prof_state.unattributed_allocs, __ATOMIC_RELAXED),
+             (unsigned long long)__atomic_load_n(&omni_prof_state.unattributed_bytes, __ATOMIC_RELAXED));
+    omni_strbuilder_append_str(&sb, number);
+    omni_mutex_unlock(&omni_prof_state.mutex);
+    free(totals);
+
+    // Callers free() the result, so it cannot stay an omni_str
+    char* built = omni_strbuilder_finish(&sb);
+    if (!built) {
+        return NULL;
+    }
+    char* text = strdup(built);
+    omni_str_free(built);
+    return text;
+}
+
+// Appends a frame name, replacing the characters that separate frames and
+// counts in the folded format
+static void omni_prof_append_frame(omni_strbuilder_t* sb, const char* name, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        omni_strbuilder_append_len(sb, (c == ';' || c == ' ' || c == '\n') ? "_" : &name[i], 1);
+    }
+}
+
+#ifdef OMNI_HAVE_BACKTRACE
+// Extracts the function name from a backtrace_symbols line:
+// "binary(function+0x1f) [0x...]" on glibc, "0  binary  0x...  function + 31"
+// on macOS. Frames without a symbol show as the binary's file name; anything
+// unrecognized as the whole line.
+static void omni_prof_append_native_frame(omni_strbuilder_t* sb, const char* symbol) {
+    const char* start = strchr(symbol, '(');
+    const char* end = NULL;
+    if (start) {
+        end = start;
+        start++;
+        if (*start == '+' || *start == ')') {
+            for (start = end; start > symbol && start[-1] != '/'; start--) {
+            }
+        } else {
+            end = start + strcspn(start, "+)");
+        }
+    } else if ((end = strstr(symbol, " + ")) != NULL) {
+        start = end;
+        while (start > symbol && start[-1] != ' ') {
+            start--;
+        }
+    }
+    if (start && end > start) {
+        omni_prof_append_frame(sb, start, (size_t)(end - start));
+    } else {
+        omni_prof_append_frame(sb, symbol, strlen(symbol));
+    }
+}
+#endif
+
+static int omni_prof_compare_lines(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+char* omni_prof_export_folded(void) {
+    omni_strbuilder_t sb;
+    omni_strbuilder_init(&sb);
+
+    omni_mutex_lock(&omni_prof_state.mutex);
+    uint64_t used = __atomic_load_n(&omni_prof_state.next_sample, __ATOMIC_RELAXED);
+    if (used > OMNI_PROF_MAX_SAMPLES) {
+        used = OMNI_PROF_MAX_SAMPLES;
+    }
+    char** lines = (char**)calloc(used > 0 ? (size_t)used : 1, sizeof(char*));
+    size_t line_count = 0;
+    for (uint64_t i = 0; lines && i < used; i++) {
+        omni_prof_sample_t* sample = &omni_prof_state.samples[i];
+        int32_t depth = __atomic_load_n(&sample->depth, __ATOMIC_ACQUIRE);
+        if (depth <= 0) {
+            continue;
+        }
+        omni_strbuilder_t line;
+        omni_strbuilder_init(&line);
+        if (sample->kind == OMNI_PROF_SAMPLE_SITES) {
+            for (int32_t f = 0; f < depth; f++) {
+                int32_t site = (int32_t)sample->frames[f];
+                const char* name = site < omni_prof_state.site_count ? omni_prof_state.sites[site].function_name : "?";
+                if (f > 0) omni_strbuilder_append_len(&line, ";", 1);
+                omni_prof_append_frame(&line, name, strlen(name));
+            }
+        }
+#ifdef OMNI_HAVE_BACKTRACE
+        else {
+            // Skip the handler and the signal trampoline, then go outermost first
+            int32_t skip = depth > 2 ? 2 : 0;
+            char** symbols = backtrace_symbols((void* const*)sample->frames, depth);
+            for (int32_t f = depth - 1; symbols && f >= skip; f--) {
+                if (f < depth - 1) omni_strbuilder_append_len(&line, ";", 1);
+                omni_prof_append_native_frame(&line, symbols[f]);
+            }
+            free(symbols);
+        }
+#endif
+        char* built = omni_strbuilder_finish(&line);
+        if (built) {
+            lines[line_count] = strdup(built);
+            if (lines[line_count]) line_count++;
+            omni_str_free(built);
+        }
+    }
+    omni_mutex_unlock(&omni_prof_state.mutex);
+
+    // Equal stacks end up adjacent; each run becomes one "stack count" line
+    if (line_count > 0) {
+        qsort(lines, line_count, sizeof(char*), omni_prof_compare_lines);
+    }
+    char number[32];
+    for (size_t i = 0; i < line_count;) {
+        size_t run = i + 1;
+        while (run < line_count && strcmp(lines[run], lines[i]) == 0) {
+            run++;
+        }
+        omni_strbuilder_append_str(&sb, lines[i]);
+        snprintf(number, sizeof(number), " %zu\n", run - i);
+        omni_strbuilder_append_str(&sb, number);
+        i = run;
+    }
+    for (size_t i = 0; i < line_count; i++) {
+        free(lines[i]);
+    }
+    free(lines);
+
+    // Callers free() the result, so it cannot stay an omni_str
+    char* built = omni_strbuilder_finish(&sb);
+    if (!built) {
+        return NULL;
+    }
+    char* text = strdup(built);
+    omni_str_free(built);
+    return text;
+}
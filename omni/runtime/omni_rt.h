@@ -18,6 +18,12 @@ void omni_log_info(const char* message);
 void omni_log_warn(const char* message);
 void omni_log_error(const char* message);
 int32_t omni_log_set_level(const char* level);
+// "sync" (default) writes each line before returning. "async" queues lines
+// in per-thread buffers for a background flusher and makes a thread whose
+// buffer is full wait for the write; "async_drop" drops the line instead.
+// Queued lines are flushed at exit and by omni_log_flush.
+int32_t omni_log_set_mode(const char* mode);
+void omni_log_flush(void);
 
 // Memory management
 void* omni_alloc(size_t size);
@@ -25,7 +31,82 @@ void omni_free(void* ptr);
 void* omni_malloc(size_t size);
 void* omni_realloc(void* ptr, size_t new_size);
 
+// Arena (region) allocator
+// Bump allocation out of chunked storage. Memory from an arena is never
+// passed to free(); it is reclaimed all at once by omni_arena_rewind/reset
+// (O(1), chunks are kept for reuse) or omni_arena_destroy.
+// Passing a NULL arena to omni_arena_alloc, omni_arena_strdup or any *_arena
+// string function falls back to malloc.
+typedef struct omni_arena omni_arena_t;
+typedef struct {
+    void* chunk;
+    size_t used;
+} omni_arena_mark_t;
+omni_arena_t* omni_arena_create(size_t chunk_size); // 0 = default chunk size
+void* omni_arena_alloc(omni_arena_t* arena, size_t size);
+char* omni_arena_strdup(omni_arena_t* arena, const char* str);
+omni_arena_mark_t omni_arena_mark(omni_arena_t* arena);
+void omni_arena_rewind(omni_arena_t* arena, omni_arena_mark_t mark);
+void omni_arena_reset(omni_arena_t* arena);
+void omni_arena_destroy(omni_arena_t* arena);
+// Per-thread arena used by the C backend for scoped temporaries
+omni_arena_t* omni_arena_scratch(void);
+
+// Length-prefixed strings
+// Every string the runtime allocates (strcat, substring, trim, case mapping,
+// number formatting, string builders) is an omni_str: an omni_str_header_t
+// followed by NUL-terminated bytes. The pointer handed out points at the
+// bytes, so an omni_str is an ordinary const char* everywhere, but its byte
+// length is O(1) and its rune count and hash are cached after the first use.
+// omni_str_* functions must only be given omni_str pointers, never literals
+// or foreign strings.
+//
+// Ownership: C code calling the runtime directly must release every heap
+// string it gets from these functions with omni_str_free. The allocation
+// starts at the header, so passing one to free() frees an interior pointer.
+// Functions documented as returning a copy to release "using free()" (file
+// reads, awaited strings) still return plain malloc blocks.
+typedef struct {
+    size_t len;       // Byte length, excluding the terminator
+    int32_t runes;    // UTF-8 rune count, -1 until counted
+    uint32_t hash;    // Cached hash, 0 until computed
+    uint32_t flags;
+} omni_str_header_t;
+
+char* omni_str_alloc(omni_arena_t* arena, size_t len);
+char* omni_str_new(omni_arena_t* arena, const char* data, size_t len);
+size_t omni_str_len(const char* s);
+int32_t omni_str_rune_count(const char* s);
+uint32_t omni_str_hash(const char* s);
+int32_t omni_str_equals(const char* a, const char* b);
+void omni_str_free(const char* s);
+
+// String interning
+// omni_intern returns the canonical omni_str for the given contents, creating
+// it on first use; equal strings always intern to the same pointer, and the
+// hash is computed once at that point. Interned strings live for the rest of
+// the program, so intern a bounded set such as constant keys and field names;
+// maps store keys that are not interned as copies they own and free.
+// Thread-safe; lookups take no lock.
+const char* omni_intern(const char* str);
+const char* omni_intern_len(const char* str, size_t len);
+// Returns the canonical pointer if str has been interned, NULL otherwise
+const char* omni_intern_lookup(const char* str);
+int32_t omni_is_interned(const char* str);
+
+// Length-aware fast paths: callers that already know byte lengths (omni_str
+// headers, literals) pass them instead of having them rescanned
+char* omni_strcat_len(omni_arena_t* arena, const char* str1, size_t len1, const char* str2, size_t len2);
+char* omni_substring_len(omni_arena_t* arena, const char* str, size_t len, int32_t start, int32_t end);
+char omni_char_at_len(const char* str, size_t len, int32_t index);
+int32_t omni_starts_with_len(const char* str, size_t len, const char* prefix, size_t prefix_len);
+int32_t omni_ends_with_len(const char* str, size_t len, const char* suffix, size_t suffix_len);
+int32_t omni_contains_len(const char* str, size_t len, const char* substr, size_t substr_len);
+int32_t omni_index_of_len(const char* str, size_t len, const char* substr, size_t substr_len);
+int32_t omni_string_equals_len(const char* a, size_t a_len, const char* b, size_t b_len);
+
 // String operations
+// Allocating operations return heap omni_strs (release with omni_str_free)
 char* omni_strcat(const char* str1, const char* str2);
 int32_t omni_strlen(const char* str);
 char* omni_substring(const char* str, int32_t start, int32_t end);
@@ -38,25 +119,92 @@ int32_t omni_last_index_of(const char* str, const char* substr);
 char* omni_trim(const char* str);
 char* omni_to_upper(const char* str);
 char* omni_to_lower(const char* str);
+// Arena-backed variants of the allocating string operations above
+char* omni_strcat_arena(omni_arena_t* arena, const char* str1, const char* str2);
+char* omni_substring_arena(omni_arena_t* arena, const char* str, int32_t start, int32_t end);
+char* omni_trim_arena(omni_arena_t* arena, const char* str);
+char* omni_to_upper_arena(omni_arena_t* arena, const char* str);
+char* omni_to_lower_arena(omni_arena_t* arena, const char* str);
 int32_t omni_string_equals(const char* a, const char* b);
 int32_t omni_string_compare(const char* a, const char* b);
 
-// Promise/Async support (simplified synchronous implementation)
+// String builder
+// Collects pieces in a growable buffer and produces the result with a single
+// final allocation. Short strings are built in the inline buffer, so a builder
+// must not be copied or moved once initialized. finish returns a heap
+// omni_str (or, for finish_arena, one owned by the arena) and leaves the
+// builder empty and reusable; free discards the contents.
+#define OMNI_STRBUILDER_INLINE 128
 typedef struct {
-    void* value;
-    int32_t type;  // 0=int, 1=string, 2=float, 3=bool
-    int32_t done;
-} omni_promise_t;
+    char* data;
+    size_t len;
+    size_t cap;
+    char inline_buf[OMNI_STRBUILDER_INLINE];
+} omni_strbuilder_t;
 
-// Create a resolved promise (synchronous implementation)
+void omni_strbuilder_init(omni_strbuilder_t* sb);
+int omni_strbuilder_reserve(omni_strbuilder_t* sb, size_t additional);
+void omni_strbuilder_append_str(omni_strbuilder_t* sb, const char* str);
+void omni_strbuilder_append_len(omni_strbuilder_t* sb, const char* str, size_t len);
+void omni_strbuilder_append_int(omni_strbuilder_t* sb, int32_t value);
+void omni_strbuilder_append_float(omni_strbuilder_t* sb, double value);
+void omni_strbuilder_append_bool(omni_strbuilder_t* sb, int32_t value);
+char* omni_strbuilder_finish(omni_strbuilder_t* sb);
+char* omni_strbuilder_finish_arena(omni_strbuilder_t* sb, omni_arena_t* arena);
+void omni_strbuilder_free(omni_strbuilder_t* sb);
+
+// Task scheduler
+// Tasks run on a pool of worker threads (one per core, or OMNI_WORKERS),
+// started on first use. Each worker has a work-stealing deque: tasks spawned
+// by a worker go to its own deque, idle workers steal from the others, and
+// tasks spawned from other threads go through a shared queue.
+typedef void (*omni_task_fn)(void* arg);
+void omni_task_spawn(omni_task_fn fn, void* arg);
+// Worker count, starting the pool if needed (0 if no thread could start, in
+// which case tasks run inline)
+int32_t omni_scheduler_workers(void);
+
+// Promise/Async support
+// A promise is pending until it is resolved, once; later resolutions are
+// ignored. omni_await_* returns the value, and while the promise is pending
+// the awaiting thread runs other scheduled tasks instead of blocking (socket
+// promises, settled by the event loop, block the waiter instead, with a
+// spare thread taking over a blocked worker's share of the tasks).
+// Promises are reference counted: omni_promise_free drops a reference.
+#define OMNI_PROMISE_INT 0
+#define OMNI_PROMISE_STRING 1
+#define OMNI_PROMISE_FLOAT 2
+#define OMNI_PROMISE_BOOL 3
+
+typedef struct omni_promise omni_promise_t;
+typedef void (*omni_promise_callback_t)(omni_promise_t* promise, void* arg);
+typedef void (*omni_async_fn)(omni_promise_t* promise, void* arg);
+
+omni_promise_t* omni_promise_new(int32_t type);
+omni_promise_t* omni_promise_retain(omni_promise_t* promise);
+void omni_promise_resolve_int(omni_promise_t* promise, int32_t value);
+// Copies value
+void omni_promise_resolve_string(omni_promise_t* promise, const char* value);
+void omni_promise_resolve_float(omni_promise_t* promise, double value);
+void omni_promise_resolve_bool(omni_promise_t* promise, int32_t value);
+int32_t omni_promise_is_done(omni_promise_t* promise);
+// Runs callback once the promise is resolved: on the resolving thread, or
+// right away if it already is
+void omni_promise_then(omni_promise_t* promise, omni_promise_callback_t callback, void* arg);
+
+// Runs fn(promise, arg) as a task and returns its pending promise, which fn
+// resolves
+omni_promise_t* omni_async_call(int32_t type, omni_async_fn fn, void* arg);
+
+// Create a resolved promise
 omni_promise_t* omni_promise_create_int(int32_t value);
 omni_promise_t* omni_promise_create_string(const char* value);
 omni_promise_t* omni_promise_create_float(double value);
 omni_promise_t* omni_promise_create_bool(int32_t value);
 
-// Await a promise (synchronous - just extracts the value)
+// Await a promise
 int32_t omni_await_int(omni_promise_t* promise);
-// Returns a newly allocated copy of the string - caller must free it
+// Returns a newly allocated copy of the string - caller must free it using free()
 char* omni_await_string(omni_promise_t* promise);
 double omni_await_float(omni_promise_t* promise);
 int32_t omni_await_bool(omni_promise_t* promise);
@@ -64,6 +212,52 @@ int32_t omni_await_bool(omni_promise_t* promise);
 // Free a promise
 void omni_promise_free(omni_promise_t* promise);
 
+// Channels
+// Multi-producer/multi-consumer channels of elem_size-byte elements, copied
+// in and out. A capacity is rounded up to a power of two (at least 2); one <= 0
+// makes the channel unbounded. send/recv block while the channel is
+// full/empty and return 1, or 0 once it is closed (recv still drains what
+// was sent before the close); the try_ forms never block. send_n blocks
+// until all count elements are sent and returns how many were (fewer only
+// if the channel closed); recv_n blocks until at least one element is
+// available and returns how many it took, up to max. Blocking parks the
+// calling thread; a scheduler worker that blocks is stood in for by a
+// spare thread so other tasks keep running. This is a C-level API for now:
+// OmniLang has no channel type, so std does not expose it.
+typedef struct omni_chan omni_chan_t;
+omni_chan_t* omni_chan_create(int32_t elem_size, int32_t capacity);
+// Only once no thread uses the channel any more
+void omni_chan_destroy(omni_chan_t* ch);
+int32_t omni_chan_send(omni_chan_t* ch, const void* elem);
+int32_t omni_chan_recv(omni_chan_t* ch, void* out);
+int32_t omni_chan_try_send(omni_chan_t* ch, const void* elem);
+int32_t omni_chan_try_recv(omni_chan_t* ch, void* out);
+int32_t omni_chan_send_n(omni_chan_t* ch, const void* elems, int32_t count);
+int32_t omni_chan_recv_n(omni_chan_t* ch, void* out, int32_t max);
+// Wakes every blocked sender and receiver; later sends fail
+void omni_chan_close(omni_chan_t* ch);
+int32_t omni_chan_is_closed(omni_chan_t* ch);
+// Approximate while other threads use the channel
+int32_t omni_chan_len(omni_chan_t* ch);
+// 0 for an unbounded channel
+int32_t omni_chan_capacity(omni_chan_t* ch);
+
+// omni_chan_select completes one of count cases, picked among those ready
+// (a closed channel is ready with ok = 0), and returns its index. A case
+// with a NULL channel is never ready. With block = 0 it returns -1 when
+// no case is ready; blocking, it returns -1 only if every channel is NULL.
+#define OMNI_CHAN_SEND 0
+#define OMNI_CHAN_RECV 1
+
+typedef struct {
+    omni_chan_t* chan;
+    int32_t dir;  // OMNI_CHAN_SEND or OMNI_CHAN_RECV
+    void* data;   // Element to send, or where to receive into
+    int32_t ok;   // Set on the chosen case
+} omni_chan_case_t;
+
+int32_t omni_chan_select(omni_chan_case_t* cases, int32_t count, int32_t block);
+
 // Array operations
 // omni_len returns the length of an array. The length must be passed explicitly
 // by the backend since C arrays don't carry length metadata.
@@ -80,10 +274,31 @@ int32_t omni_min(int32_t a, int32_t b);
 char* omni_int_to_string(int32_t value);
 char* omni_float_to_string(double value);
 char* omni_bool_to_string(int32_t value);
+char* omni_int_to_string_arena(omni_arena_t* arena, int32_t value);
+char* omni_float_to_string_arena(omni_arena_t* arena, double value);
+char* omni_bool_to_string_arena(omni_arena_t* arena, int32_t value);
 int32_t omni_string_to_int(const char* str);
 double omni_string_to_float(const char* str);
 int32_t omni_string_to_bool(const char* str);
 
+// Number formatting and parsing
+// omni_format_int and omni_format_float write a number, unterminated, to buf
+// and return its length; buf needs room for OMNI_FMT_INT_MAX or
+// OMNI_FMT_FLOAT_MAX bytes. A double is written with the fewest digits that
+// parse back to the same value, laid out as %g lays it out (exponent form
+// below 1e-4 and from 1e6), or as +Inf, -Inf or NaN. omni_parse_int and
+// omni_parse_float read a number at the very start of str[0, len), in the C
+// locale whatever the current one is, and return the bytes consumed, or 0
+// when there is none. Integers saturate at the int64 limits; floats round
+// to infinity or zero when out of range. None of them allocate, and the
+// conversions above and the string builder's number appends use them.
+#define OMNI_FMT_INT_MAX 20
+#define OMNI_FMT_FLOAT_MAX 24
+size_t omni_format_int(char* buf, int64_t value);
+size_t omni_format_float(char* buf, double value);
+size_t omni_parse_int(const char* str, size_t len, int64_t* out);
+size_t omni_parse_float(const char* str, size_t len, double* out);
+
 // Array operations
 int32_t omni_array_length(int32_t* arr);
 // Array get/set operations with bounds checking
@@ -91,6 +306,81 @@ int32_t omni_array_length(int32_t* arr);
 int32_t omni_array_get_int(int32_t* arr, int32_t index, int32_t length);
 void omni_array_set_int(int32_t* arr, int32_t index, int32_t value, int32_t length);
 
+// Inline bounds check emitted by the C backend around array accesses it
+// cannot prove in range. Being inline, it costs a compare and lets the C
+// compiler drop the check where it can prove the index in range itself.
+void omni_array_bounds_fail(int32_t index, int32_t length)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((noreturn, cold))
+#endif
+    ;
+static inline int32_t omni_array_check_index(int32_t index, int32_t length) {
+#if defined(__GNUC__) || defined(__clang__)
+    if (__builtin_expect((uint32_t)index >= (uint32_t)length, 0)) omni_array_bounds_fail(index, length);
+#else
+    if ((uint32_t)index >= (uint32_t)length) omni_array_bounds_fail(index, length);
+#endif
+    return index;
+}
+
+// Typed vectors
+// A growable array that carries its length, capacity and element kind.
+// push, reserve, resize, append and copy return 0 on allocation failure or
+// a kind mismatch. get/set check the index like array accesses do; data
+// may be used directly for indices below length and is invalidated by any
+// call that grows the vector. The *_int kernels use SIMD where available:
+// sum widens to 64 bits, min/max return 0 for an empty vector, find
+// returns the first index >= from holding value or -1, and compare orders
+// vectors lexicographically (-1, 0, 1).
+#define OMNI_VEC_INT 0
+#define OMNI_VEC_INT64 1
+#define OMNI_VEC_DOUBLE 2
+#define OMNI_VEC_PTR 3
+typedef struct {
+    void* data;
+    int32_t length;
+    int32_t capacity;
+    int32_t elem_size;
+    int32_t kind;
+} omni_vec_t;
+
+omni_vec_t* omni_vec_create(int32_t kind, int32_t capacity);
+omni_vec_t* omni_vec_from(int32_t kind, const void* data, int32_t length);
+void omni_vec_destroy(omni_vec_t* vec);
+int32_t omni_vec_reserve(omni_vec_t* vec, int32_t capacity);
+int32_t omni_vec_resize(omni_vec_t* vec, int32_t length);
+void omni_vec_clear(omni_vec_t* vec);
+int32_t omni_vec_length(const omni_vec_t* vec);
+int32_t omni_vec_push_int(omni_vec_t* vec, int32_t value);
+int32_t omni_vec_push_int64(omni_vec_t* vec, int64_t value);
+int32_t omni_vec_push_double(omni_vec_t* vec, double value);
+int32_t omni_vec_push_ptr(omni_vec_t* vec, void* value);
+int32_t omni_vec_append(omni_vec_t* dst, const omni_vec_t* src);
+int32_t omni_vec_copy(omni_vec_t* dst, const omni_vec_t* src);
+int32_t omni_vec_equal(const omni_vec_t* a, const omni_vec_t* b);
+
+static inline int32_t omni_vec_get_int(const omni_vec_t* vec, int32_t index) {
+    return ((const int32_t*)vec->data)[omni_array_check_index(index, vec->length)];
+}
+static inline void omni_vec_set_int(omni_vec_t* vec, int32_t index, int32_t value) {
+    ((int32_t*)vec->data)[omni_array_check_index(index, vec->length)] = value;
+}
+static inline double omni_vec_get_double(const omni_vec_t* vec, int32_t index) {
+    return ((const double*)vec->data)[omni_array_check_index(index, vec->length)];
+}
+static inline void omni_vec_set_double(omni_vec_t* vec, int32_t index, double value) {
+    ((double*)vec->data)[omni_array_check_index(index, vec->length)] = value;
+}
+
+int64_t omni_vec_sum_int(const omni_vec_t* vec);
+int32_t omni_vec_min_int(const omni_vec_t* vec, int32_t* out);
+int32_t omni_vec_max_int(const omni_vec_t* vec, int32_t* out);
+void omni_vec_fill_int(omni_vec_t* vec, int32_t value);
+int32_t omni_vec_find_int(const omni_vec_t* vec, int32_t value, int32_t from);
+int32_t omni_vec_compare_int(const omni_vec_t* a, const omni_vec_t* b);
+double omni_vec_sum_double(const omni_vec_t* vec);
+void omni_vec_fill_double(omni_vec_t* vec, double value);
+
 // Map operations
 typedef struct omni_map omni_map_t;
 omni_map_t* omni_map_create();
@@ -130,6 +420,37 @@ int32_t omni_map_values_string_int(omni_map_t* map, int32_t* values_buffer, int3
 omni_map_t* omni_map_copy_string_int(omni_map_t* map);
 omni_map_t* omni_map_merge_string_int(omni_map_t* a, omni_map_t* b);
 
+// Parallel algorithms
+// Run on the task scheduler, with the calling thread taking part; small
+// inputs stay on the calling thread. omni_parallel_for calls fn on disjoint
+// subranges that together cover [begin, end), possibly concurrently, and
+// returns once all have finished. grain is the largest subrange fn is given
+// (0 picks one from the worker count).
+typedef void (*omni_parallel_range_fn)(void* ctx, int64_t begin, int64_t end);
+void omni_parallel_for(int64_t begin, int64_t end, int64_t grain, omni_parallel_range_fn fn, void* ctx);
+// In-place sorts: ints by radix sort, strings (by strcmp) by merge sort.
+// Return 0, leaving data unchanged, if scratch space could not be allocated.
+int32_t omni_parallel_sort_int(int32_t* data, int64_t n);
+int32_t omni_parallel_sort_string(const char** data, int64_t n);
+// omni_parallel_map returns a vector of the given kind and src's length,
+// with fn filling consecutive runs of it from the matching runs of src.
+// omni_parallel_reduce folds runs of vec into private accumulators that
+// start as copies of *acc, then combines them into *acc in element order,
+// so combine only needs to be associative. Returns 0 on allocation failure.
+typedef void (*omni_parallel_map_fn)(void* ctx, const void* src, void* dst, int64_t count);
+typedef void (*omni_parallel_fold_fn)(void* ctx, const void* src, int64_t count, void* acc);
+typedef void (*omni_parallel_combine_fn)(void* ctx, void* acc, const void* other);
+omni_vec_t* omni_parallel_map(const omni_vec_t* src, int32_t kind, omni_parallel_map_fn fn, void* ctx);
+int32_t omni_parallel_reduce(const omni_vec_t* vec, void* acc, size_t acc_size,
+                             omni_parallel_fold_fn fold, omni_parallel_combine_fn combine, void* ctx);
+// Reductions over plain int arrays; min and max of no elements are 0
+int64_t omni_parallel_sum_int(const int32_t* data, int64_t n);
+int32_t omni_parallel_min_int(const int32_t* data, int64_t n);
+int32_t omni_parallel_max_int(const int32_t* data, int64_t n);
+// Builds an int -> int map from keys[i] -> values[i]; a repeated key keeps
+// its last value, as with successive puts
+omni_map_t* omni_parallel_build_map_int(const int32_t* keys, const int32_t* values, int64_t n);
+
 // Collection data structures (using maps as base implementation)
 // Sets, queues, stacks, priority queues, linked lists, and binary trees
 // For now, we'll use simplified implementations that can be extended later
@@ -140,7 +461,10 @@ typedef struct omni_priority_queue omni_priority_queue_t;
 typedef struct omni_linked_list omni_linked_list_t;
 typedef struct omni_binary_tree omni_binary_tree_t;
 
-// Set operations (using map internally for O(1) lookups)
+// Set operations (roaring bitmap: sorted arrays or bitmaps per 64K chunk)
+// add and remove return 1 only when they changed the set. The *_with
+// variants update a in place and return 0 if an allocation failed, in which
+// case a is still a valid set but may be only partly updated.
 omni_set_t* omni_set_create();
 void omni_set_destroy(omni_set_t* set);
 int32_t omni_set_add(omni_set_t* set, int32_t element);
@@ -151,37 +475,88 @@ void omni_set_clear(omni_set_t* set);
 omni_set_t* omni_set_union(omni_set_t* a, omni_set_t* b);
 omni_set_t* omni_set_intersection(omni_set_t* a, omni_set_t* b);
 omni_set_t* omni_set_difference(omni_set_t* a, omni_set_t* b);
+int32_t omni_set_union_with(omni_set_t* a, omni_set_t* b);
+int32_t omni_set_intersect_with(omni_set_t* a, omni_set_t* b);
+int32_t omni_set_difference_with(omni_set_t* a, omni_set_t* b);
 
-// Queue operations (FIFO)
+// Queue operations (FIFO, growable ring buffer)
+// reserve returns 0 if the space cannot be allocated; enqueue_n adds all
+// of the batch or nothing, dequeue_n takes up to max and returns the count.
 omni_queue_t* omni_queue_create();
 void omni_queue_destroy(omni_queue_t* queue);
+int32_t omni_queue_reserve(omni_queue_t* queue, int32_t capacity);
 void omni_queue_enqueue(omni_queue_t* queue, int32_t element);
+int32_t omni_queue_enqueue_n(omni_queue_t* queue, const int32_t* elements, int32_t count);
 int32_t omni_queue_dequeue(omni_queue_t* queue);
+int32_t omni_queue_dequeue_n(omni_queue_t* queue, int32_t* out, int32_t max);
 int32_t omni_queue_peek(omni_queue_t* queue);
 int32_t omni_queue_is_empty(omni_queue_t* queue);
 int32_t omni_queue_size(omni_queue_t* queue);
 void omni_queue_clear(omni_queue_t* queue);
 
-// Stack operations (LIFO)
+// Stack operations (LIFO, growable array)
+// push_n pushes elements[0] first; pop_n writes the old top to out[0].
 omni_stack_t* omni_stack_create();
 void omni_stack_destroy(omni_stack_t* stack);
+int32_t omni_stack_reserve(omni_stack_t* stack, int32_t capacity);
 void omni_stack_push(omni_stack_t* stack, int32_t element);
+int32_t omni_stack_push_n(omni_stack_t* stack, const int32_t* elements, int32_t count);
 int32_t omni_stack_pop(omni_stack_t* stack);
+int32_t omni_stack_pop_n(omni_stack_t* stack, int32_t* out, int32_t max);
 int32_t omni_stack_peek(omni_stack_t* stack);
 int32_t omni_stack_is_empty(omni_stack_t* stack);
 int32_t omni_stack_size(omni_stack_t* stack);
 void omni_stack_clear(omni_stack_t* stack);
 
-// Priority queue operations (max-heap)
+// Single-producer/single-consumer queue
+// A bounded lock-free ring (capacity rounded up to a power of two) for
+// handing values from exactly one producer thread to exactly one consumer
+// thread. push/pop return 1 on success and 0 when full/empty; the _n forms
+// move as many as fit and return the count. Values are 64-bit so they can
+// carry pointers.
+typedef struct omni_spsc_queue omni_spsc_queue_t;
+omni_spsc_queue_t* omni_spsc_queue_create(int32_t capacity);
+void omni_spsc_queue_destroy(omni_spsc_queue_t* q);
+int32_t omni_spsc_queue_push(omni_spsc_queue_t* q, int64_t value);
+int32_t omni_spsc_queue_push_n(omni_spsc_queue_t* q, const int64_t* values, int32_t count);
+int32_t omni_spsc_queue_pop(omni_spsc_queue_t* q, int64_t* out);
+int32_t omni_spsc_queue_pop_n(omni_spsc_queue_t* q, int64_t* out, int32_t max);
+int32_t omni_spsc_queue_size(omni_spsc_queue_t* q);
+int32_t omni_spsc_queue_capacity(omni_spsc_queue_t* q);
+
+// Priority queue operations (growable 4-ary heap)
+// omni_priority_queue_create builds a max-heap, _create_min a min-heap;
+// priorities are 64-bit internally, insert is the 32-bit shorthand for push.
+// "top" and extract_max mean the highest priority on a max-heap and the
+// lowest on a min-heap. insert/push return a handle (-1 on allocation
+// failure) that names the element until it is extracted or removed.
+// decrease_key only moves an element toward the top and returns 0 for the
+// other direction; update accepts either. push_n heapifies the batch in
+// O(n) when it outweighs the existing heap.
 omni_priority_queue_t* omni_priority_queue_create();
+omni_priority_queue_t* omni_priority_queue_create_min();
 void omni_priority_queue_destroy(omni_priority_queue_t* pq);
-void omni_priority_queue_insert(omni_priority_queue_t* pq, int32_t element, int32_t priority);
+int32_t omni_priority_queue_reserve(omni_priority_queue_t* pq, int32_t capacity);
+int32_t omni_priority_queue_insert(omni_priority_queue_t* pq, int32_t element, int32_t priority);
+int32_t omni_priority_queue_push(omni_priority_queue_t* pq, int32_t element, int64_t priority);
+int32_t omni_priority_queue_push_n(omni_priority_queue_t* pq, const int32_t* elements,
+                                   const int64_t* priorities, int32_t count, int32_t* handles);
 int32_t omni_priority_queue_extract_max(omni_priority_queue_t* pq);
+int32_t omni_priority_queue_pop(omni_priority_queue_t* pq);
+int32_t omni_priority_queue_extract_top_k(omni_priority_queue_t* pq, int32_t k, int32_t* out);
 int32_t omni_priority_queue_peek(omni_priority_queue_t* pq);
+int64_t omni_priority_queue_peek_priority(omni_priority_queue_t* pq);
+int32_t omni_priority_queue_decrease_key(omni_priority_queue_t* pq, int32_t handle, int64_t priority);
+int32_t omni_priority_queue_update(omni_priority_queue_t* pq, int32_t handle, int64_t priority);
+int32_t omni_priority_queue_remove(omni_priority_queue_t* pq, int32_t handle);
+int32_t omni_priority_queue_contains(omni_priority_queue_t* pq, int32_t handle);
 int32_t omni_priority_queue_is_empty(omni_priority_queue_t* pq);
 int32_t omni_priority_queue_size(omni_priority_queue_t* pq);
+void omni_priority_queue_clear(omni_priority_queue_t* pq);
 
-// Linked list operations
+// Linked list operations (unrolled list)
+// Index operations resume from the last position they resolved, so walking
+// indexes in order is O(1) per step.
 omni_linked_list_t* omni_linked_list_create();
 void omni_linked_list_destroy(omni_linked_list_t* ll);
 void omni_linked_list_append(omni_linked_list_t* ll, int32_t element);
@@ -194,16 +569,69 @@ int32_t omni_linked_list_size(omni_linked_list_t* ll);
 int32_t omni_linked_list_is_empty(omni_linked_list_t* ll);
 void omni_linked_list_clear(omni_linked_list_t* ll);
 
-// Binary tree operations (BST)
+// Linked list cursors
+// A cursor names one element, or the end of the list once valid() returns
+// 0. insert_at_cursor inserts before the named element (appends at the end)
+// and keeps the cursor on the same element; remove_at_cursor moves it to
+// the following element. Changing the list other than through a cursor
+// invalidates every cursor on it, as does a cursor change for other cursors.
+struct omni_linked_list_node;
+typedef struct {
+    omni_linked_list_t* list;
+    struct omni_linked_list_node* node;
+    int32_t offset;
+    int32_t index;
+} omni_linked_list_cursor_t;
+
+omni_linked_list_cursor_t omni_linked_list_begin(omni_linked_list_t* ll);
+int32_t omni_linked_list_cursor_valid(const omni_linked_list_cursor_t* cursor);
+int32_t omni_linked_list_cursor_value(const omni_linked_list_cursor_t* cursor);
+int32_t omni_linked_list_cursor_index(const omni_linked_list_cursor_t* cursor);
+void omni_linked_list_next(omni_linked_list_cursor_t* cursor);
+int32_t omni_linked_list_insert_at_cursor(omni_linked_list_cursor_t* cursor, int32_t element);
+int32_t omni_linked_list_remove_at_cursor(omni_linked_list_cursor_t* cursor);
+
+// Binary tree operations
+// An ordered set of int32 keys stored as a B+-tree with wide nodes, so
+// lookups stay logarithmic for any insertion order. Duplicates are ignored;
+// add reports whether the key was new (0 also on allocation failure).
 omni_binary_tree_t* omni_binary_tree_create();
 void omni_binary_tree_destroy(omni_binary_tree_t* bt);
 void omni_binary_tree_insert(omni_binary_tree_t* bt, int32_t element);
+int32_t omni_binary_tree_add(omni_binary_tree_t* bt, int32_t element);
 int32_t omni_binary_tree_search(omni_binary_tree_t* bt, int32_t element);
 int32_t omni_binary_tree_remove(omni_binary_tree_t* bt, int32_t element);
 int32_t omni_binary_tree_size(omni_binary_tree_t* bt);
 int32_t omni_binary_tree_is_empty(omni_binary_tree_t* bt);
 void omni_binary_tree_clear(omni_binary_tree_t* bt);
 
+// Ordered queries
+// min/max and the bounds return 1 and store the key in *out, or return 0
+// when there is none. lower_bound finds the smallest key >= key,
+// upper_bound the smallest key > key. range copies the keys in [lo, hi] in
+// ascending order into out, at most max of them, and returns how many it
+// copied; with out == NULL it only counts them.
+int32_t omni_binary_tree_min(omni_binary_tree_t* bt, int32_t* out);
+int32_t omni_binary_tree_max(omni_binary_tree_t* bt, int32_t* out);
+int32_t omni_binary_tree_lower_bound(omni_binary_tree_t* bt, int32_t key, int32_t* out);
+int32_t omni_binary_tree_upper_bound(omni_binary_tree_t* bt, int32_t key, int32_t* out);
+int32_t omni_binary_tree_range(omni_binary_tree_t* bt, int32_t lo, int32_t hi, int32_t* out, int32_t max);
+
+// In-order iterators
+// begin starts at the smallest key, seek at the lower bound of key. An
+// iterator walks the leaf chain and is invalidated by any change to the tree.
+struct omni_bt_leaf;
+typedef struct {
+    struct omni_bt_leaf* leaf;
+    int32_t index;
+} omni_binary_tree_iter_t;
+
+omni_binary_tree_iter_t omni_binary_tree_iter_begin(omni_binary_tree_t* bt);
+omni_binary_tree_iter_t omni_binary_tree_iter_seek(omni_binary_tree_t* bt, int32_t key);
+int32_t omni_binary_tree_iter_valid(const omni_binary_tree_iter_t* it);
+int32_t omni_binary_tree_iter_value(const omni_binary_tree_iter_t* it);
+void omni_binary_tree_iter_next(omni_binary_tree_iter_t* it);
+
 // Network structures and functions
 typedef struct omni_ip_address {
     char address[64];
@@ -230,8 +658,9 @@ typedef struct omni_http_request {
 typedef struct omni_http_response {
     int32_t status_code;
     char status_text[64];
-    omni_map_t* headers;
-    char* body;
+    omni_map_t* headers; // Lower-cased names; values point into header_block
+    char* body;          // omni_str, so a binary body keeps its length
+    char* header_block;  // The response head as received, owned by the response
 } omni_http_response_t;
 
 // IP address functions
@@ -247,10 +676,22 @@ char* omni_url_to_string(omni_url_t* url);
 int32_t omni_url_is_valid(const char* url_str);
 
 // DNS functions
+// Results are cached for their records' TTL, and failed lookups for the
+// zone's negative TTL. lookup returns the IPv4 and IPv6 addresses in one
+// allocation (free() releases the array and the addresses it points to), or
+// NULL with *count = 0. lookup_async resolves to the addresses joined by
+// commas ("" if there are none).
 omni_ip_address_t** omni_dns_lookup(const char* hostname, int32_t* count);
+omni_promise_t* omni_dns_lookup_async(const char* hostname);
 char* omni_dns_reverse_lookup(omni_ip_address_t* ip);
+void omni_dns_cache_clear(void);
 
 // HTTP client functions
+// HTTP/1.1 over plain TCP (http:// URLs only; there is no TLS). Connections
+// are kept alive in a per-host pool and reused by later requests. A NULL
+// response means the request could not be completed: bad URL, connection
+// failure, malformed response or a peer silent for 30 seconds.
+// get_header matches names case-insensitively and returns a copy to free.
 omni_http_response_t* omni_http_get(const char* url);
 omni_http_response_t* omni_http_post(const char* url, const char* body);
 omni_http_response_t* omni_http_put(const char* url, const char* body);
@@ -266,9 +707,17 @@ void omni_http_request_set_header(omni_http_request_t* req, const char* name, co
 void omni_http_request_set_body(omni_http_request_t* req, const char* body);
 char* omni_http_request_get_header(omni_http_request_t* req, const char* name);
 void omni_http_request_destroy(omni_http_request_t* req);
+// Performs count requests concurrently and stores the response to
+// requests[i] in responses[i] (NULL if it failed); returns how many
+// succeeded. Requests to one host share a few connections, and requests
+// without a body and with an idempotent method are pipelined on them.
+int32_t omni_http_request_all(omni_http_request_t** requests, omni_http_response_t** responses, int32_t count);
+// Closes the idle pooled connections
+void omni_http_pool_clear(void);
 
 // Socket functions
 int32_t omni_socket_create();
+// address is an IPv4 address or a host name, resolved through the DNS cache
 int32_t omni_socket_connect(int32_t socket, const char* address, int32_t port);
 int32_t omni_socket_bind(int32_t socket, const char* address, int32_t port);
 int32_t omni_socket_listen(int32_t socket, int32_t backlog);
@@ -276,6 +725,65 @@ int32_t omni_socket_accept(int32_t socket);
 int32_t omni_socket_send(int32_t socket, const char* data);
 int32_t omni_socket_receive(int32_t socket, char* buffer, int32_t buffer_size);
 int32_t omni_socket_close(int32_t socket);
+// Binary-safe transfer: send_bytes sends all len bytes, retrying short
+// writes, and returns the count sent (less on a full non-blocking socket)
+// or -1; receive_bytes performs a single receive into buffer and returns the
+// count read, 0 at end of stream or -1
+int64_t omni_socket_send_bytes(int32_t socket, const void* data, int64_t len);
+int64_t omni_socket_receive_bytes(int32_t socket, void* buffer, int64_t size);
+// Receives up to max_len bytes as an omni_str ("" at end of stream or on
+// error); embedded NULs are kept and counted by omni_str_len
+char* omni_socket_receive_string(int32_t socket, int32_t max_len);
+int32_t omni_socket_set_nonblocking(int32_t socket, int32_t enable);
+int32_t omni_socket_set_reuse_port(int32_t socket, int32_t enable);
+// Creates a listening socket with SO_REUSEADDR and SO_REUSEPORT set, so
+// several acceptors (one per thread or process) can listen on the same
+// port and the kernel spreads incoming connections across them. Returns
+// the socket or -1.
+int32_t omni_socket_listen_shared(const char* address, int32_t port, int32_t backlog);
+
+// Event loop
+// Readiness notification over epoll (Linux), kqueue (macOS and the BSDs) or
+// poll elsewhere. A watch registers a callback for OMNI_EV_READ and/or
+// OMNI_EV_WRITE on a descriptor; the callback receives the ready events,
+// with OMNI_EV_ERROR added on hangup or error. OMNI_EV_ONESHOT watches are
+// disarmed after one callback and re-armed with omni_event_loop_modify (or
+// replaced with omni_event_loop_add). Watches may be changed from any
+// thread; callbacks run on the thread calling run/run_once.
+#define OMNI_EV_READ 1
+#define OMNI_EV_WRITE 2
+#define OMNI_EV_ONESHOT 4
+#define OMNI_EV_ERROR 8
+
+typedef struct omni_event_loop omni_event_loop_t;
+typedef void (*omni_io_callback_t)(omni_event_loop_t* loop, int32_t fd, int32_t events, void* arg);
+
+omni_event_loop_t* omni_event_loop_create(void);
+void omni_event_loop_destroy(omni_event_loop_t* loop);
+// Returns 0, or -1 if fd already has an armed watch or cannot be watched
+int32_t omni_event_loop_add(omni_event_loop_t* loop, int32_t fd, int32_t events, omni_io_callback_t callback, void* arg);
+int32_t omni_event_loop_modify(omni_event_loop_t* loop, int32_t fd, int32_t events);
+int32_t omni_event_loop_remove(omni_event_loop_t* loop, int32_t fd);
+// Waits up to timeout_ms (-1 forever) and dispatches ready watches; returns
+// the number of callbacks run or -1 on error
+int32_t omni_event_loop_run_once(omni_event_loop_t* loop, int32_t timeout_ms);
+// Dispatches until omni_event_loop_stop; returns 0, or -1 on error
+int32_t omni_event_loop_run(omni_event_loop_t* loop);
+void omni_event_loop_stop(omni_event_loop_t* loop);
+// "epoll", "kqueue", "poll" or "none"
+const char* omni_event_loop_backend(void);
+
+// Asynchronous sockets
+// These wait on the runtime's shared event loop (driven by its own thread)
+// and resolve their promise from there, so a task awaiting one leaves its
+// worker free for other tasks. At most one operation may be pending per
+// socket; closing the socket with omni_socket_close fails it (-1 or "").
+// accept_async puts the listening socket into non-blocking mode.
+omni_promise_t* omni_socket_wait_async(int32_t socket, int32_t events);
+omni_promise_t* omni_socket_accept_async(int32_t socket);
+omni_promise_t* omni_socket_receive_async(int32_t socket, int32_t max_len);
+omni_promise_t* omni_socket_send_async(int32_t socket, const char* data);
+omni_promise_t* omni_socket_send_bytes_async(int32_t socket, const void* data, int64_t len);
 
 // Network utility functions
 int32_t omni_network_is_connected();
@@ -285,6 +793,8 @@ int32_t omni_network_ping(const char* host);
 // Struct operations
 typedef struct omni_struct omni_struct_t;
 omni_struct_t* omni_struct_create();
+// Reserves slots for field_count fields up front
+omni_struct_t* omni_struct_create_sized(int32_t field_count);
 void omni_struct_destroy(omni_struct_t* struct_ptr);
 void omni_struct_set_string_field(omni_struct_t* struct_ptr, const char* field_name, const char* value);
 void omni_struct_set_int_field(omni_struct_t* struct_ptr, const char* field_name, int32_t value);
@@ -294,6 +804,23 @@ const char* omni_struct_get_string_field(omni_struct_t* struct_ptr, const char*
 int32_t omni_struct_get_int_field(omni_struct_t* struct_ptr, const char* field_name);
 double omni_struct_get_float_field(omni_struct_t* struct_ptr, const char* field_name);
 int32_t omni_struct_get_bool_field(omni_struct_t* struct_ptr, const char* field_name);
+// Structs with the same field sequence share a shape and keep their values in
+// slots. The _at accessors take the slot the field is expected in (known to
+// the generator when the struct type is statically known); the _ic accessors
+// take a per-access-site cache, zero-initialized, that remembers the slot last
+// found. Both verify the slot against the struct's shape and fall back to the
+// name lookup, so a wrong guess only costs time. field_name should be interned.
+typedef struct {
+    int32_t slot;
+} omni_struct_ic_t;
+const char* omni_struct_get_string_at(omni_struct_t* struct_ptr, int32_t slot, const char* field_name);
+int32_t omni_struct_get_int_at(omni_struct_t* struct_ptr, int32_t slot, const char* field_name);
+double omni_struct_get_float_at(omni_struct_t* struct_ptr, int32_t slot, const char* field_name);
+int32_t omni_struct_get_bool_at(omni_struct_t* struct_ptr, int32_t slot, const char* field_name);
+const char* omni_struct_get_string_field_ic(omni_struct_t* struct_ptr, const char* field_name, omni_struct_ic_t* ic);
+int32_t omni_struct_get_int_field_ic(omni_struct_t* struct_ptr, const char* field_name, omni_struct_ic_t* ic);
+double omni_struct_get_float_field_ic(omni_struct_t* struct_ptr, const char* field_name, omni_struct_ic_t* ic);
+int32_t omni_struct_get_bool_field_ic(omni_struct_t* struct_ptr, const char* field_name, omni_struct_ic_t* ic);
 
 double omni_pow(double x, double y);
 double omni_sqrt(double x);
@@ -338,12 +865,69 @@ int32_t omni_file_seek(intptr_t file_handle, int32_t offset, int32_t whence);
 int32_t omni_file_tell(intptr_t file_handle);
 int32_t omni_file_exists(const char* filename);
 int32_t omni_file_size(const char* filename);
+// 64-bit variants for files over 2 GiB; the int32_t versions above return
+// -1 when a size or position does not fit
+int64_t omni_file_read64(intptr_t file_handle, char* buffer, int64_t size);
+int64_t omni_file_write64(intptr_t file_handle, const char* buffer, int64_t size);
+int32_t omni_file_seek64(intptr_t file_handle, int64_t offset, int32_t whence);
+int64_t omni_file_tell64(intptr_t file_handle);
+int64_t omni_file_size64(const char* filename);
+// Vectored write: all pieces go out in as few system calls as possible
+// (writev on POSIX). Returns the number of bytes written, or -1 on error.
+typedef struct {
+    const char* data;
+    size_t len;
+} omni_iovec_t;
+int64_t omni_file_writev(intptr_t file_handle, const omni_iovec_t* pieces, int32_t count);
+
+// Memory-mapped files
+// omni_file_map returns a read-only view of a whole file, backed by mmap
+// (MapViewOfFile on Windows), or NULL on error. The view is not
+// NUL-terminated: hand data/len to the *_len string functions, which work on
+// it in place. An empty file gives a view with len 0. The advice is a
+// read-ahead hint for the kernel; omni_file_advise changes it for a range.
+#define OMNI_FILE_MAP_NORMAL     0
+#define OMNI_FILE_MAP_SEQUENTIAL 1
+#define OMNI_FILE_MAP_RANDOM     2
+#define OMNI_FILE_MAP_WILLNEED   3
+
+typedef struct {
+    const char* data;
+    size_t len;
+    void* handle; // Mapping object on Windows, unused elsewhere
+} omni_file_view_t;
+
+omni_file_view_t* omni_file_map(const char* path, int32_t advice);
+int32_t omni_file_advise(omni_file_view_t* view, size_t offset, size_t len, int32_t advice);
+void omni_file_unmap(omni_file_view_t* view);
+
+// Buffered line reader
+// omni_reader_next_line returns the next line without its "\n" or "\r\n",
+// or NULL at end of input. The line is a slice of the reader's buffer and
+// stays valid until the next call; it is NUL-terminated except when the
+// reader scans a mapped view, so prefer the length. omni_reader_stdin is
+// shared by the process and never freed; omni_reader_from_file reads on
+// from the handle's position and leaves the handle just past the last line
+// on free; omni_reader_open maps the file when it can.
+typedef struct omni_reader omni_reader_t;
+
+omni_reader_t* omni_reader_stdin(void);
+omni_reader_t* omni_reader_from_file(intptr_t file_handle);
+omni_reader_t* omni_reader_from_view(const omni_file_view_t* view);
+omni_reader_t* omni_reader_open(const char* path);
+const char* omni_reader_next_line(omni_reader_t* reader, size_t* len);
+void omni_reader_free(omni_reader_t* reader);
 
 // File I/O convenience functions (for async operations)
 // Returns a newly allocated string - caller must free it using free()
 char* omni_read_file(const char* path);
 int32_t omni_write_file(const char* path, const char* content);
 int32_t omni_append_file(const char* path, const char* content);
+// The same operations run as scheduled tasks
+omni_promise_t* omni_read_file_async(const char* path);
+omni_promise_t* omni_write_file_async(const char* path, const char* content);
+omni_promise_t* omni_append_file_async(const char* path, const char* content);
+omni_promise_t* omni_read_line_async(void);
 
 // Testing framework
 void omni_test_start(const char* test_name);
@@ -398,6 +982,21 @@ char* omni_escape_json(const char* str);
 char* omni_escape_shell(const char* str);
 
 // Regex functions (using POSIX regex)
+// The omni_string_* functions compile their pattern through a bounded LRU
+// cache shared by all threads. A pattern used repeatedly can also be compiled
+// once into a handle with omni_regex_compile (patterns are POSIX extended)
+// and released with omni_regex_free; handles are safe to use concurrently.
+#define OMNI_REGEX_ICASE 0x1
+#define OMNI_REGEX_NEWLINE 0x2
+typedef struct omni_regex omni_regex_t;
+omni_regex_t* omni_regex_compile(const char* pattern, int32_t flags);
+void omni_regex_free(omni_regex_t* re);
+// Returns 1 if str matches, storing the byte offsets of the first match
+// (either pointer may be NULL)
+int32_t omni_regex_exec(const omni_regex_t* re, const char* str, int32_t* match_start, int32_t* match_end);
+char* omni_regex_find_match(const omni_regex_t* re, const char* str);
+char* omni_regex_find_all_matches(const omni_regex_t* re, const char* str, int32_t* count);
+char* omni_regex_replace(const omni_regex_t* re, const char* str, const char* replacement);
 int32_t omni_string_matches(const char* str, const char* pattern);
 char* omni_string_find_match(const char* str, const char* pattern);
 char* omni_string_find_all_matches(const char* str, const char* pattern, int32_t* count);
@@ -406,6 +1005,8 @@ char* omni_string_replace_regex(const char* str, const char* pattern, const char
 // Time functions
 int64_t omni_time_now_unix(void);
 int64_t omni_time_now_unix_nano(void);
+// Nanoseconds from an arbitrary fixed point; never goes backwards
+int64_t omni_time_now_monotonic_nano(void);
 void omni_time_sleep_seconds(double seconds);
 void omni_time_sleep_milliseconds(int32_t milliseconds);
 int32_t omni_time_zone_offset(void);
@@ -434,4 +1035,53 @@ void omni_coverage_reset(void);
 int32_t omni_coverage_is_enabled(void);
 void omni_coverage_set_enabled(int32_t enabled);
 
+// Compiled-in coverage sites
+// A coverage build emits one static site table and a zeroed counter per
+// site, registers them from main, and counts a hit with OMNI_COVERAGE_HIT.
+// At exit the export is written to $OMNI_COVERAGE_OUTPUT (default
+// coverage.json).
+typedef struct {
+    const char* function_name;
+    const char* file_path;
+    int32_t line_number;
+} omni_coverage_site_t;
+
+void omni_coverage_register(const omni_coverage_site_t* sites, uint64_t* counters, int32_t count);
+
+#if defined(__GNUC__) || defined(__clang__)
+#define OMNI_COVERAGE_HIT(counters, id) ((void)__atomic_fetch_add(&(counters)[id], 1, __ATOMIC_RELAXED))
+#else
+#define OMNI_COVERAGE_HIT(counters, id) ((void)((counters)[id]++))
+#endif
+
+// Profiler
+// A profiling build (omnic -profile) emits a static site table with one
+// entry per function, registers it from main, and brackets every function
+// with omni_prof_enter/omni_prof_exit. Each thread keeps a shadow stack and
+// per-site counters of its own: calls, inclusive and self time on the
+// monotonic clock, and the omni_alloc/omni_malloc calls and bytes made while
+// the site was innermost. At exit the counters are written as JSON to
+// $OMNI_PROFILE_OUTPUT (default profile.json).
+// The sampler interrupts running threads on a CPU-time timer (SIGPROF) and
+// records the shadow stack, or the native stack where there is none; the
+// folded stacks (one "outer;inner count" line per distinct stack, the input
+// of flamegraph.pl) go to $OMNI_PROFILE_FOLDED (default profile.folded).
+// Profiling builds sample at $OMNI_PROFILE_HZ (default 99, 0 = off); other
+// programs start it with omni_prof_start_sampling. Not available on Windows.
+typedef struct {
+    const char* function_name;
+    const char* file_path;
+} omni_prof_site_t;
+
+void omni_prof_register(const omni_prof_site_t* sites, int32_t count);
+void omni_prof_enter(int32_t site);
+void omni_prof_exit(int32_t site);
+// Returns 1 if sampling is running at the given rate (0 = default rate)
+int32_t omni_prof_start_sampling(int32_t hz);
+void omni_prof_stop_sampling(void);
+// Both exports return malloc'd text (release with free)
+char* omni_prof_export(void);
+char* omni_prof_export_folded(void);
+void omni_prof_reset(void);
+
 #endif // OMNI_RT_H
@@ -0,0 +1,141 @@
+#ifndef OMNI_RT_INLINE_H
+#define OMNI_RT_INLINE_H
+
+// Inline definitions of the runtime's hot leaf functions.
+//
+// Generated programs include this after omni_rt.h. Each function is defined
+// here as omni_inline_<name>, and a macro points the exported name at it, so
+// a call such as omni_max(a, b) compiles to a compare whether the runtime is
+// linked as a shared library, a static archive or built alongside the
+// program. omni_rt.c defines the exported functions with these same bodies.
+// Define OMNI_RT_NO_INLINE before including this to keep calling the
+// exported functions.
+
+#include "omni_rt.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define OMNI_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define OMNI_UNLIKELY(x) (x)
+#endif
+
+static inline int32_t omni_inline_add(int32_t a, int32_t b) {
+    return a + b;
+}
+
+static inline int32_t omni_inline_sub(int32_t a, int32_t b) {
+    return a - b;
+}
+
+static inline int32_t omni_inline_mul(int32_t a, int32_t b) {
+    return a * b;
+}
+
+static inline int32_t omni_inline_div(int32_t a, int32_t b) {
+    return b != 0 ? a / b : 0;
+}
+
+static inline int32_t omni_inline_abs(int32_t x) {
+    return x < 0 ? -x : x;
+}
+
+static inline int32_t omni_inline_max(int32_t a, int32_t b) {
+    return a > b ? a : b;
+}
+
+static inline int32_t omni_inline_min(int32_t a, int32_t b) {
+    return a < b ? a : b;
+}
+
+static inline double omni_inline_pow(double x, double y) {
+    return pow(x, y);
+}
+
+static inline double omni_inline_sqrt(double x) {
+    return sqrt(x);
+}
+
+static inline double omni_inline_floor(double x) {
+    return floor(x);
+}
+
+static inline double omni_inline_ceil(double x) {
+    return ceil(x);
+}
+
+static inline double omni_inline_round(double x) {
+    return round(x);
+}
+
+static inline double omni_inline_trunc(double x) {
+    return trunc(x);
+}
+
+static inline int32_t omni_inline_len(void* array, size_t element_size, int32_t array_length) {
+    (void)array;
+    (void)element_size;
+    return array_length;
+}
+
+static inline int32_t omni_inline_strlen(const char* str) {
+    return (int32_t)strlen(str);
+}
+
+static inline int32_t omni_inline_string_equals(const char* a, const char* b) {
+    if (!a || !b) {
+        return (a == b) ? 1 : 0;
+    }
+    return strcmp(a, b) == 0 ? 1 : 0;
+}
+
+// Scans no further than index for the terminator, rather than measuring the
+// whole string
+static inline char omni_inline_char_at(const char* str, int32_t index) {
+    if (!str || index < 0 || memchr(str, '\0', (size_t)index + 1) != NULL) {
+        return '\0';
+    }
+    return str[index];
+}
+
+// The accessors check inline and leave reporting a bad access, which
+// aborts, to the exported function
+static inline int32_t omni_inline_array_get_int(int32_t* arr, int32_t index, int32_t length) {
+    if (OMNI_UNLIKELY(!arr || (uint32_t)index >= (uint32_t)length)) {
+        return omni_array_get_int(arr, index, length);
+    }
+    return arr[index];
+}
+
+static inline void omni_inline_array_set_int(int32_t* arr, int32_t index, int32_t value, int32_t length) {
+    if (OMNI_UNLIKELY(!arr || (uint32_t)index >= (uint32_t)length)) {
+        omni_array_set_int(arr, index, value, length);
+        return;
+    }
+    arr[index] = value;
+}
+
+#ifndef OMNI_RT_NO_INLINE
+#define omni_add omni_inline_add
+#define omni_sub omni_inline_sub
+#define omni_mul omni_inline_mul
+#define omni_div omni_inline_div
+#define omni_abs omni_inline_abs
+#define omni_max omni_inline_max
+#define omni_min omni_inline_min
+#define omni_pow omni_inline_pow
+#define omni_sqrt omni_inline_sqrt
+#define omni_floor omni_inline_floor
+#define omni_ceil omni_inline_ceil
+#define omni_round omni_inline_round
+#define omni_trunc omni_inline_trunc
+#define omni_len omni_inline_len
+#define omni_strlen omni_inline_strlen
+#define omni_string_equals omni_inline_string_equals
+#define omni_char_at omni_inline_char_at
+#define omni_array_get_int omni_inline_array_get_int
+#define omni_array_set_int omni_inline_array_set_int
+#endif
+
+#endif // OMNI_RT_INLINE_H
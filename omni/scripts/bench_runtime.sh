@@ -0,0 +1,164 @@
+#!/bin/bash
+
+# Runtime benchmark suite for OmniLang
+# Measures libomni_rt itself: the C micro benchmarks in tests/bench/runtime
+# and end-to-end .omni programs compiled with omnic, then compares the
+# results against a stored baseline.
+#
+# Usage: bench_runtime.sh run|baseline|compare [-quick]
+
+set -e
+
+# Configuration
+PERF_DIR="performance"
+RESULT_DIR="bench-results"
+BASELINE_FILE="${PERF_DIR}/runtime_baseline.json"
+CURRENT_FILE="${RESULT_DIR}/runtime.json"
+REGRESSION_THRESHOLD=${REGRESSION_THRESHOLD:-0.20}  # 20% slower than baseline fails
+PROGRAM_RUNS=${PROGRAM_RUNS:-5}
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+print_status() {
+    local color=$1
+    local message=$2
+    echo -e "${color}${message}${NC}"
+}
+
+# Builds the micro benchmark harness against the runtime library generated
+# programs link with
+build_harness() {
+    mkdir -p "${RESULT_DIR}"
+    gcc -O2 -pthread -Iruntime tests/bench/runtime/bench_runtime.c \
+        -Lruntime/posix -lomni_rt -Wl,-rpath,"$PWD/runtime/posix" -lm \
+        -o "${RESULT_DIR}/bench_runtime"
+}
+
+# Runs the micro benchmarks and the .omni programs and writes ${CURRENT_FILE}
+run_benchmarks() {
+    local quick=$1
+    print_status $GREEN "Building runtime benchmark harness..."
+    build_harness
+
+    print_status $GREEN "Running runtime micro benchmarks..."
+    "${RESULT_DIR}/bench_runtime" ${quick} -o "${RESULT_DIR}/runtime_micro.json"
+
+    print_status $GREEN "Running end-to-end programs..."
+    local work="${RESULT_DIR}/programs"
+    local programs=()
+    mkdir -p "${work}"
+    export LD_LIBRARY_PATH="$PWD/native/clift/target/release:$PWD/runtime/posix:$LD_LIBRARY_PATH"
+    for source in tests/bench/*.omni tests/bench/runtime/programs/*.omni; do
+        local name
+        name=$(basename "${source}" .omni)
+        if ./bin/omnic -O O2 -o "${work}/${name}" "${source}" > "${work}/${name}.log" 2>&1; then
+            programs+=("./${name}")
+        else
+            print_status $YELLOW "  ${name}: compile failed, skipped (see ${work}/${name}.log)"
+        fi
+    done
+    # Programs run from the work directory, where they may leave files
+    (cd "${work}" && ../bench_runtime -count "${PROGRAM_RUNS}" -o ../runtime_programs.json -run "${programs[@]}")
+
+    python3 - "${RESULT_DIR}" <<'EOF'
+import json
+import os
+import sys
+import time
+
+result_dir = sys.argv[1]
+with open(os.path.join(result_dir, "runtime_micro.json")) as f:
+    micro = json.load(f)
+with open(os.path.join(result_dir, "runtime_programs.json")) as f:
+    programs = json.load(f)
+
+current = {
+    "timestamp": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+    "platform": os.uname().sysname,
+    "architecture": os.uname().machine,
+    "benchmarks": micro["benchmarks"] + programs["benchmarks"],
+    "peak_rss_bytes": micro["peak_rss_bytes"],
+}
+with open(os.path.join(result_dir, "runtime.json"), "w") as f:
+    json.dump(current, f, indent=2)
+print("Results saved with", len(current["benchmarks"]), "benchmarks")
+EOF
+}
+
+# Copies the current results over the baseline
+create_baseline() {
+    mkdir -p "${PERF_DIR}"
+    cp "${CURRENT_FILE}" "${BASELINE_FILE}"
+    print_status $GREEN "Baseline saved to ${BASELINE_FILE}"
+}
+
+# Fails when a benchmark got slower, or allocates more per op, than the
+# threshold allows
+detect_regressions() {
+    print_status $GREEN "Comparing against ${BASELINE_FILE}..."
+    python3 - "${BASELINE_FILE}" "${CURRENT_FILE}" "${REGRESSION_THRESHOLD}" <<'EOF'
+import json
+import sys
+
+with open(sys.argv[1]) as f:
+    baseline = {b["name"]: b for b in json.load(f)["benchmarks"]}
+with open(sys.argv[2]) as f:
+    current = json.load(f)["benchmarks"]
+threshold = float(sys.argv[3])
+
+regressions = []
+for bench in current:
+    base = baseline.get(bench["name"])
+    if not base:
+        continue
+    if base["ns_per_op"] > 0:
+        change = bench["ns_per_op"] / base["ns_per_op"] - 1
+        if change > threshold:
+            regressions.append(f"{bench['name']}: {base['ns_per_op']:.1f} -> {bench['ns_per_op']:.1f} ns/op (+{change:.0%})")
+    # Allocation counts are deterministic, so any growth is a regression
+    if base["allocs_per_op"] >= 0 and bench["allocs_per_op"] > base["allocs_per_op"] * 1.01 + 1e-9:
+        regressions.append(f"{bench['name']}: {base['allocs_per_op']:.4f} -> {bench['allocs_per_op']:.4f} allocs/op")
+
+if regressions:
+    print("Performance regressions detected:")
+    for line in regressions:
+        print("  " + line)
+    sys.exit(1)
+print(f"No regressions above {threshold:.0%} across {len(current)} benchmarks")
+EOF
+}
+
+QUICK=""
+if [ "$2" = "-quick" ]; then
+    QUICK="-quick"
+fi
+
+case "$1" in
+    run)
+        run_benchmarks "${QUICK}"
+        if [ ! -f "${BASELINE_FILE}" ]; then
+            print_status $YELLOW "No runtime baseline found. Creating baseline..."
+            create_baseline
+        elif detect_regressions; then
+            print_status $GREEN "Runtime benchmarks passed!"
+        else
+            print_status $RED "Runtime benchmarks regressed!"
+            exit 1
+        fi
+        ;;
+    baseline)
+        run_benchmarks "${QUICK}"
+        create_baseline
+        ;;
+    compare)
+        detect_regressions
+        ;;
+    *)
+        echo "Usage: $0 run|baseline|compare [-quick]"
+        exit 1
+        ;;
+esac
@@ -110,7 +110,7 @@ build_all() {
     
     # Build runtime
     print_status $YELLOW "Building runtime..."
-    make build-runtime
+    make build-runtime-release
     
     print_status $GREEN "All targets built successfully!"
 }
@@ -0,0 +1,1174 @@
+// Micro benchmarks for libomni_rt
+//
+// Each benchmark times n operations against the runtime library and reports
+// ns/op, heap allocations and bytes per op, and the process RSS afterwards,
+// as one JSON document. Every benchmark runs -count times (default 3) and the
+// fastest run is reported; allocations are counted in that run.
+//
+// Usage: bench_runtime [-quick] [-max N] [-count N] [-filter SUBSTR] [-o FILE]
+//        bench_runtime [-count N] [-o FILE] -run PROGRAM...
+//   -quick   stop the size sweeps at 1e5 (default 1e7)
+//   -run     time whole programs instead (compiled .omni programs); the
+//            fastest wall time of -count runs and the peak RSS of a run are
+//            reported as one op
+//
+// Allocations are counted by interposing malloc and friends, which needs
+// glibc; elsewhere allocs_per_op and bytes_per_op are reported as -1.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "omni_rt.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+
+static int32_t bench_counting = 0;
+static uint64_t bench_allocs = 0;
+static uint64_t bench_alloc_bytes = 0;
+
+#if defined(__GLIBC__)
+#define BENCH_COUNTS_ALLOCS 1
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* ptr);
+
+static void bench_note_alloc(size_t size) {
+    if (__atomic_load_n(&bench_counting, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&bench_alloc_bytes, (uint64_t)size, __ATOMIC_RELAXED);
+    }
+}
+
+void* malloc(size_t size) {
+    bench_note_alloc(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    bench_note_alloc(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    bench_note_alloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    bench_note_alloc(size);
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    bench_note_alloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+#endif
+
+// ============================================================================
+// Harness
+// ============================================================================
+
+typedef struct {
+    int64_t ops;
+    int64_t start_ns;
+    int64_t elapsed_ns;
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+    int64_t rss_bytes;
+} bench_t;
+
+typedef struct {
+    const char* name;
+    void (*run)(bench_t* b, int64_t n);
+    int sized; // Run once per size of the sweep, otherwise once with n
+    int64_t n;
+} bench_spec_t;
+
+static int64_t bench_max_size = 10000000;
+static int32_t bench_count = 3;
+static const char* bench_filter = NULL;
+
+// Starts the timed section; setup done before it is not measured
+static void bench_start(bench_t* b) {
+    __atomic_store_n(&bench_allocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&bench_alloc_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&bench_counting, 1, __ATOMIC_RELAXED);
+    b->start_ns = omni_time_now_monotonic_nano();
+}
+
+// Ends the timed section over ops operations
+static void bench_stop(bench_t* b, int64_t ops) {
+    b->elapsed_ns = omni_time_now_monotonic_nano() - b->start_ns;
+    __atomic_store_n(&bench_counting, 0, __ATOMIC_RELAXED);
+    b->allocs = __atomic_load_n(&bench_allocs, __ATOMIC_RELAXED);
+    b->alloc_bytes = __atomic_load_n(&bench_alloc_bytes, __ATOMIC_RELAXED);
+    b->ops = ops;
+}
+
+static int64_t bench_rss_bytes(void) {
+#ifdef __linux__
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        long pages_total = 0, pages_resident = 0;
+        int ok = fscanf(statm, "%ld %ld", &pages_total, &pages_resident) == 2;
+        fclose(statm);
+        if (ok) {
+            return (int64_t)pages_resident * sysconf(_SC_PAGESIZE);
+        }
+    }
+#endif
+    return -1;
+}
+
+static int64_t bench_peak_rss_bytes(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#ifdef __APPLE__
+    return (int64_t)usage.ru_maxrss;
+#else
+    return (int64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+// Keeps results alive so the compiler cannot drop the work producing them
+static volatile int64_t bench_sink;
+
+// Deterministic pseudo-random keys (xorshift)
+static uint32_t bench_rand_state = 2463534242u;
+
+static uint32_t bench_rand(void) {
+    bench_rand_state ^= bench_rand_state << 13;
+    bench_rand_state ^= bench_rand_state >> 17;
+    bench_rand_state ^= bench_rand_state << 5;
+    return bench_rand_state;
+}
+
+// Heap array of n keys "key<i>" for the string-keyed benchmarks
+static char** bench_string_keys(int64_t n) {
+    char** keys = (char**)malloc((size_t)n * sizeof(char*));
+    for (int64_t i = 0; keys && i < n; i++) {
+        char buffer[32];
+        int len = snprintf(buffer, sizeof(buffer), "key%lld", (long long)i);
+        keys[i] = (char*)malloc((size_t)len + 1);
+        memcpy(keys[i], buffer, (size_t)len + 1);
+    }
+    return keys;
+}
+
+static void bench_free_keys(char** keys, int64_t n) {
+    for (int64_t i = 0; keys && i < n; i++) {
+        free(keys[i]);
+    }
+    free(keys);
+}
+
+// ============================================================================
+// Maps
+// ============================================================================
+
+static void bench_map_put_int(bench_t* b, int64_t n) {
+    omni_map_t* map = omni_map_create();
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_map_put_int_int(map, (int32_t)i, (int32_t)i);
+    }
+    bench_stop(b, n);
+    omni_map_destroy(map);
+}
+
+static void bench_map_get_int(bench_t* b, int64_t n) {
+    omni_map_t* map = omni_map_create();
+    for (int64_t i = 0; i < n; i++) {
+        omni_map_put_int_int(map, (int32_t)i, (int32_t)i);
+    }
+    int64_t sum = 0;
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        sum += omni_map_get_int_int(map, (int32_t)(bench_rand() % (uint32_t)n));
+    }
+    bench_stop(b, n);
+    bench_sink = sum;
+    omni_map_destroy(map);
+}
+
+static void bench_map_delete_int(bench_t* b, int64_t n) {
+    omni_map_t* map = omni_map_create();
+    for (int64_t i = 0; i < n; i++) {
+        omni_map_put_int_int(map, (int32_t)i, (int32_t)i);
+    }
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_map_delete_int(map, (int32_t)i);
+    }
+    bench_stop(b, n);
+    omni_map_destroy(map);
+}
+
+static void bench_map_put_string(bench_t* b, int64_t n) {
+    char** keys = bench_string_keys(n);
+    omni_map_t* map = omni_map_create();
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_map_put_string_int(map, keys[i], (int32_t)i);
+    }
+    bench_stop(b, n);
+    omni_map_destroy(map);
+    bench_free_keys(keys, n);
+}
+
+static void bench_map_get_string(bench_t* b, int64_t n) {
+    char** keys = bench_string_keys(n);
+    omni_map_t* map = omni_map_create();
+    for (int64_t i = 0; i < n; i++) {
+        omni_map_put_string_int(map, keys[i], (int32_t)i);
+    }
+    int64_t sum = 0;
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        sum += omni_map_get_string_int(map, keys[bench_rand() % (uint32_t)n]);
+    }
+    bench_stop(b, n);
+    bench_sink = sum;
+    omni_map_destroy(map);
+    bench_free_keys(keys, n);
+}
+
+static void bench_map_delete_string(bench_t* b, int64_t n) {
+    char** keys = bench_string_keys(n);
+    omni_map_t* map = omni_map_create();
+    for (int64_t i = 0; i < n; i++) {
+        omni_map_put_string_int(map, keys[i], (int32_t)i);
+    }
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_map_delete_string(map, keys[i]);
+    }
+    bench_stop(b, n);
+    omni_map_destroy(map);
+    bench_free_keys(keys, n);
+}
+
+// ============================================================================
+// Strings
+// ============================================================================
+
+static const char* bench_text =
+    "GET /api/v1/items?page=3&limit=50 HTTP/1.1 Host: example.com User-Agent: omni-bench Accept: */*";
+
+static void bench_string_concat(bench_t* b, int64_t n) {
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        char* joined = omni_strcat("request path: ", bench_text);
+        bench_sink += (int64_t)omni_str_len(joined);
+        omni_str_free(joined);
+    }
+    bench_stop(b, n);
+}
+
+static void bench_string_builder(bench_t* b, int64_t n) {
+    // One op is one appended piece; the result is built every 64 pieces
+    omni_strbuilder_t sb;
+    omni_strbuilder_init(&sb);
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_strbuilder_append_int(&sb, (int32_t)i);
+        if ((i & 63) == 63) {
+            char* built = omni_strbuilder_finish(&sb);
+            bench_sink += (int64_t)omni_str_len(built);
+            omni_str_free(built);
+        }
+    }
+    bench_stop(b, n);
+    omni_strbuilder_free(&sb);
+}
+
+static void bench_string_int_to_string(bench_t* b, int64_t n) {
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        char* text = omni_int_to_string((int32_t)(i * 7919));
+        bench_sink += text[0];
+        omni_str_free(text);
+    }
+    bench_stop(b, n);
+}
+
+static void bench_string_append_float(bench_t* b, int64_t n) {
+    // One op is one appended double; the result is built every 64
+    omni_strbuilder_t sb;
+    omni_strbuilder_init(&sb);
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_strbuilder_append_float(&sb, (double)(i * 7919) / 113.0);
+        if ((i & 63) == 63) {
+            char* built = omni_strbuilder_finish(&sb);
+            bench_sink += (int64_t)omni_str_len(built);
+            omni_str_free(built);
+        }
+    }
+    bench_stop(b, n);
+    omni_strbuilder_free(&sb);
+}
+
+static void bench_string_parse_float(bench_t* b, int64_t n) {
+    static const char* inputs[] = {"3.14", "-0.000125", "6.02214076e23", "12345.678901234", "1e-7", "0.1", "299792458", "2.718281828459045"};
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += (int64_t)omni_string_to_float(inputs[i & 7]);
+    }
+    bench_stop(b, n);
+}
+
+static void bench_string_index_of(bench_t* b, int64_t n) {
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_index_of(bench_text, "omni-bench");
+    }
+    bench_stop(b, n);
+}
+
+static void bench_string_to_upper(bench_t* b, int64_t n) {
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        char* upper = omni_to_upper(bench_text);
+        bench_sink += upper[0];
+        omni_str_free(upper);
+    }
+    bench_stop(b, n);
+}
+
+static void bench_string_equals(bench_t* b, int64_t n) {
+    char* copy = omni_strcat(bench_text, "");
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_string_equals(bench_text, copy);
+    }
+    bench_stop(b, n);
+    omni_str_free(copy);
+}
+
+static void bench_string_intern(bench_t* b, int64_t n) {
+    char** keys = bench_string_keys(1024);
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += (intptr_t)omni_intern(keys[i & 1023]) & 1;
+    }
+    bench_stop(b, n);
+    bench_free_keys(keys, 1024);
+}
+
+// ============================================================================
+// Collections
+// ============================================================================
+
+static void bench_set_add_contains(bench_t* b, int64_t n) {
+    omni_set_t* set = omni_set_create();
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_set_add(set, (int32_t)i);
+    }
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_set_contains(set, (int32_t)(bench_rand() % (uint32_t)n));
+    }
+    bench_stop(b, 2 * n);
+    omni_set_destroy(set);
+}
+
+static void bench_set_dense_ops(bench_t* b, int64_t n) {
+    // Dense ID sets: a holds every ID below n, b every third one. One op is
+    // one ID of a passing through an intersection, a union and a difference.
+    omni_set_t* a = omni_set_create();
+    omni_set_t* c = omni_set_create();
+    for (int64_t i = 0; i < n; i++) {
+        omni_set_add(a, (int32_t)i);
+        if (i % 3 == 0) omni_set_add(c, (int32_t)i);
+    }
+    bench_start(b);
+    for (int32_t round = 0; round < 8; round++) {
+        omni_set_t* result = omni_set_intersection(a, c);
+        omni_set_union_with(result, a);
+        omni_set_difference_with(result, c);
+        bench_sink += omni_set_size(result);
+        omni_set_destroy(result);
+    }
+    bench_stop(b, 8 * n);
+    omni_set_destroy(a);
+    omni_set_destroy(c);
+}
+
+static void bench_queue_cycle(bench_t* b, int64_t n) {
+    omni_queue_t* queue = omni_queue_create();
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_queue_enqueue(queue, (int32_t)i);
+    }
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_queue_dequeue(queue);
+    }
+    bench_stop(b, 2 * n);
+    omni_queue_destroy(queue);
+}
+
+static void bench_stack_cycle(bench_t* b, int64_t n) {
+    omni_stack_t* stack = omni_stack_create();
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_stack_push(stack, (int32_t)i);
+    }
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_stack_pop(stack);
+    }
+    bench_stop(b, 2 * n);
+    omni_stack_destroy(stack);
+}
+
+static void bench_queue_batch(bench_t* b, int64_t n) {
+    // BFS-style frontier: batches of 64 in, batches of 64 out
+    omni_queue_t* queue = omni_queue_create();
+    int32_t batch[64];
+    for (int i = 0; i < 64; i++) batch[i] = i;
+    bench_start(b);
+    for (int64_t i = 0; i < n; i += 64) {
+        omni_queue_enqueue_n(queue, batch, 64);
+    }
+    while (omni_queue_dequeue_n(queue, batch, 64) > 0) {
+        bench_sink += batch[0];
+    }
+    bench_stop(b, 2 * ((n + 63) / 64) * 64);
+    omni_queue_destroy(queue);
+}
+
+typedef struct {
+    omni_spsc_queue_t* queue;
+    int64_t count;
+} bench_spsc_arg_t;
+
+static void* bench_spsc_producer(void* p) {
+    bench_spsc_arg_t* arg = (bench_spsc_arg_t*)p;
+    for (int64_t i = 0; i < arg->count; i++) {
+        while (!omni_spsc_queue_push(arg->queue, i)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void bench_spsc_handoff(bench_t* b, int64_t n) {
+    bench_spsc_arg_t arg = {omni_spsc_queue_create(4096), n};
+    pthread_t producer;
+    int64_t value;
+    bench_start(b);
+    pthread_create(&producer, NULL, bench_spsc_producer, &arg);
+    for (int64_t i = 0; i < n; i++) {
+        while (!omni_spsc_queue_pop(arg.queue, &value)) {
+            sched_yield();
+        }
+        bench_sink += value;
+    }
+    pthread_join(producer, NULL);
+    bench_stop(b, n);
+    omni_spsc_queue_destroy(arg.queue);
+}
+
+static void bench_priority_queue_cycle(bench_t* b, int64_t n) {
+    omni_priority_queue_t* pq = omni_priority_queue_create();
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_priority_queue_insert(pq, (int32_t)i, (int32_t)(bench_rand() & 0xFFFF));
+    }
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_priority_queue_extract_max(pq);
+    }
+    bench_stop(b, 2 * n);
+    omni_priority_queue_destroy(pq);
+}
+
+static void bench_priority_queue_decrease_key(bench_t* b, int64_t n) {
+    // Dijkstra-style: every element is relaxed once before the queue drains
+    omni_priority_queue_t* pq = omni_priority_queue_create_min();
+    int32_t* handles = (int32_t*)malloc((size_t)n * sizeof(int32_t));
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        handles[i] = omni_priority_queue_push(pq, (int32_t)i, 1000000 + (bench_rand() & 0xFFFF));
+    }
+    for (int64_t i = 0; i < n; i++) {
+        omni_priority_queue_decrease_key(pq, handles[i], bench_rand() & 0xFFFF);
+    }
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_priority_queue_pop(pq);
+    }
+    bench_stop(b, 3 * n);
+    free(handles);
+    omni_priority_queue_destroy(pq);
+}
+
+static void bench_priority_queue_heapify(bench_t* b, int64_t n) {
+    omni_priority_queue_t* pq = omni_priority_queue_create();
+    int32_t* elements = (int32_t*)malloc((size_t)n * sizeof(int32_t));
+    int64_t* priorities = (int64_t*)malloc((size_t)n * sizeof(int64_t));
+    int32_t top[64];
+    for (int64_t i = 0; i < n; i++) {
+        elements[i] = (int32_t)i;
+        priorities[i] = bench_rand();
+    }
+    bench_start(b);
+    omni_priority_queue_push_n(pq, elements, priorities, (int32_t)n, NULL);
+    while (omni_priority_queue_extract_top_k(pq, 64, top) > 0) {
+        bench_sink += top[0];
+    }
+    bench_stop(b, 2 * n);
+    free(elements);
+    free(priorities);
+    omni_priority_queue_destroy(pq);
+}
+
+static void bench_linked_list_scan(bench_t* b, int64_t n) {
+    // Indexed access from front to back
+    omni_linked_list_t* list = omni_linked_list_create();
+    for (int64_t i = 0; i < n; i++) {
+        omni_linked_list_append(list, (int32_t)i);
+    }
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_linked_list_get(list, (int32_t)i);
+    }
+    bench_stop(b, n);
+    omni_linked_list_destroy(list);
+}
+
+static void bench_linked_list_cursor(bench_t* b, int64_t n) {
+    // Cursor walk, as a for loop over a list does
+    omni_linked_list_t* list = omni_linked_list_create();
+    for (int64_t i = 0; i < n; i++) {
+        omni_linked_list_append(list, (int32_t)i);
+    }
+    bench_start(b);
+    omni_linked_list_cursor_t cursor = omni_linked_list_begin(list);
+    while (omni_linked_list_cursor_valid(&cursor)) {
+        bench_sink += omni_linked_list_cursor_value(&cursor);
+        omni_linked_list_next(&cursor);
+    }
+    bench_stop(b, n);
+    omni_linked_list_destroy(list);
+}
+
+static void bench_linked_list_filter(bench_t* b, int64_t n) {
+    // Build by appending, then drop every third element through a cursor
+    omni_linked_list_t* list = omni_linked_list_create();
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_linked_list_append(list, (int32_t)i);
+    }
+    omni_linked_list_cursor_t cursor = omni_linked_list_begin(list);
+    while (omni_linked_list_cursor_valid(&cursor)) {
+        if (omni_linked_list_cursor_value(&cursor) % 3 == 0) {
+            omni_linked_list_remove_at_cursor(&cursor);
+        } else {
+            omni_linked_list_next(&cursor);
+        }
+    }
+    bench_stop(b, 2 * n);
+    omni_linked_list_destroy(list);
+}
+
+static void bench_binary_tree_sorted(bench_t* b, int64_t n) {
+    // Ascending keys, which degenerated the old unbalanced tree into a list
+    omni_binary_tree_t* tree = omni_binary_tree_create();
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_binary_tree_insert(tree, (int32_t)i);
+    }
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_binary_tree_search(tree, (int32_t)i);
+    }
+    bench_stop(b, 2 * n);
+    omni_binary_tree_destroy(tree);
+}
+
+static void bench_binary_tree_churn(bench_t* b, int64_t n) {
+    // Scattered inserts and removes over a key space a quarter of n wide
+    omni_binary_tree_t* tree = omni_binary_tree_create();
+    uint32_t x = 2463534242u;
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        int32_t key = (int32_t)(x % (uint32_t)(n / 4 + 1));
+        if (x & 0x100) {
+            omni_binary_tree_insert(tree, key);
+        } else {
+            bench_sink += omni_binary_tree_remove(tree, key);
+        }
+    }
+    bench_stop(b, n);
+    omni_binary_tree_destroy(tree);
+}
+
+static void bench_binary_tree_range(bench_t* b, int64_t n) {
+    // 64-key windows out of a 100k key index; one op is one key returned
+    enum { keys = 100000, window = 64 };
+    omni_binary_tree_t* tree = omni_binary_tree_create();
+    for (int32_t i = 0; i < keys; i++) {
+        omni_binary_tree_insert(tree, i * 2);
+    }
+    int32_t out[window];
+    int64_t queries = n / window + 1;
+    bench_start(b);
+    for (int64_t i = 0; i < queries; i++) {
+        int32_t lo = (int32_t)((i * 7919) % keys) * 2;
+        bench_sink += omni_binary_tree_range(tree, lo, lo + 2 * window - 1, out, window);
+    }
+    bench_stop(b, queries * window);
+    omni_binary_tree_destroy(tree);
+}
+
+// ============================================================================
+// Vectors
+// ============================================================================
+
+static void bench_vec_push_sum(bench_t* b, int64_t n) {
+    // One op is one element pushed and later summed
+    bench_start(b);
+    omni_vec_t* vec = omni_vec_create(OMNI_VEC_INT, 0);
+    for (int64_t i = 0; i < n; i++) {
+        omni_vec_push_int(vec, (int32_t)bench_rand());
+    }
+    bench_sink += omni_vec_sum_int(vec);
+    bench_stop(b, 2 * n);
+    omni_vec_destroy(vec);
+}
+
+static void bench_vec_find_int(bench_t* b, int64_t n) {
+    // Repeated linear scans for a value that sits at the end of the vector
+    omni_vec_t* vec = omni_vec_create(OMNI_VEC_INT, (int32_t)n);
+    for (int64_t i = 0; i < n; i++) {
+        omni_vec_push_int(vec, (int32_t)i);
+    }
+    bench_start(b);
+    for (int32_t round = 0; round < 16; round++) {
+        bench_sink += omni_vec_find_int(vec, (int32_t)(n - 1), 0);
+    }
+    bench_stop(b, 16 * n);
+    omni_vec_destroy(vec);
+}
+
+// ============================================================================
+// Parallel algorithms
+// ============================================================================
+
+static void bench_parallel_sort_int(bench_t* b, int64_t n) {
+    int32_t* data = (int32_t*)malloc((size_t)n * sizeof(int32_t));
+    for (int64_t i = 0; i < n; i++) data[i] = (int32_t)bench_rand();
+    omni_scheduler_workers(); // Keep pool startup out of the timing
+    bench_start(b);
+    omni_parallel_sort_int(data, n);
+    bench_stop(b, n);
+    bench_sink += data[n / 2];
+    free(data);
+}
+
+static void bench_parallel_sort_string(bench_t* b, int64_t n) {
+    char** keys = bench_string_keys(n);
+    const char** data = (const char**)malloc((size_t)n * sizeof(char*));
+    for (int64_t i = 0; i < n; i++) data[i] = keys[bench_rand() % (uint32_t)n];
+    omni_scheduler_workers();
+    bench_start(b);
+    omni_parallel_sort_string(data, n);
+    bench_stop(b, n);
+    bench_sink += data[n / 2][0];
+    free(data);
+    bench_free_keys(keys, n);
+}
+
+static void bench_parallel_sum_int(bench_t* b, int64_t n) {
+    int32_t* data = (int32_t*)malloc((size_t)n * sizeof(int32_t));
+    for (int64_t i = 0; i < n; i++) data[i] = (int32_t)bench_rand();
+    omni_scheduler_workers();
+    bench_start(b);
+    for (int32_t round = 0; round < 8; round++) {
+        bench_sink += omni_parallel_sum_int(data, n);
+    }
+    bench_stop(b, 8 * n);
+    free(data);
+}
+
+static void bench_parallel_build_map(bench_t* b, int64_t n) {
+    int32_t* keys = (int32_t*)malloc((size_t)n * sizeof(int32_t));
+    int32_t* values = (int32_t*)malloc((size_t)n * sizeof(int32_t));
+    for (int64_t i = 0; i < n; i++) {
+        keys[i] = (int32_t)bench_rand();
+        values[i] = (int32_t)i;
+    }
+    omni_scheduler_workers();
+    bench_start(b);
+    omni_map_t* map = omni_parallel_build_map_int(keys, values, n);
+    bench_stop(b, n);
+    bench_sink += omni_map_size(map);
+    omni_map_destroy(map);
+    free(keys);
+    free(values);
+}
+
+// ============================================================================
+// Channels
+// ============================================================================
+
+// Two producer and two consumer threads move n elements through one channel,
+// one element or `batch` elements per call
+typedef struct {
+    omni_chan_t* chan;
+    int64_t count;
+    int32_t batch;
+} bench_chan_arg_t;
+
+static void* bench_chan_producer(void* p) {
+    bench_chan_arg_t* arg = (bench_chan_arg_t*)p;
+    int64_t buf[64];
+    for (int64_t i = 0; i < arg->count;) {
+        if (arg->batch > 1) {
+            int32_t k = 0;
+            while (k < arg->batch && i < arg->count) buf[k++] = i++;
+            omni_chan_send_n(arg->chan, buf, k);
+        } else {
+            omni_chan_send(arg->chan, &i);
+            i++;
+        }
+    }
+    return NULL;
+}
+
+static void* bench_chan_consumer(void* p) {
+    bench_chan_arg_t* arg = (bench_chan_arg_t*)p;
+    int64_t buf[64];
+    int64_t sum = 0;
+    for (;;) {
+        int32_t k = arg->batch > 1 ? omni_chan_recv_n(arg->chan, buf, arg->batch) : omni_chan_recv(arg->chan, buf);
+        if (k == 0) break;
+        for (int32_t j = 0; j < k; j++) sum += buf[j];
+    }
+    __atomic_add_fetch(&bench_sink, sum, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void bench_chan_mpmc(bench_t* b, int64_t n, int32_t capacity, int32_t batch) {
+    omni_chan_t* chan = omni_chan_create(sizeof(int64_t), capacity);
+    bench_chan_arg_t producer_arg = {chan, n / 2, batch};
+    bench_chan_arg_t consumer_arg = {chan, 0, batch};
+    pthread_t producers[2], consumers[2];
+    bench_start(b);
+    for (int t = 0; t < 2; t++) {
+        pthread_create(&consumers[t], NULL, bench_chan_consumer, &consumer_arg);
+        pthread_create(&producers[t], NULL, bench_chan_producer, &producer_arg);
+    }
+    for (int t = 0; t < 2; t++) pthread_join(producers[t], NULL);
+    omni_chan_close(chan);
+    for (int t = 0; t < 2; t++) pthread_join(consumers[t], NULL);
+    bench_stop(b, n);
+    omni_chan_destroy(chan);
+}
+
+static void bench_chan_bounded(bench_t* b, int64_t n) {
+    bench_chan_mpmc(b, n, 1024, 1);
+}
+
+static void bench_chan_bounded_batch(bench_t* b, int64_t n) {
+    bench_chan_mpmc(b, n, 1024, 64);
+}
+
+static void bench_chan_unbounded(bench_t* b, int64_t n) {
+    bench_chan_mpmc(b, n, 0, 1);
+}
+
+// ============================================================================
+// Regex
+// ============================================================================
+
+static void bench_regex_match_cached(bench_t* b, int64_t n) {
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_string_matches(bench_text, "page=[0-9]+&limit=[0-9]+");
+    }
+    bench_stop(b, n);
+}
+
+static void bench_regex_exec_compiled(bench_t* b, int64_t n) {
+    omni_regex_t* re = omni_regex_compile("Host: [a-z.]+", 0);
+    int32_t start = 0, end = 0;
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_regex_exec(re, bench_text, &start, &end) + end;
+    }
+    bench_stop(b, n);
+    omni_regex_free(re);
+}
+
+static void bench_regex_replace(bench_t* b, int64_t n) {
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        char* replaced = omni_string_replace_regex(bench_text, "[0-9]+", "N");
+        bench_sink += replaced ? replaced[0] : 0;
+        free(replaced);
+    }
+    bench_stop(b, n);
+}
+
+// ============================================================================
+// File I/O
+// ============================================================================
+
+static char bench_file_path[64];
+static char bench_copy_path[80];
+
+// Writes a file of n lines to read back
+static void bench_make_file(int64_t lines) {
+    intptr_t file = omni_file_open(bench_file_path, "w");
+    char line[96];
+    for (int64_t i = 0; i < lines; i++) {
+        int len = snprintf(line, sizeof(line), "%lld,item-%lld,%s\n", (long long)i, (long long)(i * 31), "ready");
+        omni_file_write(file, line, len);
+    }
+    omni_file_close(file);
+}
+
+static void bench_file_write(bench_t* b, int64_t n) {
+    // One op is one 64-byte write through a file handle
+    char block[64];
+    memset(block, 'x', sizeof(block));
+    block[sizeof(block) - 1] = '\n';
+    intptr_t file = omni_file_open(bench_file_path, "w");
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_file_write(file, block, (int32_t)sizeof(block));
+    }
+    omni_file_close(file);
+    bench_stop(b, n);
+}
+
+static void bench_file_read_lines(bench_t* b, int64_t n) {
+    bench_make_file(n);
+    bench_start(b);
+    omni_reader_t* reader = omni_reader_open(bench_file_path);
+    size_t len = 0;
+    int64_t lines = 0;
+    while (reader && omni_reader_next_line(reader, &len)) {
+        lines++;
+        bench_sink += (int64_t)len;
+    }
+    omni_reader_free(reader);
+    bench_stop(b, lines);
+}
+
+static void bench_file_read_whole(bench_t* b, int64_t n) {
+    // One op reads the whole 1e4-line file
+    bench_make_file(10000);
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        char* content = omni_read_file(bench_file_path);
+        bench_sink += content ? content[0] : 0;
+        free(content);
+    }
+    bench_stop(b, n);
+}
+
+static void bench_file_copy(bench_t* b, int64_t n) {
+    // One op copies the 1e5-line file
+    bench_make_file(100000);
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink += omni_copy(bench_file_path, bench_copy_path);
+    }
+    bench_stop(b, n);
+    omni_remove(bench_copy_path);
+}
+
+// ============================================================================
+// Logging
+// ============================================================================
+
+// Log output goes to /dev/null while logging benchmarks run
+static int bench_saved_stderr = -1;
+
+static void bench_silence_stderr(void) {
+    fflush(stderr);
+    bench_saved_stderr = dup(STDERR_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+        dup2(null_fd, STDERR_FILENO);
+        close(null_fd);
+    }
+}
+
+static void bench_restore_stderr(void) {
+    fflush(stderr);
+    if (bench_saved_stderr >= 0) {
+        dup2(bench_saved_stderr, STDERR_FILENO);
+        close(bench_saved_stderr);
+        bench_saved_stderr = -1;
+    }
+}
+
+static void bench_log_mode(bench_t* b, int64_t n, const char* mode) {
+    bench_silence_stderr();
+    omni_log_set_mode(mode);
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_log_info("request handled: GET /api/v1/items status=200");
+    }
+    omni_log_flush();
+    bench_stop(b, n);
+    omni_log_set_mode("sync");
+    bench_restore_stderr();
+}
+
+static void bench_log_sync(bench_t* b, int64_t n) {
+    bench_log_mode(b, n, "sync");
+}
+
+static void bench_log_async(bench_t* b, int64_t n) {
+    bench_log_mode(b, n, "async");
+}
+
+static void bench_log_filtered(bench_t* b, int64_t n) {
+    bench_start(b);
+    for (int64_t i = 0; i < n; i++) {
+        omni_log_debug("below the level, never formatted");
+    }
+    bench_stop(b, n);
+}
+
+// ============================================================================
+// Driver
+// ============================================================================
+
+static const bench_spec_t bench_specs[] = {
+    {"map/put_int", bench_map_put_int, 1, 0},
+    {"map/get_int", bench_map_get_int, 1, 0},
+    {"map/delete_int", bench_map_delete_int, 1, 0},
+    {"map/put_string", bench_map_put_string, 1, 0},
+    {"map/get_string", bench_map_get_string, 1, 0},
+    {"map/delete_string", bench_map_delete_string, 1, 0},
+    {"string/concat", bench_string_concat, 0, 1000000},
+    {"string/builder_append_int", bench_string_builder, 0, 1000000},
+    {"string/int_to_string", bench_string_int_to_string, 0, 1000000},
+    {"string/builder_append_float", bench_string_append_float, 0, 1000000},
+    {"string/parse_float", bench_string_parse_float, 0, 1000000},
+    {"string/index_of", bench_string_index_of, 0, 1000000},
+    {"string/to_upper", bench_string_to_upper, 0, 1000000},
+    {"string/equals", bench_string_equals, 0, 1000000},
+    {"string/intern", bench_string_intern, 0, 1000000},
+    {"collections/set_add_contains", bench_set_add_contains, 0, 1000000},
+    {"collections/set_dense_ops", bench_set_dense_ops, 0, 10000000},
+    {"collections/queue_cycle", bench_queue_cycle, 0, 1000000},
+    {"collections/queue_batch", bench_queue_batch, 0, 1000000},
+    {"collections/stack_cycle", bench_stack_cycle, 0, 1000000},
+    {"collections/spsc_handoff", bench_spsc_handoff, 0, 1000000},
+    {"collections/priority_queue_cycle", bench_priority_queue_cycle, 0, 1000000},
+    {"collections/priority_queue_decrease_key", bench_priority_queue_decrease_key, 0, 1000000},
+    {"collections/priority_queue_heapify", bench_priority_queue_heapify, 0, 1000000},
+    {"collections/linked_list_scan", bench_linked_list_scan, 0, 1000000},
+    {"collections/linked_list_cursor", bench_linked_list_cursor, 0, 1000000},
+    {"collections/linked_list_filter", bench_linked_list_filter, 0, 1000000},
+    {"collections/binary_tree_sorted", bench_binary_tree_sorted, 0, 1000000},
+    {"collections/binary_tree_churn", bench_binary_tree_churn, 0, 1000000},
+    {"collections/binary_tree_range", bench_binary_tree_range, 0, 1000000},
+    {"vec/push_sum_int", bench_vec_push_sum, 0, 1000000},
+    {"vec/find_int", bench_vec_find_int, 0, 1000000},
+    {"parallel/sort_int", bench_parallel_sort_int, 0, 10000000},
+    {"parallel/sort_string", bench_parallel_sort_string, 0, 1000000},
+    {"parallel/sum_int", bench_parallel_sum_int, 0, 10000000},
+    {"parallel/build_map_int", bench_parallel_build_map, 0, 1000000},
+    {"chan/mpmc_bounded", bench_chan_bounded, 0, 1000000},
+    {"chan/mpmc_bounded_batch", bench_chan_bounded_batch, 0, 1000000},
+    {"chan/mpmc_unbounded", bench_chan_unbounded, 0, 1000000},
+    {"regex/match_cached", bench_regex_match_cached, 0, 100000},
+    {"regex/exec_compiled", bench_regex_exec_compiled, 0, 100000},
+    {"regex/replace", bench_regex_replace, 0, 20000},
+    {"io/file_write_64b", bench_file_write, 0, 200000},
+    {"io/file_read_lines", bench_file_read_lines, 0, 1000000},
+    {"io/read_file_whole", bench_file_read_whole, 0, 200},
+    {"io/copy_file", bench_file_copy, 0, 50},
+    {"log/info_sync", bench_log_sync, 0, 200000},
+    {"log/info_async", bench_log_async, 0, 200000},
+    {"log/debug_filtered", bench_log_filtered, 0, 1000000},
+};
+
+static void bench_report(FILE* out, int* first, const char* name, const bench_t* best) {
+    double ops = best->ops > 0 ? (double)best->ops : 1.0;
+    fprintf(out, "%s\n    {\"name\":\"%s\",\"ops\":%lld,\"ns_per_op\":%.3f,", *first ? "" : ",", name,
+            (long long)best->ops, (double)best->elapsed_ns / ops);
+#ifdef BENCH_COUNTS_ALLOCS
+    fprintf(out, "\"allocs_per_op\":%.4f,\"bytes_per_op\":%.2f,", (double)best->allocs / ops,
+            (double)best->alloc_bytes / ops);
+#else
+    fprintf(out, "\"allocs_per_op\":-1,\"bytes_per_op\":-1,");
+#endif
+    fprintf(out, "\"rss_bytes\":%lld}", (long long)best->rss_bytes);
+    *first = 0;
+}
+
+static void bench_run(FILE* out, int* first, const char* name, void (*run)(bench_t*, int64_t), int64_t n) {
+    if (bench_filter && !strstr(name, bench_filter)) {
+        return;
+    }
+    bench_t best;
+    memset(&best, 0, sizeof(best));
+    for (int32_t i = 0; i < bench_count; i++) {
+        bench_t b;
+        memset(&b, 0, sizeof(b));
+        bench_rand_state = 2463534242u;
+        run(&b, n);
+        b.rss_bytes = bench_rss_bytes();
+        if (i == 0 || b.elapsed_ns < best.elapsed_ns) {
+            best = b;
+        }
+    }
+    fprintf(stderr, "%-40s %12.1f ns/op\n", name, best.ops > 0 ? (double)best.elapsed_ns / (double)best.ops : 0.0);
+    bench_report(out, first, name, &best);
+}
+
+// Runs program to completion count times from the current directory, with
+// its output discarded
+static int bench_program(FILE* out, int* first, const char* program) {
+    const char* base = strrchr(program, '/');
+    char name[256];
+    snprintf(name, sizeof(name), "program/%s", base ? base + 1 : program);
+    bench_t best;
+    memset(&best, 0, sizeof(best));
+    for (int32_t i = 0; i < bench_count; i++) {
+        int64_t start_ns = omni_time_now_monotonic_nano();
+        pid_t pid = fork();
+        if (pid == 0) {
+            int null_fd = open("/dev/null", O_WRONLY);
+            if (null_fd >= 0) {
+                dup2(null_fd, STDOUT_FILENO);
+                dup2(null_fd, STDERR_FILENO);
+            }
+            execl(program, program, (char*)NULL);
+            _exit(127);
+        }
+        int status = 0;
+        struct rusage usage;
+        if (pid < 0 || wait4(pid, &status, 0, &usage) != pid) {
+            fprintf(stderr, "%s: cannot run\n", program);
+            return 0;
+        }
+        int64_t elapsed_ns = omni_time_now_monotonic_nano() - start_ns;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) == 127) {
+            fprintf(stderr, "%s: did not run to completion\n", program);
+            return 0;
+        }
+        if (i == 0 || elapsed_ns < best.elapsed_ns) {
+            best.elapsed_ns = elapsed_ns;
+        }
+#ifdef __APPLE__
+        int64_t rss = (int64_t)usage.ru_maxrss;
+#else
+        int64_t rss = (int64_t)usage.ru_maxrss * 1024;
+#endif
+        if (rss > best.rss_bytes) {
+            best.rss_bytes = rss;
+        }
+    }
+    best.ops = 1;
+    fprintf(stderr, "%-40s %12.1f ms\n", name, (double)best.elapsed_ns / 1e6);
+    double ns = (double)best.elapsed_ns;
+    fprintf(out, "%s\n    {\"name\":\"%s\",\"ops\":1,\"ns_per_op\":%.0f,\"allocs_per_op\":-1,\"bytes_per_op\":-1,"
+            "\"rss_bytes\":%lld}", *first ? "" : ",", name, ns, (long long)best.rss_bytes);
+    *first = 0;
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    const char* output = NULL;
+    int programs = 0; // Index of the first program after -run
+    for (int i = 1; i < argc && !programs; i++) {
+        if (strcmp(argv[i], "-run") == 0 && i + 1 < argc) {
+            programs = i + 1;
+        } else if (strcmp(argv[i], "-quick") == 0) {
+            bench_max_size = 100000;
+        } else if (strcmp(argv[i], "-max") == 0 && i + 1 < argc) {
+            bench_max_size = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "-count") == 0 && i + 1 < argc) {
+            bench_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc) {
+            bench_filter = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-quick] [-max N] [-count N] [-filter SUBSTR] [-o FILE]\n"
+                            "       %s [-count N] [-o FILE] -run PROGRAM...\n", argv[0], argv[0]);
+            return 2;
+        }
+    }
+    if (bench_count < 1) {
+        bench_count = 1;
+    }
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", output);
+        return 1;
+    }
+    snprintf(bench_file_path, sizeof(bench_file_path), "/tmp/omni_bench_%ld.txt", (long)getpid());
+    snprintf(bench_copy_path, sizeof(bench_copy_path), "%s.copy", bench_file_path);
+
+    fprintf(out, "{\n  \"benchmarks\": [");
+    int first = 1;
+    if (programs) {
+        for (int i = programs; i < argc; i++) {
+            bench_program(out, &first, argv[i]);
+        }
+        fprintf(out, "\n  ]\n}\n");
+        if (out != stdout) {
+            fclose(out);
+        }
+        return 0;
+    }
+    char name[96];
+    for (size_t s = 0; s < sizeof(bench_specs) / sizeof(bench_specs[0]); s++) {
+        const bench_spec_t* spec = &bench_specs[s];
+        if (!spec->sized) {
+            bench_run(out, &first, spec->name, spec->run, spec->n);
+            continue;
+        }
+        for (int64_t n = 1000; n <= bench_max_size; n *= 10) {
+            snprintf(name, sizeof(name), "%s/%lld", spec->name, (long long)n);
+            bench_run(out, &first, name, spec->run, n);
+        }
+    }
+    fprintf(out, "\n  ],\n  \"peak_rss_bytes\": %lld\n}\n", (long long)bench_peak_rss_bytes());
+    omni_remove(bench_file_path);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
@@ -418,6 +418,20 @@ func TestMapComprehensive(t *testing.T) {
 	}
 }
 
+func TestSetAliased(t *testing.T) {
+	testFile := "set_aliased.omni"
+	expected := "3" // union, intersection and difference of a set with itself
+
+	// Test C backend (sets are C backend only)
+	result, err := runCBackend(testFile)
+	if err != nil {
+		t.Fatalf("C backend execution failed: %v", err)
+	}
+	if result != expected {
+		t.Errorf("C backend: expected %s, got %s", expected, result)
+	}
+}
+
 func TestStructBasic(t *testing.T) {
 	testFile := "struct_basic.omni"
 	expected := "10" // p.x where p = Point{x: 10, y: 20}
@@ -653,6 +667,29 @@ func TestTypeCasting(t *testing.T) {
 	}
 }
 
+func TestFloatFormat(t *testing.T) {
+	testFile := "float_format.omni"
+	expected := "26" // formatting, halfway rounding and round-trip checks
+
+	// Test VM backend
+	result, err := runVM(testFile)
+	if err != nil {
+		t.Fatalf("VM execution failed: %v", err)
+	}
+	if result != expected {
+		t.Errorf("VM: expected %s, got %s", expected, result)
+	}
+
+	// Test C backend
+	result, err = runCBackend(testFile)
+	if err != nil {
+		t.Fatalf("C backend execution failed: %v", err)
+	}
+	if result != expected {
+		t.Errorf("C backend: expected %s, got %s", expected, result)
+	}
+}
+
 func TestLexicalPrimitives(t *testing.T) {
 	testFile := "new_features/test_lexical_primitives.omni"
 	expected := "Null literal test passed\nHex 0xFF: 255\nHex 0x1A: 26\nHex 0x10_00: 4096\nBinary 0b1010: 10\nBinary 0b1111_0000: 240\nBinary 0b1: 1\nScientific 1.0e5: 100000\nScientific 2.5e-3: 0.0025\nScientific 1.23E+2: 123\nMixed sum: 100265\n0"
@@ -0,0 +1,48 @@
+package runtime
+
+import (
+	"fmt"
+	"strings"
+	"testing"
+)
+
+func TestBinaryTree(t *testing.T) {
+	output := runCTest(t, buildCTest(t, "binary_tree.c"), t.TempDir())
+	type tally struct{ checked, mismatched int }
+	tallies := map[string]tally{}
+	for _, line := range strings.Split(strings.TrimSpace(output), "\n") {
+		var op string
+		var c tally
+		if _, err := fmt.Sscan(line, &op, &c.checked, &c.mismatched); err != nil {
+			t.Fatalf("bad tally line %q: %v", line, err)
+		}
+		tallies[op] = c
+	}
+
+	// Each operation must have been compared with the reference at least
+	// this often, so a broken loop cannot pass by checking nothing
+	minimum := map[string]int{
+		"size":        20,
+		"min_max":     20,
+		"lower_bound": 1000,
+		"upper_bound": 1000,
+		"search":      1000,
+		"range":       1000,
+		"walk":        10000,
+		"update":      40000,
+	}
+	for op, least := range minimum {
+		c, ok := tallies[op]
+		switch {
+		case !ok:
+			t.Errorf("%s: not reported", op)
+		case c.mismatched != 0:
+			t.Errorf("%s: %d of %d results differ from the reference", op, c.mismatched, c.checked)
+		case c.checked < least:
+			t.Errorf("%s: only %d results checked, want at least %d", op, c.checked, least)
+		}
+	}
+	if len(tallies) != len(minimum) {
+		t.Errorf("reported operations %v, want %d", tallies, len(minimum))
+	}
+}
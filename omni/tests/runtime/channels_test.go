@@ -0,0 +1,81 @@
+package runtime
+
+import (
+	"fmt"
+	"strings"
+	"testing"
+)
+
+func TestChannels(t *testing.T) {
+	bin := buildCTest(t, "channels.c")
+	delivered := []string{
+		"sent 60000, received 60000",
+		"exactly once: 1",
+		"sends accepted and in order: 1",
+		"left: 0",
+	}
+	drained := []string{
+		"sent 8, len 8",
+		"closed: 1",
+		"send after close: 0 0 0",
+		"drained: 0 1 2 3 4 5 6 7",
+		"recv after drain: 0 0 0",
+		"left: 0",
+	}
+	type scenario struct {
+		name string
+		args []string
+		want []string
+	}
+	// Three producers and three consumers share one channel, sending and
+	// receiving singly or in batches
+	var scenarios []scenario
+	for _, capacity := range []int{1, 4, 64, 0} {
+		for _, mode := range []struct{ send, recv int }{{0, 0}, {1, 0}, {0, 1}, {1, 1}} {
+			scenarios = append(scenarios, scenario{
+				name: fmt.Sprintf("mpmc/capacity=%d/batch_send=%d/batch_recv=%d", capacity, mode.send, mode.recv),
+				args: []string{"mpmc", fmt.Sprint(capacity), fmt.Sprint(mode.send), fmt.Sprint(mode.recv)},
+				want: delivered,
+			})
+		}
+	}
+	scenarios = append(scenarios,
+		scenario{"close_then_drain/bounded", []string{"close_then_drain", "8"}, drained},
+		scenario{"close_then_drain/unbounded", []string{"close_then_drain", "0"}, drained},
+		scenario{"close_wakes_waiters", []string{"close_wakes_waiters"}, []string{
+			"blocked recv returned 0",
+			"blocked recv returned 0",
+			"blocked send_n of 10 returned 4, len 4",
+		}},
+		scenario{"batches", []string{"batches"}, []string{
+			"capacity 16",
+			"sent 10, took 4, sent 10, len 16",
+			"try_send when full: 0",
+			"took 16 more, all intact and in order: 1",
+			"try_recv when empty: 0",
+			"unbounded capacity 0",
+			"sent 5000, len 5000",
+			"took 5000 in batches of 333, in order: 1",
+			"empty batch: 0",
+		}},
+		scenario{"select", []string{"select"}, []string{
+			"nothing ready: -1",
+			"b ready: case 1, ok 1, value 7",
+			"sends into room for 2: 2, len 2",
+			"both ready, each picked: 1",
+			"blocking: case 1, ok 1, value 42",
+			"closed recv: case 1, ok 0",
+			"closed send: case 0, ok 0",
+			"no channels: -1",
+		}},
+	)
+
+	for _, sc := range scenarios {
+		t.Run(sc.name, func(t *testing.T) {
+			got := strings.Split(strings.TrimSuffix(runCTest(t, bin, t.TempDir(), sc.args...), "\n"), "\n")
+			if strings.Join(got, "\n") != strings.Join(sc.want, "\n") {
+				t.Errorf("got:\n%s\nwant:\n%s", strings.Join(got, "\n"), strings.Join(sc.want, "\n"))
+			}
+		})
+	}
+}
@@ -0,0 +1,7 @@
+package runtime
+
+import "testing"
+
+func TestFileIO(t *testing.T) {
+	runCTest(t, buildCTest(t, "file_io.c"), t.TempDir())
+}
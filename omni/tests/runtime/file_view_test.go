@@ -0,0 +1,56 @@
+package runtime
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+)
+
+func TestFileView(t *testing.T) {
+	dir := t.TempDir()
+	// page.txt fills exactly one page and ends in a three-byte rune
+	page := strings.Repeat("a", os.Getpagesize()-3) + "€"
+	files := map[string]string{
+		"text.txt":  "first line\nsecond line\n",
+		"empty.txt": "",
+		"page.txt":  page,
+	}
+	for name, contents := range files {
+		if err := os.WriteFile(filepath.Join(dir, name), []byte(contents), 0o644); err != nil {
+			t.Fatal(err)
+		}
+	}
+
+	want := []string{
+		`text.txt advice 0: "first line\nsecond line\n", advise 0`,
+		`text.txt advice 1: "first line\nsecond line\n", advise 0`,
+		`text.txt advice 2: "first line\nsecond line\n", advise 0`,
+		`text.txt advice 3: "first line\nsecond line\n", advise 0`,
+		`advise past the end: -1`,
+		`advise a clipped range: 0`,
+		`advise an unknown advice: -1`,
+		`contains "second": 1`,
+		`index of "line": 6`,
+		`empty.txt: 0 bytes`,
+		`missing.txt: not mapped`,
+		`.: not mapped`,
+		`NULL path: not mapped`,
+		fmt.Sprintf(`page.txt: %d bytes`, len(page)),
+		`last two bytes: ""`,
+		`last three bytes: "\xe2\x82\xac"`,
+	}
+	output := runCTest(t, buildCTest(t, "file_view.c"), dir)
+	got := strings.Split(strings.TrimSuffix(output, "\n"), "\n")
+	for i, line := range want {
+		if i >= len(got) {
+			t.Errorf("missing line %d: want %s", i+1, line)
+		} else if got[i] != line {
+			t.Errorf("line %d: got %s, want %s", i+1, got[i], line)
+		}
+	}
+	if len(got) > len(want) {
+		t.Errorf("unexpected lines:\n%s", strings.Join(got[len(want):], "\n"))
+	}
+}
@@ -0,0 +1,7 @@
+package runtime
+
+import "testing"
+
+func TestNumbers(t *testing.T) {
+	runCTest(t, buildCTest(t, "numbers.c"), t.TempDir())
+}
@@ -0,0 +1,7 @@
+package runtime
+
+import "testing"
+
+func TestQueues(t *testing.T) {
+	runCTest(t, buildCTest(t, "queues.c"), t.TempDir())
+}
@@ -0,0 +1,116 @@
+package runtime
+
+import (
+	"bytes"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"regexp"
+	"strconv"
+	"strings"
+	"testing"
+)
+
+var recordHeader = regexp.MustCompile(`^(\w+)\[(\d+)\]$`)
+
+// parseRecords splits reader.c output into "<tag> <bytes>" for each record
+// and the plain lines between them
+func parseRecords(t *testing.T, output string) []string {
+	t.Helper()
+	var records []string
+	for output != "" {
+		line, rest, _ := strings.Cut(output, "\n")
+		output = rest
+		m := recordHeader.FindStringSubmatch(line)
+		if m == nil {
+			records = append(records, line)
+			continue
+		}
+		n, _ := strconv.Atoi(m[2])
+		if n >= len(output) || output[n] != '\n' {
+			t.Fatalf("truncated %s record", line)
+		}
+		records = append(records, m[1]+" "+output[:n])
+		output = output[n+1:]
+	}
+	return records
+}
+
+func TestReader(t *testing.T) {
+	bin := buildCTest(t, "reader.c")
+	dir := t.TempDir()
+	write := func(name, contents string) {
+		if err := os.WriteFile(filepath.Join(dir, name), []byte(contents), 0o644); err != nil {
+			t.Fatal(err)
+		}
+	}
+
+	// \r\n and \n end lines; a bare \r is part of the line
+	write("lines.txt", "one\r\ntwo\n\nbare\rcarriage\n\r\nlast")
+	lines := []string{"line one", "line two", "line ", "line bare\rcarriage", "line ", "line last", "end", "end"}
+
+	// Lines longer than the initial buffer, both mid-file and unterminated
+	first := strings.Repeat("abcdefghijklmnopqrstuvwxyz", 12000)
+	second := strings.Repeat("ABCDEFGHIJKLMNOPQRSTUVWXYZ", 12000)
+	write("long.txt", "short\n"+first+"\n"+second)
+	long := []string{"line short", "line " + first, "line " + second, "end", "end"}
+
+	write("pos.txt", "header\nfirst\nsecond\nthird\n")
+
+	tests := []struct {
+		name  string
+		args  []string
+		stdin string
+		want  []string
+	}{
+		{"open", []string{"open", "lines.txt"}, "", lines},
+		{"view", []string{"view", "lines.txt"}, "", lines},
+		{"file", []string{"file", "lines.txt"}, "", lines},
+		// Devices cannot be mapped and are read through the buffer
+		{"device", []string{"open", "/dev/null"}, "", []string{"end", "end"}},
+		{"long mapped", []string{"open", "long.txt"}, "", long},
+		{"long buffered", []string{"file", "long.txt"}, "", long},
+		{"position", []string{"position", "pos.txt"}, "", []string{"skipped header\n", "line first", "tell 13", "rest second\nthird\n"}},
+		{"stdin", []string{"stdin"}, "typed\r\nsecond\nrest", []string{"read_line typed", "shared", "line second", "read_line rest", "read_line ", "end", "end"}},
+		{"invalid", []string{"invalid"}, "", []string{"open missing: NULL", "open NULL: NULL", "view NULL: NULL", "file -1: NULL", "next_line NULL: NULL"}},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			var output string
+			if tt.stdin == "" {
+				output = runCTest(t, bin, dir, tt.args...)
+			} else {
+				// omni_reader_stdin reads the process's own standard input
+				var stdout bytes.Buffer
+				cmd := exec.Command(bin, tt.args...)
+				cmd.Dir = dir
+				cmd.Stdin = strings.NewReader(tt.stdin)
+				cmd.Stdout = &stdout
+				cmd.Stderr = os.Stderr
+				if err := cmd.Run(); err != nil {
+					t.Fatalf("reader %s failed: %v", strings.Join(tt.args, " "), err)
+				}
+				output = stdout.String()
+			}
+			got := parseRecords(t, output)
+			for i := 0; i < len(got) || i < len(tt.want); i++ {
+				switch {
+				case i >= len(got):
+					t.Errorf("record %d: missing, want %q", i, abbreviate(tt.want[i]))
+				case i >= len(tt.want):
+					t.Errorf("record %d: got %q, want no more", i, abbreviate(got[i]))
+				case got[i] != tt.want[i]:
+					t.Errorf("record %d: got %q, want %q", i, abbreviate(got[i]), abbreviate(tt.want[i]))
+				}
+			}
+		})
+	}
+}
+
+// abbreviate shortens a long record so a failure stays readable
+func abbreviate(record string) string {
+	if len(record) <= 60 {
+		return record
+	}
+	return record[:40] + "... (" + strconv.Itoa(len(record)) + " bytes)"
+}
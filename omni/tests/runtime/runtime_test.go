@@ -0,0 +1,80 @@
+package runtime
+
+import (
+	"bytes"
+	"fmt"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"strings"
+	"testing"
+)
+
+// Behavioural tests of runtime APIs that OmniLang programs do not call
+// directly. Each test drives a C program from testdata, linked with the
+// runtime; depending on the API it either checks results itself and exits
+// non-zero on a failure, or prints what it observed for the Go test to
+// compare.
+
+var (
+	runtimeObject string
+	buildError    error
+)
+
+func TestMain(m *testing.M) {
+	dir, err := os.MkdirTemp("", "omni-rt-test")
+	if err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+	runtimeObject, buildError = buildRuntime(dir)
+	code := m.Run()
+	os.RemoveAll(dir)
+	os.Exit(code)
+}
+
+// buildRuntime compiles runtime/omni_rt.c once for all tests
+func buildRuntime(dir string) (string, error) {
+	if _, err := exec.LookPath("gcc"); err != nil {
+		return "", err
+	}
+	obj := filepath.Join(dir, "omni_rt.o")
+	cmd := exec.Command("gcc", "-c", "-O1", "-g", "-pthread", "-I../../runtime", "-o", obj, "../../runtime/omni_rt.c")
+	if output, err := cmd.CombinedOutput(); err != nil {
+		return "", fmt.Errorf("compiling the runtime failed: %v\n%s", err, output)
+	}
+	return obj, nil
+}
+
+// buildCTest compiles testdata/source against the runtime and returns the
+// path of the program
+func buildCTest(t *testing.T, source string) string {
+	t.Helper()
+	if buildError != nil {
+		if _, err := exec.LookPath("gcc"); err != nil {
+			t.Skip("gcc not found")
+		}
+		t.Fatal(buildError)
+	}
+	bin := filepath.Join(t.TempDir(), strings.TrimSuffix(source, ".c"))
+	compile := exec.Command("gcc", "-O1", "-g", "-pthread", "-I../../runtime", "-o", bin, filepath.Join("testdata", source), runtimeObject, "-lm")
+	if output, err := compile.CombinedOutput(); err != nil {
+		t.Fatalf("compiling %s failed: %v\n%s", source, err, output)
+	}
+	return bin
+}
+
+// runCTest runs a program from buildCTest in dir and returns its standard
+// output; a non-zero exit fails the test
+func runCTest(t *testing.T, bin, dir string, args ...string) string {
+	t.Helper()
+	var stdout, stderr bytes.Buffer
+	run := exec.Command(bin, args...)
+	run.Dir = dir
+	run.Stdout = &stdout
+	run.Stderr = &stderr
+	if err := run.Run(); err != nil {
+		t.Fatalf("%s %s failed: %v\n%s%s", filepath.Base(bin), strings.Join(args, " "), err, stdout.String(), stderr.String())
+	}
+	return stdout.String()
+}
@@ -0,0 +1,213 @@
+// B+-tree ordered set: bounds, ranges and iteration against a reference.
+// Every comparison is tallied under the operation it exercises, and main
+// prints "<operation> <checked> <mismatched>" for binary_tree_test.go.
+
+#include "omni_rt.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+enum {
+    OP_SIZE,
+    OP_MIN_MAX,
+    OP_LOWER_BOUND,
+    OP_UPPER_BOUND,
+    OP_SEARCH,
+    OP_RANGE,
+    OP_WALK,
+    OP_UPDATE,
+    OP_COUNT,
+};
+
+static const char* op_names[OP_COUNT] = {
+    "size", "min_max", "lower_bound", "upper_bound", "search", "range", "walk", "update",
+};
+
+static long checked[OP_COUNT], mismatched[OP_COUNT];
+
+static void tally(int op, int ok) {
+    checked[op]++;
+    mismatched[op] += !ok;
+}
+
+// Keys are drawn from a small domain so inserts and removes collide; the
+// reference is a presence flag per key, scanned linearly for each answer
+#define DOMAIN 6000
+#define KEY_BASE (-3000)
+
+static unsigned char present[DOMAIN];
+static int32_t present_count;
+static uint32_t rng = 88172645u;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// Reference lower bound: smallest present key >= key
+static int ref_lower_bound(int64_t key, int32_t* out) {
+    int64_t start = key - KEY_BASE;
+    if (start < 0) start = 0;
+    for (int64_t i = start; i < DOMAIN; i++) {
+        if (present[i]) {
+            *out = (int32_t)(i + KEY_BASE);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int32_t ref_range(int32_t lo, int32_t hi, int32_t* out, int32_t max) {
+    int32_t n = 0;
+    for (int32_t i = 0; i < DOMAIN; i++) {
+        int32_t key = i + KEY_BASE;
+        if (!present[i] || key < lo || key > hi) continue;
+        if (out) {
+            if (n == max) break;
+            out[n] = key;
+        }
+        n++;
+    }
+    return n;
+}
+
+static int32_t got[DOMAIN], want[DOMAIN];
+
+static int same_prefix(int32_t n) {
+    for (int32_t i = 0; i < n; i++) {
+        if (got[i] != want[i]) return 0;
+    }
+    return 1;
+}
+
+static void check_against_reference(omni_binary_tree_t* bt) {
+    tally(OP_SIZE, omni_binary_tree_size(bt) == present_count);
+    tally(OP_SIZE, omni_binary_tree_is_empty(bt) == (present_count == 0));
+
+    int32_t value = 0, expected = 0;
+    int has = ref_lower_bound(KEY_BASE, &expected);
+    tally(OP_MIN_MAX, omni_binary_tree_min(bt, &value) == has && (!has || value == expected));
+    for (int32_t i = DOMAIN - 1; i >= -1; i--) {
+        if (i < 0) {
+            tally(OP_MIN_MAX, omni_binary_tree_max(bt, &value) == 0);
+        } else if (present[i]) {
+            tally(OP_MIN_MAX, omni_binary_tree_max(bt, &value) == 1 && value == i + KEY_BASE);
+            break;
+        }
+    }
+
+    // Bounds at, between and beyond the stored keys
+    for (int32_t q = 0; q < 200; q++) {
+        int32_t key = (int32_t)(next_random() % (DOMAIN + 200)) + KEY_BASE - 100;
+        has = ref_lower_bound(key, &expected);
+        value = INT32_MIN;
+        tally(OP_LOWER_BOUND, omni_binary_tree_lower_bound(bt, key, &value) == has && (!has || value == expected));
+        has = ref_lower_bound((int64_t)key + 1, &expected);
+        tally(OP_UPPER_BOUND, omni_binary_tree_upper_bound(bt, key, &value) == has && (!has || value == expected));
+        tally(OP_SEARCH, omni_binary_tree_search(bt, key) ==
+                             (key >= KEY_BASE && key < KEY_BASE + DOMAIN && present[key - KEY_BASE]));
+    }
+
+    // Ranges of every width, including empty, truncated and count-only
+    for (int32_t q = 0; q < 100; q++) {
+        int32_t lo = (int32_t)(next_random() % (DOMAIN + 200)) + KEY_BASE - 100;
+        int32_t hi = lo + (int32_t)(next_random() % (q % 4 == 0 ? DOMAIN : 80)) - 5;
+        int32_t max = q % 3 == 0 ? (int32_t)(next_random() % 50) : DOMAIN;
+        int32_t n = omni_binary_tree_range(bt, lo, hi, got, max);
+        tally(OP_RANGE, n == ref_range(lo, hi, want, max) && same_prefix(n));
+        tally(OP_RANGE, omni_binary_tree_range(bt, lo, hi, NULL, 0) == ref_range(lo, hi, NULL, 0));
+    }
+    tally(OP_RANGE, omni_binary_tree_range(bt, INT32_MIN, INT32_MAX, got, DOMAIN) == present_count);
+
+    // A full in-order walk visits exactly the reference keys
+    int32_t n = ref_range(INT32_MIN, INT32_MAX, want, DOMAIN);
+    int32_t walked = 0;
+    for (omni_binary_tree_iter_t it = omni_binary_tree_iter_begin(bt); omni_binary_tree_iter_valid(&it);
+         omni_binary_tree_iter_next(&it)) {
+        tally(OP_WALK, walked < n && omni_binary_tree_iter_value(&it) == want[walked]);
+        walked++;
+    }
+    tally(OP_WALK, walked == n);
+}
+
+static void test_random_workload(void) {
+    omni_binary_tree_t* bt = omni_binary_tree_create();
+    check_against_reference(bt);
+    // Phases that grow the tree, shrink it through merges, then churn
+    int32_t inserts_per_mille[] = {900, 700, 200, 50, 500, 500};
+    for (int phase = 0; phase < 6; phase++) {
+        for (int32_t op = 0; op < 8000; op++) {
+            int32_t i = (int32_t)(next_random() % DOMAIN);
+            int32_t key = i + KEY_BASE;
+            if ((int32_t)(next_random() % 1000) < inserts_per_mille[phase]) {
+                tally(OP_UPDATE, omni_binary_tree_add(bt, key) == !present[i]);
+                present_count += !present[i];
+                present[i] = 1;
+            } else {
+                tally(OP_UPDATE, omni_binary_tree_remove(bt, key) == present[i]);
+                present_count -= present[i];
+                present[i] = 0;
+            }
+        }
+        check_against_reference(bt);
+    }
+
+    // Remove everything, in ascending order, so leaves empty one by one
+    for (int32_t i = 0; i < DOMAIN; i++) {
+        if (present[i]) omni_binary_tree_remove(bt, i + KEY_BASE);
+        present[i] = 0;
+    }
+    present_count = 0;
+    check_against_reference(bt);
+    int32_t value;
+    tally(OP_LOWER_BOUND, omni_binary_tree_lower_bound(bt, 0, &value) == 0);
+    tally(OP_RANGE, omni_binary_tree_range(bt, INT32_MIN, INT32_MAX, got, DOMAIN) == 0);
+
+    // The tree is usable again after emptying and after clear
+    for (int32_t i = 0; i < DOMAIN; i += 3) {
+        omni_binary_tree_insert(bt, i + KEY_BASE);
+        present[i] = 1;
+        present_count++;
+    }
+    check_against_reference(bt);
+    omni_binary_tree_clear(bt);
+    for (int32_t i = 0; i < DOMAIN; i++) present[i] = 0;
+    present_count = 0;
+    check_against_reference(bt);
+    omni_binary_tree_destroy(bt);
+}
+
+static void test_extreme_keys(void) {
+    omni_binary_tree_t* bt = omni_binary_tree_create();
+    omni_binary_tree_insert(bt, INT32_MAX);
+    omni_binary_tree_insert(bt, INT32_MIN);
+    omni_binary_tree_insert(bt, 0);
+    int32_t value = 0;
+    tally(OP_LOWER_BOUND, omni_binary_tree_lower_bound(bt, INT32_MIN, &value) == 1 && value == INT32_MIN);
+    tally(OP_LOWER_BOUND, omni_binary_tree_lower_bound(bt, INT32_MAX, &value) == 1 && value == INT32_MAX);
+    tally(OP_UPPER_BOUND, omni_binary_tree_upper_bound(bt, INT32_MIN, &value) == 1 && value == 0);
+    tally(OP_UPPER_BOUND, omni_binary_tree_upper_bound(bt, 0, &value) == 1 && value == INT32_MAX);
+    tally(OP_UPPER_BOUND, omni_binary_tree_upper_bound(bt, INT32_MAX, &value) == 0);
+    int32_t keys[3];
+    tally(OP_RANGE, omni_binary_tree_range(bt, INT32_MIN, INT32_MAX, keys, 3) == 3 &&
+                        keys[0] == INT32_MIN && keys[1] == 0 && keys[2] == INT32_MAX);
+    tally(OP_RANGE, omni_binary_tree_range(bt, 1, -1, keys, 3) == 0);
+    tally(OP_RANGE, omni_binary_tree_range(bt, INT32_MAX, INT32_MAX, keys, 3) == 1 && keys[0] == INT32_MAX);
+    omni_binary_tree_destroy(bt);
+
+    // A NULL tree is empty
+    tally(OP_MIN_MAX, omni_binary_tree_min(NULL, &value) == 0);
+    tally(OP_RANGE, omni_binary_tree_range(NULL, 0, 1, keys, 3) == 0);
+    omni_binary_tree_iter_t it = omni_binary_tree_iter_seek(NULL, 0);
+    tally(OP_WALK, omni_binary_tree_iter_valid(&it) == 0);
+}
+
+int main(void) {
+    test_random_workload();
+    test_extreme_keys();
+    for (int op = 0; op < OP_COUNT; op++) {
+        printf("%s %ld %ld\n", op_names[op], checked[op], mismatched[op]);
+    }
+    return 0;
+}
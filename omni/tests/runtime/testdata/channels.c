@@ -0,0 +1,294 @@
+// MPMC channels: delivery, close-then-drain, batches and select.
+//
+// Usage: channels <scenario> [args]. Each scenario prints what it observed,
+// one fact per line, and channels_test.go compares the lines.
+
+#include "omni_rt.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Several producers and consumers share one channel. Each value names its
+// producer and sequence number; consumers count every value they see, so
+// a lost or duplicated value shows as a count other than one, and each
+// consumer must see any one producer's values in the order they were sent.
+#define PRODUCERS 3
+#define CONSUMERS 3
+#define PER_PRODUCER 20000
+#define TOTAL (PRODUCERS * PER_PRODUCER)
+
+typedef struct {
+    omni_chan_t* chan;
+    int32_t id;
+    int32_t batch;
+    int32_t ok;      // Cleared on a failed send or an out-of-order value
+    int64_t received;
+} worker_t;
+
+static int32_t seen[TOTAL];
+
+static void* producer(void* arg) {
+    worker_t* w = (worker_t*)arg;
+    int64_t base = (int64_t)w->id * PER_PRODUCER;
+    if (w->batch) {
+        int64_t buf[37];
+        for (int32_t i = 0; i < PER_PRODUCER;) {
+            int32_t n = 0;
+            while (n < 37 && i < PER_PRODUCER) buf[n++] = base + i++;
+            if (omni_chan_send_n(w->chan, buf, n) != n) w->ok = 0;
+        }
+    } else {
+        for (int32_t i = 0; i < PER_PRODUCER; i++) {
+            int64_t value = base + i;
+            if (!omni_chan_send(w->chan, &value)) w->ok = 0;
+        }
+    }
+    return NULL;
+}
+
+static void consume(worker_t* w, int64_t value, int64_t* last) {
+    __atomic_fetch_add(&seen[value], 1, __ATOMIC_RELAXED);
+    int64_t from = value / PER_PRODUCER;
+    if (value <= last[from]) w->ok = 0;
+    last[from] = value;
+    w->received++;
+}
+
+static void* consumer(void* arg) {
+    worker_t* w = (worker_t*)arg;
+    int64_t last[PRODUCERS] = {-1, -1, -1};
+    int64_t buf[16];
+    for (;;) {
+        if (w->batch) {
+            int32_t n = omni_chan_recv_n(w->chan, buf, 16);
+            if (n == 0) break;
+            for (int32_t i = 0; i < n; i++) consume(w, buf[i], last);
+        } else {
+            int64_t value;
+            if (!omni_chan_recv(w->chan, &value)) break;
+            consume(w, value, last);
+        }
+    }
+    return NULL;
+}
+
+static void test_mpmc(int32_t capacity, int32_t batch_send, int32_t batch_recv) {
+    memset(seen, 0, sizeof(seen));
+    omni_chan_t* chan = omni_chan_create(sizeof(int64_t), capacity);
+    pthread_t threads[PRODUCERS + CONSUMERS];
+    worker_t workers[PRODUCERS + CONSUMERS];
+    for (int32_t i = 0; i < PRODUCERS + CONSUMERS; i++) {
+        int producing = i < PRODUCERS;
+        workers[i] = (worker_t){chan, producing ? i : i - PRODUCERS, producing ? batch_send : batch_recv, 1, 0};
+        pthread_create(&threads[i], NULL, producing ? producer : consumer, &workers[i]);
+    }
+    for (int32_t i = 0; i < PRODUCERS; i++) pthread_join(threads[i], NULL);
+    // Consumers drain what is left after the close, then see the end
+    omni_chan_close(chan);
+    int64_t received = 0;
+    int ordered = 1;
+    for (int32_t i = 0; i < PRODUCERS + CONSUMERS; i++) {
+        if (i >= PRODUCERS) pthread_join(threads[i], NULL);
+        ordered &= workers[i].ok;
+        received += workers[i].received;
+    }
+    int exactly_once = 1;
+    for (int32_t i = 0; i < TOTAL; i++) exactly_once &= seen[i] == 1;
+    printf("sent %d, received %lld\n", TOTAL, (long long)received);
+    printf("exactly once: %d\n", exactly_once);
+    printf("sends accepted and in order: %d\n", ordered);
+    printf("left: %d\n", omni_chan_len(chan));
+    omni_chan_destroy(chan);
+}
+
+static void test_close_then_drain(int32_t capacity) {
+    omni_chan_t* chan = omni_chan_create(sizeof(int32_t), capacity);
+    int32_t sent = 0;
+    for (int32_t i = 0; i < 8; i++) sent += omni_chan_try_send(chan, &i);
+    printf("sent %d, len %d\n", sent, omni_chan_len(chan));
+    omni_chan_close(chan);
+    printf("closed: %d\n", omni_chan_is_closed(chan));
+
+    int32_t value = 99;
+    printf("send after close: %d %d %d\n", omni_chan_send(chan, &value), omni_chan_try_send(chan, &value),
+           omni_chan_send_n(chan, &value, 1));
+    // Everything sent before the close still arrives, in order
+    printf("drained:");
+    for (int32_t i = 0; i < 5 && omni_chan_recv(chan, &value); i++) printf(" %d", value);
+    int32_t rest[8];
+    int32_t n = omni_chan_recv_n(chan, rest, 8);
+    for (int32_t i = 0; i < n; i++) printf(" %d", rest[i]);
+    printf("\n");
+    printf("recv after drain: %d %d %d\n", omni_chan_recv(chan, &value), omni_chan_try_recv(chan, &value),
+           omni_chan_recv_n(chan, rest, 8));
+    printf("left: %d\n", omni_chan_len(chan));
+    omni_chan_destroy(chan);
+}
+
+// Threads blocked on a channel wake up when it closes
+static void* blocked_recv(void* arg) {
+    int32_t value;
+    return (void*)(intptr_t)omni_chan_recv((omni_chan_t*)arg, &value);
+}
+
+static void* blocked_send_n(void* arg) {
+    int32_t values[10] = {0};
+    return (void*)(intptr_t)omni_chan_send_n((omni_chan_t*)arg, values, 10);
+}
+
+static void test_close_wakes_waiters(void) {
+    omni_chan_t* empty = omni_chan_create(sizeof(int32_t), 4);
+    omni_chan_t* full = omni_chan_create(sizeof(int32_t), 4);
+    pthread_t receivers[2], sender;
+    for (int i = 0; i < 2; i++) pthread_create(&receivers[i], NULL, blocked_recv, empty);
+    pthread_create(&sender, NULL, blocked_send_n, full);
+    usleep(20000);
+    omni_chan_close(empty);
+    omni_chan_close(full);
+    void* result;
+    for (int i = 0; i < 2; i++) {
+        pthread_join(receivers[i], &result);
+        printf("blocked recv returned %d\n", (int)(intptr_t)result);
+    }
+    // The first four fit before the close; the rest were refused
+    pthread_join(sender, &result);
+    printf("blocked send_n of 10 returned %d, len %d\n", (int)(intptr_t)result, omni_chan_len(full));
+    omni_chan_destroy(empty);
+    omni_chan_destroy(full);
+}
+
+typedef struct {
+    int32_t id;
+    char tag[8];
+} record_t;
+
+static void test_batches(void) {
+    // Elements of an odd size are copied whole, in order
+    omni_chan_t* chan = omni_chan_create(sizeof(record_t), 16);
+    printf("capacity %d\n", omni_chan_capacity(chan));
+    record_t records[10], out[20];
+    for (int32_t i = 0; i < 10; i++) {
+        records[i].id = i;
+        memcpy(records[i].tag, "record", 7);
+        records[i].tag[7] = (char)('a' + i);
+    }
+    int32_t first = omni_chan_send_n(chan, records, 10);
+    int32_t taken = omni_chan_recv_n(chan, out, 4);
+    int32_t second = omni_chan_send_n(chan, records, 10);
+    printf("sent %d, took %d, sent %d, len %d\n", first, taken, second, omni_chan_len(chan));
+    printf("try_send when full: %d\n", omni_chan_try_send(chan, &records[0]));
+    int32_t rest = omni_chan_recv_n(chan, out + 4, 20);
+    int same = 1;
+    for (int32_t i = 0; i < 4 + rest; i++) same &= memcmp(&out[i], &records[i % 10], sizeof(record_t)) == 0;
+    printf("took %d more, all intact and in order: %d\n", rest, same);
+    printf("try_recv when empty: %d\n", omni_chan_try_recv(chan, out));
+    omni_chan_destroy(chan);
+
+    // A batch larger than an unbounded channel's segments stays in order
+    chan = omni_chan_create(sizeof(int32_t), 0);
+    printf("unbounded capacity %d\n", omni_chan_capacity(chan));
+    enum { BIG = 5000 };
+    int32_t* values = (int32_t*)malloc(BIG * sizeof(int32_t));
+    int32_t* back = (int32_t*)malloc(BIG * sizeof(int32_t));
+    for (int32_t i = 0; i < BIG; i++) values[i] = i * 3;
+    int32_t sent = omni_chan_send_n(chan, values, BIG);
+    printf("sent %d, len %d\n", sent, omni_chan_len(chan));
+    taken = 0;
+    while (taken < BIG) {
+        int32_t n = omni_chan_recv_n(chan, back + taken, 333);
+        if (n <= 0) break;
+        taken += n;
+    }
+    printf("took %d in batches of 333, in order: %d\n", taken, memcmp(values, back, BIG * sizeof(int32_t)) == 0);
+    printf("empty batch: %d\n", omni_chan_send_n(chan, values, 0));
+    free(values);
+    free(back);
+    omni_chan_destroy(chan);
+}
+
+static void* delayed_send(void* arg) {
+    usleep(20000);
+    int32_t value = 42;
+    omni_chan_send((omni_chan_t*)arg, &value);
+    return NULL;
+}
+
+static void test_select(void) {
+    omni_chan_t* a = omni_chan_create(sizeof(int32_t), 2);
+    omni_chan_t* b = omni_chan_create(sizeof(int32_t), 0);
+    int32_t from_a = 0, from_b = 0, seven = 7;
+    omni_chan_case_t cases[3] = {
+        {a, OMNI_CHAN_RECV, &from_a, 0},
+        {b, OMNI_CHAN_RECV, &from_b, 0},
+        {NULL, OMNI_CHAN_RECV, NULL, 0},
+    };
+    printf("nothing ready: %d\n", omni_chan_select(cases, 3, 0));
+    omni_chan_send(b, &seven);
+    int32_t index = omni_chan_select(cases, 3, 1);
+    printf("b ready: case %d, ok %d, value %d\n", index, cases[1].ok, from_b);
+
+    // Send cases complete only while there is room
+    omni_chan_case_t sends[2] = {{a, OMNI_CHAN_SEND, &seven, 0}, {a, OMNI_CHAN_SEND, &seven, 0}};
+    int32_t completed = 0;
+    for (int i = 0; i < 3; i++) completed += omni_chan_select(sends, 2, 0) >= 0;
+    printf("sends into room for 2: %d, len %d\n", completed, omni_chan_len(a));
+
+    // With both sides ready, each is chosen some of the time
+    int32_t picked[2] = {0, 0};
+    for (int32_t i = 0; i < 40; i++) {
+        int32_t one = 1;
+        omni_chan_send(b, &one);
+        index = omni_chan_select(cases, 2, 0);
+        if (index != 0 && index != 1) {
+            printf("both ready: case %d\n", index);
+            break;
+        }
+        picked[index]++;
+        if (index == 0) omni_chan_send(a, &seven);
+    }
+    printf("both ready, each picked: %d\n", picked[0] > 0 && picked[1] > 0);
+    while (omni_chan_try_recv(b, &from_b)) {}
+
+    // A blocking select waits for a send from another thread
+    int32_t drained;
+    while (omni_chan_try_recv(a, &drained)) {}
+    pthread_t sender;
+    pthread_create(&sender, NULL, delayed_send, b);
+    from_b = 0;
+    index = omni_chan_select(cases, 2, 1);
+    printf("blocking: case %d, ok %d, value %d\n", index, cases[1].ok, from_b);
+    pthread_join(sender, NULL);
+
+    // A closed channel is ready, with ok = 0
+    omni_chan_close(b);
+    index = omni_chan_select(cases, 2, 1);
+    printf("closed recv: case %d, ok %d\n", index, cases[1].ok);
+    omni_chan_case_t closed_send = {b, OMNI_CHAN_SEND, &seven, 1};
+    index = omni_chan_select(&closed_send, 1, 0);
+    printf("closed send: case %d, ok %d\n", index, closed_send.ok);
+    omni_chan_case_t none[1] = {{NULL, OMNI_CHAN_RECV, NULL, 0}};
+    printf("no channels: %d\n", omni_chan_select(none, 1, 1));
+    omni_chan_destroy(a);
+    omni_chan_destroy(b);
+}
+
+int main(int argc, char** argv) {
+    const char* scenario = argc > 1 ? argv[1] : "";
+    if (strcmp(scenario, "mpmc") == 0 && argc == 5) {
+        test_mpmc(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+    } else if (strcmp(scenario, "close_then_drain") == 0 && argc == 3) {
+        test_close_then_drain(atoi(argv[2]));
+    } else if (strcmp(scenario, "close_wakes_waiters") == 0) {
+        test_close_wakes_waiters();
+    } else if (strcmp(scenario, "batches") == 0) {
+        test_batches();
+    } else if (strcmp(scenario, "select") == 0) {
+        test_select();
+    } else {
+        fprintf(stderr, "unknown scenario %s\n", scenario);
+        return 2;
+    }
+    return 0;
+}
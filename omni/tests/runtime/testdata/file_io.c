@@ -0,0 +1,165 @@
+// File copies (omni_copy), 64-bit handle I/O and vectored writes
+
+#include "omni_rt.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Steps build on the files earlier steps wrote, so the first failure ends
+// the run, with errno from the call that failed
+static void must(int ok, const char* step) {
+    if (ok) return;
+    fprintf(stderr, "%s failed (errno %d: %s)\n", step, errno, strerror(errno));
+    exit(1);
+}
+
+static char* read_all(const char* path, size_t* len) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* data = (char*)malloc((size_t)size + 1);
+    *len = fread(data, 1, (size_t)size, f);
+    fclose(f);
+    return data;
+}
+
+static int same_contents(const char* path, const char* data, size_t len) {
+    size_t got = 0;
+    char* contents = read_all(path, &got);
+    int same = contents && got == len && memcmp(contents, data, len) == 0;
+    free(contents);
+    return same;
+}
+
+static void test_copy(void) {
+    // Several MiB of non-repeating bytes, so a short or misplaced chunk shows
+    size_t len = (size_t)5 << 20;
+    len += 12345;
+    char* data = (char*)malloc(len);
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < len; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (char)x;
+    }
+    FILE* f = fopen("big.bin", "wb");
+    fwrite(data, 1, len, f);
+    fclose(f);
+
+    must(omni_copy("big.bin", "big.copy") == 1, "copying big.bin");
+    must(same_contents("big.copy", data, len), "comparing big.copy with big.bin");
+    must(omni_file_size64("big.copy") == (int64_t)len, "sizing big.copy");
+
+    // Copying over a longer file truncates it
+    f = fopen("short.txt", "wb");
+    fputs("short", f);
+    fclose(f);
+    must(omni_copy("short.txt", "big.copy") == 1, "copying short.txt over big.copy");
+    must(same_contents("big.copy", "short", 5), "truncating big.copy");
+
+    // An empty source gives an empty copy
+    fclose(fopen("empty.txt", "wb"));
+    must(omni_copy("empty.txt", "empty.copy") == 1, "copying an empty file");
+    must(omni_file_exists("empty.copy") == 1 && omni_file_size64("empty.copy") == 0, "creating an empty copy");
+
+    // Copying a file onto itself is refused and leaves it intact
+    must(omni_copy("big.bin", "big.bin") == 0, "refusing to copy big.bin onto itself");
+    must(omni_copy("big.bin", "./big.bin") == 0, "refusing to copy big.bin onto ./big.bin");
+    must(same_contents("big.bin", data, len), "keeping big.bin intact");
+
+    must(omni_copy("missing.bin", "missing.copy") == 0, "refusing a missing source");
+    must(omni_file_exists("missing.copy") == 0, "leaving no copy of a missing source");
+    must(omni_copy(".", "dir.copy") == 0, "refusing a directory");
+    must(omni_copy(NULL, "null.copy") == 0 && omni_copy("big.bin", NULL) == 0, "refusing NULL paths");
+    free(data);
+}
+
+static void test_handles(void) {
+    intptr_t file = omni_file_open("io.bin", "w+b");
+    must(file != (intptr_t)-1, "opening io.bin");
+    must(omni_file_write64(file, "0123456789", 10) == 10, "writing ten bytes");
+    must(omni_file_tell64(file) == 10 && omni_file_tell(file) == 10, "telling after the write");
+
+    char buffer[16] = {0};
+    must(omni_file_seek64(file, 4, SEEK_SET) == 0, "seeking to 4");
+    must(omni_file_read64(file, buffer, 3) == 3 && memcmp(buffer, "456", 3) == 0, "reading at 4");
+    must(omni_file_tell64(file) == 7, "telling after the read");
+    must(omni_file_seek64(file, -2, SEEK_END) == 0, "seeking from the end");
+    must(omni_file_read64(file, buffer, sizeof(buffer)) == 2 && memcmp(buffer, "89", 2) == 0, "reading the last two bytes");
+    must(omni_file_seek(file, 0, SEEK_SET) == 0, "seeking back with the int32 call");
+    must(omni_file_read(file, buffer, 4) == 4 && memcmp(buffer, "0123", 4) == 0, "reading with the int32 call");
+
+    // Invalid arguments are errors, not zero-length transfers
+    must(omni_file_read64(file, buffer, 0) == -1, "rejecting a zero-length read");
+    must(omni_file_read64(file, NULL, 4) == -1, "rejecting a NULL buffer");
+    must(omni_file_write64(file, buffer, -1) == -1, "rejecting a negative length");
+    must(omni_file_seek64(file, -1, SEEK_SET) == -1, "rejecting a negative offset");
+
+    // Offsets past 4 GiB: the int64 calls report them, the int32 ones
+    // signal overflow instead of truncating
+    int64_t far = ((int64_t)1 << 32) + 5;
+    must(omni_file_seek64(file, far, SEEK_SET) == 0, "seeking past 4 GiB");
+    must(omni_file_write64(file, "end", 3) == 3, "writing past 4 GiB");
+    must(omni_file_tell64(file) == far + 3, "telling past 4 GiB");
+    must(omni_file_tell(file) == -1, "reporting overflow from the int32 tell");
+    must(omni_file_seek64(file, far, SEEK_SET) == 0, "seeking back past 4 GiB");
+    memset(buffer, 0, sizeof(buffer));
+    must(omni_file_read64(file, buffer, 3) == 3 && memcmp(buffer, "end", 3) == 0, "reading past 4 GiB");
+    must(omni_file_close(file) == 0, "closing io.bin");
+    must(omni_file_size64("io.bin") == far + 3, "sizing io.bin");
+    must(omni_file_size("io.bin") == -1, "reporting overflow from the int32 size");
+    must(omni_file_size64("missing.bin") == -1 && omni_file_size(NULL) == -1, "sizing missing files");
+    must(omni_file_tell64((intptr_t)-1) == -1, "telling on an invalid handle");
+    remove("io.bin");
+}
+
+static void test_writev(void) {
+    // More pieces than one writev call takes, with empty pieces mixed in
+    enum { PIECES = 3000 };
+    omni_iovec_t pieces[PIECES];
+    char digits[PIECES];
+    char* expected = (char*)malloc(PIECES + 2);
+    size_t expected_len = 0;
+    expected[expected_len++] = '<';
+    for (int i = 0; i < PIECES; i++) {
+        digits[i] = (char)('0' + i % 10);
+        pieces[i].data = &digits[i];
+        pieces[i].len = i % 7 == 3 ? 0 : 1;
+        if (pieces[i].len) expected[expected_len++] = digits[i];
+    }
+
+    intptr_t file = omni_file_open("vec.txt", "w+b");
+    must(file != (intptr_t)-1, "opening vec.txt");
+    // Buffered writes before and after must land in order around the batch
+    must(omni_file_write64(file, "<", 1) == 1, "writing before the batch");
+    must(omni_file_writev(file, pieces, PIECES) == (int64_t)expected_len - 1, "writing 3000 pieces");
+    must(omni_file_tell64(file) == (int64_t)expected_len, "telling after the batch");
+    must(omni_file_write64(file, ">", 1) == 1, "writing after the batch");
+    expected[expected_len++] = '>';
+    must(omni_file_writev(file, pieces, 0) == 0, "writing no pieces");
+    must(omni_file_writev(file, NULL, 1) == -1 && omni_file_writev(file, pieces, -1) == -1, "rejecting bad piece lists");
+
+    // After reading part of the file, a vectored write lands at the
+    // stream position rather than wherever read-ahead left the descriptor
+    must(omni_file_seek64(file, 0, SEEK_SET) == 0, "rewinding vec.txt");
+    char head[4];
+    must(omni_file_read64(file, head, 4) == 4 && memcmp(head, expected, 4) == 0, "reading the head");
+    omni_iovec_t patch[2] = {{"AB", 2}, {"CD", 2}};
+    must(omni_file_writev(file, patch, 2) == 4, "patching after a read");
+    must(omni_file_tell64(file) == 8, "telling after the patch");
+    memcpy(expected + 4, "ABCD", 4);
+    must(omni_file_close(file) == 0, "closing vec.txt");
+    must(same_contents("vec.txt", expected, expected_len), "comparing vec.txt");
+    free(expected);
+}
+
+int main(void) {
+    test_copy();
+    test_handles();
+    test_writev();
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Read-only memory-mapped file views (omni_file_map). file_view_test.go
+// writes the files this maps and compares what it prints, one probe a line.
+
+#include "omni_rt.h"
+#include <stdio.h>
+
+// Prints bytes as a C string literal, so line breaks and UTF-8 stay visible
+static void print_quoted(const char* data, size_t len) {
+    putchar('"');
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)data[i];
+        if (c == '\n') {
+            fputs("\\n", stdout);
+        } else if (c < 0x20 || c >= 0x7f || c == '"' || c == '\\') {
+            printf("\\x%02x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+static void print_map(const char* path) {
+    omni_file_view_t* view = omni_file_map(path, OMNI_FILE_MAP_NORMAL);
+    printf("%s: ", path ? path : "NULL path");
+    if (view) {
+        printf("%zu bytes\n", view->len);
+    } else {
+        printf("not mapped\n");
+    }
+    omni_file_unmap(view);
+}
+
+int main(void) {
+    // Every advice maps the same bytes and accepts every other advice
+    for (int32_t advice = OMNI_FILE_MAP_NORMAL; advice <= OMNI_FILE_MAP_WILLNEED; advice++) {
+        omni_file_view_t* view = omni_file_map("text.txt", advice);
+        if (!view) {
+            printf("text.txt advice %d: not mapped\n", advice);
+            continue;
+        }
+        printf("text.txt advice %d: ", advice);
+        print_quoted(view->data, view->len);
+        printf(", advise %d\n", omni_file_advise(view, 11, 6, OMNI_FILE_MAP_WILLNEED - advice));
+        omni_file_unmap(view);
+    }
+
+    omni_file_view_t* view = omni_file_map("text.txt", OMNI_FILE_MAP_NORMAL);
+    if (view) {
+        printf("advise past the end: %d\n", omni_file_advise(view, view->len + 1, 1, OMNI_FILE_MAP_NORMAL));
+        printf("advise a clipped range: %d\n", omni_file_advise(view, 5, 1000, OMNI_FILE_MAP_RANDOM));
+        printf("advise an unknown advice: %d\n", omni_file_advise(view, 0, 1, 42));
+        printf("contains \"second\": %d\n", omni_contains_len(view->data, view->len, "second", 6));
+        printf("index of \"line\": %d\n", omni_index_of_len(view->data, view->len, "line", 4));
+        omni_file_unmap(view);
+    }
+
+    print_map("empty.txt");
+    print_map("missing.txt");
+    print_map(".");
+    print_map(NULL);
+
+    // page.txt fills whole pages, so nothing is mapped after it: substrings
+    // that end mid-rune must stop at the end of the view
+    view = omni_file_map("page.txt", OMNI_FILE_MAP_NORMAL);
+    if (!view) {
+        printf("page.txt: not mapped\n");
+        return 0;
+    }
+    int32_t len = (int32_t)view->len;
+    printf("page.txt: %d bytes\n", len);
+    char* tail = omni_substring_len(NULL, view->data, view->len, len - 2, len);
+    printf("last two bytes: ");
+    print_quoted(tail, omni_str_len(tail));
+    putchar('\n');
+    omni_str_free(tail);
+    char* rune = omni_substring_len(NULL, view->data, view->len, len - 3, len);
+    printf("last three bytes: ");
+    print_quoted(rune, omni_str_len(rune));
+    putchar('\n');
+    omni_str_free(rune);
+    omni_file_unmap(view);
+    return 0;
+}
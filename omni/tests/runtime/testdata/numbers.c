@@ -0,0 +1,407 @@
+// Number formatting (omni_format_*) and parsing (omni_parse_*). Fixed cases
+// are tables; random inputs are checked against libc: glibc's strtod rounds
+// correctly and printf("%.*e") gives exact digits, so both serve as the
+// reference. Every mismatch is printed and main returns how many there were.
+
+#include "omni_rt.h"
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+static uint64_t bits_of(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+static double from_bits(uint64_t bits) {
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+
+static uint64_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+// Formats x into a guarded buffer; a write past OMNI_FMT_FLOAT_MAX clears *ok
+static const char* format(double x, int* ok) {
+    static char buf[OMNI_FMT_FLOAT_MAX + 9];
+    memset(buf, '#', sizeof(buf));
+    size_t len = omni_format_float(buf, x);
+    if (len == 0 || len > OMNI_FMT_FLOAT_MAX || memcmp(buf + OMNI_FMT_FLOAT_MAX, "########", 8) != 0) *ok = 0;
+    buf[len] = '\0';
+    return buf;
+}
+
+static void expect_format(double x, const char* expected) {
+    int ok = 1;
+    const char* got = format(x, &ok);
+    if (strcmp(got, expected) != 0 || !ok) {
+        fprintf(stderr, "formatted %.17g as %s, want %s\n", x, got, expected);
+        failures++;
+    }
+}
+
+// Parses all of text and compares the bits with strtod's answer
+static void expect_strtod(const char* text) {
+    double got = -1.0, want = strtod(text, NULL);
+    size_t len = strlen(text);
+    size_t used = omni_parse_float(text, len, &got);
+    if (used != len || bits_of(got) != bits_of(want)) {
+        fprintf(stderr, "parsed %s as %a using %zu bytes, want %a using %zu\n", text, got, used, want, len);
+        failures++;
+    }
+}
+
+// Fewest significant digits that read back as x
+static int shortest_digits(double x) {
+    char buf[40];
+    for (int digits = 1; digits < 17; digits++) {
+        snprintf(buf, sizeof(buf), "%.*e", digits - 1, x);
+        if (strtod(buf, NULL) == x) return digits;
+    }
+    return 17;
+}
+
+static int significant_digits(const char* s) {
+    int n = 0, leading = 1;
+    for (; *s && *s != 'e'; s++) {
+        if (*s < '0' || *s > '9') continue;
+        if (*s == '0' && leading) continue;
+        leading = 0;
+        n++;
+    }
+    // Trailing zeros of an integer like "100" are layout, not digits
+    while (n > 0 && s[-1] == '0') {
+        s--;
+        n--;
+    }
+    return n;
+}
+
+static const struct {
+    double x;
+    const char* text;
+} format_cases[] = {
+    {0.0, "0"},
+    {-0.0, "-0"},
+    {1.0, "1"},
+    {0.1, "0.1"},
+    {0.1 + 0.2, "0.30000000000000004"},
+    {100.0, "100"},
+    {123456.0, "123456"},
+    {999999.0, "999999"},
+    {1e6, "1e+06"},
+    {1234567.0, "1.234567e+06"},
+    {1e-4, "0.0001"},
+    {1.5e-4, "0.00015"},
+    {9.99e-5, "9.99e-05"},
+    {-2.5e-7, "-2.5e-07"},
+    {1e100, "1e+100"},
+    {5e-324, "5e-324"},
+    {-4.9406564584124654e-324, "-5e-324"},
+    {2.2250738585072009e-308, "2.225073858507201e-308"},
+    {2.2250738585072014e-308, "2.2250738585072014e-308"},
+    {1.7976931348623157e308, "1.7976931348623157e+308"},
+    {-1.7976931348623157e308, "-1.7976931348623157e+308"},
+    {9007199254740993.0, "9.007199254740992e+15"},
+    {INFINITY, "+Inf"},
+    {-INFINITY, "-Inf"},
+    {NAN, "NaN"},
+    {-NAN, "NaN"},
+};
+
+static void test_format_layout(void) {
+    for (size_t i = 0; i < sizeof(format_cases) / sizeof(format_cases[0]); i++) {
+        expect_format(format_cases[i].x, format_cases[i].text);
+    }
+}
+
+// Random bit patterns cover every exponent, subnormals included: the
+// output must be as short as possible and read back to the same bits
+static void test_format_round_trip(void) {
+    int ok = 1, round_trips = 1, shortest = 1;
+    for (int i = 0; i < 200000; i++) {
+        uint64_t bits = next_random();
+        if (i % 4 == 0) bits &= 0x800FFFFFFFFFFFFFull; // Subnormal
+        if (i % 4 == 1) bits &= ~(next_random() & 0x000FFFFFFFFFFFFFull); // Few mantissa bits
+        double x = from_bits(bits);
+        if (isnan(x) || isinf(x)) continue;
+        const char* text = format(x, &ok);
+        double back = 0.0;
+        size_t len = strlen(text);
+        if (omni_parse_float(text, len, &back) != len || bits_of(back) != bits) {
+            if (round_trips) fprintf(stderr, "%a formats as %s, which reads back as %a\n", x, text, back);
+            round_trips = 0;
+        }
+        if (strtod(text, NULL) != x) round_trips = 0;
+        if (significant_digits(text) != shortest_digits(x)) {
+            if (shortest) fprintf(stderr, "%a formats as %s, not in %d digits\n", x, text, shortest_digits(x));
+            shortest = 0;
+        }
+    }
+    if (!ok) fprintf(stderr, "a formatted float overran OMNI_FMT_FLOAT_MAX\n");
+    failures += !ok + !round_trips + !shortest;
+}
+
+// Inputs whose correctly rounded value strtod gives
+static const char* strtod_cases[] = {
+    // Subnormals and the normal boundary
+    "4.9e-324",
+    "4.9406564584124654e-324",
+    "2.2250738585072009e-308",
+    "2.2250738585072011e-308",
+    "2.2250738585072012e-308",
+    "2.2250738585072014e-308",
+    "1e-310",
+    "-3.5e-320",
+    // Exactly halfway between two doubles, and a hair either side
+    "9007199254740993",
+    "9007199254740995",
+    "9007199254740993.0000000000000000001",
+    "9007199254740992.9999999999999999999",
+    "2.4703282292062327e-324",
+    "2.4703282292062328e-324",
+    "1.00000000000000011102230246251565404236316680908203125",
+    "1.00000000000000011102230246251565404236316680908203124",
+    "1.00000000000000011102230246251565404236316680908203126",
+    "179769313486231580793728971405301e276",
+    "179769313486231580793728971405302e276",
+    "1.7976931348623158e308",
+    // Long mantissas, leading zeros and exponents that cancel out
+    "12345678901234567890123456789",
+    "0.000000000000000000000000000000123456789012345678901",
+    "000000000000000000000000000001.5",
+    "1000000000000000000000000e-25",
+    "0.1e1",
+    "123.456E+2",
+    "7.",
+    ".5",
+};
+
+// Inputs with a fixed answer: how many bytes of the first len (0 for all of
+// text) are consumed, and the value, compared bit for bit (any NaN matches)
+static const struct {
+    const char* text;
+    size_t len;
+    size_t consumed;
+    double value;
+} parse_cases[] = {
+    // Out of range: overflow to infinity, underflow to a signed zero
+    {"1e400", 0, 5, INFINITY},
+    {"-1e400", 0, 6, -INFINITY},
+    {"1.8e308", 0, 7, INFINITY},
+    {"1e99999999999", 0, 13, INFINITY},
+    {"1e-400", 0, 6, 0.0},
+    {"-1e-400", 0, 7, -0.0},
+    {"1e-99999999999", 0, 14, 0.0},
+    // Signed zero, infinities and NaN, including the formatter's spellings
+    {"-0", 0, 2, -0.0},
+    {"-0.0e10", 0, 7, -0.0},
+    {"+0", 0, 2, 0.0},
+    {"inf", 0, 3, INFINITY},
+    {"+Inf", 0, 4, INFINITY},
+    {"-Inf", 0, 4, -INFINITY},
+    {"-Infinity", 0, 9, -INFINITY},
+    {"INF", 0, 3, INFINITY},
+    {"nan", 0, 3, NAN},
+    {"NaN", 0, 3, NAN},
+    // Only a number at the very start, and only its bytes, are consumed
+    {"1.5abc", 0, 3, 1.5},
+    {"2e", 0, 1, 2.0},
+    {"2e+", 0, 1, 2.0},
+    {"3.25", 2, 2, 3.0},
+};
+
+// Inputs that are not numbers: nothing is consumed and the output is untouched
+static const char* rejected_cases[] = {"", "-", ".", "e5", " 1", "in"};
+
+static void test_parse_edges(void) {
+    for (size_t i = 0; i < sizeof(strtod_cases) / sizeof(strtod_cases[0]); i++) {
+        expect_strtod(strtod_cases[i]);
+    }
+    for (size_t i = 0; i < sizeof(parse_cases) / sizeof(parse_cases[0]); i++) {
+        const char* text = parse_cases[i].text;
+        size_t len = parse_cases[i].len ? parse_cases[i].len : strlen(text);
+        double want = parse_cases[i].value, got = 42.0;
+        size_t used = omni_parse_float(text, len, &got);
+        int same = isnan(want) ? isnan(got) : bits_of(got) == bits_of(want);
+        if (used != parse_cases[i].consumed || !same) {
+            fprintf(stderr, "parsed %.*s as %a using %zu bytes, want %a using %zu\n", (int)len, text, got, used, want,
+                    parse_cases[i].consumed);
+            failures++;
+        }
+    }
+    for (size_t i = 0; i < sizeof(rejected_cases) / sizeof(rejected_cases[0]); i++) {
+        double got = 42.0;
+        size_t used = omni_parse_float(rejected_cases[i], strlen(rejected_cases[i]), &got);
+        if (used != 0 || got != 42.0) {
+            fprintf(stderr, "parsed \"%s\" as %a using %zu bytes, want it rejected\n", rejected_cases[i], got, used);
+            failures++;
+        }
+    }
+}
+
+// Random decimal strings of every length and exponent against strtod
+static void test_parse_random(void) {
+    char text[64];
+    int ok = 1;
+    for (int i = 0; i < 200000; i++) {
+        int digits = 1 + (int)(next_random() % 25);
+        int point = (int)(next_random() % (uint64_t)(digits + 1));
+        int exponent = (int)(next_random() % 680) - 350;
+        size_t n = 0;
+        if (next_random() & 1) text[n++] = '-';
+        for (int d = 0; d < digits; d++) {
+            if (d == point && d > 0) text[n++] = '.';
+            text[n++] = (char)('0' + next_random() % 10);
+        }
+        n += (size_t)snprintf(text + n, sizeof(text) - n, "e%d", exponent);
+        double got = 0.0, want = strtod(text, NULL);
+        if (omni_parse_float(text, n, &got) != n || bits_of(got) != bits_of(want)) {
+            if (ok) fprintf(stderr, "parsed %s as %a, want %a\n", text, got, want);
+            ok = 0;
+        }
+    }
+    failures += !ok;
+}
+
+static const struct {
+    int64_t value;
+    const char* text;
+} int_cases[] = {
+    {0, "0"},
+    {7, "7"},
+    {-1, "-1"},
+    {10, "10"},
+    {99, "99"},
+    {100, "100"},
+    {-1000000007, "-1000000007"},
+    {INT64_MAX, "9223372036854775807"},
+    {INT64_MIN, "-9223372036854775808"},
+};
+
+// Parsing stops at the first non-digit and saturates at the int64 limits
+static const struct {
+    const char* text;
+    size_t consumed;
+    int64_t value;
+} parse_int_cases[] = {
+    {"9223372036854775807", 19, INT64_MAX},
+    {"9223372036854775808", 19, INT64_MAX},
+    {"-9223372036854775808", 20, INT64_MIN},
+    {"-9223372036854775809", 20, INT64_MIN},
+    {"99999999999999999999", 20, INT64_MAX},
+    {"18446744073709551617", 20, INT64_MAX},
+    {"000000000000000000000012", 24, 12},
+    {"+5", 2, 5},
+    {"-0", 2, 0},
+    {"12x", 2, 12},
+    {"", 0, 3},
+    {"-", 0, 3},
+    {"x1", 0, 3},
+};
+
+static void test_integers(void) {
+    char buf[OMNI_FMT_INT_MAX + 1], want[32];
+    for (size_t i = 0; i < sizeof(int_cases) / sizeof(int_cases[0]); i++) {
+        size_t len = omni_format_int(buf, int_cases[i].value);
+        buf[len < sizeof(buf) ? len : 0] = '\0';
+        if (len > OMNI_FMT_INT_MAX || strcmp(buf, int_cases[i].text) != 0) {
+            fprintf(stderr, "formatted %lld as %s, want %s\n", (long long)int_cases[i].value, buf, int_cases[i].text);
+            failures++;
+        }
+    }
+
+    int ok = 1;
+    for (int i = 0; i < 100000; i++) {
+        int64_t value = (int64_t)next_random() >> (next_random() % 64);
+        size_t len = omni_format_int(buf, value);
+        buf[len] = '\0';
+        snprintf(want, sizeof(want), "%lld", (long long)value);
+        int64_t back = 0;
+        if (strcmp(buf, want) != 0 || omni_parse_int(buf, len, &back) != len || back != value) {
+            if (ok) fprintf(stderr, "%lld formats as %s, which reads back as %lld\n", (long long)value, buf, (long long)back);
+            ok = 0;
+        }
+    }
+    failures += !ok;
+
+    for (size_t i = 0; i < sizeof(parse_int_cases) / sizeof(parse_int_cases[0]); i++) {
+        const char* text = parse_int_cases[i].text;
+        int64_t got = 3; // Untouched when nothing is consumed
+        size_t used = omni_parse_int(text, strlen(text), &got);
+        if (used != parse_int_cases[i].consumed || got != parse_int_cases[i].value) {
+            fprintf(stderr, "parsed \"%s\" as %lld using %zu bytes, want %lld using %zu\n", text, (long long)got, used,
+                    (long long)parse_int_cases[i].value, parse_int_cases[i].consumed);
+            failures++;
+        }
+    }
+}
+
+static void expect_string(char* got, const char* want) {
+    if (strcmp(got, want) != 0) {
+        fprintf(stderr, "got %s, want %s\n", got, want);
+        failures++;
+    }
+    omni_str_free(got);
+}
+
+static void expect_true(int ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        failures++;
+    }
+}
+
+static void test_string_conversions(void) {
+    expect_string(omni_float_to_string(0.1), "0.1");
+    expect_string(omni_float_to_string(-0.0), "-0");
+    expect_string(omni_int_to_string(INT32_MIN), "-2147483648");
+
+    // Leading whitespace, a trailing remainder and hex are all accepted
+    expect_true(omni_string_to_float("  2.5xyz") == 2.5, "string_to_float skips space and stops at the remainder");
+    expect_true(omni_string_to_float("0x1p-2") == 0.25, "string_to_float reads hex");
+    expect_true(omni_string_to_float("abc") == 0.0, "string_to_float gives 0 for text");
+    expect_true(signbit(omni_string_to_float("-0")), "string_to_float keeps the sign of -0");
+    expect_true(isinf(omni_string_to_float("1e400")), "string_to_float overflows to infinity");
+    expect_true(omni_string_to_int("2147483647") == INT32_MAX, "string_to_int reads INT32_MAX");
+    expect_true(omni_string_to_int("-2147483648") == INT32_MIN, "string_to_int reads INT32_MIN");
+}
+
+// A locale with a decimal comma must not change either direction
+static void test_locale(void) {
+    const char* locales[] = {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8"};
+    for (size_t i = 0; i < sizeof(locales) / sizeof(locales[0]); i++) {
+        if (!setlocale(LC_NUMERIC, locales[i])) continue;
+        double x = 0.0;
+        expect_true(omni_parse_float("1.5", 3, &x) == 3 && x == 1.5, "parse_float changed under a decimal-comma locale");
+        expect_true(omni_parse_float("1.00000000000000011102230246251565404236316680908203126", 55, &x) == 55 &&
+                        x == 1.0000000000000002,
+                    "parse_float changed under a decimal-comma locale on its slow path");
+        expect_format(1.5, "1.5");
+        setlocale(LC_NUMERIC, "C");
+        return;
+    }
+}
+
+int main(void) {
+    test_format_layout();
+    test_format_round_trip();
+    test_parse_edges();
+    test_parse_random();
+    test_integers();
+    test_string_conversions();
+    test_locale();
+    return failures;
+}
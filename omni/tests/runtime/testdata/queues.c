@@ -0,0 +1,178 @@
+// Ring-buffer queue, array stack and the SPSC queue. Checks are plain
+// asserts, so the first failure aborts with its expression and line; they
+// call the functions under test, so NDEBUG must stay off.
+
+#undef NDEBUG
+
+#include "omni_rt.h"
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+static void test_queue(void) {
+    omni_queue_t* q = omni_queue_create();
+    assert(omni_queue_is_empty(q) == 1);
+    assert(omni_queue_dequeue(q) == 0);
+    assert(omni_queue_peek(q) == 0);
+
+    // Drain part of the queue so later items wrap, then grow it while
+    // wrapped: FIFO order must survive the move
+    int32_t next_in = 0, next_out = 0, ordered = 1;
+    for (; next_in < 12; next_in++) omni_queue_enqueue(q, next_in);
+    for (; next_out < 8; next_out++) ordered &= omni_queue_dequeue(q) == next_out;
+    for (; next_in < 20; next_in++) omni_queue_enqueue(q, next_in);
+    int32_t batch[200];
+    for (int32_t i = 0; i < 200; i++) batch[i] = next_in + i;
+    assert(omni_queue_enqueue_n(q, batch, 200) == 200);
+    next_in += 200;
+    assert(omni_queue_size(q) == next_in - next_out);
+    assert(omni_queue_peek(q) == next_out);
+
+    int32_t out[64];
+    while (!omni_queue_is_empty(q)) {
+        int32_t n = omni_queue_dequeue_n(q, out, 64);
+        assert(n > 0);
+        for (int32_t i = 0; i < n; i++) ordered &= out[i] == next_out++;
+        // Keep refilling a little so head and tail chase each other
+        if (next_in < 1000) {
+            omni_queue_enqueue(q, next_in++);
+        }
+    }
+    assert(ordered);
+    assert(next_out == next_in);
+    assert(omni_queue_dequeue_n(q, out, 64) == 0);
+
+    assert(omni_queue_reserve(q, 5000) == 1);
+    assert(omni_queue_enqueue_n(q, batch, 0) == 0);
+    assert(omni_queue_enqueue_n(q, NULL, 3) == 0);
+    omni_queue_enqueue(q, 7);
+    omni_queue_clear(q);
+    assert(omni_queue_size(q) == 0);
+    omni_queue_enqueue(q, 9);
+    assert(omni_queue_dequeue(q) == 9);
+    omni_queue_destroy(q);
+    assert(omni_queue_size(NULL) == 0);
+    assert(omni_queue_is_empty(NULL) == 1);
+}
+
+static void test_stack(void) {
+    omni_stack_t* s = omni_stack_create();
+    assert(omni_stack_pop(s) == 0);
+    assert(omni_stack_peek(s) == 0);
+    for (int32_t i = 0; i < 40; i++) omni_stack_push(s, i);
+    int32_t batch[3] = {100, 101, 102};
+    assert(omni_stack_push_n(s, batch, 3) == 3);
+    assert(omni_stack_size(s) == 43);
+    assert(omni_stack_peek(s) == 102);
+
+    // pop_n hands back the old top first
+    int32_t out[5];
+    assert(omni_stack_pop_n(s, out, 5) == 5);
+    assert(out[0] == 102 && out[1] == 101 && out[2] == 100 && out[3] == 39 && out[4] == 38);
+    int ordered = 1;
+    for (int32_t i = 37; i >= 0; i--) ordered &= omni_stack_pop(s) == i;
+    assert(ordered);
+    assert(omni_stack_is_empty(s) == 1);
+    assert(omni_stack_pop_n(s, out, 5) == 0);
+
+    assert(omni_stack_reserve(s, 1000) == 1);
+    omni_stack_push(s, 1);
+    omni_stack_clear(s);
+    assert(omni_stack_size(s) == 0);
+    omni_stack_destroy(s);
+}
+
+static void test_spsc_single_thread(void) {
+    assert(omni_spsc_queue_create(0) == NULL);
+    assert(omni_spsc_queue_create(-1) == NULL);
+    omni_spsc_queue_t* q = omni_spsc_queue_create(5);
+    assert(omni_spsc_queue_capacity(q) == 8);
+
+    int64_t value = 0;
+    assert(omni_spsc_queue_pop(q, &value) == 0);
+    for (int64_t i = 0; i < 8; i++) assert(omni_spsc_queue_push(q, i) == 1);
+    assert(omni_spsc_queue_push(q, 8) == 0);
+    assert(omni_spsc_queue_size(q) == 8);
+
+    // Batches stop at full and at empty and wrap around the ring
+    int64_t out[16];
+    assert(omni_spsc_queue_pop_n(q, out, 5) == 5);
+    assert(out[0] == 0 && out[4] == 4);
+    int64_t batch[10] = {8, 9, 10, 11, 12, 13, 14, 15, 16, 17};
+    assert(omni_spsc_queue_push_n(q, batch, 10) == 5);
+    assert(omni_spsc_queue_size(q) == 8);
+    assert(omni_spsc_queue_pop_n(q, out, 16) == 8);
+    int ordered = 1;
+    for (int i = 0; i < 8; i++) ordered &= out[i] == 5 + i;
+    assert(ordered);
+    assert(omni_spsc_queue_size(q) == 0);
+    assert(omni_spsc_queue_pop_n(q, out, 16) == 0);
+
+    // 64-bit values, including pointers, come back unchanged
+    int64_t big = INT64_MIN + 3;
+    assert(omni_spsc_queue_push(q, big) == 1);
+    assert(omni_spsc_queue_push(q, (int64_t)(intptr_t)&value) == 1);
+    assert(omni_spsc_queue_pop(q, &value) == 1 && value == big);
+    assert(omni_spsc_queue_pop(q, &value) == 1 && value == (int64_t)(intptr_t)&value);
+    omni_spsc_queue_destroy(q);
+}
+
+// One producer and one consumer through a small ring: every value arrives
+// exactly once and in order
+#define SPSC_VALUES 1000000
+
+static void* spsc_producer(void* arg) {
+    omni_spsc_queue_t* q = (omni_spsc_queue_t*)arg;
+    int64_t next = 1;
+    int64_t batch[7];
+    while (next <= SPSC_VALUES) {
+        if (next % 3 == 0) {
+            int32_t n = 0;
+            while (n < 7 && next + n <= SPSC_VALUES) {
+                batch[n] = next + n;
+                n++;
+            }
+            int32_t pushed = omni_spsc_queue_push_n(q, batch, n);
+            next += pushed;
+            if (pushed == 0) sched_yield();
+        } else if (omni_spsc_queue_push(q, next)) {
+            next++;
+        } else {
+            sched_yield(); // Full; let the consumer run on a single core
+        }
+    }
+    return NULL;
+}
+
+static void test_spsc_threads(void) {
+    omni_spsc_queue_t* q = omni_spsc_queue_create(64);
+    pthread_t producer;
+    pthread_create(&producer, NULL, spsc_producer, q);
+    int64_t expected = 1, count = 0, sum = 0;
+    int ordered = 1;
+    int64_t out[5];
+    while (count < SPSC_VALUES) {
+        int32_t n = omni_spsc_queue_pop_n(q, out, 5);
+        if (n == 0) sched_yield();
+        for (int32_t i = 0; i < n; i++) {
+            ordered &= out[i] == expected++;
+            sum += out[i];
+        }
+        count += n;
+    }
+    pthread_join(producer, NULL);
+    assert(ordered);
+    assert(count == SPSC_VALUES);
+    assert(sum == (int64_t)SPSC_VALUES * (SPSC_VALUES + 1) / 2);
+    assert(omni_spsc_queue_size(q) == 0);
+    omni_spsc_queue_destroy(q);
+}
+
+int main(void) {
+    test_queue();
+    test_stack();
+    test_spsc_single_thread();
+    test_spsc_threads();
+    return 0;
+}
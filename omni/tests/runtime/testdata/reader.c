@@ -0,0 +1,102 @@
+// Buffered line reader (omni_reader_*) and omni_read_line.
+//
+// Usage: reader <source> [path]. Reads every line from the source and
+// prints one record per call: "line[<len>]" followed by the line's bytes on
+// the next line, or "end" once the reader is exhausted. reader_test.go
+// compares the records.
+
+#include "omni_rt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_record(const char* tag, const char* data, size_t len) {
+    printf("%s[%zu]\n", tag, len);
+    fwrite(data, 1, len, stdout);
+    putchar('\n');
+}
+
+// Prints the rest of the reader, then asks once more past the end. Lines
+// from a buffered reader must also be NUL-terminated.
+static void drain(omni_reader_t* reader, int buffered) {
+    if (!reader) {
+        printf("no reader\n");
+        return;
+    }
+    for (int ends = 0; ends < 2;) {
+        size_t len = 1;
+        const char* line = omni_reader_next_line(reader, &len);
+        if (line) {
+            print_record(buffered && line[len] != '\0' ? "unterminated" : "line", line, len);
+        } else {
+            printf(len == 0 ? "end\n" : "end with length %zu\n", len);
+            ends++;
+        }
+    }
+}
+
+static void print_read_line(void) {
+    char* line = omni_read_line();
+    print_record("read_line", line, strlen(line));
+    free(line);
+}
+
+int main(int argc, char** argv) {
+    const char* source = argc > 1 ? argv[1] : "";
+    const char* path = argc > 2 ? argv[2] : NULL;
+
+    if (strcmp(source, "open") == 0) {
+        omni_reader_t* reader = omni_reader_open(path);
+        drain(reader, 0);
+        omni_reader_free(reader);
+    } else if (strcmp(source, "view") == 0) {
+        omni_file_view_t* view = omni_file_map(path, OMNI_FILE_MAP_SEQUENTIAL);
+        omni_reader_t* reader = omni_reader_from_view(view);
+        drain(reader, 0);
+        omni_reader_free(reader);
+        omni_file_unmap(view);
+    } else if (strcmp(source, "file") == 0) {
+        intptr_t file = omni_file_open(path, "rb");
+        omni_reader_t* reader = omni_reader_from_file(file);
+        drain(reader, 1);
+        omni_reader_free(reader);
+        omni_file_close(file);
+    } else if (strcmp(source, "position") == 0) {
+        // A reader on a handle starts where the stream is and leaves it
+        // just past the last line handed out, even though it read ahead
+        intptr_t file = omni_file_open(path, "rb");
+        char skipped[7];
+        print_record("skipped", skipped, (size_t)omni_file_read(file, skipped, 7));
+        omni_reader_t* reader = omni_reader_from_file(file);
+        size_t len = 0;
+        const char* line = omni_reader_next_line(reader, &len);
+        print_record("line", line, len);
+        omni_reader_free(reader);
+        printf("tell %lld\n", (long long)omni_file_tell64(file));
+        char rest[64];
+        print_record("rest", rest, (size_t)omni_file_read(file, rest, sizeof(rest)));
+        omni_file_close(file);
+    } else if (strcmp(source, "stdin") == 0) {
+        // omni_read_line and the shared reader consume the same stream
+        print_read_line();
+        omni_reader_t* reader = omni_reader_stdin();
+        printf(reader == omni_reader_stdin() ? "shared\n" : "not shared\n");
+        size_t len = 0;
+        const char* line = omni_reader_next_line(reader, &len);
+        print_record("line", line, len);
+        omni_reader_free(reader); // No-op for the shared reader
+        print_read_line();
+        print_read_line();
+        drain(omni_reader_stdin(), 1);
+    } else if (strcmp(source, "invalid") == 0) {
+        printf("open missing: %s\n", omni_reader_open("missing.txt") ? "reader" : "NULL");
+        printf("open NULL: %s\n", omni_reader_open(NULL) ? "reader" : "NULL");
+        printf("view NULL: %s\n", omni_reader_from_view(NULL) ? "reader" : "NULL");
+        printf("file -1: %s\n", omni_reader_from_file((intptr_t)-1) ? "reader" : "NULL");
+        printf("next_line NULL: %s\n", omni_reader_next_line(NULL, NULL) ? "line" : "NULL");
+    } else {
+        fprintf(stderr, "unknown source %s\n", source);
+        return 2;
+    }
+    return 0;
+}
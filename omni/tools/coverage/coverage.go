@@ -9,8 +9,11 @@ import (
 	"strings"
 )
 
-// CoverageEntry represents a single coverage entry from the coverage JSON
+// CoverageEntry represents a single coverage entry from the coverage JSON.
+// Sites compiled into a C backend program carry their id and are listed
+// even when never hit (count 0); sites recorded by name have no id.
 type CoverageEntry struct {
+	ID       *int   `json:"id,omitempty"`
 	Function string `json:"function"`
 	File     string `json:"file"`
 	Line     int    `json:"line"`
@@ -180,11 +183,11 @@ func determineQualifiedName(filePath, funcName string) string {
 func MatchCoverageToFunctions(coverage *CoverageData, funcsByFile map[string][]FunctionInfo) map[string]*CoverageMatch {
 	matches := make(map[string]*CoverageMatch)
 
-	// Create a map of covered functions
-	covered := make(map[string]bool)
+	// Sum the counts per function; a function may have several sites, and
+	// listed sites with a zero count were never reached
+	counts := make(map[string]int)
 	for _, entry := range coverage.Entries {
-		key := entry.Function
-		covered[key] = true
+		counts[entry.Function] += entry.Count
 	}
 
 	// Match functions to coverage
@@ -195,18 +198,9 @@ func MatchCoverageToFunctions(coverage *CoverageData, funcsByFile map[string][]F
 			}
 
 			match := &CoverageMatch{
-				Function: fn,
-				Covered:  covered[fn.Name],
-			}
-
-			if match.Covered {
-				// Find the coverage entry
-				for _, entry := range coverage.Entries {
-					if entry.Function == fn.Name {
-						match.CallCount = entry.Count
-						break
-					}
-				}
+				Function:  fn,
+				Covered:   counts[fn.Name] > 0,
+				CallCount: counts[fn.Name],
 			}
 
 			matches[fn.Name] = match